@@ -0,0 +1,127 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include "Enterprise/Assets/AssetCooker.h"
+
+namespace {
+
+void PrintUsage()
+{
+    std::printf("Usage: EnterpriseCook <asset directory> [options]\n"
+                "  --output <directory>   Where cooked files go. Defaults to the asset directory, next to the\n"
+                "                         sources, which is where the engine looks for them.\n"
+                "  --cache <directory>    Manifest and cache entries. Defaults to <output>/.cook.\n"
+                "  --format <format>      rgba8, bc1, bc3, bc4, bc5 or bc7 (default).\n"
+                "  --quality <quality>    fast, normal (default) or high.\n"
+                "  --srgb                 Treat textures as sRGB color.\n"
+                "  --force                Cook everything again, ignoring the manifest and the cache.\n");
+}
+
+bool ParseFormat( const char* text, Enterprise::Textures::TextureFormat* format )
+{
+    using Enterprise::Textures::TextureFormat;
+    static const struct {
+        const char*   Name;
+        TextureFormat Format;
+    } formats[] = {
+        {"rgba8", TextureFormat::RGBA8}, {"bc1", TextureFormat::BC1}, {"bc3", TextureFormat::BC3},
+        {"bc4", TextureFormat::BC4}, {"bc5", TextureFormat::BC5}, {"bc7", TextureFormat::BC7},
+    };
+    for (const auto &entry: formats)
+    {
+        if (std::strcmp(text, entry.Name) == 0)
+        {
+            *format = entry.Format;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseQuality( const char* text, Enterprise::Textures::CompressionQuality* quality )
+{
+    using Enterprise::Textures::CompressionQuality;
+    if (std::strcmp(text, "fast") == 0)
+    {
+        *quality = CompressionQuality::Fast;
+    } else if (std::strcmp(text, "normal") == 0)
+    {
+        *quality = CompressionQuality::Normal;
+    } else if (std::strcmp(text, "high") == 0)
+    {
+        *quality = CompressionQuality::High;
+    } else
+    {
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main( int argc, char** argv )
+{
+    if (argc < 2 || std::strcmp(argv[1], "--help") == 0)
+    {
+        PrintUsage();
+        return argc < 2 ? 1 : 0;
+    }
+
+    std::string                         sourceDirectory = argv[1];
+    std::string                         outputDirectory;
+    std::string                         cacheDirectory;
+    Enterprise::Assets::AssetCookSettings settings;
+    for (int i = 2; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--output") == 0 && hasValue)
+        {
+            outputDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--cache") == 0 && hasValue)
+        {
+            cacheDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--format") == 0 && hasValue && ParseFormat(argv[i + 1], &settings.Texture.Format))
+        {
+            ++i;
+        } else if (std::strcmp(argv[i], "--quality") == 0 && hasValue &&
+                   ParseQuality(argv[i + 1], &settings.Texture.Quality))
+        {
+            ++i;
+        } else if (std::strcmp(argv[i], "--srgb") == 0)
+        {
+            settings.Texture.Srgb = true;
+        } else if (std::strcmp(argv[i], "--force") == 0)
+        {
+            settings.Force = true;
+        } else
+        {
+            std::fprintf(stderr, "Unknown or incomplete option %s\n", argv[i]);
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (outputDirectory.empty())
+    {
+        outputDirectory = sourceDirectory;
+    }
+    if (cacheDirectory.empty())
+    {
+        cacheDirectory = (std::filesystem::path(outputDirectory) / ".cook").string();
+    }
+
+    Enterprise::Assets::AssetCooker         cooker(sourceDirectory, outputDirectory, cacheDirectory, settings);
+    Enterprise::Assets::AssetCookStatistics statistics;
+    bool                                    success = cooker.Cook(&statistics);
+
+    std::printf("Cooked %u of %u assets (%u up to date, %u failed) in %.2f s\n", statistics.NumCooked,
+                statistics.NumAssets, statistics.NumUpToDate, statistics.NumFailed, statistics.Seconds);
+    std::printf("Throughput %.1f MB/s of source cooked, %.1f MB hashed\n", statistics.GetMegabytesPerSecond(),
+                double(statistics.HashedBytes) * 1e-6);
+    std::printf("Cache hit rate %.1f%% (assets %u/%u, meshes %u/%u, textures %u/%u)\n",
+                statistics.GetCacheHitRate() * 100.0, statistics.NumUpToDate, statistics.NumAssets,
+                statistics.MeshHits, statistics.MeshHits + statistics.MeshMisses, statistics.TextureHits,
+                statistics.TextureHits + statistics.TextureMisses);
+    return success ? 0 : 1;
+}
@@ -18,6 +18,30 @@ struct Light
 	float  SpecularStrength;
 };
 
+// Matches Enterprise::Core::Material.
+struct Material
+{
+	float4 BaseColor;
+	float3 Emissive;
+	float  Metallic;
+	float  Roughness;
+	float  AlphaCutoff;
+	uint   BaseColorTexture;
+	uint   NormalTexture;
+	uint   MetallicRoughnessTexture;
+	uint   EmissiveTexture;
+	uint   PipelineKey;
+	uint   Reserved;
+};
+
+// MaterialPipelineFlags
+#define MATERIAL_PIPELINE_ALPHA_TEST 1
+
+struct MaterialConstants
+{
+	uint MaterialIndex;
+};
+
 struct LightResult
 {
 	float4 Diffuse;
@@ -28,6 +52,8 @@ struct LightResult
 
 Texture2D Texture                   : register(t0);
 StructuredBuffer<Light> Lights		: register(t1);
+StructuredBuffer<Material> Materials : register(t2);
+ConstantBuffer<MaterialConstants> MaterialCB : register(b2);
 SamplerState LinearRepeatSampler    : register(s0);
 
 float DoDiffuse( float3 dir, float3 normal)
@@ -60,6 +86,11 @@ LightResult DoLight(Light light, float3 surfacePos, float3 surfaceNorm, float3 v
 float4 main ( PixelShaderInput IN) : SV_Target
 {
 	LightResult light = DoLight(Lights[0], IN.PositionVS.xyz, normalize(IN.NormalVS.xyz), IN.Position.xyz);
-    float4 texColour = Texture.Sample(LinearRepeatSampler, IN.TexCoord);
-	return (light.Ambient + light.Diffuse + light.Specular) * texColour;
+	Material material = Materials[MaterialCB.MaterialIndex];
+    float4 texColour = Texture.Sample(LinearRepeatSampler, IN.TexCoord) * material.BaseColor;
+	if (material.PipelineKey & MATERIAL_PIPELINE_ALPHA_TEST)
+	{
+		clip(texColour.a - material.AlphaCutoff);
+	}
+	return (light.Ambient + light.Diffuse + light.Specular) * texColour + float4(material.Emissive, 0);
 };
\ No newline at end of file
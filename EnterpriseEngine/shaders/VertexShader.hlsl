@@ -6,7 +6,16 @@ struct Transforms
     matrix ModelViewProjectionMatrix;
 };
 
+// Model matrix of every instance of an instanced draw, transforming column vectors, and the inverse transpose of
+// its upper 3x3 for normals. Draws that are not instanced bind a single identity instance.
+struct Instance
+{
+    row_major float3x4 World;
+    row_major float3x4 Normal;
+};
+
 ConstantBuffer<Transforms> TransformsCB : register(b0);
+StructuredBuffer<Instance> Instances    : register(t3);
 
 struct VertexPositionNormalTexture
 {
@@ -23,13 +32,17 @@ struct VertexShaderOutput
     float4 Position    : SV_Position;
 };
 
-VertexShaderOutput main(VertexPositionNormalTexture IN)
+VertexShaderOutput main(VertexPositionNormalTexture IN, uint InstanceID : SV_InstanceID)
 {
     VertexShaderOutput OUT;
 
-    OUT.Position = mul( TransformsCB.ModelViewProjectionMatrix, float4(IN.Position, 1.0f));
-    OUT.PositionVS = mul( TransformsCB.ModelViewMatrix, float4(IN.Position, 1.0f));
-    OUT.NormalVS = mul((float3x3)TransformsCB.InverseTransposeModelViewMatrix, IN.Normal);
+    Instance instance = Instances[InstanceID];
+    float4 position = float4(mul(instance.World, float4(IN.Position, 1.0f)), 1.0f);
+    float3 normal = mul((float3x3)instance.Normal, IN.Normal);
+
+    OUT.Position = mul( TransformsCB.ModelViewProjectionMatrix, position);
+    OUT.PositionVS = mul( TransformsCB.ModelViewMatrix, position);
+    OUT.NormalVS = mul((float3x3)TransformsCB.InverseTransposeModelViewMatrix, normal);
     OUT.TexCoord = IN.TexCoord;
 
     return OUT;
@@ -0,0 +1,70 @@
+struct Transforms
+{
+    matrix ModelMatrix;
+    matrix ModelViewMatrix;
+    matrix InverseTransposeModelViewMatrix;
+    matrix ModelViewProjectionMatrix;
+};
+
+// Model matrix of every instance of an instanced draw, transforming column vectors, and the inverse transpose of
+// its upper 3x3 for normals. Draws that are not instanced bind a single identity instance.
+struct Instance
+{
+    row_major float3x4 World;
+    row_major float3x4 Normal;
+};
+
+// Identity for float positions, maps unorm16 positions back onto the mesh bounds otherwise.
+struct VertexQuantization
+{
+    float3 PositionScale;
+    float  Padding0;
+    float3 PositionOffset;
+    float  Padding1;
+};
+
+ConstantBuffer<Transforms> TransformsCB                 : register(b0);
+ConstantBuffer<VertexQuantization> VertexQuantizationCB : register(b1);
+StructuredBuffer<Instance> Instances                    : register(t3);
+
+struct VertexPackedNormalTexture
+{
+    float3 Position    : POSITION;  // R32G32B32_FLOAT or R16G16B16A16_UNORM
+    float2 Normal      : NORMAL;    // R16G16_SNORM, octahedral encoded
+    float2 TexCoord    : TEXCOORD;  // R16G16_FLOAT
+};
+
+struct VertexShaderOutput
+{
+    float4 PositionVS  : POSITION;
+    float3 NormalVS    : NORMAL;
+    float2 TexCoord    : TEXCOORD;
+    float4 Position    : SV_Position;
+};
+
+float3 DecodeOctahedral(float2 encoded)
+{
+    float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    if (normal.z < 0.0f)
+    {
+        normal.xy = (1.0f - abs(normal.yx)) * (normal.xy >= 0.0f ? 1.0f : -1.0f);
+    }
+    return normalize(normal);
+}
+
+VertexShaderOutput main(VertexPackedNormalTexture IN, uint InstanceID : SV_InstanceID)
+{
+    VertexShaderOutput OUT;
+
+    Instance instance = Instances[InstanceID];
+    float3 positionMS = IN.Position * VertexQuantizationCB.PositionScale + VertexQuantizationCB.PositionOffset;
+    float4 position = float4(mul(instance.World, float4(positionMS, 1.0f)), 1.0f);
+    float3 normal = mul((float3x3)instance.Normal, DecodeOctahedral(IN.Normal));
+
+    OUT.Position = mul( TransformsCB.ModelViewProjectionMatrix, position);
+    OUT.PositionVS = mul( TransformsCB.ModelViewMatrix, position);
+    OUT.NormalVS = mul((float3x3)TransformsCB.InverseTransposeModelViewMatrix, normal);
+    OUT.TexCoord = IN.TexCoord;
+
+    return OUT;
+}
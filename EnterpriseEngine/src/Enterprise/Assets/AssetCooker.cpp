@@ -0,0 +1,505 @@
+#include "AssetCooker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <utility>
+
+#include "ContentHash.h"
+#include "CookedModel.h"
+#include "CookedTexture.h"
+#include "MappedFile.h"
+#include "../Core/ThreadPool.h"
+
+namespace Enterprise::Assets {
+
+namespace {
+
+// Bump when a change to the cooker alters its output for the same sources and settings.
+constexpr uint32_t ASSET_COOK_VERSION = 1;
+
+constexpr const char* MANIFEST_FILE = "manifest.txt";
+constexpr const char* MANIFEST_HEADER = "EnterpriseCook manifest";
+constexpr const char* TEMP_EXTENSION = ".cooktmp";
+
+uint64_t HashSettings( const ModelImportSettings &settings )
+{
+    ContentHasher hasher(COOKED_MODEL_VERSION);
+    hasher.Add(ASSET_COOK_VERSION);
+    hasher.Add(settings.OptimizeMeshes);
+    hasher.Add(settings.OptimizeOverdraw);
+    hasher.Add(settings.OverdrawThreshold);
+    hasher.Add(settings.BuildMeshlets);
+    hasher.Add(settings.MeshletMaxVertices);
+    hasher.Add(settings.MeshletMaxTriangles);
+    hasher.Add(settings.NumLods);
+    hasher.Add(settings.LodReduction);
+    hasher.Add(settings.LodMaxError);
+    hasher.Add(settings.VertexFormat);
+    hasher.Add(settings.MaxPositionError);
+    hasher.Add(settings.MaxNormalError);
+    hasher.Add(settings.MaxTexCoordError);
+    return hasher.GetHash();
+}
+
+uint64_t HashSettings( const TextureCookSettings &settings )
+{
+    ContentHasher hasher(COOKED_TEXTURE_VERSION);
+    hasher.Add(ASSET_COOK_VERSION);
+    hasher.Add(settings.Format);
+    hasher.Add(settings.Quality);
+    hasher.Add(settings.GenerateMips);
+    hasher.Add(settings.MipFilter);
+    hasher.Add(settings.Srgb);
+    return hasher.GetHash();
+}
+
+// Everything ProcessModelData reads, so equal hashes give equal processed meshes.
+uint64_t HashMeshes( const ModelData &model, uint64_t settingsHash )
+{
+    ContentHasher hasher(settingsHash);
+    hasher.Add(model.Meshes.size());
+    for (const auto &mesh: model.Meshes)
+    {
+        hasher.Add(mesh.Vertices.data(), mesh.Vertices.size() * sizeof(MeshVertex));
+        hasher.Add(mesh.Indices.data(), mesh.Indices.size() * sizeof(uint32_t));
+        hasher.Add(mesh.MaterialIndex);
+        hasher.Add(mesh.IsTriangleList);
+    }
+    hasher.Add(model.Nodes.size());
+    for (const auto &node: model.Nodes)
+    {
+        hasher.Add(node.Name);
+        hasher.Add(node.Transform, sizeof(node.Transform));
+        hasher.Add(node.Parent);
+        hasher.Add(node.FirstMesh);
+        hasher.Add(node.NumMeshes);
+    }
+    hasher.Add(model.NodeMeshes.data(), model.NodeMeshes.size() * sizeof(uint32_t));
+    hasher.Add(model.Materials.data(), model.Materials.size() * sizeof(MaterialData));
+    return hasher.GetHash();
+}
+
+uint64_t HashTexture( const TextureData &texture, uint64_t settingsHash )
+{
+    ContentHasher hasher(settingsHash);
+    hasher.Add(texture.Data.data(), texture.Data.size());
+    hasher.Add(texture.Width);
+    hasher.Add(texture.Height);
+    return hasher.GetHash();
+}
+
+bool IsTextureFile( const std::string &extension )
+{
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" ||
+           extension == ".bmp";
+}
+
+bool ReadFile( const std::string &fileName, std::vector<uint8_t>* data )
+{
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return false;
+    }
+    data->resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(data->data()), static_cast<std::streamsize>(data->size()));
+    return static_cast<bool>(file);
+}
+
+// Files are written under a unique temporary name and moved into place, so a cook that dies halfway
+// never leaves a truncated file behind and threads writing the same cache entry do not interleave.
+std::string GetTempPath( const std::string &fileName )
+{
+    static std::atomic<uint64_t> counter{0};
+    return fileName + "." + std::to_string(counter++) + TEMP_EXTENSION;
+}
+
+bool ReplaceFile( const std::string &tempFile, const std::string &fileName )
+{
+    std::error_code error;
+    std::filesystem::rename(tempFile, fileName, error);
+    if (error)
+    {
+        std::filesystem::remove(tempFile, error);
+        // Another thread may have put the same content there first, and still have it open.
+        return std::filesystem::exists(fileName, error);
+    }
+    return true;
+}
+
+bool WriteFile( const std::string &fileName, const std::vector<uint8_t> &data )
+{
+    std::string tempFile = GetTempPath(fileName);
+    {
+        std::ofstream file(tempFile, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file)
+        {
+            return false;
+        }
+    }
+    return ReplaceFile(tempFile, fileName);
+}
+
+}
+
+double AssetCookStatistics::GetCacheHitRate() const
+{
+    uint64_t hits = uint64_t(NumUpToDate) + MeshHits + TextureHits;
+    uint64_t lookups = uint64_t(NumAssets) + MeshHits + MeshMisses + TextureHits + TextureMisses;
+    return lookups > 0 ? double(hits) / double(lookups) : 0.0;
+}
+
+double AssetCookStatistics::GetMegabytesPerSecond() const
+{
+    return Seconds > 0.0 ? double(CookedBytes) / Seconds * 1e-6 : 0.0;
+}
+
+AssetCooker::AssetCooker( std::string sourceDirectory, std::string outputDirectory, std::string cacheDirectory,
+                          const AssetCookSettings &settings )
+    : m_SourceDirectory(std::move(sourceDirectory))
+    , m_OutputDirectory(std::move(outputDirectory))
+    , m_CacheDirectory(std::move(cacheDirectory))
+    , m_Settings(settings)
+    , m_ModelSettingsHash(HashSettings(settings.Model))
+    , m_TextureSettingsHash(HashSettings(settings.Texture))
+{}
+
+bool AssetCooker::Cook( AssetCookStatistics* statistics )
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::error_code error;
+    if (!std::filesystem::is_directory(m_SourceDirectory, error))
+    {
+        return false;
+    }
+    std::filesystem::create_directories(std::filesystem::path(m_CacheDirectory) / "meshes", error);
+    std::filesystem::create_directories(std::filesystem::path(m_CacheDirectory) / "textures", error);
+    m_Manifest.clear();
+    if (!m_Settings.Force)
+    {
+        LoadManifest();
+    }
+
+    std::vector<std::pair<std::string, AssetType> > assets;
+    for (std::filesystem::recursive_directory_iterator iter(m_SourceDirectory, error), end;
+         !error && iter != end; iter.increment(error))
+    {
+        std::error_code entryError;
+        if (iter->is_directory(entryError))
+        {
+            if (std::filesystem::equivalent(iter->path(), m_CacheDirectory, entryError))
+            {
+                iter.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (!iter->is_regular_file(entryError))
+        {
+            continue;
+        }
+
+        std::string extension = iter->path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       []( unsigned char c ) { return static_cast<char>(std::tolower(c)); });
+        // Skip what the cooker writes itself, wherever the output directory is.
+        if (extension == ".emdl" || extension == ".etex" || extension == TEMP_EXTENSION)
+        {
+            continue;
+        }
+
+        std::string relativePath = std::filesystem::relative(iter->path(), m_SourceDirectory, entryError)
+                .generic_string();
+        if (IsTextureFile(extension))
+        {
+            assets.emplace_back(relativePath, AssetType::Texture);
+        } else if (IsModelFile(iter->path().string()))
+        {
+            assets.emplace_back(relativePath, AssetType::Model);
+        }
+    }
+    std::sort(assets.begin(), assets.end());
+
+    // One asset per task. The texture and mesh work inside each asset spreads over the pool as well.
+    std::vector<CookResult> results(assets.size());
+    Core::Threads::ThreadPool::Get().ParallelFor(assets.size(), 1, [&]( size_t begin, size_t end )
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            results[i] = CookAsset(assets[i].first, assets[i].second);
+        }
+    });
+
+    AssetCookStatistics total;
+    total.NumAssets = static_cast<uint32_t>(assets.size());
+    m_Manifest.clear();
+    for (size_t i = 0; i < assets.size(); ++i)
+    {
+        const auto &result = results[i];
+        total.NumUpToDate += result.UpToDate ? 1 : 0;
+        total.NumCooked += result.Success && !result.UpToDate ? 1 : 0;
+        total.NumFailed += result.Success ? 0 : 1;
+        total.MeshHits += result.Statistics.MeshHits;
+        total.MeshMisses += result.Statistics.MeshMisses;
+        total.TextureHits += result.Statistics.TextureHits;
+        total.TextureMisses += result.Statistics.TextureMisses;
+        total.HashedBytes += result.Statistics.HashedBytes;
+        total.CookedBytes += result.Statistics.CookedBytes;
+        if (result.Success)
+        {
+            m_Manifest[assets[i].first] = result.Record;
+        }
+    }
+
+    bool saved = SaveManifest();
+    PruneCache();
+
+    total.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (statistics)
+    {
+        *statistics = total;
+    }
+    return saved && total.NumFailed == 0;
+}
+
+AssetCooker::CookResult AssetCooker::CookAsset( const std::string &relativePath, AssetType type ) const
+{
+    CookResult  result;
+    std::string sourceFile = (std::filesystem::path(m_SourceDirectory) / relativePath).string();
+    std::string outputFile = (std::filesystem::path(m_OutputDirectory) / relativePath).string() +
+                             (type == AssetType::Model ? ".emdl" : ".etex");
+
+    {
+        MappedFile source;
+        if (!source.Open(sourceFile))
+        {
+            return result;
+        }
+        result.Record.SourceHash = HashContent(source.GetData(), source.GetSize());
+        result.Statistics.HashedBytes = source.GetSize();
+    }
+    // Models embed their textures, so they depend on both.
+    ContentHasher settingsHasher(m_TextureSettingsHash);
+    if (type == AssetType::Model)
+    {
+        settingsHasher.Add(m_ModelSettingsHash);
+    }
+    result.Record.SettingsHash = settingsHasher.GetHash();
+
+    std::error_code error;
+    auto            iter = m_Manifest.find(relativePath);
+    if (iter != m_Manifest.end() && iter->second.SourceHash == result.Record.SourceHash &&
+        iter->second.SettingsHash == result.Record.SettingsHash && std::filesystem::exists(outputFile, error))
+    {
+        result.Success = true;
+        result.UpToDate = true;
+        result.Record = iter->second;
+        return result;
+    }
+
+    std::filesystem::create_directories(std::filesystem::path(outputFile).parent_path(), error);
+    result.Success = type == AssetType::Model
+                         ? CookModel(sourceFile, outputFile, &result.Record, &result.Statistics)
+                         : CookTexture(sourceFile, outputFile, &result.Record, &result.Statistics);
+    result.Statistics.CookedBytes = result.Success ? result.Statistics.HashedBytes : 0;
+    return result;
+}
+
+bool AssetCooker::CookModel( const std::string &sourceFile, const std::string &outputFile, ManifestRecord* record,
+                             AssetCookStatistics* statistics ) const
+{
+    ModelData model;
+    if (!ReadModelData(sourceFile, &model))
+    {
+        return false;
+    }
+    std::vector<TextureData> textures;
+    textures.swap(model.Textures);
+
+    // The meshes are keyed by what was imported rather than by the file, which changes with its textures.
+    std::string meshEntry = "meshes/" + FormatContentHash(HashMeshes(model, m_ModelSettingsHash)) + ".emdl";
+    std::string meshFile = GetCachePath(meshEntry);
+    record->Dependencies.push_back(meshEntry);
+
+    CookedModel meshes;
+    if (!m_Settings.Force && meshes.Open(meshFile))
+    {
+        statistics->MeshHits += 1;
+    } else
+    {
+        statistics->MeshMisses += 1;
+        ProcessModelData(&model, m_Settings.Model);
+
+        std::string tempFile = GetTempPath(meshFile);
+        if (!WriteCookedModel(tempFile, model) || !ReplaceFile(tempFile, meshFile) || !meshes.Open(meshFile))
+        {
+            return false;
+        }
+    }
+
+    CookTextures(&textures, record, statistics);
+
+    std::string tempFile = GetTempPath(outputFile);
+    return WriteCookedModel(tempFile, meshes, textures) && ReplaceFile(tempFile, outputFile);
+}
+
+bool AssetCooker::CookTexture( const std::string &sourceFile, const std::string &outputFile, ManifestRecord* record,
+                               AssetCookStatistics* statistics ) const
+{
+    // Image files go through the same path as embedded images that are stored compressed.
+    std::vector<TextureData> textures(1);
+    if (!ReadFile(sourceFile, &textures[0].Data))
+    {
+        return false;
+    }
+
+    CookTextures(&textures, record, statistics);
+    const auto &texture = textures[0];
+    return IsCookedTexture(texture.Data.data(), texture.Data.size()) && WriteFile(outputFile, texture.Data);
+}
+
+void AssetCooker::CookTextures( std::vector<TextureData>* textures, ManifestRecord* record,
+                                AssetCookStatistics* statistics ) const
+{
+    ModelData                pending;
+    std::vector<size_t>      pendingIndices;
+    std::vector<std::string> pendingEntries;
+    for (size_t i = 0; i < textures->size(); ++i)
+    {
+        auto &      texture = (*textures)[i];
+        std::string entry = "textures/" + FormatContentHash(HashTexture(texture, m_TextureSettingsHash)) + ".etex";
+
+        std::vector<uint8_t> cooked;
+        if (!m_Settings.Force && ReadFile(GetCachePath(entry), &cooked) &&
+            IsCookedTexture(cooked.data(), cooked.size()))
+        {
+            statistics->TextureHits += 1;
+            record->Dependencies.push_back(entry);
+            texture.Data.swap(cooked);
+            texture.Width = 0;
+            texture.Height = 0;
+            continue;
+        }
+
+        statistics->TextureMisses += 1;
+        pending.Textures.push_back(std::move(texture));
+        pendingIndices.push_back(i);
+        pendingEntries.push_back(entry);
+    }
+
+    CookModelTextures(&pending, m_Settings.Texture);
+
+    for (size_t i = 0; i < pendingIndices.size(); ++i)
+    {
+        auto &texture = pending.Textures[i];
+        // Textures that failed to decode stay as they were and are not cached.
+        if (texture.Height == 0 && IsCookedTexture(texture.Data.data(), texture.Data.size()) &&
+            WriteFile(GetCachePath(pendingEntries[i]), texture.Data))
+        {
+            record->Dependencies.push_back(pendingEntries[i]);
+        }
+        (*textures)[pendingIndices[i]] = std::move(texture);
+    }
+}
+
+bool AssetCooker::LoadManifest()
+{
+    std::ifstream file((std::filesystem::path(m_CacheDirectory) / MANIFEST_FILE).string());
+    std::string   line;
+    if (!file || !std::getline(file, line) || line != std::string(MANIFEST_HEADER) + " " +
+        std::to_string(ASSET_COOK_VERSION))
+    {
+        return false;
+    }
+
+    // <source hash> <settings hash> <dependency count> <dependencies...> <source path>
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string        sourceHash;
+        std::string        settingsHash;
+        size_t             numDependencies = 0;
+        ManifestRecord     record;
+        if (!(stream >> sourceHash >> settingsHash >> numDependencies))
+        {
+            continue;
+        }
+        record.SourceHash = std::stoull(sourceHash, nullptr, 16);
+        record.SettingsHash = std::stoull(settingsHash, nullptr, 16);
+        record.Dependencies.resize(numDependencies);
+        for (auto &dependency: record.Dependencies)
+        {
+            stream >> dependency;
+        }
+
+        std::string path;
+        stream.ignore(1);
+        if (std::getline(stream, path) && !path.empty())
+        {
+            m_Manifest[path] = std::move(record);
+        }
+    }
+    return true;
+}
+
+bool AssetCooker::SaveManifest() const
+{
+    std::ostringstream stream;
+    stream << MANIFEST_HEADER << " " << ASSET_COOK_VERSION << "\n";
+    for (const auto &[path, record]: m_Manifest)
+    {
+        stream << FormatContentHash(record.SourceHash) << " " << FormatContentHash(record.SettingsHash) << " "
+               << record.Dependencies.size();
+        for (const auto &dependency: record.Dependencies)
+        {
+            stream << " " << dependency;
+        }
+        stream << " " << path << "\n";
+    }
+
+    std::string text = stream.str();
+    return WriteFile((std::filesystem::path(m_CacheDirectory) / MANIFEST_FILE).string(),
+                     std::vector<uint8_t>(text.begin(), text.end()));
+}
+
+void AssetCooker::PruneCache() const
+{
+    std::set<std::string> referenced;
+    for (const auto &entry: m_Manifest)
+    {
+        referenced.insert(entry.second.Dependencies.begin(), entry.second.Dependencies.end());
+    }
+
+    std::vector<std::filesystem::path> unreferenced;
+    std::error_code                    error;
+    for (const char* directory: {"meshes", "textures"})
+    {
+        for (std::filesystem::directory_iterator iter(std::filesystem::path(m_CacheDirectory) / directory, error), end;
+             !error && iter != end; iter.increment(error))
+        {
+            if (referenced.count(std::string(directory) + "/" + iter->path().filename().string()) == 0)
+            {
+                unreferenced.push_back(iter->path());
+            }
+        }
+    }
+    for (const auto &path: unreferenced)
+    {
+        std::filesystem::remove(path, error);
+    }
+}
+
+std::string AssetCooker::GetCachePath( const std::string &entry ) const
+{
+    return (std::filesystem::path(m_CacheDirectory) / entry).string();
+}
+
+}
@@ -0,0 +1,123 @@
+#ifndef ASSETCOOKER_H
+#define ASSETCOOKER_H
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ModelImporter.h"
+#include "TextureCooker.h"
+
+
+namespace Enterprise::Assets {
+
+//---------------------------------------------------------------------------------------------|
+// Cook cache layout                                                                           |
+//---------------------------------------------------------------------------------------------|
+// manifest.txt              one record per source: its hash, the hash of the settings it was  |
+//                           cooked with and the cache entries its output was built from       |
+// meshes/<hash>.emdl        cooked model without textures, keyed by the imported meshes       |
+// textures/<hash>.etex      cooked texture, keyed by the encoded image                        |
+//---------------------------------------------------------------------------------------------|
+// A model's meshes and each of its embedded textures are separate cache entries, so editing   |
+// one texture of a model re-encodes only that texture and reuses the processed meshes.        |
+//---------------------------------------------------------------------------------------------|
+
+struct AssetCookSettings {
+    ModelImportSettings Model;
+    TextureCookSettings Texture;
+    // Cook everything again, ignoring the manifest and the cache.
+    bool                Force = false;
+};
+
+struct AssetCookStatistics {
+    uint32_t NumAssets = 0;
+    uint32_t NumUpToDate = 0;
+    uint32_t NumCooked = 0;
+    uint32_t NumFailed = 0;
+    // Lookups of the cache entries below whole assets.
+    uint32_t MeshHits = 0;
+    uint32_t MeshMisses = 0;
+    uint32_t TextureHits = 0;
+    uint32_t TextureMisses = 0;
+    // Source bytes hashed, and source bytes of the assets that were cooked.
+    uint64_t HashedBytes = 0;
+    uint64_t CookedBytes = 0;
+    double   Seconds = 0.0;
+
+    // Hits over every lookup, whole assets and cache entries alike.
+    [[nodiscard]] double GetCacheHitRate() const;
+
+    // Source bytes cooked per second.
+    [[nodiscard]] double GetMegabytesPerSecond() const;
+};
+
+/**
+ * Cooks every model and texture under a directory into cooked models and textures the runtime loads
+ * directly, next to where Model::GetCookedPath looks for them unless told otherwise. Sources whose content
+ * and settings match the manifest are skipped, the rest are cooked in parallel on the shared thread pool.
+ */
+class AssetCooker {
+public:
+    AssetCooker( std::string sourceDirectory, std::string outputDirectory, std::string cacheDirectory,
+                 const AssetCookSettings &settings );
+
+    /**
+     * Returns false if any asset failed to cook. Assets that failed keep no manifest record, so they are
+     * tried again next time.
+     */
+    bool Cook( AssetCookStatistics* statistics );
+
+private:
+    enum class AssetType : uint32_t {
+        Model = 0,
+        Texture,
+    };
+
+    struct ManifestRecord {
+        uint64_t                 SourceHash = 0;
+        uint64_t                 SettingsHash = 0;
+        // Cache entries the output was built from, like "meshes/<hash>.emdl".
+        std::vector<std::string> Dependencies;
+    };
+
+    struct CookResult {
+        bool                Success = false;
+        bool                UpToDate = false;
+        ManifestRecord      Record;
+        AssetCookStatistics Statistics;
+    };
+
+    bool LoadManifest();
+
+    bool SaveManifest() const;
+
+    CookResult CookAsset( const std::string &relativePath, AssetType type ) const;
+
+    bool CookModel( const std::string &sourceFile, const std::string &outputFile, ManifestRecord* record,
+                    AssetCookStatistics* statistics ) const;
+
+    bool CookTexture( const std::string &sourceFile, const std::string &outputFile, ManifestRecord* record,
+                      AssetCookStatistics* statistics ) const;
+
+    // Swap textures with their cooked versions, from the cache where possible.
+    void CookTextures( std::vector<TextureData>* textures, ManifestRecord* record,
+                       AssetCookStatistics* statistics ) const;
+
+    // Remove cache entries no manifest record depends on any more.
+    void PruneCache() const;
+
+    [[nodiscard]] std::string GetCachePath( const std::string &entry ) const;
+
+    std::string                           m_SourceDirectory;
+    std::string                           m_OutputDirectory;
+    std::string                           m_CacheDirectory;
+    AssetCookSettings                     m_Settings;
+    uint64_t                              m_ModelSettingsHash;
+    uint64_t                              m_TextureSettingsHash;
+    std::map<std::string, ManifestRecord> m_Manifest;
+};
+
+}
+
+#endif //ASSETCOOKER_H
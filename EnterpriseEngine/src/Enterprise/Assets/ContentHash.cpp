@@ -0,0 +1,114 @@
+#include "ContentHash.h"
+
+#include <cstring>
+
+namespace Enterprise::Assets {
+
+namespace {
+
+constexpr uint64_t PRIME1 = 11400714785074694791ull;
+constexpr uint64_t PRIME2 = 14029467366897019727ull;
+constexpr uint64_t PRIME3 = 1609587929392839161ull;
+constexpr uint64_t PRIME4 = 9650029242287828579ull;
+constexpr uint64_t PRIME5 = 2870177450012600261ull;
+
+uint64_t RotateLeft( uint64_t value, int bits )
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t Read64( const uint8_t* data )
+{
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint32_t Read32( const uint8_t* data )
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint64_t Round( uint64_t accumulator, uint64_t input )
+{
+    accumulator += input * PRIME2;
+    accumulator = RotateLeft(accumulator, 31);
+    return accumulator * PRIME1;
+}
+
+uint64_t MergeRound( uint64_t hash, uint64_t accumulator )
+{
+    hash ^= Round(0, accumulator);
+    return hash * PRIME1 + PRIME4;
+}
+
+}
+
+uint64_t HashContent( const void* data, size_t size, uint64_t seed )
+{
+    auto           bytes = static_cast<const uint8_t *>(data);
+    const uint8_t* end = bytes + size;
+    uint64_t       hash;
+
+    if (size >= 32)
+    {
+        // Four independent lanes over 32 byte stripes.
+        uint64_t lanes[4] = {seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1};
+        for (; bytes + 32 <= end; bytes += 32)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                lanes[i] = Round(lanes[i], Read64(bytes + i * 8));
+            }
+        }
+        hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) +
+               RotateLeft(lanes[3], 18);
+        for (uint64_t lane: lanes)
+        {
+            hash = MergeRound(hash, lane);
+        }
+    } else
+    {
+        hash = seed + PRIME5;
+    }
+
+    hash += size;
+    for (; bytes + 8 <= end; bytes += 8)
+    {
+        hash ^= Round(0, Read64(bytes));
+        hash = RotateLeft(hash, 27) * PRIME1 + PRIME4;
+    }
+    if (bytes + 4 <= end)
+    {
+        hash ^= uint64_t(Read32(bytes)) * PRIME1;
+        hash = RotateLeft(hash, 23) * PRIME2 + PRIME3;
+        bytes += 4;
+    }
+    for (; bytes < end; ++bytes)
+    {
+        hash ^= *bytes * PRIME5;
+        hash = RotateLeft(hash, 11) * PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+std::string FormatContentHash( uint64_t hash )
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string       text(16, '0');
+    for (int i = 15; i >= 0; --i, hash >>= 4)
+    {
+        text[i] = digits[hash & 0xF];
+    }
+    return text;
+}
+
+}
@@ -0,0 +1,47 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+
+namespace Enterprise::Assets {
+
+/**
+ * 64 bit hash of a block of memory (the XXH64 algorithm). Fast enough to hash every source asset on every
+ * cook, and wide enough to key cooked data by content alone.
+ */
+[[nodiscard]] uint64_t HashContent( const void* data, size_t size, uint64_t seed = 0 );
+
+// Sixteen lowercase hex digits, for file names and manifests.
+[[nodiscard]] std::string FormatContentHash( uint64_t hash );
+
+/**
+ * Hashes a sequence of values. Add fields one at a time rather than whole structs, so padding never
+ * ends up in the hash.
+ */
+class ContentHasher {
+public:
+    explicit ContentHasher( uint64_t seed = 0 ) : m_Hash(seed) {}
+
+    void Add( const void* data, size_t size ) { m_Hash = HashContent(data, size, m_Hash ^ size); }
+
+    void Add( const std::string &value ) { Add(value.data(), value.size()); }
+
+    template<typename T>
+    void Add( const T &value )
+    {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Add structs field by field");
+        Add(&value, sizeof(value));
+    }
+
+    [[nodiscard]] uint64_t GetHash() const { return m_Hash; }
+
+private:
+    uint64_t m_Hash;
+};
+
+}
+
+#endif //CONTENTHASH_H
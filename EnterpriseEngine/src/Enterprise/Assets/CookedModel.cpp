@@ -0,0 +1,436 @@
+#include "CookedModel.h"
+#include "CookedTexture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace Enterprise::Assets {
+
+namespace {
+
+uint64_t AlignSection( uint64_t offset )
+{
+    return (offset + COOKED_MODEL_ALIGNMENT - 1) & ~(COOKED_MODEL_ALIGNMENT - 1);
+}
+
+// Collects the sections of a cooked file and lays them out on write.
+class CookedModelWriter {
+public:
+    void AddSection( CookedSectionType type, uint32_t elementSize, uint64_t count, const void* data )
+    {
+        m_Sections.push_back({type, elementSize, 0, count});
+        m_SectionData.push_back(static_cast<const uint8_t *>(data));
+    }
+
+    template<typename T>
+    void AddSection( CookedSectionType type, const std::vector<T> &elements )
+    {
+        AddSection(type, sizeof(T), elements.size(), elements.data());
+    }
+
+    bool Write( const std::string &fileName )
+    {
+        uint64_t offset = sizeof(CookedModelHeader) + sizeof(CookedSection) * m_Sections.size();
+        for (auto &section: m_Sections)
+        {
+            offset = AlignSection(offset);
+            section.Offset = offset;
+            offset += section.ElementSize * section.Count;
+        }
+
+        CookedModelHeader header{};
+        header.Magic = COOKED_MODEL_MAGIC;
+        header.Version = COOKED_MODEL_VERSION;
+        header.NumSections = static_cast<uint32_t>(m_Sections.size());
+        header.FileSize = AlignSection(offset);
+
+        std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            return false;
+        }
+
+        static const char padding[COOKED_MODEL_ALIGNMENT] = {};
+        uint64_t          written = 0;
+        auto              write = [&]( const void* data, uint64_t size )
+        {
+            file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+            written += size;
+        };
+        auto pad = [&]( uint64_t to )
+        {
+            write(padding, to - written);
+        };
+
+        write(&header, sizeof(header));
+        write(m_Sections.data(), sizeof(CookedSection) * m_Sections.size());
+        for (size_t i = 0; i < m_Sections.size(); ++i)
+        {
+            pad(m_Sections[i].Offset);
+            write(m_SectionData[i], m_Sections[i].ElementSize * m_Sections[i].Count);
+        }
+        pad(header.FileSize);
+
+        return static_cast<bool>(file);
+    }
+
+private:
+    std::vector<CookedSection>   m_Sections;
+    std::vector<const uint8_t *> m_SectionData;
+};
+
+void BuildTextureSections( const std::vector<TextureData> &  textures, std::vector<CookedTextureRange>* ranges,
+                           std::vector<uint8_t>*             data )
+{
+    for (const auto &texture: textures)
+    {
+        // Cooked textures are read in place, so each one starts aligned.
+        data->resize((data->size() + COOKED_TEXTURE_ALIGNMENT - 1) & ~(COOKED_TEXTURE_ALIGNMENT - 1));
+
+        CookedTextureRange range{};
+        range.Offset = data->size();
+        range.Size = texture.Data.size();
+        range.Width = texture.Width;
+        range.Height = texture.Height;
+        ranges->push_back(range);
+
+        data->insert(data->end(), texture.Data.begin(), texture.Data.end());
+    }
+}
+
+}
+
+std::vector<CookedNode> BuildCookedNodes( const ModelData &model )
+{
+    std::vector<CookedNode> nodes;
+    nodes.reserve(model.Nodes.size());
+    for (const auto &node: model.Nodes)
+    {
+        CookedNode cookedNode{};
+        std::memcpy(cookedNode.Transform, node.Transform, sizeof(cookedNode.Transform));
+        cookedNode.Parent = node.Parent;
+        cookedNode.FirstMesh = node.FirstMesh;
+        cookedNode.NumMeshes = node.NumMeshes;
+        nodes.push_back(cookedNode);
+    }
+    return nodes;
+}
+
+bool WriteCookedModel( const std::string &fileName, const ModelData &model )
+{
+    std::vector<CookedMeshRange>      meshRanges;
+    std::vector<MeshVertex>           vertices;
+    std::vector<uint32_t>             indices;
+    std::vector<Geometry::Meshlet>    meshlets;
+    std::vector<Geometry::MeshLod>    lods;
+    std::vector<Geometry::MeshBounds> meshBounds;
+    size_t                            numVertices = 0;
+    size_t                            numIndices = 0;
+    for (const auto &mesh: model.Meshes)
+    {
+        numVertices += mesh.Vertices.size();
+        numIndices += mesh.Indices.size();
+    }
+    meshRanges.reserve(model.Meshes.size());
+    meshBounds.reserve(model.Meshes.size());
+    vertices.reserve(numVertices);
+    indices.reserve(numIndices);
+
+    for (const auto &mesh: model.Meshes)
+    {
+        CookedMeshRange range{};
+        range.BaseVertex = static_cast<uint32_t>(vertices.size());
+        range.NumVertices = static_cast<uint32_t>(mesh.Vertices.size());
+        range.FirstIndex = static_cast<uint32_t>(indices.size());
+        range.NumIndices = static_cast<uint32_t>(mesh.Indices.size());
+        range.MaterialIndex = mesh.MaterialIndex;
+        range.FirstMeshlet = static_cast<uint32_t>(meshlets.size());
+        range.NumMeshlets = static_cast<uint32_t>(mesh.Meshlets.size());
+        range.FirstLod = static_cast<uint32_t>(lods.size());
+        range.NumLods = static_cast<uint32_t>(mesh.Lods.size());
+        meshRanges.push_back(range);
+        meshBounds.push_back(mesh.Bounds);
+
+        meshlets.insert(meshlets.end(), mesh.Meshlets.begin(), mesh.Meshlets.end());
+        lods.insert(lods.end(), mesh.Lods.begin(), mesh.Lods.end());
+        vertices.insert(vertices.end(), mesh.Vertices.begin(), mesh.Vertices.end());
+        indices.insert(indices.end(), mesh.Indices.begin(), mesh.Indices.end());
+    }
+
+    std::vector<CookedVertexStream> vertexStreams;
+    std::vector<uint8_t>            packedVertices;
+    for (const auto &mesh: model.Meshes)
+    {
+        CookedVertexStream stream{};
+        stream.Offset = packedVertices.size();
+        stream.Size = mesh.PackedVertices.size();
+        stream.Format = mesh.VertexFormat;
+        stream.Stride = static_cast<uint32_t>(Geometry::GetVertexFormatStride(mesh.VertexFormat));
+        stream.Quantization = mesh.Quantization;
+        vertexStreams.push_back(stream);
+
+        packedVertices.insert(packedVertices.end(), mesh.PackedVertices.begin(), mesh.PackedVertices.end());
+    }
+
+    std::vector<CookedNode> nodes = BuildCookedNodes(model);
+
+    std::vector<CookedTextureRange> textureRanges;
+    std::vector<uint8_t>            textureData;
+    BuildTextureSections(model.Textures, &textureRanges, &textureData);
+
+    CookedModelWriter writer;
+    writer.AddSection(CookedSectionType::MeshRanges, meshRanges);
+    writer.AddSection(CookedSectionType::Nodes, nodes);
+    writer.AddSection(CookedSectionType::NodeMeshes, model.NodeMeshes);
+    writer.AddSection(CookedSectionType::Vertices, vertices);
+    writer.AddSection(CookedSectionType::Indices, indices);
+    writer.AddSection(CookedSectionType::TextureRanges, textureRanges);
+    writer.AddSection(CookedSectionType::TextureData, textureData);
+    writer.AddSection(CookedSectionType::VertexStreams, vertexStreams);
+    writer.AddSection(CookedSectionType::PackedVertices, packedVertices);
+    writer.AddSection(CookedSectionType::Meshlets, meshlets);
+    writer.AddSection(CookedSectionType::Lods, lods);
+    writer.AddSection(CookedSectionType::Materials, model.Materials);
+    writer.AddSection(CookedSectionType::MeshBounds, meshBounds);
+
+    return writer.Write(fileName);
+}
+
+bool WriteCookedModel( const std::string &fileName, const CookedModel &model, const std::vector<TextureData> &textures )
+{
+    std::vector<CookedTextureRange> textureRanges;
+    std::vector<uint8_t>            textureData;
+    BuildTextureSections(textures, &textureRanges, &textureData);
+
+    CookedModelWriter writer;
+    for (uint32_t i = 0; i < model.GetNumSections(); ++i)
+    {
+        const auto &section = model.GetSection(i);
+        if (section.Type != CookedSectionType::TextureRanges && section.Type != CookedSectionType::TextureData)
+        {
+            writer.AddSection(section.Type, section.ElementSize, section.Count, model.GetSectionData(section));
+        }
+    }
+    writer.AddSection(CookedSectionType::TextureRanges, textureRanges);
+    writer.AddSection(CookedSectionType::TextureData, textureData);
+
+    return writer.Write(fileName);
+}
+
+CookedModel::CookedModel()
+    : m_Header(nullptr)
+    , m_Sections(nullptr)
+    , m_MeshRanges(nullptr)
+    , m_NumMeshes(0)
+    , m_Nodes(nullptr)
+    , m_NumNodes(0)
+    , m_NodeMeshes(nullptr)
+    , m_Vertices(nullptr)
+    , m_Indices(nullptr)
+    , m_TextureRanges(nullptr)
+    , m_NumTextures(0)
+    , m_TextureData(nullptr)
+    , m_VertexStreams(nullptr)
+    , m_PackedVertices(nullptr)
+    , m_Meshlets(nullptr)
+    , m_Lods(nullptr)
+    , m_Materials(nullptr)
+    , m_NumMaterials(0)
+    , m_MeshBounds(nullptr)
+{}
+
+bool CookedModel::Open( const std::string &fileName )
+{
+    Close();
+
+    if (!m_File.Open(fileName) || m_File.GetSize() < sizeof(CookedModelHeader))
+    {
+        Close();
+        return false;
+    }
+
+    m_Header = reinterpret_cast<const CookedModelHeader *>(m_File.GetData());
+    m_Sections = reinterpret_cast<const CookedSection *>(m_File.GetData() + sizeof(CookedModelHeader));
+
+    if (!Validate())
+    {
+        Close();
+        return false;
+    }
+
+    uint64_t numNodeMeshes = 0;
+    uint64_t numVertices = 0;
+    uint64_t numIndices = 0;
+    uint64_t textureDataSize = 0;
+    uint64_t numVertexStreams = 0;
+    uint64_t packedVerticesSize = 0;
+    uint64_t numMeshlets = 0;
+    uint64_t numLods = 0;
+    uint64_t numMeshBounds = 0;
+    m_MeshRanges = FindSection<CookedMeshRange>(CookedSectionType::MeshRanges, &m_NumMeshes);
+    m_Nodes = FindSection<CookedNode>(CookedSectionType::Nodes, &m_NumNodes);
+    m_NodeMeshes = FindSection<uint32_t>(CookedSectionType::NodeMeshes, &numNodeMeshes);
+    m_Vertices = FindSection<MeshVertex>(CookedSectionType::Vertices, &numVertices);
+    m_Indices = FindSection<uint32_t>(CookedSectionType::Indices, &numIndices);
+    m_TextureRanges = FindSection<CookedTextureRange>(CookedSectionType::TextureRanges, &m_NumTextures);
+    m_TextureData = FindSection<uint8_t>(CookedSectionType::TextureData, &textureDataSize);
+    m_VertexStreams = FindSection<CookedVertexStream>(CookedSectionType::VertexStreams, &numVertexStreams);
+    m_PackedVertices = FindSection<uint8_t>(CookedSectionType::PackedVertices, &packedVerticesSize);
+    m_Meshlets = FindSection<Geometry::Meshlet>(CookedSectionType::Meshlets, &numMeshlets);
+    m_Lods = FindSection<Geometry::MeshLod>(CookedSectionType::Lods, &numLods);
+    m_Materials = FindSection<MaterialData>(CookedSectionType::Materials, &m_NumMaterials);
+    m_MeshBounds = FindSection<Geometry::MeshBounds>(CookedSectionType::MeshBounds, &numMeshBounds);
+
+    bool valid = m_MeshRanges && m_Nodes && m_NodeMeshes && m_Vertices && m_Indices && m_MeshBounds &&
+                 numMeshBounds == m_NumMeshes;
+    for (uint64_t i = 0; valid && i < m_NumMeshes; ++i)
+    {
+        const auto &range = m_MeshRanges[i];
+        valid = uint64_t(range.BaseVertex) + range.NumVertices <= numVertices &&
+                uint64_t(range.FirstIndex) + range.NumIndices <= numIndices &&
+                uint64_t(range.FirstMeshlet) + range.NumMeshlets <= numMeshlets &&
+                uint64_t(range.FirstLod) + range.NumLods <= numLods &&
+                (m_NumMaterials == 0 || range.MaterialIndex < m_NumMaterials);
+        // Indices reach GPU buffers as they are, so every one has to stay inside its mesh.
+        if (valid && range.NumIndices != 0)
+        {
+            const uint32_t* indices = m_Indices + range.FirstIndex;
+            valid = *std::max_element(indices, indices + range.NumIndices) < range.NumVertices;
+        }
+        for (uint32_t j = 0; valid && j < range.NumMeshlets; ++j)
+        {
+            const auto &meshlet = m_Meshlets[range.FirstMeshlet + j];
+            valid = uint64_t(meshlet.FirstIndex) + meshlet.NumIndices <= range.NumIndices;
+        }
+        for (uint32_t j = 0; valid && j < range.NumLods; ++j)
+        {
+            const auto &lod = m_Lods[range.FirstLod + j];
+            valid = uint64_t(lod.FirstIndex) + lod.NumIndices <= range.NumIndices;
+        }
+    }
+    if (m_VertexStreams)
+    {
+        valid = valid && numVertexStreams == m_NumMeshes;
+        for (uint64_t i = 0; valid && i < m_NumMeshes; ++i)
+        {
+            const auto &stream = m_VertexStreams[i];
+            if (stream.Format == Geometry::VertexFormat::Float)
+            {
+                continue;
+            }
+            valid = stream.Format < Geometry::VertexFormat::NumFormats &&
+                    stream.Stride == Geometry::GetVertexFormatStride(stream.Format) &&
+                    stream.Size == uint64_t(stream.Stride) * m_MeshRanges[i].NumVertices &&
+                    m_PackedVertices && stream.Offset <= packedVerticesSize &&
+                    stream.Size <= packedVerticesSize - stream.Offset;
+        }
+    }
+    // Parents come before their children, so the hierarchy can be walked in one pass without cycles.
+    for (uint64_t i = 0; valid && i < m_NumNodes; ++i)
+    {
+        const auto &node = m_Nodes[i];
+        valid = uint64_t(node.FirstMesh) + node.NumMeshes <= numNodeMeshes &&
+                (node.Parent == -1 || (node.Parent >= 0 && uint64_t(node.Parent) < i));
+    }
+    for (uint64_t i = 0; valid && i < numNodeMeshes; ++i)
+    {
+        valid = m_NodeMeshes[i] < m_NumMeshes;
+    }
+    for (uint64_t i = 0; valid && i < m_NumTextures; ++i)
+    {
+        const auto &range = m_TextureRanges[i];
+        valid = m_TextureData && range.Offset <= textureDataSize && range.Size <= textureDataSize - range.Offset;
+    }
+    for (uint64_t i = 0; valid && i < m_NumMaterials; ++i)
+    {
+        const auto &material = m_Materials[i];
+        valid = material.AlphaMode <= MaterialAlphaMode::Blend;
+        for (uint32_t texture: {material.BaseColorTexture, material.NormalTexture, material.MetallicRoughnessTexture,
+                                material.EmissiveTexture})
+        {
+            valid = valid && (texture == NO_MATERIAL_TEXTURE || texture < m_NumTextures);
+        }
+    }
+
+    if (!valid)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void CookedModel::Close()
+{
+    m_File.Close();
+    m_Header = nullptr;
+    m_Sections = nullptr;
+    m_MeshRanges = nullptr;
+    m_NumMeshes = 0;
+    m_Nodes = nullptr;
+    m_NumNodes = 0;
+    m_NodeMeshes = nullptr;
+    m_Vertices = nullptr;
+    m_Indices = nullptr;
+    m_TextureRanges = nullptr;
+    m_NumTextures = 0;
+    m_TextureData = nullptr;
+    m_VertexStreams = nullptr;
+    m_PackedVertices = nullptr;
+    m_Meshlets = nullptr;
+    m_Lods = nullptr;
+    m_Materials = nullptr;
+    m_NumMaterials = 0;
+    m_MeshBounds = nullptr;
+}
+
+bool CookedModel::Validate() const
+{
+    if (m_Header->Magic != COOKED_MODEL_MAGIC || m_Header->Version != COOKED_MODEL_VERSION ||
+        m_Header->FileSize != m_File.GetSize())
+    {
+        return false;
+    }
+
+    uint64_t tableEnd = sizeof(CookedModelHeader) + sizeof(CookedSection) * uint64_t(m_Header->NumSections);
+    if (tableEnd > m_File.GetSize())
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < m_Header->NumSections; ++i)
+    {
+        const auto &section = m_Sections[i];
+        if (section.Offset % COOKED_MODEL_ALIGNMENT != 0 || section.Offset < tableEnd ||
+            section.Offset > m_File.GetSize() || section.ElementSize == 0 ||
+            section.Count > (m_File.GetSize() - section.Offset) / section.ElementSize)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const void* CookedModel::FindSection( CookedSectionType type, uint32_t elementSize, uint64_t* count ) const
+{
+    *count = 0;
+    for (uint32_t i = 0; i < m_Header->NumSections; ++i)
+    {
+        if (m_Sections[i].Type == type)
+        {
+            if (m_Sections[i].ElementSize != elementSize)
+            {
+                return nullptr;
+            }
+            *count = m_Sections[i].Count;
+            return m_File.GetData() + m_Sections[i].Offset;
+        }
+    }
+    return nullptr;
+}
+
+}
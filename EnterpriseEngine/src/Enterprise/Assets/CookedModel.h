@@ -0,0 +1,250 @@
+#ifndef COOKEDMODEL_H
+#define COOKEDMODEL_H
+#include <cstdint>
+#include <string>
+
+#include "MappedFile.h"
+#include "ModelData.h"
+
+
+namespace Enterprise::Assets {
+
+//---------------------------------------------------------------------------------------------|
+// Cooked model file layout                                                                    |
+//---------------------------------------------------------------------------------------------|
+// CookedModelHeader                                                                           |
+// CookedSection[NumSections]                                                                  |
+// Section data, each section starting on a COOKED_MODEL_ALIGNMENT boundary                    |
+//---------------------------------------------------------------------------------------------|
+// Sections are looked up by type so new sections can be added without breaking old readers.   |
+// Bump COOKED_MODEL_VERSION whenever the layout of an existing section changes.               |
+//---------------------------------------------------------------------------------------------|
+constexpr uint32_t COOKED_MODEL_MAGIC = 0x4C444D45; // "EMDL"
+constexpr uint32_t COOKED_MODEL_VERSION = 7;
+constexpr uint64_t COOKED_MODEL_ALIGNMENT = 64;
+
+enum class CookedSectionType : uint32_t {
+    MeshRanges = 1,
+    Nodes,
+    NodeMeshes,
+    Vertices,
+    Indices,
+    TextureRanges,
+    TextureData,
+    VertexStreams,
+    PackedVertices,
+    Meshlets,
+    Lods,
+    Materials,
+    MeshBounds,
+};
+
+struct CookedModelHeader {
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t NumSections;
+    uint32_t Reserved;
+    uint64_t FileSize;
+};
+
+struct CookedSection {
+    CookedSectionType Type;
+    uint32_t          ElementSize;
+    uint64_t          Offset;
+    uint64_t          Count;
+};
+
+struct CookedMeshRange {
+    // Offsets into the Vertices and Indices sections. Indices are relative to BaseVertex.
+    uint32_t BaseVertex;
+    uint32_t NumVertices;
+    uint32_t FirstIndex;
+    uint32_t NumIndices;
+    uint32_t MaterialIndex;
+    // Offset into the Meshlets section. Meshlet index ranges are relative to FirstIndex.
+    uint32_t FirstMeshlet;
+    uint32_t NumMeshlets;
+    // Offset into the Lods section. Lod index ranges are relative to FirstIndex.
+    uint32_t FirstLod;
+    uint32_t NumLods;
+    uint32_t Reserved[3];
+};
+
+// Optional, one per mesh. Meshes without a stream, or with VertexFormat::Float, use the Vertices section.
+struct CookedVertexStream {
+    // Byte range in the PackedVertices section.
+    uint64_t                           Offset;
+    uint64_t                           Size;
+    Geometry::VertexFormat             Format;
+    uint32_t                           Stride;
+    Geometry::VertexQuantizationParams Quantization;
+};
+
+// Nodes come in the order of ModelData::Nodes, so a parent always comes before its children.
+struct CookedNode {
+    // Row major local transform for column vectors, as stored by assimp.
+    float    Transform[16];
+    // Index of the parent node, -1 for the root.
+    int32_t  Parent;
+    // Range into the NodeMeshes section, which holds mesh indices.
+    uint32_t FirstMesh;
+    uint32_t NumMeshes;
+    uint32_t Reserved;
+};
+
+struct CookedTextureRange {
+    // Offset into the TextureData section.
+    uint64_t Offset;
+    uint64_t Size;
+    uint32_t Width;
+    uint32_t Height;
+};
+
+/**
+ * The nodes of a model as they are written to the Nodes section, without their names.
+ */
+std::vector<CookedNode> BuildCookedNodes( const ModelData &model );
+
+/**
+ * Write a model to disk in the cooked binary format.
+ */
+bool WriteCookedModel( const std::string &fileName, const ModelData &model );
+
+/**
+ * A cooked model mapped into memory. All returned pointers point straight into
+ * the mapping and stay valid until the model is closed.
+ */
+class CookedModel {
+public:
+    CookedModel();
+
+    bool Open( const std::string &fileName );
+
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const { return m_Header != nullptr; }
+
+    [[nodiscard]] uint32_t GetNumMeshes() const { return static_cast<uint32_t>(m_NumMeshes); }
+
+    [[nodiscard]] const CookedMeshRange &GetMeshRange( uint32_t mesh ) const { return m_MeshRanges[mesh]; }
+
+    [[nodiscard]] const MeshVertex* GetVertices( const CookedMeshRange &range ) const
+    {
+        return m_Vertices + range.BaseVertex;
+    }
+
+    [[nodiscard]] const uint32_t* GetIndices( const CookedMeshRange &range ) const
+    {
+        return m_Indices + range.FirstIndex;
+    }
+
+    /**
+     * Compact vertex stream of a mesh. Returns nullptr when the mesh only has float vertices.
+     */
+    [[nodiscard]] const CookedVertexStream* GetVertexStream( uint32_t mesh ) const
+    {
+        if (m_VertexStreams == nullptr || m_VertexStreams[mesh].Format == Geometry::VertexFormat::Float)
+        {
+            return nullptr;
+        }
+        return &m_VertexStreams[mesh];
+    }
+
+    [[nodiscard]] const uint8_t* GetPackedVertices( const CookedVertexStream &stream ) const
+    {
+        return m_PackedVertices + stream.Offset;
+    }
+
+    [[nodiscard]] const Geometry::Meshlet* GetMeshlets( const CookedMeshRange &range ) const
+    {
+        return m_Meshlets + range.FirstMeshlet;
+    }
+
+    [[nodiscard]] const Geometry::MeshLod* GetLods( const CookedMeshRange &range ) const
+    {
+        return m_Lods + range.FirstLod;
+    }
+
+    [[nodiscard]] const Geometry::MeshBounds &GetMeshBounds( uint32_t mesh ) const { return m_MeshBounds[mesh]; }
+
+    [[nodiscard]] uint32_t GetNumNodes() const { return static_cast<uint32_t>(m_NumNodes); }
+
+    [[nodiscard]] const CookedNode &GetNode( uint32_t node ) const { return m_Nodes[node]; }
+
+    [[nodiscard]] const uint32_t* GetNodeMeshes( const CookedNode &node ) const
+    {
+        return m_NodeMeshes + node.FirstMesh;
+    }
+
+    [[nodiscard]] uint32_t GetNumMaterials() const { return static_cast<uint32_t>(m_NumMaterials); }
+
+    // Texture indices are validated against GetNumTextures.
+    [[nodiscard]] const MaterialData &GetMaterial( uint32_t material ) const { return m_Materials[material]; }
+
+    [[nodiscard]] uint32_t GetNumTextures() const { return static_cast<uint32_t>(m_NumTextures); }
+
+    [[nodiscard]] const CookedTextureRange &GetTextureRange( uint32_t texture ) const
+    {
+        return m_TextureRanges[texture];
+    }
+
+    [[nodiscard]] const uint8_t* GetTextureData( const CookedTextureRange &range ) const
+    {
+        return m_TextureData + range.Offset;
+    }
+
+    [[nodiscard]] uint32_t GetNumSections() const { return m_Header->NumSections; }
+
+    [[nodiscard]] const CookedSection &GetSection( uint32_t section ) const { return m_Sections[section]; }
+
+    [[nodiscard]] const uint8_t* GetSectionData( const CookedSection &section ) const
+    {
+        return m_File.GetData() + section.Offset;
+    }
+
+    /**
+     * Find a section of the file. Returns nullptr if the section is missing or
+     * its element size does not match.
+     */
+    [[nodiscard]] const void* FindSection( CookedSectionType type, uint32_t elementSize, uint64_t* count ) const;
+
+    template<typename T>
+    const T* FindSection( CookedSectionType type, uint64_t* count ) const
+    {
+        return static_cast<const T *>(FindSection(type, sizeof(T), count));
+    }
+
+private:
+    bool Validate() const;
+
+    MappedFile               m_File;
+    const CookedModelHeader* m_Header;
+    const CookedSection*     m_Sections;
+
+    const CookedMeshRange*      m_MeshRanges;
+    uint64_t                    m_NumMeshes;
+    const CookedNode*           m_Nodes;
+    uint64_t                    m_NumNodes;
+    const uint32_t*             m_NodeMeshes;
+    const MeshVertex*           m_Vertices;
+    const uint32_t*             m_Indices;
+    const CookedTextureRange*   m_TextureRanges;
+    uint64_t                    m_NumTextures;
+    const uint8_t*              m_TextureData;
+    const CookedVertexStream*   m_VertexStreams;
+    const uint8_t*              m_PackedVertices;
+    const Geometry::Meshlet*    m_Meshlets;
+    const Geometry::MeshLod*    m_Lods;
+    const MaterialData*         m_Materials;
+    uint64_t                    m_NumMaterials;
+    const Geometry::MeshBounds* m_MeshBounds;
+};
+
+/**
+ * Write a copy of a cooked model with its textures replaced, copying every other section as is.
+ */
+bool WriteCookedModel( const std::string &fileName, const CookedModel &model, const std::vector<TextureData> &textures );
+
+}
+
+#endif //COOKEDMODEL_H
@@ -0,0 +1,160 @@
+#include "CookedTexture.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace Enterprise::Assets {
+
+namespace {
+
+uint64_t AlignMip( uint64_t offset )
+{
+    return (offset + COOKED_TEXTURE_ALIGNMENT - 1) & ~(COOKED_TEXTURE_ALIGNMENT - 1);
+}
+
+}
+
+void SerializeCookedTexture( const CompressedTexture &texture, std::vector<uint8_t>* data )
+{
+    std::vector<CookedTextureMip> mips(texture.Mips.size());
+    uint64_t                      offset = sizeof(CookedTextureHeader) + sizeof(CookedTextureMip) * mips.size();
+    for (size_t i = 0; i < mips.size(); ++i)
+    {
+        const auto &mip = texture.Mips[i];
+        offset = AlignMip(offset);
+        mips[i].Offset = offset;
+        mips[i].Size = mip.Data.size();
+        mips[i].Width = mip.Width;
+        mips[i].Height = mip.Height;
+        mips[i].RowPitch = static_cast<uint32_t>(Textures::GetRowPitch(texture.Format, mip.Width));
+        mips[i].NumRows = Textures::GetNumRows(texture.Format, mip.Height);
+        offset += mip.Data.size();
+    }
+
+    CookedTextureHeader header{};
+    header.Magic = COOKED_TEXTURE_MAGIC;
+    header.Version = COOKED_TEXTURE_VERSION;
+    header.Format = texture.Format;
+    header.Flags = texture.Srgb ? COOKED_TEXTURE_FLAG_SRGB : COOKED_TEXTURE_FLAG_NONE;
+    header.Width = texture.Mips.empty() ? 0 : texture.Mips[0].Width;
+    header.Height = texture.Mips.empty() ? 0 : texture.Mips[0].Height;
+    header.NumMips = static_cast<uint32_t>(mips.size());
+    header.FileSize = AlignMip(offset);
+
+    data->assign(header.FileSize, 0);
+    std::memcpy(data->data(), &header, sizeof(header));
+    std::memcpy(data->data() + sizeof(header), mips.data(), sizeof(CookedTextureMip) * mips.size());
+    for (size_t i = 0; i < mips.size(); ++i)
+    {
+        std::memcpy(data->data() + mips[i].Offset, texture.Mips[i].Data.data(), texture.Mips[i].Data.size());
+    }
+}
+
+bool WriteCookedTexture( const std::string &fileName, const CompressedTexture &texture )
+{
+    std::vector<uint8_t> data;
+    SerializeCookedTexture(texture, &data);
+
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(file);
+}
+
+bool IsCookedTexture( const uint8_t* data, size_t size )
+{
+    uint32_t magic = 0;
+    if (size < sizeof(CookedTextureHeader))
+    {
+        return false;
+    }
+    std::memcpy(&magic, data, sizeof(magic));
+    return magic == COOKED_TEXTURE_MAGIC;
+}
+
+CookedTexture::CookedTexture()
+    : m_Data(nullptr)
+    , m_Header(nullptr)
+    , m_Mips(nullptr)
+{}
+
+bool CookedTexture::Open( const std::string &fileName )
+{
+    Close();
+
+    if (!m_File.Open(fileName) || !Parse(m_File.GetData(), m_File.GetSize()))
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool CookedTexture::Open( const uint8_t* data, size_t size )
+{
+    Close();
+
+    if (!Parse(data, size))
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void CookedTexture::Close()
+{
+    m_File.Close();
+    m_Data = nullptr;
+    m_Header = nullptr;
+    m_Mips = nullptr;
+}
+
+bool CookedTexture::Parse( const uint8_t* data, size_t size )
+{
+    if (!IsCookedTexture(data, size))
+    {
+        return false;
+    }
+
+    m_Data = data;
+    m_Header = reinterpret_cast<const CookedTextureHeader *>(data);
+    m_Mips = reinterpret_cast<const CookedTextureMip *>(data + sizeof(CookedTextureHeader));
+    return Validate(size);
+}
+
+bool CookedTexture::Validate( size_t size ) const
+{
+    if (m_Header->Version != COOKED_TEXTURE_VERSION || m_Header->FileSize > size ||
+        m_Header->Format >= Textures::TextureFormat::NumFormats || m_Header->NumMips == 0 ||
+        m_Header->NumMips > 32)
+    {
+        return false;
+    }
+
+    uint64_t tableEnd = sizeof(CookedTextureHeader) + sizeof(CookedTextureMip) * uint64_t(m_Header->NumMips);
+    if (tableEnd > m_Header->FileSize)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < m_Header->NumMips; ++i)
+    {
+        const auto &mip = m_Mips[i];
+        if (mip.Offset < tableEnd || mip.Offset % COOKED_TEXTURE_ALIGNMENT != 0 ||
+            mip.Offset > m_Header->FileSize || mip.Size > m_Header->FileSize - mip.Offset ||
+            mip.RowPitch != Textures::GetRowPitch(m_Header->Format, mip.Width) ||
+            mip.NumRows != Textures::GetNumRows(m_Header->Format, mip.Height) ||
+            mip.Size != uint64_t(mip.RowPitch) * mip.NumRows)
+        {
+            return false;
+        }
+    }
+
+    return m_Mips[0].Width == m_Header->Width && m_Mips[0].Height == m_Header->Height;
+}
+
+}
@@ -0,0 +1,125 @@
+#ifndef COOKEDTEXTURE_H
+#define COOKEDTEXTURE_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "../Textures/BlockCompression.h"
+
+
+namespace Enterprise::Assets {
+
+//---------------------------------------------------------------------------------------------|
+// Cooked texture file layout                                                                  |
+//---------------------------------------------------------------------------------------------|
+// CookedTextureHeader                                                                         |
+// CookedTextureMip[NumMips], largest first                                                    |
+// Mip data, each mip starting on a COOKED_TEXTURE_ALIGNMENT boundary                          |
+//---------------------------------------------------------------------------------------------|
+// Mips are stored the way the GPU expects them, rows of blocks with no padding, so they are   |
+// uploaded straight from the mapping. The same bytes are embedded in cooked models.           |
+//---------------------------------------------------------------------------------------------|
+constexpr uint32_t COOKED_TEXTURE_MAGIC = 0x58455445; // "ETEX"
+constexpr uint32_t COOKED_TEXTURE_VERSION = 1;
+constexpr uint64_t COOKED_TEXTURE_ALIGNMENT = 16;
+
+enum CookedTextureFlags : uint32_t {
+    COOKED_TEXTURE_FLAG_NONE = 0,
+    // Color data to be sampled through an sRGB view.
+    COOKED_TEXTURE_FLAG_SRGB = 1 << 0,
+};
+
+struct CookedTextureHeader {
+    uint32_t                Magic;
+    uint32_t                Version;
+    Textures::TextureFormat Format;
+    uint32_t                Flags;
+    uint32_t                Width;
+    uint32_t                Height;
+    uint32_t                NumMips;
+    uint32_t                Reserved;
+    uint64_t                FileSize;
+};
+
+struct CookedTextureMip {
+    // From the start of the file.
+    uint64_t Offset;
+    uint64_t Size;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t RowPitch;
+    uint32_t NumRows;
+};
+
+struct CompressedMip {
+    uint32_t             Width = 0;
+    uint32_t             Height = 0;
+    // Tightly packed rows of blocks, see Textures::GetRowPitch.
+    std::vector<uint8_t> Data;
+};
+
+// A texture ready to be written, mips largest first.
+struct CompressedTexture {
+    Textures::TextureFormat    Format = Textures::TextureFormat::RGBA8;
+    bool                       Srgb = false;
+    std::vector<CompressedMip> Mips;
+};
+
+/**
+ * Lay a texture out in the cooked format in memory, for embedding.
+ */
+void SerializeCookedTexture( const CompressedTexture &texture, std::vector<uint8_t>* data );
+
+bool WriteCookedTexture( const std::string &fileName, const CompressedTexture &texture );
+
+/**
+ * Whether data starts like a cooked texture, to tell them apart from png, jpg, ... in embedded textures.
+ */
+[[nodiscard]] bool IsCookedTexture( const uint8_t* data, size_t size );
+
+/**
+ * A cooked texture, either mapped from a file or viewing memory owned by someone else (a cooked model).
+ * All returned pointers point straight into that memory.
+ */
+class CookedTexture {
+public:
+    CookedTexture();
+
+    bool Open( const std::string &fileName );
+
+    // data must outlive the texture.
+    bool Open( const uint8_t* data, size_t size );
+
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const { return m_Header != nullptr; }
+
+    [[nodiscard]] Textures::TextureFormat GetFormat() const { return m_Header->Format; }
+
+    [[nodiscard]] bool IsSrgb() const { return (m_Header->Flags & COOKED_TEXTURE_FLAG_SRGB) != 0; }
+
+    [[nodiscard]] uint32_t GetWidth() const { return m_Header->Width; }
+
+    [[nodiscard]] uint32_t GetHeight() const { return m_Header->Height; }
+
+    [[nodiscard]] uint32_t GetNumMips() const { return m_Header->NumMips; }
+
+    [[nodiscard]] const CookedTextureMip &GetMip( uint32_t mip ) const { return m_Mips[mip]; }
+
+    [[nodiscard]] const uint8_t* GetMipData( const CookedTextureMip &mip ) const { return m_Data + mip.Offset; }
+
+private:
+    bool Parse( const uint8_t* data, size_t size );
+
+    bool Validate( size_t size ) const;
+
+    MappedFile                 m_File;
+    const uint8_t*             m_Data;
+    const CookedTextureHeader* m_Header;
+    const CookedTextureMip*    m_Mips;
+};
+
+}
+
+#endif //COOKEDTEXTURE_H
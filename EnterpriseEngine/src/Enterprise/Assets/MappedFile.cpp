@@ -0,0 +1,180 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Enterprise::Assets {
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile()
+    : m_Data(nullptr)
+    , m_Size(0)
+    , m_FileHandle(INVALID_HANDLE_VALUE)
+    , m_MappingHandle(nullptr)
+{}
+
+MappedFile::MappedFile( MappedFile &&copy ) noexcept
+    : m_Data(std::exchange(copy.m_Data, nullptr))
+    , m_Size(std::exchange(copy.m_Size, 0))
+    , m_FileHandle(std::exchange(copy.m_FileHandle, INVALID_HANDLE_VALUE))
+    , m_MappingHandle(std::exchange(copy.m_MappingHandle, nullptr))
+{}
+
+MappedFile &MappedFile::operator=( MappedFile &&other ) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+        m_FileHandle = std::exchange(other.m_FileHandle, INVALID_HANDLE_VALUE);
+        m_MappingHandle = std::exchange(other.m_MappingHandle, nullptr);
+    }
+    return *this;
+}
+
+bool MappedFile::Open( const std::string &fileName )
+{
+    Close();
+
+    m_FileHandle = ::CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_FileHandle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!::GetFileSizeEx(m_FileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+
+    m_MappingHandle = ::CreateFileMappingA(m_FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_MappingHandle == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    m_Data = static_cast<const uint8_t *>(::MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (m_Data == nullptr)
+    {
+        Close();
+        return false;
+    }
+    m_Size = static_cast<size_t>(fileSize.QuadPart);
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_Data)
+    {
+        ::UnmapViewOfFile(m_Data);
+        m_Data = nullptr;
+    }
+    if (m_MappingHandle)
+    {
+        ::CloseHandle(m_MappingHandle);
+        m_MappingHandle = nullptr;
+    }
+    if (m_FileHandle != INVALID_HANDLE_VALUE)
+    {
+        ::CloseHandle(m_FileHandle);
+        m_FileHandle = INVALID_HANDLE_VALUE;
+    }
+    m_Size = 0;
+}
+
+#else
+
+MappedFile::MappedFile()
+    : m_Data(nullptr)
+    , m_Size(0)
+    , m_FileDescriptor(-1)
+{}
+
+MappedFile::MappedFile( MappedFile &&copy ) noexcept
+    : m_Data(std::exchange(copy.m_Data, nullptr))
+    , m_Size(std::exchange(copy.m_Size, 0))
+    , m_FileDescriptor(std::exchange(copy.m_FileDescriptor, -1))
+{}
+
+MappedFile &MappedFile::operator=( MappedFile &&other ) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+        m_FileDescriptor = std::exchange(other.m_FileDescriptor, -1);
+    }
+    return *this;
+}
+
+bool MappedFile::Open( const std::string &fileName )
+{
+    Close();
+
+    m_FileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+    if (m_FileDescriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat{};
+    if (::fstat(m_FileDescriptor, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        Close();
+        return false;
+    }
+
+    void* data = ::mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    m_Data = static_cast<const uint8_t *>(data);
+    m_Size = static_cast<size_t>(fileStat.st_size);
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_Data)
+    {
+        ::munmap(const_cast<uint8_t *>(m_Data), m_Size);
+        m_Data = nullptr;
+    }
+    if (m_FileDescriptor >= 0)
+    {
+        ::close(m_FileDescriptor);
+        m_FileDescriptor = -1;
+    }
+    m_Size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+}
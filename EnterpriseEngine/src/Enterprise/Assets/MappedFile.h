@@ -0,0 +1,48 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace Enterprise::Assets {
+
+/**
+ * Read only memory mapping of a whole file.
+ * The mapping stays valid until the MappedFile is closed or destroyed.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile( const MappedFile &copy ) = delete;
+    MappedFile &operator=( const MappedFile &other ) = delete;
+
+    MappedFile( MappedFile &&copy ) noexcept;
+    MappedFile &operator=( MappedFile &&other ) noexcept;
+
+    bool Open( const std::string &fileName );
+
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const { return m_Data != nullptr; }
+
+    [[nodiscard]] const uint8_t* GetData() const { return m_Data; }
+
+    [[nodiscard]] size_t GetSize() const { return m_Size; }
+
+private:
+    const uint8_t* m_Data;
+    size_t         m_Size;
+#if defined(_WIN32)
+    void*          m_FileHandle;
+    void*          m_MappingHandle;
+#else
+    int            m_FileDescriptor;
+#endif
+};
+
+}
+
+#endif //MAPPEDFILE_H
@@ -0,0 +1,107 @@
+#ifndef MODELDATA_H
+#define MODELDATA_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../Geometry/Bounds.h"
+#include "../Geometry/Meshlets.h"
+#include "../Geometry/Simplifier.h"
+#include "../Geometry/VertexQuantization.h"
+
+
+namespace Enterprise::Assets {
+
+// CPU side vertex. Matches the layout of Graphics::VertexPosNormalTexture so vertex
+// streams can be handed to the GPU upload without any conversion.
+struct MeshVertex {
+    float Position[3];
+    float Normal[3];
+    float TexCoord[2];
+};
+static_assert(sizeof(MeshVertex) == 32, "MeshVertex must match VertexPosNormalTexture");
+
+struct MeshData {
+    std::vector<MeshVertex> Vertices;
+    std::vector<uint32_t>   Indices;
+    uint32_t                MaterialIndex = 0;
+    // Points and lines are left as they are by the optimizer.
+    bool                    IsTriangleList = true;
+    // In the mesh's local space, for culling the whole mesh.
+    Geometry::MeshBounds    Bounds{};
+
+    // GPU vertex stream in VertexFormat. Empty for VertexFormat::Float, which uploads Vertices as is.
+    Geometry::VertexFormat             VertexFormat = Geometry::VertexFormat::Float;
+    std::vector<uint8_t>               PackedVertices;
+    Geometry::VertexQuantizationParams Quantization;
+
+    // Clusters of the first level of detail for culling finer than the whole mesh. Empty for point and line meshes.
+    std::vector<Geometry::Meshlet> Meshlets;
+
+    // Levels of detail as ranges of Indices, from full detail down. Empty when the mesh has a single level.
+    std::vector<Geometry::MeshLod> Lods;
+};
+
+// Nodes are stored flattened in depth first order so a parent always comes before its children.
+struct NodeData {
+    std::string Name;
+    // Row major local transform, as stored by assimp.
+    float       Transform[16];
+    int32_t     Parent = -1;
+    // Range into ModelData::NodeMeshes.
+    uint32_t    FirstMesh = 0;
+    uint32_t    NumMeshes = 0;
+};
+
+enum class MaterialAlphaMode : uint32_t {
+    Opaque,
+    // Pixels below AlphaCutoff are discarded.
+    Mask,
+    Blend,
+};
+
+// Index into ModelData::Textures of a material without that texture.
+constexpr uint32_t NO_MATERIAL_TEXTURE = UINT32_MAX;
+
+// Plain data, so materials are cooked and read back as is.
+struct MaterialData {
+    float             BaseColor[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    float             Emissive[3] = {0.0f, 0.0f, 0.0f};
+    float             Metallic = 0.0f;
+    float             Roughness = 1.0f;
+    float             AlphaCutoff = 0.5f;
+    // Indices into ModelData::Textures, or NO_MATERIAL_TEXTURE.
+    uint32_t          BaseColorTexture = NO_MATERIAL_TEXTURE;
+    uint32_t          NormalTexture = NO_MATERIAL_TEXTURE;
+    uint32_t          MetallicRoughnessTexture = NO_MATERIAL_TEXTURE;
+    uint32_t          EmissiveTexture = NO_MATERIAL_TEXTURE;
+    MaterialAlphaMode AlphaMode = MaterialAlphaMode::Opaque;
+    uint32_t          DoubleSided = 0;
+};
+
+// Whether meshes with the material hide everything behind them, which alpha tested and blended ones do not.
+[[nodiscard]] inline bool IsOpaque( const MaterialData &material )
+{
+    return material.AlphaMode == MaterialAlphaMode::Opaque;
+}
+
+struct TextureData {
+    // Compressed image bytes (png, jpg, ...) or a cooked texture (see CookedTexture.h) when Height is 0,
+    // raw BGRA8 texels otherwise.
+    std::vector<uint8_t> Data;
+    uint32_t             Width = 0;
+    uint32_t             Height = 0;
+};
+
+struct ModelData {
+    std::vector<MeshData>     Meshes;
+    std::vector<NodeData>     Nodes;
+    std::vector<uint32_t>     NodeMeshes;
+    // MeshData::MaterialIndex indexes these.
+    std::vector<MaterialData> Materials;
+    std::vector<TextureData>  Textures;
+};
+
+}
+
+#endif //MODELDATA_H
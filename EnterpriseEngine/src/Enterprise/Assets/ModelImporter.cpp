@@ -0,0 +1,466 @@
+#include "ModelImporter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "assimp/GltfMaterial.h"
+#include "assimp/Importer.hpp"
+#include "assimp/postprocess.h"
+#include "assimp/scene.h"
+#include "../Core/ThreadPool.h"
+
+namespace Enterprise::Assets {
+
+// Vertex ranges larger than this are split over several tasks.
+constexpr uint32_t VERTEX_TASK_SIZE = 16 * 1024;
+
+void ProcessVertices( const aiMesh* _mesh, uint32_t firstVertex, uint32_t lastVertex, MeshVertex* vertexArray )
+{
+    const aiVector3D* texCoords = _mesh->mTextureCoords[0];
+    const aiVector3D* normals = _mesh->HasNormals() ? _mesh->mNormals : nullptr;
+    for ( auto x = firstVertex; x < lastVertex; ++x )
+    {
+        auto  vertex = _mesh->mVertices + x;
+        auto &vertPosNormTex = vertexArray[x];
+        vertPosNormTex.Position[0] = vertex->x;
+        vertPosNormTex.Position[1] = vertex->y;
+        vertPosNormTex.Position[2] = vertex->z;
+        vertPosNormTex.Normal[0] = normals ? normals[x].x : 0.0f;
+        vertPosNormTex.Normal[1] = normals ? normals[x].y : 0.0f;
+        vertPosNormTex.Normal[2] = normals ? normals[x].z : 0.0f;
+        vertPosNormTex.TexCoord[0] = texCoords ? texCoords[x].x : 0.0f;
+        vertPosNormTex.TexCoord[1] = texCoords ? texCoords[x].y : 0.0f;
+    }
+}
+
+void ProcessIndicies( const aiMesh* _mesh, std::vector<uint32_t>* indexArray )
+{
+    size_t numIndices = 0;
+    for ( auto x = 0u; x < _mesh->mNumFaces; ++x )
+    {
+        numIndices += _mesh->mFaces[x].mNumIndices;
+    }
+    indexArray->resize(numIndices);
+
+    uint32_t* index = indexArray->data();
+    for ( auto x = 0u; x < _mesh->mNumFaces; ++x )
+    {
+        const auto &face = _mesh->mFaces[x];
+        for ( auto j = 0u; j < face.mNumIndices; ++j )
+        {
+            *index++ = face.mIndices[j];
+        }
+    }
+}
+
+void ProcessMeshes( const aiScene* scene, ModelData* model )
+{
+    // One task per mesh for the indices and one per vertex range for the vertices.
+    // Every task writes to its own preallocated slice, so the result does not depend on scheduling.
+    struct MeshTask {
+        uint32_t Mesh;
+        uint32_t FirstVertex;
+        uint32_t LastVertex;
+        bool     Indices;
+    };
+    std::vector<MeshTask> tasks;
+
+    model->Meshes.resize(scene->mNumMeshes);
+    for ( auto i = 0u; i < scene->mNumMeshes; ++i )
+    {
+        auto  _mesh = scene->mMeshes[i];
+        auto &meshData = model->Meshes[i];
+        meshData.Vertices.resize(_mesh->mNumVertices);
+        meshData.MaterialIndex = _mesh->mMaterialIndex;
+        meshData.IsTriangleList = _mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE;
+
+        tasks.push_back({i, 0, 0, true});
+        for ( auto first = 0u; first < _mesh->mNumVertices; first += VERTEX_TASK_SIZE )
+        {
+            tasks.push_back({i, first, std::min(_mesh->mNumVertices, first + VERTEX_TASK_SIZE), false});
+        }
+    }
+
+    Core::Threads::ThreadPool::Get().ParallelFor(tasks.size(), 1, [&]( size_t begin, size_t end )
+    {
+        for ( size_t t = begin; t < end; ++t )
+        {
+            const auto &task = tasks[t];
+            auto        _mesh = scene->mMeshes[task.Mesh];
+            auto &      meshData = model->Meshes[task.Mesh];
+            if (task.Indices)
+            {
+                ProcessIndicies(_mesh, &meshData.Indices);
+            } else
+            {
+                ProcessVertices(_mesh, task.FirstVertex, task.LastVertex, meshData.Vertices.data());
+            }
+        }
+    });
+}
+
+void OptimizeMesh( MeshData* meshData, const ModelImportSettings &settings )
+{
+    auto &indices = meshData->Indices;
+    auto &vertices = meshData->Vertices;
+
+    Geometry::OptimizeVertexCache(indices.data(), indices.data(), indices.size(), vertices.size());
+    if (settings.OptimizeOverdraw)
+    {
+        std::vector<uint32_t> clusteredIndices(indices.size());
+        Geometry::OptimizeOverdraw(clusteredIndices.data(), indices.data(), indices.size(),
+                                   vertices.data()->Position, vertices.size(), sizeof(MeshVertex),
+                                   settings.OverdrawThreshold);
+        indices.swap(clusteredIndices);
+    }
+
+    std::vector<MeshVertex> fetchOrderedVertices(vertices.size());
+    size_t                  numVertices = Geometry::OptimizeVertexFetch(fetchOrderedVertices.data(), indices.data(),
+                                                                        indices.size(), vertices.data(),
+                                                                        vertices.size(), sizeof(MeshVertex));
+    fetchOrderedVertices.resize(numVertices);
+    vertices.swap(fetchOrderedVertices);
+}
+
+// Append coarser levels of detail to the index buffer, each simplified from the previous one.
+void GenerateLods( MeshData* meshData, const ModelImportSettings &settings )
+{
+    auto &indices = meshData->Indices;
+    auto &lods = meshData->Lods;
+    lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.0f, 0});
+
+    const float* positions = meshData->Vertices.data()->Position;
+    const float  scale = Geometry::GetMeshScale(positions, meshData->Vertices.size(), sizeof(MeshVertex));
+    while (lods.size() < settings.NumLods)
+    {
+        const auto &previous = lods.back();
+        size_t      targetIndexCount = size_t(float(previous.NumIndices / 3) * settings.LodReduction) * 3;
+
+        std::vector<uint32_t> lodIndices(indices.begin() + previous.FirstIndex,
+                                         indices.begin() + previous.FirstIndex + previous.NumIndices);
+        float  error = 0.0f;
+        size_t numIndices = Geometry::SimplifyMesh(lodIndices.data(), lodIndices.data(), lodIndices.size(),
+                                                   positions, meshData->Vertices.size(), sizeof(MeshVertex),
+                                                   targetIndexCount, settings.LodMaxError, &error);
+
+        // A level that keeps most of the triangles costs memory without saving much.
+        if (numIndices == 0 || numIndices > previous.NumIndices * 9 / 10)
+        {
+            break;
+        }
+
+        Geometry::OptimizeVertexCache(lodIndices.data(), lodIndices.data(), numIndices, meshData->Vertices.size());
+
+        Geometry::MeshLod lod{};
+        lod.FirstIndex = static_cast<uint32_t>(indices.size());
+        lod.NumIndices = static_cast<uint32_t>(numIndices);
+        lod.Error = std::max(error * scale, previous.Error);
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.begin() + numIndices);
+        lods.push_back(lod);
+    }
+
+    if (lods.size() == 1)
+    {
+        lods.clear();
+    }
+}
+
+void OptimizeMeshes( ModelData* model, const ModelImportSettings &settings, ModelImportStatistics* statistics )
+{
+    std::vector<ModelImportStatistics> meshStatistics(model->Meshes.size());
+
+    Core::Threads::ThreadPool::Get().ParallelFor(model->Meshes.size(), 1, [&]( size_t begin, size_t end )
+    {
+        for ( size_t i = begin; i < end; ++i )
+        {
+            // Points and lines are sorted into their own meshes and are left untouched.
+            auto &meshData = model->Meshes[i];
+            if (!meshData.IsTriangleList || meshData.Indices.empty())
+            {
+                continue;
+            }
+
+            if (statistics)
+            {
+                meshStatistics[i].Before = Geometry::AnalyzeVertexCache(meshData.Indices.data(),
+                                                                        meshData.Indices.size(),
+                                                                        meshData.Vertices.size());
+            }
+            if (settings.OptimizeMeshes)
+            {
+                OptimizeMesh(&meshData, settings);
+            }
+            if (settings.BuildMeshlets)
+            {
+                std::vector<uint32_t> meshletIndices(meshData.Indices.size());
+                meshData.Meshlets = Geometry::BuildMeshlets(meshletIndices.data(), meshData.Indices.data(),
+                                                            meshData.Indices.size(),
+                                                            meshData.Vertices.data()->Position,
+                                                            meshData.Vertices.size(), sizeof(MeshVertex),
+                                                            settings.MeshletMaxVertices,
+                                                            settings.MeshletMaxTriangles);
+                meshData.Indices.swap(meshletIndices);
+            }
+            if (statistics)
+            {
+                meshStatistics[i].After = Geometry::AnalyzeVertexCache(meshData.Indices.data(),
+                                                                       meshData.Indices.size(),
+                                                                       meshData.Vertices.size());
+            }
+            if (settings.NumLods > 1)
+            {
+                GenerateLods(&meshData, settings);
+            }
+        }
+    });
+
+    if (statistics)
+    {
+        for (const auto &mesh: meshStatistics)
+        {
+            statistics->Before += mesh.Before;
+            statistics->After += mesh.After;
+        }
+    }
+}
+
+// Encode the mesh in the most compact format, starting at settings.VertexFormat, that stays within the error tolerances.
+void EncodeMeshVertices( MeshData* meshData, const ModelImportSettings &settings, Geometry::VertexQuantizationError* error )
+{
+    const auto &vertices = meshData->Vertices;
+
+    Geometry::VertexStreamDesc source;
+    source.Positions = vertices.data()->Position;
+    source.Normals = vertices.data()->Normal;
+    source.TexCoords = vertices.data()->TexCoord;
+    source.Stride = sizeof(MeshVertex);
+    source.NumVertices = vertices.size();
+
+    auto params = Geometry::ComputeQuantizationParams(source.Positions, source.Stride, source.NumVertices);
+    for (auto format = static_cast<uint32_t>(settings.VertexFormat); format > 0; --format)
+    {
+        auto                 vertexFormat = static_cast<Geometry::VertexFormat>(format);
+        std::vector<uint8_t> encoded(Geometry::GetVertexFormatStride(vertexFormat) * vertices.size());
+        Geometry::EncodeVertices(vertexFormat, encoded.data(), source, params);
+
+        auto formatError = Geometry::MeasureQuantizationError(vertexFormat, encoded.data(), source, params);
+        if (formatError.MaxPositionError <= settings.MaxPositionError &&
+            formatError.MaxNormalError <= settings.MaxNormalError &&
+            formatError.MaxTexCoordError <= settings.MaxTexCoordError)
+        {
+            meshData->VertexFormat = vertexFormat;
+            meshData->PackedVertices = std::move(encoded);
+            meshData->Quantization = vertexFormat == Geometry::VertexFormat::Quantized
+                                         ? params
+                                         : Geometry::VertexQuantizationParams{};
+            *error = formatError;
+            return;
+        }
+    }
+
+    meshData->VertexFormat = Geometry::VertexFormat::Float;
+}
+
+void EncodeMeshes( ModelData* model, const ModelImportSettings &settings, ModelImportStatistics* statistics )
+{
+    std::vector<Geometry::VertexQuantizationError> meshErrors(model->Meshes.size());
+
+    Core::Threads::ThreadPool::Get().ParallelFor(model->Meshes.size(), 1, [&]( size_t begin, size_t end )
+    {
+        for ( size_t i = begin; i < end; ++i )
+        {
+            if (!model->Meshes[i].Vertices.empty())
+            {
+                EncodeMeshVertices(&model->Meshes[i], settings, &meshErrors[i]);
+            }
+        }
+    });
+
+    if (statistics)
+    {
+        for ( size_t i = 0; i < model->Meshes.size(); ++i )
+        {
+            const auto &meshData = model->Meshes[i];
+            statistics->FloatVertexBytes += meshData.Vertices.size() * sizeof(MeshVertex);
+            statistics->PackedVertexBytes += meshData.VertexFormat == Geometry::VertexFormat::Float
+                                                 ? meshData.Vertices.size() * sizeof(MeshVertex)
+                                                 : meshData.PackedVertices.size();
+            statistics->MeshesPerFormat[static_cast<size_t>(meshData.VertexFormat)]++;
+            statistics->QuantizationError.Merge(meshErrors[i]);
+        }
+    }
+}
+
+void ProcessNode( const aiNode* node, int32_t parent, ModelData* model )
+{
+    auto nodeIndex = static_cast<int32_t>(model->Nodes.size());
+
+    NodeData nodeData;
+    nodeData.Name = node->mName.C_Str();
+    std::memcpy(nodeData.Transform, &node->mTransformation, sizeof(nodeData.Transform));
+    nodeData.Parent = parent;
+    nodeData.FirstMesh = static_cast<uint32_t>(model->NodeMeshes.size());
+    nodeData.NumMeshes = node->mNumMeshes;
+    model->Nodes.push_back(std::move(nodeData));
+
+    for ( auto i = 0u; i < node->mNumMeshes; ++i )
+    {
+        model->NodeMeshes.push_back(node->mMeshes[i]);
+    }
+    for ( auto x = 0u; x < node->mNumChildren; x++ )
+    {
+        ProcessNode(node->mChildren[x], nodeIndex, model);
+    }
+}
+
+void ProcessEmbeddedTextures( const aiScene* scene, ModelData* model )
+{
+    model->Textures.resize(scene->mNumTextures);
+    for ( auto i = 0u; i < scene->mNumTextures; ++i )
+    {
+        auto  aiTex = scene->mTextures[i];
+        auto &texture = model->Textures[i];
+        // mHeight == 0 means pcData holds a compressed image of mWidth bytes.
+        size_t size = aiTex->mHeight == 0 ? aiTex->mWidth : aiTex->mWidth * aiTex->mHeight * sizeof(aiTexel);
+        auto   data = reinterpret_cast<const uint8_t *>(aiTex->pcData);
+        texture.Data.assign(data, data + size);
+        texture.Width = aiTex->mWidth;
+        texture.Height = aiTex->mHeight;
+    }
+}
+
+// Index into ModelData::Textures of the first texture of type, or NO_MATERIAL_TEXTURE if it is not embedded.
+uint32_t GetMaterialTexture( const aiScene* scene, const aiMaterial* material, aiTextureType type )
+{
+    aiString path;
+    if (material->GetTexture(type, 0, &path) != aiReturn_SUCCESS)
+    {
+        return NO_MATERIAL_TEXTURE;
+    }
+
+    int index = scene->GetEmbeddedTextureAndIndex(path.C_Str()).second;
+    return index < 0 ? NO_MATERIAL_TEXTURE : static_cast<uint32_t>(index);
+}
+
+void ProcessMaterials( const aiScene* scene, ModelData* model )
+{
+    model->Materials.resize(scene->mNumMaterials);
+    for ( auto i = 0u; i < scene->mNumMaterials; ++i )
+    {
+        const aiMaterial* _material = scene->mMaterials[i];
+        auto &            material = model->Materials[i];
+
+        // PBR factors first, the classic diffuse and opacity for formats that only have those.
+        aiColor4D baseColor;
+        if (_material->Get(AI_MATKEY_BASE_COLOR, baseColor) == aiReturn_SUCCESS ||
+            _material->Get(AI_MATKEY_COLOR_DIFFUSE, baseColor) == aiReturn_SUCCESS)
+        {
+            material.BaseColor[0] = baseColor.r;
+            material.BaseColor[1] = baseColor.g;
+            material.BaseColor[2] = baseColor.b;
+            material.BaseColor[3] = baseColor.a;
+        }
+        float opacity = 1.0f;
+        if (_material->Get(AI_MATKEY_OPACITY, opacity) == aiReturn_SUCCESS && opacity < 1.0f)
+        {
+            material.BaseColor[3] *= opacity;
+            material.AlphaMode = MaterialAlphaMode::Blend;
+        }
+        aiColor3D emissive;
+        if (_material->Get(AI_MATKEY_COLOR_EMISSIVE, emissive) == aiReturn_SUCCESS)
+        {
+            material.Emissive[0] = emissive.r;
+            material.Emissive[1] = emissive.g;
+            material.Emissive[2] = emissive.b;
+        }
+        _material->Get(AI_MATKEY_METALLIC_FACTOR, material.Metallic);
+        _material->Get(AI_MATKEY_ROUGHNESS_FACTOR, material.Roughness);
+
+        aiString alphaMode;
+        if (_material->Get(AI_MATKEY_GLTF_ALPHAMODE, alphaMode) == aiReturn_SUCCESS)
+        {
+            material.AlphaMode = std::strcmp(alphaMode.C_Str(), "MASK") == 0    ? MaterialAlphaMode::Mask
+                                 : std::strcmp(alphaMode.C_Str(), "BLEND") == 0 ? MaterialAlphaMode::Blend
+                                                                                 : MaterialAlphaMode::Opaque;
+        }
+        _material->Get(AI_MATKEY_GLTF_ALPHACUTOFF, material.AlphaCutoff);
+        int twoSided = 0;
+        if (_material->Get(AI_MATKEY_TWOSIDED, twoSided) == aiReturn_SUCCESS)
+        {
+            material.DoubleSided = twoSided != 0;
+        }
+
+        material.BaseColorTexture = GetMaterialTexture(scene, _material, aiTextureType_BASE_COLOR);
+        if (material.BaseColorTexture == NO_MATERIAL_TEXTURE)
+        {
+            material.BaseColorTexture = GetMaterialTexture(scene, _material, aiTextureType_DIFFUSE);
+        }
+        material.NormalTexture = GetMaterialTexture(scene, _material, aiTextureType_NORMALS);
+        material.MetallicRoughnessTexture = GetMaterialTexture(scene, _material, aiTextureType_METALNESS);
+        material.EmissiveTexture = GetMaterialTexture(scene, _material, aiTextureType_EMISSIVE);
+    }
+}
+
+bool ReadModelData( const std::string &pFile, ModelData* model )
+{
+    Assimp::Importer importer;
+    const aiScene*   scene = importer.ReadFile(pFile,
+                                               aiProcess_ConvertToLeftHanded |
+                                               aiProcessPreset_TargetRealtime_Quality);
+    if (scene == nullptr || scene->mRootNode == nullptr)
+    {
+        return false;
+    }
+
+    ProcessMeshes(scene, model);
+    ProcessNode(scene->mRootNode, -1, model);
+    ProcessMaterials(scene, model);
+    ProcessEmbeddedTextures(scene, model);
+
+    return true;
+}
+
+// Bounds of the vertices left after optimization, which drops the ones no index refers to.
+void ComputeBounds( ModelData* model )
+{
+    Core::Threads::ThreadPool::Get().ParallelFor(model->Meshes.size(), 1, [&]( size_t begin, size_t end )
+    {
+        for ( size_t i = begin; i < end; ++i )
+        {
+            auto &meshData = model->Meshes[i];
+            if (meshData.Vertices.empty())
+            {
+                continue;
+            }
+            meshData.Bounds = Geometry::ComputeMeshBounds(meshData.Vertices.data()->Position,
+                                                          meshData.Vertices.size(), sizeof(MeshVertex));
+        }
+    });
+}
+
+void ProcessModelData( ModelData* model, const ModelImportSettings &settings, ModelImportStatistics* statistics )
+{
+    OptimizeMeshes(model, settings, statistics);
+    ComputeBounds(model);
+    EncodeMeshes(model, settings, statistics);
+}
+
+bool ImportModelData( const std::string &pFile, ModelData* model, const ModelImportSettings &settings,
+                      ModelImportStatistics* statistics )
+{
+    if (!ReadModelData(pFile, model))
+    {
+        return false;
+    }
+
+    ProcessModelData(model, settings, statistics);
+    return true;
+}
+
+bool IsModelFile( const std::string &pFile )
+{
+    auto extension = pFile.rfind('.');
+    return extension != std::string::npos && Assimp::Importer().IsExtensionSupported(pFile.substr(extension));
+}
+
+}
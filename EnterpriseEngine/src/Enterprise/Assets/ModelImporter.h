@@ -0,0 +1,74 @@
+#ifndef MODELIMPORTER_H
+#define MODELIMPORTER_H
+#include <string>
+
+#include "ModelData.h"
+#include "../Geometry/MeshOptimizer.h"
+
+
+namespace Enterprise::Assets {
+
+struct ModelImportSettings {
+    // Reorder triangles for the post-transform cache and vertices for fetch locality.
+    bool  OptimizeMeshes = true;
+    // Reorder triangle clusters front to back after the cache pass, see Geometry::OptimizeOverdraw.
+    bool  OptimizeOverdraw = true;
+    float OverdrawThreshold = 1.05f;
+
+    // Split triangle meshes into meshlets, reordering the indices so each meshlet is a contiguous range.
+    bool     BuildMeshlets = true;
+    uint32_t MeshletMaxVertices = Geometry::MESHLET_MAX_VERTICES;
+    uint32_t MeshletMaxTriangles = Geometry::MESHLET_MAX_TRIANGLES;
+
+    // Levels of detail generated per triangle mesh, including the full detail one. Each level aims for
+    // LodReduction times the triangles of the previous one, and stops short of LodMaxError, which is
+    // relative to the mesh size. Levels that save too little are dropped.
+    uint32_t NumLods = 4;
+    float    LodReduction = 0.5f;
+    float    LodMaxError = 0.02f;
+
+    // Most compact vertex format to try. Each mesh falls back to a wider format when the
+    // encoding error of a narrower one exceeds the tolerances below.
+    Geometry::VertexFormat VertexFormat = Geometry::VertexFormat::Quantized;
+    // In model units.
+    float                  MaxPositionError = 1e-3f;
+    // In degrees.
+    float                  MaxNormalError = 0.1f;
+    // Half a texel of a 1024 texture.
+    float                  MaxTexCoordError = 1.0f / 2048.0f;
+};
+
+struct ModelImportStatistics {
+    // Vertex cache statistics summed over every triangle mesh, before and after optimization.
+    Geometry::VertexCacheStatistics Before;
+    Geometry::VertexCacheStatistics After;
+
+    // Vertex stream sizes with float vertices and with the chosen formats.
+    uint64_t                         FloatVertexBytes = 0;
+    uint64_t                         PackedVertexBytes = 0;
+    uint32_t                         MeshesPerFormat[size_t(Geometry::VertexFormat::NumFormats)] = {};
+    Geometry::VertexQuantizationError QuantizationError;
+};
+
+/**
+ * Import a model through assimp and convert it to the engine's CPU side representation.
+ * Does not touch the GPU, so it can be used by the runtime as well as the offline cooker.
+ */
+bool ImportModelData( const std::string &pFile, ModelData* model, const ModelImportSettings &settings = {},
+                      ModelImportStatistics* statistics = nullptr );
+
+/**
+ * The two halves of ImportModelData. ReadModelData only converts what assimp loaded, so the cooker can hash
+ * the meshes before paying for ProcessModelData, which optimizes and encodes them.
+ */
+bool ReadModelData( const std::string &pFile, ModelData* model );
+
+void ProcessModelData( ModelData* model, const ModelImportSettings &settings = {},
+                       ModelImportStatistics* statistics = nullptr );
+
+// Whether assimp can import files with the extension of pFile.
+[[nodiscard]] bool IsModelFile( const std::string &pFile );
+
+}
+
+#endif //MODELIMPORTER_H
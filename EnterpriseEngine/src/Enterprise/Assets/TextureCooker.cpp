@@ -0,0 +1,335 @@
+#include "TextureCooker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "../Core/ThreadPool.h"
+
+namespace Enterprise::Assets {
+
+namespace {
+
+// Blocks per tile. Small enough to balance a handful of textures over every thread,
+// large enough that scheduling a tile costs nothing next to compressing it.
+constexpr size_t TILE_BLOCKS = 1024;
+
+struct CompressionTile {
+    Textures::TextureFormat Format;
+    const uint8_t*          Pixels;
+    uint32_t                Width;
+    uint32_t                Height;
+    uint32_t                FirstRow;
+    uint32_t                NumRows;
+    CompressedMip*          Mip;
+};
+
+// Channels a format stores, which are the ones its error is measured over.
+uint32_t GetNumStoredChannels( Textures::TextureFormat format )
+{
+    switch (format)
+    {
+        case Textures::TextureFormat::BC1:
+            return 3;
+        case Textures::TextureFormat::BC4:
+            return 1;
+        case Textures::TextureFormat::BC5:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+}
+
+double TextureCookStatistics::GetMegatexelsPerSecond() const
+{
+    return EncodeSeconds > 0.0 ? double(NumTexels) / EncodeSeconds * 1e-6 : 0.0;
+}
+
+double TextureCookStatistics::GetPSNR() const
+{
+    if (NumSamples == 0)
+    {
+        return 0.0;
+    }
+    double meanSquaredError = std::max(SquaredError / double(NumSamples), 1e-10);
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
+
+void CompressTextures( const DecodedImage* images, size_t count, const TextureCookSettings &settings,
+                       CompressedTexture*  textures, TextureCookStatistics* statistics )
+{
+    auto &threadPool = Core::Threads::ThreadPool::Get();
+
+    // Mip chains are built per image, each one splitting its larger mips over the pool itself.
+    std::vector<std::vector<Textures::MipLevel> > mipLevels(count);
+    threadPool.ParallelFor(count, 1, [&]( size_t begin, size_t end )
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto &texture = textures[i];
+            texture = CompressedTexture();
+            texture.Srgb = settings.Srgb;
+            if (!images[i].IsValid())
+            {
+                continue;
+            }
+
+            uint32_t width = images[i].Width;
+            uint32_t height = images[i].Height;
+            // The GPU only takes block compressed textures whose top level is a whole number of blocks.
+            bool wholeBlocks = width % 4 == 0 && height % 4 == 0;
+            texture.Format = wholeBlocks ? settings.Format : Textures::TextureFormat::RGBA8;
+            texture.Mips.push_back({width, height,
+                                    std::vector<uint8_t>(Textures::GetSurfaceSize(texture.Format, width, height))});
+
+            if (settings.GenerateMips)
+            {
+                Textures::GenerateMipChain(images[i].Pixels.GetData(), width, height, images[i].GetRowPitch(),
+                                           {settings.MipFilter, settings.Srgb}, &mipLevels[i]);
+            }
+            for (const auto &level: mipLevels[i])
+            {
+                texture.Mips.push_back({level.Width, level.Height,
+                                        std::vector<uint8_t>(
+                                            Textures::GetSurfaceSize(texture.Format, level.Width, level.Height))});
+            }
+        }
+    });
+
+    std::vector<CompressionTile> tiles;
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto &texture = textures[i];
+        for (size_t mipIndex = 0; mipIndex < texture.Mips.size(); ++mipIndex)
+        {
+            auto &         mip = texture.Mips[mipIndex];
+            const uint8_t* pixels = mipIndex == 0 ? images[i].Pixels.GetData() : mipLevels[i][mipIndex - 1].Pixels.data();
+            uint32_t       numRows = Textures::GetNumRows(texture.Format, mip.Height);
+            size_t         numColumns = std::max<size_t>(Textures::GetRowPitch(texture.Format, mip.Width) /
+                                                         Textures::GetBlockBytes(texture.Format), 1);
+            auto           rowsPerTile = static_cast<uint32_t>(std::max<size_t>(TILE_BLOCKS / numColumns, 1));
+            for (uint32_t row = 0; row < numRows; row += rowsPerTile)
+            {
+                tiles.push_back({texture.Format, pixels, mip.Width, mip.Height, row,
+                                 std::min(rowsPerTile, numRows - row), &mip});
+            }
+        }
+    }
+
+    auto encodeStart = std::chrono::steady_clock::now();
+    threadPool.ParallelFor(tiles.size(), 1, [&]( size_t begin, size_t end )
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            // Tiles of the same mip share a destination, but not any rows of it.
+            const auto &tile = tiles[i];
+            uint8_t*    destination = tile.Mip->Data.data() +
+                                      Textures::GetRowPitch(tile.Format, tile.Width) * tile.FirstRow;
+            Textures::CompressSurface(tile.Format, settings.Quality, tile.Pixels, tile.Width, tile.Height,
+                                      size_t(tile.Width) * 4, tile.FirstRow, tile.NumRows, destination);
+        }
+    });
+    auto encodeEnd = std::chrono::steady_clock::now();
+
+    if (statistics == nullptr)
+    {
+        return;
+    }
+
+    statistics->EncodeSeconds += std::chrono::duration<double>(encodeEnd - encodeStart).count();
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (textures[i].Mips.empty())
+        {
+            continue;
+        }
+        statistics->NumTextures += 1;
+        statistics->NumUncompressed += textures[i].Format != settings.Format ? 1 : 0;
+        for (const auto &mip: textures[i].Mips)
+        {
+            statistics->NumTexels += uint64_t(mip.Width) * mip.Height;
+        }
+    }
+
+    // Decode the top levels again to see what the compression cost.
+    std::vector<double>   squaredErrors(count, 0.0);
+    std::vector<uint64_t> numSamples(count, 0);
+    threadPool.ParallelFor(count, 1, [&]( size_t begin, size_t end )
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const auto &texture = textures[i];
+            if (texture.Mips.empty())
+            {
+                continue;
+            }
+
+            const auto &         mip = texture.Mips[0];
+            std::vector<uint8_t> decoded(size_t(mip.Width) * mip.Height * 4);
+            Textures::DecompressSurface(texture.Format, mip.Data.data(), mip.Width, mip.Height, decoded.data());
+
+            const uint8_t* source = images[i].Pixels.GetData();
+            uint32_t       numChannels = GetNumStoredChannels(texture.Format);
+            for (size_t texel = 0; texel < size_t(mip.Width) * mip.Height; ++texel)
+            {
+                for (uint32_t c = 0; c < numChannels; ++c)
+                {
+                    double difference = double(decoded[texel * 4 + c]) - double(source[texel * 4 + c]);
+                    squaredErrors[i] += difference * difference;
+                }
+            }
+            numSamples[i] = uint64_t(mip.Width) * mip.Height * numChannels;
+        }
+    });
+    for (size_t i = 0; i < count; ++i)
+    {
+        statistics->SquaredError += squaredErrors[i];
+        statistics->NumSamples += numSamples[i];
+    }
+}
+
+bool CookTexture( const std::string &sourceFile, const std::string &cookedFile, const TextureCookSettings &settings,
+                  TextureCookStatistics* statistics )
+{
+    DecodedImage image;
+    if (!DecodeImageFile(sourceFile, &image))
+    {
+        return false;
+    }
+
+    CompressedTexture texture;
+    CompressTextures(&image, 1, settings, &texture, statistics);
+    return WriteCookedTexture(cookedFile, texture);
+}
+
+bool TileTexture( const DecodedImage &  image, const TextureCookSettings &settings, uint32_t tileSize,
+                  uint32_t              tileBorder, CompressedTiledTexture* texture )
+{
+    Textures::VirtualTextureLayout layout;
+    if (!image.IsValid() ||
+        !Textures::MakeVirtualTextureLayout(image.Width, image.Height, tileSize, tileBorder, &layout))
+    {
+        return false;
+    }
+
+    const uint32_t paddedSize = layout.GetPaddedTileSize();
+    texture->Format = paddedSize % 4 == 0 ? settings.Format : Textures::TextureFormat::RGBA8;
+    texture->Srgb = settings.Srgb;
+    texture->Layout = layout;
+    texture->Tiles.assign(layout.GetNumTiles(), {});
+
+    std::vector<Textures::MipLevel> mipLevels;
+    if (layout.NumMips > 1)
+    {
+        Textures::GenerateMipChain(image.Pixels.GetData(), image.Width, image.Height, image.GetRowPitch(),
+                                   {settings.MipFilter, settings.Srgb}, &mipLevels);
+    }
+
+    struct TileSource {
+        const uint8_t*   Pixels;
+        uint32_t         Width;
+        uint32_t         Height;
+        Textures::TileId Tile;
+    };
+
+    std::vector<TileSource> sources;
+    sources.reserve(texture->Tiles.size());
+    for (uint32_t mip = 0; mip < layout.NumMips; ++mip)
+    {
+        const uint8_t* pixels = mip == 0 ? image.Pixels.GetData() : mipLevels[mip - 1].Pixels.data();
+        for (uint32_t y = 0; y < layout.GetNumTilesY(mip); ++y)
+        {
+            for (uint32_t x = 0; x < layout.GetNumTilesX(mip); ++x)
+            {
+                sources.push_back({pixels, layout.GetMipWidth(mip), layout.GetMipHeight(mip), {x, y, mip}});
+            }
+        }
+    }
+
+    Core::Threads::ThreadPool::Get().ParallelFor(sources.size(), 1, [&]( size_t begin, size_t end )
+    {
+        std::vector<uint8_t> texels(size_t(paddedSize) * paddedSize * 4);
+        for (size_t i = begin; i < end; ++i)
+        {
+            // Gather the tile with its border, texels past the edges of the mip repeat the last one.
+            const auto &source = sources[i];
+            int         left = int(source.Tile.X * tileSize) - int(tileBorder);
+            int         top = int(source.Tile.Y * tileSize) - int(tileBorder);
+            for (uint32_t row = 0; row < paddedSize; ++row)
+            {
+                int            y = std::clamp(top + int(row), 0, int(source.Height) - 1);
+                const uint8_t* sourceRow = source.Pixels + size_t(y) * source.Width * 4;
+                uint8_t*       destination = texels.data() + size_t(row) * paddedSize * 4;
+                for (uint32_t column = 0; column < paddedSize; ++column)
+                {
+                    int x = std::clamp(left + int(column), 0, int(source.Width) - 1);
+                    std::memcpy(destination + size_t(column) * 4, sourceRow + size_t(x) * 4, 4);
+                }
+            }
+
+            auto &tile = texture->Tiles[i];
+            tile.resize(Textures::GetSurfaceSize(texture->Format, paddedSize, paddedSize));
+            Textures::CompressSurface(texture->Format, settings.Quality, texels.data(), paddedSize, paddedSize,
+                                      size_t(paddedSize) * 4, 0, Textures::GetNumRows(texture->Format, paddedSize),
+                                      tile.data());
+        }
+    });
+    return true;
+}
+
+bool CookTiledTexture( const std::string &sourceFile, const std::string &tiledFile,
+                       const TextureCookSettings &settings, uint32_t tileSize, uint32_t tileBorder )
+{
+    DecodedImage image;
+    if (!DecodeImageFile(sourceFile, &image))
+    {
+        return false;
+    }
+
+    CompressedTiledTexture texture;
+    return TileTexture(image, settings, tileSize, tileBorder, &texture) && WriteTiledTexture(tiledFile, texture);
+}
+
+size_t CookModelTextures( ModelData* model, const TextureCookSettings &settings, TextureCookStatistics* statistics )
+{
+    std::vector<EncodedImage> sources;
+    std::vector<size_t>       sourceIndices;
+    for (size_t i = 0; i < model->Textures.size(); ++i)
+    {
+        const auto &texture = model->Textures[i];
+        if (texture.Height == 0 && IsCookedTexture(texture.Data.data(), texture.Data.size()))
+        {
+            continue;
+        }
+        sources.push_back({texture.Data.data(), texture.Data.size(), texture.Width, texture.Height});
+        sourceIndices.push_back(i);
+    }
+
+    std::vector<DecodedImage> images(sources.size());
+    DecodeImages(sources.data(), sources.size(), images.data());
+
+    std::vector<CompressedTexture> textures(sources.size());
+    CompressTextures(images.data(), images.size(), settings, textures.data(), statistics);
+
+    size_t numCooked = 0;
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        if (textures[i].Mips.empty())
+        {
+            continue;
+        }
+
+        auto &texture = model->Textures[sourceIndices[i]];
+        SerializeCookedTexture(textures[i], &texture.Data);
+        texture.Width = 0;
+        texture.Height = 0;
+        ++numCooked;
+    }
+    return numCooked;
+}
+
+}
@@ -0,0 +1,81 @@
+#ifndef TEXTURECOOKER_H
+#define TEXTURECOOKER_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "CookedTexture.h"
+#include "ModelData.h"
+#include "TextureDecoder.h"
+#include "TiledTexture.h"
+#include "../Textures/BlockCompression.h"
+#include "../Textures/MipChain.h"
+
+
+namespace Enterprise::Assets {
+
+struct TextureCookSettings {
+    Textures::TextureFormat      Format = Textures::TextureFormat::BC7;
+    Textures::CompressionQuality Quality = Textures::CompressionQuality::Normal;
+    // Generate the full mip chain down to 1x1, since block compressed textures cannot get their mips on the GPU.
+    bool                         GenerateMips = true;
+    Textures::MipFilter          MipFilter = Textures::MipFilter::Kaiser;
+    // Color data, mips are filtered in linear space.
+    bool                         Srgb = false;
+};
+
+struct TextureCookStatistics {
+    uint32_t NumTextures = 0;
+    // Textures stored uncompressed because their size is not a multiple of the block size.
+    uint32_t NumUncompressed = 0;
+    // Texels compressed over every mip, and the wall clock time spent doing so.
+    uint64_t NumTexels = 0;
+    double   EncodeSeconds = 0.0;
+    // Error of the largest mips after decoding them again, over the channels the format stores.
+    double   SquaredError = 0.0;
+    uint64_t NumSamples = 0;
+
+    [[nodiscard]] double GetMegatexelsPerSecond() const;
+
+    // Peak signal to noise ratio in dB.
+    [[nodiscard]] double GetPSNR() const;
+};
+
+/**
+ * Compress count decoded images. Every mip of every image is cut into tiles of block rows, and all tiles
+ * are compressed together on the shared thread pool, so a batch of small textures keeps every thread busy
+ * as well as one large texture does.
+ */
+void CompressTextures( const DecodedImage* images, size_t count, const TextureCookSettings &settings,
+                       CompressedTexture*  textures, TextureCookStatistics* statistics = nullptr );
+
+/**
+ * Decode an image file, compress it and write it in the cooked texture format.
+ */
+bool CookTexture( const std::string &sourceFile, const std::string &cookedFile, const TextureCookSettings &settings = {},
+                  TextureCookStatistics* statistics = nullptr );
+
+/**
+ * Cut a decoded image and its mips into tileSize tiles with tileBorder texels of border for a virtual texture,
+ * compressing the tiles on the shared thread pool. Mips are always generated, settings.GenerateMips is ignored.
+ * Tiles are stored uncompressed if their padded size is not a multiple of the block size.
+ */
+bool TileTexture( const DecodedImage &  image, const TextureCookSettings &settings, uint32_t tileSize,
+                  uint32_t              tileBorder, CompressedTiledTexture* texture );
+
+/**
+ * Decode an image file, cut it into tiles and write it in the tiled texture format.
+ */
+bool CookTiledTexture( const std::string &sourceFile, const std::string &tiledFile,
+                       const TextureCookSettings &settings = {}, uint32_t tileSize = 128, uint32_t tileBorder = 4 );
+
+/**
+ * Replace the embedded textures of a model with cooked textures, which the loader uploads without decoding.
+ * Textures that fail to decode keep their source data. Returns the number of textures cooked.
+ */
+size_t CookModelTextures( ModelData* model, const TextureCookSettings &settings = {},
+                          TextureCookStatistics* statistics = nullptr );
+
+}
+
+#endif //TEXTURECOOKER_H
@@ -0,0 +1,250 @@
+#include "TextureDecoder.h"
+
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "../Core/ThreadPool.h"
+
+// Route every allocation stb_image makes, including the returned pixels, through the scratch pool.
+#define STBI_MALLOC(size)           Enterprise::Assets::ScratchAllocate(size)
+#define STBI_REALLOC(block, size)   Enterprise::Assets::ScratchReallocate(block, size)
+#define STBI_FREE(block)            Enterprise::Assets::ScratchFree(block)
+#define STB_IMAGE_IMPLEMENTATION
+#include "../../vendor/stb/stb_image.h"
+
+
+namespace Enterprise::Assets {
+
+namespace {
+// Blocks carry a header with their bucket, padded to keep the data 16 byte aligned.
+constexpr size_t   SCRATCH_HEADER_SIZE = 16;
+constexpr uint32_t SCRATCH_MIN_BUCKET = 8;
+// Blocks up to 128 MiB are pooled, anything larger goes straight to the heap.
+constexpr uint32_t SCRATCH_MAX_BUCKET = 27;
+// Memory the pool keeps around between decodes.
+constexpr size_t   SCRATCH_MAX_CACHED_BYTES = size_t(256) * 1024 * 1024;
+constexpr uint32_t SCRATCH_UNPOOLED = UINT32_MAX;
+
+struct ScratchHeader {
+    uint32_t Bucket;
+    uint32_t Padding;
+    uint64_t Capacity;
+};
+static_assert(sizeof(ScratchHeader) == SCRATCH_HEADER_SIZE);
+
+class ScratchPool {
+public:
+    ~ScratchPool()
+    {
+        for (auto &blocks: m_FreeBlocks)
+        {
+            for (void* block: blocks)
+            {
+                std::free(block);
+            }
+        }
+    }
+
+    void* Allocate( size_t size )
+    {
+        size_t   blockSize = size + SCRATCH_HEADER_SIZE;
+        uint32_t bucket = SCRATCH_MIN_BUCKET;
+        while (bucket <= SCRATCH_MAX_BUCKET && (size_t(1) << bucket) < blockSize)
+        {
+            ++bucket;
+        }
+
+        void* block = nullptr;
+        if (bucket > SCRATCH_MAX_BUCKET)
+        {
+            bucket = SCRATCH_UNPOOLED;
+        } else
+        {
+            blockSize = size_t(1) << bucket;
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto &blocks = m_FreeBlocks[bucket];
+            if (!blocks.empty())
+            {
+                block = blocks.back();
+                blocks.pop_back();
+                m_CachedBytes -= blockSize;
+            }
+        }
+
+        if (block == nullptr)
+        {
+            block = std::malloc(blockSize);
+            if (block == nullptr)
+            {
+                return nullptr;
+            }
+        }
+
+        auto* header = static_cast<ScratchHeader *>(block);
+        header->Bucket = bucket;
+        header->Capacity = blockSize - SCRATCH_HEADER_SIZE;
+        return static_cast<uint8_t *>(block) + SCRATCH_HEADER_SIZE;
+    }
+
+    void Free( void* data )
+    {
+        void* block = static_cast<uint8_t *>(data) - SCRATCH_HEADER_SIZE;
+        auto* header = static_cast<ScratchHeader *>(block);
+        if (header->Bucket != SCRATCH_UNPOOLED)
+        {
+            size_t blockSize = size_t(1) << header->Bucket;
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_CachedBytes + blockSize <= SCRATCH_MAX_CACHED_BYTES)
+            {
+                m_FreeBlocks[header->Bucket].push_back(block);
+                m_CachedBytes += blockSize;
+                return;
+            }
+        }
+        std::free(block);
+    }
+
+private:
+    std::vector<void*> m_FreeBlocks[SCRATCH_MAX_BUCKET + 1];
+    size_t             m_CachedBytes = 0;
+    std::mutex         m_Mutex;
+};
+
+ScratchPool &GetScratchPool()
+{
+    static ScratchPool s_ScratchPool;
+    return s_ScratchPool;
+}
+
+void ConvertBGRAToRGBA( uint8_t* destination, const uint8_t* source, size_t numTexels )
+{
+    for (size_t i = 0; i < numTexels; ++i)
+    {
+        destination[i * 4 + 0] = source[i * 4 + 2];
+        destination[i * 4 + 1] = source[i * 4 + 1];
+        destination[i * 4 + 2] = source[i * 4 + 0];
+        destination[i * 4 + 3] = source[i * 4 + 3];
+    }
+}
+}
+
+void* ScratchAllocate( size_t size )
+{
+    return GetScratchPool().Allocate(size);
+}
+
+void* ScratchReallocate( void* block, size_t size )
+{
+    if (block == nullptr)
+    {
+        return ScratchAllocate(size);
+    }
+
+    auto* header = reinterpret_cast<ScratchHeader *>(static_cast<uint8_t *>(block) - SCRATCH_HEADER_SIZE);
+    if (size <= header->Capacity)
+    {
+        return block;
+    }
+
+    void* newBlock = ScratchAllocate(size);
+    if (newBlock != nullptr)
+    {
+        std::memcpy(newBlock, block, header->Capacity);
+        ScratchFree(block);
+    }
+    return newBlock;
+}
+
+void ScratchFree( void* block )
+{
+    if (block != nullptr)
+    {
+        GetScratchPool().Free(block);
+    }
+}
+
+bool DecodeImage( const EncodedImage &source, DecodedImage* image )
+{
+    *image = DecodedImage();
+
+    if (source.Height != 0)
+    {
+        size_t numTexels = size_t(source.Width) * source.Height;
+        if (source.Size < numTexels * 4)
+        {
+            return false;
+        }
+
+        image->Pixels = ScratchBuffer(ScratchAllocate(numTexels * 4));
+        if (!image->IsValid())
+        {
+            return false;
+        }
+        ConvertBGRAToRGBA(image->Pixels.GetData(), source.Data, numTexels);
+        image->Width = source.Width;
+        image->Height = source.Height;
+        return true;
+    }
+
+    if (source.Size > INT_MAX)
+    {
+        return false;
+    }
+
+    int      width, height, components;
+    stbi_uc* pixels = stbi_load_from_memory(source.Data, static_cast<int>(source.Size), &width, &height, &components,
+                                            STBI_rgb_alpha);
+    if (pixels == nullptr)
+    {
+        return false;
+    }
+
+    image->Pixels = ScratchBuffer(pixels);
+    image->Width = static_cast<uint32_t>(width);
+    image->Height = static_cast<uint32_t>(height);
+    return true;
+}
+
+bool DecodeImageFile( const std::string &fileName, DecodedImage* image )
+{
+    *image = DecodedImage();
+
+    int      width, height, components;
+    stbi_uc* pixels = stbi_load(fileName.c_str(), &width, &height, &components, STBI_rgb_alpha);
+    if (pixels == nullptr)
+    {
+        return false;
+    }
+
+    image->Pixels = ScratchBuffer(pixels);
+    image->Width = static_cast<uint32_t>(width);
+    image->Height = static_cast<uint32_t>(height);
+    return true;
+}
+
+size_t DecodeImages( const EncodedImage* sources, size_t count, DecodedImage* images )
+{
+    std::atomic<size_t> numDecoded{0};
+
+    // One image per task, image sizes vary too much for larger chunks to balance.
+    Core::Threads::ThreadPool::Get().ParallelFor(count, 1, [&]( size_t begin, size_t end )
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (DecodeImage(sources[i], &images[i]))
+            {
+                numDecoded.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    return numDecoded.load();
+}
+
+}
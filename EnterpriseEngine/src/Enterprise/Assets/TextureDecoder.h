@@ -0,0 +1,102 @@
+#ifndef TEXTUREDECODER_H
+#define TEXTUREDECODER_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace Enterprise::Assets {
+
+/**
+ * Scratch memory for decoded images. Blocks are rounded up to a power of two and recycled through a
+ * process wide pool, so decoding a batch of images reuses the same few allocations.
+ * stb_image allocates through these as well.
+ */
+void* ScratchAllocate( size_t size );
+
+void* ScratchReallocate( void* block, size_t size );
+
+void ScratchFree( void* block );
+
+// Owning handle to a ScratchAllocate block.
+class ScratchBuffer {
+public:
+    ScratchBuffer() = default;
+
+    explicit ScratchBuffer( void* block )
+        : m_Block(block)
+    {}
+
+    ~ScratchBuffer() { Reset(); }
+
+    ScratchBuffer( const ScratchBuffer &copy ) = delete;
+    ScratchBuffer &operator=( const ScratchBuffer &other ) = delete;
+
+    ScratchBuffer( ScratchBuffer &&other ) noexcept
+        : m_Block(other.m_Block)
+    {
+        other.m_Block = nullptr;
+    }
+
+    ScratchBuffer &operator=( ScratchBuffer &&other ) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            m_Block = other.m_Block;
+            other.m_Block = nullptr;
+        }
+        return *this;
+    }
+
+    [[nodiscard]] uint8_t* GetData() const { return static_cast<uint8_t *>(m_Block); }
+
+    void Reset()
+    {
+        ScratchFree(m_Block);
+        m_Block = nullptr;
+    }
+
+private:
+    void* m_Block = nullptr;
+};
+
+// Image decoded to RGBA8 with tightly packed rows.
+struct DecodedImage {
+    ScratchBuffer Pixels;
+    uint32_t      Width = 0;
+    uint32_t      Height = 0;
+
+    [[nodiscard]] bool IsValid() const { return Pixels.GetData() != nullptr; }
+
+    [[nodiscard]] size_t GetRowPitch() const { return size_t(Width) * 4; }
+};
+
+// Source of an image, as stored in TextureData: a compressed file (png, jpg, tga, ...) when Height is 0,
+// raw BGRA8 texels of Width x Height otherwise.
+struct EncodedImage {
+    const uint8_t* Data = nullptr;
+    size_t         Size = 0;
+    uint32_t       Width = 0;
+    uint32_t       Height = 0;
+};
+
+/**
+ * Decode an image held in memory. Returns false if the data could not be decoded.
+ */
+bool DecodeImage( const EncodedImage &source, DecodedImage* image );
+
+/**
+ * Decode an image file (png, jpg, tga, bmp, ...).
+ */
+bool DecodeImageFile( const std::string &fileName, DecodedImage* image );
+
+/**
+ * Decode count images on the shared thread pool, each exactly once. Images that fail to decode are left
+ * invalid. Returns the number of images decoded.
+ */
+size_t DecodeImages( const EncodedImage* sources, size_t count, DecodedImage* images );
+
+}
+
+#endif //TEXTUREDECODER_H
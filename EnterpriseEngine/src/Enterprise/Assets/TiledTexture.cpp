@@ -0,0 +1,162 @@
+#include "TiledTexture.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace Enterprise::Assets {
+
+namespace {
+
+uint64_t AlignTile( uint64_t offset )
+{
+    return (offset + TILED_TEXTURE_ALIGNMENT - 1) & ~(TILED_TEXTURE_ALIGNMENT - 1);
+}
+
+}
+
+bool WriteTiledTexture( const std::string &fileName, const CompressedTiledTexture &texture )
+{
+    std::vector<TiledTextureTile> tiles(texture.Tiles.size());
+    uint64_t                      offset = sizeof(TiledTextureHeader) + sizeof(TiledTextureTile) * tiles.size();
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        offset = AlignTile(offset);
+        tiles[i].Offset = offset;
+        tiles[i].Size = static_cast<uint32_t>(texture.Tiles[i].size());
+        tiles[i].Reserved = 0;
+        offset += texture.Tiles[i].size();
+    }
+
+    TiledTextureHeader header{};
+    header.Magic = TILED_TEXTURE_MAGIC;
+    header.Version = TILED_TEXTURE_VERSION;
+    header.Format = texture.Format;
+    header.Flags = texture.Srgb ? TILED_TEXTURE_FLAG_SRGB : TILED_TEXTURE_FLAG_NONE;
+    header.Width = texture.Layout.Width;
+    header.Height = texture.Layout.Height;
+    header.TileSize = texture.Layout.TileSize;
+    header.TileBorder = texture.Layout.TileBorder;
+    header.NumMips = texture.Layout.NumMips;
+    header.NumTiles = static_cast<uint32_t>(tiles.size());
+    header.FileSize = AlignTile(offset);
+
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+
+    // Tiles are written one at a time rather than laid out in memory first, tiled textures are large.
+    static const char padding[TILED_TEXTURE_ALIGNMENT] = {};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(tiles.data()),
+               static_cast<std::streamsize>(sizeof(TiledTextureTile) * tiles.size()));
+    uint64_t position = sizeof(TiledTextureHeader) + sizeof(TiledTextureTile) * tiles.size();
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        file.write(padding, static_cast<std::streamsize>(tiles[i].Offset - position));
+        file.write(reinterpret_cast<const char *>(texture.Tiles[i].data()),
+                   static_cast<std::streamsize>(texture.Tiles[i].size()));
+        position = tiles[i].Offset + tiles[i].Size;
+    }
+    file.write(padding, static_cast<std::streamsize>(header.FileSize - position));
+    return static_cast<bool>(file);
+}
+
+TiledTexture::TiledTexture()
+    : m_Data(nullptr)
+    , m_Header(nullptr)
+    , m_Tiles(nullptr)
+{}
+
+bool TiledTexture::Open( const std::string &fileName )
+{
+    Close();
+
+    if (!m_File.Open(fileName) || m_File.GetSize() < sizeof(TiledTextureHeader))
+    {
+        Close();
+        return false;
+    }
+
+    m_Data = m_File.GetData();
+    m_Header = reinterpret_cast<const TiledTextureHeader *>(m_Data);
+    m_Tiles = reinterpret_cast<const TiledTextureTile *>(m_Data + sizeof(TiledTextureHeader));
+    if (!Validate(m_File.GetSize()))
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void TiledTexture::Close()
+{
+    m_File.Close();
+    m_Data = nullptr;
+    m_Header = nullptr;
+    m_Tiles = nullptr;
+    m_Layout = {};
+    m_FirstTiles.clear();
+}
+
+size_t TiledTexture::GetTileSize() const
+{
+    return Textures::GetSurfaceSize(m_Header->Format, m_Layout.GetPaddedTileSize(), m_Layout.GetPaddedTileSize());
+}
+
+size_t TiledTexture::GetTileRowPitch() const
+{
+    return Textures::GetRowPitch(m_Header->Format, m_Layout.GetPaddedTileSize());
+}
+
+uint32_t TiledTexture::GetTileNumRows() const
+{
+    return Textures::GetNumRows(m_Header->Format, m_Layout.GetPaddedTileSize());
+}
+
+bool TiledTexture::Validate( size_t size )
+{
+    if (m_Header->Magic != TILED_TEXTURE_MAGIC || m_Header->Version != TILED_TEXTURE_VERSION ||
+        m_Header->FileSize > size || m_Header->Format >= Textures::TextureFormat::NumFormats)
+    {
+        return false;
+    }
+
+    // The layout follows from the size and tiling, it is only stored to catch files that do not match it.
+    if (!Textures::MakeVirtualTextureLayout(m_Header->Width, m_Header->Height, m_Header->TileSize,
+                                            m_Header->TileBorder, &m_Layout) ||
+        m_Layout.NumMips != m_Header->NumMips || m_Layout.GetNumTiles() != m_Header->NumTiles)
+    {
+        return false;
+    }
+
+    uint64_t tableEnd = sizeof(TiledTextureHeader) + sizeof(TiledTextureTile) * uint64_t(m_Header->NumTiles);
+    if (tableEnd > m_Header->FileSize)
+    {
+        return false;
+    }
+
+    size_t tileSize = GetTileSize();
+    for (uint32_t i = 0; i < m_Header->NumTiles; ++i)
+    {
+        const auto &tile = m_Tiles[i];
+        if (tile.Offset < tableEnd || tile.Offset % TILED_TEXTURE_ALIGNMENT != 0 ||
+            tile.Offset > m_Header->FileSize || tile.Size > m_Header->FileSize - tile.Offset ||
+            tile.Size != tileSize)
+        {
+            return false;
+        }
+    }
+
+    m_FirstTiles.resize(m_Layout.NumMips);
+    uint32_t firstTile = 0;
+    for (uint32_t mip = 0; mip < m_Layout.NumMips; ++mip)
+    {
+        m_FirstTiles[mip] = firstTile;
+        firstTile += m_Layout.GetNumTilesX(mip) * m_Layout.GetNumTilesY(mip);
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,119 @@
+#ifndef TILEDTEXTURE_H
+#define TILEDTEXTURE_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "../Textures/BlockCompression.h"
+#include "../Textures/VirtualTexture.h"
+
+
+namespace Enterprise::Assets {
+
+//---------------------------------------------------------------------------------------------|
+// Tiled texture file layout                                                                   |
+//---------------------------------------------------------------------------------------------|
+// TiledTextureHeader                                                                          |
+// TiledTextureTile[NumTiles], largest mip first, each mip in row order                        |
+// Tile data, each tile starting on a TILED_TEXTURE_ALIGNMENT boundary                         |
+//---------------------------------------------------------------------------------------------|
+// Tiles are TileSize + 2 * TileBorder texels square, their border repeating the neighbouring  |
+// tiles or, at the edges, the last texel. They are stored the way the GPU expects them, so a  |
+// tile is copied straight from the mapping into a slot of the physical texture.               |
+//---------------------------------------------------------------------------------------------|
+constexpr uint32_t TILED_TEXTURE_MAGIC = 0x4C495445; // "ETIL"
+constexpr uint32_t TILED_TEXTURE_VERSION = 1;
+constexpr uint64_t TILED_TEXTURE_ALIGNMENT = 16;
+
+enum TiledTextureFlags : uint32_t {
+    TILED_TEXTURE_FLAG_NONE = 0,
+    // Color data to be sampled through an sRGB view.
+    TILED_TEXTURE_FLAG_SRGB = 1 << 0,
+};
+
+struct TiledTextureHeader {
+    uint32_t                Magic;
+    uint32_t                Version;
+    Textures::TextureFormat Format;
+    uint32_t                Flags;
+    uint32_t                Width;
+    uint32_t                Height;
+    uint32_t                TileSize;
+    uint32_t                TileBorder;
+    uint32_t                NumMips;
+    uint32_t                NumTiles;
+    uint64_t                FileSize;
+};
+
+struct TiledTextureTile {
+    // From the start of the file.
+    uint64_t Offset;
+    uint32_t Size;
+    uint32_t Reserved;
+};
+
+// A texture cut into tiles, ready to be written.
+struct CompressedTiledTexture {
+    Textures::TextureFormat           Format = Textures::TextureFormat::RGBA8;
+    bool                              Srgb = false;
+    Textures::VirtualTextureLayout    Layout;
+    // Largest mip first, each mip in row order, see TiledTexture::GetTileIndex.
+    std::vector<std::vector<uint8_t> > Tiles;
+};
+
+bool WriteTiledTexture( const std::string &fileName, const CompressedTiledTexture &texture );
+
+/**
+ * A tiled texture mapped from a file, the source virtual textures stream their tiles from.
+ * Tiles are read through the mapping, so only the ones asked for are ever paged in.
+ */
+class TiledTexture {
+public:
+    TiledTexture();
+
+    bool Open( const std::string &fileName );
+
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const { return m_Header != nullptr; }
+
+    [[nodiscard]] Textures::TextureFormat GetFormat() const { return m_Header->Format; }
+
+    [[nodiscard]] bool IsSrgb() const { return (m_Header->Flags & TILED_TEXTURE_FLAG_SRGB) != 0; }
+
+    [[nodiscard]] const Textures::VirtualTextureLayout &GetLayout() const { return m_Layout; }
+
+    [[nodiscard]] uint32_t GetTileIndex( const Textures::TileId &tile ) const
+    {
+        return m_FirstTiles[tile.Mip] + tile.Y * m_Layout.GetNumTilesX(tile.Mip) + tile.X;
+    }
+
+    // Tightly packed rows of texels or blocks, see Textures::GetRowPitch.
+    [[nodiscard]] const uint8_t* GetTileData( const Textures::TileId &tile ) const
+    {
+        return m_Data + m_Tiles[GetTileIndex(tile)].Offset;
+    }
+
+    [[nodiscard]] size_t GetTileSize() const;
+
+    [[nodiscard]] size_t GetTileRowPitch() const;
+
+    [[nodiscard]] uint32_t GetTileNumRows() const;
+
+private:
+    // Also fills in the layout and the first tile of every mip.
+    bool Validate( size_t size );
+
+    MappedFile                     m_File;
+    const uint8_t*                 m_Data;
+    const TiledTextureHeader*      m_Header;
+    const TiledTextureTile*        m_Tiles;
+    Textures::VirtualTextureLayout m_Layout;
+    // Index of the first tile of every mip.
+    std::vector<uint32_t>          m_FirstTiles;
+};
+
+}
+
+#endif //TILEDTEXTURE_H
@@ -4,6 +4,9 @@
 
 #include "Camera.h"
 
+#include <algorithm>
+#include <cmath>
+
 // Used to get access to -, +, *, / operators
 using namespace DirectX;
 namespace Enterprise::Core {
@@ -54,6 +57,12 @@ XMFLOAT4 Camera::GetCameraLocation() const
 }
 
 
+float Camera::GetPixelsPerUnit( float distance, float viewportHeight ) const
+{
+    float halfHeight = std::max(distance, m_NearClip) * std::tan(XMConvertToRadians(m_Fov) * 0.5f);
+    return viewportHeight / (2.0f * halfHeight);
+}
+
 void Camera::SetProjection( float fovY, float aspectRatio, float nearClip, float farClip )
 {
     m_Fov = fovY;
@@ -20,6 +20,11 @@ public:
     [[nodiscard]] DirectX::XMMATRIX GetViewMatrix() const;
     [[nodiscard]] DirectX::XMMATRIX GetProjectionMatrix() const;
     [[nodiscard]] DirectX::XMFLOAT4 GetCameraLocation() const;
+    [[nodiscard]] float GetFov() const { return m_Fov; }
+    /**
+     * Size in pixels of one world unit at distance from the camera, for a viewport viewportHeight pixels high.
+     */
+    [[nodiscard]] float GetPixelsPerUnit( float distance, float viewportHeight ) const;
     void SetProjection( float fovY, float aspectRatio, float nearClip, float farClip);
 
 
@@ -2,6 +2,7 @@
 // Created by Peter on 5/12/2025.
 //
 
+#include <algorithm>
 #include <filesystem>
 
 #include "CommandList.h"
@@ -12,12 +13,13 @@
 #include "Log.h"
 #include "Resource.h"
 #include "ResourceStateTracker.h"
+#include "../Assets/ContentHash.h"
+#include "../Assets/CookedTexture.h"
+#include "../Assets/TextureDecoder.h"
+#include "../Textures/MipChain.h"
 
 
 namespace Enterprise::Core::Graphics {
-std::map<std::wstring, ID3D12Resource *> CommandList::ms_TextureCache{};
-std::mutex                               CommandList::ms_TextureCacheMutex{};
-
 CommandList::CommandList( D3D12_COMMAND_LIST_TYPE type )
     : m_D3D12CommandListType( type )
 {
@@ -157,35 +159,36 @@ void CommandList::CopyResource( Resource &destResource, const Resource &srcResou
 void CommandList::CopyTextureSubresource( const Texture &texture, uint32_t firstSubResource, uint32_t numSubResources,
                                           D3D12_SUBRESOURCE_DATA* data )
 {
-    auto device = Renderer::Get()->GetDevice();
     auto destResource = texture.GetD3D12Resource();
     if (destResource)
     {
         TransitionBarrier(texture, D3D12_RESOURCE_STATE_COPY_DEST);
         FlushResourceBarriers();
         uint64_t requiredSize = GetRequiredIntermediateSize(destResource.Get(), firstSubResource, numSubResources);
-        Microsoft::WRL::ComPtr<ID3D12Resource> intermediateResource;
-        ThrowIfFailed(device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(requiredSize),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&intermediateResource)
-        ));
-
-        UpdateSubresources( m_D3D12CommandList.Get(), destResource.Get(), intermediateResource.Get(),
-            0, firstSubResource, numSubResources, data);
-
-        TrackObject(intermediateResource);
+
+        // Small textures are staged in an upload page rather than a resource of their own.
+        if (requiredSize <= m_UploadBuffer->GetPageSize())
+        {
+            auto uploadAllocation = m_UploadBuffer->Allocate(requiredSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+            UpdateSubresources(m_D3D12CommandList.Get(), destResource.Get(), uploadAllocation.Resource,
+                               uploadAllocation.Offset, firstSubResource, numSubResources, data);
+        } else
+        {
+            auto intermediateResource = Renderer::Get()->GetMemoryAllocator()->CreateResource(
+                CD3DX12_RESOURCE_DESC::Buffer(requiredSize), D3D12_HEAP_TYPE_UPLOAD,
+                D3D12_RESOURCE_STATE_GENERIC_READ);
+
+            UpdateSubresources( m_D3D12CommandList.Get(), destResource.Get(), intermediateResource.Get(),
+                0, firstSubResource, numSubResources, data);
+
+            TrackObject(intermediateResource);
+        }
         TrackObject(destResource);
     }
 }
 
 void CommandList::CopyBuffer( Buffer& buffer, size_t numElements, size_t elementSize, const void* bufferData, D3D12_RESOURCE_FLAGS flags )
 {
-    auto device = Renderer::Get()->GetDevice();
-
     size_t bufferSize = numElements * elementSize;
 
     Microsoft::WRL::ComPtr<ID3D12Resource> d3d12Resource;
@@ -195,29 +198,14 @@ void CommandList::CopyBuffer( Buffer& buffer, size_t numElements, size_t element
     }
     else
     {
-        ThrowIfFailed( device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES( D3D12_HEAP_TYPE_DEFAULT ),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(bufferSize, flags),
-            D3D12_RESOURCE_STATE_COMMON,
-            nullptr,
-            IID_PPV_ARGS(&d3d12Resource)));
+        d3d12Resource = Renderer::Get()->GetMemoryAllocator()->CreateResource(
+            CD3DX12_RESOURCE_DESC::Buffer(bufferSize, flags), D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COMMON);
 
         // Add the resource to the global resource state tracker.
         ResourceStateTracker::AddGlobalResourceState( d3d12Resource.Get(), D3D12_RESOURCE_STATE_COMMON);
 
         if ( bufferData != nullptr )
         {
-            // Create an upload resource to use as an intermediate buffer to copy the buffer resource
-            Microsoft::WRL::ComPtr<ID3D12Resource> uploadResource;
-            ThrowIfFailed( device->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-                D3D12_HEAP_FLAG_NONE,
-                &CD3DX12_RESOURCE_DESC::Buffer(bufferSize),
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(&uploadResource)));
-
             D3D12_SUBRESOURCE_DATA subresourceData = {};
             subresourceData.pData = bufferData;
             subresourceData.RowPitch = bufferSize;
@@ -226,11 +214,25 @@ void CommandList::CopyBuffer( Buffer& buffer, size_t numElements, size_t element
             m_ResourceStateTracker->TransitionResource(d3d12Resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
             FlushResourceBarriers();
 
-            UpdateSubresources( m_D3D12CommandList.Get(), d3d12Resource.Get(),
-                uploadResource.Get(), 0, 0, 1, &subresourceData );
-
-            // Add references to resources so they stay in scope until the command list is reset.
-            TrackResource(uploadResource);
+            // Small buffers are staged in an upload page rather than a resource of their own.
+            if (bufferSize <= m_UploadBuffer->GetPageSize())
+            {
+                auto uploadAllocation = m_UploadBuffer->Allocate(bufferSize, 4);
+                UpdateSubresources( m_D3D12CommandList.Get(), d3d12Resource.Get(),
+                    uploadAllocation.Resource, uploadAllocation.Offset, 0, 1, &subresourceData );
+            } else
+            {
+                // Create an upload resource to use as an intermediate buffer to copy the buffer resource
+                auto uploadResource = Renderer::Get()->GetMemoryAllocator()->CreateResource(
+                    CD3DX12_RESOURCE_DESC::Buffer(bufferSize), D3D12_HEAP_TYPE_UPLOAD,
+                    D3D12_RESOURCE_STATE_GENERIC_READ);
+
+                UpdateSubresources( m_D3D12CommandList.Get(), d3d12Resource.Get(),
+                    uploadResource.Get(), 0, 0, 1, &subresourceData );
+
+                // Add references to resources so they stay in scope until the command list is reset.
+                TrackResource(uploadResource);
+            }
         }
         TrackResource(d3d12Resource);
     }
@@ -239,6 +241,126 @@ void CommandList::CopyBuffer( Buffer& buffer, size_t numElements, size_t element
     buffer.CreateViews( numElements, elementSize );
 }
 
+void CommandList::WriteBuffer( Buffer &buffer, size_t offset, const void* data, size_t numBytes )
+{
+    if (numBytes == 0)
+    {
+        return;
+    }
+
+    auto d3d12Resource = buffer.GetD3D12Resource();
+
+    ID3D12Resource* uploadResource;
+    size_t          uploadOffset;
+    if (numBytes <= m_UploadBuffer->GetPageSize())
+    {
+        auto uploadAllocation = m_UploadBuffer->Allocate(numBytes, 4);
+        memcpy(uploadAllocation.CPU, data, numBytes);
+        uploadResource = uploadAllocation.Resource;
+        uploadOffset = uploadAllocation.Offset;
+    } else
+    {
+        // Too large for an upload page, stage it in a resource of its own.
+        auto intermediateResource = Renderer::Get()->GetMemoryAllocator()->CreateResource(
+            CD3DX12_RESOURCE_DESC::Buffer(numBytes), D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+        void* pCPU = nullptr;
+        ThrowIfFailed(intermediateResource->Map(0, nullptr, &pCPU));
+        memcpy(pCPU, data, numBytes);
+        intermediateResource->Unmap(0, nullptr);
+
+        TrackResource(intermediateResource);
+        uploadResource = intermediateResource.Get();
+        uploadOffset = 0;
+    }
+
+    TransitionBarrier(d3d12Resource, D3D12_RESOURCE_STATE_COPY_DEST);
+    FlushResourceBarriers();
+
+    m_D3D12CommandList->CopyBufferRegion(d3d12Resource.Get(), offset, uploadResource, uploadOffset, numBytes);
+
+    TrackResource(d3d12Resource);
+}
+
+void CommandList::WriteTextureRegion( const Texture &texture, uint32_t subresource, uint32_t x, uint32_t y,
+                                      uint32_t       width, uint32_t height, const void* data, size_t rowPitch,
+                                      uint32_t       numRows )
+{
+    if (numRows == 0)
+    {
+        return;
+    }
+
+    auto d3d12Resource = texture.GetD3D12Resource();
+
+    // Rows of a texture copy source are aligned, unlike the tightly packed source rows.
+    size_t uploadPitch = AlignUp(rowPitch, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+    size_t uploadSize = uploadPitch * numRows;
+
+    ID3D12Resource*                        uploadResource;
+    size_t                                 uploadOffset;
+    void*                                  uploadData;
+    Microsoft::WRL::ComPtr<ID3D12Resource> intermediateResource;
+    if (uploadSize <= m_UploadBuffer->GetPageSize())
+    {
+        auto uploadAllocation = m_UploadBuffer->Allocate(uploadSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+        uploadResource = uploadAllocation.Resource;
+        uploadOffset = uploadAllocation.Offset;
+        uploadData = uploadAllocation.CPU;
+    } else
+    {
+        // Too large for an upload page, stage it in a resource of its own.
+        intermediateResource = Renderer::Get()->GetMemoryAllocator()->CreateResource(
+            CD3DX12_RESOURCE_DESC::Buffer(uploadSize), D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+        ThrowIfFailed(intermediateResource->Map(0, nullptr, &uploadData));
+        TrackResource(intermediateResource);
+        uploadResource = intermediateResource.Get();
+        uploadOffset = 0;
+    }
+
+    for (uint32_t row = 0; row < numRows; ++row)
+    {
+        memcpy(static_cast<uint8_t *>(uploadData) + uploadPitch * row,
+               static_cast<const uint8_t *>(data) + rowPitch * row, rowPitch);
+    }
+    if (intermediateResource)
+    {
+        intermediateResource->Unmap(0, nullptr);
+    }
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+    footprint.Offset = uploadOffset;
+    footprint.Footprint.Format = d3d12Resource->GetDesc().Format;
+    footprint.Footprint.Width = width;
+    footprint.Footprint.Height = height;
+    footprint.Footprint.Depth = 1;
+    footprint.Footprint.RowPitch = static_cast<UINT>(uploadPitch);
+
+    TransitionBarrier(texture, D3D12_RESOURCE_STATE_COPY_DEST, subresource);
+    FlushResourceBarriers();
+
+    CD3DX12_TEXTURE_COPY_LOCATION destination(d3d12Resource.Get(), subresource);
+    CD3DX12_TEXTURE_COPY_LOCATION source(uploadResource, footprint);
+    m_D3D12CommandList->CopyTextureRegion(&destination, x, y, 0, &source, nullptr);
+
+    TrackResource(d3d12Resource);
+}
+
+void CommandList::CopyBufferRegion( Microsoft::WRL::ComPtr<ID3D12Resource> dstRes, size_t dstOffset,
+                                    Microsoft::WRL::ComPtr<ID3D12Resource> srcRes, size_t srcOffset,
+                                    size_t numBytes )
+{
+    TransitionBarrier(dstRes, D3D12_RESOURCE_STATE_COPY_DEST);
+    TransitionBarrier(srcRes, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    FlushResourceBarriers();
+
+    m_D3D12CommandList->CopyBufferRegion(dstRes.Get(), dstOffset, srcRes.Get(), srcOffset, numBytes);
+
+    TrackResource(dstRes);
+    TrackResource(srcRes);
+}
 
 void CommandList::CopyVertexBuffer( VertexBuffer& vertexBuffer, size_t numVertices, size_t vertexStride, const void* vertexBufferData )
 {
@@ -347,6 +469,36 @@ void CommandList::SetGraphicsDynamicStructuredBuffer( uint32_t slot, size_t numE
     m_D3D12CommandList->SetGraphicsRootShaderResourceView( slot, heapAllocation.GPU );
 }
 
+void* CommandList::SetGraphicsDynamicStructuredBuffer( uint32_t slot, size_t numElements, size_t elementSize )
+{
+    auto heapAllocation = AllocateDynamicBuffer( numElements * elementSize );
+
+    SetGraphicsRootShaderResourceView( slot, heapAllocation.GPU );
+
+    return heapAllocation.CPU;
+}
+
+UploadBuffer::Allocation CommandList::AllocateDynamicBuffer( size_t sizeInBytes, size_t alignment )
+{
+    return m_UploadBuffer->Allocate( sizeInBytes, alignment );
+}
+
+void CommandList::SetGraphicsRootShaderResourceView( uint32_t rootParameterIndex, const Buffer &buffer,
+                                                     D3D12_RESOURCE_STATES stateAfter )
+{
+    TransitionBarrier(buffer, stateAfter, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, true);
+
+    m_D3D12CommandList->SetGraphicsRootShaderResourceView(rootParameterIndex,
+                                                          buffer.GetD3D12Resource()->GetGPUVirtualAddress());
+
+    TrackResource(buffer);
+}
+
+void CommandList::SetGraphicsRootShaderResourceView( uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS address )
+{
+    m_D3D12CommandList->SetGraphicsRootShaderResourceView( rootParameterIndex, address );
+}
+
 void CommandList::SetGraphics32BitConstants( uint32_t rootParameterIndex, uint32_t numConstants, const void* constants )
 {
     m_D3D12CommandList->SetGraphicsRoot32BitConstants( rootParameterIndex, numConstants, constants, 0 );
@@ -479,108 +631,258 @@ void CommandList::ResolveSubresource( Resource& dstRes, const Resource& srcRes,
 
 void CommandList::LoadEmbeddedTexture( Texture* texture, const uint8_t* imageData, size_t size, const std::wstring &textureName)
 {
-    std::lock_guard<std::mutex> lock(ms_TextureCacheMutex);
-    auto iter = ms_TextureCache.find(textureName);
-    if (iter != ms_TextureCache.end())
+    TextureCache::Key cacheKey = GetTextureContentKey(imageData, size, false);
+    if (GetCachedTexture(*texture, cacheKey, textureName))
     {
-        texture->SetD3D12Resource(iter->second, nullptr);
-        texture->CreateViews();
-        texture->SetName(textureName);
-    } else
+        return;
+    }
+
+    Assets::DecodedImage image;
+    if (!Assets::DecodeImage({imageData, size, 0, 0}, &image))
     {
-        DirectX::TexMetadata metadata{};
-        DirectX::ScratchImage scratchImage;
-        ThrowIfFailed(DirectX::LoadFromWICMemory(imageData, size, DirectX::WIC_FLAGS::WIC_FLAGS_NONE, &metadata, scratchImage));
-        D3D12_RESOURCE_DESC textureDesc = {};
-        switch (metadata.dimension)
-        {
-            case DirectX::TEX_DIMENSION_TEXTURE1D:
-                textureDesc = CD3DX12_RESOURCE_DESC::Tex1D(
-                    metadata.format,
-                    static_cast<UINT64>(metadata.width),
-                    static_cast<UINT16>(metadata.arraySize)
-                );
-                break;
-            case DirectX::TEX_DIMENSION_TEXTURE2D:
-                textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(
-                    metadata.format,
-                    static_cast<UINT64>(metadata.width),
-                    static_cast<UINT>(metadata.height),
-                    static_cast<UINT16>(metadata.arraySize)
-                );
-                break;
-            case DirectX::TEX_DIMENSION_TEXTURE3D:
-                textureDesc = CD3DX12_RESOURCE_DESC::Tex3D(
-                    metadata.format,
-                    static_cast<UINT64>(metadata.width),
-                    static_cast<UINT>(metadata.height),
-                    static_cast<UINT16>(metadata.arraySize)
-                );
-            default:
-                EE_CORE_ERROR("Invalid texture dimension.");
-                throw std::exception("Invalid texture dimension");
-        }
-        auto                                   device = Renderer::Get()->GetDevice();
-        Microsoft::WRL::ComPtr<ID3D12Resource> textureResource;
-
-        ThrowIfFailed(device->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-                D3D12_HEAP_FLAG_NONE,
-                &textureDesc,
-                D3D12_RESOURCE_STATE_COMMON,
-                nullptr,
-                IID_PPV_ARGS(&textureResource))
-        );
+        EE_CORE_ERROR("Unable to decode embedded texture.");
+        throw std::exception("Unable to decode embedded texture");
+    }
 
-        texture->SetD3D12Resource(textureResource, nullptr);
-        texture->CreateViews();
-        texture->SetName(textureName);
+    std::vector<Textures::MipLevel> mips;
+    Textures::GenerateMipChain(image.Pixels.GetData(), image.Width, image.Height, image.GetRowPitch(), {}, &mips);
+    LoadTextureFromImage(*texture, image, mips, cacheKey, textureName, false);
+}
 
-        ResourceStateTracker::AddGlobalResourceState(textureResource.Get(), D3D12_RESOURCE_STATE_COMMON);
-        std::vector<D3D12_SUBRESOURCE_DATA> subresources(scratchImage.GetImageCount());
-        const DirectX::Image*               pImages = scratchImage.GetImages();
-        for (UINT i = 0; i < scratchImage.GetImageCount(); ++i)
-        {
-            auto &subresource = subresources[i];
-            subresource.RowPitch = pImages[i].rowPitch;
-            subresource.SlicePitch = pImages[i].slicePitch;
-            subresource.pData = pImages[i].pixels;
-        }
+TextureCache::Key CommandList::GetTextureNameKey( const std::wstring &textureName )
+{
+    return Assets::HashContent(textureName.data(), textureName.size() * sizeof(wchar_t));
+}
 
-        CopyTextureSubresource(
-            *texture,
-            0,
-            static_cast<uint32_t>(subresources.size()),
-            subresources.data()
-        );
+TextureCache::Key CommandList::GetTextureContentKey( const void* data, size_t size, bool useSrgb )
+{
+    // Seeded differently from the name keys, so a name can never alias a texture's content.
+    Assets::ContentHasher hasher(1);
+    hasher.Add(data, size);
+    hasher.Add(useSrgb);
+    return hasher.GetHash();
+}
 
-        if (subresources.size() < textureResource->GetDesc().MipLevels)
-        {
-            // TODO: finish mips
-            //GenerateMips(*texture);
-        }
-        ms_TextureCache[textureName] = textureResource.Get();
+bool CommandList::GetCachedTexture( Texture &texture, TextureCache::Key cacheKey, const std::wstring &textureName )
+{
+    auto handle = Renderer::Get()->GetTextureCache()->Find(cacheKey);
+    if (!handle)
+    {
+        return false;
+    }
+
+    ShareCachedTexture(texture, std::move(handle), textureName);
+    return true;
+}
+
+void CommandList::ShareCachedTexture( Texture &texture, TextureCache::Handle handle, const std::wstring &textureName )
+{
+    const auto &upload = handle.Get().Upload;
+    if (upload && upload != m_TextureUpload && !IsTextureUploadComplete(*upload) &&
+        std::find(m_SharedTextureUploads.begin(), m_SharedTextureUploads.end(), upload) == m_SharedTextureUploads.end())
+    {
+        m_SharedTextureUploads.push_back(upload);
+    }
+    SetCachedTexture(texture, std::move(handle), textureName);
+}
+
+bool CommandList::IsTextureUploadComplete( const TextureUpload &upload )
+{
+    uint64_t fenceValue = upload.FenceValue.load(std::memory_order_acquire);
+    return fenceValue != 0 && upload.Queue->IsFenceComplete(fenceValue);
+}
+
+void CommandList::SetTextureUploadFence( uint64_t fenceValue )
+{
+    if (m_TextureUpload)
+    {
+        m_TextureUpload->FenceValue.store(fenceValue, std::memory_order_release);
+        m_TextureUpload.reset();
     }
+}
+
+void CommandList::SetCachedTexture( Texture &texture, TextureCache::Handle handle, const std::wstring &textureName )
+{
+    texture.SetD3D12Resource(handle.Get().D3D12Resource, nullptr);
+    texture.CreateViews();
+    texture.SetName(textureName);
+    texture.SetCacheHandle(std::move(handle));
+}
 
+void CommandList::AddCachedTexture( Texture &texture, TextureCache::Key cacheKey, const std::wstring &textureName )
+{
+    auto                device = Renderer::Get()->GetDevice();
+    auto                textureResource = texture.GetD3D12Resource();
+    D3D12_RESOURCE_DESC textureDesc = textureResource->GetDesc();
+    uint64_t            size = device->GetResourceAllocationInfo(0, 1, &textureDesc).SizeInBytes;
+
+    if (!m_TextureUpload)
+    {
+        m_TextureUpload = std::make_shared<TextureUpload>();
+        m_TextureUpload->Queue = Renderer::Get()->GetCommandQueue(m_D3D12CommandListType);
+    }
+    auto handle = Renderer::Get()->GetTextureCache()->Insert(cacheKey, {textureResource, m_TextureUpload}, size);
+    if (handle.Get().D3D12Resource != textureResource)
+    {
+        // Another thread loaded the same texture first, use that one so only one copy stays resident.
+        ShareCachedTexture(texture, std::move(handle), textureName);
+        return;
+    }
+    texture.SetCacheHandle(std::move(handle));
+}
+
+void CommandList::LoadTextureFromImage( Texture &texture, const Assets::DecodedImage &image,
+                                        const std::vector<Textures::MipLevel> &mips, TextureCache::Key cacheKey,
+                                        const std::wstring &textureName, bool useSrgb )
+{
+    if (GetCachedTexture(texture, cacheKey, textureName))
+    {
+        return;
+    }
+
+    DXGI_FORMAT format = useSrgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+    auto                numMips = static_cast<uint32_t>(mips.size() + 1);
+    D3D12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, image.Width, image.Height, 1,
+                                                                   static_cast<UINT16>(numMips));
+
+    auto textureResource = Renderer::Get()->GetMemoryAllocator()->CreateResource(textureDesc, D3D12_HEAP_TYPE_DEFAULT,
+                                                                                 D3D12_RESOURCE_STATE_COMMON);
+
+    texture.SetD3D12Resource(textureResource, nullptr);
+    texture.CreateViews();
+    texture.SetName(textureName);
+    texture.m_Width = static_cast<int32_t>(image.Width);
+    texture.m_Height = static_cast<int32_t>(image.Height);
+    texture.m_ComponentsPerPixel = 4;
+
+    ResourceStateTracker::AddGlobalResourceState(textureResource.Get(), D3D12_RESOURCE_STATE_COMMON);
+
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources(numMips);
+    subresources[0].pData = image.Pixels.GetData();
+    subresources[0].RowPitch = static_cast<LONG_PTR>(image.GetRowPitch());
+    subresources[0].SlicePitch = static_cast<LONG_PTR>(image.GetRowPitch() * image.Height);
+    for (uint32_t i = 1; i < numMips; ++i)
+    {
+        const auto &mip = mips[i - 1];
+        subresources[i].pData = mip.Pixels.data();
+        subresources[i].RowPitch = static_cast<LONG_PTR>(size_t(mip.Width) * 4);
+        subresources[i].SlicePitch = static_cast<LONG_PTR>(mip.Pixels.size());
+    }
+    CopyTextureSubresource(texture, 0, numMips, subresources.data());
+
+    AddCachedTexture(texture, cacheKey, textureName);
+}
+
+DXGI_FORMAT CommandList::GetCookedTextureFormat( Textures::TextureFormat format, bool useSrgb )
+{
+    switch (format)
+    {
+        case Textures::TextureFormat::BC1:
+            return useSrgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+        case Textures::TextureFormat::BC3:
+            return useSrgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+        case Textures::TextureFormat::BC4:
+            return DXGI_FORMAT_BC4_UNORM;
+        case Textures::TextureFormat::BC5:
+            return DXGI_FORMAT_BC5_UNORM;
+        case Textures::TextureFormat::BC7:
+            return useSrgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+        default:
+            return useSrgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+void CommandList::LoadCookedTexture( Texture &texture, const Assets::CookedTexture &cookedTexture,
+                                     TextureCache::Key cacheKey, const std::wstring &textureName, bool useSrgb )
+{
+    if (GetCachedTexture(texture, cacheKey, textureName))
+    {
+        return;
+    }
+
+    uint32_t            numMips = cookedTexture.GetNumMips();
+    DXGI_FORMAT         format = GetCookedTextureFormat(cookedTexture.GetFormat(), useSrgb || cookedTexture.IsSrgb());
+    D3D12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, cookedTexture.GetWidth(),
+                                                                   cookedTexture.GetHeight(), 1,
+                                                                   static_cast<UINT16>(numMips));
+
+    auto textureResource = Renderer::Get()->GetMemoryAllocator()->CreateResource(textureDesc, D3D12_HEAP_TYPE_DEFAULT,
+                                                                                 D3D12_RESOURCE_STATE_COMMON);
+
+    texture.SetD3D12Resource(textureResource, nullptr);
+    texture.CreateViews();
+    texture.SetName(textureName);
+    texture.m_Width = static_cast<int32_t>(cookedTexture.GetWidth());
+    texture.m_Height = static_cast<int32_t>(cookedTexture.GetHeight());
+    texture.m_ComponentsPerPixel = 4;
+
+    ResourceStateTracker::AddGlobalResourceState(textureResource.Get(), D3D12_RESOURCE_STATE_COMMON);
+
+    // The cooked rows are already laid out the way the copy wants them.
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources(numMips);
+    for (uint32_t i = 0; i < numMips; ++i)
+    {
+        const auto &mip = cookedTexture.GetMip(i);
+        subresources[i].pData = cookedTexture.GetMipData(mip);
+        subresources[i].RowPitch = static_cast<LONG_PTR>(mip.RowPitch);
+        subresources[i].SlicePitch = static_cast<LONG_PTR>(mip.Size);
+    }
+    CopyTextureSubresource(texture, 0, numMips, subresources.data());
+
+    AddCachedTexture(texture, cacheKey, textureName);
 }
 
 void CommandList::LoadTextureFromFile( Texture &texture, const std::wstring &fileName, bool useSrgb )
 {
     std::filesystem::path filePath(fileName);
+    TextureCache::Key     cacheKey = GetTextureNameKey(fileName);
     if (!std::filesystem::exists(filePath))
     {
         throw std::exception("File not found. ");
         EE_CORE_ERROR("Texture file not found");
     }
 
-    std::lock_guard<std::mutex> lock(ms_TextureCacheMutex);
-    auto                        iter = ms_TextureCache.find(fileName);
-    if (iter != ms_TextureCache.end())
+    if (filePath.extension() == ".etex")
     {
-        texture.SetD3D12Resource(iter->second, nullptr);
-        texture.CreateViews();
-        texture.SetName(fileName);
-    } else
+        if (GetCachedTexture(texture, cacheKey, fileName))
+        {
+            return;
+        }
+
+        Assets::CookedTexture cookedTexture;
+        if (!cookedTexture.Open(filePath.string()))
+        {
+            EE_CORE_ERROR("Unable to open cooked texture file.");
+            throw std::exception("Unable to open cooked texture file");
+        }
+        LoadCookedTexture(texture, cookedTexture, cacheKey, fileName, useSrgb);
+        return;
+    }
+
+    // DirectXTex only handles the formats stb_image cannot decode.
+    if (filePath.extension() != ".dds" && filePath.extension() != ".hdr")
+    {
+        if (GetCachedTexture(texture, cacheKey, fileName))
+        {
+            return;
+        }
+
+        Assets::DecodedImage image;
+        if (!Assets::DecodeImageFile(filePath.string(), &image))
+        {
+            EE_CORE_ERROR("Unable to decode texture file.");
+            throw std::exception("Unable to decode texture file");
+        }
+
+        // Built here rather than with GenerateMips, so the whole chain goes up in one copy.
+        std::vector<Textures::MipLevel> mips;
+        Textures::GenerateMipChain(image.Pixels.GetData(), image.Width, image.Height, image.GetRowPitch(),
+                                   {Textures::MipFilter::Box, useSrgb}, &mips);
+        LoadTextureFromImage(texture, image, mips, cacheKey, fileName, useSrgb);
+        return;
+    }
+
+    if (!GetCachedTexture(texture, cacheKey, fileName))
     {
         DirectX::TexMetadata  metadata{};
         DirectX::ScratchImage scratchImage;
@@ -593,25 +895,10 @@ void CommandList::LoadTextureFromFile( Texture &texture, const std::wstring &fil
                     &metadata,
                     scratchImage)
             );
-        } else if (filePath.extension() == "hdr")
-        {
-            ThrowIfFailed(DirectX::LoadFromHDRFile(
-                    fileName.c_str(),
-                    &metadata,
-                    scratchImage)
-            );
-        } else if (filePath.extension() == "tga")
-        {
-            ThrowIfFailed(DirectX::LoadFromTGAFile(
-                    fileName.c_str(),
-                    &metadata,
-                    scratchImage)
-            );
         } else
         {
-            ThrowIfFailed(DirectX::LoadFromWICFile(
+            ThrowIfFailed(DirectX::LoadFromHDRFile(
                     fileName.c_str(),
-                    DirectX::WIC_FLAGS_FORCE_RGB,
                     &metadata,
                     scratchImage)
             );
@@ -649,17 +936,8 @@ void CommandList::LoadTextureFromFile( Texture &texture, const std::wstring &fil
                 EE_CORE_ERROR("Invalid texture dimension.");
                 throw std::exception("Invalid texture dimension");
         }
-        auto                                   device = Renderer::Get()->GetDevice();
-        Microsoft::WRL::ComPtr<ID3D12Resource> textureResource;
-
-        ThrowIfFailed(device->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-                D3D12_HEAP_FLAG_NONE,
-                &textureDesc,
-                D3D12_RESOURCE_STATE_COMMON,
-                nullptr,
-                IID_PPV_ARGS(&textureResource))
-        );
+        auto textureResource = Renderer::Get()->GetMemoryAllocator()->CreateResource(
+            textureDesc, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COMMON);
 
         texture.SetD3D12Resource(textureResource, nullptr);
         texture.CreateViews();
@@ -687,7 +965,7 @@ void CommandList::LoadTextureFromFile( Texture &texture, const std::wstring &fil
         {
             GenerateMips(texture);
         }
-        ms_TextureCache[fileName] = textureResource.Get();
+        AddCachedTexture(texture, cacheKey, fileName);
     }
 }
 
@@ -738,6 +1016,7 @@ void CommandList::Reset()
 
     m_RootSignature = nullptr;
     m_ComputeCommandList = nullptr;
+    m_SharedTextureUploads.clear();
 }
 
 
@@ -5,9 +5,7 @@
 #ifndef COMMANDLIST_H
 #define COMMANDLIST_H
 #include <cstdint>
-#include <map>
 #include <memory>
-#include <mutex>
 #include <string>
 #include <vector>
 
@@ -23,6 +21,16 @@
 #include "ResourceStateTracker.h"
 
 
+namespace Enterprise::Assets {
+struct DecodedImage;
+class CookedTexture;
+}
+
+namespace Enterprise::Textures {
+struct MipLevel;
+enum class TextureFormat : uint32_t;
+}
+
 namespace Enterprise::Core::Graphics {
 
 class ENTERPRISE_API CommandList {
@@ -43,6 +51,8 @@ public:
         return m_D3D12CommandList;
     }
 
+    [[nodiscard]] D3D12_COMMAND_LIST_TYPE GetCommandListType() const { return m_D3D12CommandListType; }
+
     void Draw( uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance );
 
     void DrawIndexed( uint32_t indexCountPerInstance, uint32_t instanceCount = 1,
@@ -112,6 +122,31 @@ public:
     void SetGraphicsDynamicStructuredBuffer( uint32_t    slot, size_t numElements, size_t elementSize,
                                              const void* bufferData );
 
+    /**
+     * Allocate a structured buffer in upload memory and bind it like the overload above, returning its address so
+     * the elements can be written in place instead of copied. Aligned to 16 bytes and valid until the command
+     * list has executed.
+     */
+    void* SetGraphicsDynamicStructuredBuffer( uint32_t slot, size_t numElements, size_t elementSize );
+
+    /**
+     * Allocate upload memory valid until the command list has executed, to write once and bind as often as needed
+     * with the overload of SetGraphicsRootShaderResourceView below.
+     */
+    UploadBuffer::Allocation AllocateDynamicBuffer( size_t sizeInBytes, size_t alignment = 16 );
+
+    /**
+     * Bind a buffer in GPU memory to a root shader resource view, transitioning it to stateAfter first.
+     */
+    void SetGraphicsRootShaderResourceView( uint32_t              rootParameterIndex, const Buffer &buffer,
+                                            D3D12_RESOURCE_STATES stateAfter =
+                                                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE );
+
+    /**
+     * Bind upload memory, see AllocateDynamicBuffer, to a root shader resource view.
+     */
+    void SetGraphicsRootShaderResourceView( uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS address );
+
     /**
      * Set a set of 32-bit constants on the graphics pipeline.
      */
@@ -138,6 +173,23 @@ public:
 
     void SetPrimitiveTopology( D3D_PRIMITIVE_TOPOLOGY primitiveTopology ) const;
 
+    /**
+     * Copy numBytes of CPU data into buffer at offset, leaving the rest of the buffer untouched.
+     * Small writes are staged in the command list's upload buffer instead of a new upload resource.
+     */
+    void WriteBuffer( Buffer &buffer, size_t offset, const void* data, size_t numBytes );
+
+    /**
+     * Copy a width x height texel region of CPU data into subresource of texture at x, y, leaving the rest of
+     * the subresource untouched. data holds numRows rows of rowPitch bytes, rows of blocks for block compressed
+     * formats, whose regions must start and end on block boundaries.
+     */
+    void WriteTextureRegion( const Texture &texture, uint32_t subresource, uint32_t x, uint32_t y, uint32_t width,
+                             uint32_t       height, const void* data, size_t rowPitch, uint32_t numRows );
+
+    void CopyBufferRegion( Microsoft::WRL::ComPtr<ID3D12Resource> dstRes, size_t dstOffset,
+                           Microsoft::WRL::ComPtr<ID3D12Resource> srcRes, size_t srcOffset, size_t numBytes );
+
     void SetComputeRootSignature( const RootSignature &rootSignature );
 
     void BindDescriptorHeaps();
@@ -155,10 +207,66 @@ public:
     void ResolveSubresource( Resource &dstRes, const Resource &srcRes, uint32_t dstSubresource = 0,
                              uint32_t  srcSubresource = 0 );
 
+    /**
+     * Load an encoded image, sharing the texture with any other texture of the same content.
+     */
     void LoadEmbeddedTexture( Texture* texture, const uint8_t* imageData, size_t size, const std::wstring &textureName );
 
+    /**
+     * Key of a texture cached under its name, such as a file path.
+     */
+    static TextureCache::Key GetTextureNameKey( const std::wstring &textureName );
+
+    /**
+     * Key of a texture cached under its content, the encoded or cooked image bytes, so identical textures
+     * share one resource whichever model they come from.
+     */
+    static TextureCache::Key GetTextureContentKey( const void* data, size_t size, bool useSrgb );
+
+    /**
+     * Point texture at the texture cached under cacheKey, if it is still resident. Returns false if it is not.
+     * If another command list uploads the texture and has not finished, its upload is added to the ones this
+     * list's work has to wait for, see TakeSharedTextureUploads.
+     */
+    bool GetCachedTexture( Texture &texture, TextureCache::Key cacheKey, const std::wstring &textureName );
+
+    /**
+     * Create texture from decoded RGBA8 pixels and the mips built from them on the CPU, and upload the whole
+     * chain at once, unless cacheKey is already cached.
+     */
+    void LoadTextureFromImage( Texture &texture, const Assets::DecodedImage &image,
+                               const std::vector<Textures::MipLevel> &mips, TextureCache::Key cacheKey,
+                               const std::wstring &textureName, bool useSrgb );
+
+    /**
+     * Create texture in the cooked format and upload every cooked mip as is, unless cacheKey is already cached.
+     * The view is sRGB if the texture was cooked as sRGB or useSrgb is set.
+     */
+    void LoadCookedTexture( Texture &texture, const Assets::CookedTexture &cookedTexture, TextureCache::Key cacheKey,
+                            const std::wstring &textureName, bool useSrgb );
+
     void LoadTextureFromFile( Texture &texture, const std::wstring &fileName, bool useSrgb );
 
+    /**
+     * Uploads of other command lists that the textures this list took from the texture cache still wait for.
+     * Take them before executing the list and wait for them along with its own fence, see
+     * IsTextureUploadComplete.
+     */
+    std::vector<std::shared_ptr<TextureUpload>> TakeSharedTextureUploads() { return std::move(m_SharedTextureUploads); }
+
+    /**
+     * Publish the fence value the list was executed with to every texture it put in the texture cache.
+     * Called by the command queue.
+     */
+    void SetTextureUploadFence( uint64_t fenceValue );
+
+    static bool IsTextureUploadComplete( const TextureUpload &upload );
+
+    /**
+     * Format textures cooked in format are created in.
+     */
+    static DXGI_FORMAT GetCookedTextureFormat( Textures::TextureFormat format, bool useSrgb );
+
     std::shared_ptr<CommandList> GetGenerateMipsCommandList() const { return m_ComputeCommandList; }
 
     void GenerateMips( Texture &texture );
@@ -174,6 +282,15 @@ public:
     void SetIndexBuffer( const IndexBuffer &indexBuffer );
 
 private:
+    static void SetCachedTexture( Texture &texture, TextureCache::Handle handle, const std::wstring &textureName );
+
+    // Add the texture just created to the texture cache, under the renderer's budget. It is shared right away, so
+    // the entry carries this list's upload for other lists to wait for.
+    void AddCachedTexture( Texture &texture, TextureCache::Key cacheKey, const std::wstring &textureName );
+
+    // Point texture at a cached texture and wait for its upload if another list is still on it.
+    void ShareCachedTexture( Texture &texture, TextureCache::Handle handle, const std::wstring &textureName );
+
     std::unique_ptr<ResourceStateTracker>              m_ResourceStateTracker;
     std::unique_ptr<DynamicDescriptorHeap>             m_DynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
     std::unique_ptr<UploadBuffer>                      m_UploadBuffer;
@@ -181,11 +298,13 @@ private:
     ID3D12RootSignature*                               m_RootSignature;
     ID3D12DescriptorHeap*                              m_DynamicDescriptors[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
     D3D12_COMMAND_LIST_TYPE                            m_D3D12CommandListType;
+    // Upload of the textures this list added to the texture cache since it was last executed, and the pending
+    // uploads of other lists it shares textures from.
+    std::shared_ptr<TextureUpload>                     m_TextureUpload;
+    std::vector<std::shared_ptr<TextureUpload>>        m_SharedTextureUploads;
     Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> m_D3D12CommandList;
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator>     m_D3D12CommandAllocator;
     std::vector<Microsoft::WRL::ComPtr<ID3D12Object> > m_TrackedObjects;
-    static std::map<std::wstring, ID3D12Resource *>    ms_TextureCache;
-    static std::mutex                                  ms_TextureCacheMutex;
 };
 }
 
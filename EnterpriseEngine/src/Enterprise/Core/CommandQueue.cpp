@@ -98,14 +98,10 @@ std::shared_ptr<CommandList> CommandQueue::GetCommandList()
 {
     std::shared_ptr<CommandList> commandList;
 
-    // If there is a command list on the queue.
-    if ( !m_AvailableCommandLists.Empty() )
+    // Take a command list from the queue if there is one, otherwise create a new one.
+    // Loaders call this from other threads, so checking Empty() first could race with another TryPop.
+    if ( !m_AvailableCommandLists.TryPop(commandList) )
     {
-        m_AvailableCommandLists.TryPop(commandList);
-    }
-    else
-    {
-        // Otherwise create a new command list.
         commandList = std::make_shared<CommandList>(m_CommandListType);
     }
 
@@ -161,6 +157,10 @@ uint64_t CommandQueue::ExecuteCommandLists(const std::vector<std::shared_ptr<Com
     UINT numCommandLists = static_cast<UINT>(d3d12CommandLists.size());
     m_d3d12CommandQueue->ExecuteCommandLists(numCommandLists, d3d12CommandLists.data());
     uint64_t fenceValue = Signal();
+    for (const auto &commandList: commandLists)
+    {
+        commandList->SetTextureUploadFence(fenceValue);
+    }
 
     ResourceStateTracker::Unlock();
 
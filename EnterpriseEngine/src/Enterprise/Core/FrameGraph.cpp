@@ -0,0 +1,260 @@
+#include "FrameGraph.h"
+
+#include <algorithm>
+
+#include "CommandList.h"
+#include "Renderer.h"
+#include "ResourceStateTracker.h"
+
+
+namespace Enterprise::Core::Graphics {
+
+using Enterprise::RenderGraph::BarrierType;
+using Enterprise::RenderGraph::ResourceState;
+
+static_assert(uint32_t(ResourceState::RenderTarget) == D3D12_RESOURCE_STATE_RENDER_TARGET);
+static_assert(uint32_t(ResourceState::UnorderedAccess) == D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+static_assert(uint32_t(ResourceState::DepthWrite) == D3D12_RESOURCE_STATE_DEPTH_WRITE);
+static_assert(uint32_t(ResourceState::DepthRead) == D3D12_RESOURCE_STATE_DEPTH_READ);
+static_assert(uint32_t(ResourceState::NonPixelShaderResource) == D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+static_assert(uint32_t(ResourceState::PixelShaderResource) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+static_assert(uint32_t(ResourceState::IndirectArgument) == D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+static_assert(uint32_t(ResourceState::CopyDest) == D3D12_RESOURCE_STATE_COPY_DEST);
+static_assert(uint32_t(ResourceState::CopySource) == D3D12_RESOURCE_STATE_COPY_SOURCE);
+static_assert(uint32_t(ResourceState::ResolveDest) == D3D12_RESOURCE_STATE_RESOLVE_DEST);
+static_assert(uint32_t(ResourceState::ResolveSource) == D3D12_RESOURCE_STATE_RESOLVE_SOURCE);
+
+namespace {
+
+bool HasState( ResourceState states, ResourceState state )
+{
+    return (uint32_t(states) & uint32_t(state)) != 0;
+}
+
+}
+
+void FrameGraph::Reset()
+{
+    m_Graph.Reset();
+    m_Executes.clear();
+    m_Textures.clear();
+}
+
+FrameGraph::ResourceHandle FrameGraph::Import( const std::string &name, const Texture* texture, ResourceState state )
+{
+    m_Textures.push_back(texture);
+    return m_Graph.ImportResource(name, state);
+}
+
+FrameGraph::ResourceHandle FrameGraph::Create( const std::string &name,
+                                               const Enterprise::RenderGraph::TextureDesc &desc )
+{
+    // Filled in by CreateTransients once the graph knows how the texture is used.
+    m_Textures.push_back(nullptr);
+    return m_Graph.CreateTexture(name, desc);
+}
+
+void FrameGraph::Export( ResourceHandle resource, ResourceState finalState )
+{
+    m_Graph.ExportResource(resource, finalState);
+}
+
+Enterprise::RenderGraph::PassBuilder FrameGraph::AddPass( const std::string &name, ExecuteFunction execute )
+{
+    m_Executes.push_back(std::move(execute));
+    return m_Graph.AddPass(name);
+}
+
+bool FrameGraph::Execute( CommandList &commandList )
+{
+    if (!m_Graph.Compile())
+    {
+        return false;
+    }
+    CreateTransients();
+
+    // The state tracker knows the state each resource is in, so only the states after the barriers are passed on.
+    auto recordBarrier = [&]( const Enterprise::RenderGraph::Barrier &barrier ) {
+        const Texture &texture = *m_Textures[barrier.Resource];
+        if (barrier.Type == BarrierType::UnorderedAccess)
+        {
+            commandList.UAVBarrier(texture);
+        } else
+        {
+            commandList.TransitionBarrier(texture, static_cast<D3D12_RESOURCE_STATES>(barrier.After));
+        }
+    };
+
+    const auto &barriers = m_Graph.GetBarriers();
+    const auto &schedule = m_Graph.GetSchedule();
+    auto        aliasBarrier = m_AliasBarriers.begin();
+    for (uint32_t index = 0; index < schedule.size(); ++index)
+    {
+        const auto &scheduled = schedule[index];
+        for (; aliasBarrier != m_AliasBarriers.end() && aliasBarrier->Pass == index; ++aliasBarrier)
+        {
+            // Resources alike in the same memory share a pooled texture.
+            if (m_Textures[aliasBarrier->Before] != m_Textures[aliasBarrier->After])
+            {
+                commandList.AliasBarrier(*m_Textures[aliasBarrier->Before], *m_Textures[aliasBarrier->After]);
+            }
+        }
+        for (uint32_t i = 0; i < scheduled.NumBarriers; ++i)
+        {
+            recordBarrier(barriers[scheduled.FirstBarrier + i]);
+        }
+        commandList.FlushResourceBarriers();
+        if (m_Executes[scheduled.Pass])
+        {
+            m_Executes[scheduled.Pass](commandList, *this);
+        }
+    }
+    for (const auto &barrier: m_Graph.GetFinalBarriers())
+    {
+        recordBarrier(barrier);
+    }
+    commandList.FlushResourceBarriers();
+    return true;
+}
+
+template<typename Predicate>
+void FrameGraph::RetirePooledTextures( Predicate predicate, uint64_t frame )
+{
+    auto retired = std::partition(m_Pool.begin(), m_Pool.end(), [&]( const PooledTexture &pooled ) {
+        return !predicate(pooled);
+    });
+    for (auto pooled = retired; pooled != m_Pool.end(); ++pooled)
+    {
+        m_StaleTextures.emplace_back(frame, std::move(pooled->Allocation));
+    }
+    m_Pool.erase(retired, m_Pool.end());
+}
+
+void FrameGraph::CreateTransients()
+{
+    uint64_t frame = Renderer::GetFrameCount();
+    auto     device = Renderer::Get()->GetDevice();
+
+    for (auto &heap: m_Heaps)
+    {
+        heap.Allocator.Clear();
+        heap.Resources.clear();
+    }
+    m_TextureDescs.resize(m_Graph.GetNumResources());
+    for (ResourceHandle resource = 0; resource < m_Graph.GetNumResources(); ++resource)
+    {
+        const auto &lifetime = m_Graph.GetLifetime(resource);
+        if (m_Graph.IsImported(resource) || lifetime.FirstPass == Enterprise::RenderGraph::INVALID_PASS)
+        {
+            continue;
+        }
+
+        const auto &desc = m_Graph.GetTextureDesc(resource);
+        auto        textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(desc.Format), desc.Width,
+                                                                desc.Height, 1, static_cast<UINT16>(desc.MipLevels),
+                                                                desc.SampleCount);
+        if (HasState(lifetime.UsedStates, ResourceState::RenderTarget))
+        {
+            textureDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+        }
+        if (HasState(lifetime.UsedStates, ResourceState::DepthWrite | ResourceState::DepthRead))
+        {
+            textureDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+        }
+        if (HasState(lifetime.UsedStates, ResourceState::UnorderedAccess))
+        {
+            textureDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+        }
+        m_TextureDescs[resource] = textureDesc;
+
+        bool  renderTarget = (textureDesc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET |
+                                                   D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0;
+        auto &heap = m_Heaps[renderTarget ? RENDER_TARGET_HEAP : TEXTURE_HEAP];
+        auto  info = device->GetResourceAllocationInfo(0, 1, &textureDesc);
+        heap.Allocator.Add(info.SizeInBytes, info.Alignment, lifetime.FirstPass, lifetime.LastPass);
+        heap.Resources.push_back(resource);
+    }
+
+    m_AliasBarriers.clear();
+    for (uint32_t type = 0; type < NUM_HEAP_TYPES; ++type)
+    {
+        auto &   heap = m_Heaps[type];
+        uint64_t size = heap.Allocator.Allocate();
+        if (size > heap.Size)
+        {
+            // Every texture placed in the old heap goes with it.
+            if (heap.D3D12Heap)
+            {
+                m_StaleHeaps.emplace_back(frame, std::move(heap.D3D12Heap));
+            }
+            RetirePooledTextures([type]( const PooledTexture &pooled ) { return pooled.Heap == type; }, frame);
+
+            // Multisampled textures are aligned to 4MB, which is enough for anything else.
+            CD3DX12_HEAP_DESC heapDesc(size, D3D12_HEAP_TYPE_DEFAULT,
+                                       D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT,
+                                       type == RENDER_TARGET_HEAP ? D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES
+                                                                  : D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES);
+            heapDesc.SizeInBytes = (size + D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT - 1) &
+                                   ~uint64_t(D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT - 1);
+            ThrowIfFailed(device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap.D3D12Heap)));
+            heap.Size = heapDesc.SizeInBytes;
+        }
+
+        const auto &placements = heap.Allocator.GetPlacements();
+        for (uint32_t i = 0; i < placements.size(); ++i)
+        {
+            ResourceHandle resource = heap.Resources[i];
+            m_Textures[resource] = GetPooledTexture(static_cast<HeapType>(type), placements[i].Offset, resource,
+                                                    m_TextureDescs[resource], frame);
+            if (placements[i].Aliased != Enterprise::RenderGraph::TransientAllocator::NO_ALIAS)
+            {
+                m_AliasBarriers.push_back({m_Graph.GetLifetime(resource).FirstPass,
+                                           heap.Resources[placements[i].Aliased], resource});
+            }
+        }
+    }
+    std::sort(m_AliasBarriers.begin(), m_AliasBarriers.end(), []( const AliasBarrier &a, const AliasBarrier &b ) {
+        return a.Pass < b.Pass;
+    });
+
+    RetirePooledTextures([frame]( const PooledTexture &pooled ) {
+        return pooled.LastUsedFrame + POOL_FRAMES < frame;
+    }, frame);
+}
+
+const Texture* FrameGraph::GetPooledTexture( HeapType heap, uint64_t offset, ResourceHandle resource,
+                                             const D3D12_RESOURCE_DESC &textureDesc, uint64_t frame )
+{
+    const auto &desc = m_Graph.GetTextureDesc(resource);
+    for (auto &pooled: m_Pool)
+    {
+        if (pooled.Heap == heap && pooled.Offset == offset && pooled.Desc == desc && pooled.Flags == textureDesc.Flags)
+        {
+            pooled.LastUsedFrame = frame;
+            return pooled.Allocation.get();
+        }
+    }
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> d3d12Resource;
+    ThrowIfFailed(Renderer::Get()->GetDevice()->CreatePlacedResource(m_Heaps[heap].D3D12Heap.Get(), offset,
+                                                                      &textureDesc, D3D12_RESOURCE_STATE_COMMON,
+                                                                      nullptr, IID_PPV_ARGS(&d3d12Resource)));
+    ResourceStateTracker::AddGlobalResourceState(d3d12Resource.Get(), D3D12_RESOURCE_STATE_COMMON);
+
+    const auto &name = m_Graph.GetResourceName(resource);
+    m_Pool.push_back({heap, offset, desc, textureDesc.Flags,
+                      std::make_unique<Texture>(d3d12Resource, std::wstring(name.begin(), name.end())), frame});
+    return m_Pool.back().Allocation.get();
+}
+
+void FrameGraph::ReleaseStaleTextures( uint64_t frameNumber )
+{
+    m_StaleTextures.erase(std::remove_if(m_StaleTextures.begin(), m_StaleTextures.end(),
+                                         [frameNumber]( const auto &stale ) { return stale.first <= frameNumber; }),
+                          m_StaleTextures.end());
+    m_StaleHeaps.erase(std::remove_if(m_StaleHeaps.begin(), m_StaleHeaps.end(),
+                                      [frameNumber]( const auto &stale ) { return stale.first <= frameNumber; }),
+                       m_StaleHeaps.end());
+}
+
+}
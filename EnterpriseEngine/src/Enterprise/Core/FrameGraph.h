@@ -0,0 +1,138 @@
+#ifndef FRAMEGRAPH_H
+#define FRAMEGRAPH_H
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <wrl/client.h>
+
+#include "Resource.h"
+#include "../Core.h"
+#include "../RenderGraph/RenderGraph.h"
+#include "../RenderGraph/TransientAllocator.h"
+
+
+namespace Enterprise::Core::Graphics {
+class CommandList;
+
+/**
+ * Records a RenderGraph onto a command list. Passes are added with the function that records them, and Execute
+ * compiles the graph, creates the textures it needs, and records the scheduled passes with the barriers before
+ * each flushed as one batch.
+ * Textures the graph creates are placed resources in heaps the graph keeps. Every frame the textures are packed
+ * with a TransientAllocator, so those that are never used by the same passes share memory, and an aliasing barrier
+ * is recorded before a texture takes over the memory of another. Placed textures are pooled by description and
+ * offset, so a frame laid out like the one before it creates nothing; heaps only grow.
+ */
+class ENTERPRISE_API FrameGraph {
+public:
+    using ResourceHandle = Enterprise::RenderGraph::ResourceHandle;
+    using ResourceState = Enterprise::RenderGraph::ResourceState;
+    using ExecuteFunction = std::function<void( CommandList &, const FrameGraph & )>;
+
+    FrameGraph() = default;
+
+    FrameGraph( const FrameGraph &copy ) = delete;
+    FrameGraph &operator=( const FrameGraph &other ) = delete;
+
+    // Drop the passes and resources of the previous frame.
+    void Reset();
+
+    /**
+     * Add a texture that lives outside the graph. It must stay valid until Execute returns.
+     */
+    ResourceHandle Import( const std::string &name, const Texture* texture,
+                           ResourceState state = ResourceState::Unknown );
+
+    /**
+     * Add a texture the graph creates. It shares memory with textures used by other passes, so the first pass that
+     * writes it must overwrite all of it, by clearing it for instance.
+     */
+    ResourceHandle Create( const std::string &name, const Enterprise::RenderGraph::TextureDesc &desc );
+
+    void Export( ResourceHandle resource, ResourceState finalState );
+
+    /**
+     * Add a pass recorded by execute, which is not called when the pass is culled. Declare what it uses on the
+     * builder that is returned.
+     */
+    Enterprise::RenderGraph::PassBuilder AddPass( const std::string &name, ExecuteFunction execute );
+
+    /**
+     * Compile the graph and record it onto commandList. Returns false, recording nothing, when the graph does not
+     * compile.
+     */
+    bool Execute( CommandList &commandList );
+
+    // The texture behind a resource, for the passes to bind while they record.
+    [[nodiscard]] const Texture &GetTexture( ResourceHandle resource ) const { return *m_Textures[resource]; }
+
+    [[nodiscard]] const Enterprise::RenderGraph::RenderGraph &GetGraph() const { return m_Graph; }
+
+    /**
+     * Destroy the textures and heaps that were replaced up to the completed frame number.
+     */
+    void ReleaseStaleTextures( uint64_t frameNumber );
+
+private:
+    // Render targets and depth buffers need heaps of their own on resource heap tier 1.
+    enum HeapType {
+        RENDER_TARGET_HEAP,
+        TEXTURE_HEAP,
+        NUM_HEAP_TYPES
+    };
+
+    // Pooled textures that go unused for this many frames are released.
+    static constexpr uint64_t POOL_FRAMES = 64;
+
+    struct Heap {
+        Microsoft::WRL::ComPtr<ID3D12Heap>          D3D12Heap;
+        uint64_t                                    Size = 0;
+        Enterprise::RenderGraph::TransientAllocator Allocator;
+        // The graph resource of every resource added to Allocator this frame.
+        std::vector<ResourceHandle>                 Resources;
+    };
+
+    struct PooledTexture {
+        HeapType                             Heap;
+        uint64_t                             Offset;
+        Enterprise::RenderGraph::TextureDesc Desc;
+        D3D12_RESOURCE_FLAGS                 Flags;
+        std::unique_ptr<Texture>             Allocation;
+        uint64_t                             LastUsedFrame;
+    };
+
+    // Before the pass at index Pass of the schedule, After takes over the memory of Before.
+    struct AliasBarrier {
+        uint32_t       Pass;
+        ResourceHandle Before;
+        ResourceHandle After;
+    };
+
+    // Place the textures that scheduled passes use in the heaps, growing them when they do not fit.
+    void CreateTransients();
+
+    const Texture* GetPooledTexture( HeapType heap, uint64_t offset, ResourceHandle resource,
+                                     const D3D12_RESOURCE_DESC &textureDesc, uint64_t frame );
+
+    // Keep the pooled textures that predicate rejects, the others are released once the GPU is done with them.
+    template<typename Predicate>
+    void RetirePooledTextures( Predicate predicate, uint64_t frame );
+
+    Enterprise::RenderGraph::RenderGraph                       m_Graph;
+    // Per pass and per resource of the current frame.
+    std::vector<ExecuteFunction>                               m_Executes;
+    std::vector<const Texture*>                                m_Textures;
+    std::vector<AliasBarrier>                                  m_AliasBarriers;
+    std::vector<D3D12_RESOURCE_DESC>                           m_TextureDescs;
+    Heap                                                       m_Heaps[NUM_HEAP_TYPES];
+    std::vector<PooledTexture>                                 m_Pool;
+    // Replaced textures and heaps, and the frame they were last used in.
+    std::vector<std::pair<uint64_t, std::unique_ptr<Texture>>> m_StaleTextures;
+    std::vector<std::pair<uint64_t, Microsoft::WRL::ComPtr<ID3D12Heap>>> m_StaleHeaps;
+};
+
+}
+
+#endif //FRAMEGRAPH_H
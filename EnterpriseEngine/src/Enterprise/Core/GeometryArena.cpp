@@ -0,0 +1,513 @@
+#include "GeometryArena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+#include "CommandList.h"
+#include "CommandQueue.h"
+#include "ResourceStateTracker.h"
+#include "../Assets/ContentHash.h"
+
+
+namespace Enterprise::Core::Graphics {
+
+static uint32_t RemapOffset( const std::vector<OffsetAllocator::Move> &moves, uint32_t offset )
+{
+    // Moves are sorted by source offset, one per live allocation.
+    auto moveIter = std::lower_bound(moves.begin(), moves.end(), offset,
+                                     []( const OffsetAllocator::Move &move, uint32_t value )
+                                     {
+                                         return move.Source < value;
+                                     });
+    assert(moveIter != moves.end() && moveIter->Source == offset);
+    return moveIter->Destination;
+}
+
+GeometryArena::GeometryArena( size_t pageSize )
+    : m_PageSize(pageSize)
+{
+    for (size_t i = 0; i < size_t(Geometry::VertexFormat::NumFormats); ++i)
+    {
+        auto vertexFormat = static_cast<Geometry::VertexFormat>(i);
+        m_VertexPools[i].ElementSize = static_cast<uint32_t>(Geometry::GetVertexFormatStride(vertexFormat));
+        m_VertexPools[i].VertexFormat = vertexFormat;
+    }
+    m_IndexPool.ElementSize = sizeof(uint32_t);
+    m_IndexPool.Indices = true;
+}
+
+GeometryArena::Handle GeometryArena::Allocate( CommandList &commandList, Geometry::VertexFormat vertexFormat,
+                                               const void* vertices, size_t numVertices, const uint32_t* indices,
+                                               size_t numIndices, bool* shared )
+{
+    if (numVertices > UINT32_MAX || numIndices > UINT32_MAX)
+    {
+        throw std::bad_alloc();
+    }
+
+    size_t vertexBytes = numVertices * Geometry::GetVertexFormatStride(vertexFormat);
+    size_t indexBytes = numIndices * sizeof(uint32_t);
+
+    // Hashed before taking the lock, other threads keep allocating meanwhile.
+    Assets::ContentHasher hasher;
+    hasher.Add(vertexFormat);
+    hasher.Add(vertices, vertexBytes);
+    hasher.Add(indices, indexBytes);
+    uint64_t contentHash = hasher.GetHash();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (shared)
+    {
+        *shared = false;
+    }
+    // Geometry still uploading is only shared within the command list uploading it, which finishes with it.
+    const CommandList* uploadList = commandList.GetCommandListType() == D3D12_COMMAND_LIST_TYPE_COPY
+                                        ? &commandList
+                                        : nullptr;
+    auto sharedIter = m_SharedRanges.find(contentHash);
+    if (sharedIter != m_SharedRanges.end())
+    {
+        Handle       sharedHandle = sharedIter->second;
+        const Range &sharedRange = m_Ranges[sharedHandle];
+        const Page*  uploadingPage = FindUploadingPage(sharedRange);
+        if (sharedRange.VertexFormat == vertexFormat && sharedRange.NumVertices == numVertices &&
+            sharedRange.NumIndices == numIndices &&
+            (uploadingPage == nullptr || (uploadList != nullptr && uploadingPage->UploadList == uploadList)))
+        {
+            ++m_RefCounts[sharedHandle];
+            m_DeduplicatedBytes += vertexBytes + indexBytes;
+            if (shared)
+            {
+                *shared = true;
+            }
+            return sharedHandle;
+        }
+    }
+
+    Pool &vertexPool = m_VertexPools[size_t(vertexFormat)];
+
+    Range range{};
+    range.VertexFormat = vertexFormat;
+    range.NumVertices = static_cast<uint32_t>(numVertices);
+    range.NumIndices = static_cast<uint32_t>(numIndices);
+    range.BaseVertex = AllocateFromPool(commandList, vertexPool, range.NumVertices, &range.VertexPage);
+    range.StartIndex = AllocateFromPool(commandList, m_IndexPool, range.NumIndices, &range.IndexPage);
+
+    if (numVertices > 0)
+    {
+        commandList.WriteBuffer(*vertexPool.Pages[range.VertexPage].Storage,
+                                size_t(range.BaseVertex) * vertexPool.ElementSize, vertices, vertexBytes);
+    }
+    if (numIndices > 0)
+    {
+        commandList.WriteBuffer(*m_IndexPool.Pages[range.IndexPage].Storage,
+                                size_t(range.StartIndex) * m_IndexPool.ElementSize, indices, indexBytes);
+    }
+
+    Handle handle;
+    if (!m_FreeHandles.empty())
+    {
+        handle = m_FreeHandles.back();
+        m_FreeHandles.pop_back();
+        m_Ranges[handle] = range;
+        m_RefCounts[handle] = 1;
+        m_ContentHashes[handle] = contentHash;
+    } else
+    {
+        handle = static_cast<Handle>(m_Ranges.size());
+        m_Ranges.push_back(range);
+        m_RefCounts.push_back(1);
+        m_ContentHashes.push_back(contentHash);
+    }
+    m_SharedRanges[contentHash] = handle;
+    return handle;
+}
+
+uint64_t GeometryArena::CloseUploads( const CommandList &commandList )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    uint64_t batch = 0;
+    auto     closePool = [&]( Pool &pool )
+    {
+        for (auto &page: pool.Pages)
+        {
+            if (page.UploadList == &commandList)
+            {
+                if (batch == 0)
+                {
+                    batch = m_NextUploadBatch++;
+                }
+                page.UploadList = nullptr;
+                page.UploadBatch = batch;
+            }
+        }
+    };
+    for (auto &pool: m_VertexPools)
+    {
+        closePool(pool);
+    }
+    closePool(m_IndexPool);
+    return batch;
+}
+
+void GeometryArena::SubmitUploads( uint64_t batch, std::shared_ptr<CommandQueue> queue, uint64_t fenceValue )
+{
+    if (batch == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto submitPool = [&]( Pool &pool )
+    {
+        for (auto &page: pool.Pages)
+        {
+            if (page.UploadBatch == batch)
+            {
+                page.UploadQueue = queue;
+                page.UploadFence = fenceValue;
+            }
+        }
+    };
+    for (auto &pool: m_VertexPools)
+    {
+        submitPool(pool);
+    }
+    submitPool(m_IndexPool);
+}
+
+void GeometryArena::FinishUploads( CommandList &commandList )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto finishPool = [&commandList]( Pool &pool )
+    {
+        for (auto &page: pool.Pages)
+        {
+            if (!page.UploadQueue || !page.UploadQueue->IsFenceComplete(page.UploadFence))
+            {
+                continue;
+            }
+            page.UploadBatch = 0;
+            page.UploadQueue.reset();
+            if (!page.Storage)
+            {
+                continue;
+            }
+
+            // Buffers decay to the common state once the copy queue is done with them.
+            auto d3d12Resource = page.Storage->GetD3D12Resource();
+            ResourceStateTracker::AddGlobalResourceState(d3d12Resource.Get(), D3D12_RESOURCE_STATE_COMMON);
+            commandList.TransitionBarrier(d3d12Resource, pool.Indices
+                                                             ? D3D12_RESOURCE_STATE_INDEX_BUFFER
+                                                             : D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+        }
+    };
+    for (auto &pool: m_VertexPools)
+    {
+        finishPool(pool);
+    }
+    finishPool(m_IndexPool);
+}
+
+bool GeometryArena::IsReady( Handle handle ) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return FindUploadingPage(m_Ranges[handle]) == nullptr;
+}
+
+void GeometryArena::Free( Handle handle, uint64_t frameNumber )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_StaleAllocations.emplace(handle, frameNumber);
+}
+
+void GeometryArena::ReleaseStaleAllocations( uint64_t frameNumber )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    bool released = false;
+    while (!m_StaleAllocations.empty() && m_StaleAllocations.front().FrameNumber <= frameNumber)
+    {
+        FreeRange(m_StaleAllocations.front().Allocation);
+        m_StaleAllocations.pop();
+        released = true;
+    }
+
+    if (!released)
+    {
+        return;
+    }
+
+    // Drop pages nothing lives in anymore, the command lists that used them keep the buffers alive.
+    // A copy list may still be recording into an empty page.
+    auto releaseEmptyPages = []( Pool &pool )
+    {
+        for (auto &page: pool.Pages)
+        {
+            if (page.Storage && page.Allocator.GetNumAllocations() == 0 && page.UploadList == nullptr)
+            {
+                page = Page{};
+            }
+        }
+    };
+    for (auto &pool: m_VertexPools)
+    {
+        releaseEmptyPages(pool);
+    }
+    releaseEmptyPages(m_IndexPool);
+}
+
+bool GeometryArena::Defragment( CommandList &commandList, float minFragmentation )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto isUploading = []( const Pool &pool )
+    {
+        return std::any_of(pool.Pages.begin(), pool.Pages.end(), []( const Page &page ) { return page.IsUploading(); });
+    };
+    if (isUploading(m_IndexPool) || std::any_of(std::begin(m_VertexPools), std::end(m_VertexPools), isUploading))
+    {
+        return false;
+    }
+
+    for (auto &pool: m_VertexPools)
+    {
+        DefragmentPool(commandList, pool, minFragmentation);
+    }
+    DefragmentPool(commandList, m_IndexPool, minFragmentation);
+    return true;
+}
+
+GeometryArena::Range GeometryArena::GetRange( Handle handle ) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return m_Ranges[handle];
+}
+
+std::shared_ptr<VertexBuffer> GeometryArena::GetVertexBuffer( const Range &range ) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    const Pool &pool = m_VertexPools[size_t(range.VertexFormat)];
+    return std::static_pointer_cast<VertexBuffer>(pool.Pages[range.VertexPage].Storage);
+}
+
+std::shared_ptr<IndexBuffer> GeometryArena::GetIndexBuffer( const Range &range ) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return std::static_pointer_cast<IndexBuffer>(m_IndexPool.Pages[range.IndexPage].Storage);
+}
+
+size_t GeometryArena::GetUsedBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    size_t usedBytes = 0;
+    auto   addPool = [&usedBytes]( const Pool &pool )
+    {
+        for (const auto &page: pool.Pages)
+        {
+            usedBytes += size_t(page.Allocator.GetUsedSize()) * pool.ElementSize;
+        }
+    };
+    for (const auto &pool: m_VertexPools)
+    {
+        addPool(pool);
+    }
+    addPool(m_IndexPool);
+    return usedBytes;
+}
+
+size_t GeometryArena::GetDeduplicatedBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return m_DeduplicatedBytes;
+}
+
+size_t GeometryArena::GetCapacityBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    size_t capacityBytes = 0;
+    auto   addPool = [&capacityBytes]( const Pool &pool )
+    {
+        for (const auto &page: pool.Pages)
+        {
+            capacityBytes += size_t(page.Allocator.GetSize()) * pool.ElementSize;
+        }
+    };
+    for (const auto &pool: m_VertexPools)
+    {
+        addPool(pool);
+    }
+    addPool(m_IndexPool);
+    return capacityBytes;
+}
+
+uint32_t GeometryArena::AllocateFromPool( CommandList &commandList, Pool &pool, uint32_t numElements, uint32_t* page )
+{
+    *page = 0;
+    if (numElements == 0)
+    {
+        return 0;
+    }
+
+    // Copy lists only fill the pages they created, and nothing else allocates from those until they are ready.
+    const CommandList* uploadList = commandList.GetCommandListType() == D3D12_COMMAND_LIST_TYPE_COPY
+                                        ? &commandList
+                                        : nullptr;
+    for (uint32_t i = 0; i < pool.Pages.size(); ++i)
+    {
+        if (pool.Pages[i].UploadList != uploadList || pool.Pages[i].UploadBatch != 0)
+        {
+            continue;
+        }
+        OffsetAllocator::OffsetType offset = pool.Pages[i].Allocator.Allocate(numElements);
+        if (offset != OffsetAllocator::INVALID_OFFSET)
+        {
+            *page = i;
+            return offset;
+        }
+    }
+
+    // No page has room, start a new one, reusing the slot of a released page if there is one.
+    uint64_t pageElements = std::max<uint64_t>(m_PageSize / pool.ElementSize, numElements);
+    pageElements = std::min<uint64_t>(pageElements, OffsetAllocator::INVALID_OFFSET - 1);
+
+    auto pageIter = std::find_if(pool.Pages.begin(), pool.Pages.end(),
+                                 []( const Page &existing ) { return !existing.Storage; });
+    if (pageIter == pool.Pages.end())
+    {
+        pageIter = pool.Pages.insert(pool.Pages.end(), Page{});
+    }
+    pageIter->Storage = CreatePageBuffer(commandList, pool, static_cast<uint32_t>(pageElements), nullptr, {});
+    pageIter->Allocator = OffsetAllocator(static_cast<uint32_t>(pageElements));
+    pageIter->UploadList = uploadList;
+
+    *page = static_cast<uint32_t>(pageIter - pool.Pages.begin());
+    return pageIter->Allocator.Allocate(numElements);
+}
+
+std::shared_ptr<Buffer> GeometryArena::CreatePageBuffer( CommandList &commandList, const Pool &pool,
+                                                         uint32_t numElements, const std::shared_ptr<Buffer> &previous,
+                                                         const std::vector<OffsetAllocator::Move> &moves )
+{
+    std::shared_ptr<Buffer> buffer;
+    if (pool.Indices)
+    {
+        buffer = std::make_shared<IndexBuffer>(L"Geometry Arena Indices");
+    } else
+    {
+        buffer = std::make_shared<VertexBuffer>(L"Geometry Arena Vertices");
+    }
+    commandList.CopyBuffer(*buffer, numElements, pool.ElementSize, nullptr);
+
+    // Copy runs of allocations that stay contiguous with a single copy each.
+    for (size_t i = 0; i < moves.size();)
+    {
+        const auto &move = moves[i];
+        uint64_t    size = move.Size;
+        size_t      j = i + 1;
+        while (j < moves.size() && moves[j].Source == move.Source + size && moves[j].Destination == move.Destination + size)
+        {
+            size += moves[j].Size;
+            ++j;
+        }
+
+        commandList.CopyBufferRegion(buffer->GetD3D12Resource(), size_t(move.Destination) * pool.ElementSize,
+                                     previous->GetD3D12Resource(), size_t(move.Source) * pool.ElementSize,
+                                     size * pool.ElementSize);
+        i = j;
+    }
+
+    return buffer;
+}
+
+void GeometryArena::DefragmentPool( CommandList &commandList, Pool &pool, float minFragmentation )
+{
+    for (uint32_t pageIndex = 0; pageIndex < pool.Pages.size(); ++pageIndex)
+    {
+        Page &page = pool.Pages[pageIndex];
+        if (!page.Storage || page.Allocator.GetFragmentation() <= minFragmentation)
+        {
+            continue;
+        }
+
+        auto moves = page.Allocator.Defragment();
+        page.Storage = CreatePageBuffer(commandList, pool, page.Allocator.GetSize(), page.Storage, moves);
+
+        for (auto &range: m_Ranges)
+        {
+            if (pool.Indices)
+            {
+                if (range.NumIndices > 0 && range.IndexPage == pageIndex)
+                {
+                    range.StartIndex = RemapOffset(moves, range.StartIndex);
+                }
+            } else if (range.NumVertices > 0 && range.VertexFormat == pool.VertexFormat && range.VertexPage == pageIndex)
+            {
+                range.BaseVertex = RemapOffset(moves, range.BaseVertex);
+            }
+        }
+    }
+}
+
+const GeometryArena::Page* GeometryArena::FindUploadingPage( const Range &range ) const
+{
+    if (range.NumVertices > 0)
+    {
+        const Page &page = m_VertexPools[size_t(range.VertexFormat)].Pages[range.VertexPage];
+        if (page.IsUploading())
+        {
+            return &page;
+        }
+    }
+    if (range.NumIndices > 0)
+    {
+        const Page &page = m_IndexPool.Pages[range.IndexPage];
+        if (page.IsUploading())
+        {
+            return &page;
+        }
+    }
+    return nullptr;
+}
+
+void GeometryArena::FreeRange( Handle handle )
+{
+    if (--m_RefCounts[handle] > 0)
+    {
+        return;
+    }
+
+    auto sharedIter = m_SharedRanges.find(m_ContentHashes[handle]);
+    if (sharedIter != m_SharedRanges.end() && sharedIter->second == handle)
+    {
+        m_SharedRanges.erase(sharedIter);
+    }
+
+    Range &range = m_Ranges[handle];
+    if (range.NumVertices > 0)
+    {
+        m_VertexPools[size_t(range.VertexFormat)].Pages[range.VertexPage].Allocator.Free(range.BaseVertex);
+    }
+    if (range.NumIndices > 0)
+    {
+        m_IndexPool.Pages[range.IndexPage].Allocator.Free(range.StartIndex);
+    }
+
+    range = {};
+    m_FreeHandles.push_back(handle);
+}
+
+}
@@ -0,0 +1,182 @@
+#ifndef GEOMETRYARENA_H
+#define GEOMETRYARENA_H
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "IndexBuffer.h"
+#include "OffsetAllocator.h"
+#include "VertexBuffer.h"
+#include "../Core.h"
+#include "../Geometry/VertexQuantization.h"
+
+
+namespace Enterprise::Core::Graphics {
+class CommandList;
+class CommandQueue;
+
+/**
+ * Shared GPU storage for mesh geometry. Vertices live in large vertex buffer pages per vertex format and indices
+ * in large index buffer pages, each sub-allocated with an OffsetAllocator, so loading a model creates a handful
+ * of resources instead of two per mesh. Meshes draw their range with a base vertex and start index.
+ * Full pools get a new page rather than a bigger buffer, so existing ranges never move while their
+ * uploads may still be in flight on another queue.
+ * A copy queue cannot transition buffers to the vertex and index buffer states, nor write to pages the direct
+ * queue is drawing from, so copy lists upload into pages of their own. Those pages join the rest of the arena
+ * once their upload fence completes, when FinishUploads transitions them on the direct queue.
+ * Identical geometry, by a hash of its vertex and index bytes, is stored once and shared by every mesh that
+ * allocates it, whichever model it belongs to.
+ */
+class ENTERPRISE_API GeometryArena {
+public:
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = UINT32_MAX;
+
+    struct Range {
+        Geometry::VertexFormat VertexFormat;
+        uint32_t               VertexPage;
+        uint32_t               BaseVertex;
+        uint32_t               NumVertices;
+        uint32_t               IndexPage;
+        uint32_t               StartIndex;
+        uint32_t               NumIndices;
+    };
+
+    // Pages hold pageSize bytes, or a single allocation that is larger.
+    explicit GeometryArena( size_t pageSize = 32 * 1024 * 1024 );
+
+    GeometryArena( const GeometryArena &copy ) = delete;
+    GeometryArena &operator=( const GeometryArena &other ) = delete;
+
+    /**
+     * Allocate room for a mesh and record the upload of its data on commandList.
+     * The vertices must already be in vertexFormat. The range may not be drawn before IsReady says so.
+     * A copy list must be followed by CloseUploads and SubmitUploads around its execution.
+     * If the same geometry is already in the arena, its handle is returned with another reference, nothing is
+     * uploaded and shared is set. Its upload was recorded by whichever command list allocated it first.
+     */
+    Handle Allocate( CommandList &    commandList, Geometry::VertexFormat vertexFormat, const void* vertices,
+                     size_t           numVertices, const uint32_t* indices, size_t numIndices, bool* shared = nullptr );
+
+    /**
+     * Detach the pages commandList uploaded into from it, before it is executed and its command list can be reused.
+     * Returns the batch to pass to SubmitUploads, 0 if commandList uploaded nothing.
+     */
+    uint64_t CloseUploads( const CommandList &commandList );
+
+    /**
+     * Mark the pages of batch as uploading until fenceValue completes on queue.
+     * Call once the command list is executed, whether or not its loads succeeded.
+     */
+    void SubmitUploads( uint64_t batch, std::shared_ptr<CommandQueue> queue, uint64_t fenceValue );
+
+    /**
+     * Transition the pages whose uploads have completed on the copy queue to their read state on commandList,
+     * a direct list, and let every command list allocate from them. Call before drawing.
+     */
+    void FinishUploads( CommandList &commandList );
+
+    // Whether the geometry of handle has finished uploading, including FinishUploads, and can be drawn.
+    [[nodiscard]] bool IsReady( Handle handle ) const;
+
+    /**
+     * Release a reference to an allocation once frameNumber has finished on the GPU, see ReleaseStaleAllocations.
+     */
+    void Free( Handle handle, uint64_t frameNumber );
+
+    /**
+     * Return the allocations freed up to the completed frame number to the pools and release empty pages.
+     */
+    void ReleaseStaleAllocations( uint64_t frameNumber );
+
+    /**
+     * Compact every page whose free space is more fragmented than minFragmentation into a new buffer.
+     * Frames in flight keep reading the old buffer, which the command lists hold on to until they finish.
+     * Returns false without moving anything while uploads on another queue are outstanding, since their data
+     * would be copied before it arrives.
+     */
+    bool Defragment( CommandList &commandList, float minFragmentation = 0.5f );
+
+    [[nodiscard]] Range GetRange( Handle handle ) const;
+
+    [[nodiscard]] std::shared_ptr<VertexBuffer> GetVertexBuffer( const Range &range ) const;
+
+    [[nodiscard]] std::shared_ptr<IndexBuffer> GetIndexBuffer( const Range &range ) const;
+
+    [[nodiscard]] size_t GetUsedBytes() const;
+
+    [[nodiscard]] size_t GetCapacityBytes() const;
+
+    // Bytes of geometry that were shared rather than uploaded again, since the arena was created.
+    [[nodiscard]] size_t GetDeduplicatedBytes() const;
+
+private:
+    struct Page {
+        std::shared_ptr<Buffer>       Storage;
+        OffsetAllocator               Allocator;
+        // The copy list filling the page, until CloseUploads moves it to a batch. The batch stays set until
+        // FinishUploads sees UploadFence complete on UploadQueue.
+        const CommandList*            UploadList = nullptr;
+        uint64_t                      UploadBatch = 0;
+        std::shared_ptr<CommandQueue> UploadQueue;
+        uint64_t                      UploadFence = 0;
+
+        [[nodiscard]] bool IsUploading() const { return UploadList != nullptr || UploadBatch != 0; }
+    };
+
+    struct Pool {
+        // Released pages keep their slot, with no storage, so page indices stay valid.
+        std::vector<Page>      Pages;
+        uint32_t               ElementSize = 0;
+        bool                   Indices = false;
+        // Format of the vertices in a vertex pool.
+        Geometry::VertexFormat VertexFormat = Geometry::VertexFormat::Float;
+    };
+
+    // Returns the offset in elements and the page in page.
+    uint32_t AllocateFromPool( CommandList &commandList, Pool &pool, uint32_t numElements, uint32_t* page );
+
+    // Create a buffer for numElements elements of the pool, copying the given ranges of previous.
+    std::shared_ptr<Buffer> CreatePageBuffer( CommandList &                            commandList, const Pool &pool,
+                                              uint32_t                                 numElements,
+                                              const std::shared_ptr<Buffer> &          previous,
+                                              const std::vector<OffsetAllocator::Move> &moves );
+
+    void DefragmentPool( CommandList &commandList, Pool &pool, float minFragmentation );
+
+    // The page of range that is still uploading, or nullptr.
+    [[nodiscard]] const Page* FindUploadingPage( const Range &range ) const;
+
+    void FreeRange( Handle handle );
+
+    struct StaleAllocationInfo {
+        StaleAllocationInfo( Handle handle, uint64_t frameNumber )
+            : Allocation(handle)
+            , FrameNumber(frameNumber)
+        {}
+
+        Handle   Allocation;
+        uint64_t FrameNumber;
+    };
+
+    Pool                                 m_VertexPools[size_t(Geometry::VertexFormat::NumFormats)];
+    Pool                                 m_IndexPool;
+    std::vector<Range>                   m_Ranges;
+    // Per handle, the number of meshes sharing it and the hash of its content.
+    std::vector<uint32_t>                m_RefCounts;
+    std::vector<uint64_t>                m_ContentHashes;
+    std::unordered_map<uint64_t, Handle> m_SharedRanges;
+    size_t                               m_DeduplicatedBytes = 0;
+    uint64_t                             m_NextUploadBatch = 1;
+    std::vector<Handle>                  m_FreeHandles;
+    std::queue<StaleAllocationInfo>      m_StaleAllocations;
+    size_t                               m_PageSize;
+    mutable std::mutex                   m_Mutex;
+};
+
+}
+
+#endif //GEOMETRYARENA_H
@@ -0,0 +1,259 @@
+#include "GpuMemoryAllocator.h"
+
+#include <atomic>
+
+#include "Renderer.h"
+#include "directx/d3dx12.h"
+
+
+namespace Enterprise::Core::Graphics {
+
+namespace {
+
+// Private data of placed resources, holding the Releaser of their memory.
+constexpr GUID RELEASER_GUID = {0x6b2f4c1e, 0x8d3a, 0x4e57, {0x9a, 0x61, 0x2c, 0x7e, 0x10, 0xb4, 0x53, 0xd8}};
+
+int GetHeapIndex( D3D12_HEAP_TYPE heapType )
+{
+    switch (heapType)
+    {
+        case D3D12_HEAP_TYPE_DEFAULT:
+            return 0;
+        case D3D12_HEAP_TYPE_UPLOAD:
+            return 1;
+        case D3D12_HEAP_TYPE_READBACK:
+            return 2;
+        default:
+            return -1;
+    }
+}
+
+}
+
+/**
+ * Returns the memory of a resource to the allocator when the resource releases its private data, on its
+ * destruction. Keeps the allocator alive until then.
+ */
+class GpuMemoryAllocator::Releaser final : public IUnknown {
+public:
+    Releaser( std::shared_ptr<GpuMemoryAllocator> allocator, Pool* pool, Heap* heap,
+              TlsfAllocator::BlockHandle block, uint64_t size, uint64_t wasted )
+        : m_Allocator(std::move(allocator))
+        , m_Pool(pool)
+        , m_Heap(heap)
+        , m_Block(block)
+        , m_Size(size)
+        , m_Wasted(wasted)
+    {}
+
+    HRESULT STDMETHODCALLTYPE QueryInterface( REFIID riid, void** object ) override
+    {
+        if (riid == __uuidof(IUnknown))
+        {
+            *object = static_cast<IUnknown *>(this);
+            AddRef();
+            return S_OK;
+        }
+        *object = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++m_RefCount; }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        ULONG refCount = --m_RefCount;
+        if (refCount == 0)
+        {
+            m_Allocator->Free(m_Pool, m_Heap, m_Block, m_Size, m_Wasted);
+            delete this;
+        }
+        return refCount;
+    }
+
+private:
+    std::atomic<ULONG>                  m_RefCount = 1;
+    std::shared_ptr<GpuMemoryAllocator> m_Allocator;
+    // Null for committed resources.
+    Pool*                               m_Pool;
+    Heap*                               m_Heap;
+    TlsfAllocator::BlockHandle          m_Block;
+    uint64_t                            m_Size;
+    uint64_t                            m_Wasted;
+};
+
+GpuMemoryAllocator::GpuMemoryAllocator( uint64_t heapSize )
+    : m_HeapSize(heapSize)
+{
+}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> GpuMemoryAllocator::CreateResource( const D3D12_RESOURCE_DESC &resourceDesc,
+                                                                           D3D12_HEAP_TYPE heapType,
+                                                                           D3D12_RESOURCE_STATES initialState,
+                                                                           const D3D12_CLEAR_VALUE* clearValue )
+{
+    auto device = Renderer::Get()->GetDevice();
+
+    ResourceKind kind = TEXTURE_KIND;
+    if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        kind = BUFFER_KIND;
+    } else if (resourceDesc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+    {
+        kind = RENDER_TARGET_KIND;
+    }
+
+    // Small textures may be placed at 4KB, which the device only allows for some of them.
+    D3D12_RESOURCE_DESC            desc = resourceDesc;
+    D3D12_RESOURCE_ALLOCATION_INFO info;
+    if (kind == TEXTURE_KIND && desc.Alignment == 0 && desc.SampleDesc.Count == 1)
+    {
+        desc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        info = device->GetResourceAllocationInfo(0, 1, &desc);
+        if (info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+        {
+            desc.Alignment = 0;
+            info = device->GetResourceAllocationInfo(0, 1, &desc);
+        }
+    } else
+    {
+        info = device->GetResourceAllocationInfo(0, 1, &desc);
+    }
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+    int                                    heapIndex = GetHeapIndex(heapType);
+    if (heapIndex < 0 || (kind != BUFFER_KIND && heapType != D3D12_HEAP_TYPE_DEFAULT) ||
+        info.SizeInBytes > m_HeapSize / 4)
+    {
+        ThrowIfFailed(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(heapType), D3D12_HEAP_FLAG_NONE,
+                                                      &resourceDesc, initialState, clearValue,
+                                                      IID_PPV_ARGS(&resource)));
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            ++m_NumCommittedResources;
+            m_CommittedSize += info.SizeInBytes;
+        }
+        auto* releaser = new Releaser(shared_from_this(), nullptr, nullptr, TlsfAllocator::INVALID_BLOCK,
+                                      info.SizeInBytes, 0);
+        resource->SetPrivateDataInterface(RELEASER_GUID, releaser);
+        releaser->Release();
+        return resource;
+    }
+
+    Pool &                    pool = m_Pools[heapIndex][kind];
+    Heap*                     heap = nullptr;
+    TlsfAllocator::Allocation allocation;
+    uint64_t                  wasted;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        for (auto &candidate: pool.Heaps)
+        {
+            allocation = candidate->Allocator.Allocate(info.SizeInBytes, info.Alignment);
+            if (allocation.Block != TlsfAllocator::INVALID_BLOCK)
+            {
+                heap = candidate.get();
+                break;
+            }
+        }
+        if (!heap)
+        {
+            static const D3D12_HEAP_FLAGS heapFlags[NUM_RESOURCE_KINDS] = {
+                D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+                D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+                D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES
+            };
+            // Multisampled render targets need 4MB alignment, everything else fits in 64KB and smaller blocks.
+            uint64_t heapAlignment = kind == RENDER_TARGET_KIND ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT
+                                                                : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+            uint64_t granularity = kind == TEXTURE_KIND ? D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT
+                                                        : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+            auto              newHeap = std::make_unique<Heap>();
+            CD3DX12_HEAP_DESC heapDesc(m_HeapSize, heapType, heapAlignment, heapFlags[kind]);
+            ThrowIfFailed(device->CreateHeap(&heapDesc, IID_PPV_ARGS(&newHeap->D3D12Heap)));
+            newHeap->Allocator = TlsfAllocator(m_HeapSize, granularity);
+            allocation = newHeap->Allocator.Allocate(info.SizeInBytes, info.Alignment);
+            heap = newHeap.get();
+            pool.Heaps.push_back(std::move(newHeap));
+        }
+
+        HRESULT result = device->CreatePlacedResource(heap->D3D12Heap.Get(), allocation.Offset, &desc,
+                                                      initialState, clearValue, IID_PPV_ARGS(&resource));
+        if (FAILED(result))
+        {
+            heap->Allocator.Free(allocation.Block);
+            ThrowIfFailed(result);
+        }
+
+        wasted = allocation.Size - info.SizeInBytes;
+        m_UsedSize += info.SizeInBytes;
+        m_WastedSize += wasted;
+        ++m_NumPlacedResources;
+    }
+
+    auto* releaser = new Releaser(shared_from_this(), &pool, heap, allocation.Block, info.SizeInBytes, wasted);
+    resource->SetPrivateDataInterface(RELEASER_GUID, releaser);
+    releaser->Release();
+    return resource;
+}
+
+GpuMemoryAllocator::Statistics GpuMemoryAllocator::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    Statistics statistics = {};
+    float      fragmentation = 0.0f;
+    for (const auto &pools: m_Pools)
+    {
+        for (const auto &pool: pools)
+        {
+            for (const auto &heap: pool.Heaps)
+            {
+                ++statistics.NumHeaps;
+                statistics.HeapSize += heap->Allocator.GetSize();
+                fragmentation += heap->Allocator.GetFragmentation();
+            }
+        }
+    }
+    statistics.UsedSize = m_UsedSize;
+    statistics.WastedSize = m_WastedSize;
+    statistics.NumPlacedResources = m_NumPlacedResources;
+    statistics.NumCommittedResources = m_NumCommittedResources;
+    statistics.CommittedSize = m_CommittedSize;
+    statistics.Fragmentation = statistics.NumHeaps > 0 ? fragmentation / statistics.NumHeaps : 0.0f;
+    return statistics;
+}
+
+void GpuMemoryAllocator::Free( Pool* pool, Heap* heap, TlsfAllocator::BlockHandle block, uint64_t size,
+                               uint64_t wasted )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (!pool)
+    {
+        --m_NumCommittedResources;
+        m_CommittedSize -= size;
+        return;
+    }
+
+    heap->Allocator.Free(block);
+    m_UsedSize -= size;
+    m_WastedSize -= wasted;
+    --m_NumPlacedResources;
+
+    // One empty heap stays, so a pool that empties and fills again every frame does not recreate it.
+    if (heap->Allocator.GetNumAllocations() == 0 && pool->Heaps.size() > 1)
+    {
+        for (auto iter = pool->Heaps.begin(); iter != pool->Heaps.end(); ++iter)
+        {
+            if (iter->get() == heap)
+            {
+                pool->Heaps.erase(iter);
+                break;
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,92 @@
+#ifndef GPUMEMORYALLOCATOR_H
+#define GPUMEMORYALLOCATOR_H
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <wrl/client.h>
+
+#include "TlsfAllocator.h"
+#include "../Core.h"
+#include "directx/d3d12.h"
+
+
+namespace Enterprise::Core::Graphics {
+
+/**
+ * Creates resources as placed resources in large heaps rather than as committed resources, so most resources
+ * cost a sub-allocation instead of a kernel allocation. Heaps are kept per heap type and per kind of resource:
+ * buffers, textures, and render target or depth textures, as resource heap tier 1 requires. Each heap is split
+ * with a TlsfAllocator. Textures up to 64KB use the 4KB small resource alignment rather than 64KB.
+ * Resources larger than a quarter of a heap are still committed.
+ * The memory of a placed resource is returned when the last reference to its ID3D12Resource goes, which is after
+ * the command lists using it have completed. Thread safe.
+ */
+class ENTERPRISE_API GpuMemoryAllocator : public std::enable_shared_from_this<GpuMemoryAllocator> {
+public:
+    struct Statistics {
+        uint32_t NumHeaps;
+        // Bytes of all heaps, of the resources placed in them, and lost to rounding and alignment padding.
+        uint64_t HeapSize;
+        uint64_t UsedSize;
+        uint64_t WastedSize;
+        uint32_t NumPlacedResources;
+        // Resources too large or of a kind that is not placed.
+        uint32_t NumCommittedResources;
+        uint64_t CommittedSize;
+        // Share of the free heap space that is not in the largest free block of its heap, averaged over heaps.
+        float    Fragmentation;
+    };
+
+    explicit GpuMemoryAllocator( uint64_t heapSize = 64 * 1024 * 1024 );
+
+    GpuMemoryAllocator( const GpuMemoryAllocator &copy ) = delete;
+    GpuMemoryAllocator &operator=( const GpuMemoryAllocator &other ) = delete;
+
+    /**
+     * Create a resource in a heap of heapType, in the same way as CreateCommittedResource.
+     */
+    Microsoft::WRL::ComPtr<ID3D12Resource> CreateResource( const D3D12_RESOURCE_DESC &resourceDesc,
+                                                           D3D12_HEAP_TYPE heapType,
+                                                           D3D12_RESOURCE_STATES initialState,
+                                                           const D3D12_CLEAR_VALUE* clearValue = nullptr );
+
+    [[nodiscard]] Statistics GetStatistics() const;
+
+private:
+    enum ResourceKind {
+        BUFFER_KIND,
+        TEXTURE_KIND,
+        RENDER_TARGET_KIND,
+        NUM_RESOURCE_KINDS
+    };
+
+    static constexpr uint32_t NUM_HEAP_TYPES = 3;
+
+    struct Heap {
+        Microsoft::WRL::ComPtr<ID3D12Heap> D3D12Heap;
+        TlsfAllocator                      Allocator;
+    };
+
+    struct Pool {
+        std::vector<std::unique_ptr<Heap>> Heaps;
+    };
+
+    class Releaser;
+
+    // Return the memory of a placed resource, releasing heaps that are left empty but the last of their pool.
+    void Free( Pool* pool, Heap* heap, TlsfAllocator::BlockHandle block, uint64_t size, uint64_t wasted );
+
+    uint64_t           m_HeapSize;
+    Pool               m_Pools[NUM_HEAP_TYPES][NUM_RESOURCE_KINDS];
+    mutable std::mutex m_Mutex;
+    uint64_t           m_UsedSize = 0;
+    uint64_t           m_WastedSize = 0;
+    uint32_t           m_NumPlacedResources = 0;
+    uint32_t           m_NumCommittedResources = 0;
+    uint64_t           m_CommittedSize = 0;
+};
+
+}
+
+#endif //GPUMEMORYALLOCATOR_H
@@ -4,14 +4,45 @@
 
 #ifndef MATERIAL_H
 #define MATERIAL_H
+#include <cstdint>
+
 
 namespace Enterprise::Core {
 
+using MaterialHandle = uint32_t;
+constexpr MaterialHandle INVALID_MATERIAL = UINT32_MAX;
+
+// Texture index of a material without that texture, sampled as the table's default texture.
+constexpr uint32_t NO_TEXTURE = UINT32_MAX;
+
+enum MaterialPipelineFlags : uint32_t {
+    MATERIAL_PIPELINE_OPAQUE = 0,
+    // Pixels with an alpha below AlphaCutoff are clipped.
+    MATERIAL_PIPELINE_ALPHA_TEST = 1 << 0,
+    MATERIAL_PIPELINE_ALPHA_BLEND = 1 << 1,
+    MATERIAL_PIPELINE_DOUBLE_SIDED = 1 << 2,
+};
+
+/**
+ * A material as the shaders see it, one element of the material table's structured buffer.
+ * Matches struct Material in PixelShader.hlsl.
+ */
 struct Material {
-    std::string Name;
-    std::string TypeName;
-    std::string FilePath;
+    float    BaseColor[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    float    Emissive[3] = {0.0f, 0.0f, 0.0f};
+    float    Metallic = 0.0f;
+    float    Roughness = 1.0f;
+    float    AlphaCutoff = 0.5f;
+    // Indices into the material table's textures, see Graphics::MaterialTable::AddTexture.
+    uint32_t BaseColorTexture = NO_TEXTURE;
+    uint32_t NormalTexture = NO_TEXTURE;
+    uint32_t MetallicRoughnessTexture = NO_TEXTURE;
+    uint32_t EmissiveTexture = NO_TEXTURE;
+    // MaterialPipelineFlags, for picking the pipeline state a material is drawn with.
+    uint32_t PipelineKey = MATERIAL_PIPELINE_OPAQUE;
+    uint32_t Reserved = 0;
 };
+static_assert(sizeof(Material) == 64, "Material must match the shader layout");
 
 }
 
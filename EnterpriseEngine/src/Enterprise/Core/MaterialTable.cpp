@@ -0,0 +1,232 @@
+#include "MaterialTable.h"
+
+#include <algorithm>
+
+#include "CommandList.h"
+
+
+namespace Enterprise::Core::Graphics {
+
+MaterialTable::MaterialTable( uint32_t initialCapacity )
+    : m_Capacity(std::max(initialCapacity, 1u))
+{
+    m_Materials.emplace_back();
+    m_Dirty.push_back(false);
+}
+
+MaterialTable::Handle MaterialTable::Create( const Material &material )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    Handle handle;
+    if (!m_FreeHandles.empty())
+    {
+        handle = m_FreeHandles.back();
+        m_FreeHandles.pop_back();
+        m_Materials[handle] = material;
+    } else
+    {
+        handle = static_cast<Handle>(m_Materials.size());
+        m_Materials.push_back(material);
+        m_Dirty.push_back(false);
+    }
+    MarkDirty(handle);
+    return handle;
+}
+
+void MaterialTable::Update( Handle handle, const Material &material )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_Materials[handle] = material;
+    MarkDirty(handle);
+}
+
+Material MaterialTable::Get( Handle handle ) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return m_Materials[handle];
+}
+
+void MaterialTable::Free( Handle handle, uint64_t frameNumber )
+{
+    if (handle == DEFAULT_MATERIAL || handle == INVALID_MATERIAL)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_StaleEntries.emplace(handle, false, frameNumber);
+}
+
+void MaterialTable::ReleaseStaleMaterials( uint64_t frameNumber )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    while (!m_StaleEntries.empty() && m_StaleEntries.front().FrameNumber <= frameNumber)
+    {
+        const auto &entry = m_StaleEntries.front();
+        if (entry.IsTexture)
+        {
+            ReleaseTexture(entry.Index);
+        } else
+        {
+            ReleaseMaterial(entry.Index);
+        }
+        m_StaleEntries.pop();
+    }
+}
+
+uint32_t MaterialTable::AddTexture( const Texture &texture )
+{
+    if (!texture.IsValid())
+    {
+        return NO_TEXTURE;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto sharedIter = m_TextureIndices.find(texture.GetD3D12Resource().Get());
+    if (sharedIter != m_TextureIndices.end())
+    {
+        ++m_TextureRefCounts[sharedIter->second];
+        return sharedIter->second;
+    }
+
+    uint32_t index;
+    if (!m_FreeTextures.empty())
+    {
+        index = m_FreeTextures.back();
+        m_FreeTextures.pop_back();
+        m_Textures[index] = texture;
+        m_TextureRefCounts[index] = 1;
+    } else
+    {
+        index = static_cast<uint32_t>(m_Textures.size());
+        m_Textures.push_back(texture);
+        m_TextureRefCounts.push_back(1);
+    }
+    m_TextureIndices[texture.GetD3D12Resource().Get()] = index;
+    return index;
+}
+
+void MaterialTable::FreeTexture( uint32_t index, uint64_t frameNumber )
+{
+    if (index == NO_TEXTURE)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_StaleEntries.emplace(index, true, frameNumber);
+}
+
+void MaterialTable::SetDefaultTexture( const Texture &texture )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_DefaultTexture = texture;
+}
+
+const Texture &MaterialTable::GetTexture( uint32_t index ) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return index < m_Textures.size() && m_Textures[index].IsValid() ? m_Textures[index] : m_DefaultTexture;
+}
+
+const Texture &MaterialTable::GetBaseColorTexture( Handle handle ) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    uint32_t index = m_Materials[handle].BaseColorTexture;
+    return index < m_Textures.size() && m_Textures[index].IsValid() ? m_Textures[index] : m_DefaultTexture;
+}
+
+void MaterialTable::Upload( CommandList &commandList )
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (!m_Buffer || m_Materials.size() > m_Capacity)
+    {
+        while (m_Capacity < m_Materials.size())
+        {
+            m_Capacity *= 2;
+        }
+
+        // Frames in flight keep reading the old buffer, which their command lists hold on to.
+        m_Buffer = std::make_shared<StructuredBuffer>(L"Material Table");
+        commandList.CopyBuffer(*m_Buffer, m_Capacity, sizeof(Material), nullptr);
+        commandList.WriteBuffer(*m_Buffer, 0, m_Materials.data(), m_Materials.size() * sizeof(Material));
+    } else
+    {
+        // One copy per run of neighbouring handles.
+        std::sort(m_DirtyHandles.begin(), m_DirtyHandles.end());
+        for (size_t i = 0; i < m_DirtyHandles.size();)
+        {
+            Handle first = m_DirtyHandles[i];
+            size_t j = i + 1;
+            while (j < m_DirtyHandles.size() && m_DirtyHandles[j] == first + (j - i))
+            {
+                ++j;
+            }
+
+            commandList.WriteBuffer(*m_Buffer, size_t(first) * sizeof(Material), &m_Materials[first],
+                                    (j - i) * sizeof(Material));
+            i = j;
+        }
+    }
+
+    for (Handle handle: m_DirtyHandles)
+    {
+        m_Dirty[handle] = false;
+    }
+    m_DirtyHandles.clear();
+}
+
+uint32_t MaterialTable::GetNumMaterials() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return static_cast<uint32_t>(m_Materials.size() - m_FreeHandles.size());
+}
+
+uint32_t MaterialTable::GetNumTextures() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return static_cast<uint32_t>(m_Textures.size() - m_FreeTextures.size());
+}
+
+void MaterialTable::MarkDirty( Handle handle )
+{
+    if (!m_Dirty[handle])
+    {
+        m_Dirty[handle] = true;
+        m_DirtyHandles.push_back(handle);
+    }
+}
+
+void MaterialTable::ReleaseMaterial( Handle handle )
+{
+    // Nothing draws with a released handle, so the slot is not uploaded until it is reused.
+    m_Materials[handle] = Material();
+    m_FreeHandles.push_back(handle);
+}
+
+void MaterialTable::ReleaseTexture( uint32_t index )
+{
+    if (--m_TextureRefCounts[index] > 0)
+    {
+        return;
+    }
+
+    m_TextureIndices.erase(m_Textures[index].GetD3D12Resource().Get());
+    m_Textures[index] = Texture();
+    m_FreeTextures.push_back(index);
+}
+
+}
@@ -0,0 +1,127 @@
+#ifndef MATERIALTABLE_H
+#define MATERIALTABLE_H
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "Material.h"
+#include "Resource.h"
+#include "StructuredBuffer.h"
+#include "../Core.h"
+
+
+namespace Enterprise::Core::Graphics {
+class CommandList;
+
+/**
+ * Every material of every model in one contiguous array of plain Material records, indexed by handle and
+ * mirrored on the GPU as a single structured buffer. Shaders index the buffer with the handle of the draw, so
+ * switching materials costs one root constant rather than a buffer binding.
+ * Changes are only recorded on the CPU; Upload copies the handles that changed since the last upload, a run
+ * of neighbouring handles per copy, and recreates the buffer only when the table outgrows it.
+ * Materials refer to textures by index into the textures of the table, which keeps them alive and shares one
+ * index between every material using the same texture.
+ */
+class ENTERPRISE_API MaterialTable {
+public:
+    using Handle = MaterialHandle;
+    // Plain white material, always present, drawn for meshes without one.
+    static constexpr Handle DEFAULT_MATERIAL = 0;
+
+    explicit MaterialTable( uint32_t initialCapacity = 256 );
+
+    MaterialTable( const MaterialTable &copy ) = delete;
+    MaterialTable &operator=( const MaterialTable &other ) = delete;
+
+    Handle Create( const Material &material );
+
+    void Update( Handle handle, const Material &material );
+
+    [[nodiscard]] Material Get( Handle handle ) const;
+
+    /**
+     * Release a material once frameNumber has finished on the GPU, see ReleaseStaleMaterials.
+     */
+    void Free( Handle handle, uint64_t frameNumber );
+
+    /**
+     * Return the materials and textures freed up to the completed frame number to the table.
+     */
+    void ReleaseStaleMaterials( uint64_t frameNumber );
+
+    /**
+     * Add a reference to texture and return its index. A texture that is already in the table keeps its index.
+     */
+    uint32_t AddTexture( const Texture &texture );
+
+    /**
+     * Release a reference to a texture once frameNumber has finished on the GPU.
+     */
+    void FreeTexture( uint32_t index, uint64_t frameNumber );
+
+    // Sampled for NO_TEXTURE and for released textures.
+    void SetDefaultTexture( const Texture &texture );
+
+    /**
+     * The texture at index, or the default texture. The reference stays valid until the texture is released.
+     */
+    [[nodiscard]] const Texture &GetTexture( uint32_t index ) const;
+
+    // The texture the base color of a material is sampled from.
+    [[nodiscard]] const Texture &GetBaseColorTexture( Handle handle ) const;
+
+    /**
+     * Record the copies of the materials that changed since the last upload on commandList.
+     * Must be called on the queue that draws with the table, before binding GetBuffer.
+     */
+    void Upload( CommandList &commandList );
+
+    [[nodiscard]] const StructuredBuffer &GetBuffer() const { return *m_Buffer; }
+
+    [[nodiscard]] uint32_t GetNumMaterials() const;
+
+    [[nodiscard]] uint32_t GetNumTextures() const;
+
+private:
+    void MarkDirty( Handle handle );
+
+    void ReleaseMaterial( Handle handle );
+
+    void ReleaseTexture( uint32_t index );
+
+    struct StaleEntryInfo {
+        StaleEntryInfo( uint32_t index, bool texture, uint64_t frameNumber )
+            : Index(index)
+            , IsTexture(texture)
+            , FrameNumber(frameNumber)
+        {}
+
+        uint32_t Index;
+        bool     IsTexture;
+        uint64_t FrameNumber;
+    };
+
+    std::vector<Material>                         m_Materials;
+    std::vector<Handle>                           m_FreeHandles;
+    // Handles written since the last upload, each once.
+    std::vector<Handle>                           m_DirtyHandles;
+    std::vector<bool>                             m_Dirty;
+    std::shared_ptr<StructuredBuffer>             m_Buffer;
+    uint32_t                                      m_Capacity;
+    // A deque, so references handed out by GetTexture survive textures being added.
+    std::deque<Texture>                           m_Textures;
+    std::vector<uint32_t>                         m_TextureRefCounts;
+    std::vector<uint32_t>                         m_FreeTextures;
+    std::unordered_map<ID3D12Resource*, uint32_t> m_TextureIndices;
+    Texture                                       m_DefaultTexture;
+    std::queue<StaleEntryInfo>                    m_StaleEntries;
+    mutable std::mutex                            m_Mutex;
+};
+
+}
+
+#endif //MATERIALTABLE_H
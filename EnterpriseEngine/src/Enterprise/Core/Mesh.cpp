@@ -4,29 +4,137 @@
 
 #include "Mesh.h"
 
+#include <cassert>
+
 #include "CommandList.h"
+#include "Renderer.h"
 
 namespace Enterprise::Core::Graphics {
 Mesh::Mesh()
-    : m_IndexCount(0)
+    : m_Geometry(GeometryArena::INVALID_HANDLE)
+    , m_IndexCount(0)
+    , m_VertexFormat(Geometry::VertexFormat::Float)
 {
 }
 
 
 Mesh::Mesh(const std::vector<VertexPosNormalTexture>& verts,const std::vector<uint32_t>& indices, CommandList* commandList)
-    : m_IndexCount(0)
+    : Mesh(verts.data(), verts.size(), sizeof(VertexPosNormalTexture), indices.data(), indices.size(), commandList)
+{
+}
+
+Mesh::Mesh( const void* vertexData, size_t numVertices, size_t vertexStride, const uint32_t* indices, size_t numIndices,
+            CommandList* commandList, Geometry::VertexFormat vertexFormat,
+            const Geometry::VertexQuantizationParams &quantization )
+    : m_Geometry(GeometryArena::INVALID_HANDLE)
+    , m_IndexCount(0)
+    , m_VertexFormat(vertexFormat)
+    , m_Quantization(quantization)
 {
-    commandList->CopyIndexBuffer(m_IndexBuffer, indices);
-    commandList->CopyVertexBuffer(m_VertexBuffer, verts);
-    m_IndexCount = indices.size();
+    assert(vertexStride == Geometry::GetVertexFormatStride(vertexFormat) && "Vertex stride does not match the format.");
+    Allocate(*commandList, vertexData, numVertices, indices, numIndices);
+}
+
+Mesh::~Mesh()
+{
+    if (m_Geometry != GeometryArena::INVALID_HANDLE)
+    {
+        // Frames in flight may still draw the mesh.
+        m_GeometryArena->Free(m_Geometry, Renderer::GetFrameCount());
+    }
+}
+
+bool Mesh::IsReady()
+{
+    if (m_UploadQueue && m_UploadQueue->IsFenceComplete(m_UploadFence))
+    {
+        m_UploadQueue.reset();
+    }
+    while (!m_TextureUploads.empty() && CommandList::IsTextureUploadComplete(*m_TextureUploads.back()))
+    {
+        m_TextureUploads.pop_back();
+    }
+    return !m_UploadQueue && m_TextureUploads.empty() && (m_Geometry == GeometryArena::INVALID_HANDLE || m_GeometryArena->IsReady(m_Geometry));
+}
+
+void Mesh::Allocate( CommandList &commandList, const void* vertexData, size_t numVertices, const uint32_t* indices,
+                     size_t       numIndices )
+{
+    if (m_Geometry != GeometryArena::INVALID_HANDLE)
+    {
+        m_GeometryArena->Free(m_Geometry, Renderer::GetFrameCount());
+    }
+
+    m_GeometryArena = Renderer::Get()->GetGeometryArena();
+    m_MaterialTable = Renderer::Get()->GetMaterialTable();
+    m_Geometry = m_GeometryArena->Allocate(commandList, m_VertexFormat, vertexData, numVertices, indices, numIndices,
+                                           &m_GeometryShared);
+    m_IndexCount = static_cast<uint32_t>(numIndices);
 }
 
-void Mesh::Draw( CommandList &commandList )
+void Mesh::Draw( CommandList &commandList, const MeshDrawParams &params )
 {
-    commandList.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    commandList.SetVertexBuffer(0, m_VertexBuffer);
-    commandList.SetIndexBuffer(m_IndexBuffer);
-    commandList.DrawIndexed(m_IndexCount);
+    if (m_Geometry == GeometryArena::INVALID_HANDLE)
+    {
+        return;
+    }
+
+    MeshBindState  unbound;
+    MeshBindState &bound = params.BoundState != nullptr ? *params.BoundState : unbound;
+    if (!bound.TopologySet)
+    {
+        commandList.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        bound.TopologySet = true;
+    }
+    if (bound.Material != m_Material)
+    {
+        commandList.SetGraphics32BitConstants(MATERIAL_ROOT_PARAMETER, m_Material);
+        commandList.SetShaderResourceView(1, 0, m_MaterialTable->GetBaseColorTexture(m_Material),
+                                          D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        bound.Material = m_Material;
+    }
+    if (m_VertexFormat != Geometry::VertexFormat::Float)
+    {
+        commandList.SetGraphics32BitConstants(VERTEX_QUANTIZATION_ROOT_PARAMETER, m_Quantization);
+    }
+    GeometryArena::Range geometry = m_GeometryArena->GetRange(m_Geometry);
+    auto                 vertexBuffer = m_GeometryArena->GetVertexBuffer(geometry);
+    auto                 indexBuffer = m_GeometryArena->GetIndexBuffer(geometry);
+    if (bound.Vertices != vertexBuffer.get())
+    {
+        commandList.SetVertexBuffer(0, *vertexBuffer);
+        bound.Vertices = vertexBuffer.get();
+    }
+    if (bound.Indices != indexBuffer.get())
+    {
+        commandList.SetIndexBuffer(*indexBuffer);
+        bound.Indices = indexBuffer.get();
+    }
+
+    if (!m_Lods.empty())
+    {
+        uint32_t lod = Geometry::SelectLod(m_Lods.data(), static_cast<uint32_t>(m_Lods.size()), params.PixelsPerUnit,
+                                           params.MaxPixelError);
+        if (lod > 0 || params.CullParams == nullptr || m_Meshlets.empty())
+        {
+            // Meshlets only cover the full detail level.
+            commandList.DrawIndexed(m_Lods[lod].NumIndices, params.NumInstances,
+                                    geometry.StartIndex + m_Lods[lod].FirstIndex, geometry.BaseVertex);
+            return;
+        }
+    } else if (params.CullParams == nullptr || m_Meshlets.empty())
+    {
+        commandList.DrawIndexed(m_IndexCount, params.NumInstances, geometry.StartIndex, geometry.BaseVertex);
+        return;
+    }
+
+    m_VisibleRanges.clear();
+    Geometry::CullMeshlets(m_Meshlets.data(), m_Meshlets.size(), *params.CullParams, &m_VisibleRanges);
+    for (const auto &range: m_VisibleRanges)
+    {
+        commandList.DrawIndexed(range.NumIndices, params.NumInstances, geometry.StartIndex + range.FirstIndex,
+                                geometry.BaseVertex);
+    }
 }
 
 std::unique_ptr<Mesh> Mesh::CreateDemoCube( CommandList &commandList, UINT size )
@@ -85,9 +193,10 @@ std::unique_ptr<Mesh> Mesh::CreateDemoCube( CommandList &commandList, UINT size
 void Mesh::Initialize( CommandList &      commandList, std::vector<VertexPosNormalTexture> vertexArray,
                        std::vector<DWORD> indexArray )
 {
-    commandList.CopyVertexBuffer(m_VertexBuffer, vertexArray);
-    commandList.CopyIndexBuffer(m_IndexBuffer, indexArray);
-    m_IndexCount = static_cast<uint32_t>(indexArray.size());
+    static_assert(sizeof(DWORD) == sizeof(uint32_t));
+    m_VertexFormat = Geometry::VertexFormat::Float;
+    Allocate(commandList, vertexArray.data(), vertexArray.size(), reinterpret_cast<const uint32_t *>(indexArray.data()),
+             indexArray.size());
 }
 
 }
@@ -7,14 +7,20 @@
 #include <DirectXMath.h>
 #include <intsafe.h>
 
-#include "IndexBuffer.h"
-#include "Material.h"
-#include "VertexBuffer.h"
+#include "GeometryArena.h"
+#include "MaterialTable.h"
 #include "../Core.h"
+#include "../Geometry/Bounds.h"
+#include "../Geometry/Bvh.h"
+#include "../Geometry/Meshlets.h"
+#include "../Geometry/OcclusionCuller.h"
+#include "../Geometry/Simplifier.h"
+#include "../Geometry/VertexQuantization.h"
 
 
 namespace Enterprise::Core::Graphics {
 class ENTERPRISE_API CommandList;
+class ENTERPRISE_API CommandQueue;
 
 struct VertexPosColor {
     DirectX::XMFLOAT3 Position;
@@ -60,13 +66,104 @@ static WORD g_Indicies[36] =
     4, 0, 3, 4, 3, 7
 };
 
+// Root parameter the dequantization constants of packed meshes are bound to.
+constexpr uint32_t VERTEX_QUANTIZATION_ROOT_PARAMETER = 3;
+// Root parameters of the material table and of the handle of the material drawn with, see MaterialTable.
+constexpr uint32_t MATERIAL_TABLE_ROOT_PARAMETER = 4;
+constexpr uint32_t MATERIAL_ROOT_PARAMETER = 5;
+// Root parameter of the per instance structured buffer, see Scene::InstanceData.
+constexpr uint32_t INSTANCE_ROOT_PARAMETER = 6;
+
+// What the previous draw of a sorted submission left bound, so draws that share it skip binding it again. Start
+// every submission with a fresh one, and after anything else was bound to the same slots.
+struct MeshBindState {
+    bool           TopologySet = false;
+    MaterialHandle Material = INVALID_MATERIAL;
+    const void*    Vertices = nullptr;
+    const void*    Indices = nullptr;
+};
+
+struct MeshDrawParams {
+    // Enables meshlet culling when set, see Mesh::Draw.
+    const Geometry::MeshletCullParams* CullParams = nullptr;
+    // Projected size of one model unit at the mesh, see Camera::GetPixelsPerUnit. 0 always draws full detail.
+    float                              PixelsPerUnit = 0.0f;
+    // Largest simplification error, in pixels, that may be visible.
+    float                              MaxPixelError = 1.0f;
+    // Skips meshes whose bounds are hidden behind the occluders rasterized this frame, when set. ModelToClip is the
+    // model view projection matrix the occluders were added with, row major.
+    const Geometry::OcclusionCuller*   Occlusion = nullptr;
+    const float*                       ModelToClip = nullptr;
+    // Instances to draw, read by the vertex shader from the buffer bound to INSTANCE_ROOT_PARAMETER.
+    uint32_t                           NumInstances = 1;
+    // Binds everything for every draw when not set.
+    MeshBindState*                     BoundState = nullptr;
+};
+
 class ENTERPRISE_API Mesh {
 public:
     Mesh();
     Mesh(const std::vector<VertexPosNormalTexture>& vertArray,const std::vector<uint32_t>& indices, CommandList* commandList);
-    ~Mesh() = default;
+    Mesh(const void* vertexData, size_t numVertices, size_t vertexStride, const uint32_t* indices, size_t numIndices,
+         CommandList* commandList, Geometry::VertexFormat vertexFormat = Geometry::VertexFormat::Float,
+         const Geometry::VertexQuantizationParams &quantization = {});
+    ~Mesh();
+
+    Mesh( const Mesh &copy ) = delete;
+    Mesh &operator=( const Mesh &other ) = delete;
+
+    /**
+     * Draw the mesh at the level of detail picked from params. At full detail with cull parameters,
+     * meshlets outside the frustum or facing away from the camera are skipped and only the visible
+     * index ranges are drawn.
+     */
+    void Draw( CommandList &commandList, const MeshDrawParams &params = {} );
+
+    [[nodiscard]] Geometry::VertexFormat GetVertexFormat() const { return m_VertexFormat; }
+
+    // True if another mesh had already uploaded the same geometry, which this one shares.
+    [[nodiscard]] bool IsGeometryShared() const { return m_GeometryShared; }
+
+    /**
+     * Mark the mesh as uploading until fenceValue completes on queue, and the texture uploads of other loads its
+     * textures were shared from have completed too. Meshes that are not ready are not drawn.
+     */
+    void SetUploadFence( std::shared_ptr<CommandQueue> queue, uint64_t fenceValue,
+                         std::vector<std::shared_ptr<TextureUpload>> textureUploads = {} )
+    {
+        m_UploadQueue = std::move(queue);
+        m_UploadFence = fenceValue;
+        m_TextureUploads = std::move(textureUploads);
+    }
+
+    // True once the upload fence has completed and the arena has its geometry ready to draw.
+    [[nodiscard]] bool IsReady();
+
+    void SetMeshlets( const Geometry::Meshlet* meshlets, size_t numMeshlets )
+    {
+        m_Meshlets.assign(meshlets, meshlets + numMeshlets);
+    }
 
-    void Draw( CommandList &commandList );
+    [[nodiscard]] const std::vector<Geometry::Meshlet> &GetMeshlets() const { return m_Meshlets; }
+
+    void SetLods( const Geometry::MeshLod* lods, size_t numLods ) { m_Lods.assign(lods, lods + numLods); }
+
+    [[nodiscard]] const std::vector<Geometry::MeshLod> &GetLods() const { return m_Lods; }
+
+    // Bounds in model space. Meshes without bounds are never culled.
+    void SetBounds( const Geometry::MeshBounds &bounds ) { m_Bounds = bounds; }
+
+    [[nodiscard]] const Geometry::MeshBounds &GetBounds() const { return m_Bounds; }
+
+    // Model space triangles of the full detail level, for ray casts. nullptr when the mesh has none.
+    void SetTriangleBvh( std::unique_ptr<Geometry::TriangleBvh> bvh ) { m_TriangleBvh = std::move(bvh); }
+
+    [[nodiscard]] const Geometry::TriangleBvh* GetTriangleBvh() const { return m_TriangleBvh.get(); }
+
+    // Model space triangles rasterized for occlusion culling. nullptr when the mesh is too detailed to be worth it.
+    void SetOccluder( std::unique_ptr<Geometry::OccluderMesh> occluder ) { m_Occluder = std::move(occluder); }
+
+    [[nodiscard]] const Geometry::OccluderMesh* GetOccluder() const { return m_Occluder.get(); }
 
     //void CreateMesh( CommandList &commandList, VertexPosColor* vertexArray, WORD* indexArray );
 
@@ -75,14 +172,34 @@ public:
     void Initialize( CommandList &      commandList, std::vector<VertexPosNormalTexture> vertexArray,
                      std::vector<DWORD> indexArray );
 
-    void AddMaterial( const Material &mat) { m_Materials.push_back(std::move(mat));};
+    // A handle into the renderer's material table, owned by whoever created it.
+    void SetMaterial( MaterialHandle material ) { m_Material = material; }
+
+    [[nodiscard]] MaterialHandle GetMaterial() const { return m_Material; }
 
 private:
-    IndexBuffer                         m_IndexBuffer;
-    VertexBuffer                        m_VertexBuffer;
+    void Allocate( CommandList &commandList, const void* vertexData, size_t numVertices, const uint32_t* indices,
+                   size_t       numIndices );
+
+    // Vertices and indices live in the renderer's geometry arena, drawn with a base vertex and start index.
+    std::shared_ptr<GeometryArena>      m_GeometryArena;
+    GeometryArena::Handle               m_Geometry;
+    bool                                m_GeometryShared = false;
     uint32_t                            m_IndexCount;
-    std::shared_ptr<Texture>            m_pTexture;
-    std::vector<Material>               m_Materials;
+    std::shared_ptr<CommandQueue>       m_UploadQueue;
+    uint64_t                            m_UploadFence = 0;
+    std::vector<std::shared_ptr<TextureUpload>> m_TextureUploads;
+    std::shared_ptr<MaterialTable>      m_MaterialTable;
+    MaterialHandle                      m_Material = MaterialTable::DEFAULT_MATERIAL;
+    Geometry::VertexFormat              m_VertexFormat;
+    Geometry::VertexQuantizationParams  m_Quantization;
+    std::vector<Geometry::Meshlet>      m_Meshlets;
+    std::vector<Geometry::MeshLod>      m_Lods;
+    Geometry::MeshBounds                m_Bounds = Geometry::GetInfiniteBounds();
+    std::unique_ptr<Geometry::TriangleBvh> m_TriangleBvh;
+    std::unique_ptr<Geometry::OccluderMesh> m_Occluder;
+    // Scratch for the visible index ranges, kept to avoid an allocation per draw.
+    std::vector<Geometry::IndexRange>   m_VisibleRanges;
 };
 }
 
@@ -4,161 +4,663 @@
 
 #include "Model.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <unordered_map>
+
 #include "Renderer.h"
+#include "ThreadPool.h"
 #include "../Log.h"
-#include "assimp/Importer.hpp"
-#include "assimp/ObjMaterial.h"
-#include "assimp/postprocess.h"
-#include "assimp/scene.h"
-#define STB_IMAGE_IMPLEMENTATION
+#include "../Assets/CookedModel.h"
+#include "../Assets/CookedTexture.h"
+#include "../Assets/ModelImporter.h"
+#include "../Assets/TextureCooker.h"
+#include "../Assets/TextureDecoder.h"
+#include "../Scene/ModelNodes.h"
+#include "../Textures/MipChain.h"
 #include "CommandList.h"
 #include "DirectXTex.h"
-#include "../../vendor/stb/stb_image.h"
 
 using namespace Enterprise::Core::Graphics;
 
-void ProcessVertices( const aiMesh* _mesh, std::vector<VertexPosNormalTexture>* vertexArray)
+// The cooked vertex stream is uploaded as is, so the layouts have to agree.
+static_assert(sizeof(Enterprise::Assets::MeshVertex) == sizeof(VertexPosNormalTexture));
+static_assert(offsetof(Enterprise::Assets::MeshVertex, Normal) == offsetof(VertexPosNormalTexture, Normal));
+static_assert(offsetof(Enterprise::Assets::MeshVertex, TexCoord) == offsetof(VertexPosNormalTexture, TexCoord));
+
+namespace Enterprise::Core::Graphics {
+
+// Give the mesh the CPU copies of its full detail level, the first level when it has them: a triangle hierarchy for
+// ray casts and, for simple meshes with an opaque material, the triangles to rasterize as an occluder. material is
+// nullptr for meshes drawn with the default material, which is opaque.
+static void SetCpuGeometry( Mesh &mesh, const Assets::MeshVertex* vertices, size_t numVertices, const uint32_t* indices,
+                            size_t numIndices, const Geometry::MeshLod* lods, size_t numLods,
+                            const Assets::MaterialData* material )
 {
-    for ( auto x = 0; x < _mesh->mNumVertices; ++x)
+    if (numLods != 0)
+    {
+        indices += lods[0].FirstIndex;
+        numIndices = lods[0].NumIndices;
+    }
+    if (numVertices == 0 || numIndices < 3)
     {
-        auto vertex = _mesh->mVertices + x;
-        auto normal = _mesh->mNormals + x;
-        auto texCoords = _mesh->mTextureCoords + x;
-        VertexPosNormalTexture vertPosNormTex{};
-        vertPosNormTex.Position = DirectX::XMFLOAT3(vertex->x, vertex->y, vertex->z);
-        vertPosNormTex.Normal = DirectX::XMFLOAT3(normal->x,normal->y, normal->z);
-        if (_mesh->mTextureCoords[0])
+        return;
+    }
+
+    auto bvh = std::make_unique<Geometry::TriangleBvh>();
+    bvh->Build(vertices->Position, numVertices, sizeof(Assets::MeshVertex), indices, numIndices);
+    mesh.SetTriangleBvh(std::move(bvh));
+
+    auto occluder = std::make_unique<Geometry::OccluderMesh>();
+    if ((!material || Assets::IsOpaque(*material)) &&
+        Geometry::MakeOccluderMesh(vertices->Position, numVertices, sizeof(Assets::MeshVertex), indices, numIndices,
+                                   occluder.get()))
+    {
+        mesh.SetOccluder(std::move(occluder));
+    }
+}
+
+bool Model::LoadModel( const std::string &pFile, Model* model, CommandList* commandList, const std::wstring &modelName )
+{
+    const std::string cookedFile = GetCookedPath(pFile);
+    std::error_code   error;
+    bool              result;
+    if (std::filesystem::exists(cookedFile, error) &&
+        std::filesystem::last_write_time(cookedFile, error) >= std::filesystem::last_write_time(pFile, error) &&
+        LoadCookedModel(cookedFile, model, commandList, modelName))
+    {
+        result = true;
+    } else if (CookModel(pFile, cookedFile))
+    {
+        result = LoadCookedModel(cookedFile, model, commandList, modelName);
+    } else
+    {
+        EE_CORE_WARN("Unable to cook model; {}", pFile);
+        result = ImportModel(pFile, model, commandList, modelName);
+    }
+
+    const auto &statistics = model->m_LoadStatistics;
+    if (result && (statistics.NumSharedMeshes != 0 || statistics.NumSharedTextures != 0))
+    {
+        EE_CORE_INFO("Loaded {}; shared {} of {} meshes and {} of {} textures, {} geometry and {} texture bytes "
+                     "deduplicated", pFile, statistics.NumSharedMeshes, statistics.NumMeshes,
+                     statistics.NumSharedTextures, statistics.NumTextures, statistics.DeduplicatedGeometryBytes,
+                     statistics.DeduplicatedTextureBytes);
+    }
+    return result;
+}
+
+bool Model::ImportModel( const std::string &pFile, Model* model, CommandList* commandList, const std::wstring &modelName )
+{
+    Assets::ModelData modelData;
+    if (!Assets::ImportModelData(pFile, &modelData))
+    {
+        EE_CORE_ERROR("Unable to import model; {}", pFile);
+        return false;
+    }
+
+    size_t                firstMesh = model->m_Meshes.size();
+    std::vector<uint32_t> meshMaterials;
+    model->m_Meshes.reserve(firstMesh + modelData.Meshes.size());
+    for (const auto &mesh: modelData.Meshes)
+    {
+        if (mesh.VertexFormat != Geometry::VertexFormat::Float)
         {
-            vertPosNormTex.TexCoord = DirectX::XMFLOAT2(_mesh->mTextureCoords[0][x].x, _mesh->mTextureCoords[0][x].y);
+            model->AddMesh(mesh.PackedVertices.data(), mesh.Vertices.size(),
+                           Geometry::GetVertexFormatStride(mesh.VertexFormat), mesh.Indices.data(), mesh.Indices.size(),
+                           commandList, mesh.VertexFormat, mesh.Quantization);
         } else
         {
-            vertPosNormTex.TexCoord = DirectX::XMFLOAT2(0.0,0.0);
+            model->AddMesh(mesh.Vertices.data(), mesh.Vertices.size(), sizeof(Assets::MeshVertex),
+                           mesh.Indices.data(), mesh.Indices.size(), commandList);
         }
-        vertexArray->emplace_back(vertPosNormTex);
+        model->m_Meshes.back()->SetMeshlets(mesh.Meshlets.data(), mesh.Meshlets.size());
+        model->m_Meshes.back()->SetLods(mesh.Lods.data(), mesh.Lods.size());
+        model->m_Meshes.back()->SetBounds(mesh.Bounds);
+        SetCpuGeometry(*model->m_Meshes.back(), mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices.data(),
+                       mesh.Indices.size(), mesh.Lods.data(), mesh.Lods.size(),
+                       mesh.MaterialIndex < modelData.Materials.size() ? &modelData.Materials[mesh.MaterialIndex]
+                                                                       : nullptr);
+        meshMaterials.push_back(mesh.MaterialIndex);
+    }
+
+    size_t firstNode = model->m_Nodes.size();
+    for (const auto &node: Assets::BuildCookedNodes(modelData))
+    {
+        model->AddNode(node, modelData.NodeMeshes.data() + node.FirstMesh, firstNode, firstMesh);
     }
-};
 
-void ProcessIndicies( const aiMesh* _mesh, std::vector<uint32_t>* indexArray)
+    std::vector<Assets::EncodedImage> images;
+    images.reserve(modelData.Textures.size());
+    for (const auto &texture: modelData.Textures)
+    {
+        images.push_back({texture.Data.data(), texture.Data.size(), texture.Width, texture.Height});
+    }
+    std::vector<uint32_t> textureIndices;
+    model->LoadEmbeddedTextures(images, commandList, modelName, &textureIndices);
+    model->LoadMaterials(modelData.Materials.data(), modelData.Materials.size(), textureIndices, firstMesh,
+                         meshMaterials);
+
+    return true;
+}
+
+bool Model::LoadCookedModel( const std::string &cookedFile, Model* model, CommandList* commandList,
+                             const std::wstring &modelName )
 {
-    for (auto x = 0; x < _mesh->mNumFaces; ++x)
+    Assets::CookedModel cookedModel;
+    if (!cookedModel.Open(cookedFile))
     {
-        auto face = _mesh->mFaces[x];
-        for (auto j = 0; j < face.mNumIndices; ++j)
+        EE_CORE_WARN("Unable to open cooked model; {}", cookedFile);
+        return false;
+    }
+
+    size_t                firstMesh = model->m_Meshes.size();
+    std::vector<uint32_t> meshMaterials;
+    model->m_Meshes.reserve(firstMesh + cookedModel.GetNumMeshes());
+    for (uint32_t i = 0; i < cookedModel.GetNumMeshes(); ++i)
+    {
+        const auto &range = cookedModel.GetMeshRange(i);
+        if (const auto* stream = cookedModel.GetVertexStream(i))
         {
-            indexArray->emplace_back(face.mIndices[j]);
+            model->AddMesh(cookedModel.GetPackedVertices(*stream), range.NumVertices, stream->Stride,
+                           cookedModel.GetIndices(range), range.NumIndices, commandList, stream->Format,
+                           stream->Quantization);
+        } else
+        {
+            model->AddMesh(cookedModel.GetVertices(range), range.NumVertices, sizeof(Assets::MeshVertex),
+                           cookedModel.GetIndices(range), range.NumIndices, commandList);
         }
+        model->m_Meshes.back()->SetMeshlets(cookedModel.GetMeshlets(range), range.NumMeshlets);
+        model->m_Meshes.back()->SetLods(cookedModel.GetLods(range), range.NumLods);
+        model->m_Meshes.back()->SetBounds(cookedModel.GetMeshBounds(i));
+        SetCpuGeometry(*model->m_Meshes.back(), cookedModel.GetVertices(range), range.NumVertices,
+                       cookedModel.GetIndices(range), range.NumIndices, cookedModel.GetLods(range), range.NumLods,
+                       range.MaterialIndex < cookedModel.GetNumMaterials()
+                           ? &cookedModel.GetMaterial(range.MaterialIndex)
+                           : nullptr);
+        meshMaterials.push_back(range.MaterialIndex);
+    }
+
+    size_t firstNode = model->m_Nodes.size();
+    for (uint32_t i = 0; i < cookedModel.GetNumNodes(); ++i)
+    {
+        const auto &node = cookedModel.GetNode(i);
+        model->AddNode(node, cookedModel.GetNodeMeshes(node), firstNode, firstMesh);
     }
+
+    std::vector<Assets::EncodedImage> images;
+    images.reserve(cookedModel.GetNumTextures());
+    for (uint32_t i = 0; i < cookedModel.GetNumTextures(); ++i)
+    {
+        const auto &range = cookedModel.GetTextureRange(i);
+        images.push_back({cookedModel.GetTextureData(range), size_t(range.Size), range.Width, range.Height});
+    }
+    std::vector<uint32_t> textureIndices;
+    model->LoadEmbeddedTextures(images, commandList, modelName, &textureIndices);
+    model->LoadMaterials(cookedModel.GetNumMaterials() ? &cookedModel.GetMaterial(0) : nullptr,
+                         cookedModel.GetNumMaterials(), textureIndices, firstMesh, meshMaterials);
+
+    return true;
 }
 
-void loadMaterials(aiMaterial material, aiTextureType type, std::string typeName)
+bool Model::CookModel( const std::string &pFile, const std::string &cookedFile )
 {
-    std::vector<Enterprise::Core::Material> materials;
-    for (UINT i = 0; i < material.GetTextureCount(type); ++i)
+    Assets::ModelData             modelData;
+    Assets::ModelImportStatistics statistics;
+    if (!Assets::ImportModelData(pFile, &modelData, {}, &statistics))
+    {
+        EE_CORE_ERROR("Unable to import model; {}", pFile);
+        return false;
+    }
+    EE_CORE_INFO("Optimized {}; ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", pFile,
+                 statistics.Before.GetACMR(), statistics.After.GetACMR(),
+                 statistics.Before.GetATVR(), statistics.After.GetATVR());
+    EE_CORE_INFO("Vertex streams {} -> {} bytes; {} float, {} packed, {} quantized meshes; "
+                 "max error position {:.6f}, normal {:.4f} deg, uv {:.6f}",
+                 statistics.FloatVertexBytes, statistics.PackedVertexBytes,
+                 statistics.MeshesPerFormat[size_t(Geometry::VertexFormat::Float)],
+                 statistics.MeshesPerFormat[size_t(Geometry::VertexFormat::PackedNormalTexCoord)],
+                 statistics.MeshesPerFormat[size_t(Geometry::VertexFormat::Quantized)],
+                 statistics.QuantizationError.MaxPositionError, statistics.QuantizationError.MaxNormalError,
+                 statistics.QuantizationError.MaxTexCoordError);
+
+    Assets::TextureCookStatistics textureStatistics;
+    size_t numCooked = Assets::CookModelTextures(&modelData, {}, &textureStatistics);
+    if (numCooked != 0)
     {
-        aiString str;
-        material.GetTexture(type, i, &str);
-        Enterprise::Core::Material newMaterial;
+        EE_CORE_INFO("Cooked {} of {} textures, {} uncompressed; {:.1f} MTexel/s, PSNR {:.2f} dB", numCooked,
+                     modelData.Textures.size(), textureStatistics.NumUncompressed,
+                     textureStatistics.GetMegatexelsPerSecond(), textureStatistics.GetPSNR());
     }
+
+    return Assets::WriteCookedModel(cookedFile, modelData);
 }
-void ProcessEmbeddedTextures(const aiScene* scene, std::vector<Texture> *textures, CommandList* commandList, const std::wstring &modelName)
+
+void Model::LoadEmbeddedTextures( const std::vector<Assets::EncodedImage> &images, CommandList* commandList,
+                                  const std::wstring &                     modelName,
+                                  std::vector<uint32_t>*                   textureIndices )
 {
-    for (UINT i= 0; i < scene->mNumTextures; ++i)
+    std::vector<std::wstring>      textureNames(images.size());
+    std::vector<TextureCache::Key> cacheKeys(images.size());
+    std::vector<Texture>           textures(images.size());
+
+    // Textures already resident, from another model or from earlier in this one, are shared rather than
+    // decoded again, cooked textures are never decoded.
+    std::vector<Assets::EncodedImage>             pendingImages;
+    std::vector<size_t>                           pendingIndices;
+    std::vector<bool>                             loaded(images.size(), true);
+    std::unordered_map<TextureCache::Key, size_t> firstIndices;
+    std::vector<size_t>                           duplicateIndices;
+    for (size_t i = 0; i < images.size(); ++i)
     {
-        auto aiTex = scene->mTextures[i];
-        Texture texture;
-        const uint8_t* imageData = nullptr;
-        if (aiTex->mHeight == 0)
+        textureNames[i] = modelName + L"-E" + std::to_wstring(i);
+        cacheKeys[i] = CommandList::GetTextureContentKey(images[i].Data, images[i].Size, false);
+        m_LoadStatistics.NumTextures += 1;
+        if (!firstIndices.emplace(cacheKeys[i], i).second)
         {
-            imageData = stbi_load_from_memory(reinterpret_cast<unsigned char*>(aiTex->pcData), aiTex->mWidth, &texture.m_Width, &texture.m_Height, &texture.m_ComponentsPerPixel,0);
-            commandList->LoadEmbeddedTexture(&texture, reinterpret_cast<uint8_t*>(aiTex->pcData), aiTex->mWidth, modelName+L"-E"+std::to_wstring(i));
-        } else
+            duplicateIndices.push_back(i);
+            continue;
+        }
+        if (commandList->GetCachedTexture(textures[i], cacheKeys[i], textureNames[i]))
+        {
+            m_LoadStatistics.NumSharedTextures += 1;
+            m_LoadStatistics.DeduplicatedTextureBytes += textures[i].GetCacheHandle().GetSize();
+            continue;
+        }
+
+        if (Assets::IsCookedTexture(images[i].Data, images[i].Size))
+        {
+            Assets::CookedTexture cookedTexture;
+            if (!cookedTexture.Open(images[i].Data, images[i].Size))
+            {
+                EE_CORE_WARN("Invalid cooked embedded texture {}.", i);
+                loaded[i] = false;
+                continue;
+            }
+            commandList->LoadCookedTexture(textures[i], cookedTexture, cacheKeys[i], textureNames[i], false);
+            continue;
+        }
+
+        pendingImages.push_back(images[i]);
+        pendingIndices.push_back(i);
+    }
+
+    // Decode everything and build the mips up front on the thread pool, the uploads below have to stay
+    // on this thread.
+    std::vector<Assets::DecodedImage> decodedImages(pendingImages.size());
+    Assets::DecodeImages(pendingImages.data(), pendingImages.size(), decodedImages.data());
+
+    std::vector<std::vector<Textures::MipLevel> > mips(decodedImages.size());
+    Threads::ThreadPool::Get().ParallelFor(decodedImages.size(), 1, [&]( size_t begin, size_t end )
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const auto &image = decodedImages[i];
+            if (image.IsValid())
+            {
+                Textures::GenerateMipChain(image.Pixels.GetData(), image.Width, image.Height, image.GetRowPitch(),
+                                           {}, &mips[i]);
+            }
+        }
+    });
+
+    for (size_t i = 0; i < pendingIndices.size(); ++i)
+    {
+        size_t index = pendingIndices[i];
+        if (!decodedImages[i].IsValid())
+        {
+            EE_CORE_WARN("Unable to decode embedded texture {}.", index);
+            loaded[index] = false;
+            continue;
+        }
+        commandList->LoadTextureFromImage(textures[index], decodedImages[i], mips[i], cacheKeys[index],
+                                          textureNames[index], false);
+        // Hand the pixels back to the scratch pool for the next image.
+        decodedImages[i].Pixels.Reset();
+    }
+
+    for (size_t i: duplicateIndices)
+    {
+        size_t first = firstIndices[cacheKeys[i]];
+        loaded[i] = loaded[first];
+        if (loaded[i])
+        {
+            textures[i] = textures[first];
+            m_LoadStatistics.NumSharedTextures += 1;
+            m_LoadStatistics.DeduplicatedTextureBytes += textures[i].GetCacheHandle().GetSize();
+        }
+    }
+
+    if (!m_MaterialTable)
+    {
+        m_MaterialTable = Renderer::Get()->GetMaterialTable();
+    }
+    textureIndices->assign(textures.size(), NO_TEXTURE);
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        if (loaded[i])
         {
-            imageData = stbi_load_from_memory(reinterpret_cast<unsigned char*>(aiTex->pcData), aiTex->mWidth * aiTex->mHeight, &texture.m_Width, &texture.m_Height, &texture.m_ComponentsPerPixel,0);
-            commandList->LoadEmbeddedTexture(&texture, imageData, aiTex->mWidth * aiTex->mHeight, modelName+L"-E"+std::to_wstring(i));
+            (*textureIndices)[i] = m_MaterialTable->AddTexture(textures[i]);
+            m_TextureIndices.push_back((*textureIndices)[i]);
+            m_Textures.push_back(std::move(textures[i]));
         }
     }
 }
 
-void ProcessMaterials(const aiScene* scene, const aiMesh* mesh, std::vector<Enterprise::Core::Material> mats)
+void Model::LoadMaterials( const Assets::MaterialData* materials, size_t numMaterials,
+                           const std::vector<uint32_t> &textureIndices, size_t firstMesh,
+                           const std::vector<uint32_t> &meshMaterials )
 {
-    if (mesh->mMaterialIndex >= 0)
+    if (!m_MaterialTable)
+    {
+        m_MaterialTable = Renderer::Get()->GetMaterialTable();
+    }
+
+    auto getTexture = [&]( uint32_t texture )
+    {
+        return texture < textureIndices.size() ? textureIndices[texture] : NO_TEXTURE;
+    };
+
+    std::vector<MaterialHandle> handles(numMaterials);
+    for (size_t i = 0; i < numMaterials; ++i)
     {
+        const auto &data = materials[i];
+        Material    material;
+        std::copy(std::begin(data.BaseColor), std::end(data.BaseColor), material.BaseColor);
+        std::copy(std::begin(data.Emissive), std::end(data.Emissive), material.Emissive);
+        material.Metallic = data.Metallic;
+        material.Roughness = data.Roughness;
+        material.AlphaCutoff = data.AlphaCutoff;
+        material.BaseColorTexture = getTexture(data.BaseColorTexture);
+        material.NormalTexture = getTexture(data.NormalTexture);
+        material.MetallicRoughnessTexture = getTexture(data.MetallicRoughnessTexture);
+        material.EmissiveTexture = getTexture(data.EmissiveTexture);
+        material.PipelineKey = data.AlphaMode == Assets::MaterialAlphaMode::Mask    ? MATERIAL_PIPELINE_ALPHA_TEST
+                               : data.AlphaMode == Assets::MaterialAlphaMode::Blend ? MATERIAL_PIPELINE_ALPHA_BLEND
+                                                                                    : MATERIAL_PIPELINE_OPAQUE;
+        if (data.DoubleSided)
+        {
+            material.PipelineKey |= MATERIAL_PIPELINE_DOUBLE_SIDED;
+        }
+
+        handles[i] = m_MaterialTable->Create(material);
+        m_Materials.push_back(handles[i]);
+    }
+
+    for (size_t i = 0; i < meshMaterials.size(); ++i)
+    {
+        if (meshMaterials[i] < handles.size())
+        {
+            m_Meshes[firstMesh + i]->SetMaterial(handles[meshMaterials[i]]);
+        }
     }
 }
 
-void ProcessMeshes( const aiScene* scene, const aiNode* node, Model* model, CommandList* commandList)
+Model::~Model()
 {
-    for (auto i = 0; i < node->mNumMeshes; ++i )
+    if (!m_MaterialTable)
     {
-        auto nodeMesh = node->mMeshes[i];
-        auto _mesh = scene->mMeshes[nodeMesh];
-        std::vector<VertexPosNormalTexture> vertexArray;
-        vertexArray.reserve(_mesh->mNumVertices);
-        ProcessVertices(_mesh, &vertexArray);
-        std::vector<uint32_t> indexArray;
-        indexArray.reserve(_mesh->mNumVertices);
-        ProcessIndicies(_mesh, &indexArray);
-        std::vector<Enterprise::Core::Material> mats;
-        ProcessMaterials(scene, _mesh, mats);
-        model->AddMesh(vertexArray, indexArray, commandList);
+        return;
     }
-};
 
-namespace Enterprise::Core::Graphics {
+    // Frames in flight may still draw with them.
+    uint64_t frameNumber = Renderer::GetFrameCount();
+    for (MaterialHandle material: m_Materials)
+    {
+        m_MaterialTable->Free(material, frameNumber);
+    }
+    for (uint32_t texture: m_TextureIndices)
+    {
+        m_MaterialTable->FreeTexture(texture, frameNumber);
+    }
+}
 
+std::future<bool> Model::LoadModelAsync( const std::string &pFile, std::shared_ptr<Model> model,
+                                         const std::wstring &modelName )
+{
+    return Threads::ThreadPool::Get().Submit([pFile, model, modelName]()
+    {
+        auto copyQueue = Renderer::Get()->GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
+        auto commandList = copyQueue->GetCommandList();
 
-aiNode* Model::ProcessNode(const aiScene* scene, aiNode* node, Model* model, CommandList* commandList)
+        // Load into a private model so Draw never sees a mesh whose upload has not been submitted yet.
+        // A load that throws has still published textures to the cache and recorded their uploads, so the list
+        // is submitted either way and the exception rethrown into the future afterwards.
+        Model              loaded;
+        bool               result = false;
+        std::exception_ptr exception;
+        try
+        {
+            result = LoadModel(pFile, &loaded, commandList.get(), modelName);
+        } catch (...)
+        {
+            exception = std::current_exception();
+        }
+
+        // The geometry went into arena pages of this list's own, which the direct queue takes over once uploaded.
+        // Textures shared from other loads may be uploaded by lists executed after this one, so the meshes also
+        // wait for those.
+        auto     geometryArena = Renderer::Get()->GetGeometryArena();
+        auto     textureUploads = commandList->TakeSharedTextureUploads();
+        uint64_t uploadBatch = geometryArena->CloseUploads(*commandList);
+        uint64_t fenceValue = copyQueue->ExecuteCommandList(commandList);
+        geometryArena->SubmitUploads(uploadBatch, copyQueue, fenceValue);
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+        if (result)
+        {
+            model->AddLoadedModel(loaded, copyQueue, fenceValue, textureUploads);
+        }
+        return result;
+    });
+}
+
+bool Model::IsReady() const
+{
+    std::lock_guard<std::mutex> lock(m_MeshMutex);
+
+    return std::all_of(m_Meshes.begin(), m_Meshes.end(), []( const auto &mesh ) { return mesh->IsReady(); });
+}
+
+void Model::AddLoadedModel( Model &loaded, std::shared_ptr<CommandQueue> queue, uint64_t fenceValue,
+                            const std::vector<std::shared_ptr<TextureUpload>> &textureUploads )
 {
-    if (node->mNumMeshes != 0)
+    // Materials do not say which textures their mesh reads, so every mesh waits for every shared upload.
+    for (auto &mesh: loaded.m_Meshes)
     {
-        ProcessMeshes(scene, node, model, commandList);
+        mesh->SetUploadFence(queue, fenceValue, textureUploads);
     }
-    for (auto x = 0; x < node->mNumChildren; x++)
+
+    std::lock_guard<std::mutex> lock(m_MeshMutex);
+
+    size_t firstNode = m_Nodes.size();
+    size_t firstMesh = m_Meshes.size();
+    for (const auto &node: loaded.m_Nodes)
     {
-        ProcessNode(scene, node->mChildren[x], model, commandList);
+        AddNode(node, loaded.m_NodeMeshes.data() + node.FirstMesh, firstNode, firstMesh);
     }
-    if ( node->mNumChildren == 0 )
+    m_Meshes.insert(m_Meshes.end(), std::make_move_iterator(loaded.m_Meshes.begin()),
+                    std::make_move_iterator(loaded.m_Meshes.end()));
+    m_Textures.insert(m_Textures.end(), std::make_move_iterator(loaded.m_Textures.begin()),
+                      std::make_move_iterator(loaded.m_Textures.end()));
+    m_Materials.insert(m_Materials.end(), loaded.m_Materials.begin(), loaded.m_Materials.end());
+    m_TextureIndices.insert(m_TextureIndices.end(), loaded.m_TextureIndices.begin(), loaded.m_TextureIndices.end());
+    if (!m_MaterialTable)
     {
-        return nullptr;
+        m_MaterialTable = loaded.m_MaterialTable;
     }
-    return nullptr;
+    m_NumMeshes += loaded.m_NumMeshes;
+    m_LoadStatistics.NumMeshes += loaded.m_LoadStatistics.NumMeshes;
+    m_LoadStatistics.NumSharedMeshes += loaded.m_LoadStatistics.NumSharedMeshes;
+    m_LoadStatistics.NumTextures += loaded.m_LoadStatistics.NumTextures;
+    m_LoadStatistics.NumSharedTextures += loaded.m_LoadStatistics.NumSharedTextures;
+    m_LoadStatistics.DeduplicatedGeometryBytes += loaded.m_LoadStatistics.DeduplicatedGeometryBytes;
+    m_LoadStatistics.DeduplicatedTextureBytes += loaded.m_LoadStatistics.DeduplicatedTextureBytes;
+    loaded.m_Meshes.clear();
+    loaded.m_Textures.clear();
+    loaded.m_Materials.clear();
+    loaded.m_TextureIndices.clear();
+    loaded.m_Nodes.clear();
+    loaded.m_NodeMeshes.clear();
+    loaded.m_NumMeshes = 0;
+}
 
-};
+void Model::AddNode( const Assets::CookedNode &node, const uint32_t* nodeMeshes, size_t firstNode, size_t firstMesh )
+{
+    Assets::CookedNode added = node;
+    added.Parent = node.Parent < 0 ? -1 : static_cast<int32_t>(firstNode + node.Parent);
+    added.FirstMesh = static_cast<uint32_t>(m_NodeMeshes.size());
+    m_Nodes.push_back(added);
+    for (uint32_t i = 0; i < node.NumMeshes; ++i)
+    {
+        m_NodeMeshes.push_back(static_cast<uint32_t>(firstMesh + nodeMeshes[i]));
+    }
+}
 
+void Model::AddNodes( Enterprise::Scene::TransformHierarchy*                      transforms,
+                      Enterprise::Scene::TransformHierarchy::Handle               parent,
+                      std::vector<Enterprise::Scene::TransformHierarchy::Handle>* handles ) const
+{
+    std::lock_guard<std::mutex> lock(m_MeshMutex);
 
-bool Model::ImportModel( const std::string &pFile, Model* model, CommandList* commandList, const std::wstring &modelName )
+    Enterprise::Scene::AddModelNodes(m_Nodes.data(), static_cast<uint32_t>(m_Nodes.size()), parent, transforms,
+                                     handles);
+}
+
+void Model::Draw( CommandList &commandList, Geometry::VertexFormat vertexFormat, const MeshDrawParams &params ) const
 {
-    Assimp::Importer importer;
-    model->m_Meshes.reserve(16);
-    const aiScene* scene = importer.ReadFile( pFile,
-        aiProcess_ConvertToLeftHanded |
-        aiProcessPreset_TargetRealtime_Quality);
+    std::lock_guard<std::mutex> lock(m_MeshMutex);
 
-    if (scene == nullptr)
+    CullMeshes(params, vertexFormat);
+    for (uint32_t index: m_VisibleMeshes)
     {
-        EE_CORE_ERROR("Unable to import model; {}", pFile);
-        return false;
+        m_Meshes[index]->Draw(commandList, params);
     }
-    auto node = scene->mRootNode;
-    while (node != nullptr)
+}
+
+void Model::Enqueue( const MeshDrawParams &       params, uint32_t pass, const float cameraPosition[3],
+                     Enterprise::Scene::RenderQueue* queue, std::vector<Mesh*>* meshes ) const
+{
+    std::lock_guard<std::mutex> lock(m_MeshMutex);
+
+    CullMeshes(params, Geometry::VertexFormat::NumFormats);
+    for (uint32_t index: m_VisibleMeshes)
+    {
+        Mesh*       mesh = m_Meshes[index].get();
+        const auto &center = mesh->GetBounds().Sphere.Center;
+        float       dx = center[0] - cameraPosition[0];
+        float       dy = center[1] - cameraPosition[1];
+        float       dz = center[2] - cameraPosition[2];
+        float       distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+        queue->Add(Enterprise::Scene::RenderQueue::MakeKey(pass, static_cast<uint32_t>(mesh->GetVertexFormat()),
+                                                           mesh->GetMaterial(), distance),
+                   static_cast<uint32_t>(meshes->size()));
+        meshes->push_back(mesh);
+    }
+}
+
+void Model::CullMeshes( const MeshDrawParams &params, Geometry::VertexFormat vertexFormat ) const
+{
+    auto isDrawn = [&params, vertexFormat]( Mesh &mesh )
+    {
+        return (vertexFormat == Geometry::VertexFormat::NumFormats || mesh.GetVertexFormat() == vertexFormat) &&
+               mesh.IsReady() && (params.Occlusion == nullptr ||
+                                  params.Occlusion->IsVisible(params.ModelToClip, mesh.GetBounds().Box));
+    };
+
+    m_VisibleMeshes.clear();
+    if (params.CullParams == nullptr)
     {
-        node = model->ProcessNode(scene, scene->mRootNode, model, commandList);
+        for (uint32_t i = 0; i < m_Meshes.size(); ++i)
+        {
+            if (isDrawn(*m_Meshes[i]))
+            {
+                m_VisibleMeshes.push_back(i);
+            }
+        }
+        return;
     }
-    if (scene->mNumTextures > 0)
+
+    // Meshes are only ever appended, by the loaders or AddLoadedModel, so only the new ones need their bounds.
+    for (size_t i = m_MeshBounds.GetCount(); i < m_Meshes.size(); ++i)
     {
-        std::vector<Texture> textures;
-        ProcessEmbeddedTextures(scene, &textures, commandList, modelName);
+        m_MeshBounds.Add(m_Meshes[i]->GetBounds());
     }
+    m_MeshBounds.Cull(params.CullParams->Planes, &m_VisibleMeshes);
+    m_VisibleMeshes.erase(std::remove_if(m_VisibleMeshes.begin(), m_VisibleMeshes.end(),
+                                         [&]( uint32_t index ) { return !isDrawn(*m_Meshes[index]); }),
+                          m_VisibleMeshes.end());
+}
 
-    return true;
+void Model::AddOccluders( Geometry::OcclusionCuller* culler, const float modelToClip[16] ) const
+{
+    std::lock_guard<std::mutex> lock(m_MeshMutex);
+
+    for (const auto &mesh: m_Meshes)
+    {
+        if (const auto* occluder = mesh->GetOccluder())
+        {
+            culler->AddOccluder(modelToClip, *occluder);
+        }
+    }
+}
+
+Geometry::MeshBounds Model::GetBounds() const
+{
+    std::lock_guard<std::mutex> lock(m_MeshMutex);
+
+    if (m_Meshes.empty())
+    {
+        return {};
+    }
+    Geometry::MeshBounds bounds = m_Meshes[0]->GetBounds();
+    for (size_t i = 1; i < m_Meshes.size(); ++i)
+    {
+        bounds = Geometry::MergeBounds(bounds, m_Meshes[i]->GetBounds());
+    }
+    return bounds;
 }
 
-void Model::Draw(CommandList& commandList) const
+bool Model::Pick( const Geometry::Ray &ray, ModelPickResult* result ) const
 {
-    for (auto&& mesh : m_Meshes)
+    std::lock_guard<std::mutex> lock(m_MeshMutex);
+
+    *result = ModelPickResult();
+    if (m_PickBvh.GetNumPrimitives() != m_Meshes.size())
     {
-        mesh->Draw(commandList);
+        std::vector<Geometry::BoundingBox> bounds;
+        bounds.reserve(m_Meshes.size());
+        for (const auto &mesh: m_Meshes)
+        {
+            bounds.push_back(mesh->GetBounds().Box);
+        }
+        m_PickBvh.Build(bounds.data(), static_cast<uint32_t>(bounds.size()), false);
+    }
+
+    // Candidates come nearest first, so once one starts beyond the closest hit none of the rest can be closer.
+    m_PickBvh.IntersectBounds(ray, &m_PickCandidates);
+    Geometry::Ray meshRay = ray;
+    for (const auto &candidate: m_PickCandidates)
+    {
+        if (candidate.Distance > meshRay.MaxDistance)
+        {
+            break;
+        }
+        const auto*      bvh = m_Meshes[candidate.Primitive]->GetTriangleBvh();
+        Geometry::RayHit hit;
+        if (bvh != nullptr && bvh->Intersect(meshRay, &hit))
+        {
+            result->Mesh = candidate.Primitive;
+            result->Hit = hit;
+            meshRay.MaxDistance = hit.Distance;
+        }
     }
+    return result->Mesh != Geometry::INVALID_PRIMITIVE;
 }
 
 }
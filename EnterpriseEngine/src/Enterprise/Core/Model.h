@@ -6,11 +6,16 @@
 #define MODEL_H
 
 #include <DirectXMath.h>
-#include "Mesh.h"
-#include "assimp/scene.h"
+#include <future>
+#include <mutex>
 
+#include "Mesh.h"
+#include "../Assets/CookedModel.h"
+#include "../Assets/ModelData.h"
+#include "../Assets/TextureDecoder.h"
+#include "../Scene/RenderQueue.h"
+#include "../Scene/TransformHierarchy.h"
 
-struct aiNode;
 
 namespace Enterprise::Core::Graphics {
 struct Matrices {
@@ -20,33 +25,190 @@ struct Matrices {
     DirectX::XMMATRIX ModelViewProjectionMatrix;
 };
 
+// What a model load found already resident, from other models or earlier in the same one.
+struct ModelLoadStatistics {
+    uint32_t NumMeshes = 0;
+    uint32_t NumSharedMeshes = 0;
+    uint32_t NumTextures = 0;
+    uint32_t NumSharedTextures = 0;
+    // Bytes that were shared instead of uploaded again.
+    uint64_t DeduplicatedGeometryBytes = 0;
+    uint64_t DeduplicatedTextureBytes = 0;
+};
+
+struct ModelPickResult {
+    // Index of the mesh hit, in the order the meshes were added.
+    uint32_t         Mesh = Geometry::INVALID_PRIMITIVE;
+    Geometry::RayHit Hit;
+};
+
 class Model {
 public:
-    Model(): m_PositionWS(DirectX::XMVECTOR()), m_NumMeshes(0), m_NumInstances(1)
+    Model(): m_PositionWS(DirectX::XMVECTOR()), m_NumMeshes(0)
     {
     };
 
 
-    ~Model() = default;
+    // Frees the model's materials and texture indices in the material table.
+    ~Model();
 
-    aiNode *ProcessNode( const aiScene* scene, aiNode* node, Model* model, CommandList* commandList );
+    /**
+     * Load a model, preferring the cooked version next to the source file.
+     * Falls back to importing the source through assimp and writes the cooked file for the next run.
+     */
+    static bool LoadModel( const std::string &pFile, Model* model, CommandList* commandList, const std::wstring &modelName );
 
     static bool ImportModel( const std::string &pFile, Model* model, CommandList* commandList, const std::wstring &modelName );
 
-    void Draw( CommandList &commandList ) const;
+    /**
+     * Load a model from a cooked file. The file is memory mapped and the vertex and index
+     * streams are copied to the GPU straight from the mapping.
+     */
+    static bool LoadCookedModel( const std::string &cookedFile, Model* model, CommandList* commandList,
+                                 const std::wstring &modelName );
+
+    /**
+     * Import a model through assimp and write it out in the cooked format.
+     */
+    static bool CookModel( const std::string &pFile, const std::string &cookedFile );
+
+    static std::string GetCookedPath( const std::string &pFile ) { return pFile + ".emdl"; }
+
+    /**
+     * Load a model on the thread pool and return right away. Parsing and conversion run in the background and
+     * the uploads are recorded and executed on the copy queue. The meshes are handed to model once submitted
+     * and drawn once their upload fence completes and GeometryArena::FinishUploads has handed their geometry to
+     * the direct queue, so model can be drawn while it loads.
+     * The future holds whether the load succeeded, or the exception the load threw.
+     */
+    static std::future<bool> LoadModelAsync( const std::string &pFile, std::shared_ptr<Model> model,
+                                             const std::wstring &modelName );
+
+    /**
+     * True when every mesh of the model has finished uploading.
+     */
+    [[nodiscard]] bool IsReady() const;
+
+    /**
+     * Draw the meshes stored in vertexFormat that have finished uploading.
+     * The caller binds the pipeline state for that format.
+     * With cull parameters, meshes whose bounds are outside the frustum are skipped before their meshlets are,
+     * and with an occlusion culler so are meshes hidden behind its occluders.
+     */
+    void Draw( CommandList &commandList, Geometry::VertexFormat vertexFormat, const MeshDrawParams &params = {} ) const;
+
+    /**
+     * Queue the meshes of every vertex format that Draw would draw with params, keyed by pass, vertex format as the
+     * pipeline, material and distance from cameraPosition to the centre of their bounds, in model space. Payloads
+     * index meshes, which the queued meshes are appended to.
+     */
+    void Enqueue( const MeshDrawParams &       params, uint32_t pass, const float cameraPosition[3],
+                  Enterprise::Scene::RenderQueue* queue, std::vector<Mesh*>* meshes ) const;
+
+    /**
+     * Queue the occluder triangles of the meshes that have them, see Mesh::GetOccluder.
+     */
+    void AddOccluders( Geometry::OcclusionCuller* culler, const float modelToClip[16] ) const;
+
+    /**
+     * Bounds of every mesh so far in model space, infinite if a mesh is never culled.
+     */
+    [[nodiscard]] Geometry::MeshBounds GetBounds() const;
 
     void AddMesh( const std::vector<VertexPosNormalTexture> &verts, const std::vector<uint32_t> &indices,
                   CommandList*                               commandList )
     {
         m_Meshes.emplace_back(std::make_unique<Mesh>(verts, indices, commandList));
         m_NumMeshes += 1;
+        AddMeshStatistics(verts.size() * sizeof(VertexPosNormalTexture), indices.size());
     }
 
+    void AddMesh( const void* vertexData, size_t numVertices, size_t vertexStride, const uint32_t* indices,
+                  size_t      numIndices, CommandList*  commandList,
+                  Geometry::VertexFormat                    vertexFormat = Geometry::VertexFormat::Float,
+                  const Geometry::VertexQuantizationParams &quantization = {} )
+    {
+        m_Meshes.emplace_back(std::make_unique<Mesh>(vertexData, numVertices, vertexStride, indices, numIndices,
+                                                     commandList, vertexFormat, quantization));
+        m_NumMeshes += 1;
+        AddMeshStatistics(numVertices * vertexStride, numIndices);
+    }
+
+    /**
+     * Add the node hierarchy of the model below parent, for the scene to place its meshes. The handle of every
+     * node goes to handles, in load order. The model itself is still drawn with a single model matrix.
+     */
+    void AddNodes( Enterprise::Scene::TransformHierarchy*                      transforms,
+                   Enterprise::Scene::TransformHierarchy::Handle               parent,
+                   std::vector<Enterprise::Scene::TransformHierarchy::Handle>* handles ) const;
+
+    [[nodiscard]] const ModelLoadStatistics &GetLoadStatistics() const { return m_LoadStatistics; }
+
+    /**
+     * Find the closest triangle of the model along a ray in model space. Meshes are found through a hierarchy
+     * over their bounds and only those the ray reaches before the closest hit so far are traced.
+     */
+    bool Pick( const Geometry::Ray &ray, ModelPickResult* result ) const;
+
 private:
+    // Count the mesh just added, and its bytes if it shares geometry with another mesh.
+    void AddMeshStatistics( size_t vertexBytes, size_t numIndices )
+    {
+        m_LoadStatistics.NumMeshes += 1;
+        if (m_Meshes.back()->IsGeometryShared())
+        {
+            m_LoadStatistics.NumSharedMeshes += 1;
+            m_LoadStatistics.DeduplicatedGeometryBytes += vertexBytes + numIndices * sizeof(uint32_t);
+        }
+    }
+
+    // Append a node whose parent and meshes are relative to firstNode and firstMesh.
+    void AddNode( const Assets::CookedNode &node, const uint32_t* nodeMeshes, size_t firstNode, size_t firstMesh );
+
+    // Fill m_VisibleMeshes with the meshes of vertexFormat, or of every format for NumFormats, that are ready and
+    // pass the culling of params. Needs m_MeshMutex.
+    void CullMeshes( const MeshDrawParams &params, Geometry::VertexFormat vertexFormat ) const;
+
+    // Take over the meshes and textures of loaded, whose uploads complete at fenceValue on queue and once the
+    // uploads of the textures it shares from other loads complete.
+    void AddLoadedModel( Model &loaded, std::shared_ptr<CommandQueue> queue, uint64_t fenceValue,
+                         const std::vector<std::shared_ptr<TextureUpload>> &textureUploads );
+
+    // Decode the embedded textures in parallel and upload them, keyed in the texture cache by the hash of their
+    // encoded data, so one that is already resident is shared rather than decoded and uploaded again.
+    // <modelName>-E<index> is only their debug name.
+    // The material table index of every image goes to textureIndices, NO_TEXTURE for images that failed to load.
+    void LoadEmbeddedTextures( const std::vector<Assets::EncodedImage> &images, CommandList* commandList,
+                               const std::wstring &                     modelName,
+                               std::vector<uint32_t>*                   textureIndices );
+
+    // Add materials to the material table, their textures mapped through textureIndices, and hand them to the
+    // meshes from firstMesh on by meshMaterials. Meshes whose material index is out of range keep the default.
+    void LoadMaterials( const Assets::MaterialData* materials, size_t numMaterials,
+                        const std::vector<uint32_t> &textureIndices, size_t firstMesh,
+                        const std::vector<uint32_t> &meshMaterials );
+
     DirectX::XMVECTOR                      m_PositionWS;
-    uint8_t                                m_NumInstances;
     std::vector<std::unique_ptr<Mesh> >    m_Meshes;
-    uint8_t                                m_NumMeshes;
+    std::vector<Texture>                   m_Textures;
+    std::shared_ptr<MaterialTable>         m_MaterialTable;
+    std::vector<MaterialHandle>            m_Materials;
+    // Material table indices of the textures, one reference each.
+    std::vector<uint32_t>                  m_TextureIndices;
+    uint32_t                               m_NumMeshes;
+    // Node hierarchy of every load, parents before children, see Assets::CookedNode. Node mesh ranges index
+    // m_NodeMeshes, which indexes m_Meshes.
+    std::vector<Assets::CookedNode>        m_Nodes;
+    std::vector<uint32_t>                  m_NodeMeshes;
+    ModelLoadStatistics                    m_LoadStatistics;
+    // Model space bounds of m_Meshes, in the same order, and scratch for the meshes that pass the frustum test.
+    mutable Geometry::BoundsCuller         m_MeshBounds;
+    mutable std::vector<uint32_t>          m_VisibleMeshes;
+    // Hierarchy over the mesh bounds for picking, rebuilt when meshes were added, and scratch for its candidates.
+    mutable Geometry::Bvh                  m_PickBvh;
+    mutable std::vector<Geometry::RayHit>  m_PickCandidates;
+    // Guards the meshes against an asynchronous load adding to them while drawing.
+    mutable std::mutex                     m_MeshMutex;
 };
 }
 
@@ -0,0 +1,158 @@
+#include "OffsetAllocator.h"
+
+#include <cassert>
+
+
+namespace Enterprise::Core {
+
+OffsetAllocator::OffsetAllocator( SizeType size )
+    : m_Size(size)
+    , m_FreeSize(size)
+{
+    if (size > 0)
+    {
+        AddFreeBlock(0, size);
+    }
+}
+
+OffsetAllocator::OffsetType OffsetAllocator::Allocate( SizeType size )
+{
+    if (size == 0 || size > m_FreeSize)
+    {
+        return INVALID_OFFSET;
+    }
+
+    // Smallest block that fits, which keeps large blocks intact for large requests.
+    auto smallestBlockIter = m_FreeListBySize.lower_bound(size);
+    if (smallestBlockIter == m_FreeListBySize.end())
+    {
+        return INVALID_OFFSET;
+    }
+
+    SizeType   blockSize = smallestBlockIter->first;
+    auto       offsetIter = smallestBlockIter->second;
+    OffsetType offset = offsetIter->first;
+
+    m_FreeListBySize.erase(smallestBlockIter);
+    m_FreeListByOffset.erase(offsetIter);
+
+    if (blockSize > size)
+    {
+        AddFreeBlock(offset + size, blockSize - size);
+    }
+
+    m_FreeSize -= size;
+    m_Allocations.emplace(offset, size);
+    return offset;
+}
+
+void OffsetAllocator::Free( OffsetType offset )
+{
+    auto allocationIter = m_Allocations.find(offset);
+    assert(allocationIter != m_Allocations.end() && "Freeing an offset that was not allocated.");
+    if (allocationIter == m_Allocations.end())
+    {
+        return;
+    }
+
+    SizeType size = allocationIter->second;
+    m_Allocations.erase(allocationIter);
+    FreeBlock(offset, size);
+}
+
+void OffsetAllocator::Grow( SizeType newSize )
+{
+    if (newSize <= m_Size)
+    {
+        return;
+    }
+
+    SizeType oldSize = m_Size;
+    m_Size = newSize;
+    FreeBlock(oldSize, newSize - oldSize);
+}
+
+std::vector<OffsetAllocator::Move> OffsetAllocator::Defragment()
+{
+    std::vector<Move> moves;
+    moves.reserve(m_Allocations.size());
+
+    std::map<OffsetType, SizeType> allocations;
+    OffsetType                     offset = 0;
+    for (const auto &[source, size]: m_Allocations)
+    {
+        moves.push_back({source, offset, size});
+        allocations.emplace_hint(allocations.end(), offset, size);
+        offset += size;
+    }
+
+    m_Allocations.swap(allocations);
+    m_FreeListByOffset.clear();
+    m_FreeListBySize.clear();
+    if (offset < m_Size)
+    {
+        AddFreeBlock(offset, m_Size - offset);
+    }
+
+    return moves;
+}
+
+OffsetAllocator::SizeType OffsetAllocator::GetLargestFreeBlock() const
+{
+    return m_FreeListBySize.empty() ? 0 : m_FreeListBySize.rbegin()->first;
+}
+
+float OffsetAllocator::GetFragmentation() const
+{
+    if (m_FreeSize == 0)
+    {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(GetLargestFreeBlock()) / static_cast<float>(m_FreeSize);
+}
+
+void OffsetAllocator::AddFreeBlock( OffsetType offset, SizeType size )
+{
+    auto offsetIter = m_FreeListByOffset.emplace(offset, size);
+    auto sizeIter = m_FreeListBySize.emplace(size, offsetIter.first);
+    offsetIter.first->second.FreeListBySizeIter = sizeIter;
+}
+
+void OffsetAllocator::FreeBlock( OffsetType offset, SizeType size )
+{
+    m_FreeSize += size;
+
+    // First free block after the one being freed, and the one before it if any.
+    auto nextBlockIter = m_FreeListByOffset.upper_bound(offset);
+    auto prevBlockIter = nextBlockIter;
+    if (prevBlockIter != m_FreeListByOffset.begin())
+    {
+        --prevBlockIter;
+    } else
+    {
+        prevBlockIter = m_FreeListByOffset.end();
+    }
+
+    if (prevBlockIter != m_FreeListByOffset.end() && offset == prevBlockIter->first + prevBlockIter->second.Size)
+    {
+        // Merge with the block directly before.
+        offset = prevBlockIter->first;
+        size += prevBlockIter->second.Size;
+
+        m_FreeListBySize.erase(prevBlockIter->second.FreeListBySizeIter);
+        m_FreeListByOffset.erase(prevBlockIter);
+    }
+
+    if (nextBlockIter != m_FreeListByOffset.end() && offset + size == nextBlockIter->first)
+    {
+        // Merge with the block directly after.
+        size += nextBlockIter->second.Size;
+
+        m_FreeListBySize.erase(nextBlockIter->second.FreeListBySizeIter);
+        m_FreeListByOffset.erase(nextBlockIter);
+    }
+
+    AddFreeBlock(offset, size);
+}
+
+}
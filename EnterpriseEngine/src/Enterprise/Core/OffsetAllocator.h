@@ -0,0 +1,100 @@
+#ifndef OFFSETALLOCATOR_H
+#define OFFSETALLOCATOR_H
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+
+namespace Enterprise::Core {
+
+/**
+ * Best fit allocator for ranges of a linear resource such as a buffer.
+ * It only hands out offsets, in whatever unit the caller uses, and never touches the memory itself.
+ * Free blocks are kept by offset for coalescing and by size for the best fit search, as in DescriptorAllocatorPage.
+ * Not thread safe, the owner is expected to lock around it.
+ */
+class OffsetAllocator {
+public:
+    using OffsetType = uint32_t;
+    using SizeType = uint32_t;
+
+    static constexpr OffsetType INVALID_OFFSET = UINT32_MAX;
+
+    explicit OffsetAllocator( SizeType size = 0 );
+
+    /**
+     * Allocate size units. Returns INVALID_OFFSET when no free block is large enough.
+     */
+    OffsetType Allocate( SizeType size );
+
+    /**
+     * Return an allocation to the free list, merging it with its free neighbours.
+     */
+    void Free( OffsetType offset );
+
+    /**
+     * Extend the allocator to newSize units, the new space follows the current end.
+     */
+    void Grow( SizeType newSize );
+
+    struct Move {
+        OffsetType Source;
+        OffsetType Destination;
+        SizeType   Size;
+    };
+
+    /**
+     * Pack all allocations to the start of the range, keeping their order, which leaves a single free block at
+     * the end. Returns one move per allocation in offset order, including those that stay in place, so the
+     * caller can copy the live data into a new resource.
+     */
+    std::vector<Move> Defragment();
+
+    [[nodiscard]] SizeType GetSize() const { return m_Size; }
+
+    [[nodiscard]] SizeType GetFreeSize() const { return m_FreeSize; }
+
+    [[nodiscard]] SizeType GetUsedSize() const { return m_Size - m_FreeSize; }
+
+    [[nodiscard]] SizeType GetLargestFreeBlock() const;
+
+    [[nodiscard]] size_t GetNumAllocations() const { return m_Allocations.size(); }
+
+    [[nodiscard]] size_t GetNumFreeBlocks() const { return m_FreeListByOffset.size(); }
+
+    /**
+     * Share of the free space that is not in the largest free block, 0 when all free space is contiguous.
+     */
+    [[nodiscard]] float GetFragmentation() const;
+
+private:
+    void AddFreeBlock( OffsetType offset, SizeType size );
+
+    void FreeBlock( OffsetType offset, SizeType size );
+
+private:
+    struct FreeBlockInfo;
+    using FreeListByOffset = std::map<OffsetType, FreeBlockInfo>;
+    using FreeListBySize = std::multimap<SizeType, FreeListByOffset::iterator>;
+
+    struct FreeBlockInfo {
+        FreeBlockInfo( SizeType size )
+            : Size(size)
+        {}
+
+        SizeType                 Size;
+        FreeListBySize::iterator FreeListBySizeIter;
+    };
+
+    FreeListByOffset                m_FreeListByOffset;
+    FreeListBySize                  m_FreeListBySize;
+    // Size of every live allocation by offset.
+    std::map<OffsetType, SizeType>  m_Allocations;
+    SizeType                        m_Size;
+    SizeType                        m_FreeSize;
+};
+
+}
+
+#endif //OFFSETALLOCATOR_H
@@ -60,10 +60,17 @@ Renderer::Renderer( uint32_t width, uint32_t height )
       , m_AppUpdateHandler([this]( const events::AppUpdateEvent &e ) { OnUpdateEvent(e); })
       , m_AppRenderHandler([this]( const events::AppRenderEvent &e ) { OnRenderEvent(e); })
       , m_AppWindowResizeEventHandler([this]( const events::AppWindowResizeEvent &e ) { OnResizeEvent(e); })
+      , m_MouseEventHandler([this]( const events::MouseEvent &e ) { OnMouseEvent(e); })
       , m_Camera(width, height)
 {
+    m_MemoryAllocator = std::make_shared<GpuMemoryAllocator>();
+    m_GeometryArena = std::make_shared<GeometryArena>();
+    m_MaterialTable = std::make_shared<MaterialTable>();
+    m_ModelViewProjectionMatrix = XMMatrixIdentity();
+
     events::Subscribe<events::AppRenderEvent>(m_AppRenderHandler);
     events::Subscribe<events::AppUpdateEvent>(m_AppUpdateHandler);
+    events::Subscribe<events::MouseEvent>(m_MouseEventHandler);
 }
 
 
@@ -317,8 +324,15 @@ void Renderer::Initialize( const Window* window )
     m_Camera.SetProjection(45.0, aspect, 0.01f, 100.0f);
     ComPtr<IDXGIAdapter4> dxgiAdapter4 = GetAdapter(FALSE);
 
+    // Textures get half of the video memory the OS grants the process, the rest is for render targets and
+    // geometry. Unreferenced textures are evicted past that.
+    DXGI_QUERY_VIDEO_MEMORY_INFO videoMemoryInfo = {};
     if (dxgiAdapter4)
+    {
         m_D3D12Device = CreateDevice(dxgiAdapter4);
+        ThrowIfFailed(dxgiAdapter4->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &videoMemoryInfo));
+    }
+    m_TextureCache = std::make_shared<TextureCache>(videoMemoryInfo.Budget / 2);
 
     if (m_D3D12Device)
     {
@@ -348,16 +362,23 @@ bool Renderer::LoadContent()
     // m_DemoCube = Mesh::CreateDemoCube(*commandList, 1);
     auto commandQueue = GetCommandQueue(D3D12_COMMAND_LIST_TYPE_COPY);
     auto commandList = commandQueue->GetCommandList();
-    m_Model = std::make_unique<Model>();
-    Model::ImportModel("C:/dev/Enterprise/EnterpriseEngine/resources/assets/models/Fighter Jet.glb", m_Model.get(), commandList.get(), L"jet");
+    // The model streams in on the thread pool and shows up once its uploads complete.
+    m_Model = std::make_shared<Model>();
+    Enterprise::Scene::Transform modelTransform;
+    modelTransform.Position[2] = 10.0f;
+    XMStoreFloat4(reinterpret_cast<XMFLOAT4 *>(modelTransform.Rotation), XMQuaternionRotationRollPitchYaw(0.0f, 0.0f, 0.7f));
+    modelTransform.Scale[0] = modelTransform.Scale[1] = modelTransform.Scale[2] = 0.02f;
+    m_ModelNode = m_Scene.GetTransforms().AddNode(Enterprise::Scene::TransformHierarchy::INVALID_HANDLE, modelTransform);
+    m_ModelLoad = Model::LoadModelAsync("C:/dev/Enterprise/EnterpriseEngine/resources/assets/models/Fighter Jet.glb", m_Model, L"jet");
 
     commandList->LoadTextureFromFile(m_DefaultTexture, L"C:/dev/Enterprise/EnterpriseEngine/resources/assets/textures/DefaultWhite.bmp", false);
+    m_MaterialTable->SetDefaultTexture(m_DefaultTexture);
     //D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
     //dsvHeapDesc.NumDescriptors = 1;
     //dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
     //dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
     //ThrowIfFailed(m_D3D12Device->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&m_DSVHeap)));
-    commandQueue->ExecuteCommandList(commandList);
+    uint64_t contentFenceValue = commandQueue->ExecuteCommandList(commandList);
 
     DXGI_FORMAT sdrFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
     DXGI_FORMAT depthFormat = DXGI_FORMAT_D32_FLOAT;
@@ -391,6 +412,9 @@ bool Renderer::LoadContent()
     ComPtr<ID3DBlob> vertexShaderBlob;
     ThrowIfFailed(D3DReadFileToBlob(L"VertexShader.cso", &vertexShaderBlob));
 
+    ComPtr<ID3DBlob> packedVertexShaderBlob;
+    ThrowIfFailed(D3DReadFileToBlob(L"VertexShaderPacked.cso", &packedVertexShaderBlob));
+
     ComPtr<ID3DBlob> pixelShaderBlob;
     ThrowIfFailed(D3DReadFileToBlob(L"PixelShader.cso", &pixelShaderBlob));
 
@@ -410,6 +434,38 @@ bool Renderer::LoadContent()
         },
     };
 
+    // Geometry::PackedVertex
+    D3D12_INPUT_ELEMENT_DESC packedInputLayout[] = {
+        {
+            "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT,
+            D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+        },
+        {
+            "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, D3D12_APPEND_ALIGNED_ELEMENT,
+            D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+        },
+        {
+            "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT,
+            D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+        },
+    };
+
+    // Geometry::QuantizedVertex
+    D3D12_INPUT_ELEMENT_DESC quantizedInputLayout[] = {
+        {
+            "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, D3D12_APPEND_ALIGNED_ELEMENT,
+            D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+        },
+        {
+            "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, D3D12_APPEND_ALIGNED_ELEMENT,
+            D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+        },
+        {
+            "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT,
+            D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+        },
+    };
+
     D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
     featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
     if (FAILED(m_D3D12Device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
@@ -427,10 +483,17 @@ bool Renderer::LoadContent()
 
     CD3DX12_STATIC_SAMPLER_DESC linearRepeatSampler(0, D3D12_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR);
 
-    CD3DX12_ROOT_PARAMETER1 rootParameters[3];
+    CD3DX12_ROOT_PARAMETER1 rootParameters[7];
     rootParameters[0].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_VERTEX);
     rootParameters[1].InitAsDescriptorTable(1, &descriptorRange, D3D12_SHADER_VISIBILITY_PIXEL);
     rootParameters[2].InitAsShaderResourceView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL);
+    rootParameters[VERTEX_QUANTIZATION_ROOT_PARAMETER].InitAsConstants(
+        sizeof(Geometry::VertexQuantizationParams) / sizeof(uint32_t), 1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+    rootParameters[MATERIAL_TABLE_ROOT_PARAMETER].InitAsShaderResourceView(2, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE,
+                                                                           D3D12_SHADER_VISIBILITY_PIXEL);
+    rootParameters[MATERIAL_ROOT_PARAMETER].InitAsConstants(1, 2, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+    rootParameters[INSTANCE_ROOT_PARAMETER].InitAsShaderResourceView(3, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE,
+                                                                     D3D12_SHADER_VISIBILITY_VERTEX);
 
     CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
     rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 1, &linearRepeatSampler, rootSignatureFlags);
@@ -455,19 +518,42 @@ bool Renderer::LoadContent()
     rtvFormats.RTFormats[0] = sdrFormat;
 
     pipelineStateStream.pRootSignature = m_GraphicsRootSignature.GetRootSignature().Get();
-    pipelineStateStream.InputLayout = {inputLayout, _countof(inputLayout)};
     pipelineStateStream.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-    pipelineStateStream.VS = CD3DX12_SHADER_BYTECODE(vertexShaderBlob.Get());
     pipelineStateStream.PS = CD3DX12_SHADER_BYTECODE(pixelShaderBlob.Get());
     pipelineStateStream.DSVFormat = depthFormat;
     pipelineStateStream.RTVFormats = rtvFormats;
 
-    D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = {
-        sizeof(PipelineStateStream), &pipelineStateStream
+    // One pipeline state per vertex format, the packed formats share a vertex shader.
+    struct VertexFormatPipeline {
+        Geometry::VertexFormat    Format;
+        D3D12_INPUT_LAYOUT_DESC   InputLayout;
+        ID3DBlob*                 VertexShader;
+    } vertexFormatPipelines[] = {
+        {Geometry::VertexFormat::Float, {inputLayout, _countof(inputLayout)}, vertexShaderBlob.Get()},
+        {
+            Geometry::VertexFormat::PackedNormalTexCoord, {packedInputLayout, _countof(packedInputLayout)},
+            packedVertexShaderBlob.Get()
+        },
+        {
+            Geometry::VertexFormat::Quantized, {quantizedInputLayout, _countof(quantizedInputLayout)},
+            packedVertexShaderBlob.Get()
+        },
     };
-    ThrowIfFailed(m_D3D12Device->CreatePipelineState(&pipelineStateStreamDesc, IID_PPV_ARGS(&m_PipelineState)));
 
-    m_CopyCommandQueue->Flush();
+    for (const auto &pipeline: vertexFormatPipelines)
+    {
+        pipelineStateStream.InputLayout = pipeline.InputLayout;
+        pipelineStateStream.VS = CD3DX12_SHADER_BYTECODE(pipeline.VertexShader);
+
+        D3D12_PIPELINE_STATE_STREAM_DESC pipelineStateStreamDesc = {
+            sizeof(PipelineStateStream), &pipelineStateStream
+        };
+        ThrowIfFailed(m_D3D12Device->CreatePipelineState(&pipelineStateStreamDesc,
+                                                         IID_PPV_ARGS(&m_PipelineStates[size_t(pipeline.Format)])));
+    }
+
+    // Only wait for the content above, not for models that are still loading.
+    m_CopyCommandQueue->WaitForFenceValue(contentFenceValue);
     m_ContentLoaded = true;
 
     return true;
@@ -475,6 +561,10 @@ bool Renderer::LoadContent()
 
 void Renderer::Shutdown() const
 {
+    if (m_ModelLoad.valid())
+    {
+        m_ModelLoad.wait();
+    }
     m_DirectCommandQueue->Flush();
     m_CopyCommandQueue->Flush();
 }
@@ -489,27 +579,60 @@ void Renderer::OnRenderEvent( const events::AppRenderEvent &event )
     }
     auto commandList = m_DirectCommandQueue->GetCommandList();
 
-    // Clear render targets.
+    // The frame as a graph of passes, which places the barriers between them.
+    using Enterprise::RenderGraph::ResourceState;
+    const Texture &color = m_RenderTarget.GetTexture(AttachmentPoint::Color0);
+    const Texture &depth = m_RenderTarget.GetTexture(AttachmentPoint::DepthStencil);
+    Texture*       backBuffer = &m_BackBufferTextures[m_CurrentBackBufferIndex];
+    bool           resolve = color.GetD3D12ResourceDesc().SampleDesc.Count > 1;
+
+    m_FrameGraph.Reset();
+    auto colorResource = m_FrameGraph.Import("Color", &color);
+    auto depthResource = m_FrameGraph.Import("Depth", &depth);
+    auto backBufferResource = m_FrameGraph.Import("BackBuffer", backBuffer, ResourceState::Present);
+    m_FrameGraph.AddPass("Clear", [=]( CommandList &list, const FrameGraph &graph ) {
+                    FLOAT clearColor[] = {0.4f, 0.6f, 0.9f, 1.0f};
+                    list.ClearTexture(graph.GetTexture(colorResource), clearColor);
+                    list.ClearDepthStencilTexture(graph.GetTexture(depthResource), D3D12_CLEAR_FLAG_DEPTH);
+                })
+                .Write(colorResource, ResourceState::RenderTarget)
+                .Write(depthResource, ResourceState::DepthWrite);
+    m_FrameGraph.AddPass("Scene", [this]( CommandList &list, const FrameGraph & ) { DrawScene(list); })
+                .Write(colorResource, ResourceState::RenderTarget)
+                .Write(depthResource, ResourceState::DepthWrite);
+    m_FrameGraph.AddPass("Present", [=]( CommandList &list, const FrameGraph &graph ) {
+                    if (resolve)
+                    {
+                        list.ResolveSubresource(*backBuffer, graph.GetTexture(colorResource));
+                    } else
+                    {
+                        list.CopyResource(*backBuffer, graph.GetTexture(colorResource));
+                    }
+                })
+                .Read(colorResource, resolve ? ResourceState::ResolveSource : ResourceState::CopySource)
+                .Write(backBufferResource, resolve ? ResourceState::ResolveDest : ResourceState::CopyDest);
+    m_FrameGraph.Export(backBufferResource, ResourceState::Present);
+
+    if (!m_FrameGraph.Execute(*commandList))
     {
-        FLOAT clearColor[] = {0.4f, 0.6f, 0.9f, 1.0f};
-        //TransitionResource(commandList, backBuffer,
-        //    D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-        commandList->ClearTexture(m_RenderTarget.GetTexture(AttachmentPoint::Color0), clearColor);
-        commandList->ClearDepthStencilTexture(m_RenderTarget.GetTexture(AttachmentPoint::DepthStencil),
-                                              D3D12_CLEAR_FLAG_DEPTH);
+        EE_CORE_ERROR("Unable to compile the frame graph");
     }
+    m_DirectCommandQueue->ExecuteCommandList(commandList);
 
-    commandList->SetRenderTarget(m_RenderTarget);
-    commandList->SetViewport(m_RenderTarget.GetViewport());
-    commandList->SetScissorRect(m_ScissorRect);
+    Present();
+}
 
-    commandList->SetPipelineState(m_PipelineState);
-    commandList->SetGraphicsRootSignature(m_GraphicsRootSignature);
+void Renderer::DrawScene( CommandList &commandList )
+{
+    commandList.SetRenderTarget(m_RenderTarget);
+    commandList.SetViewport(m_RenderTarget.GetViewport());
+    commandList.SetScissorRect(m_ScissorRect);
 
-    XMMATRIX translationMatrix    = XMMatrixTranslation( 0.0f, 0.0f, 10.0f );
-    XMMATRIX rotationMatrix       = XMMatrixRotationZ(0.7);
-    XMMATRIX scaleMatrix          = XMMatrixScaling( 0.02f, 0.02f, 0.02f );
-    XMMATRIX worldMatrix         = scaleMatrix * rotationMatrix * translationMatrix;
+    commandList.SetGraphicsRootSignature(m_GraphicsRootSignature);
+
+    m_Scene.Update();
+    XMMATRIX worldMatrix = XMLoadFloat4x4A(
+        reinterpret_cast<const XMFLOAT4X4A *>(&m_Scene.GetTransforms().GetWorldMatrix(m_ModelNode)));
     auto point = XMFLOAT3(0.0,0.0,0.0);
     //XMMATRIX viewMatrix           = m_Camera.GetViewMatrix();
     XMMATRIX viewMatrix           = m_Camera.GetLookAtViewMatrix(&point);
@@ -517,11 +640,34 @@ void Renderer::OnRenderEvent( const events::AppRenderEvent &event )
 
     Transforms transform;
     ComputeMatrices(worldMatrix, viewMatrix, m_ProjectionMatrix, transform);
-    commandList->SetGraphicsDynamicConstantBuffer(0, sizeof(Transforms), &transform);
-    // Bind texture
-    commandList->SetShaderResourceView(1, 0,
-                                       m_DefaultTexture,
-                                       D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    m_ModelViewProjectionMatrix = transform.ModelViewProjectionMatrix;
+
+    // Meshlets are culled in model space, so bring the frustum and camera there.
+    Geometry::MeshletCullParams cullParams;
+    XMFLOAT4X4                  modelViewProjection;
+    XMStoreFloat4x4(&modelViewProjection, transform.ModelViewProjectionMatrix);
+    Geometry::ExtractFrustumPlanes(&modelViewProjection.m[0][0], cullParams.Planes);
+    XMFLOAT4 cameraWS = m_Camera.GetCameraLocation();
+    XMVECTOR cameraMS = XMVector3TransformCoord(XMLoadFloat4(&cameraWS), XMMatrixInverse(nullptr, worldMatrix));
+    XMStoreFloat3(reinterpret_cast<XMFLOAT3 *>(cullParams.CameraPosition), cameraMS);
+
+    // Level of detail from the projected size of the model; the model matrix scale converts model units to world units.
+    MeshDrawParams drawParams;
+    drawParams.CullParams = &cullParams;
+    float distance = XMVectorGetX(XMVector3Length(XMLoadFloat4(&cameraWS) - worldMatrix.r[3]));
+    float modelScale = XMVectorGetX(XMVector3Length(worldMatrix.r[0]));
+    drawParams.PixelsPerUnit = m_Camera.GetPixelsPerUnit(distance, static_cast<float>(m_ClientHeight)) * modelScale;
+
+    // Rasterize the occluders before drawing so the meshes can be tested against them.
+    m_OcclusionCuller.Clear();
+    m_Model->AddOccluders(&m_OcclusionCuller, &modelViewProjection.m[0][0]);
+    m_OcclusionCuller.Rasterize();
+    drawParams.Occlusion = &m_OcclusionCuller;
+    drawParams.ModelToClip = &modelViewProjection.m[0][0];
+    commandList.SetGraphicsDynamicConstantBuffer(0, sizeof(Transforms), &transform);
+    // Copy the materials that changed since the last frame, meshes bind their texture and material handle.
+    m_MaterialTable->Upload(commandList);
+    commandList.SetGraphicsRootShaderResourceView(MATERIAL_TABLE_ROOT_PARAMETER, m_MaterialTable->GetBuffer());
 
     LightSB light{};
     XMFLOAT4 lightCol (0.9f, 0.9f, 0.9f, 0.0f);
@@ -540,36 +686,130 @@ void Renderer::OnRenderEvent( const events::AppRenderEvent &event )
     XMStoreFloat4(&light.DirectionVS, lightDir);
     light.Colour = lightCol;
     // Bind lights
-    commandList->SetGraphicsDynamicStructuredBuffer(2, 1, sizeof(light), &light);
-    //m_DemoCube->Draw(*commandList);
-    m_Model->Draw(*commandList);
-    m_DirectCommandQueue->ExecuteCommandList(commandList);
-
-    Present(m_RenderTarget.GetTexture(AttachmentPoint::Color0));
+    commandList.SetGraphicsDynamicStructuredBuffer(2, 1, sizeof(light), &light);
+    //m_DemoCube->Draw(commandList);
+    if (m_ModelLoad.valid() && m_ModelLoad.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        try
+        {
+            if (!m_ModelLoad.get())
+            {
+                EE_CORE_ERROR("Unable to load model");
+            }
+        } catch (const std::exception &exception)
+        {
+            EE_CORE_ERROR("Unable to load model; {}", exception.what());
+        }
+        m_Model->AddNodes(&m_Scene.GetTransforms(), m_ModelNode, &m_ModelNodes);
+    }
+    // Hand the geometry uploaded on the copy queue to this queue, then compact the arena once unloaded meshes
+    // have left enough holes, before the draws bind its buffers. The arena leaves everything in place while
+    // uploads are still in flight.
+    m_GeometryArena->FinishUploads(commandList);
+    m_GeometryArena->Defragment(commandList);
+    // Draws that are not instanced read a single identity instance.
+    auto* identity = static_cast<Enterprise::Scene::InstanceData *>(
+        commandList.SetGraphicsDynamicStructuredBuffer(INSTANCE_ROOT_PARAMETER, 1,
+                                                        sizeof(Enterprise::Scene::InstanceData)));
+    *identity = Enterprise::Scene::GetIdentityInstance();
+    // Sort the draws so the pipeline state, material and buffers are only bound where they change.
+    m_RenderQueue.Clear();
+    m_QueuedMeshes.clear();
+    m_Model->Enqueue(drawParams, 0, cullParams.CameraPosition, &m_RenderQueue, &m_QueuedMeshes);
+    m_RenderQueue.Sort();
+    MeshBindState boundState;
+    drawParams.BoundState = &boundState;
+    const auto &keys = m_RenderQueue.GetKeys();
+    const auto &payloads = m_RenderQueue.GetPayloads();
+    uint32_t    pipeline = UINT32_MAX;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        uint32_t drawPipeline = Enterprise::Scene::RenderQueue::GetPipeline(keys[i]);
+        if (drawPipeline != pipeline)
+        {
+            commandList.SetPipelineState(m_PipelineStates[drawPipeline]);
+            pipeline = drawPipeline;
+        }
+        m_QueuedMeshes[payloads[i]]->Draw(commandList, drawParams);
+    }
+    if (!m_ModelInstanceNodes.empty())
+    {
+        DrawModelInstances(commandList, viewMatrix);
+    }
 }
 
-UINT Renderer::Present( const Texture &texture )
+void Renderer::DrawModelInstances( CommandList &commandList, const XMMATRIX &viewMatrix )
 {
-    auto &backBuffer = m_BackBufferTextures[m_CurrentBackBufferIndex];
-    auto  commandList = m_DirectCommandQueue->GetCommandList();
+    // Skip the copies outside the frustum before packing, the planes are in world space like their bounds.
+    XMFLOAT4X4 viewProjection;
+    XMStoreFloat4x4(&viewProjection, m_ProjectionMatrix);
+    float planes[6][4];
+    Geometry::ExtractFrustumPlanes(&viewProjection.m[0][0], planes);
+    const auto &               transforms = m_Scene.GetTransforms();
+    const Geometry::MeshBounds modelBounds = m_Model->GetBounds();
+    m_InstanceBounds.Clear();
+    for (auto node: m_ModelInstanceNodes)
+    {
+        m_InstanceBounds.Add(Geometry::TransformBounds(modelBounds, &transforms.GetWorldMatrix(node).m[0][0]));
+    }
+    m_InstanceBounds.Cull(planes, &m_VisibleInstances);
+    if (m_VisibleInstances.empty())
+    {
+        return;
+    }
 
-    if (texture.IsValid())
+    // Every copy is of the one model, so they all go to the same batch.
+    m_Instances.Clear();
+    m_Instances.Reserve(m_VisibleInstances.size());
+    for (uint32_t index: m_VisibleInstances)
     {
-        if (texture.GetD3D12ResourceDesc().SampleDesc.Count > 1)
-        {
-            commandList->ResolveSubresource(backBuffer, texture);
-        } else
+        m_Instances.Add(0, &transforms.GetWorldMatrix(m_ModelInstanceNodes[index]));
+    }
+    m_Instances.Build();
+
+    // The instances carry the world matrices, so the shared transforms only hold the camera.
+    Transforms transform;
+    ComputeMatrices(XMMatrixIdentity(), viewMatrix, m_ProjectionMatrix, transform);
+    commandList.SetGraphicsDynamicConstantBuffer(0, sizeof(Transforms), &transform);
+
+    // Pack every draw's instances once, then draw them all with one vertex format before switching pipeline.
+    m_InstanceDraws.clear();
+    for (const auto &batch: m_Instances.GetBatches())
+    {
+        for (uint32_t first = 0; first < batch.NumInstances; first += MAX_INSTANCES_PER_DRAW)
         {
-            commandList->CopyResource(backBuffer, texture);
+            uint32_t count = std::min(batch.NumInstances - first, MAX_INSTANCES_PER_DRAW);
+            auto     allocation = commandList.AllocateDynamicBuffer(count * sizeof(Enterprise::Scene::InstanceData));
+            m_Instances.Pack(batch.FirstInstance + first, count,
+                             static_cast<Enterprise::Scene::InstanceData *>(allocation.CPU));
+            m_InstanceDraws.push_back({allocation.GPU, count});
         }
     }
 
-    RenderTarget renderTarget;
-    renderTarget.AttachTexture(AttachmentPoint::Color0, backBuffer);
+    // Mesh bounds and meshlets are in the space of a single copy, so instances are drawn whole at full detail.
+    MeshDrawParams drawParams;
+    for (size_t format = 0; format < size_t(Geometry::VertexFormat::NumFormats); ++format)
+    {
+        commandList.SetPipelineState(m_PipelineStates[format]);
+        for (const auto &draw: m_InstanceDraws)
+        {
+            commandList.SetGraphicsRootShaderResourceView(INSTANCE_ROOT_PARAMETER, draw.Instances);
+            drawParams.NumInstances = draw.NumInstances;
+            m_Model->Draw(commandList, static_cast<Geometry::VertexFormat>(format), drawParams);
+        }
+    }
+}
 
-    commandList->TransitionBarrier(backBuffer, D3D12_RESOURCE_STATE_PRESENT);
-    m_DirectCommandQueue->ExecuteCommandList(commandList);
+Enterprise::Scene::TransformHierarchy::Handle Renderer::AddModelInstance( const Enterprise::Scene::Transform &transform )
+{
+    auto node = m_Scene.GetTransforms().AddNode(Enterprise::Scene::TransformHierarchy::INVALID_HANDLE, transform);
+    m_ModelInstanceNodes.push_back(node);
+    return node;
+}
 
+UINT Renderer::Present()
+{
+    // The frame graph has already left the back buffer in the present state.
     UINT syncInterval = m_VSync ? 1 : 0;
     UINT presentFlags = m_TearingSupported && !m_VSync ? DXGI_PRESENT_ALLOW_TEARING : 0;
 
@@ -583,6 +823,9 @@ UINT Renderer::Present( const Texture &texture )
     m_DirectCommandQueue->WaitForFenceValue(m_FenceValues[m_CurrentBackBufferIndex]);
 
     ReleaseStaleDescriptors(m_FrameValues[m_CurrentBackBufferIndex]);
+    m_GeometryArena->ReleaseStaleAllocations(m_FrameValues[m_CurrentBackBufferIndex]);
+    m_MaterialTable->ReleaseStaleMaterials(m_FrameValues[m_CurrentBackBufferIndex]);
+    m_FrameGraph.ReleaseStaleTextures(m_FrameValues[m_CurrentBackBufferIndex]);
 
     return m_CurrentBackBufferIndex;
 }
@@ -602,6 +845,33 @@ void Renderer::OnResizeEvent( const events::AppWindowResizeEvent &event )
     }
 }
 
+void Renderer::OnMouseEvent( const events::MouseEvent &event )
+{
+    if (!m_ContentLoaded || !event.GetButtons().LMB)
+    {
+        return;
+    }
+
+    // Unproject the cursor at the near and far plane back through the model view projection of the last frame,
+    // which gives the ray in model space. Distances along it are fractions of the near to far segment.
+    float    x = (static_cast<float>(event.GetCoords().x) + 0.5f) / m_Viewport.Width * 2.0f - 1.0f;
+    float    y = 1.0f - (static_cast<float>(event.GetCoords().y) + 0.5f) / m_Viewport.Height * 2.0f;
+    XMMATRIX clipToModel = XMMatrixInverse(nullptr, m_ModelViewProjectionMatrix);
+    XMVECTOR nearMS = XMVector3TransformCoord(XMVectorSet(x, y, 0.0f, 1.0f), clipToModel);
+    XMVECTOR farMS = XMVector3TransformCoord(XMVectorSet(x, y, 1.0f, 1.0f), clipToModel);
+
+    Geometry::Ray ray;
+    XMStoreFloat3(reinterpret_cast<XMFLOAT3 *>(ray.Origin), nearMS);
+    XMStoreFloat3(reinterpret_cast<XMFLOAT3 *>(ray.Direction), farMS - nearMS);
+    ray.MaxDistance = 1.0f;
+
+    ModelPickResult result;
+    if (m_Model->Pick(ray, &result))
+    {
+        EE_CORE_INFO("Picked mesh {} triangle {} at {}", result.Mesh, result.Hit.Primitive, result.Hit.Distance);
+    }
+}
+
 void Renderer::IncrementFrameCount()
 {
     ++ms_FrameCount;
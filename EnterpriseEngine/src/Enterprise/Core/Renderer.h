@@ -21,6 +21,8 @@
 #include "DescriptorAllocator.h"
 #include "CommandQueue.h"
 #include "DescriptorAllocation.h"
+#include "FrameGraph.h"
+#include "GpuMemoryAllocator.h"
 #include "HighResClock.h"
 #include "Log.h"
 #include "Mesh.h"
@@ -28,8 +30,11 @@
 #include "RenderTarget.h"
 #include "RootSignature.h"
 #include "../Window.h"
+#include "../Scene/InstanceBatcher.h"
+#include "../Scene/Scene.h"
 #include "../Events/ApplicationEvent.h"
 #include "../Events/EventHandler.h"
+#include "../Events/MouseEvent.h"
 
 
 namespace Enterprise::Core::Graphics {
@@ -45,6 +50,12 @@ public:
 
     const Camera *GetCamera() const { return &m_Camera; };
 
+    /**
+     * Draw another copy of the model at transform, in world space. All copies are drawn instanced, one draw per
+     * mesh for up to MAX_INSTANCES_PER_DRAW of them.
+     */
+    Enterprise::Scene::TransformHierarchy::Handle AddModelInstance( const Enterprise::Scene::Transform &transform );
+
     static Renderer* Create(const Window* window);
 
     static Renderer* Get();
@@ -61,6 +72,11 @@ public:
      * Release stale descriptors. This should only be called with a completed frame counter.
      */
     void ReleaseStaleDescriptors( uint64_t finishedFrame );
+
+    [[nodiscard]] std::shared_ptr<GpuMemoryAllocator> GetMemoryAllocator() const { return m_MemoryAllocator; }
+    [[nodiscard]] std::shared_ptr<GeometryArena> GetGeometryArena() const { return m_GeometryArena; }
+    [[nodiscard]] std::shared_ptr<TextureCache> GetTextureCache() const { return m_TextureCache; }
+    [[nodiscard]] std::shared_ptr<MaterialTable> GetMaterialTable() const { return m_MaterialTable; }
     [[nodiscard]] std::shared_ptr<CommandQueue> GetCommandQueue(D3D12_COMMAND_LIST_TYPE type ) const
     {
         std::shared_ptr<CommandQueue> commandQueue;
@@ -87,8 +103,11 @@ public:
 private:
     void OnUpdateEvent(const events::AppUpdateEvent&);
     void OnRenderEvent(const events::AppRenderEvent&);
-    UINT Present( const Texture& texture = Texture());
+    // Present the back buffer, which the frame graph has left in the present state.
+    UINT Present();
     void OnResizeEvent(const events::AppWindowResizeEvent&);
+    // Pick the model triangle under the cursor on a left click.
+    void OnMouseEvent(const events::MouseEvent&);
 
     void Resize(uint32_t width, uint32_t height);
 
@@ -96,9 +115,23 @@ private:
 
     bool LoadContent();
 
+    // Draw the models to m_RenderTarget, the scene pass of the frame graph.
+    void DrawScene( CommandList &commandList );
+
+    // Cull the model instances, pack the world matrices of the visible ones into the instance buffer and draw them.
+    void DrawModelInstances( CommandList &commandList, const DirectX::XMMATRIX &viewMatrix );
+
 
 private:
+    // Instances packed in upload memory for one draw of the model.
+    struct InstanceDraw {
+        D3D12_GPU_VIRTUAL_ADDRESS Instances;
+        uint32_t                  NumInstances;
+    };
+
     static constexpr uint8_t                            ms_NumFrames = 3;
+    // So the instances of one draw fit in a page of the upload buffer.
+    static constexpr uint32_t                           MAX_INSTANCES_PER_DRAW = 16 * 1024;
     Microsoft::WRL::ComPtr<IDXGIAdapter4>               m_DxgiAdapter;
 
     std::shared_ptr<CommandQueue>                       m_DirectCommandQueue;
@@ -117,9 +150,13 @@ private:
 
     RECT                                                m_WindowRect {};
 
-    Microsoft::WRL::ComPtr<ID3D12PipelineState>         m_PipelineState;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>         m_PipelineStates[size_t(Geometry::VertexFormat::NumFormats)];
 
     std::unique_ptr<DescriptorAllocator>                m_DescriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+    std::shared_ptr<GpuMemoryAllocator>                 m_MemoryAllocator;
+    std::shared_ptr<GeometryArena>                      m_GeometryArena;
+    std::shared_ptr<TextureCache>                       m_TextureCache;
+    std::shared_ptr<MaterialTable>                      m_MaterialTable;
 
     D3D12_VIEWPORT                                      m_Viewport;
     D3D12_RECT                                          m_ScissorRect;
@@ -129,6 +166,8 @@ private:
     DirectX::XMMATRIX                                   m_ModelMatrix;
     DirectX::XMMATRIX                                   m_ViewMatrix;
     DirectX::XMMATRIX                                   m_ProjectionMatrix;
+    // Of the last frame drawn, to cast picking rays through.
+    DirectX::XMMATRIX                                   m_ModelViewProjectionMatrix;
 
     bool                                                m_ContentLoaded;
 
@@ -138,6 +177,7 @@ private:
     events::EventHandler<events::AppUpdateEvent>        m_AppUpdateHandler;
     events::EventHandler<events::AppRenderEvent>        m_AppRenderHandler;
     events::EventHandler<events::AppWindowResizeEvent>  m_AppWindowResizeEventHandler;
+    events::EventHandler<events::MouseEvent>            m_MouseEventHandler;
 
     Texture                                             m_DefaultTexture;
     Texture                                             m_BackBufferTextures[BUFFER_COUNT];
@@ -146,7 +186,26 @@ private:
     RootSignature                                       m_GraphicsRootSignature;
     static uint64_t                                     ms_FrameCount;
     Camera                                              m_Camera;
-    std::unique_ptr<Model>                              m_Model;
+    std::shared_ptr<Model>                              m_Model;
+    Enterprise::Scene::Scene                            m_Scene;
+    Enterprise::Scene::TransformHierarchy::Handle       m_ModelNode;
+    // Node hierarchy of the model below m_ModelNode, added once it has loaded.
+    std::vector<Enterprise::Scene::TransformHierarchy::Handle> m_ModelNodes;
+    // Rasterizes the models' occluders each frame, meshes hidden behind them are not drawn.
+    Geometry::OcclusionCuller                           m_OcclusionCuller;
+    // Nodes of the copies of the model added with AddModelInstance, and the batches they are packed through.
+    std::vector<Enterprise::Scene::TransformHierarchy::Handle> m_ModelInstanceNodes;
+    Enterprise::Scene::InstanceBatcher                  m_Instances;
+    // World bounds of the copies this frame, and the indices into m_ModelInstanceNodes of those in the frustum.
+    Geometry::BoundsCuller                              m_InstanceBounds;
+    std::vector<uint32_t>                               m_VisibleInstances;
+    std::vector<InstanceDraw>                           m_InstanceDraws;
+    // Draws of the frame sorted by state, their payloads index m_QueuedMeshes.
+    Enterprise::Scene::RenderQueue                      m_RenderQueue;
+    std::vector<Mesh*>                                  m_QueuedMeshes;
+    // Passes of the frame, rebuilt every frame.
+    FrameGraph                                          m_FrameGraph;
+    std::future<bool>                                   m_ModelLoad;
 };
 
 inline void ThrowIfFailed(HRESULT hr)
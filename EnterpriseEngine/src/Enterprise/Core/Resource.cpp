@@ -25,16 +25,9 @@ Resource::Resource(const D3D12_RESOURCE_DESC& resourceDesc, const D3D12_CLEAR_VA
         m_D3D12ClearValue = std::make_unique<D3D12_CLEAR_VALUE>(*clearValue);
     }
 
-    auto device = Renderer::Get()->GetDevice();
-
-    ThrowIfFailed( device->CreateCommittedResource(
-        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-        D3D12_HEAP_FLAG_NONE,
-        &resourceDesc,
-        D3D12_RESOURCE_STATE_COMMON,
-        m_D3D12ClearValue.get(),
-        IID_PPV_ARGS(&m_D3D12Resource)
-    ) );
+    m_D3D12Resource = Renderer::Get()->GetMemoryAllocator()->CreateResource(resourceDesc, D3D12_HEAP_TYPE_DEFAULT,
+                                                                          D3D12_RESOURCE_STATE_COMMON,
+                                                                          m_D3D12ClearValue.get());
 
     ResourceStateTracker::AddGlobalResourceState(m_D3D12Resource.Get(), D3D12_RESOURCE_STATE_COMMON );
 
@@ -173,12 +166,14 @@ Texture::Texture( Microsoft::WRL::ComPtr<ID3D12Resource> resource, const std::ws
 
 Texture::Texture(const Texture& copy)
     : Resource(copy)
+    , m_CacheHandle(copy.m_CacheHandle)
 {
     CreateViews();
 }
 
 Texture::Texture(Texture&& copy)
     : Resource(copy)
+    , m_CacheHandle(std::move(copy.m_CacheHandle))
 {
     CreateViews();
 }
@@ -186,6 +181,7 @@ Texture::Texture(Texture&& copy)
 Texture& Texture::operator=(const Texture& other)
 {
     Resource::operator=(other);
+    m_CacheHandle = other.m_CacheHandle;
 
     CreateViews();
 
@@ -194,6 +190,7 @@ Texture& Texture::operator=(const Texture& other)
 Texture& Texture::operator=(Texture&& other)
 {
     Resource::operator=(other);
+    m_CacheHandle = std::move(other.m_CacheHandle);
 
     CreateViews();
 
@@ -215,17 +212,12 @@ void Texture::Resize( uint32_t width, uint32_t height, uint32_t depth )
         resourceDesc.DepthOrArraySize = depth;
         resourceDesc.MipLevels = resourceDesc.SampleDesc.Count > 1 ? 1 : 0;
 
-        auto d3d12Device = Renderer::Get()->GetDevice();
-
-        ThrowIfFailed(d3d12Device->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-                D3D12_HEAP_FLAG_NONE, &resourceDesc,
-                D3D12_RESOURCE_STATE_COMMON,
-                m_D3D12ClearValue.get(),
-                IID_PPV_ARGS(&m_D3D12Resource))
-        );
+        m_D3D12Resource = Renderer::Get()->GetMemoryAllocator()->CreateResource(resourceDesc, D3D12_HEAP_TYPE_DEFAULT,
+                                                                              D3D12_RESOURCE_STATE_COMMON,
+                                                                              m_D3D12ClearValue.get());
 
         m_D3D12Resource->SetName(m_ResourceName.c_str());
+        m_CacheHandle.Reset();
 
         ResourceStateTracker::AddGlobalResourceState(m_D3D12Resource.Get(), D3D12_RESOURCE_STATE_COMMON);
 
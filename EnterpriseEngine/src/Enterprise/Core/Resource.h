@@ -5,7 +5,9 @@
 #ifndef RESOURCE_H
 #define RESOURCE_H
 #define NOMINMAX
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -13,13 +15,30 @@
 
 #include "DescriptorAllocation.h"
 #include "Core.h"
+#include "../Textures/ResidencyCache.h"
 
 #include "directx/d3d12.h"
 
 
 namespace Enterprise::Core::Graphics {
+class CommandQueue;
 class Device;
 
+// The texture uploads recorded on one command list. FenceValue stays 0 until the list is executed, so a texture
+// shared before its upload was even submitted is still known to be pending.
+struct TextureUpload {
+    std::shared_ptr<CommandQueue> Queue;
+    std::atomic<uint64_t>         FenceValue{0};
+};
+
+// A cached texture and the upload that fills it, which whoever shares the texture waits for.
+struct CachedTexture {
+    Microsoft::WRL::ComPtr<ID3D12Resource> D3D12Resource;
+    std::shared_ptr<TextureUpload>         Upload;
+};
+
+using TextureCache = Textures::ResidencyCache<CachedTexture>;
+
 class ENTERPRISE_API Resource {
 public:
     explicit Resource(const std::wstring& name = L"");
@@ -150,6 +169,14 @@ public:
 
     void CreateViews();
 
+    /**
+     * Keep the texture cache entry this texture was created from resident for as long as the texture,
+     * or a copy of it, is around.
+     */
+    void SetCacheHandle( TextureCache::Handle handle ) { m_CacheHandle = std::move(handle); }
+
+    [[nodiscard]] const TextureCache::Handle &GetCacheHandle() const { return m_CacheHandle; }
+
 private:
     DescriptorAllocation CreateShaderResourceView( const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc ) const;
 
@@ -160,6 +187,7 @@ private:
     DescriptorAllocation m_DepthStencilView;
     DescriptorAllocation m_ShaderResourceView;
     DescriptorAllocation m_UnorderedAccessView;
+    TextureCache::Handle m_CacheHandle;
 
     mutable std::unordered_map<size_t, DescriptorAllocation> m_ShaderResourceViews;
     mutable std::unordered_map<size_t, DescriptorAllocation> m_UnorderedAccessViews;
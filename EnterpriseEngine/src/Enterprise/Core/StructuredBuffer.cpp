@@ -0,0 +1,48 @@
+#include "StructuredBuffer.h"
+
+#include "Renderer.h"
+
+namespace Enterprise::Core::Graphics {
+
+StructuredBuffer::StructuredBuffer( const std::wstring &name )
+    : Buffer(name)
+    , m_NumElements(0)
+    , m_ElementSize(0)
+{}
+
+void StructuredBuffer::CreateViews( size_t numElements, size_t elementSize )
+{
+    m_NumElements = numElements;
+    m_ElementSize = elementSize;
+    if (!m_D3D12Resource)
+    {
+        return;
+    }
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Buffer.NumElements = static_cast<UINT>(numElements);
+    srvDesc.Buffer.StructureByteStride = static_cast<UINT>(elementSize);
+    srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+
+    auto renderer = Renderer::Get();
+    m_ShaderResourceView = renderer->AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    renderer->GetDevice()->CreateShaderResourceView(m_D3D12Resource.Get(), &srvDesc,
+                                                     m_ShaderResourceView.GetDescriptorHandle());
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE StructuredBuffer::GetShaderResourceView(
+    const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc ) const
+{
+    return m_ShaderResourceView.GetDescriptorHandle();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE StructuredBuffer::GetUnorderedAccessView(
+    const D3D12_UNORDERED_ACCESS_VIEW_DESC* uavDesc ) const
+{
+    throw std::exception("StructuredBuffer::GetUnorderedAccessView should not be called.");
+}
+
+}
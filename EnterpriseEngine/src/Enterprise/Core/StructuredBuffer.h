@@ -0,0 +1,39 @@
+#ifndef STRUCTUREDBUFFER_H
+#define STRUCTUREDBUFFER_H
+#include "Buffer.h"
+#include "DescriptorAllocation.h"
+#include "../Core.h"
+
+
+namespace Enterprise::Core::Graphics {
+
+/**
+ * A buffer of fixed size elements read by shaders as a StructuredBuffer, either through its SRV or bound by
+ * address as a root shader resource view.
+ */
+class ENTERPRISE_API StructuredBuffer : public Buffer {
+public:
+    explicit StructuredBuffer( const std::wstring &name = L"" );
+
+    // Inherited from Buffer
+    void CreateViews( size_t numElements, size_t elementSize ) override;
+
+    [[nodiscard]] size_t GetNumElements() const { return m_NumElements; }
+
+    [[nodiscard]] size_t GetElementSize() const { return m_ElementSize; }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetShaderResourceView(
+        const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc = nullptr ) const override;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetUnorderedAccessView(
+        const D3D12_UNORDERED_ACCESS_VIEW_DESC* uavDesc = nullptr ) const override;
+
+private:
+    size_t               m_NumElements;
+    size_t               m_ElementSize;
+    DescriptorAllocation m_ShaderResourceView;
+};
+
+}
+
+#endif //STRUCTUREDBUFFER_H
@@ -0,0 +1,142 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace Enterprise::Core::Threads {
+
+ThreadPool::ThreadPool( uint32_t numThreads )
+    : m_Shutdown(false)
+{
+    if (numThreads == 0)
+    {
+        numThreads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    m_Threads.reserve(numThreads);
+    for (uint32_t i = 0; i < numThreads; ++i)
+    {
+        m_Threads.emplace_back(&ThreadPool::WorkerThread, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Shutdown = true;
+    }
+    m_TaskAvailableCV.notify_all();
+
+    for (auto &thread: m_Threads)
+    {
+        thread.join();
+    }
+}
+
+ThreadPool &ThreadPool::Get()
+{
+    static ThreadPool s_ThreadPool;
+    return s_ThreadPool;
+}
+
+void ThreadPool::Enqueue( std::function<void()> task )
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Tasks.push_back(std::move(task));
+    }
+    m_TaskAvailableCV.notify_one();
+}
+
+void ThreadPool::WorkerThread()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_TaskAvailableCV.wait(lock, [this] { return m_Shutdown || !m_Tasks.empty(); });
+
+            // Drain the queue before shutting down so no future is left without a result.
+            if (m_Tasks.empty())
+            {
+                return;
+            }
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::ParallelFor( size_t count, size_t grainSize, const std::function<void( size_t, size_t )> &body )
+{
+    if (count == 0)
+    {
+        return;
+    }
+    grainSize = std::max<size_t>(1, grainSize);
+    const size_t numChunks = (count + grainSize - 1) / grainSize;
+
+    if (numChunks == 1)
+    {
+        body(0, count);
+        return;
+    }
+
+    // Shared with the helper tasks, which may still be queued after this call returns.
+    struct ParallelForState {
+        std::atomic_size_t      NextChunk{0};
+        std::atomic_size_t      ChunksDone{0};
+        std::mutex              Mutex;
+        std::condition_variable DoneCV;
+        std::exception_ptr      Exception;
+    };
+    auto state = std::make_shared<ParallelForState>();
+
+    // Claim chunks until there are none left. body is only touched for claimed chunks,
+    // and the caller cannot return before all claimed chunks are done.
+    auto work = [state, &body, count, grainSize, numChunks]()
+    {
+        size_t chunk;
+        while ((chunk = state->NextChunk.fetch_add(1)) < numChunks)
+        {
+            size_t begin = chunk * grainSize;
+            try
+            {
+                body(begin, std::min(count, begin + grainSize));
+            } catch (...)
+            {
+                std::lock_guard<std::mutex> lock(state->Mutex);
+                if (!state->Exception)
+                {
+                    state->Exception = std::current_exception();
+                }
+            }
+
+            if (state->ChunksDone.fetch_add(1) + 1 == numChunks)
+            {
+                std::lock_guard<std::mutex> lock(state->Mutex);
+                state->DoneCV.notify_all();
+            }
+        }
+    };
+
+    size_t numHelpers = std::min<size_t>(m_Threads.size(), numChunks - 1);
+    for (size_t i = 0; i < numHelpers; ++i)
+    {
+        Enqueue(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lock(state->Mutex);
+    state->DoneCV.wait(lock, [&state, numChunks] { return state->ChunksDone == numChunks; });
+
+    if (state->Exception)
+    {
+        std::rethrow_exception(state->Exception);
+    }
+}
+
+}
@@ -0,0 +1,70 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace Enterprise::Core::Threads {
+
+class ThreadPool {
+public:
+    // A numThreads of 0 uses one worker per hardware thread, minus the calling thread.
+    explicit ThreadPool( uint32_t numThreads = 0 );
+    ~ThreadPool();
+
+    ThreadPool( const ThreadPool &copy ) = delete;
+    ThreadPool &operator=( const ThreadPool &other ) = delete;
+
+    // Shared pool used by the loaders.
+    static ThreadPool &Get();
+
+    [[nodiscard]] uint32_t GetNumThreads() const { return static_cast<uint32_t>(m_Threads.size()); }
+
+    // Queue a task on the pool. The returned future holds the result or the exception thrown by the task.
+    template<typename F>
+    auto Submit( F &&task ) -> std::future<std::invoke_result_t<std::decay_t<F> > >;
+
+    /**
+     * Split [0, count) into chunks of grainSize and run body(begin, end) on each chunk.
+     * The calling thread works on chunks too and returns once every chunk is done,
+     * so it is safe to call from inside a pool task.
+     * The first exception thrown by body is rethrown on the calling thread.
+     */
+    void ParallelFor( size_t count, size_t grainSize, const std::function<void( size_t begin, size_t end )> &body );
+
+private:
+    void Enqueue( std::function<void()> task );
+
+    void WorkerThread();
+
+    std::vector<std::thread>          m_Threads;
+    std::deque<std::function<void()> > m_Tasks;
+    std::mutex                        m_Mutex;
+    std::condition_variable           m_TaskAvailableCV;
+    bool                              m_Shutdown;
+};
+
+template<typename F>
+auto ThreadPool::Submit( F &&task ) -> std::future<std::invoke_result_t<std::decay_t<F> > >
+{
+    using Result = std::invoke_result_t<std::decay_t<F> >;
+
+    // std::function needs a copyable callable, so the packaged task lives on the heap.
+    auto packagedTask = std::make_shared<std::packaged_task<Result()> >(std::forward<F>(task));
+    auto future = packagedTask->get_future();
+    Enqueue([packagedTask]() { (*packagedTask)(); });
+
+    return future;
+}
+
+}
+
+#endif //THREADPOOL_H
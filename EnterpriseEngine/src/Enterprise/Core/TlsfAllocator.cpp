@@ -0,0 +1,304 @@
+#include "TlsfAllocator.h"
+
+#include <cassert>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace Enterprise::Core {
+
+namespace {
+
+// Index of the highest set bit, value must not be 0.
+uint32_t FindLastSet( uint64_t value )
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return index;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+// Index of the lowest set bit, value must not be 0.
+uint32_t FindFirstSet( uint64_t value )
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return index;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+uint64_t AlignUp( uint64_t value, uint64_t alignment )
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+TlsfAllocator::TlsfAllocator( uint64_t size, uint64_t granularity )
+    : m_Size(size - size % granularity)
+    , m_FreeSize(m_Size)
+    , m_Granularity(granularity)
+{
+    assert(granularity != 0 && (granularity & (granularity - 1)) == 0);
+    for (auto &lists: m_FreeLists)
+    {
+        for (auto &list: lists)
+        {
+            list = INVALID_BLOCK;
+        }
+    }
+    if (m_Size > 0)
+    {
+        InsertFreeBlock(CreateBlock(0, m_Size, INVALID_BLOCK, INVALID_BLOCK));
+    }
+}
+
+TlsfAllocator::Allocation TlsfAllocator::Allocate( uint64_t size, uint64_t alignment )
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+    if (size == 0 || size > m_FreeSize)
+    {
+        return {};
+    }
+    size = AlignUp(size, m_Granularity);
+    alignment = alignment > m_Granularity ? alignment : m_Granularity;
+
+    // Blocks are usually aligned already; otherwise look for one with room for the padding as well.
+    BlockHandle block = FindFreeBlock(size);
+    if (block != INVALID_BLOCK &&
+        AlignUp(m_Blocks[block].Offset, alignment) + size > m_Blocks[block].Offset + m_Blocks[block].Size)
+    {
+        block = FindFreeBlock(size + alignment - m_Granularity);
+    }
+    if (block == INVALID_BLOCK)
+    {
+        return {};
+    }
+
+    RemoveFreeBlock(block);
+    uint64_t padding = AlignUp(m_Blocks[block].Offset, alignment) - m_Blocks[block].Offset;
+    if (padding > 0)
+    {
+        BlockHandle aligned = SplitBlock(block, padding);
+        InsertFreeBlock(block);
+        block = aligned;
+    }
+    if (m_Blocks[block].Size > size)
+    {
+        InsertFreeBlock(SplitBlock(block, size));
+    }
+
+    m_FreeSize -= size;
+    ++m_NumAllocations;
+    return {m_Blocks[block].Offset, size, block};
+}
+
+void TlsfAllocator::Free( BlockHandle block )
+{
+    assert(block < m_Blocks.size() && !m_Blocks[block].Free && "Freeing a block that was not allocated.");
+    m_FreeSize += m_Blocks[block].Size;
+    --m_NumAllocations;
+
+    BlockHandle prev = m_Blocks[block].PrevPhysical;
+    if (prev != INVALID_BLOCK && m_Blocks[prev].Free)
+    {
+        // Merge into the block directly before.
+        RemoveFreeBlock(prev);
+        m_Blocks[prev].Size += m_Blocks[block].Size;
+        m_Blocks[prev].NextPhysical = m_Blocks[block].NextPhysical;
+        if (m_Blocks[block].NextPhysical != INVALID_BLOCK)
+        {
+            m_Blocks[m_Blocks[block].NextPhysical].PrevPhysical = prev;
+        }
+        DestroyBlock(block);
+        block = prev;
+    }
+
+    BlockHandle next = m_Blocks[block].NextPhysical;
+    if (next != INVALID_BLOCK && m_Blocks[next].Free)
+    {
+        // Merge the block directly after into this one.
+        RemoveFreeBlock(next);
+        m_Blocks[block].Size += m_Blocks[next].Size;
+        m_Blocks[block].NextPhysical = m_Blocks[next].NextPhysical;
+        if (m_Blocks[next].NextPhysical != INVALID_BLOCK)
+        {
+            m_Blocks[m_Blocks[next].NextPhysical].PrevPhysical = block;
+        }
+        DestroyBlock(next);
+    }
+
+    InsertFreeBlock(block);
+}
+
+uint64_t TlsfAllocator::GetLargestFreeBlock() const
+{
+    if (m_FirstLevelBitmap == 0)
+    {
+        return 0;
+    }
+
+    // The largest block is in the highest list, which may hold blocks of different sizes.
+    uint32_t firstLevel = FindLastSet(m_FirstLevelBitmap);
+    uint32_t secondLevel = FindLastSet(m_SecondLevelBitmaps[firstLevel]);
+    uint64_t largest = 0;
+    for (BlockHandle block = m_FreeLists[firstLevel][secondLevel]; block != INVALID_BLOCK;
+         block = m_Blocks[block].NextFree)
+    {
+        largest = m_Blocks[block].Size > largest ? m_Blocks[block].Size : largest;
+    }
+    return largest;
+}
+
+float TlsfAllocator::GetFragmentation() const
+{
+    if (m_FreeSize == 0)
+    {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(GetLargestFreeBlock()) / static_cast<float>(m_FreeSize);
+}
+
+void TlsfAllocator::GetList( uint64_t size, uint32_t &firstLevel, uint32_t &secondLevel )
+{
+    if (size < SECOND_LEVEL_COUNT)
+    {
+        firstLevel = 0;
+        secondLevel = static_cast<uint32_t>(size);
+        return;
+    }
+    uint32_t highestBit = FindLastSet(size);
+    firstLevel = highestBit - SECOND_LEVEL_BITS + 1;
+    secondLevel = static_cast<uint32_t>(size >> (highestBit - SECOND_LEVEL_BITS)) - SECOND_LEVEL_COUNT;
+}
+
+TlsfAllocator::BlockHandle TlsfAllocator::FindFreeBlock( uint64_t size ) const
+{
+    // Round up to the next size class, so any block of the list found is large enough.
+    uint64_t roundedSize = size;
+    if (size >= SECOND_LEVEL_COUNT)
+    {
+        uint64_t round = (uint64_t(1) << (FindLastSet(size) - SECOND_LEVEL_BITS)) - 1;
+        roundedSize = size <= UINT64_MAX - round ? size + round : UINT64_MAX;
+    }
+    uint32_t firstLevel, secondLevel;
+    GetList(roundedSize, firstLevel, secondLevel);
+
+    uint32_t secondLevelBitmap = m_SecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+    if (secondLevelBitmap == 0)
+    {
+        uint64_t firstLevelBitmap = firstLevel + 1 < 64 ? m_FirstLevelBitmap & (~uint64_t(0) << (firstLevel + 1)) : 0;
+        if (firstLevelBitmap == 0)
+        {
+            // The list of size itself may still hold a block that is large enough, as when size is the whole heap.
+            GetList(size, firstLevel, secondLevel);
+            for (BlockHandle block = m_FreeLists[firstLevel][secondLevel]; block != INVALID_BLOCK;
+                 block = m_Blocks[block].NextFree)
+            {
+                if (m_Blocks[block].Size >= size)
+                {
+                    return block;
+                }
+            }
+            return INVALID_BLOCK;
+        }
+        firstLevel = FindFirstSet(firstLevelBitmap);
+        secondLevelBitmap = m_SecondLevelBitmaps[firstLevel];
+    }
+    return m_FreeLists[firstLevel][FindFirstSet(secondLevelBitmap)];
+}
+
+TlsfAllocator::BlockHandle TlsfAllocator::CreateBlock( uint64_t offset, uint64_t size, BlockHandle prevPhysical,
+                                                       BlockHandle nextPhysical )
+{
+    BlockHandle block;
+    if (!m_UnusedBlocks.empty())
+    {
+        block = m_UnusedBlocks.back();
+        m_UnusedBlocks.pop_back();
+    } else
+    {
+        block = static_cast<BlockHandle>(m_Blocks.size());
+        m_Blocks.emplace_back();
+    }
+    m_Blocks[block] = {offset, size, prevPhysical, nextPhysical, INVALID_BLOCK, INVALID_BLOCK, false};
+    return block;
+}
+
+void TlsfAllocator::DestroyBlock( BlockHandle block )
+{
+    m_UnusedBlocks.push_back(block);
+}
+
+void TlsfAllocator::InsertFreeBlock( BlockHandle block )
+{
+    uint32_t firstLevel, secondLevel;
+    GetList(m_Blocks[block].Size, firstLevel, secondLevel);
+
+    BlockHandle head = m_FreeLists[firstLevel][secondLevel];
+    m_Blocks[block].Free = true;
+    m_Blocks[block].PrevFree = INVALID_BLOCK;
+    m_Blocks[block].NextFree = head;
+    if (head != INVALID_BLOCK)
+    {
+        m_Blocks[head].PrevFree = block;
+    }
+    m_FreeLists[firstLevel][secondLevel] = block;
+    m_FirstLevelBitmap |= uint64_t(1) << firstLevel;
+    m_SecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+    ++m_NumFreeBlocks;
+}
+
+void TlsfAllocator::RemoveFreeBlock( BlockHandle block )
+{
+    uint32_t firstLevel, secondLevel;
+    GetList(m_Blocks[block].Size, firstLevel, secondLevel);
+
+    BlockHandle prev = m_Blocks[block].PrevFree;
+    BlockHandle next = m_Blocks[block].NextFree;
+    if (prev != INVALID_BLOCK)
+    {
+        m_Blocks[prev].NextFree = next;
+    } else
+    {
+        m_FreeLists[firstLevel][secondLevel] = next;
+        if (next == INVALID_BLOCK)
+        {
+            m_SecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+            if (m_SecondLevelBitmaps[firstLevel] == 0)
+            {
+                m_FirstLevelBitmap &= ~(uint64_t(1) << firstLevel);
+            }
+        }
+    }
+    if (next != INVALID_BLOCK)
+    {
+        m_Blocks[next].PrevFree = prev;
+    }
+    m_Blocks[block].Free = false;
+    --m_NumFreeBlocks;
+}
+
+TlsfAllocator::BlockHandle TlsfAllocator::SplitBlock( BlockHandle block, uint64_t size )
+{
+    // m_Blocks may grow, so the block is looked up again after creating the rest.
+    BlockHandle rest = CreateBlock(m_Blocks[block].Offset + size, m_Blocks[block].Size - size, block,
+                                   m_Blocks[block].NextPhysical);
+    if (m_Blocks[block].NextPhysical != INVALID_BLOCK)
+    {
+        m_Blocks[m_Blocks[block].NextPhysical].PrevPhysical = rest;
+    }
+    m_Blocks[block].NextPhysical = rest;
+    m_Blocks[block].Size = size;
+    return rest;
+}
+
+}
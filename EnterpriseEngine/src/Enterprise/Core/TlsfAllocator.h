@@ -0,0 +1,106 @@
+#ifndef TLSFALLOCATOR_H
+#define TLSFALLOCATOR_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace Enterprise::Core {
+
+/**
+ * Two level segregated fit allocator for ranges of a heap. Free blocks are kept in lists by size class: the first
+ * level is the power of two of the size, the second splits it into 32 linear steps. Bitmaps of the lists that are
+ * not empty find a free block in constant time, and freed blocks merge with their free neighbours in constant
+ * time, whatever the number of allocations.
+ * Sizes are rounded up to the granularity, and offsets are multiples of it.
+ * Like OffsetAllocator it only hands out offsets and is not thread safe.
+ */
+class TlsfAllocator {
+public:
+    using BlockHandle = uint32_t;
+    static constexpr BlockHandle INVALID_BLOCK = UINT32_MAX;
+
+    struct Allocation {
+        uint64_t    Offset = 0;
+        // Size rounded up to the granularity.
+        uint64_t    Size = 0;
+        BlockHandle Block = INVALID_BLOCK;
+    };
+
+    explicit TlsfAllocator( uint64_t size = 0, uint64_t granularity = 1 );
+
+    /**
+     * Allocate size bytes at an offset that is a multiple of alignment, a power of two. Returns an allocation
+     * with an INVALID_BLOCK when no free block is large enough.
+     */
+    Allocation Allocate( uint64_t size, uint64_t alignment = 1 );
+
+    /**
+     * Return an allocation to the free lists, merging it with its free neighbours.
+     */
+    void Free( BlockHandle block );
+
+    [[nodiscard]] uint64_t GetSize() const { return m_Size; }
+
+    [[nodiscard]] uint64_t GetFreeSize() const { return m_FreeSize; }
+
+    [[nodiscard]] uint64_t GetUsedSize() const { return m_Size - m_FreeSize; }
+
+    [[nodiscard]] uint64_t GetLargestFreeBlock() const;
+
+    [[nodiscard]] size_t GetNumAllocations() const { return m_NumAllocations; }
+
+    [[nodiscard]] size_t GetNumFreeBlocks() const { return m_NumFreeBlocks; }
+
+    /**
+     * Share of the free space that is not in the largest free block, 0 when all free space is contiguous.
+     */
+    [[nodiscard]] float GetFragmentation() const;
+
+private:
+    static constexpr uint32_t SECOND_LEVEL_BITS = 5;
+    static constexpr uint32_t SECOND_LEVEL_COUNT = 1u << SECOND_LEVEL_BITS;
+    static constexpr uint32_t FIRST_LEVEL_COUNT = 64 - SECOND_LEVEL_BITS + 1;
+
+    struct Block {
+        uint64_t    Offset;
+        uint64_t    Size;
+        // Neighbours in the heap, and in the free list of the block while it is free.
+        BlockHandle PrevPhysical;
+        BlockHandle NextPhysical;
+        BlockHandle PrevFree;
+        BlockHandle NextFree;
+        bool        Free;
+    };
+
+    static void GetList( uint64_t size, uint32_t &firstLevel, uint32_t &secondLevel );
+
+    // A free block of at least size, from the smallest size class holding only such blocks when there is one.
+    BlockHandle FindFreeBlock( uint64_t size ) const;
+
+    BlockHandle CreateBlock( uint64_t offset, uint64_t size, BlockHandle prevPhysical, BlockHandle nextPhysical );
+
+    void DestroyBlock( BlockHandle block );
+
+    void InsertFreeBlock( BlockHandle block );
+
+    void RemoveFreeBlock( BlockHandle block );
+
+    // Cut block down to size, returning the rest as a new block that is in no free list.
+    BlockHandle SplitBlock( BlockHandle block, uint64_t size );
+
+    std::vector<Block>       m_Blocks;
+    std::vector<BlockHandle> m_UnusedBlocks;
+    BlockHandle              m_FreeLists[FIRST_LEVEL_COUNT][SECOND_LEVEL_COUNT];
+    uint64_t                 m_FirstLevelBitmap = 0;
+    uint32_t                 m_SecondLevelBitmaps[FIRST_LEVEL_COUNT] = {};
+    uint64_t                 m_Size;
+    uint64_t                 m_FreeSize;
+    uint64_t                 m_Granularity;
+    size_t                   m_NumAllocations = 0;
+    size_t                   m_NumFreeBlocks = 0;
+};
+
+}
+
+#endif //TLSFALLOCATOR_H
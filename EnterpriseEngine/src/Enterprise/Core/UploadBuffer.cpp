@@ -59,16 +59,8 @@ UploadBuffer::Page::Page(size_t sizeInBytes)
     , m_pCPU(nullptr)
     , m_pGPU(D3D12_GPU_VIRTUAL_ADDRESS(0))
 {
-    auto device = Renderer::Get()->GetDevice();
-
-    ThrowIfFailed(device->CreateCommittedResource(
-        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-        D3D12_HEAP_FLAG_NONE,
-        &CD3DX12_RESOURCE_DESC::Buffer(m_PageSize),
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(&m_D3D12Resource)
-    ));
+    m_D3D12Resource = Renderer::Get()->GetMemoryAllocator()->CreateResource(
+        CD3DX12_RESOURCE_DESC::Buffer(m_PageSize), D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
 
     m_pGPU = m_D3D12Resource->GetGPUVirtualAddress();
     m_D3D12Resource->Map(0, nullptr, &m_pCPU);
@@ -103,6 +95,8 @@ UploadBuffer::Allocation UploadBuffer::Page::Allocate(size_t sizeInBytes, size_t
     Allocation allocation{};
     allocation.CPU = static_cast<uint8_t*>(m_pCPU) + m_Offset;
     allocation.GPU = m_pGPU + m_Offset;
+    allocation.Resource = m_D3D12Resource.Get();
+    allocation.Offset = m_Offset;
 
     m_Offset += alignedSize;
 
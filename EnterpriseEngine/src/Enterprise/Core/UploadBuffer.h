@@ -21,6 +21,9 @@ public:
     struct Allocation {
         void * CPU;
         D3D12_GPU_VIRTUAL_ADDRESS GPU;
+        // Page the allocation lives in, and its offset in bytes, for use as a copy source.
+        ID3D12Resource* Resource;
+        size_t Offset;
     };
 
     explicit UploadBuffer(size_t pageSize = 2 * 1024 * 1024);
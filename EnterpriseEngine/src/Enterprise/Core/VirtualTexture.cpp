@@ -0,0 +1,140 @@
+#include "VirtualTexture.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "CommandList.h"
+#include "../Log.h"
+#include "ThreadPool.h"
+
+namespace Enterprise::Core::Graphics {
+
+namespace {
+
+// Bytes between the reads that fault a tile's pages in ahead of the copies.
+constexpr size_t PREFETCH_STRIDE = 4096;
+
+uint32_t RoundUpToPowerOfTwo( uint32_t value )
+{
+    uint32_t power = 1;
+    while (power < value)
+    {
+        power <<= 1;
+    }
+    return power;
+}
+
+}
+
+VirtualTexture::VirtualTexture()
+    : m_SlotsPerRow(0)
+    , m_CommandList(nullptr)
+{}
+
+bool VirtualTexture::Open( CommandList &commandList, const std::string &fileName, uint32_t numSlots,
+                           const std::wstring &name )
+{
+    if (!m_File.Open(fileName))
+    {
+        EE_CORE_ERROR("Failed to open tiled texture {}", fileName);
+        return false;
+    }
+
+    const auto &layout = m_File.GetLayout();
+    uint32_t    paddedSize = layout.GetPaddedTileSize();
+    uint32_t    maxSlotsPerRow = D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION / paddedSize;
+    m_SlotsPerRow = std::min(static_cast<uint32_t>(std::ceil(std::sqrt(double(numSlots)))), maxSlotsPerRow);
+    numSlots = std::min(numSlots, m_SlotsPerRow * m_SlotsPerRow);
+
+    DXGI_FORMAT format = CommandList::GetCookedTextureFormat(m_File.GetFormat(), m_File.IsSrgb());
+    uint32_t    physicalSize = m_SlotsPerRow * paddedSize;
+    m_PhysicalTexture = Texture(CD3DX12_RESOURCE_DESC::Tex2D(format, physicalSize, physicalSize, 1, 1), nullptr,
+                                name + L" Physical");
+
+    // Mips of a power of two texture are never smaller than the tile grid of the same mip.
+    m_PageTableTexture = Texture(CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R32_UINT,
+                                                              RoundUpToPowerOfTwo(layout.GetNumTilesX(0)),
+                                                              RoundUpToPowerOfTwo(layout.GetNumTilesY(0)), 1,
+                                                              static_cast<UINT16>(layout.NumMips)),
+                                 nullptr, name + L" Page Table");
+
+    m_PageTable = std::make_unique<Textures::VirtualTexturePageTable>(layout, numSlots);
+    m_CommandList = &commandList;
+    bool initialized = m_PageTable->Initialize(*this);
+    m_CommandList = nullptr;
+    if (!initialized)
+    {
+        EE_CORE_ERROR("Failed to load the last mip of tiled texture {}", fileName);
+        return false;
+    }
+
+    UploadPageTable(commandList);
+    return true;
+}
+
+uint32_t VirtualTexture::Update( CommandList &commandList, uint32_t maxLoads )
+{
+    m_CommandList = &commandList;
+    uint32_t numLoaded = m_PageTable->Update(*this, maxLoads);
+    m_CommandList = nullptr;
+
+    UploadPageTable(commandList);
+    return numLoaded;
+}
+
+VirtualTextureConstants VirtualTexture::GetConstants() const
+{
+    const auto &layout = m_File.GetLayout();
+    return {m_SlotsPerRow, layout.TileSize, layout.TileBorder, m_SlotsPerRow * layout.GetPaddedTileSize()};
+}
+
+void VirtualTexture::LoadTiles( Textures::TileLoad* loads, size_t count )
+{
+    // Fault the tiles in from the file on the pool, rather than one page at a time in the copies below.
+    size_t tileSize = m_File.GetTileSize();
+    Threads::ThreadPool::Get().ParallelFor(count, 1, [&]( size_t begin, size_t end )
+    {
+        uint8_t sum = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            const volatile uint8_t* data = m_File.GetTileData(loads[i].Tile);
+            for (size_t offset = 0; offset < tileSize; offset += PREFETCH_STRIDE)
+            {
+                sum += data[offset];
+            }
+            sum += data[tileSize - 1];
+        }
+        (void) sum;
+    });
+
+    uint32_t paddedSize = m_File.GetLayout().GetPaddedTileSize();
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto &load = loads[i];
+        m_CommandList->WriteTextureRegion(m_PhysicalTexture, 0, load.Slot % m_SlotsPerRow * paddedSize,
+                                          load.Slot / m_SlotsPerRow * paddedSize, paddedSize, paddedSize,
+                                          m_File.GetTileData(load.Tile), m_File.GetTileRowPitch(),
+                                          m_File.GetTileNumRows());
+        load.Loaded = true;
+    }
+}
+
+void VirtualTexture::UploadPageTable( CommandList &commandList )
+{
+    const auto &layout = m_PageTable->GetLayout();
+    for (uint32_t mip = 0; mip < layout.NumMips; ++mip)
+    {
+        if (!m_PageTable->IsDirty(mip))
+        {
+            continue;
+        }
+
+        uint32_t width = layout.GetNumTilesX(mip);
+        commandList.WriteTextureRegion(m_PageTableTexture, mip, 0, 0, width, layout.GetNumTilesY(mip),
+                                       m_PageTable->GetPageTable(mip).data(), size_t(width) * sizeof(uint32_t),
+                                       layout.GetNumTilesY(mip));
+    }
+    m_PageTable->ClearDirty();
+}
+
+}
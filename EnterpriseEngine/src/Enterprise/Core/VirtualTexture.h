@@ -0,0 +1,88 @@
+#ifndef CORE_VIRTUALTEXTURE_H
+#define CORE_VIRTUALTEXTURE_H
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Resource.h"
+#include "../Core.h"
+#include "../Assets/TiledTexture.h"
+#include "../Textures/VirtualTexture.h"
+
+
+namespace Enterprise::Core::Graphics {
+class CommandList;
+
+// What a shader needs besides the two textures to sample a virtual texture, as 32-bit constants.
+struct VirtualTextureConstants {
+    uint32_t SlotsPerRow;
+    uint32_t TileSize;
+    uint32_t TileBorder;
+    // Width and height of the physical texture in texels.
+    uint32_t PhysicalSize;
+};
+
+/**
+ * A texture too large to keep resident, streamed tile by tile from a tiled texture file.
+ *
+ * Resident tiles live in the slots of a physical texture, a grid of SlotsPerRow x SlotsPerRow padded tiles.
+ * The page table texture has a mip per virtual mip and an R32_UINT texel per tile, see
+ * Textures::MakePageTableEntry. A shader looks up the page of the mip it wants, and samples the slot of the
+ * entry, at the entry's mip, which is coarser if the tile it wants is not resident yet:
+ *
+ *     uv in tile = frac(uv * mip size / (TileSize << (entry mip - wanted mip)))
+ *     physical uv = (slot xy * padded tile size + TileBorder + uv in tile * TileSize) / PhysicalSize
+ *
+ * and writes the packed id of the tile it wanted to a feedback target. Reading that target back is up to the
+ * caller, which hands it to AddFeedback.
+ */
+class ENTERPRISE_API VirtualTexture : private Textures::TileStreamer {
+public:
+    VirtualTexture();
+
+    VirtualTexture( const VirtualTexture &copy ) = delete;
+    VirtualTexture &operator=( const VirtualTexture &other ) = delete;
+
+    /**
+     * Open a tiled texture, create the physical texture with room for numSlots tiles, fewer if they would not
+     * fit in the largest texture D3D12 allows, and upload the last mip. Returns false if the file cannot be
+     * opened.
+     */
+    bool Open( CommandList &commandList, const std::string &fileName, uint32_t numSlots,
+               const std::wstring &name = L"" );
+
+    // Tiles sampled by the feedback pass, see Textures::VirtualTexturePageTable::AddFeedback.
+    void AddFeedback( const uint32_t* packedTiles, size_t count ) { m_PageTable->AddFeedback(packedTiles, count); }
+
+    /**
+     * Stream up to maxLoads of the tiles requested since the last update into the physical texture, and upload
+     * the page table mips that changed, on commandList. Returns the number of tiles loaded.
+     */
+    uint32_t Update( CommandList &commandList, uint32_t maxLoads = 32 );
+
+    [[nodiscard]] const Texture &GetPhysicalTexture() const { return m_PhysicalTexture; }
+
+    [[nodiscard]] const Texture &GetPageTableTexture() const { return m_PageTableTexture; }
+
+    [[nodiscard]] const Textures::VirtualTexturePageTable &GetPageTable() const { return *m_PageTable; }
+
+    [[nodiscard]] VirtualTextureConstants GetConstants() const;
+
+private:
+    // Copy the tiles from the file into their slots on m_CommandList.
+    void LoadTiles( Textures::TileLoad* loads, size_t count ) override;
+
+    void UploadPageTable( CommandList &commandList );
+
+    Assets::TiledTexture                              m_File;
+    std::unique_ptr<Textures::VirtualTexturePageTable> m_PageTable;
+    Texture                                           m_PhysicalTexture;
+    Texture                                           m_PageTableTexture;
+    uint32_t                                          m_SlotsPerRow;
+    // Command list of the update in progress.
+    CommandList*                                      m_CommandList;
+};
+
+}
+
+#endif //CORE_VIRTUALTEXTURE_H
@@ -61,6 +61,10 @@ public:
 
     EVENT_TYPE("MouseEvent");
 
+    [[nodiscard]] const MouseCoords &GetCoords() const { return m_Coords; }
+
+    [[nodiscard]] const MouseButton &GetButtons() const { return m_Buttons; }
+
 private:
     MouseCoords m_Coords;
     MouseButton m_Buttons;
@@ -0,0 +1,325 @@
+#include "Bounds.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <xmmintrin.h>
+
+#include "../Core/ThreadPool.h"
+
+namespace Enterprise::Geometry {
+
+namespace {
+
+// Sets smaller than this are not worth handing to the pool.
+constexpr uint32_t PARALLEL_CULL_SIZE = 16 * 1024;
+// A multiple of four, so every task starts on a group.
+constexpr uint32_t OBJECTS_PER_TASK = 4 * 1024;
+
+const float* Position( const float* positions, size_t stride, size_t vertex )
+{
+    return reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(positions) + vertex * stride);
+}
+
+float DistanceSquared( const float* a, const float* b )
+{
+    float d[3] = {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+    return d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+}
+
+bool IsInfinite( const MeshBounds &bounds )
+{
+    return bounds.Sphere.Radius == FLT_MAX;
+}
+
+}
+
+MeshBounds GetInfiniteBounds()
+{
+    return {{{-FLT_MAX, -FLT_MAX, -FLT_MAX}, {FLT_MAX, FLT_MAX, FLT_MAX}}, {{0.0f, 0.0f, 0.0f}, FLT_MAX}};
+}
+
+MeshBounds ComputeMeshBounds( const float* positions, size_t vertexCount, size_t positionStride )
+{
+    MeshBounds bounds{};
+    if (vertexCount == 0)
+    {
+        return bounds;
+    }
+
+    const float* first = Position(positions, positionStride, 0);
+    std::copy(first, first + 3, bounds.Box.Min);
+    std::copy(first, first + 3, bounds.Box.Max);
+    for (size_t i = 1; i < vertexCount; ++i)
+    {
+        const float* p = Position(positions, positionStride, i);
+        for (int k = 0; k < 3; ++k)
+        {
+            bounds.Box.Min[k] = std::min(bounds.Box.Min[k], p[k]);
+            bounds.Box.Max[k] = std::max(bounds.Box.Max[k], p[k]);
+        }
+    }
+
+    // Ritter's sphere: start from two far apart vertices and grow the sphere over the ones left outside.
+    auto farthestFrom = [&]( const float* from )
+    {
+        const float* farthest = from;
+        float        farthestDistance = 0.0f;
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            const float* p = Position(positions, positionStride, i);
+            float        distance = DistanceSquared(p, from);
+            if (distance > farthestDistance)
+            {
+                farthestDistance = distance;
+                farthest = p;
+            }
+        }
+        return farthest;
+    };
+
+    const float* a = farthestFrom(first);
+    const float* b = farthestFrom(a);
+    float*       center = bounds.Sphere.Center;
+    for (int k = 0; k < 3; ++k)
+    {
+        center[k] = (a[k] + b[k]) * 0.5f;
+    }
+    float r = std::sqrt(DistanceSquared(a, b)) * 0.5f;
+
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const float* p = Position(positions, positionStride, i);
+        float        distance = std::sqrt(DistanceSquared(p, center));
+        if (distance > r)
+        {
+            float newRadius = (r + distance) * 0.5f;
+            float shift = (newRadius - r) / distance;
+            for (int k = 0; k < 3; ++k)
+            {
+                center[k] += (p[k] - center[k]) * shift;
+            }
+            r = newRadius;
+        }
+    }
+    // Moving the centre rounds, keep every vertex inside.
+    bounds.Sphere.Radius = r * (1.0f + FLT_EPSILON * 4.0f);
+    return bounds;
+}
+
+MeshBounds MergeBounds( const MeshBounds &a, const MeshBounds &b )
+{
+    if (IsInfinite(a) || IsInfinite(b))
+    {
+        return GetInfiniteBounds();
+    }
+
+    MeshBounds bounds;
+    for (int k = 0; k < 3; ++k)
+    {
+        bounds.Box.Min[k] = std::min(a.Box.Min[k], b.Box.Min[k]);
+        bounds.Box.Max[k] = std::max(a.Box.Max[k], b.Box.Max[k]);
+    }
+
+    // The smallest sphere around both, unless one already holds the other.
+    float distance = std::sqrt(DistanceSquared(a.Sphere.Center, b.Sphere.Center));
+    if (distance + b.Sphere.Radius <= a.Sphere.Radius)
+    {
+        bounds.Sphere = a.Sphere;
+    } else if (distance + a.Sphere.Radius <= b.Sphere.Radius)
+    {
+        bounds.Sphere = b.Sphere;
+    } else
+    {
+        float radius = (distance + a.Sphere.Radius + b.Sphere.Radius) * 0.5f;
+        float shift = (radius - a.Sphere.Radius) / distance;
+        for (int k = 0; k < 3; ++k)
+        {
+            bounds.Sphere.Center[k] = a.Sphere.Center[k] + (b.Sphere.Center[k] - a.Sphere.Center[k]) * shift;
+        }
+        bounds.Sphere.Radius = radius * (1.0f + FLT_EPSILON * 4.0f);
+    }
+    return bounds;
+}
+
+MeshBounds TransformBounds( const MeshBounds &bounds, const float matrix[16] )
+{
+    if (IsInfinite(bounds))
+    {
+        return bounds;
+    }
+
+    // Arvo's method: each moved axis adds the smaller and the larger end of its column to the translation.
+    MeshBounds moved;
+    float      scale = 0.0f;
+    for (int j = 0; j < 3; ++j)
+    {
+        moved.Box.Min[j] = moved.Box.Max[j] = matrix[12 + j];
+        moved.Sphere.Center[j] = matrix[12 + j];
+        for (int i = 0; i < 3; ++i)
+        {
+            float a = matrix[i * 4 + j] * bounds.Box.Min[i];
+            float b = matrix[i * 4 + j] * bounds.Box.Max[i];
+            moved.Box.Min[j] += std::min(a, b);
+            moved.Box.Max[j] += std::max(a, b);
+            moved.Sphere.Center[j] += matrix[i * 4 + j] * bounds.Sphere.Center[i];
+        }
+        // Row j is where the axis j goes.
+        const float* row = matrix + j * 4;
+        scale = std::max(scale, row[0] * row[0] + row[1] * row[1] + row[2] * row[2]);
+    }
+    moved.Sphere.Radius = bounds.Sphere.Radius * std::sqrt(scale);
+    return moved;
+}
+
+BoundsCuller::BoundsCuller()
+    : m_Count(0)
+{}
+
+uint32_t BoundsCuller::Add( const MeshBounds &bounds )
+{
+    if (m_Count == m_Radius.size())
+    {
+        // Grow by a group of objects that are outside every frustum until they are set.
+        size_t size = m_Count + 4;
+        m_MinX.resize(size, FLT_MAX);
+        m_MinY.resize(size, FLT_MAX);
+        m_MinZ.resize(size, FLT_MAX);
+        m_MaxX.resize(size, -FLT_MAX);
+        m_MaxY.resize(size, -FLT_MAX);
+        m_MaxZ.resize(size, -FLT_MAX);
+        m_CenterX.resize(size, 0.0f);
+        m_CenterY.resize(size, 0.0f);
+        m_CenterZ.resize(size, 0.0f);
+        m_Radius.resize(size, -FLT_MAX);
+    }
+
+    uint32_t index = m_Count++;
+    Set(index, bounds);
+    return index;
+}
+
+void BoundsCuller::Set( uint32_t index, const MeshBounds &bounds )
+{
+    m_MinX[index] = bounds.Box.Min[0];
+    m_MinY[index] = bounds.Box.Min[1];
+    m_MinZ[index] = bounds.Box.Min[2];
+    m_MaxX[index] = bounds.Box.Max[0];
+    m_MaxY[index] = bounds.Box.Max[1];
+    m_MaxZ[index] = bounds.Box.Max[2];
+    m_CenterX[index] = bounds.Sphere.Center[0];
+    m_CenterY[index] = bounds.Sphere.Center[1];
+    m_CenterZ[index] = bounds.Sphere.Center[2];
+    m_Radius[index] = bounds.Sphere.Radius;
+}
+
+void BoundsCuller::Clear()
+{
+    m_MinX.clear();
+    m_MinY.clear();
+    m_MinZ.clear();
+    m_MaxX.clear();
+    m_MaxY.clear();
+    m_MaxZ.clear();
+    m_CenterX.clear();
+    m_CenterY.clear();
+    m_CenterZ.clear();
+    m_Radius.clear();
+    m_Count = 0;
+}
+
+size_t BoundsCuller::Cull( const float planes[6][4], std::vector<uint32_t>* visible, bool parallel ) const
+{
+    auto numObjects = static_cast<uint32_t>(m_Radius.size());
+    visible->resize(numObjects);
+
+    uint32_t numVisible;
+    if (parallel && numObjects >= PARALLEL_CULL_SIZE)
+    {
+        // Every task compacts into its own slice of visible, the slices are joined afterwards.
+        std::vector<uint32_t> taskCounts((numObjects + OBJECTS_PER_TASK - 1) / OBJECTS_PER_TASK);
+        Core::Threads::ThreadPool::Get().ParallelFor(numObjects, OBJECTS_PER_TASK, [&]( size_t first, size_t last )
+        {
+            taskCounts[first / OBJECTS_PER_TASK] = CullRange(planes, static_cast<uint32_t>(first),
+                                                             static_cast<uint32_t>(last), visible->data() + first);
+        });
+
+        numVisible = taskCounts[0];
+        for (size_t task = 1; task < taskCounts.size(); ++task)
+        {
+            auto slice = visible->begin() + task * OBJECTS_PER_TASK;
+            std::copy(slice, slice + taskCounts[task], visible->begin() + numVisible);
+            numVisible += taskCounts[task];
+        }
+    } else
+    {
+        numVisible = CullRange(planes, 0, numObjects, visible->data());
+    }
+
+    visible->resize(numVisible);
+    return numVisible;
+}
+
+uint32_t BoundsCuller::CullRange( const float planes[6][4], uint32_t first, uint32_t last, uint32_t* output ) const
+{
+    __m128 planeX[6];
+    __m128 planeY[6];
+    __m128 planeZ[6];
+    __m128 planeD[6];
+    // The box corner farthest along each plane normal is picked per axis by the sign of the normal.
+    bool   positiveX[6];
+    bool   positiveY[6];
+    bool   positiveZ[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        planeX[p] = _mm_set1_ps(planes[p][0]);
+        planeY[p] = _mm_set1_ps(planes[p][1]);
+        planeZ[p] = _mm_set1_ps(planes[p][2]);
+        planeD[p] = _mm_set1_ps(planes[p][3]);
+        positiveX[p] = planes[p][0] >= 0.0f;
+        positiveY[p] = planes[p][1] >= 0.0f;
+        positiveZ[p] = planes[p][2] >= 0.0f;
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    uint32_t     numVisible = 0;
+    for (uint32_t i = first; i < last; i += 4)
+    {
+        __m128 minX = _mm_loadu_ps(&m_MinX[i]);
+        __m128 minY = _mm_loadu_ps(&m_MinY[i]);
+        __m128 minZ = _mm_loadu_ps(&m_MinZ[i]);
+        __m128 maxX = _mm_loadu_ps(&m_MaxX[i]);
+        __m128 maxY = _mm_loadu_ps(&m_MaxY[i]);
+        __m128 maxZ = _mm_loadu_ps(&m_MaxZ[i]);
+        __m128 centerX = _mm_loadu_ps(&m_CenterX[i]);
+        __m128 centerY = _mm_loadu_ps(&m_CenterY[i]);
+        __m128 centerZ = _mm_loadu_ps(&m_CenterZ[i]);
+        __m128 radius = _mm_loadu_ps(&m_Radius[i]);
+
+        __m128 outside = zero;
+        for (int p = 0; p < 6; ++p)
+        {
+            __m128 box = _mm_add_ps(planeD[p], _mm_mul_ps(planeX[p], positiveX[p] ? maxX : minX));
+            box = _mm_add_ps(box, _mm_mul_ps(planeY[p], positiveY[p] ? maxY : minY));
+            box = _mm_add_ps(box, _mm_mul_ps(planeZ[p], positiveZ[p] ? maxZ : minZ));
+
+            __m128 sphere = _mm_add_ps(planeD[p], _mm_mul_ps(planeX[p], centerX));
+            sphere = _mm_add_ps(sphere, _mm_mul_ps(planeY[p], centerY));
+            sphere = _mm_add_ps(sphere, _mm_mul_ps(planeZ[p], centerZ));
+            sphere = _mm_add_ps(sphere, radius);
+
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_min_ps(box, sphere), zero));
+        }
+
+        // Write every lane but only step past the visible ones, so the output never runs ahead of the input.
+        int visibleMask = ~_mm_movemask_ps(outside);
+        for (uint32_t lane = 0; lane < 4; ++lane)
+        {
+            output[numVisible] = i + lane;
+            numVisible += (visibleMask >> lane) & 1;
+        }
+    }
+    return numVisible;
+}
+
+}
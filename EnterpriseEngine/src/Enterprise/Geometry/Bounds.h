@@ -0,0 +1,96 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace Enterprise::Geometry {
+
+struct BoundingBox {
+    float Min[3];
+    float Max[3];
+};
+
+struct BoundingSphere {
+    float Center[3];
+    float Radius;
+};
+
+// Plain data, so bounds are cooked and read back as is.
+struct MeshBounds {
+    BoundingBox    Box;
+    BoundingSphere Sphere;
+};
+static_assert(sizeof(MeshBounds) == 40);
+
+/**
+ * Bounds that contain everything, for meshes that must never be culled.
+ */
+MeshBounds GetInfiniteBounds();
+
+/**
+ * Compute the bounding box and a bounding sphere (Ritter's) of the vertices.
+ * positions points at the first float3 position, positionStride is the distance between vertices in bytes.
+ */
+MeshBounds ComputeMeshBounds( const float* positions, size_t vertexCount, size_t positionStride );
+
+/**
+ * Bounds around both a and b. Infinite if either is.
+ */
+MeshBounds MergeBounds( const MeshBounds &a, const MeshBounds &b );
+
+/**
+ * Bounds of the bounds moved by matrix, row major for row vectors as DirectXMath stores it. The box is the box
+ * around the moved box, the sphere radius grows by the largest scale of the matrix. Infinite bounds stay infinite.
+ */
+MeshBounds TransformBounds( const MeshBounds &bounds, const float matrix[16] );
+
+/**
+ * Bounds of many objects, stored as structures of arrays so a frustum test covers four objects per instruction.
+ * Cull tests the boxes and the spheres against every plane; an object is visible unless one of them is
+ * entirely outside a plane, so a sphere rejects objects next to a frustum corner that the box would not.
+ */
+class BoundsCuller {
+public:
+    BoundsCuller();
+
+    // Returns the index of the object.
+    uint32_t Add( const MeshBounds &bounds );
+
+    void Set( uint32_t index, const MeshBounds &bounds );
+
+    void Clear();
+
+    [[nodiscard]] uint32_t GetCount() const { return m_Count; }
+
+    /**
+     * Write the indices of the objects that intersect the frustum to visible, in ascending order, and return
+     * their number. planes are as (a, b, c, d) with a * x + b * y + c * z + d >= 0 inside, see
+     * ExtractFrustumPlanes, in the space the bounds are in. With parallel set, large sets are split across
+     * the thread pool.
+     */
+    size_t Cull( const float planes[6][4], std::vector<uint32_t>* visible, bool parallel = false ) const;
+
+private:
+    // Test the objects [first, last), a multiple of four apart, and write the visible ones from output on.
+    // Returns the number written.
+    uint32_t CullRange( const float planes[6][4], uint32_t first, uint32_t last, uint32_t* output ) const;
+
+    // Per object, padded to a multiple of four with bounds that are outside every frustum.
+    std::vector<float> m_MinX;
+    std::vector<float> m_MinY;
+    std::vector<float> m_MinZ;
+    std::vector<float> m_MaxX;
+    std::vector<float> m_MaxY;
+    std::vector<float> m_MaxZ;
+    std::vector<float> m_CenterX;
+    std::vector<float> m_CenterY;
+    std::vector<float> m_CenterZ;
+    std::vector<float> m_Radius;
+    uint32_t           m_Count;
+};
+
+}
+
+#endif //BOUNDS_H
@@ -0,0 +1,704 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <xmmintrin.h>
+
+#include "../Core/ThreadPool.h"
+
+namespace Enterprise::Geometry {
+
+namespace {
+
+constexpr uint32_t NUM_BINS = 16;
+// Leaves never hold more, even where splitting costs more than the heuristic says it saves.
+constexpr uint32_t MAX_LEAF_SIZE = 8;
+// Cost of visiting a node relative to testing a primitive.
+constexpr float    TRAVERSAL_COST = 1.0f;
+// Subtrees smaller than this are built on the thread that split them.
+constexpr uint32_t PARALLEL_BUILD_SIZE = 16 * 1024;
+// Below this depth nodes are split at the median instead, which bounds the depth of the tree at
+// MAX_SAH_DEPTH + 32 whatever the heuristic would have done.
+constexpr uint32_t MAX_SAH_DEPTH = 64;
+constexpr uint32_t MAX_STACK_DEPTH = 128;
+
+BoundingBox EmptyBox()
+{
+    return {{FLT_MAX, FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX, -FLT_MAX}};
+}
+
+void Grow( BoundingBox* box, const BoundingBox &other )
+{
+    for (int k = 0; k < 3; ++k)
+    {
+        box->Min[k] = std::min(box->Min[k], other.Min[k]);
+        box->Max[k] = std::max(box->Max[k], other.Max[k]);
+    }
+}
+
+void Grow( BoundingBox* box, const float* point )
+{
+    for (int k = 0; k < 3; ++k)
+    {
+        box->Min[k] = std::min(box->Min[k], point[k]);
+        box->Max[k] = std::max(box->Max[k], point[k]);
+    }
+}
+
+float SurfaceArea( const BoundingBox &box )
+{
+    float extent[3] = {box.Max[0] - box.Min[0], box.Max[1] - box.Min[1], box.Max[2] - box.Min[2]};
+    if (extent[0] < 0.0f)
+    {
+        return 0.0f;
+    }
+    return 2.0f * (extent[0] * extent[1] + extent[1] * extent[2] + extent[2] * extent[0]);
+}
+
+// Distance at which the ray enters the box, or FLT_MAX when it misses it within [0, maxDistance].
+float IntersectBox( const float* min, const float* max, const float* origin, const float* inverseDirection,
+                    float        maxDistance )
+{
+    // Comparisons are ordered so the NaN of a ray starting on a slab of a zero direction axis is ignored.
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+    for (int k = 0; k < 3; ++k)
+    {
+        float t0 = (min[k] - origin[k]) * inverseDirection[k];
+        float t1 = (max[k] - origin[k]) * inverseDirection[k];
+        tMin = std::max(tMin, std::min(t0, t1));
+        tMax = std::min(tMax, std::max(t0, t1));
+    }
+    return tMin <= tMax ? tMin : FLT_MAX;
+}
+
+void InverseDirection( const float* direction, float inverse[3] )
+{
+    for (int k = 0; k < 3; ++k)
+    {
+        inverse[k] = 1.0f / direction[k];
+    }
+}
+
+}
+
+struct Bvh::BuildState {
+    std::vector<float>    Centroids;
+    std::atomic<uint32_t> NumNodes{1};
+    bool                  Parallel;
+};
+
+void Bvh::Build( const BoundingBox* bounds, uint32_t count, bool parallel )
+{
+    m_Bounds.assign(bounds, bounds + count);
+    m_PrimitiveIndices.resize(count);
+    std::iota(m_PrimitiveIndices.begin(), m_PrimitiveIndices.end(), 0u);
+    m_Nodes.clear();
+    if (count == 0)
+    {
+        return;
+    }
+
+    BuildState state;
+    state.Parallel = parallel;
+    state.Centroids.resize(size_t(count) * 3);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            state.Centroids[size_t(i) * 3 + k] = (bounds[i].Min[k] + bounds[i].Max[k]) * 0.5f;
+        }
+    }
+
+    // A binary tree over count leaves has at most 2 * count - 1 nodes.
+    m_Nodes.resize(size_t(count) * 2 - 1);
+    Subdivide(state, 0, 0, count, 0);
+    m_Nodes.resize(state.NumNodes);
+}
+
+void Bvh::Subdivide( BuildState &state, uint32_t node, uint32_t first, uint32_t count, uint32_t depth )
+{
+    BoundingBox box = EmptyBox();
+    BoundingBox centroidBox = EmptyBox();
+    for (uint32_t i = first; i < first + count; ++i)
+    {
+        uint32_t primitive = m_PrimitiveIndices[i];
+        Grow(&box, m_Bounds[primitive]);
+        Grow(&centroidBox, &state.Centroids[size_t(primitive) * 3]);
+    }
+
+    auto &nodeData = m_Nodes[node];
+    std::copy(std::begin(box.Min), std::end(box.Min), nodeData.Min);
+    std::copy(std::begin(box.Max), std::end(box.Max), nodeData.Max);
+    nodeData.FirstChildOrPrimitive = first;
+    nodeData.NumPrimitives = count;
+    if (count == 1)
+    {
+        return;
+    }
+
+    // Bin the centroids along every axis and sweep the bin boundaries for the cheapest split.
+    int      bestAxis = -1;
+    uint32_t bestBin = 0;
+    float    bestCost = FLT_MAX;
+    for (int axis = 0; axis < 3 && depth < MAX_SAH_DEPTH; ++axis)
+    {
+        float extent = centroidBox.Max[axis] - centroidBox.Min[axis];
+        if (extent <= 0.0f)
+        {
+            continue;
+        }
+
+        uint32_t    binCounts[NUM_BINS] = {};
+        BoundingBox binBoxes[NUM_BINS];
+        std::fill(std::begin(binBoxes), std::end(binBoxes), EmptyBox());
+        float scale = NUM_BINS / extent;
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            uint32_t primitive = m_PrimitiveIndices[i];
+            auto     bin = std::min(NUM_BINS - 1, uint32_t((state.Centroids[size_t(primitive) * 3 + axis] -
+                                                            centroidBox.Min[axis]) * scale));
+            binCounts[bin] += 1;
+            Grow(&binBoxes[bin], m_Bounds[primitive]);
+        }
+
+        float       leftAreas[NUM_BINS - 1];
+        uint32_t    leftCounts[NUM_BINS - 1];
+        BoundingBox leftBox = EmptyBox();
+        uint32_t    leftCount = 0;
+        for (uint32_t bin = 0; bin < NUM_BINS - 1; ++bin)
+        {
+            Grow(&leftBox, binBoxes[bin]);
+            leftCount += binCounts[bin];
+            leftAreas[bin] = SurfaceArea(leftBox);
+            leftCounts[bin] = leftCount;
+        }
+        BoundingBox rightBox = EmptyBox();
+        uint32_t    rightCount = 0;
+        for (uint32_t bin = NUM_BINS - 1; bin > 0; --bin)
+        {
+            Grow(&rightBox, binBoxes[bin]);
+            rightCount += binCounts[bin];
+            float cost = leftAreas[bin - 1] * float(leftCounts[bin - 1]) + SurfaceArea(rightBox) * float(rightCount);
+            if (leftCounts[bin - 1] != 0 && rightCount != 0 && cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = bin - 1;
+            }
+        }
+    }
+
+    float leafCost = float(count) * SurfaceArea(box);
+    if (count <= MAX_LEAF_SIZE && (bestAxis < 0 || TRAVERSAL_COST * SurfaceArea(box) + bestCost >= leafCost))
+    {
+        return;
+    }
+
+    uint32_t* begin = m_PrimitiveIndices.data() + first;
+    uint32_t* middle = begin;
+    if (bestAxis >= 0)
+    {
+        float scale = NUM_BINS / (centroidBox.Max[bestAxis] - centroidBox.Min[bestAxis]);
+        middle = std::partition(begin, begin + count, [&]( uint32_t primitive )
+        {
+            return std::min(NUM_BINS - 1, uint32_t((state.Centroids[size_t(primitive) * 3 + bestAxis] -
+                                                    centroidBox.Min[bestAxis]) * scale)) <= bestBin;
+        });
+    }
+    if (middle == begin || middle == begin + count)
+    {
+        // Too deep, or every centroid is in the same place: split in half along the widest axis.
+        int axis = 0;
+        for (int k = 1; k < 3; ++k)
+        {
+            if (centroidBox.Max[k] - centroidBox.Min[k] > centroidBox.Max[axis] - centroidBox.Min[axis])
+            {
+                axis = k;
+            }
+        }
+        middle = begin + count / 2;
+        std::nth_element(begin, middle, begin + count, [&]( uint32_t a, uint32_t b )
+        {
+            return state.Centroids[size_t(a) * 3 + axis] < state.Centroids[size_t(b) * 3 + axis];
+        });
+    }
+    auto leftCount = static_cast<uint32_t>(middle - begin);
+
+    uint32_t firstChild = state.NumNodes.fetch_add(2);
+    nodeData.FirstChildOrPrimitive = firstChild;
+    nodeData.NumPrimitives = 0;
+
+    if (state.Parallel && count >= PARALLEL_BUILD_SIZE)
+    {
+        Core::Threads::ThreadPool::Get().ParallelFor(2, 1, [&]( size_t childBegin, size_t childEnd )
+        {
+            for (size_t child = childBegin; child < childEnd; ++child)
+            {
+                if (child == 0)
+                {
+                    Subdivide(state, firstChild, first, leftCount, depth + 1);
+                } else
+                {
+                    Subdivide(state, firstChild + 1, first + leftCount, count - leftCount, depth + 1);
+                }
+            }
+        });
+    } else
+    {
+        Subdivide(state, firstChild, first, leftCount, depth + 1);
+        Subdivide(state, firstChild + 1, first + leftCount, count - leftCount, depth + 1);
+    }
+}
+
+void Bvh::Refit( const BoundingBox* bounds )
+{
+    m_Bounds.assign(bounds, bounds + m_Bounds.size());
+
+    // Children come after their parent, so walking backwards finishes them first.
+    for (size_t i = m_Nodes.size(); i-- > 0;)
+    {
+        auto &       node = m_Nodes[i];
+        BoundingBox box = EmptyBox();
+        if (node.NumPrimitives != 0)
+        {
+            for (uint32_t j = 0; j < node.NumPrimitives; ++j)
+            {
+                Grow(&box, m_Bounds[m_PrimitiveIndices[node.FirstChildOrPrimitive + j]]);
+            }
+        } else
+        {
+            for (uint32_t child = node.FirstChildOrPrimitive; child < node.FirstChildOrPrimitive + 2; ++child)
+            {
+                Grow(&box, m_Nodes[child].Min);
+                Grow(&box, m_Nodes[child].Max);
+            }
+        }
+        std::copy(std::begin(box.Min), std::end(box.Min), node.Min);
+        std::copy(std::begin(box.Max), std::end(box.Max), node.Max);
+    }
+}
+
+void Bvh::CullFrustum( const float planes[6][4], std::vector<uint32_t>* visible ) const
+{
+    if (m_Nodes.empty())
+    {
+        return;
+    }
+
+    // Bit p of a mask is set while a box may still be outside plane p. Planes a node is entirely inside of
+    // are not tested again for anything below it.
+    enum class Containment { Outside, Intersecting, Inside };
+    auto classify = [planes]( const float* min, const float* max, uint32_t* mask )
+    {
+        for (int p = 0; p < 6; ++p)
+        {
+            if ((*mask & (1u << p)) == 0)
+            {
+                continue;
+            }
+            const float* plane = planes[p];
+            float        farthest = plane[3];
+            float        nearest = plane[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                farthest += plane[k] * (plane[k] >= 0.0f ? max[k] : min[k]);
+                nearest += plane[k] * (plane[k] >= 0.0f ? min[k] : max[k]);
+            }
+            if (farthest < 0.0f)
+            {
+                return Containment::Outside;
+            }
+            if (nearest >= 0.0f)
+            {
+                *mask &= ~(1u << p);
+            }
+        }
+        return *mask == 0 ? Containment::Inside : Containment::Intersecting;
+    };
+
+    struct StackEntry {
+        uint32_t Node;
+        uint32_t Mask;
+    };
+    StackEntry stack[MAX_STACK_DEPTH];
+    uint32_t   stackSize = 0;
+    stack[stackSize++] = {0, 0x3F};
+    while (stackSize != 0)
+    {
+        StackEntry  entry = stack[--stackSize];
+        const auto &node = m_Nodes[entry.Node];
+        Containment containment = classify(node.Min, node.Max, &entry.Mask);
+        if (containment == Containment::Outside)
+        {
+            continue;
+        }
+
+        if (containment == Containment::Inside)
+        {
+            // The primitives of a subtree are contiguous, from its leftmost to its rightmost leaf.
+            const BvhNode* leftmost = &node;
+            while (leftmost->NumPrimitives == 0)
+            {
+                leftmost = &m_Nodes[leftmost->FirstChildOrPrimitive];
+            }
+            const BvhNode* rightmost = &node;
+            while (rightmost->NumPrimitives == 0)
+            {
+                rightmost = &m_Nodes[rightmost->FirstChildOrPrimitive + 1];
+            }
+            visible->insert(visible->end(), m_PrimitiveIndices.begin() + leftmost->FirstChildOrPrimitive,
+                            m_PrimitiveIndices.begin() + rightmost->FirstChildOrPrimitive + rightmost->NumPrimitives);
+        } else if (node.NumPrimitives != 0)
+        {
+            for (uint32_t i = 0; i < node.NumPrimitives; ++i)
+            {
+                uint32_t primitive = m_PrimitiveIndices[node.FirstChildOrPrimitive + i];
+                uint32_t mask = entry.Mask;
+                if (classify(m_Bounds[primitive].Min, m_Bounds[primitive].Max, &mask) != Containment::Outside)
+                {
+                    visible->push_back(primitive);
+                }
+            }
+        } else
+        {
+            stack[stackSize++] = {node.FirstChildOrPrimitive + 1, entry.Mask};
+            stack[stackSize++] = {node.FirstChildOrPrimitive, entry.Mask};
+        }
+    }
+}
+
+void Bvh::IntersectBounds( const Ray &ray, std::vector<RayHit>* hits ) const
+{
+    hits->clear();
+    if (m_Nodes.empty())
+    {
+        return;
+    }
+
+    float inverseDirection[3];
+    InverseDirection(ray.Direction, inverseDirection);
+
+    uint32_t stack[MAX_STACK_DEPTH];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize != 0)
+    {
+        const auto &node = m_Nodes[stack[--stackSize]];
+        if (IntersectBox(node.Min, node.Max, ray.Origin, inverseDirection, ray.MaxDistance) == FLT_MAX)
+        {
+            continue;
+        }
+
+        if (node.NumPrimitives == 0)
+        {
+            stack[stackSize++] = node.FirstChildOrPrimitive + 1;
+            stack[stackSize++] = node.FirstChildOrPrimitive;
+            continue;
+        }
+
+        for (uint32_t i = 0; i < node.NumPrimitives; ++i)
+        {
+            uint32_t    primitive = m_PrimitiveIndices[node.FirstChildOrPrimitive + i];
+            const auto &bounds = m_Bounds[primitive];
+            float       distance = IntersectBox(bounds.Min, bounds.Max, ray.Origin, inverseDirection,
+                                                ray.MaxDistance);
+            if (distance != FLT_MAX)
+            {
+                RayHit hit;
+                hit.Distance = distance;
+                hit.Primitive = primitive;
+                hits->push_back(hit);
+            }
+        }
+    }
+
+    std::sort(hits->begin(), hits->end(), []( const RayHit &a, const RayHit &b ) { return a.Distance < b.Distance; });
+}
+
+void TriangleBvh::Build( const float*     positions, size_t vertexCount, size_t positionStride,
+                         const uint32_t*  indices, size_t indexCount, bool parallel )
+{
+    auto position = [&]( uint32_t index )
+    {
+        return reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(positions) + index * positionStride);
+    };
+
+    // Triangles referring to vertices that do not exist are left out of the tree.
+    std::vector<uint32_t> triangles;
+    triangles.reserve(indexCount / 3);
+    for (size_t i = 0; i + 3 <= indexCount; i += 3)
+    {
+        if (indices[i] < vertexCount && indices[i + 1] < vertexCount && indices[i + 2] < vertexCount)
+        {
+            triangles.push_back(static_cast<uint32_t>(i / 3));
+        }
+    }
+
+    std::vector<BoundingBox> bounds(triangles.size(), EmptyBox());
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            Grow(&bounds[i], position(indices[size_t(triangles[i]) * 3 + corner]));
+        }
+    }
+    m_Bvh.Build(bounds.data(), static_cast<uint32_t>(bounds.size()), parallel);
+
+    // Leaves index the triangles straight, the primitive indices of the tree map back to the mesh's triangles.
+    m_Triangles.resize(triangles.size());
+    for (uint32_t i = 0; i < m_Bvh.GetNumPrimitives(); ++i)
+    {
+        uint32_t        primitive = m_Bvh.GetPrimitiveIndex(i);
+        const uint32_t* triangle = indices + size_t(triangles[primitive]) * 3;
+        const float*    p0 = position(triangle[0]);
+        const float*    p1 = position(triangle[1]);
+        const float*    p2 = position(triangle[2]);
+        auto &          data = m_Triangles[i];
+        for (int k = 0; k < 3; ++k)
+        {
+            data.Vertex0[k] = p0[k];
+            data.Edge1[k] = p1[k] - p0[k];
+            data.Edge2[k] = p2[k] - p0[k];
+        }
+    }
+    m_TriangleIndices.resize(triangles.size());
+    for (uint32_t i = 0; i < m_Bvh.GetNumPrimitives(); ++i)
+    {
+        m_TriangleIndices[i] = triangles[m_Bvh.GetPrimitiveIndex(i)];
+    }
+}
+
+bool TriangleBvh::Intersect( const Ray &ray, RayHit* hit ) const
+{
+    const auto &nodes = m_Bvh.GetNodes();
+    *hit = RayHit();
+    if (nodes.empty())
+    {
+        return false;
+    }
+
+    float inverseDirection[3];
+    InverseDirection(ray.Direction, inverseDirection);
+    const float* d = ray.Direction;
+
+    float    closest = ray.MaxDistance;
+    uint32_t stack[MAX_STACK_DEPTH];
+    uint32_t stackSize = 0;
+    if (IntersectBox(nodes[0].Min, nodes[0].Max, ray.Origin, inverseDirection, closest) != FLT_MAX)
+    {
+        stack[stackSize++] = 0;
+    }
+    while (stackSize != 0)
+    {
+        const auto &node = nodes[stack[--stackSize]];
+        if (node.NumPrimitives == 0)
+        {
+            // Visit the nearer child first, so the farther one is more often skipped as behind the closest hit.
+            uint32_t left = node.FirstChildOrPrimitive;
+            uint32_t right = left + 1;
+            float    leftDistance = IntersectBox(nodes[left].Min, nodes[left].Max, ray.Origin, inverseDirection,
+                                                 closest);
+            float    rightDistance = IntersectBox(nodes[right].Min, nodes[right].Max, ray.Origin, inverseDirection,
+                                                  closest);
+            if (leftDistance > rightDistance)
+            {
+                std::swap(left, right);
+                std::swap(leftDistance, rightDistance);
+            }
+            if (rightDistance != FLT_MAX)
+            {
+                stack[stackSize++] = right;
+            }
+            if (leftDistance != FLT_MAX)
+            {
+                stack[stackSize++] = left;
+            }
+            continue;
+        }
+
+        // Moller-Trumbore.
+        for (uint32_t i = node.FirstChildOrPrimitive; i < node.FirstChildOrPrimitive + node.NumPrimitives; ++i)
+        {
+            const auto &triangle = m_Triangles[i];
+            const float* e1 = triangle.Edge1;
+            const float* e2 = triangle.Edge2;
+            float        p[3] = {d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0]};
+            float        determinant = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+            if (determinant == 0.0f)
+            {
+                continue;
+            }
+            float inverseDeterminant = 1.0f / determinant;
+            float s[3] = {ray.Origin[0] - triangle.Vertex0[0], ray.Origin[1] - triangle.Vertex0[1],
+                          ray.Origin[2] - triangle.Vertex0[2]};
+            float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverseDeterminant;
+            if (u < 0.0f || u > 1.0f)
+            {
+                continue;
+            }
+            float q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+            float v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inverseDeterminant;
+            if (v < 0.0f || u + v > 1.0f)
+            {
+                continue;
+            }
+            float t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inverseDeterminant;
+            if (t >= 0.0f && t <= closest)
+            {
+                closest = t;
+                hit->Distance = t;
+                hit->Primitive = m_TriangleIndices[i];
+                hit->U = u;
+                hit->V = v;
+            }
+        }
+    }
+    return hit->Primitive != INVALID_PRIMITIVE;
+}
+
+uint32_t TriangleBvh::Intersect( const RayPacket &rays, RayHit hits[4] ) const
+{
+    const auto &nodes = m_Bvh.GetNodes();
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        hits[lane] = RayHit();
+    }
+    if (nodes.empty())
+    {
+        return 0;
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128       originX = _mm_loadu_ps(rays.OriginX);
+    __m128       originY = _mm_loadu_ps(rays.OriginY);
+    __m128       originZ = _mm_loadu_ps(rays.OriginZ);
+    __m128       directionX = _mm_loadu_ps(rays.DirectionX);
+    __m128       directionY = _mm_loadu_ps(rays.DirectionY);
+    __m128       directionZ = _mm_loadu_ps(rays.DirectionZ);
+    __m128       inverseX = _mm_div_ps(one, directionX);
+    __m128       inverseY = _mm_div_ps(one, directionY);
+    __m128       inverseZ = _mm_div_ps(one, directionZ);
+    __m128       closest = _mm_loadu_ps(rays.MaxDistance);
+    __m128       hitU = zero;
+    __m128       hitV = zero;
+    uint32_t     hitTriangles[4] = {INVALID_PRIMITIVE, INVALID_PRIMITIVE, INVALID_PRIMITIVE, INVALID_PRIMITIVE};
+
+    // Lanes whose ray enters the node before their closest hit. Operand order makes NaN slabs drop out as in
+    // IntersectBox.
+    auto intersectNode = [&]( const BvhNode &node )
+    {
+        __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Min[0]), originX), inverseX);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Max[0]), originX), inverseX);
+        __m128 tMin = _mm_max_ps(_mm_min_ps(t1, t0), zero);
+        __m128 tMax = _mm_min_ps(_mm_max_ps(t1, t0), closest);
+        t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Min[1]), originY), inverseY);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Max[1]), originY), inverseY);
+        tMin = _mm_max_ps(_mm_min_ps(t1, t0), tMin);
+        tMax = _mm_min_ps(_mm_max_ps(t1, t0), tMax);
+        t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Min[2]), originZ), inverseZ);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.Max[2]), originZ), inverseZ);
+        tMin = _mm_max_ps(_mm_min_ps(t1, t0), tMin);
+        tMax = _mm_min_ps(_mm_max_ps(t1, t0), tMax);
+        return _mm_movemask_ps(_mm_cmple_ps(tMin, tMax));
+    };
+
+    uint32_t stack[MAX_STACK_DEPTH];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize != 0)
+    {
+        const auto &node = nodes[stack[--stackSize]];
+        if (intersectNode(node) == 0)
+        {
+            continue;
+        }
+
+        if (node.NumPrimitives == 0)
+        {
+            stack[stackSize++] = node.FirstChildOrPrimitive + 1;
+            stack[stackSize++] = node.FirstChildOrPrimitive;
+            continue;
+        }
+
+        for (uint32_t i = node.FirstChildOrPrimitive; i < node.FirstChildOrPrimitive + node.NumPrimitives; ++i)
+        {
+            const auto &triangle = m_Triangles[i];
+            __m128      e1X = _mm_set1_ps(triangle.Edge1[0]);
+            __m128      e1Y = _mm_set1_ps(triangle.Edge1[1]);
+            __m128      e1Z = _mm_set1_ps(triangle.Edge1[2]);
+            __m128      e2X = _mm_set1_ps(triangle.Edge2[0]);
+            __m128      e2Y = _mm_set1_ps(triangle.Edge2[1]);
+            __m128      e2Z = _mm_set1_ps(triangle.Edge2[2]);
+
+            __m128 pX = _mm_sub_ps(_mm_mul_ps(directionY, e2Z), _mm_mul_ps(directionZ, e2Y));
+            __m128 pY = _mm_sub_ps(_mm_mul_ps(directionZ, e2X), _mm_mul_ps(directionX, e2Z));
+            __m128 pZ = _mm_sub_ps(_mm_mul_ps(directionX, e2Y), _mm_mul_ps(directionY, e2X));
+            __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1X, pX), _mm_mul_ps(e1Y, pY)),
+                                            _mm_mul_ps(e1Z, pZ));
+            __m128 inverseDeterminant = _mm_div_ps(one, determinant);
+
+            __m128 sX = _mm_sub_ps(originX, _mm_set1_ps(triangle.Vertex0[0]));
+            __m128 sY = _mm_sub_ps(originY, _mm_set1_ps(triangle.Vertex0[1]));
+            __m128 sZ = _mm_sub_ps(originZ, _mm_set1_ps(triangle.Vertex0[2]));
+            __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sX, pX), _mm_mul_ps(sY, pY)), _mm_mul_ps(sZ, pZ)),
+                                  inverseDeterminant);
+
+            __m128 qX = _mm_sub_ps(_mm_mul_ps(sY, e1Z), _mm_mul_ps(sZ, e1Y));
+            __m128 qY = _mm_sub_ps(_mm_mul_ps(sZ, e1X), _mm_mul_ps(sX, e1Z));
+            __m128 qZ = _mm_sub_ps(_mm_mul_ps(sX, e1Y), _mm_mul_ps(sY, e1X));
+            __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(directionX, qX), _mm_mul_ps(directionY, qY)),
+                                             _mm_mul_ps(directionZ, qZ)), inverseDeterminant);
+            __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2X, qX), _mm_mul_ps(e2Y, qY)),
+                                             _mm_mul_ps(e2Z, qZ)), inverseDeterminant);
+
+            // Every comparison is false for the NaNs of a zero determinant.
+            __m128 hit = _mm_and_ps(_mm_cmpneq_ps(determinant, zero), _mm_cmpge_ps(u, zero));
+            hit = _mm_and_ps(hit, _mm_cmpge_ps(v, zero));
+            hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), one));
+            hit = _mm_and_ps(hit, _mm_cmpge_ps(t, zero));
+            hit = _mm_and_ps(hit, _mm_cmple_ps(t, closest));
+            int hitMask = _mm_movemask_ps(hit);
+            if (hitMask == 0)
+            {
+                continue;
+            }
+
+            closest = _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, closest));
+            hitU = _mm_or_ps(_mm_and_ps(hit, u), _mm_andnot_ps(hit, hitU));
+            hitV = _mm_or_ps(_mm_and_ps(hit, v), _mm_andnot_ps(hit, hitV));
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                if (hitMask & (1 << lane))
+                {
+                    hitTriangles[lane] = m_TriangleIndices[i];
+                }
+            }
+        }
+    }
+
+    float distances[4];
+    float us[4];
+    float vs[4];
+    _mm_storeu_ps(distances, closest);
+    _mm_storeu_ps(us, hitU);
+    _mm_storeu_ps(vs, hitV);
+    uint32_t hitMask = 0;
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        if (hitTriangles[lane] != INVALID_PRIMITIVE)
+        {
+            hits[lane].Distance = distances[lane];
+            hits[lane].Primitive = hitTriangles[lane];
+            hits[lane].U = us[lane];
+            hits[lane].V = vs[lane];
+            hitMask |= 1u << lane;
+        }
+    }
+    return hitMask;
+}
+
+}
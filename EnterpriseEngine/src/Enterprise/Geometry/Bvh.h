@@ -0,0 +1,153 @@
+#ifndef BVH_H
+#define BVH_H
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Bounds.h"
+
+
+namespace Enterprise::Geometry {
+
+struct Ray {
+    float Origin[3];
+    float Direction[3];
+    // Hits are found at distances in [0, MaxDistance], measured in multiples of Direction.
+    float MaxDistance = FLT_MAX;
+};
+
+// Four rays traced together, one per lane.
+struct RayPacket {
+    float OriginX[4];
+    float OriginY[4];
+    float OriginZ[4];
+    float DirectionX[4];
+    float DirectionY[4];
+    float DirectionZ[4];
+    float MaxDistance[4] = {FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX};
+};
+
+constexpr uint32_t INVALID_PRIMITIVE = UINT32_MAX;
+
+struct RayHit {
+    float    Distance = FLT_MAX;
+    uint32_t Primitive = INVALID_PRIMITIVE;
+    // Barycentrics of triangle hits, the hit point is (1 - U - V) * p0 + U * p1 + V * p2.
+    float    U = 0.0f;
+    float    V = 0.0f;
+};
+
+struct BvhNode {
+    float    Min[3];
+    // Interior nodes: the first child, the second one follows it. Leaves: the first primitive, see
+    // Bvh::GetPrimitiveIndex.
+    uint32_t FirstChildOrPrimitive;
+    float    Max[3];
+    // 0 for interior nodes.
+    uint32_t NumPrimitives;
+};
+static_assert(sizeof(BvhNode) == 32);
+
+/**
+ * Bounding volume hierarchy over the boxes of any kind of primitive. Nodes are split where the binned
+ * surface area heuristic is lowest, and the primitives of every subtree are contiguous in GetPrimitiveIndex
+ * order. Children are always stored after their parent.
+ */
+class Bvh {
+public:
+    Bvh() = default;
+
+    /**
+     * Build over the bounds of count primitives. Large subtrees are built in parallel on the thread pool when
+     * parallel is set.
+     */
+    void Build( const BoundingBox* bounds, uint32_t count, bool parallel = true );
+
+    /**
+     * Update the nodes to new bounds of the same primitives, keeping the tree. Much cheaper than a build, but the
+     * tree gets looser the further primitives move from where they were built.
+     */
+    void Refit( const BoundingBox* bounds );
+
+    /**
+     * Append the primitives whose bounds intersect the frustum to visible, in no particular order. Subtrees
+     * entirely inside are taken without further tests and subtrees outside a plane are skipped whole.
+     * planes are as in BoundsCuller::Cull.
+     */
+    void CullFrustum( const float planes[6][4], std::vector<uint32_t>* visible ) const;
+
+    /**
+     * Collect the primitives whose bounds the ray hits, as hits at the distance the ray enters them, nearest
+     * first. For callers that test the primitives themselves and can stop at the first candidate that is
+     * farther away than their closest hit.
+     */
+    void IntersectBounds( const Ray &ray, std::vector<RayHit>* hits ) const;
+
+    [[nodiscard]] bool IsEmpty() const { return m_Nodes.empty(); }
+
+    [[nodiscard]] const std::vector<BvhNode> &GetNodes() const { return m_Nodes; }
+
+    [[nodiscard]] uint32_t GetNumPrimitives() const { return static_cast<uint32_t>(m_PrimitiveIndices.size()); }
+
+    // The primitive at position index of the leaf order.
+    [[nodiscard]] uint32_t GetPrimitiveIndex( uint32_t index ) const { return m_PrimitiveIndices[index]; }
+
+private:
+    struct BuildState;
+
+    void Subdivide( BuildState &state, uint32_t node, uint32_t first, uint32_t count, uint32_t depth );
+
+    std::vector<BvhNode>     m_Nodes;
+    std::vector<uint32_t>    m_PrimitiveIndices;
+    // Per primitive, in the order they were given.
+    std::vector<BoundingBox> m_Bounds;
+};
+
+/**
+ * Triangle level hierarchy of a mesh for ray casts against its geometry, picking and baking. The triangles
+ * are copied in leaf order as a vertex and two edges, which is what the intersection test needs.
+ */
+class TriangleBvh {
+public:
+    TriangleBvh() = default;
+
+    /**
+     * positions points at the first float3 position, positionStride is the distance between vertices in bytes.
+     */
+    void Build( const float*     positions, size_t vertexCount, size_t positionStride, const uint32_t* indices,
+                size_t           indexCount, bool parallel = true );
+
+    /**
+     * Find the closest triangle along the ray, both sides count. hit->Primitive is the index of the triangle,
+     * its first index divided by three. Returns whether anything was hit.
+     */
+    bool Intersect( const Ray &ray, RayHit* hit ) const;
+
+    /**
+     * Trace four rays through the hierarchy together, testing each node and triangle against all of them at once.
+     * Coherent rays, neighbouring pixels for example, visit mostly the same nodes. Returns a mask with bit i set
+     * when ray i hit.
+     */
+    uint32_t Intersect( const RayPacket &rays, RayHit hits[4] ) const;
+
+    [[nodiscard]] const Bvh &GetBvh() const { return m_Bvh; }
+
+    [[nodiscard]] uint32_t GetNumTriangles() const { return m_Bvh.GetNumPrimitives(); }
+
+private:
+    struct Triangle {
+        float Vertex0[3];
+        float Edge1[3];
+        float Edge2[3];
+    };
+
+    Bvh                   m_Bvh;
+    // In leaf order, with the index of the mesh triangle each one came from.
+    std::vector<Triangle> m_Triangles;
+    std::vector<uint32_t> m_TriangleIndices;
+};
+
+}
+
+#endif //BVH_H
@@ -0,0 +1,425 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace Enterprise::Geometry {
+
+namespace {
+
+// Forsyth's tuning constants. See https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+constexpr uint32_t FORSYTH_MAX_VALENCE = 32;
+constexpr float    FORSYTH_CACHE_DECAY_POWER = 1.5f;
+constexpr float    FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float    FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+constexpr float    FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+constexpr uint32_t INVALID_INDEX = ~0u;
+
+struct ForsythScoreTables {
+    ForsythScoreTables()
+    {
+        for (uint32_t i = 0; i < FORSYTH_CACHE_SIZE; ++i)
+        {
+            if (i < 3)
+            {
+                // The vertices of the last triangle get a fixed score so it does not pay to reuse them right away.
+                Cache[i] = FORSYTH_LAST_TRIANGLE_SCORE;
+            } else
+            {
+                float scaler = 1.0f / float(FORSYTH_CACHE_SIZE - 3);
+                Cache[i] = std::pow(1.0f - float(i - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+            }
+        }
+        Valence[0] = 0.0f;
+        for (uint32_t i = 1; i <= FORSYTH_MAX_VALENCE; ++i)
+        {
+            // Boost vertices with few triangles left so lone triangles do not get stranded.
+            Valence[i] = FORSYTH_VALENCE_BOOST_SCALE * std::pow(float(i), -FORSYTH_VALENCE_BOOST_POWER);
+        }
+    }
+
+    float Cache[FORSYTH_CACHE_SIZE];
+    float Valence[FORSYTH_MAX_VALENCE + 1];
+};
+
+float GetVertexScore( const ForsythScoreTables &tables, uint32_t cachePosition, uint32_t liveTriangles )
+{
+    if (liveTriangles == 0)
+    {
+        // No triangles left to draw with this vertex.
+        return -1.0f;
+    }
+
+    float score = cachePosition < FORSYTH_CACHE_SIZE ? tables.Cache[cachePosition] : 0.0f;
+    return score + tables.Valence[std::min(liveTriangles, FORSYTH_MAX_VALENCE)];
+}
+
+// FIFO cache simulation using timestamps. A vertex is in the cache if it was added less than cacheSize
+// insertions ago. Returns the number of misses for the triangle.
+uint32_t UpdateCache( uint32_t a, uint32_t b, uint32_t c, uint32_t cacheSize, uint32_t* timestamps,
+                      uint32_t &timestamp )
+{
+    uint32_t misses = 0;
+    for (uint32_t vertex: {a, b, c})
+    {
+        if (timestamp - timestamps[vertex] > cacheSize)
+        {
+            timestamps[vertex] = timestamp++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+}
+
+VertexCacheStatistics AnalyzeVertexCache( const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                          uint32_t        cacheSize )
+{
+    assert(indexCount % 3 == 0);
+
+    VertexCacheStatistics statistics;
+    statistics.Triangles = indexCount / 3;
+
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    std::vector<bool>     referenced(vertexCount, false);
+    uint32_t              timestamp = cacheSize + 1;
+    for (size_t i = 0; i < indexCount; i += 3)
+    {
+        statistics.VerticesTransformed += UpdateCache(indices[i + 0], indices[i + 1], indices[i + 2], cacheSize,
+                                                      timestamps.data(), timestamp);
+    }
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        if (!referenced[indices[i]])
+        {
+            referenced[indices[i]] = true;
+            statistics.Vertices++;
+        }
+    }
+
+    return statistics;
+}
+
+void OptimizeVertexCache( uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount )
+{
+    assert(indexCount % 3 == 0);
+
+    static const ForsythScoreTables tables;
+
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Triangle adjacency per vertex, packed as offsets into a single array.
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        liveTriangles[indices[i]]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+    }
+
+    std::vector<uint32_t> adjacency(indexCount);
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    // Copy the input, destination may alias it.
+    std::vector<uint32_t> input(indices, indices + indexCount);
+
+    std::vector<uint32_t> cachePosition(vertexCount, INVALID_INDEX);
+    std::vector<float>    vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        vertexScore[v] = GetVertexScore(tables, INVALID_INDEX, liveTriangles[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool>  emitted(triangleCount, false);
+    uint32_t           bestTriangle = 0;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        triangleScore[t] = vertexScore[input[t * 3 + 0]] + vertexScore[input[t * 3 + 1]] +
+                           vertexScore[input[t * 3 + 2]];
+        if (triangleScore[t] > triangleScore[bestTriangle])
+        {
+            bestTriangle = static_cast<uint32_t>(t);
+        }
+    }
+
+    // The cache holds up to 3 extra entries while a new triangle is pushed to the front.
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t cacheCount = 0;
+    size_t   inputCursor = 0;
+
+    for (size_t output = 0; output < triangleCount; ++output)
+    {
+        if (bestTriangle == INVALID_INDEX)
+        {
+            // Nothing connected to the cache is left, continue with the next triangle in input order.
+            while (emitted[inputCursor])
+            {
+                inputCursor++;
+            }
+            bestTriangle = static_cast<uint32_t>(inputCursor);
+        }
+
+        const uint32_t triangle[3] = {
+            input[bestTriangle * 3 + 0], input[bestTriangle * 3 + 1], input[bestTriangle * 3 + 2]
+        };
+        destination[output * 3 + 0] = triangle[0];
+        destination[output * 3 + 1] = triangle[1];
+        destination[output * 3 + 2] = triangle[2];
+        emitted[bestTriangle] = true;
+
+        // Remove the triangle from the adjacency of its vertices.
+        for (uint32_t vertex: triangle)
+        {
+            uint32_t* begin = adjacency.data() + adjacencyOffsets[vertex];
+            uint32_t* end = begin + liveTriangles[vertex];
+            uint32_t* found = std::find(begin, end, bestTriangle);
+            if (found != end)
+            {
+                std::swap(*found, *(end - 1));
+                liveTriangles[vertex]--;
+            }
+        }
+
+        // Push the triangle's vertices to the front of the LRU cache.
+        uint32_t newCacheCount = 0;
+        for (uint32_t vertex: triangle)
+        {
+            if (std::find(newCache, newCache + newCacheCount, vertex) == newCache + newCacheCount)
+            {
+                newCache[newCacheCount++] = vertex;
+            }
+        }
+        for (uint32_t i = 0; i < cacheCount; ++i)
+        {
+            uint32_t vertex = cache[i];
+            if (std::find(newCache, newCache + newCacheCount, vertex) == newCache + newCacheCount)
+            {
+                newCache[newCacheCount++] = vertex;
+            }
+        }
+
+        // Update the scores of every vertex that moved in the cache, including the ones that fell out,
+        // and pick the best triangle touching the cache.
+        bestTriangle = INVALID_INDEX;
+        float bestScore = -1.0f;
+        for (uint32_t i = 0; i < newCacheCount; ++i)
+        {
+            uint32_t vertex = newCache[i];
+            cachePosition[vertex] = i < FORSYTH_CACHE_SIZE ? i : INVALID_INDEX;
+
+            float score = GetVertexScore(tables, cachePosition[vertex], liveTriangles[vertex]);
+            float delta = score - vertexScore[vertex];
+            vertexScore[vertex] = score;
+
+            const uint32_t* begin = adjacency.data() + adjacencyOffsets[vertex];
+            for (uint32_t j = 0; j < liveTriangles[vertex]; ++j)
+            {
+                uint32_t adjacentTriangle = begin[j];
+                triangleScore[adjacentTriangle] += delta;
+                if (i < FORSYTH_CACHE_SIZE && triangleScore[adjacentTriangle] > bestScore)
+                {
+                    bestScore = triangleScore[adjacentTriangle];
+                    bestTriangle = adjacentTriangle;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCacheCount, FORSYTH_CACHE_SIZE);
+        std::memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+    }
+}
+
+void OptimizeOverdraw( uint32_t*    destination, const uint32_t* indices, size_t indexCount, const float* positions,
+                       size_t       vertexCount, size_t positionStride, float threshold )
+{
+    assert(indexCount % 3 == 0);
+    assert(destination != indices);
+
+    constexpr uint32_t cacheSize = 16;
+    const size_t       triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t              timestamp = cacheSize + 1;
+
+    // Hard boundaries: a triangle that misses on all three vertices starts a disjoint patch of the mesh.
+    std::vector<uint32_t> hardClusters;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        uint32_t misses = UpdateCache(indices[t * 3 + 0], indices[t * 3 + 1], indices[t * 3 + 2], cacheSize,
+                                      timestamps.data(), timestamp);
+        if (t == 0 || misses == 3)
+        {
+            hardClusters.push_back(static_cast<uint32_t>(t));
+        }
+    }
+
+    // Soft boundaries: split a hard cluster once its running ACMR is within threshold of the full cluster ACMR.
+    std::vector<uint32_t> clusters;
+    for (size_t c = 0; c < hardClusters.size(); ++c)
+    {
+        const size_t start = hardClusters[c];
+        const size_t end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : triangleCount;
+
+        timestamp += cacheSize + 1;
+        uint32_t clusterMisses = 0;
+        for (size_t t = start; t < end; ++t)
+        {
+            clusterMisses += UpdateCache(indices[t * 3 + 0], indices[t * 3 + 1], indices[t * 3 + 2], cacheSize,
+                                         timestamps.data(), timestamp);
+        }
+        const float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+
+        clusters.push_back(static_cast<uint32_t>(start));
+        timestamp += cacheSize + 1;
+        uint32_t runningMisses = 0;
+        uint32_t runningTriangles = 0;
+        for (size_t t = start; t < end; ++t)
+        {
+            runningMisses += UpdateCache(indices[t * 3 + 0], indices[t * 3 + 1], indices[t * 3 + 2], cacheSize,
+                                         timestamps.data(), timestamp);
+            runningTriangles++;
+            if (float(runningMisses) / float(runningTriangles) <= clusterThreshold)
+            {
+                clusters.push_back(static_cast<uint32_t>(t + 1));
+                timestamp += cacheSize + 1;
+                runningMisses = 0;
+                runningTriangles = 0;
+            }
+        }
+
+        // The last split leaves a short tail with a poor ACMR, merge it back into the previous cluster.
+        // This also removes a boundary that landed on end.
+        if (clusters.back() != start)
+        {
+            clusters.pop_back();
+        }
+    }
+
+    auto position = [positions, positionStride]( uint32_t vertex )
+    {
+        return reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(positions) + vertex * positionStride);
+    };
+
+    float meshCentroid[3] = {};
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        const float* p = position(indices[i]);
+        meshCentroid[0] += p[0];
+        meshCentroid[1] += p[1];
+        meshCentroid[2] += p[2];
+    }
+    for (float &c: meshCentroid)
+    {
+        c /= float(indexCount);
+    }
+
+    // Sort key: how far the cluster sits out along its own average normal, measured from the mesh centre.
+    // Clusters on the outside of the mesh are likely to occlude the ones behind them.
+    std::vector<float> sortKeys(clusters.size());
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        const size_t start = clusters[c];
+        const size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+        float area = 0.0f;
+        float centroid[3] = {};
+        float normal[3] = {};
+        for (size_t t = start; t < end; ++t)
+        {
+            const float* p0 = position(indices[t * 3 + 0]);
+            const float* p1 = position(indices[t * 3 + 1]);
+            const float* p2 = position(indices[t * 3 + 2]);
+
+            float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+            float triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (int k = 0; k < 3; ++k)
+            {
+                centroid[k] += (p0[k] + p1[k] + p2[k]) / 3.0f * triangleArea;
+                normal[k] += n[k];
+            }
+            area += triangleArea;
+        }
+
+        float inverseArea = area > 0.0f ? 1.0f / area : 0.0f;
+        float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float inverseNormalLength = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+
+        float key = 0.0f;
+        for (int k = 0; k < 3; ++k)
+        {
+            key += (centroid[k] * inverseArea - meshCentroid[k]) * normal[k] * inverseNormalLength;
+        }
+        sortKeys[c] = key;
+    }
+
+    std::vector<uint32_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&sortKeys]( uint32_t a, uint32_t b ) { return sortKeys[a] > sortKeys[b]; });
+
+    size_t output = 0;
+    for (uint32_t c: order)
+    {
+        const size_t start = clusters[c];
+        const size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        std::memcpy(destination + output, indices + start * 3, (end - start) * 3 * sizeof(uint32_t));
+        output += (end - start) * 3;
+    }
+    assert(output == indexCount);
+}
+
+size_t OptimizeVertexFetch( void*       destination, uint32_t* indices, size_t indexCount, const void* vertices,
+                            size_t      vertexCount, size_t vertexSize )
+{
+    assert(destination != vertices);
+
+    std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+    uint32_t              nextVertex = 0;
+
+    auto dst = static_cast<uint8_t *>(destination);
+    auto src = static_cast<const uint8_t *>(vertices);
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t &newIndex = remap[indices[i]];
+        if (newIndex == INVALID_INDEX)
+        {
+            std::memcpy(dst + nextVertex * vertexSize, src + indices[i] * vertexSize, vertexSize);
+            newIndex = nextVertex++;
+        }
+        indices[i] = newIndex;
+    }
+
+    return nextVertex;
+}
+
+}
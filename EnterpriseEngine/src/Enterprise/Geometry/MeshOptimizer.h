@@ -0,0 +1,62 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Enterprise::Geometry {
+
+struct VertexCacheStatistics {
+    uint64_t VerticesTransformed = 0;
+    uint64_t Triangles = 0;
+    uint64_t Vertices = 0;
+
+    // Average cache miss ratio: transformed vertices per triangle. 0.5 is the best a regular grid can do.
+    [[nodiscard]] float GetACMR() const { return Triangles ? float(VerticesTransformed) / float(Triangles) : 0.0f; }
+
+    // Average transform to vertex ratio: transformed vertices per referenced vertex. 1.0 is optimal.
+    [[nodiscard]] float GetATVR() const { return Vertices ? float(VerticesTransformed) / float(Vertices) : 0.0f; }
+
+    VertexCacheStatistics &operator+=( const VertexCacheStatistics &other )
+    {
+        VerticesTransformed += other.VerticesTransformed;
+        Triangles += other.Triangles;
+        Vertices += other.Vertices;
+        return *this;
+    }
+};
+
+/**
+ * Simulate a FIFO post-transform cache of cacheSize entries over a triangle list.
+ */
+VertexCacheStatistics AnalyzeVertexCache( const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                          uint32_t        cacheSize = 16 );
+
+/**
+ * Reorder triangles for post-transform cache locality (Forsyth's linear-speed optimizer).
+ * destination may alias indices.
+ */
+void OptimizeVertexCache( uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount );
+
+/**
+ * Reorder clusters of an already cache optimized triangle list so outward facing clusters are drawn first,
+ * which reduces overdraw. Clusters are split where the cache would be flushed anyway, and again whenever the
+ * running ACMR of a cluster reaches threshold times its full ACMR; a threshold of 1.05 keeps the cache
+ * efficiency within 5%.
+ * positions points at the first float3 position, positionStride is the distance between vertices in bytes.
+ * destination must not alias indices.
+ */
+void OptimizeOverdraw( uint32_t*    destination, const uint32_t* indices, size_t indexCount, const float* positions,
+                       size_t       vertexCount, size_t positionStride, float threshold = 1.05f );
+
+/**
+ * Reorder vertices in the order they are first referenced by the index buffer so vertex fetches are
+ * mostly sequential, and rewrite the indices to match. Unreferenced vertices are dropped.
+ * Returns the number of vertices written to destination, which must not alias vertices.
+ */
+size_t OptimizeVertexFetch( void*       destination, uint32_t* indices, size_t indexCount, const void* vertices,
+                            size_t      vertexCount, size_t vertexSize );
+
+}
+
+#endif //MESHOPTIMIZER_H
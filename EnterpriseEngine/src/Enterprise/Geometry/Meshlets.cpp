@@ -0,0 +1,423 @@
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace Enterprise::Geometry {
+
+namespace {
+
+constexpr uint32_t INVALID_INDEX = ~0u;
+
+const float* Position( const float* positions, size_t stride, uint32_t vertex )
+{
+    return reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(positions) + vertex * stride);
+}
+
+float Dot( const float* a, const float* b )
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+float DistanceSquared( const float* a, const float* b )
+{
+    float d[3] = {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+    return Dot(d, d);
+}
+
+// Unit normal of a triangle. Returns false for degenerate triangles, which never rasterize
+// and so do not widen the normal cone.
+bool TriangleNormal( const uint32_t* triangle, const float* positions, size_t stride, float normal[3] )
+{
+    const float* p0 = Position(positions, stride, triangle[0]);
+    const float* p1 = Position(positions, stride, triangle[1]);
+    const float* p2 = Position(positions, stride, triangle[2]);
+
+    float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+    float length = std::sqrt(Dot(normal, normal));
+    if (length == 0.0f)
+    {
+        return false;
+    }
+    normal[0] /= length;
+    normal[1] /= length;
+    normal[2] /= length;
+    return true;
+}
+
+// Ritter's bounding sphere over the vertices referenced by a meshlet.
+void ComputeBoundingSphere( const uint32_t* indices, uint32_t indexCount, const float* positions,
+                            size_t          stride, float center[3], float* radius )
+{
+    auto farthestFrom = [&]( const float* from )
+    {
+        const float* farthest = from;
+        float        farthestDistance = 0.0f;
+        for (uint32_t i = 0; i < indexCount; ++i)
+        {
+            const float* p = Position(positions, stride, indices[i]);
+            float        distance = DistanceSquared(p, from);
+            if (distance > farthestDistance)
+            {
+                farthestDistance = distance;
+                farthest = p;
+            }
+        }
+        return farthest;
+    };
+
+    const float* a = farthestFrom(Position(positions, stride, indices[0]));
+    const float* b = farthestFrom(a);
+    for (int k = 0; k < 3; ++k)
+    {
+        center[k] = (a[k] + b[k]) * 0.5f;
+    }
+    float r = std::sqrt(DistanceSquared(a, b)) * 0.5f;
+
+    for (uint32_t i = 0; i < indexCount; ++i)
+    {
+        const float* p = Position(positions, stride, indices[i]);
+        float        distance = std::sqrt(DistanceSquared(p, center));
+        if (distance > r)
+        {
+            // Grow the sphere just enough to touch p, moving the centre towards it.
+            float newRadius = (r + distance) * 0.5f;
+            float shift = (newRadius - r) / distance;
+            for (int k = 0; k < 3; ++k)
+            {
+                center[k] += (p[k] - center[k]) * shift;
+            }
+            r = newRadius;
+        }
+    }
+    *radius = r;
+}
+
+}
+
+std::vector<Meshlet> BuildMeshlets( uint32_t*    destination, const uint32_t* indices, size_t indexCount,
+                                    const float* positions, size_t vertexCount, size_t positionStride,
+                                    uint32_t     maxVertices, uint32_t maxTriangles )
+{
+    assert(indexCount % 3 == 0);
+    assert(destination != indices);
+    assert(maxVertices >= 3 && maxTriangles >= 1);
+
+    std::vector<Meshlet> meshlets;
+    const size_t         triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return meshlets;
+    }
+
+    // Triangles using each vertex, packed as offsets into a single array. Emitted triangles are swapped
+    // out of the live part of each list so the candidate search only sees what is left.
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        liveTriangles[indices[i]]++;
+    }
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+    }
+    std::vector<uint32_t> adjacency(indexCount);
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<bool>     emitted(triangleCount, false);
+    // Id of the meshlet a vertex was last added to, so membership is a single compare.
+    std::vector<uint32_t> vertexMeshlet(vertexCount, INVALID_INDEX);
+    std::vector<uint32_t> meshletVertices;
+    meshletVertices.reserve(maxVertices);
+
+    size_t   output = 0;
+    size_t   seedCursor = 0;
+    uint32_t meshletId = 0;
+
+    Meshlet meshlet{};
+    float   centroidSum[3] = {};
+
+    auto countNewVertices = [&]( uint32_t triangle )
+    {
+        uint32_t count = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            count += vertexMeshlet[indices[triangle * 3 + k]] != meshletId;
+        }
+        return count;
+    };
+
+    auto fits = [&]( uint32_t triangle )
+    {
+        return meshletVertices.size() + countNewVertices(triangle) <= maxVertices &&
+               meshlet.NumIndices / 3 < maxTriangles;
+    };
+
+    auto addTriangle = [&]( uint32_t triangle )
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            uint32_t vertex = indices[triangle * 3 + k];
+            destination[output++] = vertex;
+
+            if (vertexMeshlet[vertex] != meshletId)
+            {
+                vertexMeshlet[vertex] = meshletId;
+                meshletVertices.push_back(vertex);
+
+                const float* p = Position(positions, positionStride, vertex);
+                centroidSum[0] += p[0];
+                centroidSum[1] += p[1];
+                centroidSum[2] += p[2];
+            }
+
+            uint32_t* begin = adjacency.data() + adjacencyOffsets[vertex];
+            uint32_t* end = begin + liveTriangles[vertex];
+            uint32_t* found = std::find(begin, end, triangle);
+            if (found != end)
+            {
+                std::swap(*found, *(end - 1));
+                liveTriangles[vertex]--;
+            }
+        }
+        emitted[triangle] = true;
+        meshlet.NumIndices += 3;
+    };
+
+    auto finishMeshlet = [&]()
+    {
+        meshlet.NumVertices = static_cast<uint32_t>(meshletVertices.size());
+        ComputeMeshletBounds(&meshlet, destination + meshlet.FirstIndex, positions, positionStride);
+        meshlets.push_back(meshlet);
+
+        meshletId++;
+        meshletVertices.clear();
+        meshlet = Meshlet{};
+        meshlet.FirstIndex = static_cast<uint32_t>(output);
+        centroidSum[0] = centroidSum[1] = centroidSum[2] = 0.0f;
+    };
+
+    while (output < indexCount)
+    {
+        // Prefer the triangle adding the fewest vertices, then the one closest to the meshlet's centroid
+        // to keep the bounding spheres tight.
+        uint32_t best = INVALID_INDEX;
+        uint32_t bestNewVertices = 4;
+        float    bestDistance = INFINITY;
+        if (!meshletVertices.empty())
+        {
+            float centroid[3] = {
+                centroidSum[0] / float(meshletVertices.size()),
+                centroidSum[1] / float(meshletVertices.size()),
+                centroidSum[2] / float(meshletVertices.size())
+            };
+            for (uint32_t vertex: meshletVertices)
+            {
+                const uint32_t* candidates = adjacency.data() + adjacencyOffsets[vertex];
+                for (uint32_t i = 0; i < liveTriangles[vertex]; ++i)
+                {
+                    uint32_t triangle = candidates[i];
+                    uint32_t newVertices = countNewVertices(triangle);
+                    if (newVertices > bestNewVertices || !fits(triangle))
+                    {
+                        continue;
+                    }
+
+                    float triangleCentroid[3] = {};
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        const float* p = Position(positions, positionStride, indices[triangle * 3 + k]);
+                        triangleCentroid[0] += p[0] / 3.0f;
+                        triangleCentroid[1] += p[1] / 3.0f;
+                        triangleCentroid[2] += p[2] / 3.0f;
+                    }
+                    float distance = DistanceSquared(triangleCentroid, centroid);
+                    if (newVertices < bestNewVertices || distance < bestDistance)
+                    {
+                        best = triangle;
+                        bestNewVertices = newVertices;
+                        bestDistance = distance;
+                    }
+                }
+            }
+        }
+
+        if (best == INVALID_INDEX)
+        {
+            // Nothing connected fits, continue with the next triangle in input order.
+            while (emitted[seedCursor])
+            {
+                seedCursor++;
+            }
+            best = static_cast<uint32_t>(seedCursor);
+            if (!meshletVertices.empty() && !fits(best))
+            {
+                finishMeshlet();
+            }
+        }
+
+        addTriangle(best);
+    }
+    finishMeshlet();
+
+    return meshlets;
+}
+
+void ComputeMeshletBounds( Meshlet* meshlet, const uint32_t* indices, const float* positions, size_t positionStride )
+{
+    ComputeBoundingSphere(indices, meshlet->NumIndices, positions, positionStride, meshlet->Center, &meshlet->Radius);
+
+    // Disabled cone: the test in CullMeshlets never passes.
+    meshlet->ConeCutoff = 1.0f;
+    std::memcpy(meshlet->ConeApex, meshlet->Center, sizeof(meshlet->ConeApex));
+    meshlet->ConeAxis[0] = 0.0f;
+    meshlet->ConeAxis[1] = 0.0f;
+    meshlet->ConeAxis[2] = 1.0f;
+
+    // Normal cone: the average triangle normal, widened until it contains every triangle normal.
+    float axis[3] = {};
+    for (uint32_t i = 0; i < meshlet->NumIndices; i += 3)
+    {
+        float normal[3];
+        if (TriangleNormal(indices + i, positions, positionStride, normal))
+        {
+            axis[0] += normal[0];
+            axis[1] += normal[1];
+            axis[2] += normal[2];
+        }
+    }
+
+    float axisLength = std::sqrt(Dot(axis, axis));
+    if (axisLength == 0.0f)
+    {
+        return;
+    }
+    for (float &a: axis)
+    {
+        a /= axisLength;
+    }
+
+    // Move the apex back along the axis until it is behind every triangle plane, so the test is
+    // conservative for viewers close to the meshlet as well.
+    float minimumDot = 1.0f;
+    float maxT = 0.0f;
+    for (uint32_t i = 0; i < meshlet->NumIndices; i += 3)
+    {
+        float normal[3];
+        if (!TriangleNormal(indices + i, positions, positionStride, normal))
+        {
+            continue;
+        }
+
+        float axisDot = Dot(normal, axis);
+        minimumDot = std::min(minimumDot, axisDot);
+        if (axisDot > 0.0f)
+        {
+            const float* p0 = Position(positions, positionStride, indices[i]);
+            float toCenter[3] = {meshlet->Center[0] - p0[0], meshlet->Center[1] - p0[1], meshlet->Center[2] - p0[2]};
+            maxT = std::max(maxT, Dot(toCenter, normal) / axisDot);
+        }
+    }
+
+    if (minimumDot <= 0.1f)
+    {
+        // The cone is close to or wider than a hemisphere and would almost never cull.
+        return;
+    }
+
+    for (int k = 0; k < 3; ++k)
+    {
+        meshlet->ConeApex[k] = meshlet->Center[k] - axis[k] * maxT;
+        meshlet->ConeAxis[k] = axis[k];
+    }
+    meshlet->ConeCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+}
+
+void ExtractFrustumPlanes( const float modelViewProjection[16], float planes[6][4] )
+{
+    // With row vectors clip = v * M, so each plane is a sum of the w column and one of the others.
+    auto column = [modelViewProjection]( int c, int r ) { return modelViewProjection[r * 4 + c]; };
+    for (int r = 0; r < 4; ++r)
+    {
+        planes[0][r] = column(3, r) + column(0, r); // Left
+        planes[1][r] = column(3, r) - column(0, r); // Right
+        planes[2][r] = column(3, r) + column(1, r); // Bottom
+        planes[3][r] = column(3, r) - column(1, r); // Top
+        planes[4][r] = column(2, r);                // Near, D3D clip space z >= 0
+        planes[5][r] = column(3, r) - column(2, r); // Far
+    }
+
+    for (int p = 0; p < 6; ++p)
+    {
+        float length = std::sqrt(Dot(planes[p], planes[p]));
+        if (length > 0.0f)
+        {
+            for (float &value: planes[p])
+            {
+                value /= length;
+            }
+        }
+    }
+}
+
+size_t CullMeshlets( const Meshlet* meshlets, size_t meshletCount, const MeshletCullParams &params,
+                     std::vector<IndexRange>* visibleRanges )
+{
+    size_t visible = 0;
+    for (size_t i = 0; i < meshletCount; ++i)
+    {
+        const auto &meshlet = meshlets[i];
+
+        bool outside = false;
+        for (int p = 0; p < 6 && !outside; ++p)
+        {
+            outside = Dot(params.Planes[p], meshlet.Center) + params.Planes[p][3] < -meshlet.Radius;
+        }
+        if (outside)
+        {
+            continue;
+        }
+
+        if (params.ConeCulling && meshlet.ConeCutoff < 1.0f)
+        {
+            float toApex[3] = {
+                meshlet.ConeApex[0] - params.CameraPosition[0],
+                meshlet.ConeApex[1] - params.CameraPosition[1],
+                meshlet.ConeApex[2] - params.CameraPosition[2]
+            };
+            float distance = std::sqrt(Dot(toApex, toApex));
+            if (Dot(toApex, meshlet.ConeAxis) >= meshlet.ConeCutoff * distance)
+            {
+                continue;
+            }
+        }
+
+        visible++;
+        if (!visibleRanges->empty() &&
+            visibleRanges->back().FirstIndex + visibleRanges->back().NumIndices == meshlet.FirstIndex)
+        {
+            visibleRanges->back().NumIndices += meshlet.NumIndices;
+        } else
+        {
+            visibleRanges->push_back({meshlet.FirstIndex, meshlet.NumIndices});
+        }
+    }
+
+    return visible;
+}
+
+}
@@ -0,0 +1,79 @@
+#ifndef MESHLETS_H
+#define MESHLETS_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace Enterprise::Geometry {
+
+// Limits that also fit a mesh shader thread group, should we move to mesh shaders later.
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet {
+    // Range of the mesh's index buffer, which BuildMeshlets reorders so every meshlet is contiguous.
+    uint32_t FirstIndex;
+    uint32_t NumIndices;
+    // Unique vertices referenced by the meshlet.
+    uint32_t NumVertices;
+    uint32_t Reserved;
+
+    float Center[3];
+    float Radius;
+
+    // Every triangle faces away from a viewer at position p when
+    // dot(normalize(ConeApex - p), ConeAxis) >= ConeCutoff. A cutoff of 1 disables the test.
+    float ConeApex[3];
+    float ConeCutoff;
+    float ConeAxis[3];
+    float Padding;
+};
+static_assert(sizeof(Meshlet) == 64);
+
+/**
+ * Split a triangle list into meshlets of at most maxVertices unique vertices and maxTriangles triangles.
+ * Meshlets are grown greedily from triangles that share the most vertices with them, so the input order
+ * (ideally vertex cache optimized) only decides where each meshlet starts.
+ * destination receives the reordered index buffer and may not alias indices.
+ * positions points at the first float3 position, positionStride is the distance between vertices in bytes.
+ */
+std::vector<Meshlet> BuildMeshlets( uint32_t*    destination, const uint32_t* indices, size_t indexCount,
+                                    const float* positions, size_t vertexCount, size_t positionStride,
+                                    uint32_t     maxVertices = MESHLET_MAX_VERTICES,
+                                    uint32_t     maxTriangles = MESHLET_MAX_TRIANGLES );
+
+/**
+ * Compute the bounding sphere and normal cone of a meshlet from its triangles.
+ */
+void ComputeMeshletBounds( Meshlet* meshlet, const uint32_t* indices, const float* positions, size_t positionStride );
+
+struct MeshletCullParams {
+    // Frustum planes in the mesh's local space as (a, b, c, d) with a * x + b * y + c * z + d >= 0 inside.
+    float Planes[6][4];
+    // Viewer position in the mesh's local space.
+    float CameraPosition[3];
+    bool  ConeCulling = true;
+};
+
+/**
+ * Extract the frustum planes from a row major model view projection matrix (row vectors, as DirectXMath).
+ */
+void ExtractFrustumPlanes( const float modelViewProjection[16], float planes[6][4] );
+
+struct IndexRange {
+    uint32_t FirstIndex;
+    uint32_t NumIndices;
+};
+
+/**
+ * Test every meshlet against the frustum and its normal cone, and append the index ranges of the visible
+ * ones to visibleRanges. Ranges of neighbouring visible meshlets are merged to keep the draw count low.
+ * Returns the number of visible meshlets.
+ */
+size_t CullMeshlets( const Meshlet* meshlets, size_t meshletCount, const MeshletCullParams &params,
+                     std::vector<IndexRange>* visibleRanges );
+
+}
+
+#endif //MESHLETS_H
@@ -0,0 +1,371 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <xmmintrin.h>
+
+#include "../Core/ThreadPool.h"
+
+namespace Enterprise::Geometry {
+
+namespace {
+
+// Tiles are the unit of parallel work, blocks the unit of the coarse depth level.
+constexpr uint32_t TILE_WIDTH = 64;
+constexpr uint32_t TILE_HEIGHT = 32;
+constexpr uint32_t BLOCK_SIZE = 8;
+// Absorbs the rounding between the depth interpolated across an occluder and the depth of a box around it, so an
+// object never hides behind itself.
+constexpr float    DEPTH_BIAS = 1e-5f;
+
+void TransformPoint( const float m[16], float x, float y, float z, float clip[4] )
+{
+    for (int j = 0; j < 4; ++j)
+    {
+        clip[j] = x * m[j] + y * m[4 + j] + z * m[8 + j] + m[12 + j];
+    }
+}
+
+}
+
+bool MakeOccluderMesh( const float* positions, size_t vertexCount, size_t positionStride, const uint32_t* indices,
+                       size_t       indexCount, OccluderMesh* occluder )
+{
+    if (vertexCount == 0 || indexCount < 3 || indexCount / 3 > MAX_OCCLUDER_TRIANGLES)
+    {
+        return false;
+    }
+    occluder->Positions.resize(vertexCount * 3);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const auto* position = reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(positions) +
+                                                               i * positionStride);
+        std::copy_n(position, 3, &occluder->Positions[i * 3]);
+    }
+    occluder->Indices.assign(indices, indices + indexCount);
+    return true;
+}
+
+OcclusionCuller::OcclusionCuller( uint32_t width, uint32_t height )
+{
+    Resize(width, height);
+}
+
+void OcclusionCuller::Resize( uint32_t width, uint32_t height )
+{
+    m_Width = std::max(BLOCK_SIZE, (width + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE);
+    m_Height = std::max(BLOCK_SIZE, (height + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE);
+    m_TilesX = (m_Width + TILE_WIDTH - 1) / TILE_WIDTH;
+    m_TilesY = (m_Height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+    m_Depth.assign(size_t(m_Width) * m_Height, 1.0f);
+    m_BlockDepth.assign(size_t(m_Width / BLOCK_SIZE) * (m_Height / BLOCK_SIZE), 1.0f);
+    m_TileTriangles.resize(size_t(m_TilesX) * m_TilesY);
+    Clear();
+}
+
+void OcclusionCuller::Clear()
+{
+    m_Triangles.clear();
+}
+
+void OcclusionCuller::AddOccluder( const float    modelToClip[16], const float* positions, size_t vertexCount,
+                                   size_t         positionStride, const uint32_t* indices, size_t indexCount )
+{
+    m_ClipVertices.resize(vertexCount * 4);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const auto* position = reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(positions) +
+                                                               i * positionStride);
+        TransformPoint(modelToClip, position[0], position[1], position[2], &m_ClipVertices[i * 4]);
+    }
+
+    auto width = static_cast<float>(m_Width);
+    auto height = static_cast<float>(m_Height);
+    for (size_t i = 0; i + 3 <= indexCount; i += 3)
+    {
+        ScreenTriangle triangle;
+        float          z[3];
+        bool           valid = true;
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            uint32_t index = indices[i + corner];
+            if (index >= vertexCount)
+            {
+                valid = false;
+                break;
+            }
+            const float* clip = &m_ClipVertices[size_t(index) * 4];
+            // In front of the near plane, behind the viewer, or not finite.
+            if (!(clip[2] >= 0.0f) || !(clip[3] > 0.0f))
+            {
+                valid = false;
+                break;
+            }
+            float inverseW = 1.0f / clip[3];
+            triangle.X[corner] = (clip[0] * inverseW * 0.5f + 0.5f) * width;
+            triangle.Y[corner] = (0.5f - clip[1] * inverseW * 0.5f) * height;
+            z[corner] = clip[2] * inverseW;
+        }
+        if (!valid || (z[0] > 1.0f && z[1] > 1.0f && z[2] > 1.0f))
+        {
+            continue;
+        }
+
+        float area = (triangle.X[1] - triangle.X[0]) * (triangle.Y[2] - triangle.Y[0]) -
+                     (triangle.X[2] - triangle.X[0]) * (triangle.Y[1] - triangle.Y[0]);
+        if (!(std::fabs(area) > 0.0f))
+        {
+            continue;
+        }
+        if (area < 0.0f)
+        {
+            std::swap(triangle.X[1], triangle.X[2]);
+            std::swap(triangle.Y[1], triangle.Y[2]);
+            std::swap(z[1], z[2]);
+            area = -area;
+        }
+        triangle.Z0 = z[0];
+        float dx1 = triangle.X[1] - triangle.X[0];
+        float dy1 = triangle.Y[1] - triangle.Y[0];
+        float dx2 = triangle.X[2] - triangle.X[0];
+        float dy2 = triangle.Y[2] - triangle.Y[0];
+        triangle.DepthDx = ((z[1] - z[0]) * dy2 - (z[2] - z[0]) * dy1) / area;
+        triangle.DepthDy = ((z[2] - z[0]) * dx1 - (z[1] - z[0]) * dx2) / area;
+
+        // Pixels whose centre is inside the bounds of the triangle and the screen.
+        float minX = std::min({triangle.X[0], triangle.X[1], triangle.X[2]});
+        float maxX = std::max({triangle.X[0], triangle.X[1], triangle.X[2]});
+        float minY = std::min({triangle.Y[0], triangle.Y[1], triangle.Y[2]});
+        float maxY = std::max({triangle.Y[0], triangle.Y[1], triangle.Y[2]});
+        triangle.MinX = static_cast<int>(std::ceil(std::clamp(minX - 0.5f, -1.0f, width)));
+        triangle.MaxX = static_cast<int>(std::floor(std::clamp(maxX - 0.5f, -1.0f, width)));
+        triangle.MinY = static_cast<int>(std::ceil(std::clamp(minY - 0.5f, -1.0f, height)));
+        triangle.MaxY = static_cast<int>(std::floor(std::clamp(maxY - 0.5f, -1.0f, height)));
+        triangle.MinX = std::max(triangle.MinX, 0);
+        triangle.MinY = std::max(triangle.MinY, 0);
+        triangle.MaxX = std::min(triangle.MaxX, static_cast<int>(m_Width) - 1);
+        triangle.MaxY = std::min(triangle.MaxY, static_cast<int>(m_Height) - 1);
+        if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+        {
+            continue;
+        }
+        m_Triangles.push_back(triangle);
+    }
+}
+
+void OcclusionCuller::Rasterize( bool parallel )
+{
+    for (auto &tileTriangles: m_TileTriangles)
+    {
+        tileTriangles.clear();
+    }
+    for (uint32_t i = 0; i < m_Triangles.size(); ++i)
+    {
+        const auto &triangle = m_Triangles[i];
+        for (uint32_t tileY = triangle.MinY / TILE_HEIGHT; tileY <= triangle.MaxY / TILE_HEIGHT; ++tileY)
+        {
+            for (uint32_t tileX = triangle.MinX / TILE_WIDTH; tileX <= triangle.MaxX / TILE_WIDTH; ++tileX)
+            {
+                m_TileTriangles[tileY * m_TilesX + tileX].push_back(i);
+            }
+        }
+    }
+
+    size_t numTiles = m_TileTriangles.size();
+    if (parallel)
+    {
+        Core::Threads::ThreadPool::Get().ParallelFor(numTiles, 1, [this]( size_t begin, size_t end )
+        {
+            for (size_t tile = begin; tile < end; ++tile)
+            {
+                RasterizeTile(static_cast<uint32_t>(tile));
+            }
+        });
+    } else
+    {
+        for (size_t tile = 0; tile < numTiles; ++tile)
+        {
+            RasterizeTile(static_cast<uint32_t>(tile));
+        }
+    }
+}
+
+void OcclusionCuller::RasterizeTile( uint32_t tile )
+{
+    int tileMinX = static_cast<int>(tile % m_TilesX * TILE_WIDTH);
+    int tileMinY = static_cast<int>(tile / m_TilesX * TILE_HEIGHT);
+    int tileMaxX = std::min(tileMinX + static_cast<int>(TILE_WIDTH), static_cast<int>(m_Width)) - 1;
+    int tileMaxY = std::min(tileMinY + static_cast<int>(TILE_HEIGHT), static_cast<int>(m_Height)) - 1;
+    for (int y = tileMinY; y <= tileMaxY; ++y)
+    {
+        std::fill_n(&m_Depth[size_t(y) * m_Width + tileMinX], tileMaxX - tileMinX + 1, 1.0f);
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    for (uint32_t index: m_TileTriangles[tile])
+    {
+        const auto &triangle = m_Triangles[index];
+        // Tiles and the screen are a multiple of four pixels wide, so groups of four never leave the tile.
+        int minX = std::max(triangle.MinX, tileMinX) & ~3;
+        int maxX = std::min(triangle.MaxX, tileMaxX);
+        int minY = std::max(triangle.MinY, tileMinY);
+        int maxY = std::min(triangle.MaxY, tileMaxY);
+
+        // Edge functions, positive inside: a * x + b * y + c for the edge from corner i to corner i + 1.
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        float inverseEdgeA[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            int next = (i + 1) % 3;
+            edgeA[i] = triangle.Y[i] - triangle.Y[next];
+            edgeB[i] = triangle.X[next] - triangle.X[i];
+            edgeC[i] = -(edgeA[i] * triangle.X[i] + edgeB[i] * triangle.Y[i]);
+            inverseEdgeA[i] = edgeA[i] != 0.0f ? 1.0f / edgeA[i] : 0.0f;
+        }
+        __m128 edgeStep0 = _mm_set1_ps(4.0f * edgeA[0]);
+        __m128 edgeStep1 = _mm_set1_ps(4.0f * edgeA[1]);
+        __m128 edgeStep2 = _mm_set1_ps(4.0f * edgeA[2]);
+        __m128 depthStep = _mm_set1_ps(4.0f * triangle.DepthDx);
+        float  depthC = triangle.Z0 - triangle.DepthDx * triangle.X[0] - triangle.DepthDy * triangle.Y[0];
+
+        for (int y = minY; y <= maxY; ++y)
+        {
+            // Narrow the row to where the edges cross it, with a pixel of slack for rounding; the coverage test
+            // below is exact.
+            float centerY = static_cast<float>(y) + 0.5f;
+            float spanMinX = static_cast<float>(minX);
+            float spanMaxX = static_cast<float>(maxX);
+            for (int i = 0; i < 3; ++i)
+            {
+                float crossing = -(edgeB[i] * centerY + edgeC[i]) * inverseEdgeA[i] - 0.5f;
+                if (edgeA[i] > 0.0f)
+                {
+                    spanMinX = std::max(spanMinX, crossing - 1.0f);
+                } else if (edgeA[i] < 0.0f)
+                {
+                    spanMaxX = std::min(spanMaxX, crossing + 1.0f);
+                }
+            }
+            if (!(spanMinX <= spanMaxX))
+            {
+                continue;
+            }
+            int rowMinX = static_cast<int>(spanMinX) & ~3;
+            int rowMaxX = static_cast<int>(spanMaxX);
+
+            __m128 x = _mm_add_ps(_mm_set1_ps(static_cast<float>(rowMinX)), laneOffsets);
+            __m128 edge0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[0]), x), _mm_set1_ps(edgeB[0] * centerY + edgeC[0]));
+            __m128 edge1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[1]), x), _mm_set1_ps(edgeB[1] * centerY + edgeC[1]));
+            __m128 edge2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[2]), x), _mm_set1_ps(edgeB[2] * centerY + edgeC[2]));
+            __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.DepthDx), x),
+                                      _mm_set1_ps(triangle.DepthDy * centerY + depthC));
+            float* row = &m_Depth[size_t(y) * m_Width];
+            for (int pixelX = rowMinX; pixelX <= rowMaxX; pixelX += 4)
+            {
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)),
+                                           _mm_cmpge_ps(edge2, zero));
+                if (_mm_movemask_ps(inside) != 0)
+                {
+                    __m128 stored = _mm_loadu_ps(row + pixelX);
+                    __m128 nearest = _mm_min_ps(stored, depth);
+                    _mm_storeu_ps(row + pixelX, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, stored)));
+                }
+                edge0 = _mm_add_ps(edge0, edgeStep0);
+                edge1 = _mm_add_ps(edge1, edgeStep1);
+                edge2 = _mm_add_ps(edge2, edgeStep2);
+                depth = _mm_add_ps(depth, depthStep);
+            }
+        }
+    }
+
+    uint32_t blocksPerRow = m_Width / BLOCK_SIZE;
+    for (int blockY = tileMinY; blockY <= tileMaxY; blockY += BLOCK_SIZE)
+    {
+        for (int blockX = tileMinX; blockX <= tileMaxX; blockX += BLOCK_SIZE)
+        {
+            __m128 farthest = _mm_setzero_ps();
+            for (int y = blockY; y < blockY + static_cast<int>(BLOCK_SIZE); ++y)
+            {
+                const float* row = &m_Depth[size_t(y) * m_Width + blockX];
+                farthest = _mm_max_ps(farthest, _mm_max_ps(_mm_loadu_ps(row), _mm_loadu_ps(row + 4)));
+            }
+            farthest = _mm_max_ps(farthest, _mm_movehl_ps(farthest, farthest));
+            farthest = _mm_max_ss(farthest, _mm_shuffle_ps(farthest, farthest, 1));
+            m_BlockDepth[size_t(blockY / BLOCK_SIZE) * blocksPerRow + blockX / BLOCK_SIZE] = _mm_cvtss_f32(farthest);
+        }
+    }
+}
+
+bool OcclusionCuller::IsVisible( const float modelToClip[16], const BoundingBox &box ) const
+{
+    float minX = FLT_MAX;
+    float maxX = -FLT_MAX;
+    float minY = FLT_MAX;
+    float maxY = -FLT_MAX;
+    float nearest = FLT_MAX;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        float clip[4];
+        TransformPoint(modelToClip, corner & 1 ? box.Max[0] : box.Min[0], corner & 2 ? box.Max[1] : box.Min[1],
+                       corner & 4 ? box.Max[2] : box.Min[2], clip);
+        if (!(clip[2] >= 0.0f) || !(clip[3] > 0.0f) || !std::isfinite(clip[0]) || !std::isfinite(clip[1]))
+        {
+            return true;
+        }
+        float inverseW = 1.0f / clip[3];
+        float x = (clip[0] * inverseW * 0.5f + 0.5f) * static_cast<float>(m_Width);
+        float y = (0.5f - clip[1] * inverseW * 0.5f) * static_cast<float>(m_Height);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::min(nearest, clip[2] * inverseW);
+    }
+
+    // Every pixel the box's screen rectangle touches, not just those whose centre it covers.
+    int pixelMinX = static_cast<int>(std::floor(std::max(minX, 0.0f)));
+    int pixelMaxX = static_cast<int>(std::floor(std::min(maxX, static_cast<float>(m_Width) - 1.0f)));
+    int pixelMinY = static_cast<int>(std::floor(std::max(minY, 0.0f)));
+    int pixelMaxY = static_cast<int>(std::floor(std::min(maxY, static_cast<float>(m_Height) - 1.0f)));
+    if (pixelMinX > pixelMaxX || pixelMinY > pixelMaxY)
+    {
+        return true;
+    }
+
+    nearest -= DEPTH_BIAS;
+    uint32_t blocksPerRow = m_Width / BLOCK_SIZE;
+    for (int blockY = pixelMinY / static_cast<int>(BLOCK_SIZE); blockY <= pixelMaxY / static_cast<int>(BLOCK_SIZE);
+         ++blockY)
+    {
+        for (int blockX = pixelMinX / static_cast<int>(BLOCK_SIZE);
+             blockX <= pixelMaxX / static_cast<int>(BLOCK_SIZE); ++blockX)
+        {
+            // The whole block is in front of the box.
+            if (nearest > m_BlockDepth[size_t(blockY) * blocksPerRow + blockX])
+            {
+                continue;
+            }
+            int x0 = std::max(pixelMinX, blockX * static_cast<int>(BLOCK_SIZE));
+            int x1 = std::min(pixelMaxX, (blockX + 1) * static_cast<int>(BLOCK_SIZE) - 1);
+            int y0 = std::max(pixelMinY, blockY * static_cast<int>(BLOCK_SIZE));
+            int y1 = std::min(pixelMaxY, (blockY + 1) * static_cast<int>(BLOCK_SIZE) - 1);
+            for (int y = y0; y <= y1; ++y)
+            {
+                for (int x = x0; x <= x1; ++x)
+                {
+                    if (nearest <= m_Depth[size_t(y) * m_Width + x])
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,118 @@
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Bounds.h"
+
+
+namespace Enterprise::Geometry {
+
+// Triangles of a mesh kept on the CPU to be rasterized as an occluder.
+struct OccluderMesh {
+    // float3 per vertex.
+    std::vector<float>    Positions;
+    std::vector<uint32_t> Indices;
+};
+
+// Meshes with more triangles than this cost more to rasterize as occluders than they usually save.
+constexpr size_t MAX_OCCLUDER_TRIANGLES = 2048;
+
+/**
+ * Copy the triangles of a mesh to rasterize as an occluder. Returns false, leaving occluder as it was, for meshes
+ * with more than MAX_OCCLUDER_TRIANGLES triangles. A mesh only hides what is behind it if it is opaque everywhere,
+ * so the caller leaves out meshes with alpha tested or blended materials.
+ * positions points at the first float3 position, positionStride is the distance between vertices in bytes.
+ */
+bool MakeOccluderMesh( const float* positions, size_t vertexCount, size_t positionStride, const uint32_t* indices,
+                       size_t       indexCount, OccluderMesh* occluder );
+
+/**
+ * Software occlusion culling. A few large occluders are rasterized into a small depth buffer, and the bounds
+ * of other objects are tested against it before they are submitted. Runs entirely on the CPU.
+ *
+ * Triangles are binned into screen tiles and the tiles are rasterized in parallel on the thread pool, four
+ * pixels at a time with SSE, writing only the pixels whose centre is covered. Each tile then records the
+ * farthest depth of every 8x8 block, so a box is usually rejected or accepted from that level alone.
+ *
+ * Matrices are row major with row vectors, as DirectXMath, and project to D3D clip space with depth in [0, 1].
+ */
+class OcclusionCuller {
+public:
+    // Width and height in pixels, rounded up to multiples of eight.
+    explicit OcclusionCuller( uint32_t width = 256, uint32_t height = 128 );
+
+    void Resize( uint32_t width, uint32_t height );
+
+    // Drop the occluders of the previous frame.
+    void Clear();
+
+    /**
+     * Queue the triangles of an occluder, transformed to clip space by modelToClip. Triangles that cross the near
+     * plane are left out, which only makes the culling less aggressive.
+     * positions points at the first float3 position, positionStride is the distance between vertices in bytes.
+     */
+    void AddOccluder( const float    modelToClip[16], const float* positions, size_t vertexCount, size_t positionStride,
+                      const uint32_t* indices, size_t indexCount );
+
+    void AddOccluder( const float modelToClip[16], const OccluderMesh &mesh )
+    {
+        AddOccluder(modelToClip, mesh.Positions.data(), mesh.Positions.size() / 3, 3 * sizeof(float),
+                    mesh.Indices.data(), mesh.Indices.size());
+    }
+
+    /**
+     * Rasterize the queued occluders into the depth buffer, which is cleared first.
+     */
+    void Rasterize( bool parallel = true );
+
+    /**
+     * False when the box, transformed by modelToClip, is behind the occluders at every pixel it covers. Boxes
+     * crossing the near plane or outside the screen count as visible, the frustum test is left to the caller.
+     */
+    [[nodiscard]] bool IsVisible( const float modelToClip[16], const BoundingBox &box ) const;
+
+    [[nodiscard]] uint32_t GetWidth() const { return m_Width; }
+
+    [[nodiscard]] uint32_t GetHeight() const { return m_Height; }
+
+    // Row major, 1 where no occluder was drawn.
+    [[nodiscard]] const std::vector<float> &GetDepth() const { return m_Depth; }
+
+    [[nodiscard]] uint32_t GetNumTriangles() const { return static_cast<uint32_t>(m_Triangles.size()); }
+
+private:
+    // In pixels and depth, counter-clockwise on screen (y down), with the plane of the depth.
+    struct ScreenTriangle {
+        float X[3];
+        float Y[3];
+        float Z0;
+        float DepthDx;
+        float DepthDy;
+        // Pixel bounds, inclusive.
+        int   MinX;
+        int   MinY;
+        int   MaxX;
+        int   MaxY;
+    };
+
+    void RasterizeTile( uint32_t tile );
+
+    uint32_t                             m_Width = 0;
+    uint32_t                             m_Height = 0;
+    uint32_t                             m_TilesX = 0;
+    uint32_t                             m_TilesY = 0;
+    std::vector<float>                   m_Depth;
+    // Farthest depth of every 8x8 block of m_Depth.
+    std::vector<float>                   m_BlockDepth;
+    std::vector<ScreenTriangle>          m_Triangles;
+    // Per tile, the triangles that overlap it.
+    std::vector<std::vector<uint32_t> >  m_TileTriangles;
+    // Clip space vertices of the occluder being added.
+    std::vector<float>                   m_ClipVertices;
+};
+
+}
+
+#endif //OCCLUSIONCULLER_H
@@ -0,0 +1,432 @@
+#include "Simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_set>
+#include <vector>
+
+namespace Enterprise::Geometry {
+
+namespace {
+
+// Symmetric 4x4 matrix of the summed squared distance to a set of planes.
+struct Quadric {
+    double A2 = 0, AB = 0, AC = 0, AD = 0;
+    double B2 = 0, BC = 0, BD = 0;
+    double C2 = 0, CD = 0;
+    double D2 = 0;
+
+    void AddPlane( double a, double b, double c, double d, double weight )
+    {
+        A2 += a * a * weight;
+        AB += a * b * weight;
+        AC += a * c * weight;
+        AD += a * d * weight;
+        B2 += b * b * weight;
+        BC += b * c * weight;
+        BD += b * d * weight;
+        C2 += c * c * weight;
+        CD += c * d * weight;
+        D2 += d * d * weight;
+    }
+
+    Quadric &operator+=( const Quadric &other )
+    {
+        A2 += other.A2;
+        AB += other.AB;
+        AC += other.AC;
+        AD += other.AD;
+        B2 += other.B2;
+        BC += other.BC;
+        BD += other.BD;
+        C2 += other.C2;
+        CD += other.CD;
+        D2 += other.D2;
+        return *this;
+    }
+
+    [[nodiscard]] double Evaluate( const float* p ) const
+    {
+        double x = p[0], y = p[1], z = p[2];
+        double error = A2 * x * x + B2 * y * y + C2 * z * z + D2 +
+                       2.0 * (AB * x * y + AC * x * z + BC * y * z + AD * x + BD * y + CD * z);
+        return std::max(error, 0.0);
+    }
+};
+
+enum class VertexKind : uint8_t {
+    // Every edge has a matching opposite edge, can collapse onto any neighbour.
+    Manifold,
+    // On an open border, can only slide along the border.
+    Border,
+    // Attribute seams and complex border configurations never move.
+    Locked,
+};
+
+// Open borders get a plane perpendicular to the surface so collapses do not pull them inwards.
+constexpr double BORDER_WEIGHT = 10.0;
+
+// A collapse may not rotate any remaining triangle by more than 90 degrees.
+constexpr float FLIP_THRESHOLD = 0.0f;
+
+const float* Position( const float* positions, size_t stride, uint32_t vertex )
+{
+    return reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(positions) + vertex * stride);
+}
+
+void Cross( const float* p0, const float* p1, const float* p2, float n[3] )
+{
+    float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+uint64_t EdgeKey( uint32_t a, uint32_t b )
+{
+    return (uint64_t(a) << 32) | b;
+}
+
+// Map every vertex to the first vertex with bitwise identical position, so vertices split for
+// normals or uvs are recognised as one point of the surface.
+std::vector<uint32_t> BuildPositionRemap( const float* positions, size_t vertexCount, size_t stride )
+{
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0);
+
+    auto key = [&]( uint32_t vertex, uint32_t k )
+    {
+        uint32_t bits;
+        std::memcpy(&bits, Position(positions, stride, vertex) + k, sizeof(bits));
+        return bits;
+    };
+    auto less = [&]( uint32_t a, uint32_t b )
+    {
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            if (key(a, k) != key(b, k))
+            {
+                return key(a, k) < key(b, k);
+            }
+        }
+        return a < b;
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    std::vector<uint32_t> remap(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        uint32_t vertex = order[i];
+        bool     sameAsPrevious = i > 0 && key(vertex, 0) == key(order[i - 1], 0) &&
+                                  key(vertex, 1) == key(order[i - 1], 1) && key(vertex, 2) == key(order[i - 1], 2);
+        remap[vertex] = sameAsPrevious ? remap[order[i - 1]] : vertex;
+    }
+    return remap;
+}
+
+}
+
+float GetMeshScale( const float* positions, size_t vertexCount, size_t positionStride )
+{
+    if (vertexCount == 0)
+    {
+        return 0.0f;
+    }
+
+    float minimum[3] = {INFINITY, INFINITY, INFINITY};
+    float maximum[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const float* p = Position(positions, positionStride, static_cast<uint32_t>(i));
+        for (int k = 0; k < 3; ++k)
+        {
+            minimum[k] = std::min(minimum[k], p[k]);
+            maximum[k] = std::max(maximum[k], p[k]);
+        }
+    }
+    return std::max({maximum[0] - minimum[0], maximum[1] - minimum[1], maximum[2] - minimum[2]});
+}
+
+size_t SimplifyMesh( uint32_t*    destination, const uint32_t* indices, size_t indexCount, const float* positions,
+                     size_t       vertexCount, size_t positionStride, size_t targetIndexCount, float targetError,
+                     float*       resultError )
+{
+    std::vector<uint32_t> current(indices, indices + indexCount);
+    const float           scale = GetMeshScale(positions, vertexCount, positionStride);
+    const double          maxCost = double(targetError) * scale * double(targetError) * scale;
+    double                error = 0.0;
+
+    const std::vector<uint32_t> positionRemap = BuildPositionRemap(positions, vertexCount, positionStride);
+    auto                        point = [&]( uint32_t vertex ) { return Position(positions, positionStride, vertex); };
+
+    // Classify the vertices from the welded edges.
+    std::unordered_set<uint64_t> edges;
+    edges.reserve(indexCount);
+    for (size_t i = 0; i < indexCount; i += 3)
+    {
+        for (int e = 0; e < 3; ++e)
+        {
+            edges.insert(EdgeKey(positionRemap[indices[i + e]], positionRemap[indices[i + (e + 1) % 3]]));
+        }
+    }
+
+    std::vector<uint32_t> wedges(vertexCount, 0);
+    std::vector<uint8_t>  openEdgesOut(vertexCount, 0);
+    std::vector<uint8_t>  openEdgesIn(vertexCount, 0);
+    std::vector<Quadric>  quadrics(vertexCount);
+    {
+        std::vector<bool> referenced(vertexCount, false);
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            if (!referenced[indices[i]])
+            {
+                referenced[indices[i]] = true;
+                wedges[positionRemap[indices[i]]]++;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < indexCount; i += 3)
+    {
+        const float* p[3] = {point(indices[i]), point(indices[i + 1]), point(indices[i + 2])};
+        float        n[3];
+        Cross(p[0], p[1], p[2], n);
+        double length = std::sqrt(double(n[0]) * n[0] + double(n[1]) * n[1] + double(n[2]) * n[2]);
+        if (length == 0.0)
+        {
+            continue;
+        }
+        double a = n[0] / length, b = n[1] / length, c = n[2] / length;
+        double d = -(a * p[0][0] + b * p[0][1] + c * p[0][2]);
+
+        for (int e = 0; e < 3; ++e)
+        {
+            uint32_t from = positionRemap[indices[i + e]];
+            uint32_t to = positionRemap[indices[i + (e + 1) % 3]];
+            quadrics[from].AddPlane(a, b, c, d, 1.0);
+
+            if (edges.count(EdgeKey(to, from)) == 0)
+            {
+                openEdgesOut[from] = uint8_t(std::min(openEdgesOut[from] + 1, 255));
+                openEdgesIn[to] = uint8_t(std::min(openEdgesIn[to] + 1, 255));
+
+                // Plane through the open edge, perpendicular to the triangle.
+                const float* p0 = p[e];
+                const float* p1 = p[(e + 1) % 3];
+                double       edge[3] = {double(p1[0]) - p0[0], double(p1[1]) - p0[1], double(p1[2]) - p0[2]};
+                double       bn[3] = {edge[1] * c - edge[2] * b, edge[2] * a - edge[0] * c, edge[0] * b - edge[1] * a};
+                double       bl = std::sqrt(bn[0] * bn[0] + bn[1] * bn[1] + bn[2] * bn[2]);
+                if (bl > 0.0)
+                {
+                    double bd = -(bn[0] * p0[0] + bn[1] * p0[1] + bn[2] * p0[2]) / bl;
+                    quadrics[from].AddPlane(bn[0] / bl, bn[1] / bl, bn[2] / bl, bd, BORDER_WEIGHT);
+                    quadrics[to].AddPlane(bn[0] / bl, bn[1] / bl, bn[2] / bl, bd, BORDER_WEIGHT);
+                }
+            }
+        }
+    }
+
+    std::vector<VertexKind> kinds(vertexCount, VertexKind::Manifold);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        uint32_t welded = positionRemap[v];
+        if (wedges[welded] > 1)
+        {
+            kinds[v] = VertexKind::Locked;
+        } else if (openEdgesOut[welded] != 0 || openEdgesIn[welded] != 0)
+        {
+            kinds[v] = openEdgesOut[welded] == 1 && openEdgesIn[welded] == 1 ? VertexKind::Border : VertexKind::Locked;
+        }
+    }
+
+    auto canCollapse = [&]( uint32_t from, uint32_t to )
+    {
+        switch (kinds[from])
+        {
+            case VertexKind::Manifold:
+                return true;
+            case VertexKind::Border:
+                return kinds[to] != VertexKind::Manifold &&
+                       (edges.count(EdgeKey(positionRemap[from], positionRemap[to])) == 0 ||
+                        edges.count(EdgeKey(positionRemap[to], positionRemap[from])) == 0);
+            default:
+                return false;
+        }
+    };
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<uint32_t> bestTarget(vertexCount);
+    std::vector<double>   bestCost(vertexCount);
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool>     touched(vertexCount);
+    std::vector<uint32_t> candidates;
+
+    // Each pass applies the cheapest independent collapses, then rebuilds the index buffer.
+    while (current.size() > targetIndexCount)
+    {
+        // Triangles around each vertex.
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t index: current)
+        {
+            adjacencyOffsets[index + 1]++;
+        }
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        adjacency.resize(current.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < current.size(); ++i)
+            {
+                adjacency[fill[current[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        // Cheapest collapse out of every vertex.
+        std::fill(bestTarget.begin(), bestTarget.end(), ~0u);
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            for (int e = 0; e < 3; ++e)
+            {
+                uint32_t a = current[i + e];
+                uint32_t b = current[i + (e + 1) % 3];
+                for (auto [from, to]: {std::pair{a, b}, std::pair{b, a}})
+                {
+                    if (!canCollapse(from, to))
+                    {
+                        continue;
+                    }
+                    Quadric combined = quadrics[positionRemap[from]];
+                    combined += quadrics[positionRemap[to]];
+                    double cost = combined.Evaluate(point(to));
+                    if (bestTarget[from] == ~0u || cost < bestCost[from])
+                    {
+                        bestTarget[from] = to;
+                        bestCost[from] = cost;
+                    }
+                }
+            }
+        }
+
+        candidates.clear();
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            if (bestTarget[v] != ~0u && bestCost[v] <= maxCost)
+            {
+                candidates.push_back(v);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [&]( uint32_t a, uint32_t b ) { return bestCost[a] < bestCost[b]; });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), false);
+        size_t triangleCount = current.size() / 3;
+        size_t collapses = 0;
+
+        for (uint32_t from: candidates)
+        {
+            if (triangleCount * 3 <= targetIndexCount)
+            {
+                break;
+            }
+
+            uint32_t to = bestTarget[from];
+            if (touched[from] || touched[to])
+            {
+                continue;
+            }
+
+            // Reject collapses that flip a triangle, and count the triangles that disappear.
+            const uint32_t* begin = adjacency.data() + adjacencyOffsets[from];
+            const uint32_t* end = adjacency.data() + adjacencyOffsets[from + 1];
+            bool            flips = false;
+            size_t          removed = 0;
+            for (const uint32_t* t = begin; t != end && !flips; ++t)
+            {
+                const uint32_t* triangle = current.data() + *t * 3;
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                {
+                    removed++;
+                    continue;
+                }
+
+                const float* before[3] = {point(triangle[0]), point(triangle[1]), point(triangle[2])};
+                const float* after[3] = {before[0], before[1], before[2]};
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (triangle[k] == from)
+                    {
+                        after[k] = point(to);
+                    }
+                }
+                float n0[3], n1[3];
+                Cross(before[0], before[1], before[2], n0);
+                Cross(after[0], after[1], after[2], n1);
+                flips = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= FLIP_THRESHOLD;
+            }
+            if (flips)
+            {
+                continue;
+            }
+
+            remap[from] = to;
+            quadrics[positionRemap[to]] += quadrics[positionRemap[from]];
+            error = std::max(error, bestCost[from]);
+            triangleCount -= removed;
+            collapses++;
+
+            // Freeze the one ring for the rest of the pass so the flip test above stays valid.
+            for (const uint32_t* t = begin; t != end; ++t)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    touched[current[*t * 3 + k]] = true;
+                }
+            }
+        }
+
+        if (collapses == 0)
+        {
+            break;
+        }
+
+        size_t output = 0;
+        for (size_t i = 0; i < current.size(); i += 3)
+        {
+            uint32_t a = remap[current[i]];
+            uint32_t b = remap[current[i + 1]];
+            uint32_t c = remap[current[i + 2]];
+            if (a != b && b != c && c != a)
+            {
+                current[output++] = a;
+                current[output++] = b;
+                current[output++] = c;
+            }
+        }
+        current.resize(output);
+    }
+
+    std::copy(current.begin(), current.end(), destination);
+    if (resultError)
+    {
+        *resultError = scale > 0.0f ? float(std::sqrt(error)) / scale : 0.0f;
+    }
+    return current.size();
+}
+
+uint32_t SelectLod( const MeshLod* lods, uint32_t numLods, float pixelsPerUnit, float maxPixelError )
+{
+    for (uint32_t lod = numLods; lod > 1; --lod)
+    {
+        if (lods[lod - 1].Error * pixelsPerUnit <= maxPixelError)
+        {
+            return lod - 1;
+        }
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,44 @@
+#ifndef SIMPLIFIER_H
+#define SIMPLIFIER_H
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Enterprise::Geometry {
+
+/**
+ * Reduce a triangle list by quadric error edge collapses until it has at most targetIndexCount indices,
+ * or until the next collapse would move the surface by more than targetError.
+ * Vertices only ever collapse onto other existing vertices, so the result indexes the same vertex buffer.
+ * Open borders only slide along themselves and vertices on attribute seams are kept in place.
+ * targetError and resultError are relative to the largest extent of the mesh bounds.
+ * destination may alias indices. Returns the number of indices written.
+ */
+size_t SimplifyMesh( uint32_t*    destination, const uint32_t* indices, size_t indexCount, const float* positions,
+                     size_t       vertexCount, size_t positionStride, size_t targetIndexCount, float targetError,
+                     float*       resultError = nullptr );
+
+/**
+ * Largest extent of the bounds of the vertices, the scale simplification errors are relative to.
+ */
+float GetMeshScale( const float* positions, size_t vertexCount, size_t positionStride );
+
+// A level of detail as a range of the mesh's index buffer, which all levels share with the vertex buffer.
+struct MeshLod {
+    uint32_t FirstIndex;
+    uint32_t NumIndices;
+    // Largest deviation from the full detail mesh, in model units.
+    float    Error;
+    uint32_t Reserved;
+};
+static_assert(sizeof(MeshLod) == 16);
+
+/**
+ * Pick the coarsest level whose error covers at most maxPixelError pixels on screen.
+ * pixelsPerUnit is the projected size of one model unit at the mesh's distance from the camera.
+ */
+uint32_t SelectLod( const MeshLod* lods, uint32_t numLods, float pixelsPerUnit, float maxPixelError );
+
+}
+
+#endif //SIMPLIFIER_H
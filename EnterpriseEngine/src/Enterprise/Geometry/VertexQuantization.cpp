@@ -0,0 +1,390 @@
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace Enterprise::Geometry {
+
+namespace {
+
+const float* Element( const float* base, size_t stride, size_t index )
+{
+    return reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(base) + index * stride);
+}
+
+template<typename T>
+T* Element( T* base, size_t stride, size_t index )
+{
+    return reinterpret_cast<T *>(reinterpret_cast<uint8_t *>(base) + index * stride);
+}
+
+// Gather one component of four strided vertices. Lanes past count repeat the last vertex.
+__m128 Gather4( const float* base, size_t stride, size_t first, size_t count, int component )
+{
+    size_t last = count - 1;
+    return _mm_setr_ps(Element(base, stride, std::min(first + 0, last))[component],
+                       Element(base, stride, std::min(first + 1, last))[component],
+                       Element(base, stride, std::min(first + 2, last))[component],
+                       Element(base, stride, std::min(first + 3, last))[component]);
+}
+
+__m128 Abs( __m128 v )
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+// +1 or -1 with the sign of v; zero counts as positive.
+__m128 SignNotZero( __m128 v )
+{
+    return _mm_or_ps(_mm_and_ps(v, _mm_set1_ps(-0.0f)), _mm_set1_ps(1.0f));
+}
+
+__m128 Select( __m128 mask, __m128 a, __m128 b )
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Round to nearest even float to half conversion with SSE2 only. Handles denormals, infinity and NaN.
+// Based on the branchless conversion by Fabian Giesen. The result is sign extended in each 32-bit lane.
+__m128i FloatToHalf4( __m128 f )
+{
+    const __m128i signMask = _mm_set1_epi32(int32_t(0x80000000u));
+    const __m128i halfMax = _mm_set1_epi32((127 + 16) << 23);
+    const __m128i nanBit = _mm_set1_epi32(0x200);
+    const __m128i infinity = _mm_set1_epi32(0x7c00);
+    const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+    const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i normalBias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+    __m128  sign = _mm_and_ps(_mm_castsi128_ps(signMask), f);
+    __m128  absF = _mm_xor_ps(f, sign);
+    __m128i absI = _mm_castps_si128(absF);
+
+    __m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absF, absF));
+    __m128i isRegular = _mm_cmpgt_epi32(halfMax, absI);
+    __m128i infOrNaN = _mm_or_si128(_mm_and_si128(isNaN, nanBit), infinity);
+    __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absI);
+
+    // Subnormal results: let the float adder do the rounding.
+    __m128  subnormalSum = _mm_add_ps(absF, _mm_castsi128_ps(subnormalMagic));
+    __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(subnormalSum), subnormalMagic);
+
+    // Normal results: rebias the exponent and round the mantissa to nearest even.
+    __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absI, 31 - 13), 31);
+    __m128i rounded = _mm_sub_epi32(_mm_add_epi32(absI, normalBias), mantissaOdd);
+    __m128i normal = _mm_srli_epi32(rounded, 13);
+
+    __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    __m128i result = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, infOrNaN));
+    result = _mm_or_si128(result, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+
+    // Sign extend from 16 bits so _mm_packs_epi32 keeps the bit pattern.
+    return _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+}
+
+// Store the low 16 bits of each lane to four strided destinations.
+template<typename T>
+void Scatter4( T* destination, size_t destinationStride, size_t first, size_t count, int component, __m128i packed )
+{
+    alignas(16) int16_t lanes[8];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), packed);
+    for (size_t lane = 0; lane < 4 && first + lane < count; ++lane)
+    {
+        Element(destination, destinationStride, first + lane)[component] = static_cast<T>(lanes[lane]);
+    }
+}
+
+float Length3( const float* v )
+{
+    return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+}
+
+void VertexQuantizationError::Merge( const VertexQuantizationError &other )
+{
+    MaxPositionError = std::max(MaxPositionError, other.MaxPositionError);
+    MaxNormalError = std::max(MaxNormalError, other.MaxNormalError);
+    MaxTexCoordError = std::max(MaxTexCoordError, other.MaxTexCoordError);
+}
+
+size_t GetVertexFormatStride( VertexFormat format )
+{
+    switch (format)
+    {
+        case VertexFormat::Float:
+            return sizeof(float) * 8;
+        case VertexFormat::PackedNormalTexCoord:
+            return sizeof(PackedVertex);
+        case VertexFormat::Quantized:
+            return sizeof(QuantizedVertex);
+        default:
+            return 0;
+    }
+}
+
+VertexQuantizationParams ComputeQuantizationParams( const float* positions, size_t stride, size_t count )
+{
+    VertexQuantizationParams params;
+    if (count == 0)
+    {
+        return params;
+    }
+
+    __m128 minimum = _mm_set1_ps(INFINITY);
+    __m128 maximum = _mm_set1_ps(-INFINITY);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float* p = Element(positions, stride, i);
+        __m128       position = _mm_setr_ps(p[0], p[1], p[2], 0.0f);
+        minimum = _mm_min_ps(minimum, position);
+        maximum = _mm_max_ps(maximum, position);
+    }
+
+    alignas(16) float minimumLanes[4];
+    alignas(16) float extentLanes[4];
+    _mm_store_ps(minimumLanes, minimum);
+    _mm_store_ps(extentLanes, _mm_sub_ps(maximum, minimum));
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        params.PositionOffset[axis] = minimumLanes[axis];
+        params.PositionScale[axis] = extentLanes[axis];
+    }
+    return params;
+}
+
+void EncodeOctahedralNormals( int16_t* destination, size_t destinationStride, const float* normals, size_t stride,
+                              size_t   count )
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 snormScale = _mm_set1_ps(32767.0f);
+    for (size_t i = 0; i < count; i += 4)
+    {
+        __m128 x = Gather4(normals, stride, i, count, 0);
+        __m128 y = Gather4(normals, stride, i, count, 1);
+        __m128 z = Gather4(normals, stride, i, count, 2);
+
+        // Project onto the octahedron |x| + |y| + |z| = 1. Zero length normals map to the +z pole.
+        __m128 l1 = _mm_add_ps(_mm_add_ps(Abs(x), Abs(y)), Abs(z));
+        __m128 valid = _mm_cmpgt_ps(l1, _mm_setzero_ps());
+        __m128 inverse = _mm_and_ps(valid, _mm_div_ps(one, _mm_max_ps(l1, _mm_set1_ps(1e-30f))));
+        x = _mm_mul_ps(x, inverse);
+        y = _mm_mul_ps(y, inverse);
+
+        // Fold the lower hemisphere over the diagonals.
+        __m128 lower = _mm_cmplt_ps(z, _mm_setzero_ps());
+        __m128 foldedX = _mm_mul_ps(_mm_sub_ps(one, Abs(y)), SignNotZero(x));
+        __m128 foldedY = _mm_mul_ps(_mm_sub_ps(one, Abs(x)), SignNotZero(y));
+        x = Select(lower, foldedX, x);
+        y = Select(lower, foldedY, y);
+
+        __m128i encodedX = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-1.0f)), one), snormScale));
+        __m128i encodedY = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(y, _mm_set1_ps(-1.0f)), one), snormScale));
+        __m128i packed = _mm_packs_epi32(encodedX, encodedY);
+
+        Scatter4(destination, destinationStride, i, count, 0, packed);
+        Scatter4(destination, destinationStride, i, count, 1, _mm_srli_si128(packed, 8));
+    }
+}
+
+void EncodeHalf2( uint16_t* destination, size_t destinationStride, const float* values, size_t stride,
+                  size_t    count )
+{
+    for (size_t i = 0; i < count; i += 4)
+    {
+        __m128i u = FloatToHalf4(Gather4(values, stride, i, count, 0));
+        __m128i v = FloatToHalf4(Gather4(values, stride, i, count, 1));
+        __m128i packed = _mm_packs_epi32(u, v);
+
+        Scatter4(destination, destinationStride, i, count, 0, packed);
+        Scatter4(destination, destinationStride, i, count, 1, _mm_srli_si128(packed, 8));
+    }
+}
+
+void QuantizePositions( uint16_t*   destination, size_t destinationStride, const float* positions, size_t stride,
+                        size_t      count, const VertexQuantizationParams &params )
+{
+    const __m128  zero = _mm_setzero_ps();
+    const __m128  unormMax = _mm_set1_ps(65535.0f);
+    // _mm_packs_epi32 saturates to int16, so bias into the signed range and flip the top bit back after packing.
+    const __m128i bias = _mm_set1_epi32(32768);
+    const __m128i flip = _mm_set1_epi16(int16_t(0x8000));
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float  extent = params.PositionScale[axis];
+        __m128 offset = _mm_set1_ps(params.PositionOffset[axis]);
+        __m128 scale = _mm_set1_ps(extent > 0.0f ? 65535.0f / extent : 0.0f);
+        for (size_t i = 0; i < count; i += 4)
+        {
+            __m128 p = Gather4(positions, stride, i, count, axis);
+            __m128 unorm = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(p, offset), scale), zero), unormMax);
+
+            __m128i biased = _mm_sub_epi32(_mm_cvtps_epi32(unorm), bias);
+            __m128i packed = _mm_xor_si128(_mm_packs_epi32(biased, biased), flip);
+            Scatter4(destination, destinationStride, i, count, axis, packed);
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        Element(destination, destinationStride, i)[3] = 0;
+    }
+}
+
+void DecodeOctahedralNormal( const int16_t encoded[2], float normal[3] )
+{
+    float x = std::max(float(encoded[0]) / 32767.0f, -1.0f);
+    float y = std::max(float(encoded[1]) / 32767.0f, -1.0f);
+    float z = 1.0f - std::fabs(x) - std::fabs(y);
+    if (z < 0.0f)
+    {
+        float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    float length = std::sqrt(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+float HalfToFloat( uint16_t value )
+{
+    uint32_t sign = uint32_t(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+
+    float result;
+    if (exponent == 0)
+    {
+        result = std::ldexp(float(mantissa), -24);
+    } else if (exponent == 31)
+    {
+        result = mantissa ? NAN : INFINITY;
+    } else
+    {
+        result = std::ldexp(float(mantissa | 0x400), int(exponent) - 25);
+    }
+    return sign ? -result : result;
+}
+
+void EncodeVertices( VertexFormat format, void* destination, const VertexStreamDesc &source,
+                     const VertexQuantizationParams &params )
+{
+    const size_t count = source.NumVertices;
+    switch (format)
+    {
+        case VertexFormat::Float:
+        {
+            auto vertices = static_cast<float *>(destination);
+            for (size_t i = 0; i < count; ++i)
+            {
+                std::memcpy(vertices + i * 8 + 0, Element(source.Positions, source.Stride, i), sizeof(float) * 3);
+                std::memcpy(vertices + i * 8 + 3, Element(source.Normals, source.Stride, i), sizeof(float) * 3);
+                std::memcpy(vertices + i * 8 + 6, Element(source.TexCoords, source.Stride, i), sizeof(float) * 2);
+            }
+            break;
+        }
+        case VertexFormat::PackedNormalTexCoord:
+        {
+            auto vertices = static_cast<PackedVertex *>(destination);
+            for (size_t i = 0; i < count; ++i)
+            {
+                std::memcpy(vertices[i].Position, Element(source.Positions, source.Stride, i), sizeof(float) * 3);
+            }
+            EncodeOctahedralNormals(vertices->Normal, sizeof(PackedVertex), source.Normals, source.Stride, count);
+            EncodeHalf2(vertices->TexCoord, sizeof(PackedVertex), source.TexCoords, source.Stride, count);
+            break;
+        }
+        case VertexFormat::Quantized:
+        {
+            auto vertices = static_cast<QuantizedVertex *>(destination);
+            QuantizePositions(vertices->Position, sizeof(QuantizedVertex), source.Positions, source.Stride, count,
+                              params);
+            EncodeOctahedralNormals(vertices->Normal, sizeof(QuantizedVertex), source.Normals, source.Stride, count);
+            EncodeHalf2(vertices->TexCoord, sizeof(QuantizedVertex), source.TexCoords, source.Stride, count);
+            break;
+        }
+        default:
+            assert(false && "Unknown vertex format");
+            break;
+    }
+}
+
+VertexQuantizationError MeasureQuantizationError( VertexFormat format, const void* encoded,
+                                                  const VertexStreamDesc &source,
+                                                  const VertexQuantizationParams &params )
+{
+    VertexQuantizationError error;
+    if (format == VertexFormat::Float)
+    {
+        return error;
+    }
+
+    const size_t stride = GetVertexFormatStride(format);
+    auto         bytes = static_cast<const uint8_t *>(encoded);
+    for (size_t i = 0; i < source.NumVertices; ++i)
+    {
+        const uint8_t* vertex = bytes + i * stride;
+        const int16_t* normal;
+        const uint16_t* texCoord;
+        float          position[3];
+        if (format == VertexFormat::Quantized)
+        {
+            auto quantized = reinterpret_cast<const QuantizedVertex *>(vertex);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                position[axis] = float(quantized->Position[axis]) / 65535.0f * params.PositionScale[axis] +
+                                 params.PositionOffset[axis];
+            }
+            normal = quantized->Normal;
+            texCoord = quantized->TexCoord;
+        } else
+        {
+            auto packed = reinterpret_cast<const PackedVertex *>(vertex);
+            std::memcpy(position, packed->Position, sizeof(position));
+            normal = packed->Normal;
+            texCoord = packed->TexCoord;
+        }
+
+        const float* sourcePosition = Element(source.Positions, source.Stride, i);
+        const float* sourceNormal = Element(source.Normals, source.Stride, i);
+        const float* sourceTexCoord = Element(source.TexCoords, source.Stride, i);
+
+        float delta[3] = {
+            position[0] - sourcePosition[0], position[1] - sourcePosition[1], position[2] - sourcePosition[2]
+        };
+        error.MaxPositionError = std::max(error.MaxPositionError, Length3(delta));
+
+        if (Length3(sourceNormal) > 0.0f)
+        {
+            float decoded[3];
+            DecodeOctahedralNormal(normal, decoded);
+            // atan2 of |cross| and dot stays accurate for the tiny angles we expect, acos does not.
+            float cross[3] = {
+                decoded[1] * sourceNormal[2] - decoded[2] * sourceNormal[1],
+                decoded[2] * sourceNormal[0] - decoded[0] * sourceNormal[2],
+                decoded[0] * sourceNormal[1] - decoded[1] * sourceNormal[0]
+            };
+            float dot = decoded[0] * sourceNormal[0] + decoded[1] * sourceNormal[1] + decoded[2] * sourceNormal[2];
+            float degrees = std::atan2(Length3(cross), dot) * (180.0f / 3.14159265f);
+            error.MaxNormalError = std::max(error.MaxNormalError, degrees);
+        }
+
+        for (int component = 0; component < 2; ++component)
+        {
+            float texCoordError = std::fabs(HalfToFloat(texCoord[component]) - sourceTexCoord[component]);
+            error.MaxTexCoordError = std::max(error.MaxTexCoordError, texCoordError);
+        }
+    }
+
+    return error;
+}
+
+}
@@ -0,0 +1,102 @@
+#ifndef VERTEXQUANTIZATION_H
+#define VERTEXQUANTIZATION_H
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Enterprise::Geometry {
+
+enum class VertexFormat : uint32_t {
+    // float3 position, float3 normal, float2 uv. Same layout as VertexPosNormalTexture, 32 bytes.
+    Float = 0,
+    // float3 position, octahedral snorm16x2 normal, half2 uv, 20 bytes.
+    PackedNormalTexCoord,
+    // unorm16x4 position relative to the mesh bounds, octahedral snorm16x2 normal, half2 uv, 16 bytes.
+    Quantized,
+
+    NumFormats
+};
+
+struct PackedVertex {
+    float    Position[3];
+    int16_t  Normal[2];
+    uint16_t TexCoord[2];
+};
+static_assert(sizeof(PackedVertex) == 20);
+
+struct QuantizedVertex {
+    // w is padding so the position can be fetched as R16G16B16A16_UNORM.
+    uint16_t Position[4];
+    int16_t  Normal[2];
+    uint16_t TexCoord[2];
+};
+static_assert(sizeof(QuantizedVertex) == 16);
+
+// Quantized positions decode as position = unorm * PositionScale + PositionOffset.
+// The layout matches the dequantization root constants in VertexShaderPacked.hlsl.
+struct VertexQuantizationParams {
+    float PositionScale[3] = {1.0f, 1.0f, 1.0f};
+    float Padding0 = 0.0f;
+    float PositionOffset[3] = {0.0f, 0.0f, 0.0f};
+    float Padding1 = 0.0f;
+};
+
+// Largest error seen over a vertex stream. Normal error is the angle in degrees.
+struct VertexQuantizationError {
+    float MaxPositionError = 0.0f;
+    float MaxNormalError = 0.0f;
+    float MaxTexCoordError = 0.0f;
+
+    void Merge( const VertexQuantizationError &other );
+};
+
+// Interleaved float vertex stream; every attribute advances by Stride bytes.
+struct VertexStreamDesc {
+    const float* Positions = nullptr;
+    const float* Normals = nullptr;
+    const float* TexCoords = nullptr;
+    size_t       Stride = 0;
+    size_t       NumVertices = 0;
+};
+
+size_t GetVertexFormatStride( VertexFormat format );
+
+/**
+ * Compute the scale and offset that map the bounds of the positions onto [0, 1].
+ */
+VertexQuantizationParams ComputeQuantizationParams( const float* positions, size_t stride, size_t count );
+
+/**
+ * The encode kernels below process four vertices at a time with SSE2.
+ * Source and destination are strided so they can read and write interleaved vertices directly.
+ */
+void EncodeOctahedralNormals( int16_t* destination, size_t destinationStride, const float* normals, size_t stride,
+                              size_t   count );
+
+void EncodeHalf2( uint16_t* destination, size_t destinationStride, const float* values, size_t stride,
+                  size_t    count );
+
+void QuantizePositions( uint16_t*   destination, size_t destinationStride, const float* positions, size_t stride,
+                        size_t      count, const VertexQuantizationParams &params );
+
+void DecodeOctahedralNormal( const int16_t encoded[2], float normal[3] );
+
+float HalfToFloat( uint16_t value );
+
+/**
+ * Encode a float vertex stream into format. destination must hold
+ * GetVertexFormatStride(format) * NumVertices bytes.
+ */
+void EncodeVertices( VertexFormat format, void* destination, const VertexStreamDesc &source,
+                     const VertexQuantizationParams &params );
+
+/**
+ * Decode an encoded stream and compare it against the source it was encoded from.
+ */
+VertexQuantizationError MeasureQuantizationError( VertexFormat format, const void* encoded,
+                                                  const VertexStreamDesc &source,
+                                                  const VertexQuantizationParams &params );
+
+}
+
+#endif //VERTEXQUANTIZATION_H
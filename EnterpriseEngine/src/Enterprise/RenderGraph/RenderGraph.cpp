@@ -0,0 +1,276 @@
+#include "RenderGraph.h"
+
+#include <cassert>
+
+namespace Enterprise::RenderGraph {
+
+namespace {
+
+constexpr uint32_t WRITE_STATES = static_cast<uint32_t>(ResourceState::RenderTarget) |
+                                  static_cast<uint32_t>(ResourceState::UnorderedAccess) |
+                                  static_cast<uint32_t>(ResourceState::DepthWrite) |
+                                  static_cast<uint32_t>(ResourceState::CopyDest) |
+                                  static_cast<uint32_t>(ResourceState::ResolveDest);
+
+// True when a resource in state can already be read in readState.
+bool IsReadableIn( ResourceState state, ResourceState readState )
+{
+    return IsReadState(state) &&
+           (static_cast<uint32_t>(state) & static_cast<uint32_t>(readState)) == static_cast<uint32_t>(readState);
+}
+
+}
+
+bool IsReadState( ResourceState state )
+{
+    return state != ResourceState::Common && state != ResourceState::Unknown &&
+           (static_cast<uint32_t>(state) & WRITE_STATES) == 0;
+}
+
+PassBuilder &PassBuilder::Read( ResourceHandle resource, ResourceState state )
+{
+    assert(IsReadState(state));
+    m_Graph->AddAccess(m_Pass, resource, state, false);
+    return *this;
+}
+
+PassBuilder &PassBuilder::Write( ResourceHandle resource, ResourceState state )
+{
+    assert(state != ResourceState::Unknown && state != ResourceState::Common && !IsReadState(state));
+    m_Graph->AddAccess(m_Pass, resource, state, true);
+    return *this;
+}
+
+PassBuilder &PassBuilder::SetSideEffects()
+{
+    m_Graph->m_Passes[m_Pass].SideEffects = true;
+    return *this;
+}
+
+void RenderGraph::Reset()
+{
+    m_Passes.clear();
+    m_Resources.clear();
+    m_Schedule.clear();
+    m_Barriers.clear();
+    m_FinalBarriers.clear();
+    m_Lifetimes.clear();
+}
+
+ResourceHandle RenderGraph::ImportResource( const std::string &name, ResourceState state )
+{
+    Resource resource;
+    resource.Name = name;
+    resource.Imported = true;
+    resource.InitialState = state;
+    m_Resources.push_back(resource);
+    return static_cast<ResourceHandle>(m_Resources.size() - 1);
+}
+
+ResourceHandle RenderGraph::CreateTexture( const std::string &name, const TextureDesc &desc )
+{
+    // Created in the common state when the graph runs.
+    Resource resource;
+    resource.Name = name;
+    resource.Desc = desc;
+    resource.InitialState = ResourceState::Common;
+    m_Resources.push_back(resource);
+    return static_cast<ResourceHandle>(m_Resources.size() - 1);
+}
+
+void RenderGraph::ExportResource( ResourceHandle resource, ResourceState finalState )
+{
+    m_Resources[resource].Exported = true;
+    m_Resources[resource].FinalState = finalState;
+}
+
+PassBuilder RenderGraph::AddPass( const std::string &name )
+{
+    Pass pass;
+    pass.Name = name;
+    m_Passes.push_back(pass);
+    return PassBuilder(this, static_cast<uint32_t>(m_Passes.size() - 1));
+}
+
+void RenderGraph::AddAccess( uint32_t pass, ResourceHandle resource, ResourceState state, bool write )
+{
+    // A pass uses every resource once, in the union of the read states or in one write state.
+    for (auto &access: m_Passes[pass].Accesses)
+    {
+        if (access.Resource == resource)
+        {
+            assert((!access.Write && !write) || access.State == state);
+            access.State = write ? state : access.State | state;
+            access.Write = access.Write || write;
+            return;
+        }
+    }
+    m_Passes[pass].Accesses.push_back({resource, state, write});
+}
+
+bool RenderGraph::Compile()
+{
+    auto numPasses = static_cast<uint32_t>(m_Passes.size());
+    auto numResources = static_cast<uint32_t>(m_Resources.size());
+    m_Schedule.clear();
+    m_Barriers.clear();
+    m_FinalBarriers.clear();
+    m_Lifetimes.assign(numResources, ResourceLifetime());
+
+    // Every pass depends on the last pass before it that wrote each resource it uses, so dependencies always point
+    // back in the order passes were added.
+    std::vector<uint32_t> lastWriters(numResources, INVALID_PASS);
+    std::vector<uint32_t> dependencies;
+    std::vector<uint32_t> dependencyStarts(numPasses + 1);
+    for (uint32_t pass = 0; pass < numPasses; ++pass)
+    {
+        dependencyStarts[pass] = static_cast<uint32_t>(dependencies.size());
+        for (const auto &access: m_Passes[pass].Accesses)
+        {
+            uint32_t writer = lastWriters[access.Resource];
+            if (writer != INVALID_PASS)
+            {
+                dependencies.push_back(writer);
+            } else if (!access.Write && !m_Resources[access.Resource].Imported)
+            {
+                return false;
+            }
+        }
+        for (const auto &access: m_Passes[pass].Accesses)
+        {
+            if (access.Write)
+            {
+                lastWriters[access.Resource] = pass;
+            }
+        }
+    }
+    dependencyStarts[numPasses] = static_cast<uint32_t>(dependencies.size());
+
+    // Keep what exported resources end up with and passes with side effects, then everything they depend on.
+    std::vector<uint8_t> needed(numPasses, 0);
+    for (uint32_t pass = 0; pass < numPasses; ++pass)
+    {
+        needed[pass] = m_Passes[pass].SideEffects;
+    }
+    for (uint32_t resource = 0; resource < numResources; ++resource)
+    {
+        if (m_Resources[resource].Exported && lastWriters[resource] != INVALID_PASS)
+        {
+            needed[lastWriters[resource]] = 1;
+        }
+    }
+    for (uint32_t pass = numPasses; pass-- > 0;)
+    {
+        if (needed[pass])
+        {
+            for (uint32_t i = dependencyStarts[pass]; i < dependencyStarts[pass + 1]; ++i)
+            {
+                needed[dependencies[i]] = 1;
+            }
+        }
+    }
+
+    for (uint32_t pass = 0; pass < numPasses; ++pass)
+    {
+        m_Passes[pass].Culled = !needed[pass];
+        if (needed[pass])
+        {
+            m_Schedule.push_back({pass, 0, 0});
+        }
+    }
+
+    for (uint32_t index = 0; index < m_Schedule.size(); ++index)
+    {
+        for (const auto &access: m_Passes[m_Schedule[index].Pass].Accesses)
+        {
+            auto &lifetime = m_Lifetimes[access.Resource];
+            if (lifetime.FirstPass == INVALID_PASS)
+            {
+                lifetime.FirstPass = index;
+            }
+            lifetime.LastPass = index;
+            lifetime.UsedStates = lifetime.UsedStates | access.State;
+        }
+    }
+
+    PlaceBarriers();
+    return true;
+}
+
+void RenderGraph::PlaceBarriers()
+{
+    // The state every access transitions to. Reads go to every read state the resource is used in until it is
+    // next written, so a run of reads in different states needs one transition.
+    std::vector<uint32_t> accessStarts(m_Schedule.size() + 1);
+    for (size_t index = 0; index < m_Schedule.size(); ++index)
+    {
+        accessStarts[index + 1] = accessStarts[index] +
+                                  static_cast<uint32_t>(m_Passes[m_Schedule[index].Pass].Accesses.size());
+    }
+    std::vector<ResourceState> targets(accessStarts.back());
+    std::vector<ResourceState> pendingReads(m_Resources.size(), ResourceState::Common);
+    for (size_t index = m_Schedule.size(); index-- > 0;)
+    {
+        const auto &accesses = m_Passes[m_Schedule[index].Pass].Accesses;
+        for (size_t i = 0; i < accesses.size(); ++i)
+        {
+            const auto &access = accesses[i];
+            if (access.Write)
+            {
+                pendingReads[access.Resource] = ResourceState::Common;
+                targets[accessStarts[index] + i] = access.State;
+            } else
+            {
+                pendingReads[access.Resource] = pendingReads[access.Resource] | access.State;
+                targets[accessStarts[index] + i] = pendingReads[access.Resource];
+            }
+        }
+    }
+
+    std::vector<ResourceState> states(m_Resources.size());
+    for (size_t resource = 0; resource < m_Resources.size(); ++resource)
+    {
+        states[resource] = m_Resources[resource].InitialState;
+    }
+    for (size_t index = 0; index < m_Schedule.size(); ++index)
+    {
+        auto &scheduled = m_Schedule[index];
+        scheduled.FirstBarrier = static_cast<uint32_t>(m_Barriers.size());
+
+        const auto &accesses = m_Passes[scheduled.Pass].Accesses;
+        for (size_t i = 0; i < accesses.size(); ++i)
+        {
+            const auto &access = accesses[i];
+            ResourceState state = states[access.Resource];
+            ResourceState target = targets[accessStarts[index] + i];
+            if (access.Write && state == target)
+            {
+                // Unordered access writes may overlap unless they are separated.
+                if (target == ResourceState::UnorderedAccess)
+                {
+                    m_Barriers.push_back({BarrierType::UnorderedAccess, access.Resource, state, target});
+                }
+                continue;
+            }
+            if (!access.Write && IsReadableIn(state, access.State))
+            {
+                continue;
+            }
+            m_Barriers.push_back({BarrierType::Transition, access.Resource, state, target});
+            states[access.Resource] = target;
+        }
+        scheduled.NumBarriers = static_cast<uint32_t>(m_Barriers.size()) - scheduled.FirstBarrier;
+    }
+
+    for (size_t resource = 0; resource < m_Resources.size(); ++resource)
+    {
+        const auto &desc = m_Resources[resource];
+        if (desc.Exported && states[resource] != desc.FinalState)
+        {
+            m_FinalBarriers.push_back({BarrierType::Transition, static_cast<ResourceHandle>(resource),
+                                       states[resource], desc.FinalState});
+        }
+    }
+}
+
+}
@@ -0,0 +1,224 @@
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace Enterprise::RenderGraph {
+
+/**
+ * How a pass uses a resource. The values are those of D3D12_RESOURCE_STATES, so read states combine as flags.
+ */
+enum class ResourceState : uint32_t {
+    Common = 0,
+    Present = 0,
+    VertexAndConstantBuffer = 0x1,
+    IndexBuffer = 0x2,
+    RenderTarget = 0x4,
+    UnorderedAccess = 0x8,
+    DepthWrite = 0x10,
+    DepthRead = 0x20,
+    NonPixelShaderResource = 0x40,
+    PixelShaderResource = 0x80,
+    IndirectArgument = 0x200,
+    CopyDest = 0x400,
+    CopySource = 0x800,
+    ResolveDest = 0x1000,
+    ResolveSource = 0x2000,
+    // Imported resources whose state the graph is not told. Their first use always transitions them.
+    Unknown = UINT32_MAX
+};
+
+inline ResourceState operator|( ResourceState a, ResourceState b )
+{
+    return static_cast<ResourceState>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+// True for states that only read, which a resource can be in several of at once.
+bool IsReadState( ResourceState state );
+
+using ResourceHandle = uint32_t;
+constexpr ResourceHandle INVALID_RESOURCE = UINT32_MAX;
+constexpr uint32_t       INVALID_PASS = UINT32_MAX;
+
+// A texture the graph creates for the frame. Format is a DXGI_FORMAT.
+struct TextureDesc {
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    uint32_t Format = 0;
+    uint32_t SampleCount = 1;
+    uint32_t MipLevels = 1;
+};
+
+inline bool operator==( const TextureDesc &a, const TextureDesc &b )
+{
+    return a.Width == b.Width && a.Height == b.Height && a.Format == b.Format && a.SampleCount == b.SampleCount &&
+           a.MipLevels == b.MipLevels;
+}
+
+enum class BarrierType : uint8_t {
+    Transition,
+    // Between passes that both access the resource as an unordered access view.
+    UnorderedAccess
+};
+
+struct Barrier {
+    BarrierType    Type;
+    ResourceHandle Resource;
+    ResourceState  Before;
+    ResourceState  After;
+};
+
+// A pass in the order it runs, with the barriers to record before it, see RenderGraph::GetBarriers.
+struct ScheduledPass {
+    uint32_t Pass;
+    uint32_t FirstBarrier;
+    uint32_t NumBarriers;
+};
+
+// Where in the schedule a resource is used, and every state it is used in.
+struct ResourceLifetime {
+    uint32_t      FirstPass = INVALID_PASS;
+    uint32_t      LastPass = INVALID_PASS;
+    ResourceState UsedStates = ResourceState::Common;
+};
+
+class RenderGraph;
+
+// Declares what a pass reads and writes, returned by RenderGraph::AddPass.
+class PassBuilder {
+public:
+    PassBuilder( RenderGraph* graph, uint32_t pass ): m_Graph(graph), m_Pass(pass)
+    {
+    }
+
+    // Read resource in state, which must be a read state. Reading a resource in several states combines them.
+    PassBuilder &Read( ResourceHandle resource, ResourceState state );
+
+    /**
+     * Write resource in state, which must not be a read state. Writes keep what earlier passes wrote to the rest of
+     * the resource, so they depend on them.
+     */
+    PassBuilder &Write( ResourceHandle resource, ResourceState state );
+
+    // Never cull the pass, for passes whose work is seen outside the graph.
+    PassBuilder &SetSideEffects();
+
+    [[nodiscard]] uint32_t GetPass() const { return m_Pass; }
+
+private:
+    RenderGraph* m_Graph;
+    uint32_t     m_Pass;
+};
+
+/**
+ * Frame graph of passes over virtual resources. Passes declare what they read and write, and Compile turns them
+ * into a schedule: passes that nothing exported depends on are culled, the others keep the order they were added
+ * in, and every pass gets the batch of barriers that brings its resources into the states it uses them in.
+ * Consecutive reads in different states share a single transition to all of them. Compile also finds when every
+ * resource the graph creates is first and last used, which is all the graph needs to know about the GPU; recording
+ * is left to the caller.
+ */
+class RenderGraph {
+public:
+    RenderGraph() = default;
+
+    // Drop the passes and resources, to build the next frame.
+    void Reset();
+
+    /**
+     * Add a resource that lives outside the graph, in state when the graph starts, or ResourceState::Unknown.
+     */
+    ResourceHandle ImportResource( const std::string &name, ResourceState state = ResourceState::Unknown );
+
+    // Add a texture the graph creates, which lives from the first pass that uses it to the last.
+    ResourceHandle CreateTexture( const std::string &name, const TextureDesc &desc );
+
+    /**
+     * Keep what the graph writes to resource, leaving it in finalState. The passes it depends on are not culled.
+     */
+    void ExportResource( ResourceHandle resource, ResourceState finalState );
+
+    PassBuilder AddPass( const std::string &name );
+
+    /**
+     * Cull, schedule and place the barriers. Returns false, with nothing scheduled, when a pass reads a resource
+     * the graph creates before any pass has written it.
+     */
+    bool Compile();
+
+    [[nodiscard]] const std::vector<ScheduledPass> &GetSchedule() const { return m_Schedule; }
+
+    [[nodiscard]] const std::vector<Barrier> &GetBarriers() const { return m_Barriers; }
+
+    // Barriers to record after the last pass, into the states exported resources were asked to be left in.
+    [[nodiscard]] const std::vector<Barrier> &GetFinalBarriers() const { return m_FinalBarriers; }
+
+    [[nodiscard]] bool IsCulled( uint32_t pass ) const { return m_Passes[pass].Culled; }
+
+    [[nodiscard]] uint32_t GetNumPasses() const { return static_cast<uint32_t>(m_Passes.size()); }
+
+    [[nodiscard]] const std::string &GetPassName( uint32_t pass ) const { return m_Passes[pass].Name; }
+
+    [[nodiscard]] uint32_t GetNumResources() const { return static_cast<uint32_t>(m_Resources.size()); }
+
+    [[nodiscard]] const std::string &GetResourceName( ResourceHandle resource ) const
+    {
+        return m_Resources[resource].Name;
+    }
+
+    [[nodiscard]] bool IsImported( ResourceHandle resource ) const { return m_Resources[resource].Imported; }
+
+    [[nodiscard]] const TextureDesc &GetTextureDesc( ResourceHandle resource ) const
+    {
+        return m_Resources[resource].Desc;
+    }
+
+    // Indices into GetSchedule. FirstPass is INVALID_PASS for resources no scheduled pass uses.
+    [[nodiscard]] const ResourceLifetime &GetLifetime( ResourceHandle resource ) const
+    {
+        return m_Lifetimes[resource];
+    }
+
+private:
+    friend class PassBuilder;
+
+    struct Access {
+        ResourceHandle Resource;
+        ResourceState  State;
+        bool           Write;
+    };
+
+    struct Pass {
+        std::string         Name;
+        std::vector<Access> Accesses;
+        bool                SideEffects = false;
+        bool                Culled = false;
+    };
+
+    struct Resource {
+        std::string   Name;
+        TextureDesc   Desc;
+        bool          Imported = false;
+        ResourceState InitialState = ResourceState::Unknown;
+        bool          Exported = false;
+        ResourceState FinalState = ResourceState::Common;
+    };
+
+    void AddAccess( uint32_t pass, ResourceHandle resource, ResourceState state, bool write );
+
+    // Place the barriers of the scheduled passes and the final ones.
+    void PlaceBarriers();
+
+    std::vector<Pass>             m_Passes;
+    std::vector<Resource>         m_Resources;
+    std::vector<ScheduledPass>    m_Schedule;
+    std::vector<Barrier>          m_Barriers;
+    std::vector<Barrier>          m_FinalBarriers;
+    std::vector<ResourceLifetime> m_Lifetimes;
+};
+
+}
+
+#endif //RENDERGRAPH_H
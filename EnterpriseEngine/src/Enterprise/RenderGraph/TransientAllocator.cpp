@@ -0,0 +1,99 @@
+#include "TransientAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Enterprise::RenderGraph {
+
+namespace {
+
+uint64_t AlignUp( uint64_t value, uint64_t alignment )
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+void TransientAllocator::Clear()
+{
+    m_Requests.clear();
+    m_Placements.clear();
+}
+
+uint32_t TransientAllocator::Add( uint64_t size, uint64_t alignment, uint32_t firstPass, uint32_t lastPass )
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && firstPass <= lastPass);
+    m_Requests.push_back({size, alignment, firstPass, lastPass});
+    return static_cast<uint32_t>(m_Requests.size() - 1);
+}
+
+uint64_t TransientAllocator::Allocate()
+{
+    auto count = static_cast<uint32_t>(m_Requests.size());
+    m_Placements.assign(count, {0, NO_ALIAS});
+
+    m_Order.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_Order[i] = i;
+    }
+    std::stable_sort(m_Order.begin(), m_Order.end(), [this]( uint32_t a, uint32_t b ) {
+        return m_Requests[a].Size > m_Requests[b].Size;
+    });
+
+    // Placed resources are kept in the order of their offsets, so the gaps between them are found in one sweep.
+    m_Ranges.clear();
+    uint64_t heapSize = 0;
+    for (uint32_t resource: m_Order)
+    {
+        const auto &request = m_Requests[resource];
+
+        // Only resources alive at the same time are in the way, and their ranges may overlap each other.
+        uint64_t offset = 0;
+        for (const auto &range: m_Ranges)
+        {
+            const auto &other = m_Requests[range.Resource];
+            if (other.FirstPass > request.LastPass || request.FirstPass > other.LastPass)
+            {
+                continue;
+            }
+            if (offset + request.Size <= range.Begin)
+            {
+                break;
+            }
+            offset = std::max(offset, AlignUp(range.End, request.Alignment));
+        }
+        m_Placements[resource].Offset = offset;
+        heapSize = std::max(heapSize, offset + request.Size);
+
+        Range placed = {offset, offset + request.Size, resource};
+        m_Ranges.insert(std::upper_bound(m_Ranges.begin(), m_Ranges.end(), placed,
+                                         []( const Range &a, const Range &b ) { return a.Begin < b.Begin; }),
+                        placed);
+    }
+
+    for (uint32_t resource = 0; resource < count; ++resource)
+    {
+        const auto &request = m_Requests[resource];
+        uint64_t    begin = m_Placements[resource].Offset;
+        uint64_t    end = begin + request.Size;
+        uint32_t    aliased = NO_ALIAS;
+        for (const auto &range: m_Ranges)
+        {
+            if (range.Begin >= end)
+            {
+                break;
+            }
+            const auto &previous = m_Requests[range.Resource];
+            if (range.End > begin && previous.LastPass < request.FirstPass &&
+                (aliased == NO_ALIAS || previous.LastPass > m_Requests[aliased].LastPass))
+            {
+                aliased = range.Resource;
+            }
+        }
+        m_Placements[resource].Aliased = aliased;
+    }
+    return heapSize;
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef TRANSIENTALLOCATOR_H
+#define TRANSIENTALLOCATOR_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace Enterprise::RenderGraph {
+
+/**
+ * Packs the resources of a frame into one heap. Resources that are never used in the same pass range may share
+ * memory, so each is placed at the lowest offset that does not overlap a resource alive at the same time as it.
+ * Resources are placed from the largest down, which leaves the small ones to fill the gaps between the large.
+ * Lifetimes are the schedule indices of the first and last pass using the resource, as RenderGraph::GetLifetime
+ * returns them.
+ */
+class TransientAllocator {
+public:
+    static constexpr uint32_t NO_ALIAS = UINT32_MAX;
+
+    struct Placement {
+        uint64_t Offset;
+        // The resource last using the memory before this one, which needs an aliasing barrier between them.
+        uint32_t Aliased;
+    };
+
+    TransientAllocator() = default;
+
+    void Clear();
+
+    // Add a resource of size bytes, aligned to alignment, a power of two. Returns its index.
+    uint32_t Add( uint64_t size, uint64_t alignment, uint32_t firstPass, uint32_t lastPass );
+
+    /**
+     * Place every resource added. Returns the size of the heap they fit in.
+     */
+    uint64_t Allocate();
+
+    // Per resource, in the order added.
+    [[nodiscard]] const std::vector<Placement> &GetPlacements() const { return m_Placements; }
+
+    [[nodiscard]] uint32_t GetNumResources() const { return static_cast<uint32_t>(m_Requests.size()); }
+
+private:
+    struct Request {
+        uint64_t Size;
+        uint64_t Alignment;
+        uint32_t FirstPass;
+        uint32_t LastPass;
+    };
+
+    struct Range {
+        uint64_t Begin;
+        uint64_t End;
+        uint32_t Resource;
+    };
+
+    std::vector<Request>   m_Requests;
+    std::vector<Placement> m_Placements;
+    // Resources in the order they are placed, and the memory of those placed in the order of their offsets.
+    std::vector<uint32_t>  m_Order;
+    std::vector<Range>     m_Ranges;
+};
+
+}
+
+#endif //TRANSIENTALLOCATOR_H
@@ -0,0 +1,161 @@
+#include "InstanceBatcher.h"
+
+#include <xmmintrin.h>
+
+#include "../Core/ThreadPool.h"
+
+namespace Enterprise::Scene {
+
+namespace {
+
+// Ranges smaller than this are not worth handing to the pool.
+constexpr uint32_t PARALLEL_PACK_SIZE = 8192;
+constexpr uint32_t INSTANCES_PER_TASK = 4096;
+
+// Cross product of the xyz of a and b, w is 0.
+__m128 Cross( __m128 a, __m128 b )
+{
+    __m128 aYzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 bYzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 zxy = _mm_sub_ps(_mm_mul_ps(a, bYzx), _mm_mul_ps(aYzx, b));
+    return _mm_shuffle_ps(zxy, zxy, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+void PackInstance( const Matrix4x4 &world, InstanceData* instance )
+{
+    __m128 r0 = _mm_load_ps(world.m[0]);
+    __m128 r1 = _mm_load_ps(world.m[1]);
+    __m128 r2 = _mm_load_ps(world.m[2]);
+    __m128 r3 = _mm_load_ps(world.m[3]);
+
+    // The shader transforms column vectors, so the rows it wants are the columns of the world matrix.
+    __m128 c0 = r0;
+    __m128 c1 = r1;
+    __m128 c2 = r2;
+    __m128 c3 = r3;
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_store_ps(instance->World[0], c0);
+    _mm_store_ps(instance->World[1], c1);
+    _mm_store_ps(instance->World[2], c2);
+
+    // The rows of the cofactor matrix are cross products of the rows, and the inverse is its transpose over the
+    // determinant.
+    __m128 n0 = Cross(r1, r2);
+    __m128 n1 = Cross(r2, r0);
+    __m128 n2 = Cross(r0, r1);
+    __m128 n3 = _mm_setzero_ps();
+    __m128 det = _mm_mul_ps(r0, n0);
+    det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)));
+    det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)));
+    __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    _MM_TRANSPOSE4_PS(n0, n1, n2, n3);
+    _mm_store_ps(instance->Normal[0], _mm_mul_ps(n0, invDet));
+    _mm_store_ps(instance->Normal[1], _mm_mul_ps(n1, invDet));
+    _mm_store_ps(instance->Normal[2], _mm_mul_ps(n2, invDet));
+}
+
+}
+
+InstanceData GetIdentityInstance()
+{
+    return {
+        {{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f}},
+        {{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f}}
+    };
+}
+
+void InstanceBatcher::Clear()
+{
+    m_Batches.clear();
+    m_BatchIndices.clear();
+    m_Worlds.clear();
+    m_InstanceBatches.clear();
+    m_Order.clear();
+    m_LastBatch = UINT32_MAX;
+}
+
+void InstanceBatcher::Reserve( size_t numInstances )
+{
+    m_Worlds.reserve(numInstances);
+    m_InstanceBatches.reserve(numInstances);
+    m_Order.reserve(numInstances);
+}
+
+void InstanceBatcher::Add( uint64_t key, const Matrix4x4* world )
+{
+    uint32_t batch = GetBatchIndex(key);
+    m_Worlds.push_back(world);
+    m_InstanceBatches.push_back(batch);
+    m_Batches[batch].NumInstances += 1;
+}
+
+void InstanceBatcher::Add( uint64_t key, const Matrix4x4* worlds, size_t count )
+{
+    uint32_t batch = GetBatchIndex(key);
+    for (size_t i = 0; i < count; ++i)
+    {
+        m_Worlds.push_back(worlds + i);
+    }
+    m_InstanceBatches.insert(m_InstanceBatches.end(), count, batch);
+    m_Batches[batch].NumInstances += static_cast<uint32_t>(count);
+}
+
+uint32_t InstanceBatcher::GetBatchIndex( uint64_t key )
+{
+    if (m_LastBatch != UINT32_MAX && key == m_LastKey)
+    {
+        return m_LastBatch;
+    }
+
+    auto [it, inserted] = m_BatchIndices.try_emplace(key, static_cast<uint32_t>(m_Batches.size()));
+    if (inserted)
+    {
+        m_Batches.push_back({key, 0, 0});
+    }
+    m_LastKey = key;
+    m_LastBatch = it->second;
+    return it->second;
+}
+
+void InstanceBatcher::Build()
+{
+    // Counting sort, the batches already know their sizes.
+    uint32_t first = 0;
+    for (auto &batch: m_Batches)
+    {
+        batch.FirstInstance = first;
+        first += batch.NumInstances;
+    }
+
+    std::vector<uint32_t> cursors(m_Batches.size());
+    for (size_t i = 0; i < m_Batches.size(); ++i)
+    {
+        cursors[i] = m_Batches[i].FirstInstance;
+    }
+    m_Order.resize(m_Worlds.size());
+    for (uint32_t i = 0; i < m_InstanceBatches.size(); ++i)
+    {
+        m_Order[cursors[m_InstanceBatches[i]]++] = i;
+    }
+}
+
+void InstanceBatcher::Pack( uint32_t first, uint32_t count, InstanceData* destination, bool parallel ) const
+{
+    auto packRange = [&]( size_t begin, size_t end )
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            PackInstance(*m_Worlds[m_Order[first + i]], destination + i);
+        }
+    };
+
+    if (parallel && count >= PARALLEL_PACK_SIZE)
+    {
+        Core::Threads::ThreadPool::Get().ParallelFor(count, INSTANCES_PER_TASK, packRange);
+    } else
+    {
+        packRange(0, count);
+    }
+}
+
+}
@@ -0,0 +1,92 @@
+#ifndef INSTANCEBATCHER_H
+#define INSTANCEBATCHER_H
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "TransformHierarchy.h"
+
+
+namespace Enterprise::Scene {
+
+/**
+ * Per instance data read by the vertex shaders, see Instance in VertexShader.hlsl. Both matrices are stored as
+ * rows of an HLSL row_major float3x4 transforming column vectors: World is the transposed world matrix without
+ * its last row, Normal the inverse transpose of the upper 3x3 of World, for normals.
+ */
+struct alignas(16) InstanceData {
+    float World[3][4];
+    float Normal[3][4];
+};
+static_assert(sizeof(InstanceData) == 96);
+
+// Leaves positions and normals in model space, for draws that are not instanced.
+InstanceData GetIdentityInstance();
+
+/**
+ * Groups the instances drawn each frame by key, usually what they are drawn with, so every group can be drawn
+ * with one instanced draw. Add the instances, Build, then Pack the world matrices of every batch straight into
+ * the buffer the GPU reads.
+ * Packing converts four rows at a time with SSE and is split across the thread pool.
+ */
+class InstanceBatcher {
+public:
+    struct Batch {
+        uint64_t Key;
+        // Range of the batch in the instance order, see Pack.
+        uint32_t FirstInstance;
+        uint32_t NumInstances;
+    };
+
+    InstanceBatcher() = default;
+
+    // Drop the instances of the previous frame.
+    void Clear();
+
+    void Reserve( size_t numInstances );
+
+    /**
+     * Add an instance drawn with key. world is not copied and must stay valid until the instance is packed, as the
+     * world matrices of a TransformHierarchy do until its next update.
+     */
+    void Add( uint64_t key, const Matrix4x4* world );
+
+    // Add count instances drawn with key, whose world matrices follow each other.
+    void Add( uint64_t key, const Matrix4x4* worlds, size_t count );
+
+    /**
+     * Sort the instances by batch. Batches come in the order their keys were first added, and the instances of a
+     * batch in the order they were added.
+     */
+    void Build();
+
+    [[nodiscard]] const std::vector<Batch> &GetBatches() const { return m_Batches; }
+
+    [[nodiscard]] uint32_t GetNumInstances() const { return static_cast<uint32_t>(m_Worlds.size()); }
+
+    /**
+     * Convert count instances from first on, in batch order, to destination, which must be 16 byte aligned.
+     * Large ranges are split across the thread pool when parallel is set.
+     */
+    void Pack( uint32_t first, uint32_t count, InstanceData* destination, bool parallel = true ) const;
+
+private:
+    uint32_t GetBatchIndex( uint64_t key );
+
+    std::vector<Batch>                     m_Batches;
+    // Per key, its index in m_Batches.
+    std::unordered_map<uint64_t, uint32_t> m_BatchIndices;
+    // Per instance, in the order added.
+    std::vector<const Matrix4x4*>          m_Worlds;
+    std::vector<uint32_t>                  m_InstanceBatches;
+    // Instances in batch order, filled by Build.
+    std::vector<uint32_t>                  m_Order;
+    // Batch of the last key added, most instances come in runs of the same key.
+    uint64_t                               m_LastKey = 0;
+    uint32_t                               m_LastBatch = UINT32_MAX;
+};
+
+}
+
+#endif //INSTANCEBATCHER_H
@@ -0,0 +1,93 @@
+#include "ModelNodes.h"
+
+#include <cmath>
+
+namespace Enterprise::Scene {
+
+Transform DecomposeNodeTransform( const float transform[16] )
+{
+    // Rows of the transposed matrix, which is laid out like the local matrices of TransformHierarchy: scaled
+    // rotation rows, then the translation.
+    float rows[3][3];
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int column = 0; column < 3; ++column)
+        {
+            rows[row][column] = transform[column * 4 + row];
+        }
+    }
+
+    Transform local;
+    for (int i = 0; i < 3; ++i)
+    {
+        local.Position[i] = transform[i * 4 + 3];
+        local.Scale[i] = std::sqrt(rows[i][0] * rows[i][0] + rows[i][1] * rows[i][1] + rows[i][2] * rows[i][2]);
+    }
+    float determinant = rows[0][0] * (rows[1][1] * rows[2][2] - rows[1][2] * rows[2][1]) -
+                        rows[0][1] * (rows[1][0] * rows[2][2] - rows[1][2] * rows[2][0]) +
+                        rows[0][2] * (rows[1][0] * rows[2][1] - rows[1][1] * rows[2][0]);
+    if (determinant < 0.0f)
+    {
+        local.Scale[0] = -local.Scale[0];
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        float inverseScale = local.Scale[i] != 0.0f ? 1.0f / local.Scale[i] : 0.0f;
+        rows[i][0] *= inverseScale;
+        rows[i][1] *= inverseScale;
+        rows[i][2] *= inverseScale;
+    }
+
+    // Inverse of the quaternion to matrix conversion of TransformHierarchy, from the largest of w, x, y and z.
+    float  trace = rows[0][0] + rows[1][1] + rows[2][2];
+    float* q = local.Rotation;
+    if (trace > 0.0f)
+    {
+        float s = 2.0f * std::sqrt(1.0f + trace);
+        q[0] = (rows[1][2] - rows[2][1]) / s;
+        q[1] = (rows[2][0] - rows[0][2]) / s;
+        q[2] = (rows[0][1] - rows[1][0]) / s;
+        q[3] = 0.25f * s;
+    } else if (rows[0][0] > rows[1][1] && rows[0][0] > rows[2][2])
+    {
+        float s = 2.0f * std::sqrt(1.0f + rows[0][0] - rows[1][1] - rows[2][2]);
+        q[0] = 0.25f * s;
+        q[1] = (rows[0][1] + rows[1][0]) / s;
+        q[2] = (rows[2][0] + rows[0][2]) / s;
+        q[3] = (rows[1][2] - rows[2][1]) / s;
+    } else if (rows[1][1] > rows[2][2])
+    {
+        float s = 2.0f * std::sqrt(1.0f + rows[1][1] - rows[0][0] - rows[2][2]);
+        q[0] = (rows[0][1] + rows[1][0]) / s;
+        q[1] = 0.25f * s;
+        q[2] = (rows[1][2] + rows[2][1]) / s;
+        q[3] = (rows[2][0] - rows[0][2]) / s;
+    } else
+    {
+        float s = 2.0f * std::sqrt(1.0f + rows[2][2] - rows[0][0] - rows[1][1]);
+        q[0] = (rows[2][0] + rows[0][2]) / s;
+        q[1] = (rows[1][2] + rows[2][1]) / s;
+        q[2] = 0.25f * s;
+        q[3] = (rows[0][1] - rows[1][0]) / s;
+    }
+    float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    for (int i = 0; i < 4; ++i)
+    {
+        q[i] /= length;
+    }
+    return local;
+}
+
+void AddModelNodes( const Assets::CookedNode* nodes, uint32_t numNodes, TransformHierarchy::Handle parent,
+                    TransformHierarchy* transforms, std::vector<TransformHierarchy::Handle>* handles )
+{
+    handles->resize(numNodes);
+    for (uint32_t i = 0; i < numNodes; ++i)
+    {
+        const auto &node = nodes[i];
+        (*handles)[i] = transforms->AddNode(node.Parent < 0 ? parent : (*handles)[node.Parent],
+                                            DecomposeNodeTransform(node.Transform));
+    }
+}
+
+}
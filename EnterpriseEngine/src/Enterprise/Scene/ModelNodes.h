@@ -0,0 +1,28 @@
+#ifndef MODELNODES_H
+#define MODELNODES_H
+#include <cstdint>
+#include <vector>
+
+#include "TransformHierarchy.h"
+#include "../Assets/CookedModel.h"
+
+
+namespace Enterprise::Scene {
+
+/**
+ * Split a node transform, row major for column vectors as assimp stores it, into the scale, rotation and
+ * translation of a Transform. A mirroring transform gets a negative x scale. Shear cannot be represented and is
+ * dropped.
+ */
+Transform DecomposeNodeTransform( const float transform[16] );
+
+/**
+ * Add nodes below parent, or as roots for INVALID_HANDLE, keeping their hierarchy. Nodes must come after their
+ * parent, as CookedModel validates. The handle of every node goes to handles, in the same order.
+ */
+void AddModelNodes( const Assets::CookedNode* nodes, uint32_t numNodes, TransformHierarchy::Handle parent,
+                    TransformHierarchy* transforms, std::vector<TransformHierarchy::Handle>* handles );
+
+}
+
+#endif //MODELNODES_H
@@ -0,0 +1,239 @@
+#include "RenderQueue.h"
+
+#include <cstring>
+
+namespace Enterprise::Scene {
+
+namespace {
+
+// Wide enough that a frame's keys rarely need more than a few digits, small enough for the histograms to stay in
+// cache.
+constexpr uint32_t RADIX_BITS = 11;
+constexpr uint32_t RADIX_SIZE = 1u << RADIX_BITS;
+constexpr uint32_t MAX_DIGITS = (64 + RADIX_BITS - 1) / RADIX_BITS;
+
+static_assert(RenderQueue::PASS_BITS + RenderQueue::PIPELINE_BITS + RenderQueue::MATERIAL_BITS +
+              RenderQueue::DEPTH_BITS == 64);
+
+uint64_t GetField( uint32_t value, uint32_t bits )
+{
+    return value & ((uint64_t(1) << bits) - 1);
+}
+
+// Turn the counts of a digit into the offset of its first draw.
+void PrefixSum( uint32_t* counts )
+{
+    uint32_t sum = 0;
+    for (uint32_t value = 0; value < RADIX_SIZE; ++value)
+    {
+        uint32_t count = counts[value];
+        counts[value] = sum;
+        sum += count;
+    }
+}
+
+}
+
+uint64_t RenderQueue::MakeKey( uint32_t pass, uint32_t pipeline, uint32_t material, float depth, bool farFirst )
+{
+    // Floats that are not negative order like their bits, NaN goes to the front.
+    if (!(depth > 0.0f))
+    {
+        depth = 0.0f;
+    }
+    uint32_t depthBits;
+    memcpy(&depthBits, &depth, sizeof(depthBits));
+    uint32_t depthBucket = depthBits >> (32 - DEPTH_BITS);
+    if (farFirst)
+    {
+        depthBucket = ~depthBucket;
+    }
+
+    return GetField(pass, PASS_BITS) << (PIPELINE_BITS + MATERIAL_BITS + DEPTH_BITS) |
+           GetField(pipeline, PIPELINE_BITS) << (MATERIAL_BITS + DEPTH_BITS) |
+           GetField(material, MATERIAL_BITS) << DEPTH_BITS |
+           GetField(depthBucket, DEPTH_BITS);
+}
+
+void RenderQueue::Clear()
+{
+    m_Keys.clear();
+    m_Payloads.clear();
+}
+
+void RenderQueue::Reserve( size_t numDraws )
+{
+    m_Keys.reserve(numDraws);
+    m_Payloads.reserve(numDraws);
+    m_SortedKeys.reserve(numDraws);
+    m_SortedPayloads.reserve(numDraws);
+}
+
+void RenderQueue::Sort()
+{
+    size_t count = m_Keys.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    uint64_t varyingBits = 0;
+    for (uint64_t key: m_Keys)
+    {
+        varyingBits |= key ^ m_Keys[0];
+    }
+    if (varyingBits == 0)
+    {
+        return;
+    }
+
+    // Runs of bits that differ between the keys, from the least significant.
+    uint32_t runShifts[64];
+    uint32_t runBits[64];
+    uint32_t numRuns = 0;
+    uint32_t numVaryingBits = 0;
+    for (uint32_t bit = 0; bit < 64;)
+    {
+        if (((varyingBits >> bit) & 1) == 0)
+        {
+            ++bit;
+            continue;
+        }
+        runShifts[numRuns] = bit;
+        while (bit < 64 && ((varyingBits >> bit) & 1) != 0)
+        {
+            ++bit;
+        }
+        runBits[numRuns] = bit - runShifts[numRuns];
+        numVaryingBits += runBits[numRuns];
+        ++numRuns;
+    }
+
+    // The index of a draw only needs the bits of the count.
+    uint32_t indexBits = 1;
+    while ((size_t(1) << indexBits) < count)
+    {
+        ++indexBits;
+    }
+    if (numVaryingBits + indexBits > 64)
+    {
+        SortWide(varyingBits);
+        return;
+    }
+
+    // Usually the differing bits fit next to the index, so they are gathered above the index of their draw and the
+    // sort moves 8 bytes per draw through as few digits as those bits need.
+    uint32_t numDigits = (numVaryingBits + RADIX_BITS - 1) / RADIX_BITS;
+    m_Histograms.assign(size_t(numDigits) * RADIX_SIZE, 0);
+    m_Items.resize(count);
+    uint64_t runMasks[64];
+    for (uint32_t run = 0; run < numRuns; ++run)
+    {
+        runMasks[run] = (uint64_t(1) << runBits[run]) - 1;
+    }
+    const uint64_t* keys = m_Keys.data();
+    uint64_t*       packed = m_Items.data();
+    uint32_t*       histograms = m_Histograms.data();
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t key = keys[i];
+        uint64_t compact = 0;
+        uint32_t position = 0;
+        for (uint32_t run = 0; run < numRuns; ++run)
+        {
+            compact |= ((key >> runShifts[run]) & runMasks[run]) << position;
+            position += runBits[run];
+        }
+        packed[i] = compact << indexBits | i;
+        for (uint32_t digit = 0; digit < numDigits; ++digit)
+        {
+            histograms[digit * RADIX_SIZE + ((compact >> (digit * RADIX_BITS)) & (RADIX_SIZE - 1))] += 1;
+        }
+    }
+
+    m_SortedItems.resize(count);
+    uint64_t indexMask = (uint64_t(1) << indexBits) - 1;
+    for (uint32_t digit = 0; digit < numDigits; ++digit)
+    {
+        // A digit every draw shares would not move anything.
+        uint32_t* offsets = m_Histograms.data() + digit * RADIX_SIZE;
+        uint32_t  shift = indexBits + digit * RADIX_BITS;
+        if (offsets[(m_Items[0] >> shift) & (RADIX_SIZE - 1)] == count)
+        {
+            continue;
+        }
+        PrefixSum(offsets);
+
+        const uint64_t* items = m_Items.data();
+        uint64_t*       sortedItems = m_SortedItems.data();
+        for (size_t i = 0; i < count; ++i)
+        {
+            sortedItems[offsets[(items[i] >> shift) & (RADIX_SIZE - 1)]++] = items[i];
+        }
+        m_Items.swap(m_SortedItems);
+    }
+
+    m_SortedKeys.resize(count);
+    m_SortedPayloads.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto index = static_cast<uint32_t>(m_Items[i] & indexMask);
+        m_SortedKeys[i] = m_Keys[index];
+        m_SortedPayloads[i] = m_Payloads[index];
+    }
+    m_Keys.swap(m_SortedKeys);
+    m_Payloads.swap(m_SortedPayloads);
+}
+
+void RenderQueue::SortWide( uint64_t varyingBits )
+{
+    size_t count = m_Keys.size();
+
+    // Each digit starts at the lowest differing bit above the previous one.
+    uint32_t shifts[MAX_DIGITS];
+    uint32_t numDigits = 0;
+    while (varyingBits != 0)
+    {
+        uint32_t shift = 0;
+        while (((varyingBits >> shift) & 1) == 0)
+        {
+            ++shift;
+        }
+        shifts[numDigits++] = shift;
+        varyingBits = shift + RADIX_BITS < 64 ? varyingBits & (~uint64_t(0) << (shift + RADIX_BITS)) : 0;
+    }
+
+    // The histograms of every digit in one pass over the keys.
+    m_Histograms.assign(size_t(numDigits) * RADIX_SIZE, 0);
+    for (uint64_t key: m_Keys)
+    {
+        for (uint32_t digit = 0; digit < numDigits; ++digit)
+        {
+            m_Histograms[digit * RADIX_SIZE + ((key >> shifts[digit]) & (RADIX_SIZE - 1))] += 1;
+        }
+    }
+
+    m_SortedKeys.resize(count);
+    m_SortedPayloads.resize(count);
+    for (uint32_t digit = 0; digit < numDigits; ++digit)
+    {
+        uint32_t* offsets = m_Histograms.data() + digit * RADIX_SIZE;
+        PrefixSum(offsets);
+
+        const uint64_t* keys = m_Keys.data();
+        const uint32_t* payloads = m_Payloads.data();
+        uint64_t*       sortedKeys = m_SortedKeys.data();
+        uint32_t*       sortedPayloads = m_SortedPayloads.data();
+        uint32_t        shift = shifts[digit];
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t destination = offsets[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+            sortedKeys[destination] = keys[i];
+            sortedPayloads[destination] = payloads[i];
+        }
+        m_Keys.swap(m_SortedKeys);
+        m_Payloads.swap(m_SortedPayloads);
+    }
+}
+
+}
@@ -0,0 +1,90 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace Enterprise::Scene {
+
+/**
+ * Draws of a frame, each a 64 bit sort key and a payload indexing whatever the caller draws from. Sorting the keys
+ * groups the draws by pass, then pipeline state, then material, and orders them by depth within a material, so
+ * the submission only has to change state where the key does.
+ * Keys are sorted with a least significant digit radix sort. The digits only cover the bits that differ between
+ * the keys of the frame, which are usually few, so most of the key costs nothing to sort. When those bits fit in
+ * 64 with the index of their draw, they are sorted together with it as a single 64 bit item, and digits that
+ * every draw shares are skipped.
+ */
+class RenderQueue {
+public:
+    // Bits of each field, from the most significant.
+    static constexpr uint32_t PASS_BITS = 4;
+    static constexpr uint32_t PIPELINE_BITS = 12;
+    static constexpr uint32_t MATERIAL_BITS = 32;
+    static constexpr uint32_t DEPTH_BITS = 16;
+
+    /**
+     * Sort key of a draw. Fields are truncated to their bits. depth is any distance from the camera that is not
+     * negative; buckets keep the exponent and top mantissa bits of the float, so they are under 1% of the distance
+     * wide. Draws with farFirst sort back to front, for blending.
+     */
+    static uint64_t MakeKey( uint32_t pass, uint32_t pipeline, uint32_t material, float depth, bool farFirst = false );
+
+    static uint32_t GetPass( uint64_t key )
+    {
+        return static_cast<uint32_t>(key >> (PIPELINE_BITS + MATERIAL_BITS + DEPTH_BITS));
+    }
+
+    static uint32_t GetPipeline( uint64_t key )
+    {
+        return static_cast<uint32_t>(key >> (MATERIAL_BITS + DEPTH_BITS)) & ((1u << PIPELINE_BITS) - 1);
+    }
+
+    static uint32_t GetMaterial( uint64_t key )
+    {
+        return static_cast<uint32_t>(key >> DEPTH_BITS);
+    }
+
+    RenderQueue() = default;
+
+    void Clear();
+
+    void Reserve( size_t numDraws );
+
+    void Add( uint64_t key, uint32_t payload )
+    {
+        m_Keys.push_back(key);
+        m_Payloads.push_back(payload);
+    }
+
+    /**
+     * Sort the draws by key. Draws with equal keys keep the order they were added in.
+     */
+    void Sort();
+
+    [[nodiscard]] size_t GetNumDraws() const { return m_Keys.size(); }
+
+    // In sort order after Sort.
+    [[nodiscard]] const std::vector<uint64_t> &GetKeys() const { return m_Keys; }
+
+    [[nodiscard]] const std::vector<uint32_t> &GetPayloads() const { return m_Payloads; }
+
+private:
+    // Sort on digits placed over varyingBits, for keys that differ in more bits than fit next to an index.
+    void SortWide( uint64_t varyingBits );
+
+    std::vector<uint64_t> m_Keys;
+    std::vector<uint32_t> m_Payloads;
+    // Scatter targets of the sort passes.
+    std::vector<uint64_t> m_SortedKeys;
+    std::vector<uint32_t> m_SortedPayloads;
+    std::vector<uint32_t> m_Histograms;
+    // The bits that differ between the keys above the index of their draw, and their scatter target.
+    std::vector<uint64_t> m_Items;
+    std::vector<uint64_t> m_SortedItems;
+};
+
+}
+
+#endif //RENDERQUEUE_H
@@ -1,5 +0,0 @@
-//
-// Created by Peter on 5/18/2025.
-//
-
-#include "Scene.h"
@@ -4,24 +4,26 @@
 
 #ifndef SCENE_H
 #define SCENE_H
-#include <memory>
+#include "TransformHierarchy.h"
 
 namespace Enterprise::Scene {
 
 class Scene {
 public:
-    Scene();
-    ~Scene();
-    bool LoadScene();
-    void RenderScene();
+    Scene() = default;
 
-private:
-    template<typename T>
-    struct Node : std::enable_shared_from_this<Node<T>>{
-        std::shared_ptr<Node> m_Parent;
-        std::shared_ptr<Node> m_Children[];
-    };
+    [[nodiscard]] TransformHierarchy &GetTransforms() { return m_Transforms; }
+
+    [[nodiscard]] const TransformHierarchy &GetTransforms() const { return m_Transforms; }
 
+    /**
+     * Bring the world matrices up to date with the local transforms changed since the last update.
+     * Call once per frame before reading world matrices.
+     */
+    void Update() { m_Transforms.UpdateWorldMatrices(); }
+
+private:
+    TransformHierarchy m_Transforms;
 };
 
 }
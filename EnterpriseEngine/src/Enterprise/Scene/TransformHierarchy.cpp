@@ -0,0 +1,394 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <xmmintrin.h>
+
+#include "../Core/ThreadPool.h"
+
+namespace Enterprise::Scene {
+
+namespace {
+
+// Levels smaller than this are not worth handing to the pool.
+constexpr uint32_t PARALLEL_LEVEL_SIZE = 4096;
+constexpr uint32_t NODES_PER_TASK = 1024;
+
+// result = a * b. result may not alias b.
+void MultiplyMatrices( const Matrix4x4 &a, const Matrix4x4 &b, Matrix4x4* result )
+{
+    __m128 b0 = _mm_load_ps(b.m[0]);
+    __m128 b1 = _mm_load_ps(b.m[1]);
+    __m128 b2 = _mm_load_ps(b.m[2]);
+    __m128 b3 = _mm_load_ps(b.m[3]);
+    for (int row = 0; row < 4; ++row)
+    {
+        __m128 r = _mm_load_ps(a.m[row]);
+        __m128 sum = _mm_mul_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+        _mm_store_ps(result->m[row], sum);
+    }
+}
+
+}
+
+TransformHierarchy::TransformHierarchy()
+    : m_LevelStarts(1, 0)
+    , m_NeedsSort(false)
+    , m_AnyDirty(false)
+{}
+
+TransformHierarchy::Handle TransformHierarchy::AddNode( Handle parent, const Transform &local )
+{
+    auto     index = static_cast<uint32_t>(m_Handles.size());
+    uint32_t parentIndex = parent == INVALID_HANDLE ? INVALID_INDEX : m_Indices[parent];
+    uint32_t depth = parentIndex == INVALID_INDEX ? 0 : m_Depths[parentIndex] + 1;
+
+    Handle handle;
+    if (!m_FreeHandles.empty())
+    {
+        handle = m_FreeHandles.back();
+        m_FreeHandles.pop_back();
+        m_Indices[handle] = index;
+    } else
+    {
+        handle = static_cast<Handle>(m_Indices.size());
+        m_Indices.push_back(index);
+    }
+
+    m_PositionX.push_back(local.Position[0]);
+    m_PositionY.push_back(local.Position[1]);
+    m_PositionZ.push_back(local.Position[2]);
+    m_RotationX.push_back(local.Rotation[0]);
+    m_RotationY.push_back(local.Rotation[1]);
+    m_RotationZ.push_back(local.Rotation[2]);
+    m_RotationW.push_back(local.Rotation[3]);
+    m_ScaleX.push_back(local.Scale[0]);
+    m_ScaleY.push_back(local.Scale[1]);
+    m_ScaleZ.push_back(local.Scale[2]);
+    m_WorldMatrices.emplace_back();
+    m_Parents.push_back(parentIndex);
+    m_Depths.push_back(depth);
+    m_Dirty.push_back(1);
+    m_Removed.push_back(0);
+    m_Handles.push_back(handle);
+    m_AnyDirty = true;
+
+    // Nodes added to the deepest level, or a level below it, keep the arrays in order.
+    uint32_t numLevels = GetNumLevels();
+    if (!m_NeedsSort && depth + 1 == numLevels)
+    {
+        m_LevelStarts.back() = index + 1;
+    } else if (!m_NeedsSort && depth == numLevels)
+    {
+        m_LevelStarts.push_back(index + 1);
+    } else
+    {
+        m_NeedsSort = true;
+    }
+    return handle;
+}
+
+void TransformHierarchy::RemoveNode( Handle handle )
+{
+    m_Removed[m_Indices[handle]] = 1;
+    m_NeedsSort = true;
+}
+
+void TransformHierarchy::SetLocalTransform( Handle handle, const Transform &local )
+{
+    uint32_t index = m_Indices[handle];
+    m_PositionX[index] = local.Position[0];
+    m_PositionY[index] = local.Position[1];
+    m_PositionZ[index] = local.Position[2];
+    m_RotationX[index] = local.Rotation[0];
+    m_RotationY[index] = local.Rotation[1];
+    m_RotationZ[index] = local.Rotation[2];
+    m_RotationW[index] = local.Rotation[3];
+    m_ScaleX[index] = local.Scale[0];
+    m_ScaleY[index] = local.Scale[1];
+    m_ScaleZ[index] = local.Scale[2];
+    m_Dirty[index] = 1;
+    m_AnyDirty = true;
+}
+
+Transform TransformHierarchy::GetLocalTransform( Handle handle ) const
+{
+    uint32_t  index = m_Indices[handle];
+    Transform local;
+    local.Position[0] = m_PositionX[index];
+    local.Position[1] = m_PositionY[index];
+    local.Position[2] = m_PositionZ[index];
+    local.Rotation[0] = m_RotationX[index];
+    local.Rotation[1] = m_RotationY[index];
+    local.Rotation[2] = m_RotationZ[index];
+    local.Rotation[3] = m_RotationW[index];
+    local.Scale[0] = m_ScaleX[index];
+    local.Scale[1] = m_ScaleY[index];
+    local.Scale[2] = m_ScaleZ[index];
+    return local;
+}
+
+TransformHierarchy::Handle TransformHierarchy::GetParent( Handle handle ) const
+{
+    uint32_t parentIndex = m_Parents[m_Indices[handle]];
+    return parentIndex == INVALID_INDEX ? INVALID_HANDLE : m_Handles[parentIndex];
+}
+
+uint32_t TransformHierarchy::UpdateWorldMatrices( bool parallel )
+{
+    if (m_NeedsSort)
+    {
+        Sort();
+    }
+    if (!m_AnyDirty)
+    {
+        return 0;
+    }
+
+    for (uint32_t level = 0; level < GetNumLevels(); ++level)
+    {
+        uint32_t begin = m_LevelStarts[level];
+        uint32_t count = m_LevelStarts[level + 1] - begin;
+        if (parallel && count >= PARALLEL_LEVEL_SIZE)
+        {
+            Core::Threads::ThreadPool::Get().ParallelFor(count, NODES_PER_TASK, [&]( size_t first, size_t last )
+            {
+                UpdateRange(begin + static_cast<uint32_t>(first), begin + static_cast<uint32_t>(last));
+            });
+        } else
+        {
+            UpdateRange(begin, begin + count);
+        }
+    }
+
+    // Children read the flags of their parents during the pass, so they are only cleared once it is done.
+    auto numUpdated = static_cast<uint32_t>(std::count(m_Dirty.begin(), m_Dirty.end(), 1));
+    std::fill(m_Dirty.begin(), m_Dirty.end(), 0);
+    m_AnyDirty = false;
+    return numUpdated;
+}
+
+void TransformHierarchy::Sort()
+{
+    // Counting sort by depth, stable so siblings keep the order they were added in.
+    uint32_t numNodes = GetNumNodes();
+    uint32_t numLevels = 0;
+    for (uint32_t depth: m_Depths)
+    {
+        numLevels = std::max(numLevels, depth + 1);
+    }
+    std::vector<uint32_t> levelStarts(numLevels + 1, 0);
+    for (uint32_t depth: m_Depths)
+    {
+        ++levelStarts[depth + 1];
+    }
+    for (uint32_t level = 0; level < numLevels; ++level)
+    {
+        levelStarts[level + 1] += levelStarts[level];
+    }
+    std::vector<uint32_t> order(numNodes);
+    std::vector<uint32_t> next(levelStarts.begin(), levelStarts.end() - 1);
+    for (uint32_t i = 0; i < numNodes; ++i)
+    {
+        order[next[m_Depths[i]]++] = i;
+    }
+
+    // Parents come first in depth order, so removal reaches every descendant in one pass.
+    std::vector<uint32_t> newIndices(numNodes, INVALID_INDEX);
+    uint32_t              numKept = 0;
+    for (uint32_t i: order)
+    {
+        if (m_Parents[i] != INVALID_INDEX && m_Removed[m_Parents[i]])
+        {
+            m_Removed[i] = 1;
+        }
+        if (m_Removed[i])
+        {
+            m_Indices[m_Handles[i]] = INVALID_INDEX;
+            m_FreeHandles.push_back(m_Handles[i]);
+        } else
+        {
+            newIndices[i] = numKept++;
+        }
+    }
+
+    auto reorder = [&]( auto &values )
+    {
+        std::remove_reference_t<decltype(values)> sorted;
+        sorted.reserve(numKept);
+        for (uint32_t i: order)
+        {
+            if (newIndices[i] != INVALID_INDEX)
+            {
+                sorted.push_back(values[i]);
+            }
+        }
+        values.swap(sorted);
+    };
+    reorder(m_PositionX);
+    reorder(m_PositionY);
+    reorder(m_PositionZ);
+    reorder(m_RotationX);
+    reorder(m_RotationY);
+    reorder(m_RotationZ);
+    reorder(m_RotationW);
+    reorder(m_ScaleX);
+    reorder(m_ScaleY);
+    reorder(m_ScaleZ);
+    reorder(m_WorldMatrices);
+    reorder(m_Parents);
+    reorder(m_Depths);
+    reorder(m_Dirty);
+    reorder(m_Handles);
+    m_Removed.assign(numKept, 0);
+
+    m_LevelStarts.clear();
+    for (uint32_t i = 0; i < numKept; ++i)
+    {
+        if (m_Parents[i] != INVALID_INDEX)
+        {
+            m_Parents[i] = newIndices[m_Parents[i]];
+        }
+        m_Indices[m_Handles[i]] = i;
+        if (m_Depths[i] == m_LevelStarts.size())
+        {
+            m_LevelStarts.push_back(i);
+        }
+    }
+    m_LevelStarts.push_back(numKept);
+    m_NeedsSort = false;
+}
+
+void TransformHierarchy::UpdateRange( uint32_t first, uint32_t last )
+{
+    // Parents are on the previous level, whose flags and matrices are final.
+    auto inheritDirty = [this]( uint32_t index )
+    {
+        uint32_t parent = m_Parents[index];
+        if (parent != INVALID_INDEX)
+        {
+            m_Dirty[index] |= m_Dirty[parent];
+        }
+        return m_Dirty[index];
+    };
+
+    uint32_t index = first;
+    for (; index + 4 <= last; index += 4)
+    {
+        uint8_t dirty = inheritDirty(index) | inheritDirty(index + 1) | inheritDirty(index + 2) |
+                        inheritDirty(index + 3);
+        if (!dirty)
+        {
+            continue;
+        }
+
+        Matrix4x4 local[4];
+        ComputeLocalMatrices4(index, local);
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            if (m_Dirty[index + i])
+            {
+                ComputeWorldMatrix(index + i, local[i]);
+            }
+        }
+    }
+    for (; index < last; ++index)
+    {
+        if (inheritDirty(index))
+        {
+            Matrix4x4 local;
+            ComputeLocalMatrix(index, &local);
+            ComputeWorldMatrix(index, local);
+        }
+    }
+}
+
+void TransformHierarchy::ComputeLocalMatrix( uint32_t index, Matrix4x4* local ) const
+{
+    float x = m_RotationX[index];
+    float y = m_RotationY[index];
+    float z = m_RotationZ[index];
+    float w = m_RotationW[index];
+    float sx = m_ScaleX[index];
+    float sy = m_ScaleY[index];
+    float sz = m_ScaleZ[index];
+
+    // Scale, then rotate, then translate, as XMMatrixAffineTransformation would.
+    *local = {{
+        {(1.0f - 2.0f * (y * y + z * z)) * sx, 2.0f * (x * y + z * w) * sx, 2.0f * (x * z - y * w) * sx, 0.0f},
+        {2.0f * (x * y - z * w) * sy, (1.0f - 2.0f * (x * x + z * z)) * sy, 2.0f * (y * z + x * w) * sy, 0.0f},
+        {2.0f * (x * z + y * w) * sz, 2.0f * (y * z - x * w) * sz, (1.0f - 2.0f * (x * x + y * y)) * sz, 0.0f},
+        {m_PositionX[index], m_PositionY[index], m_PositionZ[index], 1.0f},
+    }};
+}
+
+void TransformHierarchy::ComputeLocalMatrices4( uint32_t index, Matrix4x4 local[4] ) const
+{
+    // One node per lane, transposed into a matrix per node at the end.
+    __m128 x = _mm_loadu_ps(&m_RotationX[index]);
+    __m128 y = _mm_loadu_ps(&m_RotationY[index]);
+    __m128 z = _mm_loadu_ps(&m_RotationZ[index]);
+    __m128 w = _mm_loadu_ps(&m_RotationW[index]);
+    __m128 x2 = _mm_add_ps(x, x);
+    __m128 y2 = _mm_add_ps(y, y);
+    __m128 z2 = _mm_add_ps(z, z);
+    __m128 xx = _mm_mul_ps(x, x2);
+    __m128 yy = _mm_mul_ps(y, y2);
+    __m128 zz = _mm_mul_ps(z, z2);
+    __m128 xy = _mm_mul_ps(x, y2);
+    __m128 xz = _mm_mul_ps(x, z2);
+    __m128 yz = _mm_mul_ps(y, z2);
+    __m128 wx = _mm_mul_ps(w, x2);
+    __m128 wy = _mm_mul_ps(w, y2);
+    __m128 wz = _mm_mul_ps(w, z2);
+
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128       sx = _mm_loadu_ps(&m_ScaleX[index]);
+    __m128       sy = _mm_loadu_ps(&m_ScaleY[index]);
+    __m128       sz = _mm_loadu_ps(&m_ScaleZ[index]);
+    __m128       rows[4][4] = {
+        {
+            _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx), _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+            _mm_mul_ps(_mm_sub_ps(xz, wy), sx), zero
+        },
+        {
+            _mm_mul_ps(_mm_sub_ps(xy, wz), sy), _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+            _mm_mul_ps(_mm_add_ps(yz, wx), sy), zero
+        },
+        {
+            _mm_mul_ps(_mm_add_ps(xz, wy), sz), _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+            _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz), zero
+        },
+        {
+            _mm_loadu_ps(&m_PositionX[index]), _mm_loadu_ps(&m_PositionY[index]),
+            _mm_loadu_ps(&m_PositionZ[index]), one
+        },
+    };
+
+    for (int row = 0; row < 4; ++row)
+    {
+        _MM_TRANSPOSE4_PS(rows[row][0], rows[row][1], rows[row][2], rows[row][3]);
+        for (int node = 0; node < 4; ++node)
+        {
+            _mm_store_ps(local[node].m[row], rows[row][node]);
+        }
+    }
+}
+
+void TransformHierarchy::ComputeWorldMatrix( uint32_t index, const Matrix4x4 &local )
+{
+    uint32_t parent = m_Parents[index];
+    if (parent == INVALID_INDEX)
+    {
+        m_WorldMatrices[index] = local;
+    } else
+    {
+        MultiplyMatrices(local, m_WorldMatrices[parent], &m_WorldMatrices[index]);
+    }
+}
+
+}
@@ -0,0 +1,129 @@
+#ifndef TRANSFORMHIERARCHY_H
+#define TRANSFORMHIERARCHY_H
+#include <cstdint>
+#include <vector>
+
+
+namespace Enterprise::Scene {
+
+// Row major matrix for row vectors, laid out like DirectX::XMFLOAT4X4, so world = local * parent world.
+struct alignas(16) Matrix4x4 {
+    float m[4][4];
+};
+
+struct Transform {
+    float Position[3] = {0.0f, 0.0f, 0.0f};
+    // Unit quaternion, x y z w.
+    float Rotation[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    float Scale[3] = {1.0f, 1.0f, 1.0f};
+};
+
+/**
+ * Local and world transforms of every node of a scene, stored as structures of arrays sorted by depth, so the
+ * parent of a node always comes before it and all nodes of a level are contiguous.
+ * UpdateWorldMatrices is one linear pass over the arrays, level by level, that builds the local matrices of
+ * four nodes at a time and multiplies them with their parent's world matrix. Nodes within a level do not depend
+ * on each other, so every level is split across the thread pool. Only nodes whose local transform, or one of
+ * whose ancestors' local transform, changed since the last update are recomputed.
+ * Nodes are referred to by handles that stay valid while the arrays are reordered.
+ */
+class TransformHierarchy {
+public:
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = UINT32_MAX;
+
+    TransformHierarchy();
+
+    /**
+     * Add a node below parent, or a root for INVALID_HANDLE. Nodes added below a level that already has nodes
+     * below it are sorted in on the next update.
+     */
+    Handle AddNode( Handle parent = INVALID_HANDLE, const Transform &local = {} );
+
+    /**
+     * Remove a node. Its descendants are removed with it on the next update.
+     */
+    void RemoveNode( Handle handle );
+
+    [[nodiscard]] bool IsValid( Handle handle ) const
+    {
+        return handle < m_Indices.size() && m_Indices[handle] != INVALID_INDEX;
+    }
+
+    void SetLocalTransform( Handle handle, const Transform &local );
+
+    [[nodiscard]] Transform GetLocalTransform( Handle handle ) const;
+
+    [[nodiscard]] Handle GetParent( Handle handle ) const;
+
+    /**
+     * World matrix as of the last UpdateWorldMatrices.
+     */
+    [[nodiscard]] const Matrix4x4 &GetWorldMatrix( Handle handle ) const
+    {
+        return m_WorldMatrices[m_Indices[handle]];
+    }
+
+    /**
+     * Recompute the world matrices of the nodes that changed, splitting each level across the thread pool when
+     * parallel is set. Returns the number of world matrices recomputed.
+     */
+    uint32_t UpdateWorldMatrices( bool parallel = true );
+
+    [[nodiscard]] uint32_t GetNumNodes() const { return static_cast<uint32_t>(m_Handles.size()); }
+
+    [[nodiscard]] uint32_t GetNumLevels() const { return static_cast<uint32_t>(m_LevelStarts.size() - 1); }
+
+    // World matrices in depth order, for walking every node, see GetNodeHandle.
+    [[nodiscard]] const Matrix4x4* GetWorldMatrices() const { return m_WorldMatrices.data(); }
+
+    [[nodiscard]] Handle GetNodeHandle( uint32_t index ) const { return m_Handles[index]; }
+
+private:
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    // Restore depth order and drop removed nodes and their descendants.
+    void Sort();
+
+    // Update the nodes [first, last) of a single level.
+    void UpdateRange( uint32_t first, uint32_t last );
+
+    // Local matrix of the node at index.
+    void ComputeLocalMatrix( uint32_t index, Matrix4x4* local ) const;
+
+    // Local matrices of the four nodes from index on.
+    void ComputeLocalMatrices4( uint32_t index, Matrix4x4 local[4] ) const;
+
+    void ComputeWorldMatrix( uint32_t index, const Matrix4x4 &local );
+
+    // Per node, in depth order.
+    std::vector<float>     m_PositionX;
+    std::vector<float>     m_PositionY;
+    std::vector<float>     m_PositionZ;
+    std::vector<float>     m_RotationX;
+    std::vector<float>     m_RotationY;
+    std::vector<float>     m_RotationZ;
+    std::vector<float>     m_RotationW;
+    std::vector<float>     m_ScaleX;
+    std::vector<float>     m_ScaleY;
+    std::vector<float>     m_ScaleZ;
+    std::vector<Matrix4x4> m_WorldMatrices;
+    // Index of the parent, INVALID_INDEX for roots.
+    std::vector<uint32_t>  m_Parents;
+    std::vector<uint32_t>  m_Depths;
+    std::vector<uint8_t>   m_Dirty;
+    std::vector<uint8_t>   m_Removed;
+    std::vector<Handle>    m_Handles;
+
+    // Per handle, the index of the node.
+    std::vector<uint32_t> m_Indices;
+    std::vector<Handle>   m_FreeHandles;
+    // First node of every level, followed by the number of nodes.
+    std::vector<uint32_t> m_LevelStarts;
+    bool                  m_NeedsSort;
+    bool                  m_AnyDirty;
+};
+
+}
+
+#endif //TRANSFORMHIERARCHY_H
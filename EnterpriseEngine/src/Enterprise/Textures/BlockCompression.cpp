@@ -0,0 +1,1397 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <emmintrin.h>
+#include <iterator>
+
+namespace Enterprise::Textures {
+
+namespace {
+
+constexpr uint32_t FULL_MASK = 0xFFFF;
+
+// Texels of a block split by channel, so the palette search can handle four texels per register.
+struct BlockTexels {
+    alignas(16) float Channels[4][16];
+};
+
+void LoadBlock( const uint8_t texels[64], BlockTexels* block )
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            block->Channels[c][i] = texels[i * 4 + c];
+        }
+    }
+}
+
+float Clamp255( float value )
+{
+    return std::min(std::max(value, 0.0f), 255.0f);
+}
+
+/**
+ * Find the closest palette entry for every texel in mask, weighing the squared difference of each channel.
+ * Texels outside mask keep their index. Returns the summed error of the texels in mask.
+ */
+float FindClosestIndices( const BlockTexels &block, const float (*palette)[4], uint32_t numEntries,
+                          const float weights[4], uint32_t mask, uint8_t indices[16] )
+{
+    const __m128 weightR = _mm_set1_ps(weights[0]);
+    const __m128 weightG = _mm_set1_ps(weights[1]);
+    const __m128 weightB = _mm_set1_ps(weights[2]);
+    const __m128 weightA = _mm_set1_ps(weights[3]);
+
+    float error = 0.0f;
+    for (int group = 0; group < 16; group += 4)
+    {
+        if (((mask >> group) & 0xF) == 0)
+        {
+            continue;
+        }
+
+        __m128 r = _mm_load_ps(&block.Channels[0][group]);
+        __m128 g = _mm_load_ps(&block.Channels[1][group]);
+        __m128 b = _mm_load_ps(&block.Channels[2][group]);
+        __m128 a = _mm_load_ps(&block.Channels[3][group]);
+
+        __m128  bestError = _mm_set1_ps(FLT_MAX);
+        __m128i bestIndex = _mm_setzero_si128();
+        for (uint32_t i = 0; i < numEntries; ++i)
+        {
+            __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[i][0]));
+            __m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[i][1]));
+            __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[i][2]));
+            __m128 da = _mm_sub_ps(a, _mm_set1_ps(palette[i][3]));
+            __m128 entryError = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_mul_ps(dr, dr), weightR), _mm_mul_ps(_mm_mul_ps(dg, dg), weightG)),
+                _mm_add_ps(_mm_mul_ps(_mm_mul_ps(db, db), weightB), _mm_mul_ps(_mm_mul_ps(da, da), weightA)));
+
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(entryError, bestError));
+            bestError = _mm_min_ps(entryError, bestError);
+            bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(int32_t(i))),
+                                     _mm_andnot_si128(closer, bestIndex));
+        }
+
+        alignas(16) float   errors[4];
+        alignas(16) int32_t lanes[4];
+        _mm_store_ps(errors, bestError);
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), bestIndex);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            if (mask & (1u << (group + lane)))
+            {
+                indices[group + lane] = static_cast<uint8_t>(lanes[lane]);
+                error += errors[lane];
+            }
+        }
+    }
+    return error;
+}
+
+/**
+ * Least squares fit of the two endpoints for fixed indices, where index i lies indexWeights[i] of the way
+ * from the first endpoint to the second. Returns false when every texel in mask uses the same weight.
+ */
+bool FitEndpoints( const BlockTexels &block, const uint8_t indices[16], const float* indexWeights, uint32_t mask,
+                   float first[4], float second[4] )
+{
+    float alpha2 = 0.0f;
+    float beta2 = 0.0f;
+    float alphaBeta = 0.0f;
+    float alphaX[4] = {};
+    float betaX[4] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        if ((mask & (1u << i)) == 0)
+        {
+            continue;
+        }
+
+        float beta = indexWeights[indices[i]];
+        float alpha = 1.0f - beta;
+        alpha2 += alpha * alpha;
+        beta2 += beta * beta;
+        alphaBeta += alpha * beta;
+        for (int c = 0; c < 4; ++c)
+        {
+            alphaX[c] += alpha * block.Channels[c][i];
+            betaX[c] += beta * block.Channels[c][i];
+        }
+    }
+
+    float determinant = alpha2 * beta2 - alphaBeta * alphaBeta;
+    if (std::fabs(determinant) < 1e-6f)
+    {
+        return false;
+    }
+
+    float inverse = 1.0f / determinant;
+    for (int c = 0; c < 4; ++c)
+    {
+        first[c] = Clamp255((alphaX[c] * beta2 - betaX[c] * alphaBeta) * inverse);
+        second[c] = Clamp255((betaX[c] * alpha2 - alphaX[c] * alphaBeta) * inverse);
+    }
+    return true;
+}
+
+// Mean and dominant eigenvector of the covariance of the texels in mask, over the first numChannels channels.
+// Returns the squared distance of the texels to the line through the mean along the axis.
+float FindPrincipalAxis( const BlockTexels &block, uint32_t mask, int numChannels, float mean[4], float axis[4] )
+{
+    int count = 0;
+    for (int c = 0; c < 4; ++c)
+    {
+        mean[c] = 0.0f;
+        axis[c] = 0.0f;
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        if (mask & (1u << i))
+        {
+            for (int c = 0; c < numChannels; ++c)
+            {
+                mean[c] += block.Channels[c][i];
+            }
+            ++count;
+        }
+    }
+    if (count == 0)
+    {
+        return 0.0f;
+    }
+    for (int c = 0; c < numChannels; ++c)
+    {
+        mean[c] /= float(count);
+    }
+
+    float covariance[4][4] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        if ((mask & (1u << i)) == 0)
+        {
+            continue;
+        }
+        for (int c0 = 0; c0 < numChannels; ++c0)
+        {
+            for (int c1 = c0; c1 < numChannels; ++c1)
+            {
+                covariance[c0][c1] += (block.Channels[c0][i] - mean[c0]) * (block.Channels[c1][i] - mean[c1]);
+            }
+        }
+    }
+
+    float variance = 0.0f;
+    int   widest = 0;
+    for (int c0 = 0; c0 < numChannels; ++c0)
+    {
+        variance += covariance[c0][c0];
+        if (covariance[c0][c0] > covariance[widest][widest])
+        {
+            widest = c0;
+        }
+        for (int c1 = 0; c1 < c0; ++c1)
+        {
+            covariance[c0][c1] = covariance[c1][c0];
+        }
+    }
+    if (variance < 1e-4f)
+    {
+        return 0.0f;
+    }
+
+    // Power iteration, starting from the covariance row of the widest channel.
+    for (int c = 0; c < numChannels; ++c)
+    {
+        axis[c] = covariance[widest][c];
+    }
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[4] = {};
+        float largest = 0.0f;
+        for (int c0 = 0; c0 < numChannels; ++c0)
+        {
+            for (int c1 = 0; c1 < numChannels; ++c1)
+            {
+                next[c0] += covariance[c0][c1] * axis[c1];
+            }
+            largest = std::max(largest, std::fabs(next[c0]));
+        }
+        if (largest == 0.0f)
+        {
+            break;
+        }
+        for (int c = 0; c < numChannels; ++c)
+        {
+            axis[c] = next[c] / largest;
+        }
+    }
+
+    float length = 0.0f;
+    for (int c = 0; c < numChannels; ++c)
+    {
+        length += axis[c] * axis[c];
+    }
+    if (length < 1e-12f)
+    {
+        return 0.0f;
+    }
+    length = std::sqrt(length);
+    for (int c = 0; c < numChannels; ++c)
+    {
+        axis[c] /= length;
+    }
+
+    // Variance along the axis is its Rayleigh quotient, the rest is off the line.
+    float alongAxis = 0.0f;
+    for (int c0 = 0; c0 < numChannels; ++c0)
+    {
+        for (int c1 = 0; c1 < numChannels; ++c1)
+        {
+            alongAxis += axis[c0] * covariance[c0][c1] * axis[c1];
+        }
+    }
+    return std::max(variance - alongAxis, 0.0f);
+}
+
+// Endpoints at the extremes of the texels in mask projected on their principal axis.
+void FindPrincipalEndpoints( const BlockTexels &block, uint32_t mask, int numChannels, float first[4],
+                             float second[4] )
+{
+    float mean[4];
+    float axis[4];
+    FindPrincipalAxis(block, mask, numChannels, mean, axis);
+
+    float minimum = FLT_MAX;
+    float maximum = -FLT_MAX;
+    for (int i = 0; i < 16; ++i)
+    {
+        if ((mask & (1u << i)) == 0)
+        {
+            continue;
+        }
+        float t = 0.0f;
+        for (int c = 0; c < numChannels; ++c)
+        {
+            t += (block.Channels[c][i] - mean[c]) * axis[c];
+        }
+        minimum = std::min(minimum, t);
+        maximum = std::max(maximum, t);
+    }
+    if (minimum > maximum)
+    {
+        minimum = maximum = 0.0f;
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        first[c] = c < numChannels ? Clamp255(mean[c] + axis[c] * minimum) : 255.0f;
+        second[c] = c < numChannels ? Clamp255(mean[c] + axis[c] * maximum) : 255.0f;
+    }
+}
+
+// Corners of the bounding box of the texels in mask, inset a little since the extremes are rarely hit exactly.
+// Channels that fall while the widest one rises are flipped so the diagonal follows the texels.
+void FindBoundingBoxEndpoints( const BlockTexels &block, uint32_t mask, int numChannels, float first[4],
+                               float second[4] )
+{
+    float minimum[4] = {FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX};
+    float maximum[4] = {-FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX};
+    float mean[4] = {};
+    int   count = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        if (mask & (1u << i))
+        {
+            for (int c = 0; c < numChannels; ++c)
+            {
+                minimum[c] = std::min(minimum[c], block.Channels[c][i]);
+                maximum[c] = std::max(maximum[c], block.Channels[c][i]);
+                mean[c] += block.Channels[c][i];
+            }
+            ++count;
+        }
+    }
+
+    int widest = 0;
+    for (int c = 0; c < numChannels; ++c)
+    {
+        mean[c] /= float(std::max(count, 1));
+        if (maximum[c] - minimum[c] > maximum[widest] - minimum[widest])
+        {
+            widest = c;
+        }
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        if (c >= numChannels || count == 0)
+        {
+            first[c] = second[c] = 255.0f;
+            continue;
+        }
+
+        float inset = (maximum[c] - minimum[c]) / 16.0f;
+        first[c] = minimum[c] + inset;
+        second[c] = maximum[c] - inset;
+
+        float correlation = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            if (mask & (1u << i))
+            {
+                correlation += (block.Channels[c][i] - mean[c]) * (block.Channels[widest][i] - mean[widest]);
+            }
+        }
+        if (correlation < 0.0f)
+        {
+            std::swap(first[c], second[c]);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------|
+// BC1 color blocks                                                                            |
+//---------------------------------------------------------------------------------------------|
+
+uint16_t PackColor565( const float color[4] )
+{
+    auto r = static_cast<uint32_t>(color[0] * (31.0f / 255.0f) + 0.5f);
+    auto g = static_cast<uint32_t>(color[1] * (63.0f / 255.0f) + 0.5f);
+    auto b = static_cast<uint32_t>(color[2] * (31.0f / 255.0f) + 0.5f);
+    return static_cast<uint16_t>((std::min(r, 31u) << 11) | (std::min(g, 63u) << 5) | std::min(b, 31u));
+}
+
+void UnpackColor565( uint16_t packed, int color[3] )
+{
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// Palette as decoded, in index order. Three color blocks use index 3 for transparent black.
+void BuildColorPalette( uint16_t color0, uint16_t color1, bool threeColor, int palette[4][4] )
+{
+    int first[3];
+    int second[3];
+    UnpackColor565(color0, first);
+    UnpackColor565(color1, second);
+    for (int c = 0; c < 3; ++c)
+    {
+        palette[0][c] = first[c];
+        palette[1][c] = second[c];
+        if (threeColor)
+        {
+            palette[2][c] = (first[c] + second[c] + 1) / 2;
+            palette[3][c] = 0;
+        } else
+        {
+            palette[2][c] = (2 * first[c] + second[c] + 1) / 3;
+            palette[3][c] = (first[c] + 2 * second[c] + 1) / 3;
+        }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = threeColor ? 0 : 255;
+}
+
+struct ColorBlock {
+    uint16_t Color0;
+    uint16_t Color1;
+    uint8_t  Indices[16];
+    float    Error;
+};
+
+// Quantize a pair of endpoints and pick the indices of the texels in opaqueMask.
+ColorBlock EvaluateColorBlock( const BlockTexels &block, const float first[4], const float second[4],
+                               bool               threeColor, uint32_t opaqueMask )
+{
+    static constexpr float weights[4] = {1.0f, 1.0f, 1.0f, 0.0f};
+
+    ColorBlock result{};
+    result.Color0 = PackColor565(first);
+    result.Color1 = PackColor565(second);
+    // The decoder picks four colors when color0 > color1 and three colors plus transparent otherwise.
+    if (threeColor ? result.Color0 > result.Color1 : result.Color0 < result.Color1)
+    {
+        std::swap(result.Color0, result.Color1);
+    }
+
+    int palette[4][4];
+    BuildColorPalette(result.Color0, result.Color1, threeColor, palette);
+    float paletteFloat[4][4];
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            paletteFloat[i][c] = float(palette[i][c]);
+        }
+    }
+
+    // Equal endpoints cannot signal four colors, so stick to the first one, which means the same in both modes.
+    uint32_t numEntries = threeColor ? 3 : (result.Color0 == result.Color1 ? 1 : 4);
+    std::fill(std::begin(result.Indices), std::end(result.Indices), uint8_t(3));
+    result.Error = FindClosestIndices(block, paletteFloat, numEntries, weights, opaqueMask, result.Indices);
+    return result;
+}
+
+/**
+ * Encode the color of the texels in opaqueMask as a BC1 block. Texels outside it are transparent, which
+ * forces the three color mode. BC3 color blocks always pass a full mask.
+ */
+void EncodeColorBlock( const BlockTexels &block, CompressionQuality quality, uint32_t opaqueMask, uint8_t* destination )
+{
+    static constexpr float fourColorWeights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+    static constexpr float threeColorWeights[3] = {0.0f, 1.0f, 0.5f};
+
+    bool       threeColor = opaqueMask != FULL_MASK;
+    ColorBlock best{};
+    if (opaqueMask == 0)
+    {
+        best.Color0 = best.Color1 = 0;
+        std::fill(std::begin(best.Indices), std::end(best.Indices), uint8_t(3));
+    } else
+    {
+        float first[4];
+        float second[4];
+        if (quality == CompressionQuality::Fast)
+        {
+            FindBoundingBoxEndpoints(block, opaqueMask, 3, first, second);
+        } else
+        {
+            FindPrincipalEndpoints(block, opaqueMask, 3, first, second);
+        }
+        best = EvaluateColorBlock(block, first, second, threeColor, opaqueMask);
+
+        if (quality == CompressionQuality::High)
+        {
+            FindBoundingBoxEndpoints(block, opaqueMask, 3, first, second);
+            ColorBlock candidate = EvaluateColorBlock(block, first, second, threeColor, opaqueMask);
+            if (candidate.Error < best.Error)
+            {
+                best = candidate;
+            }
+        }
+
+        int numRefinements = quality == CompressionQuality::Fast ? 0 : (quality == CompressionQuality::Normal ? 2 : 8);
+        for (int refinement = 0; refinement < numRefinements && best.Error > 0.0f; ++refinement)
+        {
+            if (!FitEndpoints(block, best.Indices, threeColor ? threeColorWeights : fourColorWeights, opaqueMask,
+                              first, second))
+            {
+                break;
+            }
+            ColorBlock candidate = EvaluateColorBlock(block, first, second, threeColor, opaqueMask);
+            if (candidate.Error >= best.Error)
+            {
+                break;
+            }
+            best = candidate;
+        }
+    }
+
+    uint32_t indices = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        indices |= uint32_t(best.Indices[i] & 3) << (i * 2);
+    }
+    destination[0] = static_cast<uint8_t>(best.Color0);
+    destination[1] = static_cast<uint8_t>(best.Color0 >> 8);
+    destination[2] = static_cast<uint8_t>(best.Color1);
+    destination[3] = static_cast<uint8_t>(best.Color1 >> 8);
+    std::memcpy(destination + 4, &indices, sizeof(indices));
+}
+
+void DecodeColorBlock( const uint8_t* source, bool allowThreeColor, uint8_t texels[64] )
+{
+    uint16_t color0 = uint16_t(source[0] | (source[1] << 8));
+    uint16_t color1 = uint16_t(source[2] | (source[3] << 8));
+    uint32_t indices;
+    std::memcpy(&indices, source + 4, sizeof(indices));
+
+    int palette[4][4];
+    BuildColorPalette(color0, color1, allowThreeColor && color0 <= color1, palette);
+    for (int i = 0; i < 16; ++i)
+    {
+        const int* color = palette[(indices >> (i * 2)) & 3];
+        for (int c = 0; c < 4; ++c)
+        {
+            texels[i * 4 + c] = static_cast<uint8_t>(color[c]);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------------|
+// BC4 single channel blocks, also used for BC3 alpha and both halves of BC5                   |
+//---------------------------------------------------------------------------------------------|
+
+// Palette as decoded. Eight values when value0 > value1, otherwise six plus 0 and 255.
+void BuildChannelPalette( int value0, int value1, int palette[8] )
+{
+    palette[0] = value0;
+    palette[1] = value1;
+    if (value0 > value1)
+    {
+        for (int i = 1; i < 7; ++i)
+        {
+            palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+        }
+    } else
+    {
+        for (int i = 1; i < 5; ++i)
+        {
+            palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+struct ChannelBlock {
+    uint8_t Value0;
+    uint8_t Value1;
+    uint8_t Indices[16];
+    float   Error;
+};
+
+ChannelBlock EvaluateChannelBlock( const BlockTexels &channel, float first, float second, bool sixValues )
+{
+    static constexpr float weights[4] = {1.0f, 0.0f, 0.0f, 0.0f};
+
+    auto value0 = static_cast<int>(Clamp255(first) + 0.5f);
+    auto value1 = static_cast<int>(Clamp255(second) + 0.5f);
+    if (sixValues ? value0 > value1 : value0 < value1)
+    {
+        std::swap(value0, value1);
+    }
+
+    int palette[8];
+    BuildChannelPalette(value0, value1, palette);
+    float paletteFloat[8][4] = {};
+    for (int i = 0; i < 8; ++i)
+    {
+        paletteFloat[i][0] = float(palette[i]);
+    }
+
+    ChannelBlock result{};
+    result.Value0 = static_cast<uint8_t>(value0);
+    result.Value1 = static_cast<uint8_t>(value1);
+    // Equal values decode as the six value mode, where only the first index is safe to interpolate.
+    uint32_t numEntries = value0 == value1 && !sixValues ? 1 : 8;
+    result.Error = FindClosestIndices(channel, paletteFloat, numEntries, weights, FULL_MASK, result.Indices);
+    return result;
+}
+
+// Encode one channel of the block as a BC4 block.
+void EncodeChannelBlock( const BlockTexels &block, int channelIndex, CompressionQuality quality, uint8_t* destination )
+{
+    static constexpr float eightValueWeights[8] = {
+        0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f
+    };
+
+    // Move the channel to red so the palette search only looks at one channel.
+    BlockTexels channel{};
+    std::memcpy(channel.Channels[0], block.Channels[channelIndex], sizeof(channel.Channels[0]));
+
+    float minimum = *std::min_element(channel.Channels[0], channel.Channels[0] + 16);
+    float maximum = *std::max_element(channel.Channels[0], channel.Channels[0] + 16);
+
+    ChannelBlock best = EvaluateChannelBlock(channel, maximum, minimum, false);
+    if (quality != CompressionQuality::Fast)
+    {
+        int numRefinements = quality == CompressionQuality::Normal ? 2 : 6;
+        for (int refinement = 0; refinement < numRefinements && best.Error > 0.0f; ++refinement)
+        {
+            float first[4];
+            float second[4];
+            if (!FitEndpoints(channel, best.Indices, eightValueWeights, FULL_MASK, first, second))
+            {
+                break;
+            }
+            ChannelBlock candidate = EvaluateChannelBlock(channel, first[0], second[0], false);
+            if (candidate.Error >= best.Error)
+            {
+                break;
+            }
+            best = candidate;
+        }
+    }
+    if (quality == CompressionQuality::High && best.Error > 0.0f)
+    {
+        // Blocks reaching 0 or 255 may do better with the six value mode, which has both as extra entries.
+        float innerMinimum = 255.0f;
+        float innerMaximum = 0.0f;
+        for (float value: channel.Channels[0])
+        {
+            if (value > 0.0f && value < 255.0f)
+            {
+                innerMinimum = std::min(innerMinimum, value);
+                innerMaximum = std::max(innerMaximum, value);
+            }
+        }
+        if (innerMinimum <= innerMaximum)
+        {
+            ChannelBlock candidate = EvaluateChannelBlock(channel, innerMinimum, innerMaximum, true);
+            if (candidate.Error < best.Error)
+            {
+                best = candidate;
+            }
+        }
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        indices |= uint64_t(best.Indices[i] & 7) << (i * 3);
+    }
+    destination[0] = best.Value0;
+    destination[1] = best.Value1;
+    for (int i = 0; i < 6; ++i)
+    {
+        destination[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+}
+
+void DecodeChannelBlock( const uint8_t* source, uint8_t texels[64], int channel )
+{
+    int palette[8];
+    BuildChannelPalette(source[0], source[1], palette);
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i)
+    {
+        indices |= uint64_t(source[2 + i]) << (i * 8);
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        texels[i * 4 + channel] = static_cast<uint8_t>(palette[(indices >> (i * 3)) & 7]);
+    }
+}
+
+//---------------------------------------------------------------------------------------------|
+// BC7                                                                                         |
+//---------------------------------------------------------------------------------------------|
+// Only two of the eight modes are written:                                                    |
+// mode 6, one subset of RGBA 7.7.7.7 endpoints with a p-bit each and 4-bit indices, and      |
+// mode 1, two subsets of RGB 6.6.6 endpoints with a shared p-bit each and 3-bit indices,     |
+// tried for opaque blocks that a single line through color space fits poorly.                 |
+//---------------------------------------------------------------------------------------------|
+
+constexpr int BC7_WEIGHTS3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+constexpr int BC7_WEIGHTS4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// Two subset partitions; bit i set puts texel i in the second subset.
+constexpr uint16_t BC7_PARTITIONS2[64] = {
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+    0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+    0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+    0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+    0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+    0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+    0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+    0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+// Texel whose index drops its top bit in the second subset. The first subset's anchor is always texel 0.
+constexpr uint8_t BC7_ANCHORS2[64] = {
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+    15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+    6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+};
+
+class BitWriter {
+public:
+    explicit BitWriter( uint8_t* destination )
+        : m_Destination(destination)
+        , m_Position(0)
+    {
+        std::memset(m_Destination, 0, 16);
+    }
+
+    void Write( uint32_t value, uint32_t numBits )
+    {
+        for (uint32_t i = 0; i < numBits; ++i, ++m_Position)
+        {
+            m_Destination[m_Position >> 3] |= uint8_t(((value >> i) & 1) << (m_Position & 7));
+        }
+    }
+
+private:
+    uint8_t* m_Destination;
+    uint32_t m_Position;
+};
+
+class BitReader {
+public:
+    explicit BitReader( const uint8_t* source )
+        : m_Source(source)
+        , m_Position(0)
+    {}
+
+    uint32_t Read( uint32_t numBits )
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < numBits; ++i, ++m_Position)
+        {
+            value |= uint32_t((m_Source[m_Position >> 3] >> (m_Position & 7)) & 1) << i;
+        }
+        return value;
+    }
+
+private:
+    const uint8_t* m_Source;
+    uint32_t       m_Position;
+};
+
+int InterpolateBC7( int first, int second, int weight )
+{
+    return ((64 - weight) * first + weight * second + 32) >> 6;
+}
+
+// Endpoint channel of numBits bits followed by a p-bit, expanded to 8 bits.
+int UnquantizeBC7( int value, int pBit, int numBits )
+{
+    int expanded = (value << 1) | pBit;
+    int bits = numBits + 1;
+    return (expanded << (8 - bits)) | (expanded >> (2 * bits - 8));
+}
+
+int QuantizeBC7( float value, int pBit, int numBits )
+{
+    // Search the two codes around the target, the expansion is not quite linear.
+    int maximum = (1 << numBits) - 1;
+    int code = static_cast<int>((value / 255.0f) * float(maximum));
+    int best = code;
+    int bestError = INT32_MAX;
+    for (int candidate = std::max(code - 1, 0); candidate <= std::min(code + 1, maximum); ++candidate)
+    {
+        int error = std::abs(UnquantizeBC7(candidate, pBit, numBits) - static_cast<int>(value + 0.5f));
+        if (error < bestError)
+        {
+            bestError = error;
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+struct BC7Endpoints {
+    // Quantized endpoint codes, without the p-bit.
+    int Codes[2][4];
+    int PBits[2];
+};
+
+struct BC7Subset {
+    BC7Endpoints Endpoints;
+    float        Error;
+};
+
+// Quantize endpoints for a subset and pick its indices. sharedPBit is set for mode 1, where both endpoints
+// share a p-bit. Tries the p-bits allowed by quality and keeps the best.
+BC7Subset EvaluateBC7Subset( const BlockTexels &block, const float first[4], const float second[4], int numBits,
+                             int                numChannels, const int* indexWeights, uint32_t numIndices,
+                             bool               sharedPBit, bool searchPBits, uint32_t mask, uint8_t indices[16] )
+{
+    static constexpr float weights[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+
+    // Per endpoint p-bit choices to evaluate, as bit 0 for the first endpoint and bit 1 for the second.
+    int pBitCombinations[4];
+    int numCombinations = 0;
+    if (sharedPBit)
+    {
+        pBitCombinations[numCombinations++] = 0;
+        pBitCombinations[numCombinations++] = 3;
+    } else if (searchPBits)
+    {
+        for (int combination = 0; combination < 4; ++combination)
+        {
+            pBitCombinations[numCombinations++] = combination;
+        }
+    } else
+    {
+        // Pick the p-bit of each endpoint that best matches its own channels.
+        int combination = 0;
+        const float* endpoints[2] = {first, second};
+        for (int e = 0; e < 2; ++e)
+        {
+            int errors[2] = {};
+            for (int pBit = 0; pBit < 2; ++pBit)
+            {
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    int value = UnquantizeBC7(QuantizeBC7(endpoints[e][c], pBit, numBits), pBit, numBits);
+                    errors[pBit] += std::abs(value - static_cast<int>(endpoints[e][c] + 0.5f));
+                }
+            }
+            combination |= (errors[1] < errors[0] ? 1 : 0) << e;
+        }
+        pBitCombinations[numCombinations++] = combination;
+    }
+
+    BC7Subset best{};
+    best.Error = FLT_MAX;
+    uint8_t candidateIndices[16];
+    for (int i = 0; i < numCombinations; ++i)
+    {
+        BC7Subset candidate{};
+        const float* endpoints[2] = {first, second};
+        int          unquantized[2][4];
+        for (int e = 0; e < 2; ++e)
+        {
+            candidate.Endpoints.PBits[e] = (pBitCombinations[i] >> e) & 1;
+            for (int c = 0; c < 4; ++c)
+            {
+                if (c < numChannels)
+                {
+                    candidate.Endpoints.Codes[e][c] = QuantizeBC7(endpoints[e][c], candidate.Endpoints.PBits[e],
+                                                                  numBits);
+                    unquantized[e][c] = UnquantizeBC7(candidate.Endpoints.Codes[e][c], candidate.Endpoints.PBits[e],
+                                                      numBits);
+                } else
+                {
+                    candidate.Endpoints.Codes[e][c] = 0;
+                    unquantized[e][c] = 255;
+                }
+            }
+        }
+
+        float palette[16][4];
+        for (uint32_t index = 0; index < numIndices; ++index)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                palette[index][c] = float(InterpolateBC7(unquantized[0][c], unquantized[1][c], indexWeights[index]));
+            }
+        }
+        std::memcpy(candidateIndices, indices, sizeof(candidateIndices));
+        candidate.Error = FindClosestIndices(block, palette, numIndices, weights, mask, candidateIndices);
+        if (candidate.Error < best.Error)
+        {
+            best = candidate;
+            std::memcpy(indices, candidateIndices, sizeof(candidateIndices));
+        }
+    }
+    return best;
+}
+
+// Fit, quantize and refine the endpoints of one subset.
+BC7Subset EncodeBC7Subset( const BlockTexels &block, CompressionQuality quality, int numBits, int numChannels,
+                           const int*         indexWeights, uint32_t numIndices, bool sharedPBit, uint32_t mask,
+                           uint8_t            indices[16] )
+{
+    float first[4];
+    float second[4];
+    if (quality == CompressionQuality::Fast)
+    {
+        FindBoundingBoxEndpoints(block, mask, numChannels, first, second);
+    } else
+    {
+        FindPrincipalEndpoints(block, mask, numChannels, first, second);
+    }
+
+    bool      searchPBits = quality == CompressionQuality::High;
+    BC7Subset best = EvaluateBC7Subset(block, first, second, numBits, numChannels, indexWeights, numIndices,
+                                       sharedPBit, searchPBits, mask, indices);
+
+    float fitWeights[16];
+    for (uint32_t i = 0; i < numIndices; ++i)
+    {
+        fitWeights[i] = float(indexWeights[i]) / 64.0f;
+    }
+
+    int numRefinements = quality == CompressionQuality::Fast ? 1 : (quality == CompressionQuality::Normal ? 2 : 4);
+    for (int refinement = 0; refinement < numRefinements && best.Error > 0.0f; ++refinement)
+    {
+        if (!FitEndpoints(block, indices, fitWeights, mask, first, second))
+        {
+            break;
+        }
+        uint8_t   candidateIndices[16];
+        std::memcpy(candidateIndices, indices, sizeof(candidateIndices));
+        BC7Subset candidate = EvaluateBC7Subset(block, first, second, numBits, numChannels, indexWeights, numIndices,
+                                                sharedPBit, searchPBits, mask, candidateIndices);
+        if (candidate.Error >= best.Error)
+        {
+            break;
+        }
+        best = candidate;
+        std::memcpy(indices, candidateIndices, sizeof(candidateIndices));
+    }
+    return best;
+}
+
+// Swap the endpoints of a subset if its anchor index has the top bit set, which the format leaves implicit.
+void FixAnchor( BC7Endpoints* endpoints, uint8_t indices[16], uint32_t mask, int anchor, uint32_t numIndices )
+{
+    if (indices[anchor] < numIndices / 2)
+    {
+        return;
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        std::swap(endpoints->Codes[0][c], endpoints->Codes[1][c]);
+    }
+    std::swap(endpoints->PBits[0], endpoints->PBits[1]);
+    for (int i = 0; i < 16; ++i)
+    {
+        if (mask & (1u << i))
+        {
+            indices[i] = static_cast<uint8_t>(numIndices - 1 - indices[i]);
+        }
+    }
+}
+
+struct BC7Block {
+    uint8_t Data[16];
+    float   Error;
+};
+
+BC7Block EncodeBC7Mode6( const BlockTexels &block, CompressionQuality quality )
+{
+    uint8_t   indices[16] = {};
+    BC7Subset subset = EncodeBC7Subset(block, quality, 7, 4, BC7_WEIGHTS4, 16, false, FULL_MASK, indices);
+    FixAnchor(&subset.Endpoints, indices, FULL_MASK, 0, 16);
+
+    BC7Block  result{};
+    result.Error = subset.Error;
+    BitWriter writer(result.Data);
+    writer.Write(1u << 6, 7);
+    for (int c = 0; c < 4; ++c)
+    {
+        writer.Write(subset.Endpoints.Codes[0][c], 7);
+        writer.Write(subset.Endpoints.Codes[1][c], 7);
+    }
+    writer.Write(subset.Endpoints.PBits[0], 1);
+    writer.Write(subset.Endpoints.PBits[1], 1);
+    for (int i = 0; i < 16; ++i)
+    {
+        writer.Write(indices[i], i == 0 ? 3 : 4);
+    }
+    return result;
+}
+
+// Sums over the RGB of a set of texels, enough to get their covariance without another pass over the texels.
+struct TexelMoments {
+    float Count = 0.0f;
+    float Sum[3] = {};
+    // rr, rg, rb, gg, gb, bb
+    float Products[6] = {};
+
+    void Add( const BlockTexels &block, int texel )
+    {
+        float r = block.Channels[0][texel];
+        float g = block.Channels[1][texel];
+        float b = block.Channels[2][texel];
+        Count += 1.0f;
+        Sum[0] += r;
+        Sum[1] += g;
+        Sum[2] += b;
+        Products[0] += r * r;
+        Products[1] += r * g;
+        Products[2] += r * b;
+        Products[3] += g * g;
+        Products[4] += g * b;
+        Products[5] += b * b;
+    }
+
+    TexelMoments operator-( const TexelMoments &other ) const
+    {
+        TexelMoments result;
+        result.Count = Count - other.Count;
+        for (int i = 0; i < 3; ++i)
+        {
+            result.Sum[i] = Sum[i] - other.Sum[i];
+        }
+        for (int i = 0; i < 6; ++i)
+        {
+            result.Products[i] = Products[i] - other.Products[i];
+        }
+        return result;
+    }
+
+    // Squared distance of the texels to their best fitting line, the same as FindPrincipalAxis returns.
+    [[nodiscard]] float GetLineError() const
+    {
+        if (Count == 0.0f)
+        {
+            return 0.0f;
+        }
+
+        float inverseCount = 1.0f / Count;
+        float c[6];
+        c[0] = Products[0] - Sum[0] * Sum[0] * inverseCount;
+        c[1] = Products[1] - Sum[0] * Sum[1] * inverseCount;
+        c[2] = Products[2] - Sum[0] * Sum[2] * inverseCount;
+        c[3] = Products[3] - Sum[1] * Sum[1] * inverseCount;
+        c[4] = Products[4] - Sum[1] * Sum[2] * inverseCount;
+        c[5] = Products[5] - Sum[2] * Sum[2] * inverseCount;
+
+        float variance = c[0] + c[3] + c[5];
+        if (variance < 1e-4f)
+        {
+            return 0.0f;
+        }
+
+        float axis[3] = {1.0f, 1.0f, 1.0f};
+        float axisLength2 = 3.0f;
+        float rayleigh = 0.0f;
+        for (int iteration = 0; iteration < 4; ++iteration)
+        {
+            float next[3] = {
+                c[0] * axis[0] + c[1] * axis[1] + c[2] * axis[2],
+                c[1] * axis[0] + c[3] * axis[1] + c[4] * axis[2],
+                c[2] * axis[0] + c[4] * axis[1] + c[5] * axis[2],
+            };
+            rayleigh = (axis[0] * next[0] + axis[1] * next[1] + axis[2] * next[2]) / axisLength2;
+            float length2 = next[0] * next[0] + next[1] * next[1] + next[2] * next[2];
+            if (length2 < 1e-12f)
+            {
+                break;
+            }
+            float scale = 1.0f / std::sqrt(length2);
+            axis[0] = next[0] * scale;
+            axis[1] = next[1] * scale;
+            axis[2] = next[2] * scale;
+            axisLength2 = 1.0f;
+        }
+        return std::max(variance - rayleigh, 0.0f);
+    }
+};
+
+BC7Block EncodeBC7Mode1( const BlockTexels &block, CompressionQuality quality )
+{
+    TexelMoments total;
+    for (int i = 0; i < 16; ++i)
+    {
+        total.Add(block, i);
+    }
+
+    // Rank the partitions by how far their subsets are from a line, then encode the most promising ones.
+    float estimates[64];
+    int   order[64];
+    for (int partition = 0; partition < 64; ++partition)
+    {
+        TexelMoments second;
+        for (int i = 0; i < 16; ++i)
+        {
+            if (BC7_PARTITIONS2[partition] & (1u << i))
+            {
+                second.Add(block, i);
+            }
+        }
+        estimates[partition] = (total - second).GetLineError() + second.GetLineError();
+        order[partition] = partition;
+    }
+    int numCandidates = quality == CompressionQuality::High ? 8 : 2;
+    std::partial_sort(order, order + numCandidates, order + 64,
+                      [&estimates]( int a, int b ) { return estimates[a] < estimates[b]; });
+
+    BC7Block result{};
+    result.Error = FLT_MAX;
+    for (int candidate = 0; candidate < numCandidates; ++candidate)
+    {
+        int      partition = order[candidate];
+        uint32_t masks[2] = {FULL_MASK & ~uint32_t(BC7_PARTITIONS2[partition]), BC7_PARTITIONS2[partition]};
+        int      anchors[2] = {0, BC7_ANCHORS2[partition]};
+
+        uint8_t   indices[16] = {};
+        BC7Subset subsets[2];
+        float     error = 0.0f;
+        for (int s = 0; s < 2; ++s)
+        {
+            subsets[s] = EncodeBC7Subset(block, quality, 6, 3, BC7_WEIGHTS3, 8, true, masks[s], indices);
+            error += subsets[s].Error;
+        }
+        if (error >= result.Error)
+        {
+            continue;
+        }
+        for (int s = 0; s < 2; ++s)
+        {
+            FixAnchor(&subsets[s].Endpoints, indices, masks[s], anchors[s], 8);
+        }
+
+        result.Error = error;
+        BitWriter writer(result.Data);
+        writer.Write(1u << 1, 2);
+        writer.Write(uint32_t(partition), 6);
+        for (int c = 0; c < 3; ++c)
+        {
+            for (const auto &subset: subsets)
+            {
+                writer.Write(subset.Endpoints.Codes[0][c], 6);
+                writer.Write(subset.Endpoints.Codes[1][c], 6);
+            }
+        }
+        writer.Write(subsets[0].Endpoints.PBits[0], 1);
+        writer.Write(subsets[1].Endpoints.PBits[0], 1);
+        for (int i = 0; i < 16; ++i)
+        {
+            writer.Write(indices[i], i == anchors[0] || i == anchors[1] ? 2 : 3);
+        }
+    }
+    return result;
+}
+
+void EncodeBC7( const BlockTexels &block, CompressionQuality quality, uint8_t* destination )
+{
+    BC7Block best = EncodeBC7Mode6(block, quality);
+
+    bool opaque = std::all_of(block.Channels[3], block.Channels[3] + 16, []( float alpha ) { return alpha == 255.0f; });
+    // In Normal quality, blocks mode 6 already gets within about one step per channel are left alone.
+    float goodEnough = quality == CompressionQuality::High ? 0.0f : 16.0f * 4.0f;
+    if (opaque && quality != CompressionQuality::Fast && best.Error > goodEnough)
+    {
+        BC7Block candidate = EncodeBC7Mode1(block, quality);
+        if (candidate.Error < best.Error)
+        {
+            best = candidate;
+        }
+    }
+    std::memcpy(destination, best.Data, sizeof(best.Data));
+}
+
+void DecodeBC7( const uint8_t* source, uint8_t texels[64] )
+{
+    BitReader reader(source);
+    int       mode = 0;
+    while (mode < 8 && reader.Read(1) == 0)
+    {
+        ++mode;
+    }
+
+    if (mode == 6)
+    {
+        int codes[2][4];
+        for (int c = 0; c < 4; ++c)
+        {
+            codes[0][c] = int(reader.Read(7));
+            codes[1][c] = int(reader.Read(7));
+        }
+        int pBits[2] = {int(reader.Read(1)), int(reader.Read(1))};
+        for (int i = 0; i < 16; ++i)
+        {
+            int weight = BC7_WEIGHTS4[reader.Read(i == 0 ? 3 : 4)];
+            for (int c = 0; c < 4; ++c)
+            {
+                texels[i * 4 + c] = static_cast<uint8_t>(InterpolateBC7(UnquantizeBC7(codes[0][c], pBits[0], 7),
+                                                                        UnquantizeBC7(codes[1][c], pBits[1], 7),
+                                                                        weight));
+            }
+        }
+    } else if (mode == 1)
+    {
+        int partition = int(reader.Read(6));
+        int codes[2][2][3];
+        for (int c = 0; c < 3; ++c)
+        {
+            for (auto &subset: codes)
+            {
+                subset[0][c] = int(reader.Read(6));
+                subset[1][c] = int(reader.Read(6));
+            }
+        }
+        int pBits[2] = {int(reader.Read(1)), int(reader.Read(1))};
+        int anchor = BC7_ANCHORS2[partition];
+        for (int i = 0; i < 16; ++i)
+        {
+            int subset = (BC7_PARTITIONS2[partition] >> i) & 1;
+            int weight = BC7_WEIGHTS3[reader.Read(i == 0 || i == anchor ? 2 : 3)];
+            for (int c = 0; c < 3; ++c)
+            {
+                texels[i * 4 + c] = static_cast<uint8_t>(
+                    InterpolateBC7(UnquantizeBC7(codes[subset][0][c], pBits[subset], 6),
+                                   UnquantizeBC7(codes[subset][1][c], pBits[subset], 6), weight));
+            }
+            texels[i * 4 + 3] = 255;
+        }
+    } else
+    {
+        std::memset(texels, 0, 64);
+    }
+}
+
+}
+
+bool IsBlockCompressed( TextureFormat format )
+{
+    return format != TextureFormat::RGBA8;
+}
+
+size_t GetBlockBytes( TextureFormat format )
+{
+    switch (format)
+    {
+        case TextureFormat::RGBA8:
+            return 4;
+        case TextureFormat::BC1:
+        case TextureFormat::BC4:
+            return 8;
+        case TextureFormat::BC3:
+        case TextureFormat::BC5:
+        case TextureFormat::BC7:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+size_t GetRowPitch( TextureFormat format, uint32_t width )
+{
+    size_t numColumns = IsBlockCompressed(format) ? (size_t(width) + 3) / 4 : width;
+    return numColumns * GetBlockBytes(format);
+}
+
+uint32_t GetNumRows( TextureFormat format, uint32_t height )
+{
+    return IsBlockCompressed(format) ? (height + 3) / 4 : height;
+}
+
+size_t GetSurfaceSize( TextureFormat format, uint32_t width, uint32_t height )
+{
+    return GetRowPitch(format, width) * GetNumRows(format, height);
+}
+
+void CompressBlock( TextureFormat format, CompressionQuality quality, const uint8_t texels[64], uint8_t* block )
+{
+    BlockTexels blockTexels;
+    LoadBlock(texels, &blockTexels);
+
+    switch (format)
+    {
+        case TextureFormat::BC1:
+        {
+            uint32_t opaqueMask = 0;
+            for (int i = 0; i < 16; ++i)
+            {
+                opaqueMask |= uint32_t(texels[i * 4 + 3] >= 128) << i;
+            }
+            EncodeColorBlock(blockTexels, quality, opaqueMask, block);
+            break;
+        }
+        case TextureFormat::BC3:
+            EncodeChannelBlock(blockTexels, 3, quality, block);
+            EncodeColorBlock(blockTexels, quality, FULL_MASK, block + 8);
+            break;
+        case TextureFormat::BC4:
+            EncodeChannelBlock(blockTexels, 0, quality, block);
+            break;
+        case TextureFormat::BC5:
+            EncodeChannelBlock(blockTexels, 0, quality, block);
+            EncodeChannelBlock(blockTexels, 1, quality, block + 8);
+            break;
+        case TextureFormat::BC7:
+            EncodeBC7(blockTexels, quality, block);
+            break;
+        default:
+            assert(false && "Not a block compressed format");
+            break;
+    }
+}
+
+void DecompressBlock( TextureFormat format, const uint8_t* block, uint8_t texels[64] )
+{
+    switch (format)
+    {
+        case TextureFormat::BC1:
+            DecodeColorBlock(block, true, texels);
+            break;
+        case TextureFormat::BC3:
+            DecodeColorBlock(block + 8, false, texels);
+            DecodeChannelBlock(block, texels, 3);
+            break;
+        case TextureFormat::BC4:
+        case TextureFormat::BC5:
+            for (int i = 0; i < 16; ++i)
+            {
+                texels[i * 4 + 1] = 0;
+                texels[i * 4 + 2] = 0;
+                texels[i * 4 + 3] = 255;
+            }
+            DecodeChannelBlock(block, texels, 0);
+            if (format == TextureFormat::BC5)
+            {
+                DecodeChannelBlock(block + 8, texels, 1);
+            }
+            break;
+        case TextureFormat::BC7:
+            DecodeBC7(block, texels);
+            break;
+        default:
+            assert(false && "Not a block compressed format");
+            break;
+    }
+}
+
+void CompressSurface( TextureFormat  format, CompressionQuality quality, const uint8_t* pixels, uint32_t width,
+                      uint32_t       height, size_t rowPitch, uint32_t firstRow, uint32_t numRows,
+                      uint8_t*       destination )
+{
+    size_t destinationPitch = GetRowPitch(format, width);
+    if (!IsBlockCompressed(format))
+    {
+        for (uint32_t y = 0; y < numRows; ++y)
+        {
+            std::memcpy(destination + y * destinationPitch, pixels + (firstRow + y) * rowPitch, destinationPitch);
+        }
+        return;
+    }
+
+    size_t  blockBytes = GetBlockBytes(format);
+    uint8_t texels[64];
+    for (uint32_t row = 0; row < numRows; ++row)
+    {
+        uint32_t blockY = (firstRow + row) * 4;
+        for (uint32_t blockX = 0; blockX < width; blockX += 4)
+        {
+            for (uint32_t y = 0; y < 4; ++y)
+            {
+                const uint8_t* source = pixels + std::min(blockY + y, height - 1) * rowPitch;
+                for (uint32_t x = 0; x < 4; ++x)
+                {
+                    std::memcpy(texels + (y * 4 + x) * 4, source + std::min(blockX + x, width - 1) * 4, 4);
+                }
+            }
+            CompressBlock(format, quality, texels, destination + row * destinationPitch + (blockX / 4) * blockBytes);
+        }
+    }
+}
+
+void DecompressSurface( TextureFormat format, const uint8_t* data, uint32_t width, uint32_t height, uint8_t* pixels )
+{
+    size_t sourcePitch = GetRowPitch(format, width);
+    if (!IsBlockCompressed(format))
+    {
+        std::memcpy(pixels, data, sourcePitch * height);
+        return;
+    }
+
+    size_t  blockBytes = GetBlockBytes(format);
+    uint8_t texels[64];
+    for (uint32_t blockY = 0; blockY < height; blockY += 4)
+    {
+        for (uint32_t blockX = 0; blockX < width; blockX += 4)
+        {
+            DecompressBlock(format, data + (blockY / 4) * sourcePitch + (blockX / 4) * blockBytes, texels);
+            for (uint32_t y = 0; y < 4 && blockY + y < height; ++y)
+            {
+                for (uint32_t x = 0; x < 4 && blockX + x < width; ++x)
+                {
+                    std::memcpy(pixels + (size_t(blockY + y) * width + blockX + x) * 4, texels + (y * 4 + x) * 4, 4);
+                }
+            }
+        }
+    }
+}
+
+}
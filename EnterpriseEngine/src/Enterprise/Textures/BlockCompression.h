@@ -0,0 +1,77 @@
+#ifndef BLOCKCOMPRESSION_H
+#define BLOCKCOMPRESSION_H
+#include <cstddef>
+#include <cstdint>
+
+
+namespace Enterprise::Textures {
+
+enum class TextureFormat : uint32_t {
+    // Uncompressed, 4 bytes per texel.
+    RGBA8 = 0,
+    // RGB with 1-bit alpha, 8 bytes per 4x4 block.
+    BC1,
+    // RGB with a separate alpha block, 16 bytes per block.
+    BC3,
+    // Red only, 8 bytes per block.
+    BC4,
+    // Red and green (normal maps), 16 bytes per block.
+    BC5,
+    // RGBA, 16 bytes per block.
+    BC7,
+
+    NumFormats
+};
+
+enum class CompressionQuality : uint32_t {
+    // Bounding box endpoints, no refinement.
+    Fast = 0,
+    // Principal axis endpoints with a few least squares refinements.
+    Normal,
+    // Searches more endpoint and partition candidates, several times slower than Normal.
+    High,
+};
+
+[[nodiscard]] bool IsBlockCompressed( TextureFormat format );
+
+// Bytes per 4x4 block, or per texel for uncompressed formats.
+[[nodiscard]] size_t GetBlockBytes( TextureFormat format );
+
+// Bytes per row of blocks (or texels) of a surface width texels wide.
+[[nodiscard]] size_t GetRowPitch( TextureFormat format, uint32_t width );
+
+// Rows of blocks (or texels) of a surface height texels high.
+[[nodiscard]] uint32_t GetNumRows( TextureFormat format, uint32_t height );
+
+[[nodiscard]] size_t GetSurfaceSize( TextureFormat format, uint32_t width, uint32_t height );
+
+/**
+ * Compress one 4x4 block of RGBA8 texels, given in row order.
+ * BC4 reads red, BC5 red and green. BC1 encodes texels with alpha below 128 as transparent.
+ */
+void CompressBlock( TextureFormat format, CompressionQuality quality, const uint8_t texels[64], uint8_t* block );
+
+/**
+ * Decompress one block to RGBA8. Meant for measuring the encoder's error: BC7 blocks
+ * only decode in the modes CompressBlock writes (1 and 6), others decode to zero.
+ */
+void DecompressBlock( TextureFormat format, const uint8_t* block, uint8_t texels[64] );
+
+/**
+ * Compress numRows rows of blocks, starting at block row firstRow, of a width x height RGBA8 image with the
+ * given row pitch. Blocks hanging over the edge repeat the last texel. destination points at the first row
+ * to write and is tightly packed, see GetRowPitch. Disjoint row ranges can be compressed on separate threads.
+ */
+void CompressSurface( TextureFormat  format, CompressionQuality quality, const uint8_t* pixels, uint32_t width,
+                      uint32_t       height, size_t rowPitch, uint32_t firstRow, uint32_t numRows,
+                      uint8_t*       destination );
+
+/**
+ * Decompress a whole surface to tightly packed RGBA8 pixels.
+ */
+void DecompressSurface( TextureFormat format, const uint8_t* data, uint32_t width, uint32_t height,
+                        uint8_t*      pixels );
+
+}
+
+#endif //BLOCKCOMPRESSION_H
@@ -0,0 +1,316 @@
+#include "MipChain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <iterator>
+
+#include "../Core/ThreadPool.h"
+
+namespace Enterprise::Textures {
+
+namespace {
+
+// Texels filtered per thread pool task.
+constexpr size_t GRAIN_TEXELS = 16 * 1024;
+
+// Kaiser filter half width, in texels of the smaller mip, and the window's shape parameter.
+constexpr double KAISER_RADIUS = 3.0;
+constexpr double KAISER_ALPHA = 4.0;
+
+constexpr double PI = 3.14159265358979323846;
+
+struct ColorTables {
+    float UnormToFloat[256];
+    float SrgbToLinear[256];
+    // Linear values halfway between consecutive sRGB codes, to round to the nearest code without a pow.
+    float SrgbThresholds[255];
+
+    ColorTables()
+    {
+        // Same curves as ConvertToLinear and ConvertToSRGB in GenerateMipsCS.
+        for (int i = 0; i < 256; ++i)
+        {
+            double x = i / 255.0;
+            UnormToFloat[i] = static_cast<float>(x);
+            SrgbToLinear[i] = static_cast<float>(x < 0.04045 ? x / 12.92 : std::pow((x + 0.055) / 1.055, 2.4));
+        }
+        for (int i = 0; i < 255; ++i)
+        {
+            double x = (i + 0.5) / 255.0;
+            SrgbThresholds[i] = static_cast<float>(x < 0.04045 ? x / 12.92 : std::pow((x + 0.055) / 1.055, 2.4));
+        }
+    }
+};
+
+const ColorTables &GetColorTables()
+{
+    static const ColorTables tables;
+    return tables;
+}
+
+// Source texels and weights summed into each texel of the smaller mip, along one axis.
+// Every texel has NumTaps taps, the unused ones weigh nothing.
+struct FilterTaps {
+    uint32_t              NumTaps = 0;
+    std::vector<uint32_t> Indices;
+    std::vector<float>    Weights;
+};
+
+struct Tap {
+    int64_t Index;
+    double  Weight;
+};
+
+FilterTaps FlattenTaps( const std::vector<std::vector<Tap> > &texelTaps, uint32_t size )
+{
+    FilterTaps taps;
+    for (const auto &texel: texelTaps)
+    {
+        taps.NumTaps = std::max(taps.NumTaps, static_cast<uint32_t>(texel.size()));
+    }
+
+    taps.Indices.assign(texelTaps.size() * taps.NumTaps, 0);
+    taps.Weights.assign(texelTaps.size() * taps.NumTaps, 0.0f);
+    for (size_t i = 0; i < texelTaps.size(); ++i)
+    {
+        double sum = 0.0;
+        for (const auto &tap: texelTaps[i])
+        {
+            sum += tap.Weight;
+        }
+        for (size_t t = 0; t < texelTaps[i].size(); ++t)
+        {
+            // Clamp addressing, like the shader's sampler.
+            int64_t index = std::clamp<int64_t>(texelTaps[i][t].Index, 0, int64_t(size) - 1);
+            taps.Indices[i * taps.NumTaps + t] = static_cast<uint32_t>(index);
+            taps.Weights[i * taps.NumTaps + t] = static_cast<float>(texelTaps[i][t].Weight / sum);
+        }
+    }
+    return taps;
+}
+
+// GenerateMipsCS takes one bilinear sample at the center of each texel of the smaller mip when the size is
+// even, which is the average of two texels, and two samples a quarter texel either side of it when it is odd.
+FilterTaps GetBoxTaps( uint32_t size, uint32_t mipSize )
+{
+    double                         scale = double(size) / mipSize;
+    bool                           odd = (size & 1) != 0;
+    std::vector<std::vector<Tap> > texelTaps(mipSize);
+    for (uint32_t i = 0; i < mipSize; ++i)
+    {
+        const double offsets[2] = {odd ? 0.25 : 0.5, 0.75};
+        for (uint32_t sample = 0; sample < (odd ? 2u : 1u); ++sample)
+        {
+            double position = (i + offsets[sample]) * scale - 0.5;
+            double first = std::floor(position);
+            double fraction = position - first;
+            auto   index = static_cast<int64_t>(first);
+            double weight = odd ? 0.5 : 1.0;
+            texelTaps[i].push_back({index, (1.0 - fraction) * weight});
+            texelTaps[i].push_back({index + 1, fraction * weight});
+        }
+    }
+    return FlattenTaps(texelTaps, size);
+}
+
+double BesselI0( double x )
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64 && term > sum * 1e-12; ++k)
+    {
+        double half = x / (2.0 * k);
+        term *= half * half;
+        sum += term;
+    }
+    return sum;
+}
+
+double Sinc( double x )
+{
+    return x == 0.0 ? 1.0 : std::sin(PI * x) / (PI * x);
+}
+
+FilterTaps GetKaiserTaps( uint32_t size, uint32_t mipSize )
+{
+    // Low pass at the smaller mip's Nyquist frequency, so the kernel is stretched by the scale.
+    double                         scale = double(size) / mipSize;
+    double                         radius = KAISER_RADIUS * scale;
+    double                         windowScale = 1.0 / BesselI0(KAISER_ALPHA);
+    std::vector<std::vector<Tap> > texelTaps(mipSize);
+    for (uint32_t i = 0; i < mipSize; ++i)
+    {
+        double center = (i + 0.5) * scale - 0.5;
+        auto   first = static_cast<int64_t>(std::ceil(center - radius));
+        auto   last = static_cast<int64_t>(std::floor(center + radius));
+        for (int64_t index = first; index <= last; ++index)
+        {
+            double t = (double(index) - center) / radius;
+            double window = BesselI0(KAISER_ALPHA * std::sqrt(std::max(1.0 - t * t, 0.0))) * windowScale;
+            double weight = Sinc((double(index) - center) / scale) * window;
+            if (weight != 0.0)
+            {
+                texelTaps[i].push_back({index, weight});
+            }
+        }
+    }
+    return FlattenTaps(texelTaps, size);
+}
+
+FilterTaps GetTaps( MipFilter filter, uint32_t size, uint32_t mipSize )
+{
+    return filter == MipFilter::Kaiser ? GetKaiserTaps(size, mipSize) : GetBoxTaps(size, mipSize);
+}
+
+// An RGBA texel at float precision, aligned for _mm_load_ps and _mm_store_ps. Vectors of __m128 itself would drop
+// its alignment attribute from the template argument.
+struct alignas(16) Texel {
+    float Value[4];
+};
+
+size_t GetGrainRows( size_t width )
+{
+    return std::max<size_t>(GRAIN_TEXELS / std::max<size_t>(width, 1), 1);
+}
+
+void StoreRow( Texel* texels, uint32_t width, bool srgb, uint8_t* destination )
+{
+    const auto & tables = GetColorTables();
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        // Keep the clamped value, so ringing does not build up down the chain.
+        __m128 texel = _mm_min_ps(_mm_max_ps(_mm_load_ps(texels[x].Value), zero), one);
+        _mm_store_ps(texels[x].Value, texel);
+
+        __m128i code = _mm_cvtps_epi32(_mm_mul_ps(texel, scale));
+        code = _mm_packs_epi32(code, code);
+        code = _mm_packus_epi16(code, code);
+        auto packed = static_cast<uint32_t>(_mm_cvtsi128_si32(code));
+        std::memcpy(destination + size_t(x) * 4, &packed, 4);
+
+        if (srgb)
+        {
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                destination[size_t(x) * 4 + c] = static_cast<uint8_t>(
+                    std::upper_bound(std::begin(tables.SrgbThresholds), std::end(tables.SrgbThresholds),
+                                     texels[x].Value[c]) - std::begin(tables.SrgbThresholds));
+            }
+        }
+    }
+}
+
+}
+
+uint32_t GetNumMips( uint32_t width, uint32_t height )
+{
+    uint32_t numMips = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+    {
+        ++numMips;
+    }
+    return numMips;
+}
+
+void GenerateMipChain( const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch,
+                       const MipChainSettings &settings, std::vector<MipLevel>* mips )
+{
+    mips->clear();
+    if (width == 0 || height == 0)
+    {
+        return;
+    }
+    mips->reserve(GetNumMips(width, height) - 1);
+
+    auto &       threadPool = Core::Threads::ThreadPool::Get();
+    const float* toFloat = settings.Srgb ? GetColorTables().SrgbToLinear : GetColorTables().UnormToFloat;
+
+    std::vector<Texel> level(size_t(width) * height);
+    threadPool.ParallelFor(height, GetGrainRows(width), [&]( size_t begin, size_t end )
+    {
+        for (size_t y = begin; y < end; ++y)
+        {
+            const uint8_t* row = pixels + y * rowPitch;
+            Texel*         levelRow = level.data() + y * width;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const uint8_t* texel = row + size_t(x) * 4;
+                levelRow[x] = {toFloat[texel[0]], toFloat[texel[1]], toFloat[texel[2]],
+                               float(texel[3]) * (1.0f / 255.0f)};
+            }
+        }
+    });
+
+    std::vector<Texel> rows;
+    std::vector<Texel> mip;
+    while (width > 1 || height > 1)
+    {
+        uint32_t   mipWidth = std::max(width / 2, 1u);
+        uint32_t   mipHeight = std::max(height / 2, 1u);
+        FilterTaps columnTaps = GetTaps(settings.Filter, width, mipWidth);
+        FilterTaps rowTaps = GetTaps(settings.Filter, height, mipHeight);
+
+        // Filter along x into rows, then along y into the mip.
+        rows.resize(size_t(mipWidth) * height);
+        threadPool.ParallelFor(height, GetGrainRows(width), [&]( size_t begin, size_t end )
+        {
+            for (size_t y = begin; y < end; ++y)
+            {
+                const Texel* source = level.data() + y * width;
+                Texel*       destination = rows.data() + y * mipWidth;
+                for (uint32_t x = 0; x < mipWidth; ++x)
+                {
+                    const uint32_t* indices = columnTaps.Indices.data() + size_t(x) * columnTaps.NumTaps;
+                    const float*    weights = columnTaps.Weights.data() + size_t(x) * columnTaps.NumTaps;
+                    __m128          sum = _mm_setzero_ps();
+                    for (uint32_t t = 0; t < columnTaps.NumTaps; ++t)
+                    {
+                        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(source[indices[t]].Value),
+                                                         _mm_set1_ps(weights[t])));
+                    }
+                    _mm_store_ps(destination[x].Value, sum);
+                }
+            }
+        });
+
+        mip.resize(size_t(mipWidth) * mipHeight);
+        auto &output = mips->emplace_back();
+        output.Width = mipWidth;
+        output.Height = mipHeight;
+        output.Pixels.resize(size_t(mipWidth) * mipHeight * 4);
+        threadPool.ParallelFor(mipHeight, GetGrainRows(size_t(mipWidth) * rowTaps.NumTaps),
+                               [&]( size_t begin, size_t end )
+        {
+            for (size_t y = begin; y < end; ++y)
+            {
+                const uint32_t* indices = rowTaps.Indices.data() + y * rowTaps.NumTaps;
+                const float*    weights = rowTaps.Weights.data() + y * rowTaps.NumTaps;
+                Texel*          destination = mip.data() + y * mipWidth;
+                std::fill(destination, destination + mipWidth, Texel{});
+                for (uint32_t t = 0; t < rowTaps.NumTaps; ++t)
+                {
+                    const Texel* source = rows.data() + size_t(indices[t]) * mipWidth;
+                    __m128       weight = _mm_set1_ps(weights[t]);
+                    for (uint32_t x = 0; x < mipWidth; ++x)
+                    {
+                        __m128 sum = _mm_add_ps(_mm_load_ps(destination[x].Value),
+                                                _mm_mul_ps(_mm_load_ps(source[x].Value), weight));
+                        _mm_store_ps(destination[x].Value, sum);
+                    }
+                }
+                StoreRow(destination, mipWidth, settings.Srgb, output.Pixels.data() + y * mipWidth * 4);
+            }
+        });
+
+        std::swap(level, mip);
+        width = mipWidth;
+        height = mipHeight;
+    }
+}
+
+}
@@ -0,0 +1,44 @@
+#ifndef MIPCHAIN_H
+#define MIPCHAIN_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace Enterprise::Textures {
+
+enum class MipFilter : uint32_t {
+    // What GenerateMipsCS computes: a 2x2 average, with two bilinear taps along odd dimensions
+    // so a texel of the next mip covers all three source texels under it.
+    Box = 0,
+    // Kaiser windowed sinc over three texels of the next mip each side. Sharper than Box, slight ringing.
+    Kaiser,
+};
+
+struct MipChainSettings {
+    MipFilter Filter = MipFilter::Box;
+    // Filter color in linear space and store it as sRGB again. Alpha is always linear.
+    bool      Srgb = false;
+};
+
+struct MipLevel {
+    uint32_t             Width = 0;
+    uint32_t             Height = 0;
+    // Tightly packed RGBA8.
+    std::vector<uint8_t> Pixels;
+};
+
+// Mips in a full chain down to 1x1, including the top level.
+[[nodiscard]] uint32_t GetNumMips( uint32_t width, uint32_t height );
+
+/**
+ * Build every mip below a width x height RGBA8 image, down to 1x1, largest first. Mip sizes halve rounding
+ * down like D3D12's. Each mip is filtered from the one above it at float precision, only the stored texels
+ * are rounded. Rows of large mips are filtered on the shared thread pool, which is safe from a pool task.
+ */
+void GenerateMipChain( const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch,
+                       const MipChainSettings &settings, std::vector<MipLevel>* mips );
+
+}
+
+#endif //MIPCHAIN_H
@@ -0,0 +1,432 @@
+#ifndef RESIDENCYCACHE_H
+#define RESIDENCYCACHE_H
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+
+namespace Enterprise::Textures {
+
+/**
+ * Cache of GPU resources keyed by a 64 bit key, such as the hash of a texture name or of its content, with a
+ * memory budget. Lookups hand out ref-counted handles; an entry no handle refers to stays resident until the
+ * cache goes over budget, when unreferenced entries are evicted least recently used first. Referenced entries
+ * are never evicted, so the cache can go over budget when everything in it is in use.
+ *
+ * Resource is whatever owns the GPU memory, e.g. a ComPtr, and eviction simply destroys it, which keeps the
+ * policy free of any graphics API. Entries are spread over NUM_SHARDS independently locked shards, so lookups
+ * of different keys rarely contend.
+ */
+template<typename Resource>
+class ResidencyCache {
+    struct Entry;
+
+public:
+    using Key = uint64_t;
+
+    static constexpr uint32_t NUM_SHARDS = 16;
+
+    class Handle {
+    public:
+        Handle() = default;
+
+        Handle( const Handle &copy );
+
+        Handle( Handle &&copy ) noexcept;
+
+        Handle &operator=( const Handle &other );
+
+        Handle &operator=( Handle &&other ) noexcept;
+
+        ~Handle() { Reset(); }
+
+        void Reset();
+
+        explicit operator bool() const { return m_Entry != nullptr; }
+
+        [[nodiscard]] const Resource &Get() const { return m_Entry->Value; }
+        [[nodiscard]] Key             GetKey() const { return m_Entry->EntryKey; }
+        [[nodiscard]] uint64_t        GetSize() const { return m_Entry->Size; }
+
+    private:
+        friend class ResidencyCache;
+
+        explicit Handle( Entry* entry ) : m_Entry(entry) {}
+
+        Entry* m_Entry = nullptr;
+    };
+
+    struct Statistics {
+        uint64_t ResidentBytes = 0;
+        uint64_t Budget = 0;
+        uint64_t NumEntries = 0;
+        uint64_t Hits = 0;
+        uint64_t Misses = 0;
+        uint64_t Evictions = 0;
+    };
+
+    explicit ResidencyCache( uint64_t budget = UINT64_MAX );
+
+    ResidencyCache( const ResidencyCache &copy ) = delete;
+
+    ResidencyCache &operator=( const ResidencyCache &other ) = delete;
+
+    /**
+     * Entries still referenced outlive the cache and are destroyed with their last handle.
+     */
+    ~ResidencyCache();
+
+    /**
+     * Returns an empty handle if key is not resident.
+     */
+    Handle Find( Key key );
+
+    /**
+     * Add resource, taking size bytes of the budget. If another thread inserted key first, resource is
+     * destroyed and the handle refers to the entry already in the cache.
+     */
+    Handle Insert( Key key, Resource resource, uint64_t size );
+
+    /**
+     * Evicts right away if the cache is now over budget.
+     */
+    void SetBudget( uint64_t budget );
+
+    /**
+     * Evict unreferenced entries until the cache fits the budget, or nothing more can be evicted.
+     */
+    void Trim();
+
+    /**
+     * Evict every unreferenced entry.
+     */
+    void EvictUnreferenced();
+
+    [[nodiscard]] Statistics GetStatistics() const;
+
+private:
+    struct Entry {
+        ResidencyCache*       Cache = nullptr;
+        Key                   EntryKey = 0;
+        Resource              Value;
+        uint64_t              Size = 0;
+        std::atomic<uint32_t> RefCount{0};
+        // Cache clock when the last handle went away, which orders the LRU lists of all the shards.
+        uint64_t              LastUse = 0;
+        Entry*                Newer = nullptr;
+        Entry*                Older = nullptr;
+    };
+
+    struct Shard {
+        std::mutex                                     Mutex;
+        std::unordered_map<Key, std::unique_ptr<Entry> > Entries;
+        // Unreferenced entries only, newest first.
+        Entry*                                         Newest = nullptr;
+        Entry*                                         Oldest = nullptr;
+    };
+
+    static uint32_t GetShardIndex( Key key )
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return static_cast<uint32_t>(key % NUM_SHARDS);
+    }
+
+    static void Link( Shard &shard, Entry* entry );
+
+    static void Unlink( Shard &shard, Entry* entry );
+
+    // Referencing an entry takes it off its shard's LRU list. The caller holds the shard lock.
+    static Handle Acquire( Shard &shard, Entry* entry );
+
+    // Called by the last handle of an entry.
+    void Release( Entry* entry );
+
+    // Evict the least recently used unreferenced entry of all the shards. Returns false if there is none.
+    bool EvictOldest();
+
+    Shard                 m_Shards[NUM_SHARDS];
+    std::atomic<uint64_t> m_ResidentBytes{0};
+    std::atomic<uint64_t> m_Budget;
+    std::atomic<uint64_t> m_NumEntries{0};
+    std::atomic<uint64_t> m_Clock{0};
+    std::atomic<uint64_t> m_Hits{0};
+    std::atomic<uint64_t> m_Misses{0};
+    std::atomic<uint64_t> m_Evictions{0};
+};
+
+//---------------------------------------------------------------------------------------------|
+// Handle                                                                                      |
+//---------------------------------------------------------------------------------------------|
+
+template<typename Resource>
+ResidencyCache<Resource>::Handle::Handle( const Handle &copy )
+    : m_Entry(copy.m_Entry)
+{
+    // A handle already holds the entry, so the count cannot be going through zero.
+    if (m_Entry)
+    {
+        m_Entry->RefCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+template<typename Resource>
+ResidencyCache<Resource>::Handle::Handle( Handle &&copy ) noexcept
+    : m_Entry(std::exchange(copy.m_Entry, nullptr))
+{}
+
+template<typename Resource>
+typename ResidencyCache<Resource>::Handle &ResidencyCache<Resource>::Handle::operator=( const Handle &other )
+{
+    if (this != &other)
+    {
+        Handle copy(other);
+        std::swap(m_Entry, copy.m_Entry);
+    }
+    return *this;
+}
+
+template<typename Resource>
+typename ResidencyCache<Resource>::Handle &ResidencyCache<Resource>::Handle::operator=( Handle &&other ) noexcept
+{
+    if (this != &other)
+    {
+        Reset();
+        m_Entry = std::exchange(other.m_Entry, nullptr);
+    }
+    return *this;
+}
+
+template<typename Resource>
+void ResidencyCache<Resource>::Handle::Reset()
+{
+    Entry* entry = std::exchange(m_Entry, nullptr);
+    if (!entry)
+    {
+        return;
+    }
+    if (entry->Cache)
+    {
+        entry->Cache->Release(entry);
+    } else if (entry->RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // The cache is gone and this was the last reference.
+        delete entry;
+    }
+}
+
+//---------------------------------------------------------------------------------------------|
+// Cache                                                                                       |
+//---------------------------------------------------------------------------------------------|
+
+template<typename Resource>
+ResidencyCache<Resource>::ResidencyCache( uint64_t budget )
+    : m_Budget(budget)
+{}
+
+template<typename Resource>
+ResidencyCache<Resource>::~ResidencyCache()
+{
+    for (auto &shard: m_Shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        for (auto &[key, entry]: shard.Entries)
+        {
+            if (entry->RefCount.load(std::memory_order_acquire) > 0)
+            {
+                entry->Cache = nullptr;
+                entry.release();
+            }
+        }
+    }
+}
+
+template<typename Resource>
+typename ResidencyCache<Resource>::Handle ResidencyCache<Resource>::Find( Key key )
+{
+    auto                        &shard = m_Shards[GetShardIndex(key)];
+    std::lock_guard<std::mutex> lock(shard.Mutex);
+    auto                        iter = shard.Entries.find(key);
+    if (iter == shard.Entries.end())
+    {
+        m_Misses.fetch_add(1, std::memory_order_relaxed);
+        return {};
+    }
+    m_Hits.fetch_add(1, std::memory_order_relaxed);
+    return Acquire(shard, iter->second.get());
+}
+
+template<typename Resource>
+typename ResidencyCache<Resource>::Handle ResidencyCache<Resource>::Insert( Key key, Resource resource,
+                                                                          uint64_t size )
+{
+    auto   &shard = m_Shards[GetShardIndex(key)];
+    Handle handle;
+    {
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        auto                        &entry = shard.Entries[key];
+        if (entry)
+        {
+            return Acquire(shard, entry.get());
+        }
+        entry = std::make_unique<Entry>();
+        entry->Cache = this;
+        entry->EntryKey = key;
+        entry->Value = std::move(resource);
+        entry->Size = size;
+        handle = Acquire(shard, entry.get());
+    }
+    m_NumEntries.fetch_add(1, std::memory_order_relaxed);
+    if (m_ResidentBytes.fetch_add(size, std::memory_order_relaxed) + size > m_Budget.load(std::memory_order_relaxed))
+    {
+        Trim();
+    }
+    return handle;
+}
+
+template<typename Resource>
+void ResidencyCache<Resource>::SetBudget( uint64_t budget )
+{
+    m_Budget.store(budget, std::memory_order_relaxed);
+    Trim();
+}
+
+template<typename Resource>
+void ResidencyCache<Resource>::Trim()
+{
+    while (m_ResidentBytes.load(std::memory_order_relaxed) > m_Budget.load(std::memory_order_relaxed))
+    {
+        if (!EvictOldest())
+        {
+            break;
+        }
+    }
+}
+
+template<typename Resource>
+void ResidencyCache<Resource>::EvictUnreferenced()
+{
+    while (EvictOldest())
+    {}
+}
+
+template<typename Resource>
+typename ResidencyCache<Resource>::Statistics ResidencyCache<Resource>::GetStatistics() const
+{
+    Statistics statistics;
+    statistics.ResidentBytes = m_ResidentBytes.load(std::memory_order_relaxed);
+    statistics.Budget = m_Budget.load(std::memory_order_relaxed);
+    statistics.NumEntries = m_NumEntries.load(std::memory_order_relaxed);
+    statistics.Hits = m_Hits.load(std::memory_order_relaxed);
+    statistics.Misses = m_Misses.load(std::memory_order_relaxed);
+    statistics.Evictions = m_Evictions.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+template<typename Resource>
+void ResidencyCache<Resource>::Link( Shard &shard, Entry* entry )
+{
+    entry->Newer = nullptr;
+    entry->Older = shard.Newest;
+    if (shard.Newest)
+    {
+        shard.Newest->Newer = entry;
+    } else
+    {
+        shard.Oldest = entry;
+    }
+    shard.Newest = entry;
+}
+
+template<typename Resource>
+void ResidencyCache<Resource>::Unlink( Shard &shard, Entry* entry )
+{
+    (entry->Newer ? entry->Newer->Older : shard.Newest) = entry->Older;
+    (entry->Older ? entry->Older->Newer : shard.Oldest) = entry->Newer;
+    entry->Newer = nullptr;
+    entry->Older = nullptr;
+}
+
+template<typename Resource>
+typename ResidencyCache<Resource>::Handle ResidencyCache<Resource>::Acquire( Shard &shard, Entry* entry )
+{
+    if (entry->RefCount.fetch_add(1, std::memory_order_relaxed) == 0)
+    {
+        Unlink(shard, entry);
+    }
+    return Handle(entry);
+}
+
+template<typename Resource>
+void ResidencyCache<Resource>::Release( Entry* entry )
+{
+    auto &shard = m_Shards[GetShardIndex(entry->EntryKey)];
+    {
+        // Under the lock, so a Find cannot reference the entry between the count reaching zero and the
+        // entry going on the LRU list.
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        if (entry->RefCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+        entry->LastUse = m_Clock.fetch_add(1, std::memory_order_relaxed);
+        Link(shard, entry);
+    }
+    if (m_ResidentBytes.load(std::memory_order_relaxed) > m_Budget.load(std::memory_order_relaxed))
+    {
+        Trim();
+    }
+}
+
+template<typename Resource>
+bool ResidencyCache<Resource>::EvictOldest()
+{
+    // Lock one shard at a time. Another thread may take the chosen entry in the meantime, in which case the
+    // shard's next oldest entry goes instead, which is close enough to LRU.
+    Shard*   oldestShard = nullptr;
+    uint64_t oldestUse = UINT64_MAX;
+    for (auto &shard: m_Shards)
+    {
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        if (shard.Oldest && shard.Oldest->LastUse < oldestUse)
+        {
+            oldestUse = shard.Oldest->LastUse;
+            oldestShard = &shard;
+        }
+    }
+    if (!oldestShard)
+    {
+        return false;
+    }
+
+    std::unique_ptr<Entry> evicted;
+    {
+        std::lock_guard<std::mutex> lock(oldestShard->Mutex);
+        Entry*                      entry = oldestShard->Oldest;
+        if (!entry)
+        {
+            // Everything there was referenced again, look again.
+            return true;
+        }
+        Unlink(*oldestShard, entry);
+        auto iter = oldestShard->Entries.find(entry->EntryKey);
+        assert(iter != oldestShard->Entries.end());
+        evicted = std::move(iter->second);
+        oldestShard->Entries.erase(iter);
+    }
+    m_ResidentBytes.fetch_sub(evicted->Size, std::memory_order_relaxed);
+    m_NumEntries.fetch_sub(1, std::memory_order_relaxed);
+    m_Evictions.fetch_add(1, std::memory_order_relaxed);
+    // The resource is destroyed here, outside the lock.
+    return true;
+}
+
+}
+
+
+#endif //RESIDENCYCACHE_H
@@ -0,0 +1,399 @@
+#include "VirtualTexture.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace Enterprise::Textures {
+
+uint32_t VirtualTextureLayout::GetMipWidth( uint32_t mip ) const
+{
+    return std::max(Width >> mip, 1u);
+}
+
+uint32_t VirtualTextureLayout::GetMipHeight( uint32_t mip ) const
+{
+    return std::max(Height >> mip, 1u);
+}
+
+uint32_t VirtualTextureLayout::GetNumTilesX( uint32_t mip ) const
+{
+    return (GetMipWidth(mip) + TileSize - 1) / TileSize;
+}
+
+uint32_t VirtualTextureLayout::GetNumTilesY( uint32_t mip ) const
+{
+    return (GetMipHeight(mip) + TileSize - 1) / TileSize;
+}
+
+uint32_t VirtualTextureLayout::GetNumTiles() const
+{
+    uint32_t numTiles = 0;
+    for (uint32_t mip = 0; mip < NumMips; ++mip)
+    {
+        numTiles += GetNumTilesX(mip) * GetNumTilesY(mip);
+    }
+    return numTiles;
+}
+
+bool MakeVirtualTextureLayout( uint32_t width, uint32_t height, uint32_t tileSize, uint32_t tileBorder,
+                               VirtualTextureLayout* layout )
+{
+    if (width == 0 || height == 0 || tileSize == 0)
+    {
+        return false;
+    }
+
+    layout->Width = width;
+    layout->Height = height;
+    layout->TileSize = tileSize;
+    layout->TileBorder = tileBorder;
+    layout->NumMips = 1;
+    while (layout->GetNumTilesX(layout->NumMips - 1) > 1 || layout->GetNumTilesY(layout->NumMips - 1) > 1)
+    {
+        ++layout->NumMips;
+    }
+
+    return layout->NumMips <= MAX_VIRTUAL_TEXTURE_MIPS && layout->GetNumTilesX(0) <= MAX_VIRTUAL_TEXTURE_TILES &&
+           layout->GetNumTilesY(0) <= MAX_VIRTUAL_TEXTURE_TILES;
+}
+
+VirtualTexturePageTable::VirtualTexturePageTable( const VirtualTextureLayout &layout, uint32_t numSlots )
+    : m_Layout(layout)
+    , m_Slots(numSlots)
+    , m_PageTable(layout.NumMips)
+    , m_Dirty(layout.NumMips, true)
+{
+    assert(layout.NumMips > 0 && layout.NumMips <= MAX_VIRTUAL_TEXTURE_MIPS && "Invalid virtual texture layout.");
+
+    // Popped from the back, so slots fill up in order.
+    m_FreeSlots.reserve(numSlots);
+    for (uint32_t slot = numSlots; slot > 0; --slot)
+    {
+        m_FreeSlots.push_back(slot - 1);
+    }
+
+    // Nothing is resident yet; every page reads as coarser than any tile until Initialize maps the last mip.
+    for (uint32_t mip = 0; mip < layout.NumMips; ++mip)
+    {
+        m_PageTable[mip].assign(size_t(layout.GetNumTilesX(mip)) * layout.GetNumTilesY(mip),
+                                MakePageTableEntry(0, MAX_VIRTUAL_TEXTURE_MIPS - 1));
+    }
+}
+
+bool VirtualTexturePageTable::Initialize( TileStreamer &streamer )
+{
+    // The last mip fits in a single tile.
+    const TileId tile = {0, 0, m_Layout.NumMips - 1};
+    if (m_ResidentTiles.count(PackTileId(tile)) != 0)
+    {
+        return true;
+    }
+    if (m_FreeSlots.empty())
+    {
+        return false;
+    }
+
+    TileLoad load;
+    load.Tile = tile;
+    load.Slot = m_FreeSlots.back();
+    streamer.LoadTiles(&load, 1);
+    if (!load.Loaded)
+    {
+        return false;
+    }
+
+    m_FreeSlots.pop_back();
+    Slot &slot = m_Slots[load.Slot];
+    slot.Tile = PackTileId(tile);
+    slot.Pinned = true;
+    m_ResidentTiles.emplace(slot.Tile, load.Slot);
+    Map(tile, load.Slot);
+    m_Statistics.NumResident = static_cast<uint32_t>(m_ResidentTiles.size());
+    return true;
+}
+
+void VirtualTexturePageTable::AddFeedback( const uint32_t* packedTiles, size_t count )
+{
+    // Neighbouring pixels mostly sample the same tile, so count runs instead of single entries.
+    uint32_t runTile = INVALID_PACKED_TILE;
+    uint32_t runLength = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (packedTiles[i] == runTile)
+        {
+            ++runLength;
+            continue;
+        }
+        if (runLength > 0)
+        {
+            m_Requests[runTile] += runLength;
+        }
+
+        runTile = packedTiles[i];
+        runLength = runTile != INVALID_PACKED_TILE && IsValidTile(UnpackTileId(runTile)) ? 1 : 0;
+        if (runLength == 0)
+        {
+            runTile = INVALID_PACKED_TILE;
+        }
+    }
+    if (runLength > 0)
+    {
+        m_Requests[runTile] += runLength;
+    }
+}
+
+uint32_t VirtualTexturePageTable::Update( TileStreamer &streamer, uint32_t maxLoads )
+{
+    ++m_Frame;
+    m_Statistics.NumRequested = static_cast<uint32_t>(m_Requests.size());
+    m_Statistics.NumRequestedResident = 0;
+    m_Statistics.NumLoaded = 0;
+    m_Statistics.NumEvicted = 0;
+    m_Statistics.NumFailed = 0;
+
+    // Keep every requested tile and its ancestors from eviction, and collect the missing ones. A missing tile
+    // is as urgent as all the requests it is the fallback for.
+    std::unordered_map<uint32_t, uint32_t> missing;
+    for (const auto &[packed, count]: m_Requests)
+    {
+        if (m_ResidentTiles.count(packed) != 0)
+        {
+            ++m_Statistics.NumRequestedResident;
+        }
+
+        TileId tile = UnpackTileId(packed);
+        while (true)
+        {
+            uint32_t ancestor = PackTileId(tile);
+            auto     resident = m_ResidentTiles.find(ancestor);
+            if (resident != m_ResidentTiles.end())
+            {
+                Touch(resident->second);
+            } else
+            {
+                missing[ancestor] += count;
+            }
+
+            if (tile.Mip + 1 >= m_Layout.NumMips)
+            {
+                break;
+            }
+            tile = {tile.X >> 1, tile.Y >> 1, tile.Mip + 1};
+        }
+    }
+    m_Requests.clear();
+
+    // Coarse tiles first, they are the fallback of everything below them, then the most requested.
+    std::vector<std::pair<uint32_t, uint32_t> > pending(missing.begin(), missing.end());
+    std::sort(pending.begin(), pending.end(), []( const auto &a, const auto &b )
+    {
+        uint32_t mipA = a.first >> 28;
+        uint32_t mipB = b.first >> 28;
+        if (mipA != mipB)
+        {
+            return mipA > mipB;
+        }
+        if (a.second != b.second)
+        {
+            return a.second > b.second;
+        }
+        return a.first < b.first;
+    });
+
+    std::vector<TileLoad> loads;
+    loads.reserve(std::min<size_t>(pending.size(), maxLoads));
+    for (const auto &[packed, count]: pending)
+    {
+        if (loads.size() >= maxLoads)
+        {
+            break;
+        }
+
+        uint32_t slot = AcquireSlot();
+        if (slot == INVALID_SLOT)
+        {
+            break;
+        }
+
+        TileLoad load;
+        load.Tile = UnpackTileId(packed);
+        load.Slot = slot;
+        loads.push_back(load);
+    }
+
+    if (!loads.empty())
+    {
+        streamer.LoadTiles(loads.data(), loads.size());
+    }
+
+    for (const TileLoad &load: loads)
+    {
+        if (!load.Loaded)
+        {
+            m_FreeSlots.push_back(load.Slot);
+            ++m_Statistics.NumFailed;
+            continue;
+        }
+
+        Slot &slot = m_Slots[load.Slot];
+        slot.Tile = PackTileId(load.Tile);
+        slot.LastUsed = m_Frame;
+        LinkSlot(load.Slot);
+        m_ResidentTiles.emplace(slot.Tile, load.Slot);
+        Map(load.Tile, load.Slot);
+        ++m_Statistics.NumLoaded;
+    }
+
+    m_Statistics.NumDeferred = static_cast<uint32_t>(pending.size() - loads.size());
+    m_Statistics.NumResident = static_cast<uint32_t>(m_ResidentTiles.size());
+    return m_Statistics.NumLoaded;
+}
+
+bool VirtualTexturePageTable::IsResident( const TileId &tile ) const
+{
+    return m_ResidentTiles.count(PackTileId(tile)) != 0;
+}
+
+void VirtualTexturePageTable::ClearDirty()
+{
+    std::fill(m_Dirty.begin(), m_Dirty.end(), false);
+}
+
+bool VirtualTexturePageTable::IsValidTile( const TileId &tile ) const
+{
+    return tile.Mip < m_Layout.NumMips && tile.X < m_Layout.GetNumTilesX(tile.Mip) &&
+           tile.Y < m_Layout.GetNumTilesY(tile.Mip);
+}
+
+void VirtualTexturePageTable::Map( const TileId &tile, uint32_t slot )
+{
+    const uint32_t entry = MakePageTableEntry(slot, tile.Mip);
+    for (uint32_t mip = tile.Mip + 1; mip-- > 0;)
+    {
+        uint32_t shift = tile.Mip - mip;
+        uint32_t beginX = tile.X << shift;
+        uint32_t beginY = tile.Y << shift;
+        uint32_t endX = std::min((tile.X + 1) << shift, m_Layout.GetNumTilesX(mip));
+        uint32_t endY = std::min((tile.Y + 1) << shift, m_Layout.GetNumTilesY(mip));
+        for (uint32_t y = beginY; y < endY; ++y)
+        {
+            for (uint32_t x = beginX; x < endX; ++x)
+            {
+                uint32_t &page = GetEntry(x, y, mip);
+                // Pages already mapped to a finer tile keep it.
+                if (GetPageTableEntryMip(page) > tile.Mip)
+                {
+                    page = entry;
+                }
+            }
+        }
+        m_Dirty[mip] = true;
+    }
+}
+
+void VirtualTexturePageTable::Unmap( const TileId &tile )
+{
+    // The last mip is pinned, so there always is a parent.
+    assert(tile.Mip + 1 < m_Layout.NumMips);
+    const uint32_t parent = GetEntry(tile.X >> 1, tile.Y >> 1, tile.Mip + 1);
+    for (uint32_t mip = tile.Mip + 1; mip-- > 0;)
+    {
+        uint32_t shift = tile.Mip - mip;
+        uint32_t beginX = tile.X << shift;
+        uint32_t beginY = tile.Y << shift;
+        uint32_t endX = std::min((tile.X + 1) << shift, m_Layout.GetNumTilesX(mip));
+        uint32_t endY = std::min((tile.Y + 1) << shift, m_Layout.GetNumTilesY(mip));
+        for (uint32_t y = beginY; y < endY; ++y)
+        {
+            for (uint32_t x = beginX; x < endX; ++x)
+            {
+                uint32_t &page = GetEntry(x, y, mip);
+                if (GetPageTableEntryMip(page) == tile.Mip)
+                {
+                    page = parent;
+                }
+            }
+        }
+        m_Dirty[mip] = true;
+    }
+}
+
+void VirtualTexturePageTable::Touch( uint32_t slot )
+{
+    if (m_Slots[slot].LastUsed == m_Frame)
+    {
+        return;
+    }
+
+    m_Slots[slot].LastUsed = m_Frame;
+    if (!m_Slots[slot].Pinned)
+    {
+        UnlinkSlot(slot);
+        LinkSlot(slot);
+    }
+}
+
+void VirtualTexturePageTable::LinkSlot( uint32_t slot )
+{
+    Slot &entry = m_Slots[slot];
+    entry.Newer = INVALID_SLOT;
+    entry.Older = m_NewestSlot;
+    if (m_NewestSlot != INVALID_SLOT)
+    {
+        m_Slots[m_NewestSlot].Newer = slot;
+    } else
+    {
+        m_OldestSlot = slot;
+    }
+    m_NewestSlot = slot;
+}
+
+void VirtualTexturePageTable::UnlinkSlot( uint32_t slot )
+{
+    Slot &entry = m_Slots[slot];
+    if (entry.Newer != INVALID_SLOT)
+    {
+        m_Slots[entry.Newer].Older = entry.Older;
+    } else
+    {
+        m_NewestSlot = entry.Older;
+    }
+    if (entry.Older != INVALID_SLOT)
+    {
+        m_Slots[entry.Older].Newer = entry.Newer;
+    } else
+    {
+        m_OldestSlot = entry.Newer;
+    }
+    entry.Newer = INVALID_SLOT;
+    entry.Older = INVALID_SLOT;
+}
+
+uint32_t VirtualTexturePageTable::AcquireSlot()
+{
+    if (!m_FreeSlots.empty())
+    {
+        uint32_t slot = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+        return slot;
+    }
+
+    // Tiles used in this update are still being sampled.
+    uint32_t slot = m_OldestSlot;
+    if (slot == INVALID_SLOT || m_Slots[slot].LastUsed == m_Frame)
+    {
+        return INVALID_SLOT;
+    }
+
+    Slot &entry = m_Slots[slot];
+    TileId tile = UnpackTileId(entry.Tile);
+    UnlinkSlot(slot);
+    Unmap(tile);
+    m_ResidentTiles.erase(entry.Tile);
+    entry.Tile = INVALID_PACKED_TILE;
+    ++m_Statistics.NumEvicted;
+    return slot;
+}
+
+}
@@ -0,0 +1,213 @@
+#ifndef VIRTUALTEXTURE_H
+#define VIRTUALTEXTURE_H
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+namespace Enterprise::Textures {
+
+/**
+ * How a virtual texture is cut into tiles. Every mip is cut into TileSize x TileSize tiles, down to the first
+ * mip that fits in a single tile, which is the last one. Tiles are stored with TileBorder extra texels of
+ * their neighbours on each side, so filtering never has to reach into another tile.
+ */
+struct VirtualTextureLayout {
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    uint32_t TileSize = 128;
+    uint32_t TileBorder = 4;
+    uint32_t NumMips = 0;
+
+    [[nodiscard]] uint32_t GetPaddedTileSize() const { return TileSize + 2 * TileBorder; }
+
+    [[nodiscard]] uint32_t GetMipWidth( uint32_t mip ) const;
+
+    [[nodiscard]] uint32_t GetMipHeight( uint32_t mip ) const;
+
+    [[nodiscard]] uint32_t GetNumTilesX( uint32_t mip ) const;
+
+    [[nodiscard]] uint32_t GetNumTilesY( uint32_t mip ) const;
+
+    // Tiles over every mip.
+    [[nodiscard]] uint32_t GetNumTiles() const;
+};
+
+// Fills in NumMips for a width x height texture. Returns false if the texture has too many tiles to address.
+bool MakeVirtualTextureLayout( uint32_t width, uint32_t height, uint32_t tileSize, uint32_t tileBorder,
+                               VirtualTextureLayout* layout );
+
+struct TileId {
+    uint32_t X = 0;
+    uint32_t Y = 0;
+    uint32_t Mip = 0;
+};
+
+//---------------------------------------------------------------------------------------------|
+// Packed tile id, as written by the feedback pass                                             |
+//---------------------------------------------------------------------------------------------|
+// bits 0-13   tile x                                                                          |
+// bits 14-27  tile y                                                                          |
+// bits 28-31  mip                                                                             |
+//---------------------------------------------------------------------------------------------|
+constexpr uint32_t INVALID_PACKED_TILE = UINT32_MAX;
+constexpr uint32_t MAX_VIRTUAL_TEXTURE_TILES = 1u << 14;
+constexpr uint32_t MAX_VIRTUAL_TEXTURE_MIPS = 16;
+
+[[nodiscard]] inline uint32_t PackTileId( const TileId &tile )
+{
+    return tile.X | (tile.Y << 14) | (tile.Mip << 28);
+}
+
+[[nodiscard]] inline TileId UnpackTileId( uint32_t packed )
+{
+    return {packed & 0x3FFF, (packed >> 14) & 0x3FFF, packed >> 28};
+}
+
+//---------------------------------------------------------------------------------------------|
+// Page table entry, one per tile of every mip                                                 |
+//---------------------------------------------------------------------------------------------|
+// bits 0-3    mip of the resident tile the page maps to, the page's own mip or a coarser one  |
+// bits 4-31   physical slot of that tile                                                      |
+//---------------------------------------------------------------------------------------------|
+[[nodiscard]] inline uint32_t MakePageTableEntry( uint32_t slot, uint32_t mip ) { return (slot << 4) | mip; }
+
+[[nodiscard]] inline uint32_t GetPageTableEntrySlot( uint32_t entry ) { return entry >> 4; }
+
+[[nodiscard]] inline uint32_t GetPageTableEntryMip( uint32_t entry ) { return entry & 0xF; }
+
+struct TileLoad {
+    TileId   Tile;
+    uint32_t Slot = 0;
+    // Set by the streamer.
+    bool     Loaded = false;
+};
+
+/**
+ * Where tiles come from and go to. The page table decides which tiles are loaded into which physical slot;
+ * the streamer reads them and copies them there, to the GPU or, in tests, nowhere at all.
+ */
+class TileStreamer {
+public:
+    virtual ~TileStreamer() = default;
+
+    /**
+     * Copy every tile of loads into its slot and set Loaded on the ones that made it. Tiles that fail stay
+     * unmapped and may be requested again.
+     */
+    virtual void LoadTiles( TileLoad* loads, size_t count ) = 0;
+};
+
+struct VirtualTextureStatistics {
+    // Distinct tiles in the feedback of the last update, and how many of them were resident.
+    uint32_t NumRequested = 0;
+    uint32_t NumRequestedResident = 0;
+    // Of the last update.
+    uint32_t NumLoaded = 0;
+    uint32_t NumEvicted = 0;
+    uint32_t NumFailed = 0;
+    // Missing tiles left for later updates, for want of load budget or evictable slots.
+    uint32_t NumDeferred = 0;
+    uint32_t NumResident = 0;
+};
+
+/**
+ * CPU side of a virtual texture: which tiles are resident in which physical slot, and the page table the
+ * shader translates virtual addresses through. Every page maps to the finest resident tile covering it, so a
+ * missing tile falls back to a blurrier one rather than to nothing. The tiles of the last mip are loaded up
+ * front and never evicted, which guarantees there always is one.
+ *
+ * Feedback from the GPU says which tiles were sampled. Update loads the missing ones, together with any
+ * missing coarser tiles above them, coarsest first and then most requested first, into free slots or the
+ * slots of the least recently used tiles. Tiles sampled in the current update are never evicted for it.
+ * Not thread safe.
+ */
+class VirtualTexturePageTable {
+public:
+    VirtualTexturePageTable( const VirtualTextureLayout &layout, uint32_t numSlots );
+
+    /**
+     * Load and pin the tiles of the last mip. Returns false if they do not fit in the slots or fail to load.
+     */
+    bool Initialize( TileStreamer &streamer );
+
+    /**
+     * Count the tiles in packed feedback, INVALID_PACKED_TILE entries and tiles outside the texture are
+     * skipped. Feedback adds up until the next Update.
+     */
+    void AddFeedback( const uint32_t* packedTiles, size_t count );
+
+    /**
+     * Load up to maxLoads of the tiles requested since the last update. Returns the number loaded.
+     */
+    uint32_t Update( TileStreamer &streamer, uint32_t maxLoads );
+
+    [[nodiscard]] const VirtualTextureLayout &GetLayout() const { return m_Layout; }
+
+    [[nodiscard]] uint32_t GetNumSlots() const { return static_cast<uint32_t>(m_Slots.size()); }
+
+    [[nodiscard]] bool IsResident( const TileId &tile ) const;
+
+    // Entries of a mip in row order, GetNumTilesX(mip) per row, see MakePageTableEntry.
+    [[nodiscard]] const std::vector<uint32_t> &GetPageTable( uint32_t mip ) const { return m_PageTable[mip]; }
+
+    // Whether a mip of the page table changed since ClearDirty, and needs uploading again.
+    [[nodiscard]] bool IsDirty( uint32_t mip ) const { return m_Dirty[mip]; }
+
+    void ClearDirty();
+
+    [[nodiscard]] const VirtualTextureStatistics &GetStatistics() const { return m_Statistics; }
+
+private:
+    static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+    struct Slot {
+        uint32_t Tile = INVALID_PACKED_TILE;
+        uint64_t LastUsed = 0;
+        bool     Pinned = false;
+        // Least recently used list of the occupied slots that are not pinned, newest first.
+        uint32_t Newer = INVALID_SLOT;
+        uint32_t Older = INVALID_SLOT;
+    };
+
+    [[nodiscard]] bool IsValidTile( const TileId &tile ) const;
+
+    [[nodiscard]] uint32_t &GetEntry( uint32_t x, uint32_t y, uint32_t mip )
+    {
+        return m_PageTable[mip][size_t(y) * m_Layout.GetNumTilesX(mip) + x];
+    }
+
+    // Point every page covered by tile at slot, unless a finer tile is resident there.
+    void Map( const TileId &tile, uint32_t slot );
+
+    // Point the pages that mapped to tile at whatever its parent maps to.
+    void Unmap( const TileId &tile );
+
+    // Mark a slot as used in this update, moving it to the front of the LRU list.
+    void Touch( uint32_t slot );
+
+    void LinkSlot( uint32_t slot );
+
+    void UnlinkSlot( uint32_t slot );
+
+    // A free slot, or the least recently used one not used in this update. INVALID_SLOT if there is none.
+    uint32_t AcquireSlot();
+
+    VirtualTextureLayout                   m_Layout;
+    std::vector<Slot>                      m_Slots;
+    std::vector<uint32_t>                  m_FreeSlots;
+    uint32_t                               m_NewestSlot = INVALID_SLOT;
+    uint32_t                               m_OldestSlot = INVALID_SLOT;
+    std::unordered_map<uint32_t, uint32_t> m_ResidentTiles;
+    std::vector<std::vector<uint32_t> >    m_PageTable;
+    std::vector<bool>                      m_Dirty;
+    // Requests per packed tile since the last update.
+    std::unordered_map<uint32_t, uint32_t> m_Requests;
+    uint64_t                               m_Frame = 0;
+    VirtualTextureStatistics               m_Statistics;
+};
+
+}
+
+#endif //VIRTUALTEXTURE_H
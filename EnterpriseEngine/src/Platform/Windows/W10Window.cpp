@@ -158,6 +158,25 @@ LRESULT W10Window::ProcessMessage(UINT msg, WPARAM wParam, LPARAM lParam)
             }
             break;
         }
+        // Clicks carry the cursor position in client pixels, unlike the raw input deltas below.
+        case WM_LBUTTONDOWN:
+        case WM_RBUTTONDOWN:
+        case WM_MBUTTONDOWN:
+        {
+            events::MouseCoords coords{};
+            coords.x = static_cast<SHORT>(GET_X_LPARAM(lParam));
+            coords.y = static_cast<SHORT>(GET_Y_LPARAM(lParam));
+            events::MouseButton buttons{};
+            buttons.LMB = (wParam & MK_LBUTTON) != 0;
+            buttons.RMB = (wParam & MK_RBUTTON) != 0;
+            buttons.MMB = (wParam & MK_MBUTTON) != 0;
+            buttons.CTRL = (wParam & MK_CONTROL) != 0;
+            buttons.SHIFT = (wParam & MK_SHIFT) != 0;
+            buttons.XBUTTON_1 = (wParam & MK_XBUTTON1) != 0;
+            buttons.XBOTTON_2 = (wParam & MK_XBUTTON2) != 0;
+            events::TriggerEvent(events::MouseEvent(buttons, coords));
+            break;
+        }
         case WM_INPUT:
         {
             unsigned size = sizeof(RAWINPUT);
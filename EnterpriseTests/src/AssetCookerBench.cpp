@@ -0,0 +1,64 @@
+#include <cstdio>
+#include <fstream>
+
+#include "Test.h"
+#include "TestImages.h"
+#include "TestMeshes.h"
+#include "Enterprise/Assets/AssetCooker.h"
+
+using namespace Enterprise;
+
+namespace {
+
+constexpr uint32_t NUM_MODELS = 8;
+constexpr uint32_t NUM_TEXTURES = 16;
+constexpr uint32_t TEXTURE_SIZE = 256;
+
+void PrintStatistics( const char* name, const Assets::AssetCookStatistics &statistics )
+{
+    std::printf("%-6s %8.1f ms, %3u cooked, %3u up to date, %6.1f MB/s, hit rate %5.1f%%\n", name,
+                statistics.Seconds * 1e3, statistics.NumCooked, statistics.NumUpToDate,
+                statistics.GetMegabytesPerSecond(), statistics.GetCacheHitRate() * 100.0);
+}
+
+}
+
+int main()
+{
+    auto directory = Tests::MakeTempDirectory("AssetCookerBench");
+    auto source = directory / "source";
+    std::filesystem::create_directories(source);
+    for (uint32_t i = 0; i < NUM_MODELS; ++i)
+    {
+        Tests::WriteObj(source / ("model" + std::to_string(i) + ".obj"), {Tests::MakeGridMesh(48, 0.05f, i + 1)});
+    }
+    for (uint32_t i = 0; i < NUM_TEXTURES; ++i)
+    {
+        auto          file = Tests::EncodeTga(Tests::MakeImage(TEXTURE_SIZE, TEXTURE_SIZE, i + 1), TEXTURE_SIZE,
+                                              TEXTURE_SIZE);
+        std::ofstream stream(source / ("texture" + std::to_string(i) + ".tga"), std::ios::binary);
+        stream.write(reinterpret_cast<const char *>(file.data()), static_cast<std::streamsize>(file.size()));
+    }
+
+    Assets::AssetCookSettings settings;
+    settings.Texture.Format = Textures::TextureFormat::BC1;
+    Assets::AssetCooker cooker(source.string(), (directory / "output").string(), (directory / "cache").string(),
+                               settings);
+
+    // Cold cooks everything, warm only hashes the sources, and a cook after the manifest is lost rebuilds every
+    // output from the cache.
+    Assets::AssetCookStatistics cold;
+    Assets::AssetCookStatistics warm;
+    Assets::AssetCookStatistics cached;
+    EE_CHECK(cooker.Cook(&cold) && cold.NumCooked == NUM_MODELS + NUM_TEXTURES);
+    EE_CHECK(cooker.Cook(&warm) && warm.NumUpToDate == NUM_MODELS + NUM_TEXTURES);
+    std::filesystem::remove(directory / "cache" / "manifest.txt");
+    EE_CHECK(cooker.Cook(&cached) && cached.MeshMisses == 0 && cached.TextureMisses == 0);
+
+    std::printf("%u models, %u %ux%u textures\n", NUM_MODELS, NUM_TEXTURES, TEXTURE_SIZE, TEXTURE_SIZE);
+    PrintStatistics("cold", cold);
+    PrintStatistics("warm", warm);
+    PrintStatistics("cached", cached);
+    std::printf("warm cook hashes %.1f MB in %.1f ms\n", double(warm.HashedBytes) * 1e-6, warm.Seconds * 1e3);
+    return Tests::Finish();
+}
@@ -0,0 +1,138 @@
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include "Test.h"
+#include "TestImages.h"
+#include "TestMeshes.h"
+#include "Enterprise/Assets/AssetCooker.h"
+#include "Enterprise/Assets/ContentHash.h"
+#include "Enterprise/Assets/CookedModel.h"
+
+using namespace Enterprise;
+
+namespace {
+
+struct CookDirectories {
+    std::filesystem::path Source;
+    std::filesystem::path Output;
+    std::filesystem::path Cache;
+};
+
+void WriteTexture( const std::filesystem::path &path, uint32_t size, uint32_t seed )
+{
+    auto          file = Tests::EncodeTga(Tests::MakeImage(size, size, seed), size, size);
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char *>(file.data()), static_cast<std::streamsize>(file.size()));
+}
+
+Assets::AssetCookStatistics Cook( const CookDirectories &directories, bool force = false )
+{
+    Assets::AssetCookSettings settings;
+    settings.Texture.Format = Textures::TextureFormat::BC1;
+    settings.Texture.Quality = Textures::CompressionQuality::Fast;
+    settings.Force = force;
+
+    Assets::AssetCooker         cooker(directories.Source.string(), directories.Output.string(),
+                                       directories.Cache.string(), settings);
+    Assets::AssetCookStatistics statistics;
+    EE_CHECK(cooker.Cook(&statistics));
+    return statistics;
+}
+
+void TestIncrementalCook( const CookDirectories &directories )
+{
+    Tests::WriteObj(directories.Source / "grid.obj", {Tests::MakeGridMesh(8)});
+    WriteTexture(directories.Source / "a.tga", 32, 1);
+    WriteTexture(directories.Source / "b.tga", 32, 2);
+
+    auto cold = Cook(directories);
+    EE_CHECK(cold.NumAssets == 3 && cold.NumCooked == 3 && cold.NumUpToDate == 0);
+    EE_CHECK(cold.MeshMisses == 1 && cold.TextureMisses == 2);
+    EE_CHECK(std::filesystem::exists(directories.Output / "grid.obj.emdl"));
+    EE_CHECK(std::filesystem::exists(directories.Output / "a.tga.etex"));
+
+    Assets::CookedModel model;
+    EE_CHECK(model.Open((directories.Output / "grid.obj.emdl").string()) && model.GetNumMeshes() == 1);
+
+    // Nothing changed, nothing is cooked.
+    auto warm = Cook(directories);
+    EE_CHECK(warm.NumUpToDate == 3 && warm.NumCooked == 0);
+    EE_CHECK(warm.GetCacheHitRate() == 1.0);
+
+    // Only the edited texture is cooked again.
+    WriteTexture(directories.Source / "b.tga", 32, 3);
+    auto edited = Cook(directories);
+    EE_CHECK(edited.NumUpToDate == 2 && edited.NumCooked == 1);
+    EE_CHECK(edited.TextureMisses == 1 && edited.MeshMisses == 0);
+
+    // Forcing cooks everything, past the cache too.
+    auto forced = Cook(directories, true);
+    EE_CHECK(forced.NumCooked == 3 && forced.MeshHits == 0 && forced.TextureHits == 0);
+}
+
+// Copies under other names, or whose files differ only in ways the import does not see, reuse the cache entries
+// of the original.
+void TestContentDeduplication( const CookDirectories &directories )
+{
+    std::filesystem::copy_file(directories.Source / "a.tga", directories.Source / "a copy.tga");
+    Tests::WriteObj(directories.Source / "grid copy.obj", {Tests::MakeGridMesh(8)});
+    std::ofstream(directories.Source / "grid copy.obj", std::ios::app) << "# Exported again\n";
+
+    auto statistics = Cook(directories);
+    EE_CHECK(statistics.NumCooked == 2 && statistics.NumUpToDate == 3);
+    EE_CHECK(statistics.TextureHits == 1 && statistics.TextureMisses == 0);
+    EE_CHECK(statistics.MeshHits == 1 && statistics.MeshMisses == 0);
+
+    // Removing the sources prunes the cache entries only they used.
+    size_t numEntries = 0;
+    for (const auto &entry: std::filesystem::recursive_directory_iterator(directories.Cache))
+    {
+        numEntries += entry.is_regular_file() && entry.path().extension() == ".etex";
+    }
+    std::filesystem::remove(directories.Source / "b.tga");
+    Cook(directories);
+    size_t numPruned = numEntries;
+    for (const auto &entry: std::filesystem::recursive_directory_iterator(directories.Cache))
+    {
+        numPruned -= entry.is_regular_file() && entry.path().extension() == ".etex";
+    }
+    EE_CHECK(numPruned == 1);
+}
+
+void TestContentHash()
+{
+    static const uint8_t bytes[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    EE_CHECK(Assets::HashContent(bytes, sizeof(bytes)) == Assets::HashContent(bytes, sizeof(bytes)));
+    EE_CHECK(Assets::HashContent(bytes, sizeof(bytes)) != Assets::HashContent(bytes, sizeof(bytes) - 1));
+
+    // Values are chained, so the same values in another order, or split differently, hash differently.
+    auto hash = []( std::initializer_list<std::pair<size_t, size_t> > pieces )
+    {
+        Assets::ContentHasher hasher;
+        for (const auto &[offset, size]: pieces)
+        {
+            hasher.Add(bytes + offset, size);
+        }
+        return hasher.GetHash();
+    };
+    EE_CHECK(hash({{0, 4}, {4, 5}}) == hash({{0, 4}, {4, 5}}));
+    EE_CHECK(hash({{0, 4}, {4, 5}}) != hash({{4, 5}, {0, 4}}));
+    EE_CHECK(hash({{0, 4}, {4, 5}}) != hash({{0, 5}, {5, 4}}));
+}
+
+}
+
+int main()
+{
+    auto            directory = Tests::MakeTempDirectory("AssetCookerTests");
+    CookDirectories directories = {directory / "source", directory / "output", directory / "cache"};
+    std::filesystem::create_directories(directories.Source);
+
+    TestContentHash();
+    TestIncrementalCook(directories);
+    TestContentDeduplication(directories);
+    return Tests::Finish();
+}
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "Test.h"
+#include "TestImages.h"
+#include "Enterprise/Textures/BlockCompression.h"
+
+using namespace Enterprise;
+using Textures::CompressionQuality;
+using Textures::TextureFormat;
+
+namespace {
+
+// Not a multiple of four, so the blocks over the edges are encoded too.
+constexpr uint32_t WIDTH = 190;
+constexpr uint32_t HEIGHT = 126;
+
+struct FormatInfo {
+    TextureFormat Format;
+    const char*   Name;
+    // Channels the format keeps, and the PSNR over them Normal quality must reach on the test image.
+    int           NumChannels;
+    double        MinPSNR;
+};
+
+double GetPSNR( const std::vector<uint8_t> &a, const std::vector<uint8_t> &b, int numChannels )
+{
+    double squaredError = 0.0;
+    for (size_t i = 0; i < a.size(); i += 4)
+    {
+        for (int c = 0; c < numChannels; ++c)
+        {
+            double error = double(a[i + c]) - double(b[i + c]);
+            squaredError += error * error;
+        }
+    }
+    double meanSquaredError = std::max(squaredError / double(a.size() / 4 * numChannels), 1e-10);
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
+
+}
+
+int main()
+{
+    const FormatInfo formats[] = {
+        {TextureFormat::BC1, "BC1", 3, 32.0},
+        {TextureFormat::BC3, "BC3", 4, 32.0},
+        {TextureFormat::BC4, "BC4", 1, 36.0},
+        {TextureFormat::BC5, "BC5", 2, 36.0},
+        {TextureFormat::BC7, "BC7", 4, 35.0},
+    };
+    const char* qualityNames[] = {"fast", "normal", "high"};
+
+    const std::vector<uint8_t> image = Tests::MakeImage(WIDTH, HEIGHT);
+    for (const auto &info: formats)
+    {
+        double previousPSNR = 0.0;
+        for (int quality = 0; quality < 3; ++quality)
+        {
+            std::vector<uint8_t> compressed(Textures::GetSurfaceSize(info.Format, WIDTH, HEIGHT));
+            Tests::Timer         timer;
+            Textures::CompressSurface(info.Format, CompressionQuality(quality), image.data(), WIDTH, HEIGHT,
+                                      WIDTH * 4, 0, Textures::GetNumRows(info.Format, HEIGHT), compressed.data());
+            double milliseconds = timer.GetMilliseconds();
+
+            std::vector<uint8_t> decompressed(image.size());
+            Textures::DecompressSurface(info.Format, compressed.data(), WIDTH, HEIGHT, decompressed.data());
+            double psnr = GetPSNR(image, decompressed, info.NumChannels);
+            if (quality == int(CompressionQuality::Normal))
+            {
+                EE_CHECK(psnr >= info.MinPSNR);
+            }
+            // Slower settings only search more candidates, they never pick a worse one by much.
+            EE_CHECK(psnr >= previousPSNR - 0.25);
+            previousPSNR = psnr;
+
+            std::printf("%s %-6s PSNR %6.2f dB %8.2f MPix/s\n", info.Name, qualityNames[quality], psnr,
+                        WIDTH * HEIGHT / milliseconds / 1000.0);
+        }
+    }
+    return Tests::Finish();
+}
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Geometry/Bounds.h"
+#include "Enterprise/Geometry/Meshlets.h"
+
+using namespace Enterprise;
+using Geometry::MeshBounds;
+
+namespace {
+
+constexpr int NUM_RUNS = 20;
+
+template<typename Cull>
+double TimeBest( Cull cull )
+{
+    double best = 1e30;
+    for (int run = 0; run < NUM_RUNS; ++run)
+    {
+        Tests::Timer timer;
+        cull();
+        best = std::min(best, timer.GetMilliseconds());
+    }
+    return best;
+}
+
+}
+
+int main()
+{
+    constexpr float NEAR_Z = 0.1f;
+    constexpr float FAR_Z = 100.0f;
+
+    float yScale = 1.0f / std::tan(0.5f);
+    float projection[16] = {yScale / 1.5f, 0.0f, 0.0f, 0.0f,
+                            0.0f, yScale, 0.0f, 0.0f,
+                            0.0f, 0.0f, FAR_Z / (FAR_Z - NEAR_Z), 1.0f,
+                            0.0f, 0.0f, -NEAR_Z * FAR_Z / (FAR_Z - NEAR_Z), 0.0f};
+    float planes[6][4];
+    Geometry::ExtractFrustumPlanes(projection, planes);
+
+    std::mt19937                          random(3);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    for (uint32_t numObjects: {10000u, 100000u, 1000000u})
+    {
+        Geometry::BoundsCuller  culler;
+        std::vector<MeshBounds> objects;
+        for (uint32_t i = 0; i < numObjects; ++i)
+        {
+            float      center[3] = {value(random) * 100.0f, value(random) * 100.0f, value(random) * 100.0f + 50.0f};
+            float      extent = std::fabs(value(random)) * 3.0f;
+            MeshBounds bounds = {};
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                bounds.Box.Min[axis] = center[axis] - extent;
+                bounds.Box.Max[axis] = center[axis] + extent;
+                bounds.Sphere.Center[axis] = center[axis];
+            }
+            bounds.Sphere.Radius = extent * 1.7320508f;
+            culler.Add(bounds);
+            objects.push_back(bounds);
+        }
+
+        std::vector<uint32_t> visible;
+        visible.reserve(numObjects);
+        double serialTime = TimeBest([&] { culler.Cull(planes, &visible); });
+        double parallelTime = TimeBest([&] { culler.Cull(planes, &visible, true); });
+        size_t numVisible = visible.size();
+
+        // What the renderer did before: one sphere at a time from an array of structures.
+        std::vector<uint32_t> scalarVisible;
+        scalarVisible.reserve(numObjects);
+        double scalarTime = TimeBest([&]
+        {
+            scalarVisible.clear();
+            for (uint32_t i = 0; i < numObjects; ++i)
+            {
+                const auto &sphere = objects[i].Sphere;
+                bool        outside = false;
+                for (int plane = 0; plane < 6 && !outside; ++plane)
+                {
+                    outside = planes[plane][0] * sphere.Center[0] + planes[plane][1] * sphere.Center[1] +
+                              planes[plane][2] * sphere.Center[2] + planes[plane][3] < -sphere.Radius;
+                }
+                if (!outside)
+                {
+                    scalarVisible.push_back(i);
+                }
+            }
+        });
+        // The box test only ever removes more.
+        EE_CHECK(numVisible <= scalarVisible.size());
+
+        std::printf("%8u objects, %7zu visible: simd %8.3f ms, parallel %8.3f ms, scalar spheres %8.3f ms\n",
+                    numObjects, numVisible, serialTime, parallelTime, scalarTime);
+    }
+    return Tests::Finish();
+}
@@ -0,0 +1,274 @@
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "TestMeshes.h"
+#include "Enterprise/Assets/CookedModel.h"
+#include "Enterprise/Geometry/Bounds.h"
+#include "Enterprise/Geometry/Meshlets.h"
+
+using namespace Enterprise;
+using Geometry::MeshBounds;
+
+namespace {
+
+// A 1 radian perspective looking down +z, row vectors as DirectXMath.
+void MakeFrustumPlanes( float planes[6][4] )
+{
+    constexpr float ASPECT = 1.5f;
+    constexpr float NEAR_Z = 0.1f;
+    constexpr float FAR_Z = 100.0f;
+
+    float yScale = 1.0f / std::tan(0.5f);
+    float xScale = yScale / ASPECT;
+    float projection[16] = {xScale, 0.0f, 0.0f, 0.0f,
+                            0.0f, yScale, 0.0f, 0.0f,
+                            0.0f, 0.0f, FAR_Z / (FAR_Z - NEAR_Z), 1.0f,
+                            0.0f, 0.0f, -NEAR_Z * FAR_Z / (FAR_Z - NEAR_Z), 0.0f};
+    Geometry::ExtractFrustumPlanes(projection, planes);
+}
+
+// Visible unless the box or the sphere is entirely outside a plane, one object at a time.
+bool IsVisible( const MeshBounds &bounds, const float planes[6][4] )
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        const float* plane = planes[i];
+        float        box = plane[3];
+        float        sphere = plane[3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            box += plane[axis] * (plane[axis] >= 0.0f ? bounds.Box.Max[axis] : bounds.Box.Min[axis]);
+            sphere += plane[axis] * bounds.Sphere.Center[axis];
+        }
+        if (box < 0.0f || sphere < -bounds.Sphere.Radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TestComputeMeshBounds()
+{
+    std::mt19937                          random(3);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    bool                                  contained = true;
+    for (int run = 0; run < 200; ++run)
+    {
+        // Positions four floats apart, as in a vertex with more attributes.
+        size_t             numVertices = 1 + random() % 500;
+        std::vector<float> positions(numVertices * 4);
+        for (float &position: positions)
+        {
+            position = value(random) * float(1 + run);
+        }
+        auto bounds = Geometry::ComputeMeshBounds(positions.data(), numVertices, 4 * sizeof(float));
+        for (size_t i = 0; i < numVertices; ++i)
+        {
+            const float* position = &positions[i * 4];
+            float        distance = 0.0f;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                contained &= position[axis] >= bounds.Box.Min[axis] && position[axis] <= bounds.Box.Max[axis];
+                distance += (position[axis] - bounds.Sphere.Center[axis]) * (position[axis] - bounds.Sphere.Center[axis]);
+            }
+            contained &= std::sqrt(distance) <= bounds.Sphere.Radius;
+        }
+    }
+    EE_CHECK(contained);
+    EE_CHECK(Geometry::ComputeMeshBounds(nullptr, 0, 12).Sphere.Radius == 0.0f);
+}
+
+// Whether the box and the sphere of bounds both hold point.
+bool Contains( const MeshBounds &bounds, const float point[3] )
+{
+    constexpr float TOLERANCE = 1e-4f;
+
+    float distance = 0.0f;
+    bool  inBox = true;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        inBox &= point[axis] >= bounds.Box.Min[axis] - TOLERANCE && point[axis] <= bounds.Box.Max[axis] + TOLERANCE;
+        distance += (point[axis] - bounds.Sphere.Center[axis]) * (point[axis] - bounds.Sphere.Center[axis]);
+    }
+    return inBox && std::sqrt(distance) <= bounds.Sphere.Radius + TOLERANCE;
+}
+
+void TestMergeBounds()
+{
+    auto grid = Tests::MakeGridMesh(4);
+    auto sphere = Tests::MakeSphereMesh(6, 8, 2.0f, 5.0f, 1.0f, -3.0f);
+    auto inner = Tests::MakeSphereMesh(6, 8, 0.5f, 5.0f, 1.0f, -3.0f);
+    auto bounds = []( const Assets::MeshData &mesh )
+    {
+        return Geometry::ComputeMeshBounds(mesh.Vertices[0].Position, mesh.Vertices.size(),
+                                           sizeof(Assets::MeshVertex));
+    };
+
+    MeshBounds both = Geometry::MergeBounds(bounds(grid), bounds(sphere));
+    bool       contained = true;
+    for (const auto* mesh: {&grid, &sphere})
+    {
+        for (const auto &vertex: mesh->Vertices)
+        {
+            contained &= Contains(both, vertex.Position);
+        }
+    }
+    EE_CHECK(contained);
+
+    // A sphere inside the other leaves it as it is.
+    MeshBounds sphereBounds = bounds(sphere);
+    MeshBounds outer = Geometry::MergeBounds(bounds(inner), sphereBounds);
+    EE_CHECK(std::memcmp(&outer.Sphere, &sphereBounds.Sphere, sizeof(Geometry::BoundingSphere)) == 0);
+
+    MeshBounds infinite = Geometry::GetInfiniteBounds();
+    MeshBounds merged = Geometry::MergeBounds(bounds(grid), infinite);
+    EE_CHECK(std::memcmp(&merged, &infinite, sizeof(MeshBounds)) == 0);
+}
+
+void TestTransformBounds()
+{
+    auto       sphere = Tests::MakeSphereMesh(8, 12, 1.5f, 1.0f, -2.0f, 0.5f);
+    MeshBounds bounds = Geometry::ComputeMeshBounds(sphere.Vertices[0].Position, sphere.Vertices.size(),
+                                                    sizeof(Assets::MeshVertex));
+
+    // A rotation about y and x, an uneven scale and a translation, rows as the images of the axes.
+    float c = std::cos(0.7f);
+    float s = std::sin(0.7f);
+    float scale[3] = {2.0f, 0.5f, 3.0f};
+    float rotation[3][3] = {{c, 0.0f, -s}, {s * s, c, c * s}, {c * s, -s, c * c}};
+    float matrix[16] = {};
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            matrix[i * 4 + j] = rotation[i][j] * scale[i];
+        }
+    }
+    matrix[12] = 10.0f;
+    matrix[13] = -4.0f;
+    matrix[14] = 7.0f;
+    matrix[15] = 1.0f;
+
+    MeshBounds moved = Geometry::TransformBounds(bounds, matrix);
+    bool       contained = true;
+    for (const auto &vertex: sphere.Vertices)
+    {
+        float point[3];
+        for (int j = 0; j < 3; ++j)
+        {
+            point[j] = matrix[12 + j];
+            for (int i = 0; i < 3; ++i)
+            {
+                point[j] += vertex.Position[i] * matrix[i * 4 + j];
+            }
+        }
+        contained &= Contains(moved, point);
+    }
+    EE_CHECK(contained);
+    EE_CHECK(std::fabs(moved.Sphere.Radius - bounds.Sphere.Radius * 3.0f) < 1e-4f);
+
+    float identity[16] = {1.0f, 0.0f, 0.0f, 0.0f,
+                          0.0f, 1.0f, 0.0f, 0.0f,
+                          0.0f, 0.0f, 1.0f, 0.0f,
+                          0.0f, 0.0f, 0.0f, 1.0f};
+    MeshBounds same = Geometry::TransformBounds(bounds, identity);
+    EE_CHECK(std::memcmp(&same, &bounds, sizeof(MeshBounds)) == 0);
+
+    // Infinite bounds would turn into NaN through the matrix.
+    MeshBounds infinite = Geometry::GetInfiniteBounds();
+    MeshBounds movedInfinite = Geometry::TransformBounds(infinite, matrix);
+    EE_CHECK(std::memcmp(&movedInfinite, &infinite, sizeof(MeshBounds)) == 0);
+}
+
+void TestCull()
+{
+    float planes[6][4];
+    MakeFrustumPlanes(planes);
+
+    // Boxes scattered around the frustum, an odd number so the last group of four is padded.
+    std::mt19937                          random(3);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    Geometry::BoundsCuller                culler;
+    std::vector<MeshBounds>               objects;
+    for (uint32_t i = 0; i < 10003; ++i)
+    {
+        float      center[3] = {value(random) * 100.0f, value(random) * 100.0f, value(random) * 100.0f + 50.0f};
+        float      extent = std::fabs(value(random)) * 3.0f;
+        MeshBounds bounds = {};
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            bounds.Box.Min[axis] = center[axis] - extent;
+            bounds.Box.Max[axis] = center[axis] + extent;
+            bounds.Sphere.Center[axis] = center[axis];
+        }
+        bounds.Sphere.Radius = extent * 1.7320508f;
+        objects.push_back(bounds);
+        EE_CHECK(culler.Add(bounds) == i);
+    }
+    objects.push_back(Geometry::GetInfiniteBounds());
+    culler.Add(objects.back());
+
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < objects.size(); ++i)
+    {
+        if (IsVisible(objects[i], planes))
+        {
+            expected.push_back(i);
+        }
+    }
+    std::vector<uint32_t> visible;
+    std::vector<uint32_t> visibleParallel;
+    EE_CHECK(culler.Cull(planes, &visible) == expected.size() && visible == expected);
+    culler.Cull(planes, &visibleParallel, true);
+    EE_CHECK(visibleParallel == expected);
+    EE_CHECK(!expected.empty() && expected.size() < objects.size() && expected.back() == objects.size() - 1);
+
+    // Replacing the infinite bounds with the first object's.
+    uint32_t last = culler.GetCount() - 1;
+    culler.Set(last, objects[0]);
+    culler.Cull(planes, &visible);
+    EE_CHECK((visible.back() == last) == IsVisible(objects[0], planes));
+
+    culler.Clear();
+    EE_CHECK(culler.Cull(planes, &visible) == 0 && culler.GetCount() == 0);
+}
+
+void TestCookedBounds( const std::filesystem::path &directory )
+{
+    Assets::ModelData model;
+    model.Meshes.push_back(Tests::MakeGridMesh(4));
+    model.Meshes.push_back(Tests::MakeSphereMesh(6, 8, 2.0f, 1.0f, 2.0f, 3.0f));
+    model.Materials.resize(1);
+    for (auto &mesh: model.Meshes)
+    {
+        mesh.Bounds = Geometry::ComputeMeshBounds(mesh.Vertices[0].Position, mesh.Vertices.size(),
+                                                  sizeof(Assets::MeshVertex));
+    }
+
+    auto path = (directory / "model.emdl").string();
+    EE_CHECK(Assets::WriteCookedModel(path, model));
+    Assets::CookedModel cooked;
+    if (EE_CHECK(cooked.Open(path)))
+    {
+        for (uint32_t i = 0; i < model.Meshes.size(); ++i)
+        {
+            EE_CHECK(std::memcmp(&cooked.GetMeshBounds(i), &model.Meshes[i].Bounds, sizeof(MeshBounds)) == 0);
+        }
+    }
+}
+
+}
+
+int main()
+{
+    TestComputeMeshBounds();
+    TestMergeBounds();
+    TestTransformBounds();
+    TestCull();
+    TestCookedBounds(Tests::MakeTempDirectory("BoundsTests"));
+    return Tests::Finish();
+}
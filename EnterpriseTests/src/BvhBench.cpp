@@ -0,0 +1,139 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Geometry/Bvh.h"
+
+using namespace Enterprise;
+
+namespace {
+
+constexpr uint32_t GRID_SIZE = 300;
+constexpr uint32_t IMAGE_SIZE = 256;
+constexpr uint32_t NUM_BOXES = 100000;
+
+}
+
+int main()
+{
+    // A heightfield of 180k triangles, seen from above.
+    std::vector<float>    positions;
+    std::vector<uint32_t> indices;
+    for (uint32_t y = 0; y <= GRID_SIZE; ++y)
+    {
+        for (uint32_t x = 0; x <= GRID_SIZE; ++x)
+        {
+            positions.insert(positions.end(), {float(x) / GRID_SIZE, 0.05f * std::sin(x * 0.1f) * std::cos(y * 0.13f),
+                                               float(y) / GRID_SIZE});
+        }
+    }
+    for (uint32_t y = 0; y < GRID_SIZE; ++y)
+    {
+        for (uint32_t x = 0; x < GRID_SIZE; ++x)
+        {
+            uint32_t corner = y * (GRID_SIZE + 1) + x;
+            indices.insert(indices.end(), {corner, corner + 1, corner + GRID_SIZE + 1,
+                                           corner + 1, corner + GRID_SIZE + 2, corner + GRID_SIZE + 1});
+        }
+    }
+
+    Geometry::TriangleBvh bvh;
+    for (bool parallel: {false, true})
+    {
+        Tests::Timer timer;
+        bvh.Build(positions.data(), positions.size() / 3, 3 * sizeof(float), indices.data(), indices.size(),
+                  parallel);
+        std::printf("%zu triangles, %s build %8.2f ms, %zu nodes\n", indices.size() / 3,
+                    parallel ? "parallel" : "serial  ", timer.GetMilliseconds(), bvh.GetBvh().GetNodes().size());
+    }
+
+    // One ray per pixel, traced alone and in 2x2 packets.
+    auto makeRay = []( uint32_t x, uint32_t y )
+    {
+        return Geometry::Ray{{0.5f, 1.0f, -0.5f},
+                             {(x + 0.5f) / IMAGE_SIZE - 0.5f, -1.0f, (y + 0.5f) / IMAGE_SIZE + 0.5f}};
+    };
+    uint32_t     numSingleHits = 0;
+    Tests::Timer timer;
+    for (uint32_t y = 0; y < IMAGE_SIZE; ++y)
+    {
+        for (uint32_t x = 0; x < IMAGE_SIZE; ++x)
+        {
+            Geometry::RayHit hit;
+            numSingleHits += bvh.Intersect(makeRay(x, y), &hit) ? 1 : 0;
+        }
+    }
+    double singleTime = timer.GetMilliseconds();
+
+    uint32_t numPacketHits = 0;
+    timer.Reset();
+    for (uint32_t y = 0; y < IMAGE_SIZE; y += 2)
+    {
+        for (uint32_t x = 0; x < IMAGE_SIZE; x += 2)
+        {
+            Geometry::RayPacket packet;
+            for (uint32_t lane = 0; lane < 4; ++lane)
+            {
+                auto ray = makeRay(x + (lane & 1), y + (lane >> 1));
+                packet.OriginX[lane] = ray.Origin[0];
+                packet.OriginY[lane] = ray.Origin[1];
+                packet.OriginZ[lane] = ray.Origin[2];
+                packet.DirectionX[lane] = ray.Direction[0];
+                packet.DirectionY[lane] = ray.Direction[1];
+                packet.DirectionZ[lane] = ray.Direction[2];
+            }
+            Geometry::RayHit hits[4];
+            uint32_t         mask = bvh.Intersect(packet, hits);
+            for (uint32_t lane = 0; lane < 4; ++lane)
+            {
+                numPacketHits += (mask >> lane) & 1;
+            }
+        }
+    }
+    double packetTime = timer.GetMilliseconds();
+    EE_CHECK(numSingleHits == numPacketHits && numSingleHits > 0);
+    double numRays = double(IMAGE_SIZE) * IMAGE_SIZE;
+    std::printf("rays: single %6.2f Mrays/s, packets %6.2f Mrays/s\n", numRays / singleTime * 1e-3,
+                numRays / packetTime * 1e-3);
+
+    // Frustum queries over scattered boxes, against testing every one.
+    std::mt19937                          random(3);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::vector<Geometry::BoundingBox>    boxes(NUM_BOXES);
+    Geometry::BoundsCuller                culler;
+    for (auto &box: boxes)
+    {
+        Geometry::MeshBounds bounds = {};
+        float                extent = std::fabs(value(random));
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float center = value(random) * 100.0f;
+            box.Min[axis] = center - extent;
+            box.Max[axis] = center + extent;
+            bounds.Sphere.Center[axis] = center;
+        }
+        bounds.Box = box;
+        bounds.Sphere.Radius = extent * 1.7320508f;
+        culler.Add(bounds);
+    }
+    Geometry::Bvh boxBvh;
+    boxBvh.Build(boxes.data(), NUM_BOXES);
+
+    // A box of 40 units on a side at the center.
+    float planes[6][4] = {{1, 0, 0, 20}, {-1, 0, 0, 20}, {0, 1, 0, 20}, {0, -1, 0, 20}, {0, 0, 1, 20}, {0, 0, -1, 20}};
+    std::vector<uint32_t> visible;
+    timer.Reset();
+    boxBvh.CullFrustum(planes, &visible);
+    double bvhTime = timer.GetMilliseconds();
+    size_t numBvhVisible = visible.size();
+    visible.clear();
+    timer.Reset();
+    culler.Cull(planes, &visible);
+    double cullerTime = timer.GetMilliseconds();
+    EE_CHECK(numBvhVisible >= visible.size());
+    std::printf("%u boxes, %zu visible: bvh %8.3f ms, every box %8.3f ms\n", NUM_BOXES, numBvhVisible, bvhTime,
+                cullerTime);
+    return Tests::Finish();
+}
@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Geometry/Bvh.h"
+
+using namespace Enterprise;
+using Geometry::BoundingBox;
+using Geometry::Ray;
+using Geometry::RayHit;
+
+namespace {
+
+// Moller-Trumbore in double precision.
+bool IntersectTriangle( const Ray &ray, const float* p0, const float* p1, const float* p2, double* distance )
+{
+    double edge1[3], edge2[3], offset[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        edge1[i] = p1[i] - p0[i];
+        edge2[i] = p2[i] - p0[i];
+        offset[i] = ray.Origin[i] - p0[i];
+    }
+    const float* d = ray.Direction;
+    double       p[3] = {d[1] * edge2[2] - d[2] * edge2[1], d[2] * edge2[0] - d[0] * edge2[2],
+                         d[0] * edge2[1] - d[1] * edge2[0]};
+    double       q[3] = {offset[1] * edge1[2] - offset[2] * edge1[1], offset[2] * edge1[0] - offset[0] * edge1[2],
+                         offset[0] * edge1[1] - offset[1] * edge1[0]};
+    double       determinant = edge1[0] * p[0] + edge1[1] * p[1] + edge1[2] * p[2];
+    if (determinant == 0.0)
+    {
+        return false;
+    }
+    double u = (offset[0] * p[0] + offset[1] * p[1] + offset[2] * p[2]) / determinant;
+    double v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) / determinant;
+    *distance = (edge2[0] * q[0] + edge2[1] * q[1] + edge2[2] * q[2]) / determinant;
+    return u >= 0.0 && v >= 0.0 && u + v <= 1.0 && *distance >= 0.0 && *distance <= ray.MaxDistance;
+}
+
+bool IsBoxVisible( const BoundingBox &box, const float planes[6][4] )
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        float distance = planes[i][3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            distance += planes[i][axis] * (planes[i][axis] >= 0.0f ? box.Max[axis] : box.Min[axis]);
+        }
+        if (distance < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IntersectBox( const BoundingBox &box, const Ray &ray )
+{
+    double enter = 0.0;
+    double leave = ray.MaxDistance;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (ray.Direction[axis] == 0.0f)
+        {
+            if (ray.Origin[axis] < box.Min[axis] || ray.Origin[axis] > box.Max[axis])
+            {
+                return false;
+            }
+            continue;
+        }
+        double near = (box.Min[axis] - ray.Origin[axis]) / double(ray.Direction[axis]);
+        double far = (box.Max[axis] - ray.Origin[axis]) / double(ray.Direction[axis]);
+        enter = std::max(enter, std::min(near, far));
+        leave = std::min(leave, std::max(near, far));
+    }
+    return enter <= leave;
+}
+
+Ray MakeRay( std::mt19937 &random, float extent )
+{
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+    Ray ray;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        ray.Origin[axis] = value(random) * extent;
+        ray.Direction[axis] = value(random);
+    }
+    // Rays parallel to an axis, and short rays.
+    if (random() % 8 == 0)
+    {
+        ray.Direction[random() % 3] = 0.0f;
+    }
+    if (random() % 3 == 0)
+    {
+        ray.MaxDistance = value(random) + 1.5f;
+    }
+    return ray;
+}
+
+// Random triangle soups, some flat, some tiny, with degenerate triangles. Rays that graze an edge may go
+// either way in single precision, so a few disagreements with the reference are allowed, but never a different
+// distance for a hit both agree on.
+void TestTriangleBvh()
+{
+    std::mt19937                          random(7);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    uint32_t                              numRays = 0;
+    uint32_t                              numDisagreements = 0;
+    bool                                  sameDistances = true;
+    bool                                  packetsMatch = true;
+    for (int trial = 0; trial < 12; ++trial)
+    {
+        // Five floats per vertex, positions first.
+        uint32_t           numVertices = 3 + random() % 2000;
+        std::vector<float> vertices(numVertices * 5);
+        float              scale = trial % 3 == 0 ? 0.001f : 1.0f;
+        for (uint32_t i = 0; i < numVertices; ++i)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                vertices[i * 5 + axis] = trial % 5 == 0 && axis == 1 ? 0.0f : value(random) * scale;
+            }
+        }
+        uint32_t              numTriangles = 1 + random() % 2000;
+        std::vector<uint32_t> indices(numTriangles * 3);
+        for (uint32_t i = 0; i < numTriangles; ++i)
+        {
+            uint32_t first = random() % numVertices;
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                indices[i * 3 + corner] = trial % 4 == 0 && random() % 7 == 0
+                                              ? first
+                                              : (first + random() % 20) % numVertices;
+            }
+        }
+
+        Geometry::TriangleBvh bvh;
+        bvh.Build(vertices.data(), numVertices, 5 * sizeof(float), indices.data(), indices.size(), trial % 2 != 0);
+        EE_CHECK(bvh.GetNumTriangles() <= numTriangles);
+
+        for (int i = 0; i < 200; ++i)
+        {
+            Ray    ray = MakeRay(random, 2.0f);
+            double closest = ray.MaxDistance;
+            bool   expected = false;
+            for (uint32_t triangle = 0; triangle < numTriangles; ++triangle)
+            {
+                const uint32_t* corners = &indices[triangle * 3];
+                double          distance;
+                if (IntersectTriangle(ray, &vertices[corners[0] * 5], &vertices[corners[1] * 5],
+                                      &vertices[corners[2] * 5], &distance) && distance <= closest)
+                {
+                    closest = distance;
+                    expected = true;
+                }
+            }
+
+            RayHit hit;
+            bool   found = bvh.Intersect(ray, &hit);
+            numRays += 1;
+            if (found != expected)
+            {
+                numDisagreements += 1;
+            } else if (found)
+            {
+                sameDistances &= std::fabs(hit.Distance - closest) <= 1e-4 * std::max(1.0, closest) &&
+                                 hit.Primitive < numTriangles;
+            }
+
+            // The same ray and three neighbours as a packet agree with tracing them one by one.
+            Geometry::RayPacket packet;
+            Ray                 rays[4];
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                rays[lane] = ray;
+                rays[lane].Direction[lane % 3] += 0.01f * float(lane);
+                rays[lane].MaxDistance = lane == 3 ? 0.5f : ray.MaxDistance;
+                packet.OriginX[lane] = rays[lane].Origin[0];
+                packet.OriginY[lane] = rays[lane].Origin[1];
+                packet.OriginZ[lane] = rays[lane].Origin[2];
+                packet.DirectionX[lane] = rays[lane].Direction[0];
+                packet.DirectionY[lane] = rays[lane].Direction[1];
+                packet.DirectionZ[lane] = rays[lane].Direction[2];
+                packet.MaxDistance[lane] = rays[lane].MaxDistance;
+            }
+            RayHit   packetHits[4];
+            uint32_t mask = bvh.Intersect(packet, packetHits);
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                RayHit single;
+                bool   singleFound = bvh.Intersect(rays[lane], &single);
+                packetsMatch &= singleFound == ((mask >> lane) & 1) &&
+                                (!singleFound || std::fabs(single.Distance - packetHits[lane].Distance) <=
+                                 1e-5f * std::max(1.0f, single.Distance));
+            }
+        }
+    }
+    EE_CHECK(sameDistances && packetsMatch);
+    EE_CHECK(numDisagreements * 200 <= numRays);
+
+    Geometry::TriangleBvh empty;
+    RayHit                hit;
+    EE_CHECK(!empty.Intersect(Ray{{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}}, &hit));
+}
+
+void TestBoxBvh()
+{
+    std::mt19937                          random(11);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    bool                                  contained = true;
+    bool                                  culled = true;
+    bool                                  sorted = true;
+    uint32_t                              numQueries = 0;
+    uint32_t                              numDisagreements = 0;
+    for (int trial = 0; trial < 12; ++trial)
+    {
+        uint32_t                 count = 1 + random() % 3000;
+        std::vector<BoundingBox> boxes(count);
+        auto                     scatter = [&]
+        {
+            for (auto &box: boxes)
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    float center = trial % 5 == 0 && axis == 2 ? 0.0f : value(random) * 10.0f;
+                    float extent = std::fabs(value(random));
+                    box.Min[axis] = center - extent;
+                    box.Max[axis] = center + extent;
+                }
+            }
+        };
+        scatter();
+        Geometry::Bvh bvh;
+        bvh.Build(boxes.data(), count, trial % 2 != 0);
+
+        // The second pass moves every box and refits.
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            if (pass == 1)
+            {
+                scatter();
+                bvh.Refit(boxes.data());
+            }
+            for (const auto &node: bvh.GetNodes())
+            {
+                for (uint32_t i = 0; i < node.NumPrimitives; ++i)
+                {
+                    const auto &box = boxes[bvh.GetPrimitiveIndex(node.FirstChildOrPrimitive + i)];
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        contained &= box.Min[axis] >= node.Min[axis] && box.Max[axis] <= node.Max[axis];
+                    }
+                }
+            }
+
+            for (int i = 0; i < 10; ++i)
+            {
+                float planes[6][4];
+                for (auto &plane: planes)
+                {
+                    float normal[3] = {value(random), value(random), value(random)};
+                    float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        plane[axis] = normal[axis] / length;
+                    }
+                    plane[3] = 5.0f + value(random) * 5.0f;
+                }
+                std::vector<uint32_t> visible;
+                std::vector<uint32_t> expected;
+                bvh.CullFrustum(planes, &visible);
+                std::sort(visible.begin(), visible.end());
+                for (uint32_t j = 0; j < count; ++j)
+                {
+                    if (IsBoxVisible(boxes[j], planes))
+                    {
+                        expected.push_back(j);
+                    }
+                }
+                culled &= visible == expected;
+            }
+
+            for (int i = 0; i < 30; ++i)
+            {
+                Ray                 ray = MakeRay(random, 12.0f);
+                std::vector<RayHit> hits;
+                bvh.IntersectBounds(ray, &hits);
+                std::vector<uint32_t> found;
+                for (size_t j = 0; j < hits.size(); ++j)
+                {
+                    sorted &= j == 0 || hits[j].Distance >= hits[j - 1].Distance;
+                    found.push_back(hits[j].Primitive);
+                }
+                std::sort(found.begin(), found.end());
+                std::vector<uint32_t> expected;
+                for (uint32_t j = 0; j < count; ++j)
+                {
+                    if (IntersectBox(boxes[j], ray))
+                    {
+                        expected.push_back(j);
+                    }
+                }
+                numQueries += 1;
+                numDisagreements += found != expected ? 1 : 0;
+            }
+        }
+    }
+    EE_CHECK(contained && culled && sorted);
+    EE_CHECK(numDisagreements * 50 <= numQueries);
+
+    Geometry::Bvh         empty;
+    std::vector<uint32_t> visible;
+    float                 planes[6][4] = {};
+    empty.Build(nullptr, 0);
+    empty.CullFrustum(planes, &visible);
+    EE_CHECK(empty.IsEmpty() && visible.empty());
+}
+
+}
+
+int main()
+{
+    TestTriangleBvh();
+    TestBoxBvh();
+    return Tests::Finish();
+}
@@ -0,0 +1,82 @@
+#include <cstdio>
+
+#include "Test.h"
+#include "TestMeshes.h"
+#include "Enterprise/Assets/CookedModel.h"
+#include "Enterprise/Assets/ModelImporter.h"
+
+using namespace Enterprise;
+
+namespace {
+
+constexpr uint32_t NUM_MESHES = 8;
+constexpr uint32_t GRID_SIZE = 64;
+constexpr int      NUM_RUNS = 3;
+
+}
+
+int main()
+{
+    auto directory = Tests::MakeTempDirectory("CookedModelBench");
+    auto sourcePath = directory / "model.obj";
+    auto cookedPath = directory / "model.obj.emdl";
+
+    std::vector<Assets::MeshData> meshes;
+    for (uint32_t i = 0; i < NUM_MESHES; ++i)
+    {
+        meshes.push_back(Tests::MakeGridMesh(GRID_SIZE, 0.05f, i + 1));
+    }
+    Tests::WriteObj(sourcePath, meshes);
+
+    Assets::ModelData model;
+    if (!EE_CHECK(Assets::ImportModelData(sourcePath.string(), &model)) ||
+        !EE_CHECK(Assets::WriteCookedModel(cookedPath.string(), model)))
+    {
+        return Tests::Finish();
+    }
+
+    // The runtime imports and processes the source when there is no cooked file, and only maps the cooked file
+    // otherwise. The cooked path reads every index and vertex, as the upload does.
+    double importTime = 0.0;
+    double cookedTime = 0.0;
+    for (int run = 0; run < NUM_RUNS; ++run)
+    {
+        Tests::Timer      timer;
+        Assets::ModelData imported;
+        Assets::ImportModelData(sourcePath.string(), &imported);
+        importTime += timer.GetMilliseconds();
+
+        timer.Reset();
+        Assets::CookedModel cooked;
+        uint64_t            checksum = 0;
+        if (EE_CHECK(cooked.Open(cookedPath.string())))
+        {
+            for (uint32_t i = 0; i < cooked.GetNumMeshes(); ++i)
+            {
+                const auto &range = cooked.GetMeshRange(i);
+                const auto* vertices = reinterpret_cast<const uint32_t *>(cooked.GetVertices(range));
+                const auto* indices = cooked.GetIndices(range);
+                for (size_t j = 0; j < range.NumVertices * sizeof(Assets::MeshVertex) / 4; ++j)
+                {
+                    checksum += vertices[j];
+                }
+                for (uint32_t j = 0; j < range.NumIndices; ++j)
+                {
+                    checksum += indices[j];
+                }
+            }
+        }
+        cookedTime += timer.GetMilliseconds();
+        EE_CHECK(checksum != 0 && cooked.GetNumMeshes() == imported.Meshes.size());
+    }
+
+    size_t numTriangles = 0;
+    for (const auto &mesh: model.Meshes)
+    {
+        numTriangles += mesh.Indices.size() / 3;
+    }
+    std::printf("%u meshes, %zu triangles\n", NUM_MESHES, numTriangles);
+    std::printf("assimp import: %8.2f ms\n", importTime / NUM_RUNS);
+    std::printf("cooked load:   %8.2f ms (%.1fx faster)\n", cookedTime / NUM_RUNS, importTime / cookedTime);
+    return Tests::Finish();
+}
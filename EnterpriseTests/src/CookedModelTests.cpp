@@ -0,0 +1,338 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "Test.h"
+#include "TestMeshes.h"
+#include "Enterprise/Assets/CookedModel.h"
+#include "Enterprise/Scene/ModelNodes.h"
+
+using namespace Enterprise;
+using Assets::CookedSectionType;
+
+namespace {
+
+std::vector<uint8_t> ReadFile( const std::filesystem::path &path )
+{
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+void WriteFile( const std::filesystem::path &path, const std::vector<uint8_t> &bytes )
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+Assets::CookedSection* FindSection( std::vector<uint8_t> &file, CookedSectionType type )
+{
+    auto* header = reinterpret_cast<Assets::CookedModelHeader *>(file.data());
+    auto* sections = reinterpret_cast<Assets::CookedSection *>(file.data() + sizeof(Assets::CookedModelHeader));
+    for (uint32_t i = 0; i < header->NumSections; ++i)
+    {
+        if (sections[i].Type == type)
+        {
+            return &sections[i];
+        }
+    }
+    return nullptr;
+}
+
+template<typename T>
+T* GetSectionData( std::vector<uint8_t> &file, CookedSectionType type )
+{
+    return reinterpret_cast<T *>(file.data() + FindSection(file, type)->Offset);
+}
+
+// Whether a copy of a valid cooked file, changed by change, still opens.
+template<typename Change>
+bool OpensWith( const std::vector<uint8_t> &file, const std::filesystem::path &path, Change change )
+{
+    std::vector<uint8_t> copy = file;
+    change(copy);
+    WriteFile(path, copy);
+
+    Assets::CookedModel model;
+    return model.Open(path.string());
+}
+
+// Node transform for column vectors, as assimp stores it: scale, then rotate by angle about z, then translate.
+Assets::NodeData MakeNode( int32_t parent, float angle, const float scale[3], const float translation[3] )
+{
+    float            c = std::cos(angle);
+    float            s = std::sin(angle);
+    Assets::NodeData node;
+    node.Parent = parent;
+    const float transform[16] = {
+        c * scale[0], -s * scale[1], 0.0f, translation[0],
+        s * scale[0], c * scale[1], 0.0f, translation[1],
+        0.0f, 0.0f, scale[2], translation[2],
+        0.0f, 0.0f, 0.0f, 1.0f,
+    };
+    std::memcpy(node.Transform, transform, sizeof(transform));
+    return node;
+}
+
+Assets::ModelData MakeModel()
+{
+    Assets::ModelData model;
+    model.Meshes.push_back(Tests::MakeGridMesh(8));
+    model.Meshes.push_back(Tests::MakeSphereMesh(6, 8));
+    model.Meshes[1].MaterialIndex = 1;
+
+    // The sphere goes to the GPU quantized, the grid as floats.
+    auto &                     sphere = model.Meshes[1];
+    Geometry::VertexStreamDesc source = {sphere.Vertices[0].Position, sphere.Vertices[0].Normal,
+                                         sphere.Vertices[0].TexCoord, sizeof(Assets::MeshVertex),
+                                         sphere.Vertices.size()};
+    sphere.VertexFormat = Geometry::VertexFormat::Quantized;
+    sphere.Quantization = Geometry::ComputeQuantizationParams(source.Positions, source.Stride, source.NumVertices);
+    sphere.PackedVertices.resize(Geometry::GetVertexFormatStride(sphere.VertexFormat) * source.NumVertices);
+    Geometry::EncodeVertices(sphere.VertexFormat, sphere.PackedVertices.data(), source, sphere.Quantization);
+    sphere.Lods.push_back({0, uint32_t(sphere.Indices.size()), 0.0f, 0});
+    sphere.Lods.push_back({0, 24, 0.1f, 0});
+
+    // A root with the grid, a mirrored child with the sphere, and a grandchild that only groups.
+    const float one[3] = {1.0f, 1.0f, 1.0f};
+    const float mirrored[3] = {-2.0f, 1.0f, 0.5f};
+    const float translation[3] = {1.0f, 2.0f, 3.0f};
+    model.Nodes.push_back(MakeNode(-1, 0.0f, one, translation));
+    model.Nodes.push_back(MakeNode(0, 0.5f, mirrored, translation));
+    model.Nodes.push_back(MakeNode(1, -1.25f, one, one));
+    model.Nodes[0].Name = "Root";
+    model.Nodes[0].NumMeshes = 1;
+    model.Nodes[1].FirstMesh = 1;
+    model.Nodes[1].NumMeshes = 1;
+    model.Nodes[2].FirstMesh = 2;
+    model.NodeMeshes = {0, 1};
+
+    model.Materials.resize(2);
+    model.Materials[1].BaseColorTexture = 0;
+    model.Materials[1].AlphaMode = Assets::MaterialAlphaMode::Mask;
+
+    model.Textures.resize(1);
+    model.Textures[0].Width = 2;
+    model.Textures[0].Height = 2;
+    model.Textures[0].Data.assign(16, 0x7F);
+    return model;
+}
+
+void TestRoundTrip( const std::filesystem::path &directory )
+{
+    Assets::ModelData model = MakeModel();
+    auto              path = directory / "model.emdl";
+    EE_CHECK(Assets::WriteCookedModel(path.string(), model));
+
+    Assets::CookedModel cooked;
+    if (!EE_CHECK(cooked.Open(path.string())))
+    {
+        return;
+    }
+    EE_CHECK(cooked.GetNumMeshes() == model.Meshes.size());
+    for (uint32_t i = 0; i < cooked.GetNumMeshes() && i < model.Meshes.size(); ++i)
+    {
+        const auto &mesh = model.Meshes[i];
+        const auto &range = cooked.GetMeshRange(i);
+        EE_CHECK(range.NumVertices == mesh.Vertices.size());
+        EE_CHECK(range.NumIndices == mesh.Indices.size());
+        EE_CHECK(range.MaterialIndex == mesh.MaterialIndex);
+        EE_CHECK(std::memcmp(cooked.GetVertices(range), mesh.Vertices.data(),
+                             mesh.Vertices.size() * sizeof(Assets::MeshVertex)) == 0);
+        EE_CHECK(std::memcmp(cooked.GetIndices(range), mesh.Indices.data(),
+                             mesh.Indices.size() * sizeof(uint32_t)) == 0);
+        EE_CHECK(range.NumLods == mesh.Lods.size());
+
+        const auto* stream = cooked.GetVertexStream(i);
+        if (mesh.VertexFormat == Geometry::VertexFormat::Float)
+        {
+            EE_CHECK(stream == nullptr);
+        } else if (EE_CHECK(stream != nullptr))
+        {
+            EE_CHECK(stream->Format == mesh.VertexFormat);
+            EE_CHECK(stream->Size == mesh.PackedVertices.size());
+            EE_CHECK(std::memcmp(cooked.GetPackedVertices(*stream), mesh.PackedVertices.data(), stream->Size) == 0);
+        }
+    }
+    EE_CHECK(cooked.GetNumNodes() == model.Nodes.size());
+    for (uint32_t i = 0; i < cooked.GetNumNodes() && i < model.Nodes.size(); ++i)
+    {
+        const auto &node = cooked.GetNode(i);
+        EE_CHECK(node.Parent == model.Nodes[i].Parent && node.NumMeshes == model.Nodes[i].NumMeshes);
+        EE_CHECK(std::memcmp(node.Transform, model.Nodes[i].Transform, sizeof(node.Transform)) == 0);
+        EE_CHECK(std::equal(cooked.GetNodeMeshes(node), cooked.GetNodeMeshes(node) + node.NumMeshes,
+                            model.NodeMeshes.begin() + model.Nodes[i].FirstMesh));
+    }
+    EE_CHECK(cooked.GetNumMaterials() == 2);
+    EE_CHECK(cooked.GetMaterial(1).AlphaMode == Assets::MaterialAlphaMode::Mask);
+    EE_CHECK(cooked.GetNumTextures() == 1);
+    const auto &texture = cooked.GetTextureRange(0);
+    EE_CHECK(texture.Width == 2 && texture.Height == 2 && texture.Size == 16);
+    EE_CHECK(cooked.GetTextureData(texture)[15] == 0x7F);
+}
+
+void TestRejectsCorruptFiles( const std::filesystem::path &directory )
+{
+    auto path = directory / "model.emdl";
+    Assets::WriteCookedModel(path.string(), MakeModel());
+    const std::vector<uint8_t> file = ReadFile(path);
+    auto                       corruptPath = directory / "corrupt.emdl";
+
+    EE_CHECK(OpensWith(file, corruptPath, []( std::vector<uint8_t> & ) {}));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes ) { bytes[0] ^= 1; }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        reinterpret_cast<Assets::CookedModelHeader *>(bytes.data())->Version += 1;
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes ) { bytes.resize(bytes.size() - 64); }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        reinterpret_cast<Assets::CookedModelHeader *>(bytes.data())->NumSections = 1u << 30;
+    }));
+
+    // An offset close to 2^64 wraps Offset + ElementSize * Count around to a small value.
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        auto* section = FindSection(bytes, CookedSectionType::Indices);
+        section->Offset = ~uint64_t(0) - 63;
+        section->Count = 1;
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        FindSection(bytes, CookedSectionType::Vertices)->Count += 1u << 20;
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        FindSection(bytes, CookedSectionType::Vertices)->Offset += 4;
+    }));
+
+    // Values read through valid sections.
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        auto* ranges = GetSectionData<Assets::CookedMeshRange>(bytes, CookedSectionType::MeshRanges);
+        GetSectionData<uint32_t>(bytes, CookedSectionType::Indices)[ranges[1].FirstIndex + 5] = ranges[1].NumVertices;
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        GetSectionData<Assets::CookedMeshRange>(bytes, CookedSectionType::MeshRanges)[0].NumIndices += 1u << 20;
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        GetSectionData<Assets::CookedMeshRange>(bytes, CookedSectionType::MeshRanges)[1].MaterialIndex = 2;
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        auto* ranges = GetSectionData<Assets::CookedMeshRange>(bytes, CookedSectionType::MeshRanges);
+        GetSectionData<Geometry::MeshLod>(bytes, CookedSectionType::Lods)[ranges[1].FirstLod + 1].NumIndices =
+            ranges[1].NumIndices + 3;
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        GetSectionData<Assets::CookedVertexStream>(bytes, CookedSectionType::VertexStreams)[1].Offset = ~uint64_t(0);
+    }));
+    // Parents must come before their children, which rules out cycles.
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        GetSectionData<Assets::CookedNode>(bytes, CookedSectionType::Nodes)[1].Parent = 1;
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        GetSectionData<Assets::CookedNode>(bytes, CookedSectionType::Nodes)[0].Parent = 2;
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        GetSectionData<Assets::CookedNode>(bytes, CookedSectionType::Nodes)[2].Parent = -2;
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        GetSectionData<Assets::CookedNode>(bytes, CookedSectionType::Nodes)[1].NumMeshes = 2;
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        GetSectionData<uint32_t>(bytes, CookedSectionType::NodeMeshes)[1] = 2;
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        GetSectionData<Assets::CookedTextureRange>(bytes, CookedSectionType::TextureRanges)[0].Size = ~uint64_t(0);
+    }));
+    EE_CHECK(!OpensWith(file, corruptPath, []( std::vector<uint8_t> &bytes )
+    {
+        GetSectionData<Assets::MaterialData>(bytes, CookedSectionType::Materials)[1].BaseColorTexture = 1;
+    }));
+}
+
+
+// The nodes of a cooked model added below a placed model node end up with the world matrices of their chain of
+// node transforms, mirroring included.
+void TestModelNodes( const std::filesystem::path &directory )
+{
+    auto path = directory / "model.emdl";
+    Assets::WriteCookedModel(path.string(), MakeModel());
+    Assets::CookedModel cooked;
+    if (!EE_CHECK(cooked.Open(path.string())))
+    {
+        return;
+    }
+
+    Scene::TransformHierarchy transforms;
+    Scene::Transform          placement;
+    placement.Position[0] = 5.0f;
+    placement.Scale[1] = 3.0f;
+    auto modelNode = transforms.AddNode(Scene::TransformHierarchy::INVALID_HANDLE, placement);
+
+    std::vector<Scene::TransformHierarchy::Handle> handles;
+    Scene::AddModelNodes(&cooked.GetNode(0), cooked.GetNumNodes(), modelNode, &transforms, &handles);
+    transforms.UpdateWorldMatrices(false);
+    if (!EE_CHECK(handles.size() == cooked.GetNumNodes()))
+    {
+        return;
+    }
+    EE_CHECK(transforms.GetParent(handles[0]) == modelNode && transforms.GetParent(handles[2]) == handles[1]);
+    EE_CHECK(transforms.GetLocalTransform(handles[1]).Scale[0] < 0.0f);
+
+    // World matrices for column vectors, parent * local, transposed at the end to compare with the hierarchy's.
+    std::vector<std::array<float, 16>> worlds(cooked.GetNumNodes());
+    const float                        placed[16] = {1, 0, 0, 5, 0, 3, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    bool                               matches = true;
+    for (uint32_t i = 0; i < cooked.GetNumNodes(); ++i)
+    {
+        const auto & node = cooked.GetNode(i);
+        const float* parent = node.Parent < 0 ? placed : worlds[node.Parent].data();
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                float sum = 0.0f;
+                for (int k = 0; k < 4; ++k)
+                {
+                    sum += parent[row * 4 + k] * node.Transform[k * 4 + column];
+                }
+                worlds[i][row * 4 + column] = sum;
+            }
+        }
+
+        const auto &world = transforms.GetWorldMatrix(handles[i]);
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                matches &= std::abs(world.m[column][row] - worlds[i][row * 4 + column]) < 1e-4f;
+            }
+        }
+    }
+    EE_CHECK(matches);
+}
+
+}
+
+int main()
+{
+    auto directory = Tests::MakeTempDirectory("CookedModelTests");
+    TestRoundTrip(directory);
+    TestRejectsCorruptFiles(directory);
+    TestModelNodes(directory);
+    return Tests::Finish();
+}
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Scene/InstanceBatcher.h"
+
+using namespace Enterprise;
+
+namespace {
+
+constexpr uint32_t NUM_INSTANCES = 100000;
+constexpr uint32_t NUM_KEYS = 64;
+constexpr int      NUM_RUNS = 20;
+
+}
+
+int main()
+{
+    // World matrices as the transform hierarchy leaves them, with keys in runs like a scene walk hands them out.
+    std::vector<Scene::Matrix4x4> worlds(NUM_INSTANCES);
+    std::vector<uint64_t>         keys(NUM_INSTANCES);
+    std::mt19937                  random(1);
+    for (uint32_t i = 0; i < NUM_INSTANCES; ++i)
+    {
+        float scale = 1.0f + float(i % 17) * 0.125f;
+        worlds[i] = {{{scale, 0.0f, 0.1f, 0.0f}, {0.0f, scale, 0.0f, 0.0f}, {-0.1f, 0.0f, scale, 0.0f},
+                      {float(i), float(i % 100), 0.0f, 1.0f}}};
+        keys[i] = i % 8 == 0 ? random() % NUM_KEYS : keys[std::max(i, 1u) - 1];
+    }
+
+    Scene::InstanceBatcher batcher;
+    batcher.Reserve(NUM_INSTANCES);
+    double build = 1e30;
+    for (int run = 0; run < NUM_RUNS; ++run)
+    {
+        Tests::Timer timer;
+        batcher.Clear();
+        for (uint32_t i = 0; i < NUM_INSTANCES; ++i)
+        {
+            batcher.Add(keys[i], &worlds[i]);
+        }
+        batcher.Build();
+        build = std::min(build, timer.GetMilliseconds());
+    }
+
+    std::vector<Scene::InstanceData> serial(NUM_INSTANCES);
+    std::vector<Scene::InstanceData> parallel(NUM_INSTANCES);
+    auto pack = [&]( bool useThreads, std::vector<Scene::InstanceData> &destination )
+    {
+        double best = 1e30;
+        for (int run = 0; run < NUM_RUNS; ++run)
+        {
+            Tests::Timer timer;
+            for (const auto &batch: batcher.GetBatches())
+            {
+                batcher.Pack(batch.FirstInstance, batch.NumInstances, destination.data() + batch.FirstInstance,
+                             useThreads);
+            }
+            best = std::min(best, timer.GetMilliseconds());
+        }
+        return best;
+    };
+    double packSerial = pack(false, serial);
+    double packParallel = pack(true, parallel);
+    // One pack of the whole frame, as the renderer does with every visible instance in one buffer.
+    double packAll = 1e30;
+    for (int run = 0; run < NUM_RUNS; ++run)
+    {
+        Tests::Timer timer;
+        batcher.Pack(0, NUM_INSTANCES, parallel.data(), true);
+        packAll = std::min(packAll, timer.GetMilliseconds());
+    }
+    EE_CHECK(batcher.GetNumInstances() == NUM_INSTANCES && batcher.GetBatches().size() <= NUM_KEYS);
+    EE_CHECK(std::memcmp(serial.data(), parallel.data(), NUM_INSTANCES * sizeof(Scene::InstanceData)) == 0);
+
+    std::printf("%u instances, %zu batches\n", NUM_INSTANCES, batcher.GetBatches().size());
+    std::printf("%-28s %8.3f ms\n", "add and build", build);
+    std::printf("%-28s %8.3f ms\n", "pack per batch, serial", packSerial);
+    std::printf("%-28s %8.3f ms\n", "pack per batch, parallel", packParallel);
+    std::printf("%-28s %8.3f ms\n", "pack all at once, parallel", packAll);
+    return Tests::Finish();
+}
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Scene/InstanceBatcher.h"
+
+using namespace Enterprise;
+using Scene::InstanceBatcher;
+
+namespace {
+
+// Affine world matrices for row vectors: a random rotation, a scale that may be non uniform or mirrored, and a
+// translation whose x is the index of the instance.
+std::vector<Scene::Matrix4x4> MakeWorlds( size_t count, uint32_t seed )
+{
+    std::mt19937                          random(seed);
+    std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+    std::vector<Scene::Matrix4x4>         worlds(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        float a = angle(random);
+        float b = angle(random);
+        float s[3] = {scale(random), scale(random), scale(random)};
+        if (i % 5 == 0)
+        {
+            s[1] = -s[1];
+        }
+        float ca = std::cos(a), sa = std::sin(a), cb = std::cos(b), sb = std::sin(b);
+        // Rotation about z, then about x, each row scaled.
+        const float rotation[3][3] = {{ca, sa, 0.0f}, {-sa * cb, ca * cb, sb}, {sa * sb, -ca * sb, cb}};
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 3; ++column)
+            {
+                worlds[i].m[row][column] = rotation[row][column] * s[row];
+            }
+            worlds[i].m[row][3] = 0.0f;
+        }
+        worlds[i].m[3][0] = float(i);
+        worlds[i].m[3][1] = angle(random);
+        worlds[i].m[3][2] = angle(random);
+        worlds[i].m[3][3] = 1.0f;
+    }
+    return worlds;
+}
+
+// Batches come in the order their keys were first added, instances within a batch in the order they were added,
+// whether they came one at a time, in runs or as arrays.
+void TestBuildOrder()
+{
+    std::vector<Scene::Matrix4x4> worlds = MakeWorlds(64, 1);
+    InstanceBatcher               batcher;
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        batcher.Clear();
+        std::mt19937                       random(frame);
+        std::vector<uint64_t>              keys = {7, 3, 7, 7, 9, 3, 1000, 9, 7};
+        std::vector<uint64_t>              firstSeen;
+        std::vector<std::vector<uint32_t>> expected;
+        uint32_t                           next = 0;
+        for (uint64_t key: keys)
+        {
+            size_t batch = 0;
+            while (batch < firstSeen.size() && firstSeen[batch] != key)
+            {
+                ++batch;
+            }
+            if (batch == firstSeen.size())
+            {
+                firstSeen.push_back(key);
+                expected.emplace_back();
+            }
+
+            uint32_t count = 1 + random() % 4;
+            if (random() % 2 != 0)
+            {
+                batcher.Add(key, &worlds[next], count);
+            } else
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    batcher.Add(key, &worlds[next + i]);
+                }
+            }
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                expected[batch].push_back(next + i);
+            }
+            next += count;
+        }
+        batcher.Build();
+
+        const auto &batches = batcher.GetBatches();
+        if (!EE_CHECK(batches.size() == firstSeen.size() && batcher.GetNumInstances() == next))
+        {
+            return;
+        }
+        std::vector<Scene::InstanceData> packed(next);
+        batcher.Pack(0, next, packed.data(), false);
+        bool     ordered = true;
+        uint32_t first = 0;
+        for (size_t batch = 0; batch < batches.size(); ++batch)
+        {
+            ordered &= batches[batch].Key == firstSeen[batch] && batches[batch].FirstInstance == first &&
+                       batches[batch].NumInstances == expected[batch].size();
+            for (size_t i = 0; i < expected[batch].size() && ordered; ++i)
+            {
+                // The index of the instance is its x translation, the last column of the first row packed.
+                ordered &= packed[first + i].World[0][3] == float(expected[batch][i]);
+            }
+            first += batches[batch].NumInstances;
+        }
+        EE_CHECK(ordered);
+    }
+}
+
+// Packed rows against the transposed world matrix and the inverse transpose of its upper 3x3, at double precision.
+void TestPackInstance()
+{
+    std::vector<Scene::Matrix4x4> worlds = MakeWorlds(1000, 2);
+    InstanceBatcher               batcher;
+    batcher.Add(0, worlds.data(), worlds.size());
+    batcher.Build();
+    std::vector<Scene::InstanceData> packed(worlds.size());
+    batcher.Pack(0, uint32_t(worlds.size()), packed.data(), false);
+
+    double maxWorldError = 0.0;
+    double maxNormalError = 0.0;
+    for (size_t i = 0; i < worlds.size(); ++i)
+    {
+        const auto &m = worlds[i].m;
+        // a is the upper 3x3 of the world matrix for column vectors.
+        double a[3][3];
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 3; ++column)
+            {
+                a[row][column] = m[column][row];
+            }
+        }
+        double determinant = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) -
+                             a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+                             a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                double error = std::abs(packed[i].World[row][column] - m[column][row]);
+                maxWorldError = std::max(maxWorldError, error);
+            }
+            // The inverse transpose is the cofactor matrix over the determinant.
+            int r1 = (row + 1) % 3, r2 = (row + 2) % 3;
+            for (int column = 0; column < 3; ++column)
+            {
+                int    c1 = (column + 1) % 3, c2 = (column + 2) % 3;
+                double cofactor = a[r1][c1] * a[r2][c2] - a[r1][c2] * a[r2][c1];
+                double expected = cofactor / determinant;
+                maxNormalError = std::max(maxNormalError, std::abs(packed[i].Normal[row][column] - expected) /
+                                                          std::max(1.0, std::abs(expected)));
+            }
+            maxNormalError = std::max(maxNormalError, double(std::abs(packed[i].Normal[row][3])));
+        }
+    }
+    EE_CHECK(maxWorldError == 0.0);
+    EE_CHECK(maxNormalError < 1e-5);
+}
+
+// Large ranges are packed on the thread pool into exactly what a single thread writes, from any first instance.
+void TestParallelPack()
+{
+    constexpr uint32_t            NUM_INSTANCES = 50000;
+    std::vector<Scene::Matrix4x4> worlds = MakeWorlds(NUM_INSTANCES, 3);
+    InstanceBatcher               batcher;
+    for (uint32_t i = 0; i < NUM_INSTANCES; ++i)
+    {
+        batcher.Add(i * 2654435761u % 13, &worlds[i]);
+    }
+    batcher.Build();
+
+    std::vector<Scene::InstanceData> serial(NUM_INSTANCES);
+    std::vector<Scene::InstanceData> parallel(NUM_INSTANCES);
+    batcher.Pack(0, NUM_INSTANCES, serial.data(), false);
+    batcher.Pack(0, NUM_INSTANCES, parallel.data(), true);
+    EE_CHECK(std::memcmp(serial.data(), parallel.data(), NUM_INSTANCES * sizeof(Scene::InstanceData)) == 0);
+
+    constexpr uint32_t               FIRST = 777;
+    constexpr uint32_t               COUNT = 30000;
+    std::vector<Scene::InstanceData> range(COUNT);
+    batcher.Pack(FIRST, COUNT, range.data(), true);
+    EE_CHECK(std::memcmp(range.data(), serial.data() + FIRST, COUNT * sizeof(Scene::InstanceData)) == 0);
+}
+
+}
+
+int main()
+{
+    TestBuildOrder();
+    TestPackInstance();
+    TestParallelPack();
+    return Tests::Finish();
+}
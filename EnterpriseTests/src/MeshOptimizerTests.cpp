@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "TestMeshes.h"
+#include "Enterprise/Geometry/MeshOptimizer.h"
+
+using namespace Enterprise;
+
+namespace {
+
+using Triangle = std::array<float, 9>;
+
+// The triangles of a mesh by position, each in its smallest rotation so winding is kept.
+std::vector<Triangle> GetTriangles( const std::vector<uint32_t> &indices, const Assets::MeshVertex* vertices )
+{
+    std::vector<Triangle> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        Triangle smallest{};
+        for (size_t first = 0; first < 3; ++first)
+        {
+            Triangle triangle{};
+            for (size_t j = 0; j < 3; ++j)
+            {
+                const float* position = vertices[indices[i + (first + j) % 3]].Position;
+                std::copy(position, position + 3, triangle.begin() + j * 3);
+            }
+            smallest = first == 0 ? triangle : std::min(smallest, triangle);
+        }
+        triangles.push_back(smallest);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+void Shuffle( std::vector<uint32_t> &indices )
+{
+    std::vector<std::array<uint32_t, 3> > triangles(indices.size() / 3);
+    std::copy(indices.begin(), indices.end(), triangles.data()->data());
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1));
+    std::copy(triangles.data()->data(), triangles.data()->data() + indices.size(), indices.begin());
+}
+
+void TestMesh( const char* name, Assets::MeshData mesh, float maxACMR, float maxATVR )
+{
+    Shuffle(mesh.Indices);
+    const auto triangles = GetTriangles(mesh.Indices, mesh.Vertices.data());
+    size_t     vertexCount = mesh.Vertices.size();
+    auto       before = Geometry::AnalyzeVertexCache(mesh.Indices.data(), mesh.Indices.size(), vertexCount);
+
+    Geometry::OptimizeVertexCache(mesh.Indices.data(), mesh.Indices.data(), mesh.Indices.size(), vertexCount);
+    auto cache = Geometry::AnalyzeVertexCache(mesh.Indices.data(), mesh.Indices.size(), vertexCount);
+    EE_CHECK(GetTriangles(mesh.Indices, mesh.Vertices.data()) == triangles);
+    EE_CHECK(cache.GetACMR() <= maxACMR);
+    EE_CHECK(cache.GetATVR() <= maxATVR);
+
+    std::vector<uint32_t> overdraw(mesh.Indices.size());
+    Geometry::OptimizeOverdraw(overdraw.data(), mesh.Indices.data(), mesh.Indices.size(),
+                               mesh.Vertices.data()->Position, vertexCount, sizeof(Assets::MeshVertex), 1.05f);
+    auto after = Geometry::AnalyzeVertexCache(overdraw.data(), overdraw.size(), vertexCount);
+    EE_CHECK(GetTriangles(overdraw, mesh.Vertices.data()) == triangles);
+    EE_CHECK(after.GetACMR() <= cache.GetACMR() * 1.05f + 0.01f);
+
+    std::vector<Assets::MeshVertex> fetched(vertexCount);
+    size_t numFetched = Geometry::OptimizeVertexFetch(fetched.data(), overdraw.data(), overdraw.size(),
+                                                      mesh.Vertices.data(), vertexCount, sizeof(Assets::MeshVertex));
+    EE_CHECK(numFetched == vertexCount);
+    EE_CHECK(GetTriangles(overdraw, fetched.data()) == triangles);
+
+    std::printf("%-8s ACMR %.3f -> %.3f -> %.3f, ATVR %.3f -> %.3f\n", name, before.GetACMR(), cache.GetACMR(),
+                after.GetACMR(), before.GetATVR(), after.GetATVR());
+}
+
+}
+
+int main()
+{
+    // A regular grid cannot go below an ACMR of 0.5 and an ATVR of 1.
+    TestMesh("grid", Tests::MakeGridMesh(64), 0.75f, 1.45f);
+    TestMesh("sphere", Tests::MakeSphereMesh(48, 64), 0.75f, 1.45f);
+    return Tests::Finish();
+}
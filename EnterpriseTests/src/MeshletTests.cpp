@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "Test.h"
+#include "TestMeshes.h"
+#include "Enterprise/Geometry/MeshOptimizer.h"
+#include "Enterprise/Geometry/Meshlets.h"
+
+using namespace Enterprise;
+
+namespace {
+
+struct MeshletMesh {
+    Assets::MeshData               Mesh;
+    std::vector<Geometry::Meshlet> Meshlets;
+};
+
+MeshletMesh BuildSphere()
+{
+    MeshletMesh sphere;
+    auto &      mesh = sphere.Mesh;
+    mesh = Tests::MakeSphereMesh(48, 96);
+    Geometry::OptimizeVertexCache(mesh.Indices.data(), mesh.Indices.data(), mesh.Indices.size(),
+                                  mesh.Vertices.size());
+
+    std::vector<uint32_t> indices(mesh.Indices.size());
+    sphere.Meshlets = Geometry::BuildMeshlets(indices.data(), mesh.Indices.data(), mesh.Indices.size(),
+                                              mesh.Vertices.data()->Position, mesh.Vertices.size(),
+                                              sizeof(Assets::MeshVertex));
+
+    auto sorted = indices;
+    auto original = mesh.Indices;
+    std::sort(sorted.begin(), sorted.end());
+    std::sort(original.begin(), original.end());
+    EE_CHECK(sorted == original);
+    mesh.Indices = std::move(indices);
+    return sphere;
+}
+
+void TestBuildMeshlets( const MeshletMesh &sphere )
+{
+    const auto &mesh = sphere.Mesh;
+    uint32_t    nextIndex = 0;
+    bool        withinLimits = true;
+    bool        bounded = true;
+    for (const auto &meshlet: sphere.Meshlets)
+    {
+        withinLimits &= meshlet.FirstIndex == nextIndex && meshlet.NumIndices % 3 == 0 &&
+                        meshlet.NumIndices / 3 <= Geometry::MESHLET_MAX_TRIANGLES &&
+                        meshlet.NumVertices <= Geometry::MESHLET_MAX_VERTICES;
+        nextIndex += meshlet.NumIndices;
+
+        std::vector<uint32_t> vertices(&mesh.Indices[meshlet.FirstIndex],
+                                       &mesh.Indices[meshlet.FirstIndex] + meshlet.NumIndices);
+        std::sort(vertices.begin(), vertices.end());
+        withinLimits &= std::unique(vertices.begin(), vertices.end()) - vertices.begin() == meshlet.NumVertices;
+
+        for (uint32_t vertex: vertices)
+        {
+            const float* position = mesh.Vertices[vertex].Position;
+            float        x = position[0] - meshlet.Center[0];
+            float        y = position[1] - meshlet.Center[1];
+            float        z = position[2] - meshlet.Center[2];
+            bounded &= std::sqrt(x * x + y * y + z * z) <= meshlet.Radius * 1.0001f;
+        }
+    }
+    EE_CHECK(nextIndex == mesh.Indices.size());
+    EE_CHECK(withinLimits);
+    EE_CHECK(bounded);
+
+    // Grown from shared vertices, meshlets come out close to full.
+    EE_CHECK(mesh.Indices.size() / 3 / sphere.Meshlets.size() >= Geometry::MESHLET_MAX_TRIANGLES / 2);
+}
+
+// Culling must keep every triangle the viewer can see, and should drop a good part of the others.
+void TestCullMeshlets( const MeshletMesh &sphere )
+{
+    const auto &mesh = sphere.Mesh;
+
+    // Everything above y = 0.5 is outside, as is everything facing away from a viewer at z = -5.
+    Geometry::MeshletCullParams params{};
+    for (auto &plane: params.Planes)
+    {
+        plane[0] = plane[1] = plane[2] = 0.0f;
+        plane[3] = 1.0f;
+    }
+    params.Planes[0][1] = -1.0f;
+    params.Planes[0][3] = 0.5f;
+    params.CameraPosition[2] = -5.0f;
+
+    std::vector<Geometry::IndexRange> ranges;
+    size_t numVisible = Geometry::CullMeshlets(sphere.Meshlets.data(), sphere.Meshlets.size(), params, &ranges);
+
+    std::vector<bool> drawn(mesh.Indices.size() / 3, false);
+    for (const auto &range: ranges)
+    {
+        std::fill(drawn.begin() + range.FirstIndex / 3, drawn.begin() + (range.FirstIndex + range.NumIndices) / 3,
+                  true);
+    }
+
+    size_t numSeen = 0;
+    size_t numMissed = 0;
+    for (size_t triangle = 0; triangle < drawn.size(); ++triangle)
+    {
+        const float* p0 = mesh.Vertices[mesh.Indices[triangle * 3]].Position;
+        const float* p1 = mesh.Vertices[mesh.Indices[triangle * 3 + 1]].Position;
+        const float* p2 = mesh.Vertices[mesh.Indices[triangle * 3 + 2]].Position;
+        float        e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        float        e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        float        normal[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2],
+                                  e1[0] * e2[1] - e1[1] * e2[0]};
+        float        facing = normal[0] * p0[0] + normal[1] * p0[1] + normal[2] * (p0[2] + 5.0f);
+        bool         inside = std::min({p0[1], p1[1], p2[1]}) <= 0.5f;
+        if (facing < 0.0f && inside)
+        {
+            ++numSeen;
+            numMissed += !drawn[triangle];
+        }
+    }
+    EE_CHECK(numMissed == 0);
+    EE_CHECK(numVisible < sphere.Meshlets.size() * 2 / 3);
+    EE_CHECK(ranges.size() <= numVisible);
+    std::printf("%zu of %zu meshlets visible in %zu draws, %zu triangles seen\n", numVisible,
+                sphere.Meshlets.size(), ranges.size(), numSeen);
+
+    // Without the cone test only the plane culls.
+    params.ConeCulling = false;
+    ranges.clear();
+    EE_CHECK(Geometry::CullMeshlets(sphere.Meshlets.data(), sphere.Meshlets.size(), params, &ranges) > numVisible);
+}
+
+}
+
+int main()
+{
+    MeshletMesh sphere = BuildSphere();
+    TestBuildMeshlets(sphere);
+    TestCullMeshlets(sphere);
+    return Tests::Finish();
+}
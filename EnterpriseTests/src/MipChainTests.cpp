@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Test.h"
+#include "TestImages.h"
+#include "Enterprise/Textures/MipChain.h"
+
+using namespace Enterprise;
+
+namespace {
+
+double ConvertToLinear( double x )
+{
+    return x < 0.04045 ? x / 12.92 : std::pow((x + 0.055) / 1.055, 2.4);
+}
+
+double ConvertToSrgb( double x )
+{
+    return x < 0.0031308 ? 12.92 * x : 1.055 * std::pow(std::abs(x), 1.0 / 2.4) - 0.055;
+}
+
+// What sampling an RGBA8 texture reads, with sRGB color decoded to linear like an sRGB view does.
+std::vector<double> DecodeTexels( const std::vector<uint8_t> &codes, bool srgb )
+{
+    std::vector<double> texels(codes.size());
+    for (size_t i = 0; i < codes.size(); ++i)
+    {
+        double value = codes[i] / 255.0;
+        texels[i] = srgb && i % 4 != 3 ? ConvertToLinear(value) : value;
+    }
+    return texels;
+}
+
+// SampleLevel through LinearClampSampler at uv.
+void SampleBilinear( const std::vector<double> &texels, uint32_t width, uint32_t height, double u, double v,
+                     double color[4] )
+{
+    double x = u * width - 0.5;
+    double y = v * height - 0.5;
+    double x0 = std::floor(x);
+    double y0 = std::floor(y);
+    double fx = x - x0;
+    double fy = y - y0;
+    auto   clampX = [&]( double i ) { return size_t(std::clamp(int64_t(i), int64_t(0), int64_t(width) - 1)); };
+    auto   clampY = [&]( double i ) { return size_t(std::clamp(int64_t(i), int64_t(0), int64_t(height) - 1)); };
+    for (int c = 0; c < 4; ++c)
+    {
+        auto at = [&]( size_t tx, size_t ty ) { return texels[(ty * width + tx) * 4 + c]; };
+        double top = at(clampX(x0), clampY(y0)) * (1.0 - fx) + at(clampX(x0 + 1), clampY(y0)) * fx;
+        double bottom = at(clampX(x0), clampY(y0 + 1)) * (1.0 - fx) + at(clampX(x0 + 1), clampY(y0 + 1)) * fx;
+        color[c] = top * (1.0 - fy) + bottom * fy;
+    }
+}
+
+// One GenerateMipsCS dispatch writing only OutMip1, the next mip of source, through a UNORM view: one or two
+// bilinear taps per axis depending on whether the source size is even or odd, then PackColor.
+std::vector<uint8_t> RunGenerateMipsCS( const std::vector<uint8_t> &source, uint32_t width, uint32_t height,
+                                        bool srgb, uint32_t mipWidth, uint32_t mipHeight )
+{
+    std::vector<double>  texels = DecodeTexels(source, srgb);
+    std::vector<uint8_t> mip(size_t(mipWidth) * mipHeight * 4);
+    bool                 oddWidth = (width & 1) != 0;
+    bool                 oddHeight = (height & 1) != 0;
+    double               texelSize[2] = {1.0 / mipWidth, 1.0 / mipHeight};
+    for (uint32_t y = 0; y < mipHeight; ++y)
+    {
+        for (uint32_t x = 0; x < mipWidth; ++x)
+        {
+            // Odd sizes take two taps a quarter texel either side of the center, so no source texel is skipped.
+            double   u = texelSize[0] * (x + (oddWidth ? 0.25 : 0.5));
+            double   v = texelSize[1] * (y + (oddHeight ? 0.25 : 0.5));
+            uint32_t tapsX = oddWidth ? 2 : 1;
+            uint32_t tapsY = oddHeight ? 2 : 1;
+            double   color[4] = {};
+            for (uint32_t tapY = 0; tapY < tapsY; ++tapY)
+            {
+                for (uint32_t tapX = 0; tapX < tapsX; ++tapX)
+                {
+                    double tap[4];
+                    SampleBilinear(texels, width, height, u + tapX * texelSize[0] * 0.5,
+                                   v + tapY * texelSize[1] * 0.5, tap);
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        color[c] += tap[c] / (tapsX * tapsY);
+                    }
+                }
+            }
+            for (int c = 0; c < 4; ++c)
+            {
+                double packed = srgb && c != 3 ? ConvertToSrgb(color[c]) : color[c];
+                mip[(size_t(y) * mipWidth + x) * 4 + c] = uint8_t(std::lround(std::clamp(packed, 0.0, 1.0) * 255.0));
+            }
+        }
+    }
+    return mip;
+}
+
+// The Box chain matches a dispatch per mip, each reading the mip the last one stored, within a code. The CPU
+// chain filters from the unrounded mip instead.
+void TestBoxMatchesShader( uint32_t width, uint32_t height, bool srgb )
+{
+    std::vector<uint8_t>            image = Tests::MakeImage(width, height, width * 31 + height);
+    std::vector<Textures::MipLevel> mips;
+    Textures::GenerateMipChain(image.data(), width, height, size_t(width) * 4, {Textures::MipFilter::Box, srgb},
+                               &mips);
+    if (!EE_CHECK(mips.size() + 1 == Textures::GetNumMips(width, height)))
+    {
+        return;
+    }
+
+    std::vector<uint8_t> source = image;
+    uint32_t             sourceWidth = width;
+    uint32_t             sourceHeight = height;
+    int                  maxError = 0;
+    bool                 sizesMatch = true;
+    for (const auto &mip: mips)
+    {
+        uint32_t mipWidth = std::max(sourceWidth / 2, 1u);
+        uint32_t mipHeight = std::max(sourceHeight / 2, 1u);
+        sizesMatch &= mip.Width == mipWidth && mip.Height == mipHeight;
+        if (!sizesMatch)
+        {
+            break;
+        }
+        source = RunGenerateMipsCS(source, sourceWidth, sourceHeight, srgb, mipWidth, mipHeight);
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            maxError = std::max(maxError, std::abs(int(source[i]) - int(mip.Pixels[i])));
+        }
+        sourceWidth = mipWidth;
+        sourceHeight = mipHeight;
+    }
+    EE_CHECK(sizesMatch);
+    if (!EE_CHECK(maxError <= 1))
+    {
+        std::printf("  %ux%u %s: max error %d codes\n", width, height, srgb ? "sRGB" : "linear", maxError);
+    }
+}
+
+// A flat image stays flat down the chain with either filter, in either color space.
+void TestFlatImage( Textures::MipFilter filter, bool srgb )
+{
+    const uint8_t        color[4] = {200, 90, 13, 128};
+    std::vector<uint8_t> image(37 * 21 * 4);
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+        image[i] = color[i % 4];
+    }
+
+    std::vector<Textures::MipLevel> mips;
+    Textures::GenerateMipChain(image.data(), 37, 21, 37 * 4, {filter, srgb}, &mips);
+    bool flat = mips.size() == 5 && mips.back().Width == 1 && mips.back().Height == 1;
+    for (const auto &mip: mips)
+    {
+        for (size_t i = 0; i < mip.Pixels.size(); ++i)
+        {
+            flat &= mip.Pixels[i] == color[i % 4];
+        }
+    }
+    EE_CHECK(flat);
+}
+
+}
+
+int main()
+{
+    EE_CHECK(Textures::GetNumMips(1, 1) == 1);
+    EE_CHECK(Textures::GetNumMips(256, 1) == 9);
+    EE_CHECK(Textures::GetNumMips(37, 21) == 6);
+
+    for (bool srgb: {false, true})
+    {
+        TestBoxMatchesShader(64, 32, srgb);
+        TestBoxMatchesShader(45, 32, srgb);
+        TestBoxMatchesShader(32, 45, srgb);
+        TestBoxMatchesShader(45, 27, srgb);
+        TestFlatImage(Textures::MipFilter::Box, srgb);
+        TestFlatImage(Textures::MipFilter::Kaiser, srgb);
+    }
+    return Tests::Finish();
+}
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Geometry/OcclusionCuller.h"
+
+using namespace Enterprise;
+
+namespace {
+
+constexpr uint32_t NUM_OCCLUDERS = 2000;
+constexpr uint32_t NUM_BOXES = 100000;
+constexpr int      NUM_RUNS = 10;
+
+}
+
+int main()
+{
+    constexpr float NEAR_Z = 0.1f;
+    constexpr float FAR_Z = 200.0f;
+
+    float yScale = 1.0f / std::tan(0.6f);
+    float modelToClip[16] = {yScale / 1.6f, 0.0f, 0.0f, 0.0f,
+                             0.0f, yScale, 0.0f, 0.0f,
+                             0.0f, 0.0f, FAR_Z / (FAR_Z - NEAR_Z), 1.0f,
+                             0.0f, 0.0f, -NEAR_Z * FAR_Z / (FAR_Z - NEAR_Z), 0.0f};
+
+    // Square occluders facing the camera, like walls and buildings, and small boxes scattered behind them.
+    std::mt19937                          random(1);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::vector<float>                    positions;
+    std::vector<uint32_t>                 indices;
+    for (uint32_t i = 0; i < NUM_OCCLUDERS; ++i)
+    {
+        float    z = 3.0f + std::fabs(value(random)) * 60.0f;
+        float    x = value(random) * z;
+        float    y = value(random) * z;
+        float    size = z * 0.15f;
+        uint32_t first = static_cast<uint32_t>(positions.size() / 3);
+        positions.insert(positions.end(), {x - size, y - size, z, x + size, y - size, z,
+                                           x + size, y + size, z, x - size, y + size, z});
+        indices.insert(indices.end(), {first, first + 1, first + 2, first, first + 2, first + 3});
+    }
+    std::vector<Geometry::BoundingBox> boxes(NUM_BOXES);
+    for (auto &box: boxes)
+    {
+        float z = 3.0f + std::fabs(value(random)) * 100.0f;
+        float center[3] = {value(random) * z, value(random) * z, z};
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            box.Min[axis] = center[axis] - 0.5f;
+            box.Max[axis] = center[axis] + 0.5f;
+        }
+    }
+
+    for (bool parallel: {false, true})
+    {
+        Geometry::OcclusionCuller culler(320, 192);
+        double                    best = 1e30;
+        for (int run = 0; run < NUM_RUNS; ++run)
+        {
+            Tests::Timer timer;
+            culler.Clear();
+            culler.AddOccluder(modelToClip, positions.data(), positions.size() / 3, 3 * sizeof(float),
+                               indices.data(), indices.size());
+            culler.Rasterize(parallel);
+            best = std::min(best, timer.GetMilliseconds());
+        }
+
+        Tests::Timer timer;
+        uint32_t     numVisible = 0;
+        for (const auto &box: boxes)
+        {
+            numVisible += culler.IsVisible(modelToClip, box) ? 1 : 0;
+        }
+        double testTime = timer.GetMilliseconds();
+        EE_CHECK(numVisible > 0 && numVisible < NUM_BOXES);
+        std::printf("%-8s %u triangles rasterized in %7.3f ms, %u boxes tested in %7.3f ms, %u visible\n",
+                    parallel ? "parallel" : "serial", culler.GetNumTriangles(), best, NUM_BOXES, testTime, numVisible);
+    }
+    return Tests::Finish();
+}
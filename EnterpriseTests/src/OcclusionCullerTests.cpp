@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Assets/ModelData.h"
+#include "Enterprise/Geometry/OcclusionCuller.h"
+
+using namespace Enterprise;
+using Geometry::BoundingBox;
+using Geometry::OcclusionCuller;
+
+namespace {
+
+// A 1.2 radian perspective looking down +z, row vectors as DirectXMath.
+struct Projection {
+    float m[16];
+
+    Projection()
+    {
+        constexpr float NEAR_Z = 0.1f;
+        constexpr float FAR_Z = 100.0f;
+
+        float yScale = 1.0f / std::tan(0.6f);
+        float values[16] = {yScale / 1.6f, 0.0f, 0.0f, 0.0f,
+                            0.0f, yScale, 0.0f, 0.0f,
+                            0.0f, 0.0f, FAR_Z / (FAR_Z - NEAR_Z), 1.0f,
+                            0.0f, 0.0f, -NEAR_Z * FAR_Z / (FAR_Z - NEAR_Z), 0.0f};
+        std::copy_n(values, 16, m);
+    }
+
+    // To pixels and depth in double precision. Returns false behind the near plane.
+    bool Project( const float* position, uint32_t width, uint32_t height, double screen[3] ) const
+    {
+        double clip[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            clip[i] = position[0] * double(m[i]) + position[1] * double(m[4 + i]) + position[2] * double(m[8 + i]) +
+                      m[12 + i];
+        }
+        if (clip[2] < 0.0 || clip[3] <= 0.0)
+        {
+            return false;
+        }
+        screen[0] = (clip[0] / clip[3] * 0.5 + 0.5) * width;
+        screen[1] = (0.5 - clip[1] / clip[3] * 0.5) * height;
+        screen[2] = clip[2] / clip[3];
+        return true;
+    }
+};
+
+// Depth of the nearest triangle covering every pixel centre, one triangle and one pixel at a time.
+std::vector<double> RasterizeReference( const Projection &projection, const std::vector<float> &positions,
+                                        const std::vector<uint32_t> &indices, uint32_t width, uint32_t height )
+{
+    std::vector<double> depth(size_t(width) * height, 1.0);
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        double corners[3][3] = {};
+        bool   inFront = true;
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            inFront &= projection.Project(&positions[indices[i + corner] * 3], width, height, corners[corner]);
+        }
+        double area = (corners[1][0] - corners[0][0]) * (corners[2][1] - corners[0][1]) -
+                      (corners[2][0] - corners[0][0]) * (corners[1][1] - corners[0][1]);
+        if (!inFront || area == 0.0)
+        {
+            continue;
+        }
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                double edges[3];
+                for (int edge = 0; edge < 3; ++edge)
+                {
+                    const double* a = corners[edge];
+                    const double* b = corners[(edge + 1) % 3];
+                    edges[edge] = ((b[0] - a[0]) * (y + 0.5 - a[1]) - (b[1] - a[1]) * (x + 0.5 - a[0])) / area;
+                }
+                if (edges[0] >= 0.0 && edges[1] >= 0.0 && edges[2] >= 0.0)
+                {
+                    double z = corners[0][2] + (corners[1][2] - corners[0][2]) * edges[2] +
+                               (corners[2][2] - corners[0][2]) * edges[0];
+                    depth[size_t(y) * width + x] = std::min(depth[size_t(y) * width + x], z);
+                }
+            }
+        }
+    }
+    return depth;
+}
+
+// Random triangles in front of the camera at random depths, some crossing the near plane, rasterized into
+// buffers of random sizes.
+void TestRasterize()
+{
+    Projection                            projection;
+    std::mt19937                          random(5);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    bool                                  depthMatches = true;
+    bool                                  serialMatches = true;
+    bool                                  conservative = true;
+    bool                                  selfVisible = true;
+    for (int trial = 0; trial < 10; ++trial)
+    {
+        OcclusionCuller culler(8 + random() % 300, 8 + random() % 200);
+        uint32_t        width = culler.GetWidth();
+        uint32_t        height = culler.GetHeight();
+        EE_CHECK(width % 8 == 0 && height % 8 == 0);
+
+        std::vector<float>    positions;
+        std::vector<uint32_t> indices;
+        uint32_t              numTriangles = 1 + random() % 100;
+        for (uint32_t i = 0; i < numTriangles; ++i)
+        {
+            float z = 2.0f + std::fabs(value(random)) * 30.0f;
+            float x = value(random) * z;
+            float y = value(random) * z;
+            float size = std::fabs(value(random)) * z * 0.5f;
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                positions.insert(positions.end(), {x + value(random) * size, y + value(random) * size,
+                                                   i % 17 == 0 && corner == 0 ? 0.01f : z + value(random) * size * 0.3f});
+                indices.push_back(i * 3 + corner);
+            }
+        }
+        culler.AddOccluder(projection.m, positions.data(), positions.size() / 3, 3 * sizeof(float), indices.data(),
+                           indices.size());
+        culler.Rasterize(trial % 2 != 0);
+
+        // Pixel centres right on an edge may go either way.
+        auto     expected = RasterizeReference(projection, positions, indices, width, height);
+        uint32_t numDifferent = 0;
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            numDifferent += std::fabs(culler.GetDepth()[i] - expected[i]) > 1e-4 ? 1 : 0;
+        }
+        depthMatches &= numDifferent <= width * height / 500 + 3;
+
+        OcclusionCuller other(width, height);
+        other.AddOccluder(projection.m, positions.data(), positions.size() / 3, 3 * sizeof(float), indices.data(),
+                          indices.size());
+        other.Rasterize(trial % 2 == 0);
+        serialMatches &= other.GetDepth() == culler.GetDepth();
+
+        // A box is only hidden when it is behind the depth buffer at every pixel its screen rectangle covers.
+        const auto &depth = culler.GetDepth();
+        for (int i = 0; i < 500; ++i)
+        {
+            float       z = 1.0f + std::fabs(value(random)) * 40.0f;
+            float       center[3] = {value(random) * z, value(random) * z, z};
+            BoundingBox box;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                float extent = std::fabs(value(random)) * z * 0.05f;
+                box.Min[axis] = center[axis] - extent;
+                box.Max[axis] = center[axis] + extent;
+            }
+            if (culler.IsVisible(projection.m, box))
+            {
+                continue;
+            }
+
+            double minX = 1e30, maxX = -1e30, minY = 1e30, maxY = -1e30, minZ = 1e30;
+            bool   inFront = true;
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                float  point[3] = {corner & 1 ? box.Max[0] : box.Min[0], corner & 2 ? box.Max[1] : box.Min[1],
+                                   corner & 4 ? box.Max[2] : box.Min[2]};
+                double screen[3];
+                if (!projection.Project(point, width, height, screen))
+                {
+                    inFront = false;
+                    continue;
+                }
+                minX = std::min(minX, screen[0]);
+                maxX = std::max(maxX, screen[0]);
+                minY = std::min(minY, screen[1]);
+                maxY = std::max(maxY, screen[1]);
+                minZ = std::min(minZ, screen[2]);
+            }
+            int firstX = int(std::max(0.0, std::floor(minX)));
+            int lastX = int(std::min(width - 1.0, std::floor(maxX)));
+            int firstY = int(std::max(0.0, std::floor(minY)));
+            int lastY = int(std::min(height - 1.0, std::floor(maxY)));
+            conservative &= inFront && firstX <= lastX && firstY <= lastY;
+            for (int y = firstY; y <= lastY && conservative; ++y)
+            {
+                for (int x = firstX; x <= lastX; ++x)
+                {
+                    conservative &= minZ > depth[size_t(y) * width + x];
+                }
+            }
+        }
+
+        // No triangle hides its own bounds.
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            BoundingBox box = {{1e30f, 1e30f, 1e30f}, {-1e30f, -1e30f, -1e30f}};
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    box.Min[axis] = std::min(box.Min[axis], positions[indices[i + corner] * 3 + axis]);
+                    box.Max[axis] = std::max(box.Max[axis], positions[indices[i + corner] * 3 + axis]);
+                }
+            }
+            OcclusionCuller single(width, height);
+            single.AddOccluder(projection.m, positions.data(), positions.size() / 3, 3 * sizeof(float),
+                               &indices[i], 3);
+            single.Rasterize(false);
+            selfVisible &= single.IsVisible(projection.m, box);
+        }
+    }
+    EE_CHECK(depthMatches && serialMatches && conservative && selfVisible);
+}
+
+void TestWall()
+{
+    Projection      projection;
+    OcclusionCuller culler;
+    float           wall[] = {-50.0f, -50.0f, 10.0f, 50.0f, -50.0f, 10.0f, 50.0f, 50.0f, 10.0f, -50.0f, 50.0f, 10.0f};
+    uint32_t        indices[] = {0, 1, 2, 0, 2, 3};
+    culler.AddOccluder(projection.m, wall, 4, 3 * sizeof(float), indices, 6);
+    culler.Rasterize();
+
+    BoundingBox behind = {{-1.0f, -1.0f, 20.0f}, {1.0f, 1.0f, 22.0f}};
+    BoundingBox inFront = {{-1.0f, -1.0f, 5.0f}, {1.0f, 1.0f, 7.0f}};
+    BoundingBox across = {{-1.0f, -1.0f, 9.0f}, {1.0f, 1.0f, 11.0f}};
+    EE_CHECK(!culler.IsVisible(projection.m, behind));
+    EE_CHECK(culler.IsVisible(projection.m, inFront) && culler.IsVisible(projection.m, across));
+
+    culler.Clear();
+    culler.Rasterize();
+    EE_CHECK(culler.IsVisible(projection.m, behind));
+}
+
+// A wall mesh in front of a box mesh, occluders chosen by material the way Model does: only an opaque wall hides
+// the box, one that is blended or alpha tested can be seen through.
+void TestOccluderMaterials()
+{
+    Assets::MeshData wall;
+    float            corners[4][2] = {{-50.0f, -50.0f}, {50.0f, -50.0f}, {50.0f, 50.0f}, {-50.0f, 50.0f}};
+    for (const auto &corner: corners)
+    {
+        wall.Vertices.push_back({{corner[0], corner[1], 10.0f}, {0.0f, 0.0f, -1.0f}, {0.0f, 0.0f}});
+    }
+    wall.Indices = {0, 1, 2, 0, 2, 3};
+    BoundingBox behind = {{-1.0f, -1.0f, 20.0f}, {1.0f, 1.0f, 22.0f}};
+
+    Projection projection;
+    for (auto alphaMode: {Assets::MaterialAlphaMode::Opaque, Assets::MaterialAlphaMode::Mask,
+                          Assets::MaterialAlphaMode::Blend})
+    {
+        Assets::MaterialData material;
+        material.AlphaMode = alphaMode;
+
+        OcclusionCuller        culler;
+        Geometry::OccluderMesh occluder;
+        if (Assets::IsOpaque(material) &&
+            Geometry::MakeOccluderMesh(wall.Vertices[0].Position, wall.Vertices.size(), sizeof(Assets::MeshVertex),
+                                       wall.Indices.data(), wall.Indices.size(), &occluder))
+        {
+            culler.AddOccluder(projection.m, occluder);
+        }
+        culler.Rasterize();
+        EE_CHECK(culler.IsVisible(projection.m, behind) == (alphaMode != Assets::MaterialAlphaMode::Opaque));
+    }
+
+    // Too many triangles to be worth rasterizing.
+    std::vector<uint32_t>  indices((Geometry::MAX_OCCLUDER_TRIANGLES + 1) * 3, 0);
+    Geometry::OccluderMesh occluder;
+    EE_CHECK(!Geometry::MakeOccluderMesh(wall.Vertices[0].Position, wall.Vertices.size(), sizeof(Assets::MeshVertex),
+                                         indices.data(), indices.size(), &occluder));
+    EE_CHECK(Geometry::MakeOccluderMesh(wall.Vertices[0].Position, wall.Vertices.size(), sizeof(Assets::MeshVertex),
+                                        wall.Indices.data(), wall.Indices.size(), &occluder));
+    EE_CHECK(occluder.Positions.size() == 12 && occluder.Positions[3] == 50.0f && occluder.Indices == wall.Indices);
+}
+
+}
+
+int main()
+{
+    TestRasterize();
+    TestWall();
+    TestOccluderMaterials();
+    return Tests::Finish();
+}
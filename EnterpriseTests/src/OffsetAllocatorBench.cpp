@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Core/OffsetAllocator.h"
+
+using namespace Enterprise;
+using Core::OffsetAllocator;
+
+namespace {
+
+constexpr int NUM_ROUNDS = 4;
+constexpr int ALLOCATIONS_PER_ROUND = 100000;
+
+}
+
+// Mesh sized allocations out of a 1 GiB arena, freeing a random half after every round, as models stream in and
+// out.
+int main()
+{
+    std::mt19937          random(1);
+    OffsetAllocator       allocator(1u << 30);
+    std::vector<uint32_t> offsets;
+    size_t                numOperations = 0;
+
+    Tests::Timer timer;
+    for (int round = 0; round < NUM_ROUNDS; ++round)
+    {
+        for (int i = 0; i < ALLOCATIONS_PER_ROUND; ++i, ++numOperations)
+        {
+            uint32_t offset = allocator.Allocate(1 + random() % 4096);
+            if (EE_CHECK(offset != OffsetAllocator::INVALID_OFFSET))
+            {
+                offsets.push_back(offset);
+            }
+        }
+        std::shuffle(offsets.begin(), offsets.end(), random);
+        for (size_t i = offsets.size() / 2; i > 0; --i, ++numOperations)
+        {
+            allocator.Free(offsets.back());
+            offsets.pop_back();
+        }
+    }
+    double milliseconds = timer.GetMilliseconds();
+    std::printf("%zu operations: %.1f ns each, %zu free blocks, fragmentation %.3f\n", numOperations,
+                milliseconds * 1e6 / double(numOperations), allocator.GetNumFreeBlocks(),
+                allocator.GetFragmentation());
+
+    timer.Reset();
+    auto moves = allocator.Defragment();
+    std::printf("defragment %zu allocations: %.2f ms\n", moves.size(), timer.GetMilliseconds());
+    EE_CHECK(moves.size() == offsets.size() && allocator.GetFragmentation() == 0.0f);
+    return Tests::Finish();
+}
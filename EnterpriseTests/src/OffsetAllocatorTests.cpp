@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Core/OffsetAllocator.h"
+
+using namespace Enterprise;
+using Core::OffsetAllocator;
+
+namespace {
+
+void TestBestFit()
+{
+    OffsetAllocator allocator(1000);
+    auto            a = allocator.Allocate(100);
+    auto            b = allocator.Allocate(200);
+    auto            c = allocator.Allocate(300);
+    EE_CHECK(a == 0 && b == 100 && c == 300);
+
+    allocator.Free(b);
+    EE_CHECK(allocator.GetFreeSize() == 600 && allocator.GetNumFreeBlocks() == 2);
+    EE_CHECK(allocator.GetFragmentation() > 0.0f);
+
+    // The 200 unit hole fits better than the 400 units at the end.
+    auto d = allocator.Allocate(150);
+    EE_CHECK(d == 100);
+
+    // Freeing both neighbours of the 50 unit hole merges the three blocks.
+    allocator.Free(a);
+    allocator.Free(d);
+    EE_CHECK(allocator.GetNumFreeBlocks() == 2 && allocator.GetLargestFreeBlock() == 400);
+    EE_CHECK(allocator.Allocate(700) == OffsetAllocator::INVALID_OFFSET);
+    EE_CHECK(allocator.Allocate(0) == OffsetAllocator::INVALID_OFFSET);
+
+    allocator.Grow(1100);
+    EE_CHECK(allocator.GetSize() == 1100 && allocator.GetLargestFreeBlock() == 500);
+
+    auto moves = allocator.Defragment();
+    EE_CHECK(moves.size() == 1 && moves[0].Source == 300 && moves[0].Destination == 0 && moves[0].Size == 300);
+    EE_CHECK(allocator.GetNumFreeBlocks() == 1 && allocator.GetLargestFreeBlock() == 800);
+    EE_CHECK(allocator.GetFragmentation() == 0.0f);
+
+    allocator.Free(0);
+    EE_CHECK(allocator.GetFreeSize() == 1100 && allocator.GetNumAllocations() == 0);
+}
+
+// Random allocations and frees never overlap and account for every unit.
+void TestRandom()
+{
+    std::mt19937                                   random(1);
+    OffsetAllocator                                allocator(1 << 20);
+    std::vector<std::pair<uint32_t, uint32_t> >    live;
+    for (int i = 0; i < 100000; ++i)
+    {
+        if (live.empty() || random() % 2)
+        {
+            uint32_t size = 1 + random() % 2000;
+            uint32_t offset = allocator.Allocate(size);
+            if (offset != OffsetAllocator::INVALID_OFFSET)
+            {
+                live.emplace_back(offset, size);
+            }
+        } else
+        {
+            size_t index = random() % live.size();
+            allocator.Free(live[index].first);
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+
+    std::set<std::pair<uint32_t, uint32_t> > sorted(live.begin(), live.end());
+    uint32_t                                 end = 0;
+    uint64_t                                 used = 0;
+    bool                                     overlapping = false;
+    for (const auto &[offset, size]: sorted)
+    {
+        overlapping |= offset < end;
+        end = offset + size;
+        used += size;
+    }
+    EE_CHECK(!overlapping);
+    EE_CHECK(used == allocator.GetUsedSize());
+    EE_CHECK(live.size() == allocator.GetNumAllocations());
+
+    auto     moves = allocator.Defragment();
+    uint32_t offset = 0;
+    bool     packed = true;
+    auto     source = sorted.begin();
+    for (const auto &move: moves)
+    {
+        packed &= move.Destination == offset && move.Source == source->first && move.Size == source->second;
+        offset += move.Size;
+        ++source;
+    }
+    EE_CHECK(packed && moves.size() == sorted.size());
+    EE_CHECK(offset == allocator.GetUsedSize() && allocator.GetNumFreeBlocks() == 1);
+}
+
+}
+
+int main()
+{
+    TestBestFit();
+    TestRandom();
+    return Tests::Finish();
+}
@@ -0,0 +1,80 @@
+#include <cstdio>
+#include <cstring>
+
+#include "Test.h"
+#include "TestMeshes.h"
+#include "Enterprise/Assets/ModelImporter.h"
+#include "Enterprise/Core/ThreadPool.h"
+
+using namespace Enterprise;
+
+namespace {
+
+constexpr uint32_t NUM_MESHES = 16;
+constexpr uint32_t GRID_SIZE = 40;
+constexpr int      NUM_RUNS = 3;
+
+Assets::ModelData MakeModel()
+{
+    Assets::ModelData model;
+    for (uint32_t i = 0; i < NUM_MESHES; ++i)
+    {
+        model.Meshes.push_back(i % 2 == 0 ? Tests::MakeGridMesh(GRID_SIZE, 0.05f, i + 1)
+                                          : Tests::MakeSphereMesh(GRID_SIZE, GRID_SIZE, 1.0f, float(i)));
+    }
+    model.Materials.resize(1);
+    return model;
+}
+
+bool SameMesh( const Assets::MeshData &a, const Assets::MeshData &b )
+{
+    return a.Vertices.size() == b.Vertices.size() &&
+           std::memcmp(a.Vertices.data(), b.Vertices.data(), a.Vertices.size() * sizeof(Assets::MeshVertex)) == 0 &&
+           a.Indices == b.Indices && a.PackedVertices == b.PackedVertices && a.VertexFormat == b.VertexFormat &&
+           a.Meshlets.size() == b.Meshlets.size() && a.Lods.size() == b.Lods.size();
+}
+
+}
+
+// ProcessModelData spreads the meshes of a model over the shared pool. Processing the same meshes one model at a
+// time gives the single threaded time, and must give the same meshes.
+int main()
+{
+    const Assets::ModelData source = MakeModel();
+
+    double            serialTime = 0.0;
+    double            parallelTime = 0.0;
+    Assets::ModelData serial;
+    Assets::ModelData parallel;
+    for (int run = 0; run < NUM_RUNS; ++run)
+    {
+        serial = source;
+        Tests::Timer timer;
+        for (auto &mesh: serial.Meshes)
+        {
+            Assets::ModelData single;
+            single.Meshes.push_back(std::move(mesh));
+            single.Materials = source.Materials;
+            Assets::ProcessModelData(&single);
+            mesh = std::move(single.Meshes[0]);
+        }
+        serialTime += timer.GetMilliseconds();
+
+        parallel = source;
+        timer.Reset();
+        Assets::ProcessModelData(&parallel);
+        parallelTime += timer.GetMilliseconds();
+    }
+
+    for (size_t i = 0; i < source.Meshes.size(); ++i)
+    {
+        EE_CHECK(SameMesh(serial.Meshes[i], parallel.Meshes[i]));
+        EE_CHECK(!parallel.Meshes[i].Meshlets.empty());
+    }
+
+    std::printf("%u meshes, %u pool threads plus the caller\n", NUM_MESHES,
+                Core::Threads::ThreadPool::Get().GetNumThreads());
+    std::printf("one mesh at a time: %8.2f ms\n", serialTime / NUM_RUNS);
+    std::printf("ProcessModelData:   %8.2f ms (%.2fx)\n", parallelTime / NUM_RUNS, serialTime / parallelTime);
+    return Tests::Finish();
+}
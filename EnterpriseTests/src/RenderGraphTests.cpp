@@ -0,0 +1,297 @@
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/RenderGraph/RenderGraph.h"
+
+using namespace Enterprise;
+using RenderGraph::ResourceState;
+
+namespace {
+
+struct TestAccess {
+    RenderGraph::ResourceHandle Resource;
+    ResourceState               State;
+    bool                        Write;
+};
+
+// The last pass before pass that writes resource, or -1.
+int FindLastWriter( const std::vector<std::vector<TestAccess>> &accesses, int pass,
+                    RenderGraph::ResourceHandle                resource )
+{
+    for (int earlier = pass - 1; earlier >= 0; --earlier)
+    {
+        for (const auto &access: accesses[earlier])
+        {
+            if (access.Resource == resource && access.Write)
+            {
+                return earlier;
+            }
+        }
+    }
+    return -1;
+}
+
+// A frame of the renderer: clear and draw to imported targets, copy to the back buffer, and a pass whose output
+// nothing reads.
+void TestCullingAndBarriers()
+{
+    RenderGraph::RenderGraph graph;
+    auto color = graph.ImportResource("Color");
+    auto depth = graph.ImportResource("Depth");
+    auto backBuffer = graph.ImportResource("BackBuffer", ResourceState::Present);
+    auto unusedTexture = graph.CreateTexture("Unused", {64, 64, 28, 1, 1});
+
+    graph.AddPass("Clear").Write(color, ResourceState::RenderTarget).Write(depth, ResourceState::DepthWrite);
+    graph.AddPass("Scene").Write(color, ResourceState::RenderTarget).Write(depth, ResourceState::DepthWrite);
+    uint32_t unusedPass = graph.AddPass("Unused")
+                               .Read(color, ResourceState::PixelShaderResource)
+                               .Write(unusedTexture, ResourceState::RenderTarget)
+                               .GetPass();
+    graph.AddPass("Copy").Read(color, ResourceState::CopySource).Write(backBuffer, ResourceState::CopyDest);
+    graph.ExportResource(backBuffer, ResourceState::Present);
+    if (!EE_CHECK(graph.Compile()))
+    {
+        return;
+    }
+
+    const auto &schedule = graph.GetSchedule();
+    const auto &barriers = graph.GetBarriers();
+    EE_CHECK(graph.IsCulled(unusedPass));
+    if (!EE_CHECK(schedule.size() == 3))
+    {
+        return;
+    }
+    // Targets of unknown state are transitioned on their first use, and not again while the state holds.
+    EE_CHECK(schedule[0].NumBarriers == 2);
+    EE_CHECK(barriers[0].Before == ResourceState::Unknown && barriers[0].After == ResourceState::RenderTarget);
+    EE_CHECK(schedule[1].NumBarriers == 0);
+    EE_CHECK(schedule[2].NumBarriers == 2);
+    EE_CHECK(barriers[schedule[2].FirstBarrier].After == ResourceState::CopySource);
+    EE_CHECK(barriers[schedule[2].FirstBarrier + 1].Before == ResourceState::Present &&
+             barriers[schedule[2].FirstBarrier + 1].After == ResourceState::CopyDest);
+
+    const auto &finalBarriers = graph.GetFinalBarriers();
+    EE_CHECK(finalBarriers.size() == 1 && finalBarriers[0].Resource == backBuffer &&
+             finalBarriers[0].After == ResourceState::Present);
+    EE_CHECK(graph.GetLifetime(unusedTexture).FirstPass == RenderGraph::INVALID_PASS);
+    EE_CHECK(graph.GetLifetime(color).FirstPass == 0 && graph.GetLifetime(color).LastPass == 2);
+}
+
+void TestReadStates()
+{
+    RenderGraph::RenderGraph graph;
+    auto texture = graph.CreateTexture("Texture", {});
+    auto output = graph.ImportResource("Output", ResourceState::Common);
+
+    graph.AddPass("Write").Write(texture, ResourceState::RenderTarget);
+    graph.AddPass("Read").Read(texture, ResourceState::PixelShaderResource).SetSideEffects();
+    graph.AddPass("ReadCompute").Read(texture, ResourceState::NonPixelShaderResource).SetSideEffects();
+    graph.AddPass("ReadAgain").Read(texture, ResourceState::PixelShaderResource).Write(output,
+                                                                                       ResourceState::RenderTarget);
+    graph.AddPass("Compute").Write(texture, ResourceState::UnorderedAccess).SetSideEffects();
+    graph.AddPass("ComputeAgain").Write(texture, ResourceState::UnorderedAccess).SetSideEffects();
+    graph.ExportResource(output, ResourceState::PixelShaderResource);
+    if (!EE_CHECK(graph.Compile()) || !EE_CHECK(graph.GetSchedule().size() == 6))
+    {
+        return;
+    }
+
+    const auto &schedule = graph.GetSchedule();
+    const auto &barriers = graph.GetBarriers();
+    EE_CHECK(schedule[0].NumBarriers == 1 && barriers[0].Before == ResourceState::Common);
+    // Consecutive reads share one transition to every state they read in.
+    EE_CHECK(schedule[1].NumBarriers == 1 &&
+             barriers[1].After == (ResourceState::PixelShaderResource | ResourceState::NonPixelShaderResource));
+    EE_CHECK(schedule[2].NumBarriers == 0);
+    EE_CHECK(schedule[3].NumBarriers == 1 && barriers[schedule[3].FirstBarrier].Resource == output);
+    EE_CHECK(schedule[4].NumBarriers == 1 &&
+             barriers[schedule[4].FirstBarrier].After == ResourceState::UnorderedAccess);
+    // Unordered access after unordered access only waits for the first.
+    EE_CHECK(schedule[5].NumBarriers == 1 &&
+             barriers[schedule[5].FirstBarrier].Type == RenderGraph::BarrierType::UnorderedAccess);
+    EE_CHECK(graph.GetLifetime(texture).FirstPass == 0 && graph.GetLifetime(texture).LastPass == 5);
+}
+
+void TestUnwrittenReads()
+{
+    // Nothing is exported and no pass has side effects, so everything is culled.
+    RenderGraph::RenderGraph graph;
+    auto first = graph.CreateTexture("First", {});
+    auto second = graph.CreateTexture("Second", {});
+    graph.AddPass("A").Write(first, ResourceState::RenderTarget);
+    graph.AddPass("B").Read(first, ResourceState::PixelShaderResource).Write(second, ResourceState::RenderTarget);
+    EE_CHECK(graph.Compile());
+    EE_CHECK(graph.GetSchedule().empty() && graph.IsCulled(0) && graph.IsCulled(1));
+
+    graph.Reset();
+    auto texture = graph.CreateTexture("Texture", {});
+    graph.AddPass("Read").Read(texture, ResourceState::PixelShaderResource).SetSideEffects();
+    EE_CHECK(!graph.Compile());
+    EE_CHECK(graph.GetSchedule().empty());
+}
+
+// Random graphs against a simple model: the culled passes are those no export or side effect depends on, and
+// replaying the barriers leaves every resource in the state each pass uses it in.
+void TestRandomGraphs()
+{
+    const ResourceState readStates[] = {ResourceState::PixelShaderResource, ResourceState::NonPixelShaderResource,
+                                        ResourceState::CopySource, ResourceState::DepthRead,
+                                        ResourceState::ResolveSource};
+    const ResourceState writeStates[] = {ResourceState::RenderTarget, ResourceState::UnorderedAccess,
+                                         ResourceState::DepthWrite, ResourceState::CopyDest,
+                                         ResourceState::ResolveDest};
+
+    std::mt19937 random(5);
+    for (int run = 0; run < 3000; ++run)
+    {
+        RenderGraph::RenderGraph graph;
+        int                      numResources = 1 + int(random() % 6);
+        int                      numPasses = 1 + int(random() % 10);
+
+        std::vector<bool>          imported(numResources);
+        std::vector<bool>          written(numResources, false);
+        std::vector<ResourceState> initialStates(numResources, ResourceState::Common);
+        for (int i = 0; i < numResources; ++i)
+        {
+            imported[i] = random() % 2 != 0;
+            if (imported[i])
+            {
+                initialStates[i] = random() % 2 != 0 ? ResourceState::Unknown : ResourceState::Common;
+                graph.ImportResource("Imported", initialStates[i]);
+            } else
+            {
+                graph.CreateTexture("Texture", {});
+            }
+        }
+
+        std::vector<std::vector<TestAccess>> accesses(numPasses);
+        std::vector<bool>                    sideEffects(numPasses);
+        bool                                 valid = true;
+        for (int pass = 0; pass < numPasses; ++pass)
+        {
+            auto              builder = graph.AddPass("Pass");
+            std::vector<bool> used(numResources, false);
+            for (int i = 1 + int(random() % 3); i > 0; --i)
+            {
+                auto resource = RenderGraph::ResourceHandle(random() % numResources);
+                if (used[resource])
+                {
+                    continue;
+                }
+                used[resource] = true;
+                bool write = random() % 2 != 0;
+                if (write)
+                {
+                    accesses[pass].push_back({resource, writeStates[random() % 5], true});
+                    builder.Write(resource, accesses[pass].back().State);
+                } else
+                {
+                    valid &= imported[resource] || written[resource];
+                    accesses[pass].push_back({resource, readStates[random() % 5], false});
+                    builder.Read(resource, accesses[pass].back().State);
+                }
+            }
+            for (const auto &access: accesses[pass])
+            {
+                written[access.Resource] = written[access.Resource] || access.Write;
+            }
+            sideEffects[pass] = random() % 5 == 0;
+            if (sideEffects[pass])
+            {
+                builder.SetSideEffects();
+            }
+        }
+
+        std::vector<bool>          exported(numResources);
+        std::vector<ResourceState> finalStates(numResources);
+        for (int i = 0; i < numResources; ++i)
+        {
+            exported[i] = random() % 3 == 0;
+            if (exported[i])
+            {
+                finalStates[i] = random() % 2 != 0 ? ResourceState::Present : ResourceState::PixelShaderResource;
+                graph.ExportResource(RenderGraph::ResourceHandle(i), finalStates[i]);
+            }
+        }
+
+        if (!EE_CHECK(graph.Compile() == valid) || !valid)
+        {
+            continue;
+        }
+
+        // Dependencies only point to earlier passes, so one sweep from the back finds every needed pass.
+        std::vector<bool> needed(sideEffects);
+        for (int i = 0; i < numResources; ++i)
+        {
+            int writer = FindLastWriter(accesses, numPasses, RenderGraph::ResourceHandle(i));
+            if (exported[i] && writer >= 0)
+            {
+                needed[writer] = true;
+            }
+        }
+        for (int pass = numPasses - 1; pass >= 0; --pass)
+        {
+            for (const auto &access: accesses[pass])
+            {
+                int writer = FindLastWriter(accesses, pass, access.Resource);
+                if (needed[pass] && writer >= 0)
+                {
+                    needed[writer] = true;
+                }
+            }
+        }
+        bool cullMatches = true;
+        for (int pass = 0; pass < numPasses; ++pass)
+        {
+            cullMatches &= graph.IsCulled(uint32_t(pass)) == !needed[pass];
+        }
+        EE_CHECK(cullMatches);
+
+        std::vector<ResourceState> states(initialStates);
+        bool                       statesMatch = true;
+        for (const auto &scheduled: graph.GetSchedule())
+        {
+            for (uint32_t i = 0; i < scheduled.NumBarriers; ++i)
+            {
+                const auto &barrier = graph.GetBarriers()[scheduled.FirstBarrier + i];
+                if (barrier.Type == RenderGraph::BarrierType::Transition)
+                {
+                    statesMatch &= barrier.Before != barrier.After && barrier.Before == states[barrier.Resource];
+                    states[barrier.Resource] = barrier.After;
+                } else
+                {
+                    statesMatch &= barrier.After == ResourceState::UnorderedAccess;
+                }
+            }
+            for (const auto &access: accesses[scheduled.Pass])
+            {
+                auto state = static_cast<uint32_t>(states[access.Resource]);
+                auto used = static_cast<uint32_t>(access.State);
+                statesMatch &= access.Write ? state == used
+                                            : RenderGraph::IsReadState(states[access.Resource]) &&
+                                              (state & used) == used;
+            }
+        }
+        for (const auto &barrier: graph.GetFinalBarriers())
+        {
+            states[barrier.Resource] = barrier.After;
+        }
+        for (int i = 0; i < numResources; ++i)
+        {
+            statesMatch &= !exported[i] || states[i] == finalStates[i];
+        }
+        EE_CHECK(statesMatch);
+    }
+}
+
+}
+
+int main()
+{
+    TestCullingAndBarriers();
+    TestReadStates();
+    TestUnwrittenReads();
+    TestRandomGraphs();
+    return Tests::Finish();
+}
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Scene/RenderQueue.h"
+
+using namespace Enterprise;
+using Scene::RenderQueue;
+
+namespace {
+
+constexpr uint32_t NUM_DRAWS = 200000;
+constexpr int      NUM_RUNS = 20;
+constexpr double   TARGET_MILLISECONDS = 0.5;
+
+// Draws of a large frame: two passes, 16 pipelines, 4096 materials, a tenth of them blended.
+void AddFrame( RenderQueue* queue, uint32_t seed )
+{
+    std::mt19937                          random(seed);
+    std::uniform_real_distribution<float> depth(0.1f, 1000.0f);
+    for (uint32_t i = 0; i < NUM_DRAWS; ++i)
+    {
+        queue->Add(RenderQueue::MakeKey(random() % 2, random() % 16, random() % 4096, depth(random),
+                                        i % 10 == 0),
+                   i);
+    }
+}
+
+// Fastest and mean time of sorting the frame built by add, after checking the order once. Returns the fastest.
+template<typename Add>
+double Measure( const char* name, Add add )
+{
+    RenderQueue queue;
+    queue.Reserve(NUM_DRAWS);
+    double best = 1e30;
+    double total = 0.0;
+    for (int run = 0; run < NUM_RUNS; ++run)
+    {
+        queue.Clear();
+        add(&queue, uint32_t(run + 1));
+        Tests::Timer timer;
+        queue.Sort();
+        double time = timer.GetMilliseconds();
+        best = std::min(best, time);
+        total += time;
+        if (run == 0)
+        {
+            EE_CHECK(std::is_sorted(queue.GetKeys().begin(), queue.GetKeys().end()));
+        }
+    }
+    std::printf("%-12s best %6.3f ms, mean %6.3f ms (target %.1f ms)\n", name, best, total / NUM_RUNS,
+                TARGET_MILLISECONDS);
+    return best;
+}
+
+}
+
+int main()
+{
+    std::printf("%u draws\n", NUM_DRAWS);
+    // The target is for a frame; a miss fails the bench.
+    double frame = Measure("frame keys", AddFrame);
+    if (!EE_CHECK(frame <= TARGET_MILLISECONDS))
+    {
+        std::printf("  frame keys missed the %.1f ms target by %.3f ms\n", TARGET_MILLISECONDS,
+                    frame - TARGET_MILLISECONDS);
+    }
+    // Keys that differ in every bit, the slowest case, for comparison.
+    Measure("random keys", []( RenderQueue* queue, uint32_t seed )
+    {
+        std::mt19937_64 random(seed);
+        for (uint32_t i = 0; i < NUM_DRAWS; ++i)
+        {
+            queue->Add(random(), i);
+        }
+    });
+
+    // std::sort of the same frame, as the baseline the radix sort replaces.
+    RenderQueue queue;
+    AddFrame(&queue, 1);
+    std::vector<std::pair<uint64_t, uint32_t>> draws;
+    for (size_t i = 0; i < queue.GetNumDraws(); ++i)
+    {
+        draws.emplace_back(queue.GetKeys()[i], queue.GetPayloads()[i]);
+    }
+    Tests::Timer timer;
+    std::stable_sort(draws.begin(), draws.end(), []( const auto &a, const auto &b ) { return a.first < b.first; });
+    std::printf("%-12s %6.3f ms\n", "stable_sort", timer.GetMilliseconds());
+    return Tests::Finish();
+}
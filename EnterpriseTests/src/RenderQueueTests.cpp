@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Scene/RenderQueue.h"
+
+using namespace Enterprise;
+using Scene::RenderQueue;
+
+namespace {
+
+// Whether Sort orders the queue like a stable sort of its keys.
+bool SortsLikeStableSort( RenderQueue &queue )
+{
+    std::vector<std::pair<uint64_t, uint32_t>> expected;
+    for (size_t i = 0; i < queue.GetNumDraws(); ++i)
+    {
+        expected.emplace_back(queue.GetKeys()[i], queue.GetPayloads()[i]);
+    }
+    std::stable_sort(expected.begin(), expected.end(),
+                     []( const auto &a, const auto &b ) { return a.first < b.first; });
+
+    queue.Sort();
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        if (queue.GetKeys()[i] != expected[i].first || queue.GetPayloads()[i] != expected[i].second)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TestMakeKey()
+{
+    uint64_t key = RenderQueue::MakeKey(3, 77, 123456, 5.0f);
+    EE_CHECK(RenderQueue::GetPass(key) == 3);
+    EE_CHECK(RenderQueue::GetPipeline(key) == 77);
+    EE_CHECK(RenderQueue::GetMaterial(key) == 123456);
+
+    // Pass, then pipeline, then material outweigh depth.
+    EE_CHECK(RenderQueue::MakeKey(0, 5, 9, 1000.0f) < RenderQueue::MakeKey(1, 0, 0, 0.0f));
+    EE_CHECK(RenderQueue::MakeKey(0, 0, 9, 1000.0f) < RenderQueue::MakeKey(0, 1, 0, 0.0f));
+    EE_CHECK(RenderQueue::MakeKey(0, 0, 0, 1000.0f) < RenderQueue::MakeKey(0, 0, 1, 0.0f));
+
+    EE_CHECK(RenderQueue::MakeKey(0, 0, 0, 1.0f) < RenderQueue::MakeKey(0, 0, 0, 2.0f));
+    EE_CHECK(RenderQueue::MakeKey(0, 0, 0, 1.0f, true) > RenderQueue::MakeKey(0, 0, 0, 2.0f, true));
+    EE_CHECK(RenderQueue::MakeKey(0, 0, 0, -1.0f) == RenderQueue::MakeKey(0, 0, 0, 0.0f));
+    EE_CHECK(RenderQueue::MakeKey(0, 0, 0, std::nanf("")) == 0);
+
+    // Fields wider than their bits are truncated instead of spilling into the next one.
+    EE_CHECK(RenderQueue::GetPass(RenderQueue::MakeKey(0, 1u << RenderQueue::PIPELINE_BITS, 0, 0.0f)) == 0);
+    EE_CHECK(RenderQueue::GetMaterial(RenderQueue::MakeKey(0, 0, 0xFFFFFFFF, 1e30f, true)) == 0xFFFFFFFF);
+}
+
+void TestSort()
+{
+    std::mt19937_64                       random(3);
+    std::uniform_real_distribution<float> depth(0.1f, 1000.0f);
+    RenderQueue                           queue;
+
+    // Typical keys, whose differing bits fit next to the index, with a third of them repeated.
+    for (uint32_t i = 0; i < 50000; ++i)
+    {
+        uint64_t key = i % 3 == 2
+                           ? queue.GetKeys()[random() % queue.GetNumDraws()]
+                           : RenderQueue::MakeKey(random() % 2, random() % 8, random() % 2000, depth(random),
+                                                  i % 8 == 0);
+        queue.Add(key, i);
+    }
+    EE_CHECK(SortsLikeStableSort(queue));
+
+    // Keys that differ in every bit go through the wide sort.
+    queue.Clear();
+    for (uint32_t i = 0; i < 50000; ++i)
+    {
+        queue.Add(i % 4 == 3 ? queue.GetKeys()[random() % queue.GetNumDraws()] : random(), i);
+    }
+    EE_CHECK(SortsLikeStableSort(queue));
+
+    // A single differing bit high in the key, equal keys, one draw and none.
+    queue.Clear();
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        queue.Add((random() & 1) << 63 | 42, i);
+    }
+    EE_CHECK(SortsLikeStableSort(queue));
+
+    queue.Clear();
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        queue.Add(7, i);
+    }
+    EE_CHECK(SortsLikeStableSort(queue));
+
+    queue.Clear();
+    queue.Add(1, 0);
+    EE_CHECK(SortsLikeStableSort(queue));
+    queue.Clear();
+    queue.Sort();
+    EE_CHECK(queue.GetNumDraws() == 0);
+}
+
+}
+
+int main()
+{
+    TestMakeKey();
+    TestSort();
+    return Tests::Finish();
+}
@@ -0,0 +1,160 @@
+#include <atomic>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Textures/ResidencyCache.h"
+
+using namespace Enterprise;
+
+namespace {
+
+std::atomic<int> g_NumResident = 0;
+
+// Stands in for a GPU texture: counts the instances alive, as the video memory they would hold.
+class MockTexture {
+public:
+    MockTexture() = default;
+
+    explicit MockTexture( int id ) : m_Id(id) { ++g_NumResident; }
+
+    MockTexture( MockTexture &&other ) noexcept : m_Id(std::exchange(other.m_Id, -1)) {}
+
+    MockTexture &operator=( MockTexture &&other ) noexcept
+    {
+        Release();
+        m_Id = std::exchange(other.m_Id, -1);
+        return *this;
+    }
+
+    ~MockTexture() { Release(); }
+
+    [[nodiscard]] int GetId() const { return m_Id; }
+
+private:
+    void Release()
+    {
+        if (m_Id >= 0)
+        {
+            --g_NumResident;
+        }
+        m_Id = -1;
+    }
+
+    int m_Id = -1;
+};
+
+using MockCache = Textures::ResidencyCache<MockTexture>;
+
+void TestEviction()
+{
+    {
+        MockCache cache(300);
+        auto      a = cache.Insert(1, MockTexture(1), 100);
+        auto      b = cache.Insert(2, MockTexture(2), 100);
+        auto      c = cache.Insert(3, MockTexture(3), 100);
+
+        // Referenced entries stay even over budget.
+        auto d = cache.Insert(4, MockTexture(4), 100);
+        EE_CHECK(g_NumResident == 4 && cache.GetStatistics().ResidentBytes == 400);
+
+        // Released while over budget, so evicted right away.
+        b.Reset();
+        EE_CHECK(g_NumResident == 3 && !cache.Find(2));
+
+        // Within budget again, so it stays.
+        a.Reset();
+        EE_CHECK(g_NumResident == 3);
+
+        // Using 1 again makes 3 the least recently used.
+        c.Reset();
+        auto found = cache.Find(1);
+        EE_CHECK(found && found.Get().GetId() == 1);
+        found.Reset();
+        auto e = cache.Insert(5, MockTexture(5), 100);
+        EE_CHECK(!cache.Find(3) && cache.Find(1) && g_NumResident == 3);
+
+        // Inserting a key again keeps the resident entry and destroys the new one.
+        auto duplicate = cache.Insert(5, MockTexture(55), 100);
+        EE_CHECK(duplicate.Get().GetId() == 5 && g_NumResident == 3);
+
+        cache.SetBudget(0);
+        EE_CHECK(cache.GetStatistics().NumEntries == 2 && g_NumResident == 2);
+        EE_CHECK(cache.GetStatistics().Evictions == 3);
+    }
+    EE_CHECK(g_NumResident == 0);
+}
+
+void TestHandleOutlivesCache()
+{
+    MockCache::Handle handle;
+    {
+        MockCache cache;
+        handle = cache.Insert(9, MockTexture(9), 1);
+    }
+    EE_CHECK(g_NumResident == 1 && handle.Get().GetId() == 9);
+    handle.Reset();
+    EE_CHECK(g_NumResident == 0);
+}
+
+// Threads look up and insert overlapping keys while holding a few handles each, as command lists loading the
+// same textures do.
+void TestConcurrentUse()
+{
+    constexpr int NUM_THREADS = 4;
+    constexpr int NUM_KEYS = 200;
+    {
+        MockCache                cache(500);
+        std::atomic<bool>        wrongEntry = false;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < NUM_THREADS; ++i)
+        {
+            threads.emplace_back([&cache, &wrongEntry, i]
+            {
+                std::mt19937                   random(i);
+                std::vector<MockCache::Handle> held;
+                for (int j = 0; j < 20000; ++j)
+                {
+                    int  key = int(random() % NUM_KEYS);
+                    auto handle = cache.Find(key);
+                    if (!handle)
+                    {
+                        handle = cache.Insert(key, MockTexture(key), 10);
+                    }
+                    wrongEntry = wrongEntry || handle.Get().GetId() != key;
+                    if (random() % 4 == 0)
+                    {
+                        held.push_back(handle);
+                    }
+                    if (held.size() > 8)
+                    {
+                        held.erase(held.begin());
+                    }
+                }
+            });
+        }
+        for (auto &thread: threads)
+        {
+            thread.join();
+        }
+
+        auto statistics = cache.GetStatistics();
+        EE_CHECK(!wrongEntry);
+        EE_CHECK(statistics.ResidentBytes <= 500);
+        EE_CHECK(statistics.NumEntries == uint64_t(g_NumResident));
+        EE_CHECK(statistics.Hits + statistics.Misses == NUM_THREADS * 20000);
+    }
+    EE_CHECK(g_NumResident == 0);
+}
+
+}
+
+int main()
+{
+    TestEviction();
+    TestHandleOutlivesCache();
+    TestConcurrentUse();
+    return Tests::Finish();
+}
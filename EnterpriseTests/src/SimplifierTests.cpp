@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "Test.h"
+#include "TestMeshes.h"
+#include "Enterprise/Assets/ModelImporter.h"
+#include "Enterprise/Geometry/Simplifier.h"
+
+using namespace Enterprise;
+
+namespace {
+
+float Dot( const float* a, const float* b ) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+// Distance from p to the triangle abc (Ericson, Real-Time Collision Detection 5.1.5).
+float GetDistanceToTriangle( const float* p, const float* a, const float* b, const float* c )
+{
+    float ab[3], ac[3], ap[3], bp[3], cp[3], closest[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        ab[i] = b[i] - a[i];
+        ac[i] = c[i] - a[i];
+        ap[i] = p[i] - a[i];
+        bp[i] = p[i] - b[i];
+        cp[i] = p[i] - c[i];
+    }
+    float d1 = Dot(ab, ap), d2 = Dot(ac, ap), d3 = Dot(ab, bp), d4 = Dot(ac, bp), d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+    float va = d3 * d6 - d5 * d4, vb = d5 * d2 - d1 * d6, vc = d1 * d4 - d3 * d2;
+    float v = 0.0f, w = 0.0f;
+    if (d1 <= 0.0f && d2 <= 0.0f)
+    {
+    } else if (d3 >= 0.0f && d4 <= d3)
+    {
+        v = 1.0f;
+    } else if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    {
+        v = d1 / (d1 - d3);
+    } else if (d6 >= 0.0f && d5 <= d6)
+    {
+        w = 1.0f;
+    } else if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    {
+        w = d2 / (d2 - d6);
+    } else if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+    {
+        w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        v = 1.0f - w;
+    } else
+    {
+        v = vb / (va + vb + vc);
+        w = vc / (va + vb + vc);
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        closest[i] = p[i] - a[i] - ab[i] * v - ac[i] * w;
+    }
+    return std::sqrt(Dot(closest, closest));
+}
+
+// Largest distance from a vertex of the original mesh to the simplified surface.
+float GetDeviation( const Assets::MeshData &mesh, const uint32_t* indices, size_t indexCount )
+{
+    float deviation = 0.0f;
+    for (uint32_t vertex: mesh.Indices)
+    {
+        float nearest = INFINITY;
+        for (size_t i = 0; i < indexCount; i += 3)
+        {
+            nearest = std::min(nearest, GetDistanceToTriangle(mesh.Vertices[vertex].Position,
+                                                              mesh.Vertices[indices[i]].Position,
+                                                              mesh.Vertices[indices[i + 1]].Position,
+                                                              mesh.Vertices[indices[i + 2]].Position));
+        }
+        deviation = std::max(deviation, nearest);
+    }
+    return deviation;
+}
+
+// Gentle waves over a unit grid, which simplify well but not for free.
+Assets::MeshData MakeTerrainMesh()
+{
+    Assets::MeshData mesh = Tests::MakeGridMesh(48);
+    for (auto &vertex: mesh.Vertices)
+    {
+        vertex.Position[1] = 0.05f * std::sin(vertex.Position[0] * 6.0f) * std::cos(vertex.Position[2] * 8.0f);
+    }
+    return mesh;
+}
+
+void TestSimplify( const char* name, const Assets::MeshData &mesh, float ratio, float targetError )
+{
+    const float* positions = mesh.Vertices.data()->Position;
+    float        scale = Geometry::GetMeshScale(positions, mesh.Vertices.size(), sizeof(Assets::MeshVertex));
+    size_t       targetIndexCount = size_t(float(mesh.Indices.size() / 3) * ratio) * 3;
+
+    std::vector<uint32_t> indices = mesh.Indices;
+    float                 error = 0.0f;
+    size_t numIndices = Geometry::SimplifyMesh(indices.data(), indices.data(), indices.size(), positions,
+                                               mesh.Vertices.size(), sizeof(Assets::MeshVertex), targetIndexCount,
+                                               targetError, &error);
+    EE_CHECK(numIndices % 3 == 0 && numIndices <= mesh.Indices.size());
+    EE_CHECK(numIndices <= targetIndexCount || error <= targetError);
+    EE_CHECK(numIndices > targetIndexCount || error <= targetError * 1.0001f);
+    EE_CHECK(std::all_of(indices.begin(), indices.begin() + numIndices,
+                         [&]( uint32_t index ) { return index < mesh.Vertices.size(); }));
+
+    // The reported error bounds how far the surface actually moved.
+    float deviation = GetDeviation(mesh, indices.data(), numIndices) / scale;
+    EE_CHECK(deviation <= error * 1.0001f + 1e-6f);
+    std::printf("%-8s %5zu -> %5zu triangles, error %.5f, measured %.5f\n", name, mesh.Indices.size() / 3,
+                numIndices / 3, error, deviation);
+}
+
+void TestFlatGrid()
+{
+    // Every collapse on a plane is free, down to the two triangles that keep the corners.
+    Assets::MeshData mesh = Tests::MakeGridMesh(16);
+    std::vector<uint32_t> indices(mesh.Indices.size());
+    float                 error = 1.0f;
+    size_t numIndices = Geometry::SimplifyMesh(indices.data(), mesh.Indices.data(), mesh.Indices.size(),
+                                               mesh.Vertices.data()->Position, mesh.Vertices.size(),
+                                               sizeof(Assets::MeshVertex), 0, 1e-4f, &error);
+    EE_CHECK(numIndices <= 3 * 8);
+    EE_CHECK(error < 1e-4f);
+}
+
+void TestGenerateLods()
+{
+    Assets::ModelData model;
+    model.Meshes.push_back(MakeTerrainMesh());
+    model.Materials.resize(1);
+    Assets::ModelImportSettings settings;
+    settings.LodMaxError = 0.05f;
+    Assets::ProcessModelData(&model, settings);
+
+    const auto &mesh = model.Meshes[0];
+    EE_CHECK(mesh.Lods.size() >= 2 && mesh.Lods.size() <= settings.NumLods);
+    if (mesh.Lods.empty())
+    {
+        return;
+    }
+    EE_CHECK(mesh.Lods[0].FirstIndex == 0 && mesh.Lods[0].Error == 0.0f);
+    for (size_t i = 1; i < mesh.Lods.size(); ++i)
+    {
+        const auto &lod = mesh.Lods[i];
+        EE_CHECK(lod.NumIndices <= mesh.Lods[i - 1].NumIndices * 9 / 10);
+        EE_CHECK(lod.Error >= mesh.Lods[i - 1].Error);
+        EE_CHECK(lod.FirstIndex + lod.NumIndices <= mesh.Indices.size());
+    }
+
+    // A level error of e model units covers e * pixelsPerUnit pixels.
+    auto     lods = mesh.Lods;
+    uint32_t numLods = uint32_t(lods.size());
+    EE_CHECK(Geometry::SelectLod(lods.data(), numLods, 1e9f, 1.0f) == 0);
+    EE_CHECK(Geometry::SelectLod(lods.data(), numLods, 0.0f, 1.0f) == numLods - 1);
+    EE_CHECK(Geometry::SelectLod(lods.data(), numLods, 1.0f / lods[1].Error, 1.0f) >= 1);
+}
+
+}
+
+int main()
+{
+    Assets::MeshData terrain = MakeTerrainMesh();
+    Assets::MeshData sphere = Tests::MakeSphereMesh(24, 48);
+    TestSimplify("terrain", terrain, 0.25f, 1.0f);
+    TestSimplify("terrain", terrain, 0.02f, 0.01f);
+    TestSimplify("sphere", sphere, 0.25f, 1.0f);
+    TestSimplify("sphere", sphere, 0.02f, 0.01f);
+    TestFlatGrid();
+    TestGenerateLods();
+    return Tests::Finish();
+}
@@ -0,0 +1,67 @@
+#ifndef TEST_H
+#define TEST_H
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+
+namespace Enterprise::Tests {
+
+// Checks that failed so far in this process.
+inline int g_NumFailures = 0;
+
+inline bool Check( bool condition, const char* expression, const char* file, int line )
+{
+    if (!condition)
+    {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        ++g_NumFailures;
+    }
+    return condition;
+}
+
+/**
+ * The exit code of a test: 0 when every check passed.
+ */
+inline int Finish()
+{
+    if (g_NumFailures != 0)
+    {
+        std::fprintf(stderr, "%d checks failed\n", g_NumFailures);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * A directory of its own under the system temp directory, emptied first.
+ */
+inline std::filesystem::path MakeTempDirectory( const std::string &name )
+{
+    auto directory = std::filesystem::temp_directory_path() / "EnterpriseTests" / name;
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory;
+}
+
+class Timer {
+public:
+    Timer(): m_Start(std::chrono::steady_clock::now()) {}
+
+    void Reset() { m_Start = std::chrono::steady_clock::now(); }
+
+    [[nodiscard]] double GetMilliseconds() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_Start;
+};
+
+}
+
+#define EE_CHECK( condition ) ::Enterprise::Tests::Check((condition), #condition, __FILE__, __LINE__)
+
+#endif //TEST_H
@@ -0,0 +1,61 @@
+#ifndef TESTIMAGES_H
+#define TESTIMAGES_H
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+
+namespace Enterprise::Tests {
+
+/**
+ * RGBA8 texels of a smooth gradient with some noise, like a photo more than a flat test pattern.
+ */
+inline std::vector<uint8_t> MakeImage( uint32_t width, uint32_t height, uint32_t seed = 1 )
+{
+    std::mt19937                       random(seed);
+    std::uniform_int_distribution<int> noise(-8, 8);
+
+    std::vector<uint8_t> texels(size_t(width) * height * 4);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            uint8_t* texel = &texels[(size_t(y) * width + x) * 4];
+            int      values[4] = {int(x * 255 / width), int(y * 255 / height), int((x + y) * 127 / (width + height)),
+                                  255 - int(x * 64 / width)};
+            for (int c = 0; c < 4; ++c)
+            {
+                texel[c] = uint8_t(std::min(255, std::max(0, values[c] + noise(random))));
+            }
+        }
+    }
+    return texels;
+}
+
+/**
+ * An uncompressed 32 bit TGA file of RGBA8 texels, stored top down.
+ */
+inline std::vector<uint8_t> EncodeTga( const std::vector<uint8_t> &texels, uint32_t width, uint32_t height )
+{
+    std::vector<uint8_t> file(18 + texels.size());
+    file[2] = 2;
+    file[12] = uint8_t(width);
+    file[13] = uint8_t(width >> 8);
+    file[14] = uint8_t(height);
+    file[15] = uint8_t(height >> 8);
+    file[16] = 32;
+    file[17] = 0x28;
+    for (size_t i = 0; i < texels.size(); i += 4)
+    {
+        file[18 + i] = texels[i + 2];
+        file[18 + i + 1] = texels[i + 1];
+        file[18 + i + 2] = texels[i];
+        file[18 + i + 3] = texels[i + 3];
+    }
+    return file;
+}
+
+}
+
+#endif //TESTIMAGES_H
@@ -0,0 +1,113 @@
+#ifndef TESTMESHES_H
+#define TESTMESHES_H
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include "Enterprise/Assets/ModelData.h"
+
+
+namespace Enterprise::Tests {
+
+/**
+ * A unit grid of size x size quads in the xz plane, its heights displaced by up to roughness, as an indexed
+ * triangle list in row order.
+ */
+inline Assets::MeshData MakeGridMesh( uint32_t size, float roughness = 0.0f, uint32_t seed = 1 )
+{
+    std::mt19937                          random(seed);
+    std::uniform_real_distribution<float> height(-roughness, roughness);
+
+    Assets::MeshData mesh;
+    for (uint32_t z = 0; z <= size; ++z)
+    {
+        for (uint32_t x = 0; x <= size; ++x)
+        {
+            float u = float(x) / float(size);
+            float v = float(z) / float(size);
+            mesh.Vertices.push_back({{u, roughness != 0.0f ? height(random) : 0.0f, v}, {0.0f, 1.0f, 0.0f}, {u, v}});
+        }
+    }
+    for (uint32_t z = 0; z < size; ++z)
+    {
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            uint32_t corner = z * (size + 1) + x;
+            mesh.Indices.insert(mesh.Indices.end(), {corner, corner + size + 1, corner + 1,
+                                                     corner + 1, corner + size + 1, corner + size + 2});
+        }
+    }
+    return mesh;
+}
+
+/**
+ * A closed sphere of rings x segments quads, wound clockwise seen from outside.
+ */
+inline Assets::MeshData MakeSphereMesh( uint32_t rings, uint32_t segments, float radius = 1.0f,
+                                        float    centerX = 0.0f, float centerY = 0.0f, float centerZ = 0.0f )
+{
+    constexpr float PI = 3.14159265f;
+
+    Assets::MeshData mesh;
+    for (uint32_t ring = 0; ring <= rings; ++ring)
+    {
+        float theta = PI * float(ring) / float(rings);
+        for (uint32_t segment = 0; segment <= segments; ++segment)
+        {
+            float phi = 2.0f * PI * float(segment) / float(segments);
+            float normal[3] = {std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+            mesh.Vertices.push_back({{centerX + normal[0] * radius, centerY + normal[1] * radius,
+                                      centerZ + normal[2] * radius},
+                                     {normal[0], normal[1], normal[2]},
+                                     {float(segment) / float(segments), float(ring) / float(rings)}});
+        }
+    }
+    for (uint32_t ring = 0; ring < rings; ++ring)
+    {
+        for (uint32_t segment = 0; segment < segments; ++segment)
+        {
+            uint32_t corner = ring * (segments + 1) + segment;
+            mesh.Indices.insert(mesh.Indices.end(), {corner, corner + 1, corner + segments + 1,
+                                                     corner + 1, corner + segments + 2, corner + segments + 1});
+        }
+    }
+    return mesh;
+}
+
+/**
+ * Write the meshes as a Wavefront OBJ file, which every assimp build imports.
+ */
+inline void WriteObj( const std::filesystem::path &path, const std::vector<Assets::MeshData> &meshes )
+{
+    std::ofstream file(path);
+    size_t        firstVertex = 1;
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        file << "o mesh" << i << "\n";
+        for (const auto &vertex: meshes[i].Vertices)
+        {
+            file << "v " << vertex.Position[0] << " " << vertex.Position[1] << " " << vertex.Position[2] << "\n";
+            file << "vt " << vertex.TexCoord[0] << " " << vertex.TexCoord[1] << "\n";
+            file << "vn " << vertex.Normal[0] << " " << vertex.Normal[1] << " " << vertex.Normal[2] << "\n";
+        }
+        const auto &indices = meshes[i].Indices;
+        for (size_t j = 0; j < indices.size(); j += 3)
+        {
+            file << "f";
+            for (size_t k = 0; k < 3; ++k)
+            {
+                size_t index = firstVertex + indices[j + k];
+                file << " " << index << "/" << index << "/" << index;
+            }
+            file << "\n";
+        }
+        firstVertex += meshes[i].Vertices.size();
+    }
+}
+
+}
+
+#endif //TESTMESHES_H
@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "Test.h"
+#include "TestImages.h"
+#include "Enterprise/Assets/TextureDecoder.h"
+#include "Enterprise/Core/ThreadPool.h"
+
+using namespace Enterprise;
+
+namespace {
+
+constexpr uint32_t NUM_IMAGES = 48;
+constexpr int      NUM_RUNS = 3;
+
+struct Corpus {
+    std::vector<std::vector<uint8_t> > Files;
+    // Expected RGBA8 texels of generated images, empty for files read from disk.
+    std::vector<std::vector<uint8_t> > Texels;
+};
+
+// Images of the sizes a model's textures come in, as TGA files.
+Corpus MakeCorpus()
+{
+    Corpus corpus;
+    for (uint32_t i = 0; i < NUM_IMAGES; ++i)
+    {
+        uint32_t size = 64u << (i % 4);
+        corpus.Texels.push_back(Tests::MakeImage(size, size, i + 1));
+        corpus.Files.push_back(Tests::EncodeTga(corpus.Texels.back(), size, size));
+    }
+    return corpus;
+}
+
+Corpus ReadCorpus( const std::filesystem::path &directory )
+{
+    Corpus corpus;
+    for (const auto &entry: std::filesystem::directory_iterator(directory))
+    {
+        std::ifstream file(entry.path(), std::ios::binary);
+        corpus.Files.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    return corpus;
+}
+
+}
+
+// Decodes a corpus of images one after the other and with DecodeImages, which spreads them over the shared pool.
+// Pass a directory to decode the images in it instead of the generated ones.
+int main( int argc, char** argv )
+{
+    Corpus corpus = argc > 1 ? ReadCorpus(argv[1]) : MakeCorpus();
+
+    std::vector<Assets::EncodedImage> sources;
+    size_t                            numBytes = 0;
+    for (const auto &file: corpus.Files)
+    {
+        sources.push_back({file.data(), file.size(), 0, 0});
+        numBytes += file.size();
+    }
+
+    double serialTime = 0.0;
+    double parallelTime = 0.0;
+    size_t numDecoded = 0;
+    for (int run = 0; run < NUM_RUNS; ++run)
+    {
+        std::vector<Assets::DecodedImage> serial(sources.size());
+        Tests::Timer                      timer;
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            Assets::DecodeImage(sources[i], &serial[i]);
+        }
+        serialTime += timer.GetMilliseconds();
+
+        std::vector<Assets::DecodedImage> parallel(sources.size());
+        timer.Reset();
+        numDecoded = Assets::DecodeImages(sources.data(), sources.size(), parallel.data());
+        parallelTime += timer.GetMilliseconds();
+
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            const auto &image = parallel[i];
+            if (!EE_CHECK(image.IsValid() == serial[i].IsValid()) || !image.IsValid())
+            {
+                continue;
+            }
+            size_t size = image.GetRowPitch() * image.Height;
+            EE_CHECK(std::memcmp(image.Pixels.GetData(), serial[i].Pixels.GetData(), size) == 0);
+            if (i < corpus.Texels.size())
+            {
+                EE_CHECK(size == corpus.Texels[i].size() &&
+                         std::memcmp(image.Pixels.GetData(), corpus.Texels[i].data(), size) == 0);
+            }
+        }
+    }
+    EE_CHECK(numDecoded == sources.size());
+
+    // Data that is not an image fails without taking the batch down.
+    const uint8_t        garbage[3] = {1, 2, 3};
+    Assets::EncodedImage invalid = {garbage, sizeof(garbage), 0, 0};
+    Assets::DecodedImage image;
+    EE_CHECK(!Assets::DecodeImage(invalid, &image) && !image.IsValid());
+
+    std::printf("%zu images, %.1f MB, %u pool threads plus the caller\n", sources.size(), numBytes / 1e6,
+                Core::Threads::ThreadPool::Get().GetNumThreads());
+    std::printf("one at a time: %8.2f ms\n", serialTime / NUM_RUNS);
+    std::printf("DecodeImages:  %8.2f ms (%.2fx)\n", parallelTime / NUM_RUNS, serialTime / parallelTime);
+    return Tests::Finish();
+}
@@ -0,0 +1,92 @@
+#include <atomic>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Core/ThreadPool.h"
+
+using namespace Enterprise;
+using Core::Threads::ThreadPool;
+
+namespace {
+
+void TestParallelFor( ThreadPool &pool )
+{
+    std::vector<int> counts(10007, 0);
+    for (int run = 0; run < 20; ++run)
+    {
+        pool.ParallelFor(counts.size(), 100, [&]( size_t begin, size_t end )
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                ++counts[i];
+            }
+        });
+    }
+    bool allCounted = true;
+    for (int count: counts)
+    {
+        allCounted &= count == 20;
+    }
+    EE_CHECK(allCounted);
+
+    // Nothing to do still returns.
+    pool.ParallelFor(0, 1, []( size_t, size_t ) {});
+}
+
+// Every worker blocked in an inner ParallelFor must not starve the chunks they wait for.
+void TestNestedParallelFor( ThreadPool &pool )
+{
+    std::atomic<size_t> total = 0;
+    pool.ParallelFor(64, 1, [&]( size_t, size_t )
+    {
+        pool.ParallelFor(100, 3, [&]( size_t begin, size_t end ) { total += end - begin; });
+    });
+    EE_CHECK(total == 64 * 100);
+}
+
+void TestExceptions( ThreadPool &pool )
+{
+    bool thrown = false;
+    try
+    {
+        pool.ParallelFor(100, 1, []( size_t begin, size_t )
+        {
+            if (begin == 57)
+            {
+                throw 57;
+            }
+        });
+    } catch (int value)
+    {
+        thrown = value == 57;
+    }
+    EE_CHECK(thrown);
+
+    auto future = pool.Submit([]() -> int { throw 1; });
+    thrown = false;
+    try
+    {
+        future.get();
+    } catch (int)
+    {
+        thrown = true;
+    }
+    EE_CHECK(thrown);
+    EE_CHECK(pool.Submit([] { return 42; }).get() == 42);
+}
+
+}
+
+int main()
+{
+    for (uint32_t numThreads: {1u, 4u})
+    {
+        ThreadPool pool(numThreads);
+        EE_CHECK(pool.GetNumThreads() == numThreads);
+        TestParallelFor(pool);
+        TestNestedParallelFor(pool);
+        TestExceptions(pool);
+    }
+    TestParallelFor(ThreadPool::Get());
+    return Tests::Finish();
+}
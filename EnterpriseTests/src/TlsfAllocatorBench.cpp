@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Core/OffsetAllocator.h"
+#include "Enterprise/Core/TlsfAllocator.h"
+
+using namespace Enterprise;
+
+namespace {
+
+constexpr int      NUM_OPERATIONS = 2000000;
+constexpr size_t   MIN_LIVE = 4096;
+constexpr uint64_t HEAP_SIZE = 32ull << 30;
+constexpr uint64_t GRANULARITY = 64 * 1024;
+
+}
+
+// GPU heap traffic: resources from 64 KB to 8 MB, mostly small, with at least MIN_LIVE of them alive. The same
+// operations go through the TLSF allocator and the best fit OffsetAllocator, in units of 64 KB there.
+int main()
+{
+    std::mt19937_64       random(1);
+    std::vector<uint64_t> sizes(NUM_OPERATIONS);
+    std::vector<uint32_t> picks(NUM_OPERATIONS);
+    for (int i = 0; i < NUM_OPERATIONS; ++i)
+    {
+        sizes[i] = GRANULARITY * (1 + (random() % 2 != 0 ? random() % 4 : random() % 128));
+        picks[i] = uint32_t(random());
+    }
+
+    {
+        Core::TlsfAllocator                           allocator(HEAP_SIZE, GRANULARITY);
+        std::vector<Core::TlsfAllocator::BlockHandle> live;
+        int                                           numFailed = 0;
+        Tests::Timer                                  timer;
+        for (int i = 0; i < NUM_OPERATIONS; ++i)
+        {
+            if (live.size() < MIN_LIVE || picks[i] % 2 != 0)
+            {
+                auto allocation = allocator.Allocate(sizes[i], GRANULARITY);
+                if (allocation.Block == Core::TlsfAllocator::INVALID_BLOCK)
+                {
+                    ++numFailed;
+                    continue;
+                }
+                live.push_back(allocation.Block);
+            } else
+            {
+                size_t index = picks[i] % live.size();
+                allocator.Free(live[index]);
+                live[index] = live.back();
+                live.pop_back();
+            }
+        }
+        double nanoseconds = timer.GetMilliseconds() * 1e6 / NUM_OPERATIONS;
+        EE_CHECK(numFailed == 0 && allocator.GetNumAllocations() == live.size());
+        std::printf("TLSF      %6.1f ns per operation, %zu live, %6.0f MB used, fragmentation %.3f\n", nanoseconds,
+                    live.size(), allocator.GetUsedSize() / (1024.0 * 1024.0), allocator.GetFragmentation());
+    }
+
+    {
+        Core::OffsetAllocator allocator(uint32_t(HEAP_SIZE / GRANULARITY));
+        std::vector<uint32_t> live;
+        int                   numFailed = 0;
+        Tests::Timer          timer;
+        for (int i = 0; i < NUM_OPERATIONS; ++i)
+        {
+            if (live.size() < MIN_LIVE || picks[i] % 2 != 0)
+            {
+                uint32_t offset = allocator.Allocate(uint32_t(sizes[i] / GRANULARITY));
+                if (offset == Core::OffsetAllocator::INVALID_OFFSET)
+                {
+                    ++numFailed;
+                    continue;
+                }
+                live.push_back(offset);
+            } else
+            {
+                size_t index = picks[i] % live.size();
+                allocator.Free(live[index]);
+                live[index] = live.back();
+                live.pop_back();
+            }
+        }
+        double nanoseconds = timer.GetMilliseconds() * 1e6 / NUM_OPERATIONS;
+        EE_CHECK(numFailed == 0 && allocator.GetNumAllocations() == live.size());
+        std::printf("best fit  %6.1f ns per operation, %zu live, %6.0f MB used, fragmentation %.3f\n", nanoseconds,
+                    live.size(), allocator.GetUsedSize() * (GRANULARITY / (1024.0 * 1024.0)),
+                    allocator.GetFragmentation());
+    }
+    return Tests::Finish();
+}
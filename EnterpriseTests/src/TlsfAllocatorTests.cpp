@@ -0,0 +1,134 @@
+#include <iterator>
+#include <map>
+#include <random>
+
+#include "Test.h"
+#include "Enterprise/Core/TlsfAllocator.h"
+
+using namespace Enterprise;
+using Core::TlsfAllocator;
+
+namespace {
+
+struct LiveAllocation {
+    uint64_t                   Size;
+    TlsfAllocator::BlockHandle Block;
+};
+
+// Random allocations and frees in heaps of random granularity, against a map of the live ranges.
+void TestRandomOperations()
+{
+    std::mt19937_64 random(7);
+    bool            valid = true;
+    bool            statisticsMatch = true;
+    bool            coalesced = true;
+    for (int run = 0; run < 200; ++run)
+    {
+        uint64_t      granularity = uint64_t(1) << (random() % 17);
+        uint64_t      heapSize = granularity * (1 + random() % 5000);
+        TlsfAllocator allocator(heapSize, granularity);
+
+        std::map<uint64_t, LiveAllocation> live;
+        uint64_t                           used = 0;
+        for (int operation = 0; operation < 3000; ++operation)
+        {
+            if (live.empty() || random() % 3 != 0)
+            {
+                uint64_t size = 1 + random() % (heapSize / (1 + random() % 64));
+                uint64_t alignment = uint64_t(1) << (random() % 20);
+                auto     allocation = allocator.Allocate(size, alignment);
+                if (allocation.Block == TlsfAllocator::INVALID_BLOCK)
+                {
+                    continue;
+                }
+                valid &= allocation.Offset % alignment == 0 && allocation.Offset % granularity == 0;
+                valid &= allocation.Size >= size && allocation.Size < size + granularity &&
+                         allocation.Size % granularity == 0 && allocation.Offset + allocation.Size <= heapSize;
+
+                // Never overlapping the live neighbours.
+                auto next = live.lower_bound(allocation.Offset);
+                valid &= next == live.end() || allocation.Offset + allocation.Size <= next->first;
+                if (next != live.begin())
+                {
+                    auto previous = std::prev(next);
+                    valid &= previous->first + previous->second.Size <= allocation.Offset;
+                }
+                live[allocation.Offset] = {allocation.Size, allocation.Block};
+                used += allocation.Size;
+            } else
+            {
+                auto freed = std::next(live.begin(), long(random() % live.size()));
+                allocator.Free(freed->second.Block);
+                used -= freed->second.Size;
+                live.erase(freed);
+            }
+            statisticsMatch &= allocator.GetUsedSize() == used && allocator.GetNumAllocations() == live.size() &&
+                               allocator.GetLargestFreeBlock() <= allocator.GetFreeSize();
+        }
+
+        // Freeing everything merges the heap back into one block.
+        for (const auto &allocation: live)
+        {
+            allocator.Free(allocation.second.Block);
+        }
+        coalesced &= allocator.GetNumFreeBlocks() == 1 && allocator.GetLargestFreeBlock() == heapSize &&
+                     allocator.GetFragmentation() == 0.0f;
+        auto whole = allocator.Allocate(heapSize);
+        coalesced &= whole.Block != TlsfAllocator::INVALID_BLOCK && whole.Offset == 0;
+    }
+    EE_CHECK(valid);
+    EE_CHECK(statisticsMatch);
+    EE_CHECK(coalesced);
+}
+
+void TestExactFit()
+{
+    // A 64 MB heap holds exactly 1024 blocks of 64 KB.
+    TlsfAllocator allocator(64ull << 20, 65536);
+    int           count = 0;
+    while (allocator.Allocate(65536, 65536).Block != TlsfAllocator::INVALID_BLOCK)
+    {
+        ++count;
+    }
+    EE_CHECK(count == 1024);
+    EE_CHECK(allocator.GetFreeSize() == 0 && allocator.GetFragmentation() == 0.0f);
+
+    // A heap of nothing allocates nothing.
+    TlsfAllocator empty;
+    EE_CHECK(empty.Allocate(1).Block == TlsfAllocator::INVALID_BLOCK);
+}
+
+void TestFragmentation()
+{
+    // Freeing every other block leaves the free space in pieces, none larger than a block.
+    TlsfAllocator                           allocator(1 << 20, 1024);
+    std::vector<TlsfAllocator::BlockHandle> blocks;
+    for (int i = 0; i < 16; ++i)
+    {
+        blocks.push_back(allocator.Allocate(1 << 16).Block);
+    }
+    for (int i = 0; i < 16; i += 2)
+    {
+        allocator.Free(blocks[i]);
+    }
+    EE_CHECK(allocator.GetLargestFreeBlock() == 1 << 16 && allocator.GetNumFreeBlocks() == 8);
+    EE_CHECK(allocator.GetFragmentation() > 0.8f);
+    EE_CHECK(allocator.Allocate(1 << 17).Block == TlsfAllocator::INVALID_BLOCK);
+
+    // Freeing the blocks between them merges everything again.
+    for (int i = 1; i < 16; i += 2)
+    {
+        allocator.Free(blocks[i]);
+    }
+    EE_CHECK(allocator.GetNumFreeBlocks() == 1 && allocator.GetLargestFreeBlock() == 1 << 20);
+}
+
+}
+
+int main()
+{
+    TestRandomOperations();
+    TestExactFit();
+    TestFragmentation();
+    return Tests::Finish();
+}
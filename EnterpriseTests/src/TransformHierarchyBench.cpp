@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Scene/TransformHierarchy.h"
+
+using namespace Enterprise;
+using Scene::TransformHierarchy;
+
+namespace {
+
+constexpr uint32_t NUM_NODES = 100000;
+constexpr uint32_t NUM_ROOTS = 16;
+constexpr int      NUM_RUNS = 10;
+
+}
+
+int main()
+{
+    // A tree with four children per node, eight levels deep.
+    TransformHierarchy                      serial;
+    TransformHierarchy                      parallel;
+    std::vector<TransformHierarchy::Handle> nodes;
+    for (uint32_t i = 0; i < NUM_NODES; ++i)
+    {
+        Scene::Transform local;
+        local.Position[0] = float(i % 7);
+        local.Rotation[2] = 0.1f;
+        local.Rotation[3] = 0.995f;
+        local.Scale[1] = 1.01f;
+        auto parent = i < NUM_ROOTS ? TransformHierarchy::INVALID_HANDLE : nodes[i / 4];
+        nodes.push_back(serial.AddNode(parent, local));
+        parallel.AddNode(parent, local);
+    }
+    serial.UpdateWorldMatrices(false);
+    parallel.UpdateWorldMatrices(true);
+    EE_CHECK(std::memcmp(serial.GetWorldMatrices(), parallel.GetWorldMatrices(),
+                         NUM_NODES * sizeof(Scene::Matrix4x4)) == 0);
+
+    Scene::Transform moved;
+    moved.Position[1] = 1.0f;
+    auto run = [&]( const char* name, bool useThreads, auto markDirty )
+    {
+        double   best = 1e30;
+        uint32_t numUpdated = 0;
+        for (int run = 0; run < NUM_RUNS; ++run)
+        {
+            markDirty();
+            Tests::Timer timer;
+            numUpdated = serial.UpdateWorldMatrices(useThreads);
+            best = std::min(best, timer.GetMilliseconds());
+        }
+        std::printf("%-18s %-8s %8u updated %8.3f ms\n", name, useThreads ? "parallel" : "serial", numUpdated, best);
+    };
+
+    std::printf("%u nodes, %u levels\n", NUM_NODES, serial.GetNumLevels());
+    for (bool useThreads: {false, true})
+    {
+        run("all dirty", useThreads, [&]
+        {
+            for (uint32_t i = 0; i < NUM_ROOTS; ++i)
+            {
+                serial.SetLocalTransform(nodes[i], moved);
+            }
+        });
+        run("1% leaves dirty", useThreads, [&]
+        {
+            for (uint32_t i = 0; i < NUM_NODES / 100; ++i)
+            {
+                serial.SetLocalTransform(nodes[NUM_NODES - 1 - i * 97 % (NUM_NODES / 2)], moved);
+            }
+        });
+        run("none dirty", useThreads, [] {});
+    }
+    return Tests::Finish();
+}
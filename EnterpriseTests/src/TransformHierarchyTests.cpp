@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Scene/Scene.h"
+
+using namespace Enterprise;
+using Scene::TransformHierarchy;
+using Handle = TransformHierarchy::Handle;
+
+namespace {
+
+// Reference world matrices in double precision, from a plain parent map.
+struct ReferenceMatrix {
+    double m[4][4] = {};
+};
+
+ReferenceMatrix ComputeLocalMatrix( const Scene::Transform &transform )
+{
+    double x = transform.Rotation[0];
+    double y = transform.Rotation[1];
+    double z = transform.Rotation[2];
+    double w = transform.Rotation[3];
+
+    // Rotate the scaled basis vectors, v + w t + q x t with t = 2 q x v.
+    ReferenceMatrix local;
+    for (int row = 0; row < 3; ++row)
+    {
+        double v[3] = {0.0, 0.0, 0.0};
+        v[row] = transform.Scale[row];
+        double t[3] = {2.0 * (y * v[2] - z * v[1]), 2.0 * (z * v[0] - x * v[2]), 2.0 * (x * v[1] - y * v[0])};
+        local.m[row][0] = v[0] + w * t[0] + (y * t[2] - z * t[1]);
+        local.m[row][1] = v[1] + w * t[1] + (z * t[0] - x * t[2]);
+        local.m[row][2] = v[2] + w * t[2] + (x * t[1] - y * t[0]);
+    }
+    for (int column = 0; column < 3; ++column)
+    {
+        local.m[3][column] = transform.Position[column];
+    }
+    local.m[3][3] = 1.0;
+    return local;
+}
+
+ReferenceMatrix Multiply( const ReferenceMatrix &a, const ReferenceMatrix &b )
+{
+    ReferenceMatrix result;
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                result.m[i][j] += a.m[i][k] * b.m[k][j];
+            }
+        }
+    }
+    return result;
+}
+
+struct ReferenceNode {
+    Handle           Parent;
+    Scene::Transform Local;
+};
+
+using ReferenceScene = std::map<Handle, ReferenceNode>;
+
+ReferenceMatrix ComputeWorldMatrix( const ReferenceScene &scene, Handle handle )
+{
+    const auto &node = scene.at(handle);
+    auto        local = ComputeLocalMatrix(node.Local);
+    return node.Parent == TransformHierarchy::INVALID_HANDLE
+               ? local
+               : Multiply(local, ComputeWorldMatrix(scene, node.Parent));
+}
+
+Scene::Transform MakeTransform( std::mt19937 &random )
+{
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+    Scene::Transform transform;
+    float            length = 0.0f;
+    for (int i = 0; i < 3; ++i)
+    {
+        transform.Position[i] = value(random) * 3.0f;
+        transform.Scale[i] = 0.5f + std::fabs(value(random));
+    }
+    for (float &component: transform.Rotation)
+    {
+        component = value(random);
+        length += component * component;
+    }
+    for (float &component: transform.Rotation)
+    {
+        component /= std::sqrt(length);
+    }
+    return transform;
+}
+
+bool MatchesReference( const TransformHierarchy &hierarchy, const ReferenceScene &scene )
+{
+    if (hierarchy.GetNumNodes() != scene.size())
+    {
+        return false;
+    }
+    for (const auto &[handle, node]: scene)
+    {
+        if (!hierarchy.IsValid(handle) || hierarchy.GetParent(handle) != node.Parent)
+        {
+            return false;
+        }
+        auto        expected = ComputeWorldMatrix(scene, handle);
+        const auto &world = hierarchy.GetWorldMatrix(handle);
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                if (std::fabs(expected.m[i][j] - world.m[i][j]) > 1e-4 * (1.0 + std::fabs(expected.m[i][j])))
+                {
+                    return false;
+                }
+            }
+        }
+        auto local = hierarchy.GetLocalTransform(handle);
+        if (std::memcmp(&local, &node.Local, sizeof(local)) != 0)
+        {
+            return false;
+        }
+    }
+
+    // Parents come before their children.
+    std::vector<uint32_t> indices(scene.rbegin()->first + 1);
+    for (uint32_t i = 0; i < hierarchy.GetNumNodes(); ++i)
+    {
+        indices[hierarchy.GetNodeHandle(i)] = i;
+    }
+    for (const auto &[handle, node]: scene)
+    {
+        if (node.Parent != TransformHierarchy::INVALID_HANDLE && indices[node.Parent] >= indices[handle])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rounds of adding nodes under random parents, changing transforms and removing subtrees, checked against the
+// reference after every update, serial and parallel in turn.
+void TestRandomEdits()
+{
+    std::mt19937        random(1);
+    TransformHierarchy  hierarchy;
+    ReferenceScene      scene;
+    std::vector<Handle> live;
+    for (int round = 0; round < 20; ++round)
+    {
+        for (int i = 0; i < (round == 0 ? 3000 : 200); ++i)
+        {
+            Handle parent = !live.empty() && random() % 5 != 0 ? live[random() % live.size()]
+                                                               : TransformHierarchy::INVALID_HANDLE;
+            auto   local = MakeTransform(random);
+            Handle handle = hierarchy.AddNode(parent, local);
+            scene[handle] = {parent, local};
+            live.push_back(handle);
+        }
+        for (int i = 0; i < 50; ++i)
+        {
+            Handle handle = live[random() % live.size()];
+            scene[handle].Local = MakeTransform(random);
+            hierarchy.SetLocalTransform(handle, scene[handle].Local);
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            Handle removed = live[random() % live.size()];
+            hierarchy.RemoveNode(removed);
+
+            // The node and everything below it.
+            std::vector<Handle> subtree = {removed};
+            for (bool found = true; found;)
+            {
+                found = false;
+                for (const auto &[handle, node]: scene)
+                {
+                    if (std::find(subtree.begin(), subtree.end(), node.Parent) != subtree.end() &&
+                        std::find(subtree.begin(), subtree.end(), handle) == subtree.end())
+                    {
+                        subtree.push_back(handle);
+                        found = true;
+                    }
+                }
+            }
+            for (Handle handle: subtree)
+            {
+                scene.erase(handle);
+                live.erase(std::find(live.begin(), live.end(), handle));
+            }
+        }
+
+        hierarchy.UpdateWorldMatrices(round % 2 != 0);
+        EE_CHECK(MatchesReference(hierarchy, scene));
+    }
+    EE_CHECK(hierarchy.UpdateWorldMatrices() == 0);
+}
+
+void TestDirtyTracking()
+{
+    std::mt19937       random(2);
+    TransformHierarchy hierarchy;
+    Handle             root = hierarchy.AddNode();
+    Handle             child = hierarchy.AddNode(root);
+    Handle             grandchild = hierarchy.AddNode(child);
+    hierarchy.AddNode(root);
+    hierarchy.AddNode(grandchild);
+    EE_CHECK(hierarchy.UpdateWorldMatrices() == 5 && hierarchy.GetNumLevels() == 4);
+
+    // The node and its two descendants.
+    hierarchy.SetLocalTransform(child, MakeTransform(random));
+    EE_CHECK(hierarchy.UpdateWorldMatrices() == 3);
+
+    hierarchy.RemoveNode(child);
+    hierarchy.UpdateWorldMatrices();
+    EE_CHECK(hierarchy.GetNumNodes() == 2 && hierarchy.IsValid(root));
+    EE_CHECK(!hierarchy.IsValid(child) && !hierarchy.IsValid(grandchild));
+
+    Scene::Scene scene;
+    Handle       node = scene.GetTransforms().AddNode(TransformHierarchy::INVALID_HANDLE, MakeTransform(random));
+    scene.Update();
+    EE_CHECK(scene.GetTransforms().GetWorldMatrix(node).m[3][3] == 1.0f);
+}
+
+}
+
+int main()
+{
+    TestRandomEdits();
+    TestDirtyTracking();
+    return Tests::Finish();
+}
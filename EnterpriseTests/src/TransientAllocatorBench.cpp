@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/RenderGraph/TransientAllocator.h"
+
+using namespace Enterprise;
+
+namespace {
+
+constexpr uint64_t ALIGNMENT = 64 * 1024;
+constexpr double   MEGABYTE = 1024.0 * 1024.0;
+
+}
+
+int main()
+{
+    // Frames of numResources targets from 64 KB to 8 MB, each alive for up to eight passes.
+    std::printf("%9s %10s %10s %12s %10s\n", "resources", "time", "heap", "committed", "peak");
+    for (uint32_t numResources: {32u, 128u, 512u, 2048u})
+    {
+        std::mt19937          random(numResources);
+        uint32_t              numPasses = numResources / 2 + 1;
+        std::vector<uint64_t> sizes(numResources);
+        std::vector<uint32_t> firstPasses(numResources);
+        std::vector<uint32_t> lastPasses(numResources);
+        uint64_t              committed = 0;
+        for (uint32_t i = 0; i < numResources; ++i)
+        {
+            sizes[i] = (1 + random() % 128) * ALIGNMENT;
+            firstPasses[i] = random() % numPasses;
+            lastPasses[i] = std::min(numPasses - 1, firstPasses[i] + uint32_t(random() % 8));
+            committed += sizes[i];
+        }
+
+        // Fewer runs of the large frames, whose packing grows with the square of their resources.
+        RenderGraph::TransientAllocator allocator;
+        int                             numRuns = numResources <= 128 ? 2000 : numResources <= 512 ? 50 : 5;
+        uint64_t                        heapSize = 0;
+        Tests::Timer                    timer;
+        for (int run = 0; run < numRuns; ++run)
+        {
+            allocator.Clear();
+            for (uint32_t i = 0; i < numResources; ++i)
+            {
+                allocator.Add(sizes[i], ALIGNMENT, firstPasses[i], lastPasses[i]);
+            }
+            heapSize = allocator.Allocate();
+        }
+        double time = timer.GetMilliseconds() / numRuns;
+
+        uint64_t peak = 0;
+        for (uint32_t pass = 0; pass < numPasses; ++pass)
+        {
+            uint64_t alive = 0;
+            for (uint32_t i = 0; i < numResources; ++i)
+            {
+                alive += firstPasses[i] <= pass && pass <= lastPasses[i] ? sizes[i] : 0;
+            }
+            peak = std::max(peak, alive);
+        }
+        EE_CHECK(heapSize >= peak && heapSize <= committed);
+        std::printf("%9u %7.3f ms %7.1f MB %9.1f MB %7.1f MB\n", numResources, time, heapSize / MEGABYTE,
+                    committed / MEGABYTE, peak / MEGABYTE);
+    }
+    return Tests::Finish();
+}
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/RenderGraph/TransientAllocator.h"
+
+using namespace Enterprise;
+using RenderGraph::TransientAllocator;
+
+namespace {
+
+struct TestResource {
+    uint64_t Size;
+    uint64_t Alignment;
+    uint32_t FirstPass;
+    uint32_t LastPass;
+};
+
+bool Overlaps( uint64_t beginA, uint64_t endA, uint64_t beginB, uint64_t endB )
+{
+    return beginA < endB && beginB < endA;
+}
+
+void TestExamples()
+{
+    // Two targets alive one after the other share memory, the second aliasing the first.
+    TransientAllocator allocator;
+    EE_CHECK(allocator.Add(1 << 20, 1 << 16, 0, 1) == 0);
+    EE_CHECK(allocator.Add(1 << 20, 1 << 16, 2, 3) == 1);
+    EE_CHECK(allocator.Allocate() == 1 << 20);
+    const auto &placements = allocator.GetPlacements();
+    EE_CHECK(placements[0].Offset == 0 && placements[1].Offset == 0);
+    EE_CHECK(placements[0].Aliased == TransientAllocator::NO_ALIAS && placements[1].Aliased == 0);
+
+    // A third alive with both needs memory of its own.
+    EE_CHECK(allocator.Add(1 << 16, 1 << 16, 1, 2) == 2);
+    EE_CHECK(allocator.Allocate() == (1 << 20) + (1 << 16));
+    EE_CHECK(allocator.GetPlacements()[2].Offset == 1 << 20);
+
+    allocator.Clear();
+    EE_CHECK(allocator.GetNumResources() == 0 && allocator.Allocate() == 0);
+}
+
+// Random frames: every placement is aligned and inside the heap, resources alive at the same time never overlap,
+// and each names the last resource to die in the memory it reuses.
+void TestRandomFrames()
+{
+    std::mt19937 random(3);
+    bool         aligned = true;
+    bool         separate = true;
+    bool         aliasesMatch = true;
+    bool         heapsFit = true;
+    for (int run = 0; run < 2000; ++run)
+    {
+        TransientAllocator        allocator;
+        std::vector<TestResource> resources(random() % 40);
+        uint32_t                  numPasses = 1 + random() % 20;
+        for (size_t i = 0; i < resources.size(); ++i)
+        {
+            auto &resource = resources[i];
+            resource.Size = (1 + random() % 64) * 65536ull + (random() % 2 != 0 ? 0 : random() % 4096);
+            resource.Alignment = random() % 4 != 0 ? 65536 : 4194304;
+            resource.FirstPass = random() % numPasses;
+            resource.LastPass = resource.FirstPass + random() % (numPasses - resource.FirstPass);
+            EE_CHECK(allocator.Add(resource.Size, resource.Alignment, resource.FirstPass, resource.LastPass) == i);
+        }
+
+        uint64_t    heapSize = allocator.Allocate();
+        const auto &placements = allocator.GetPlacements();
+        uint64_t    total = 0;
+        for (size_t i = 0; i < resources.size(); ++i)
+        {
+            const auto &resource = resources[i];
+            uint64_t    offset = placements[i].Offset;
+            total += resource.Size;
+            aligned &= offset % resource.Alignment == 0 && offset + resource.Size <= heapSize;
+
+            uint32_t expectedAlias = TransientAllocator::NO_ALIAS;
+            for (size_t j = 0; j < resources.size(); ++j)
+            {
+                const auto &other = resources[j];
+                bool        memoryOverlaps = Overlaps(offset, offset + resource.Size, placements[j].Offset,
+                                                      placements[j].Offset + other.Size);
+                if (i != j && resource.FirstPass <= other.LastPass && other.FirstPass <= resource.LastPass)
+                {
+                    separate &= !memoryOverlaps;
+                }
+                if (memoryOverlaps && other.LastPass < resource.FirstPass &&
+                    (expectedAlias == TransientAllocator::NO_ALIAS ||
+                     other.LastPass > resources[expectedAlias].LastPass))
+                {
+                    expectedAlias = uint32_t(j);
+                }
+            }
+            // Resources that die in the same pass are equally good to wait for.
+            uint32_t alias = placements[i].Aliased;
+            aliasesMatch &= expectedAlias == TransientAllocator::NO_ALIAS
+                                ? alias == TransientAllocator::NO_ALIAS
+                                : alias != TransientAllocator::NO_ALIAS &&
+                                  resources[alias].LastPass == resources[expectedAlias].LastPass;
+        }
+
+        // Never more than the resources apart with their alignment, never less than what is alive at once.
+        uint64_t peak = 0;
+        for (uint32_t pass = 0; pass < numPasses; ++pass)
+        {
+            uint64_t alive = 0;
+            for (const auto &resource: resources)
+            {
+                alive += resource.FirstPass <= pass && pass <= resource.LastPass ? resource.Size : 0;
+            }
+            peak = std::max(peak, alive);
+        }
+        heapsFit &= heapSize >= peak && heapSize <= total + resources.size() * 4194304;
+    }
+    EE_CHECK(aligned);
+    EE_CHECK(separate);
+    EE_CHECK(aliasesMatch);
+    EE_CHECK(heapsFit);
+}
+
+}
+
+int main()
+{
+    TestExamples();
+    TestRandomFrames();
+    return Tests::Finish();
+}
@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Assets/ModelData.h"
+#include "Enterprise/Geometry/VertexQuantization.h"
+
+using namespace Enterprise;
+using Geometry::VertexFormat;
+
+namespace {
+
+constexpr size_t NUM_VERTICES = 1 << 20;
+constexpr int    NUM_RUNS = 5;
+
+}
+
+int main()
+{
+    std::mt19937                          random(3);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Assets::MeshVertex>       vertices(NUM_VERTICES);
+    for (auto &vertex: vertices)
+    {
+        vertex = {{unit(random) * 50.0f, unit(random) * 5.0f, unit(random)}, {0.0f, 0.6f, 0.8f},
+                  {unit(random), unit(random)}};
+    }
+
+    Geometry::VertexStreamDesc source = {vertices[0].Position, vertices[0].Normal, vertices[0].TexCoord,
+                                         sizeof(Assets::MeshVertex), vertices.size()};
+    auto params = Geometry::ComputeQuantizationParams(source.Positions, source.Stride, source.NumVertices);
+
+    for (auto format: {VertexFormat::PackedNormalTexCoord, VertexFormat::Quantized})
+    {
+        size_t               stride = Geometry::GetVertexFormatStride(format);
+        std::vector<uint8_t> encoded(stride * vertices.size());
+
+        Tests::Timer timer;
+        for (int run = 0; run < NUM_RUNS; ++run)
+        {
+            Geometry::EncodeVertices(format, encoded.data(), source, params);
+        }
+        double milliseconds = timer.GetMilliseconds() / NUM_RUNS;
+
+        auto error = Geometry::MeasureQuantizationError(format, encoded.data(), source, params);
+        EE_CHECK(error.MaxNormalError < 0.01f);
+        std::printf("%2zu byte vertices: %7.1f Mvertices/s, %zu -> %zu bytes\n", stride,
+                    NUM_VERTICES / milliseconds / 1000.0, NUM_VERTICES * sizeof(Assets::MeshVertex),
+                    NUM_VERTICES * stride);
+    }
+    return Tests::Finish();
+}
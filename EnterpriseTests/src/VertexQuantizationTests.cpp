@@ -0,0 +1,92 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Assets/ModelData.h"
+#include "Enterprise/Geometry/VertexQuantization.h"
+
+using namespace Enterprise;
+using Geometry::VertexFormat;
+
+namespace {
+
+// Random vertices in a 100 x 10 x 1 box, plus the normals octahedral encoding handles specially. The count is not
+// a multiple of four, so the scalar tail of the kernels runs too.
+std::vector<Assets::MeshVertex> MakeVertices( size_t count )
+{
+    std::mt19937                          random(3);
+    std::normal_distribution<float>       direction;
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<Assets::MeshVertex> vertices(count);
+    for (auto &vertex: vertices)
+    {
+        float x = direction(random), y = direction(random), z = direction(random);
+        float length = std::sqrt(x * x + y * y + z * z);
+        vertex = {{unit(random) * 100.0f - 50.0f, unit(random) * 10.0f, unit(random)},
+                  {x / length, y / length, z / length},
+                  {unit(random), unit(random)}};
+    }
+    vertices[0].Normal[0] = 0.0f;
+    vertices[0].Normal[1] = 0.0f;
+    vertices[0].Normal[2] = -1.0f;
+    vertices[1].Normal[0] = 1.0f;
+    vertices[1].Normal[1] = 0.0f;
+    vertices[1].Normal[2] = 0.0f;
+    return vertices;
+}
+
+void TestEncodingError()
+{
+    auto                       vertices = MakeVertices(10007);
+    Geometry::VertexStreamDesc source = {vertices[0].Position, vertices[0].Normal, vertices[0].TexCoord,
+                                         sizeof(Assets::MeshVertex), vertices.size()};
+    auto params = Geometry::ComputeQuantizationParams(source.Positions, source.Stride, source.NumVertices);
+
+    for (auto format: {VertexFormat::PackedNormalTexCoord, VertexFormat::Quantized})
+    {
+        std::vector<uint8_t> encoded(Geometry::GetVertexFormatStride(format) * vertices.size());
+        Geometry::EncodeVertices(format, encoded.data(), source, params);
+        auto error = Geometry::MeasureQuantizationError(format, encoded.data(), source, params);
+
+        // Half a 16 bit step along each axis of the box, a hundredth of a degree, and half a step of a half just
+        // below 1.
+        float maxPositionError = format == VertexFormat::Quantized
+                                     ? std::sqrt(100.0f * 100.0f + 10.0f * 10.0f + 1.0f) / 65535.0f * 0.5f * 1.01f
+                                     : 0.0f;
+        EE_CHECK(error.MaxPositionError <= maxPositionError);
+        EE_CHECK(error.MaxNormalError < 0.01f);
+        EE_CHECK(error.MaxTexCoordError <= 1.0f / 4096.0f);
+    }
+    EE_CHECK(Geometry::GetVertexFormatStride(VertexFormat::Float) == sizeof(Assets::MeshVertex));
+}
+
+void TestHalf()
+{
+    const float values[] = {0.0f, 1.0f, -2.5f, 65504.0f, 0.5f / 1024.0f, 0.25f};
+    for (float value: values)
+    {
+        float    pair[2] = {value, -value};
+        uint16_t encoded[2];
+        Geometry::EncodeHalf2(encoded, sizeof(encoded), pair, sizeof(pair), 1);
+        EE_CHECK(Geometry::HalfToFloat(encoded[0]) == value);
+        EE_CHECK(Geometry::HalfToFloat(encoded[1]) == -value);
+    }
+
+    // Out of range values round to infinity and NaN stays NaN, as in IEEE conversions.
+    float    special[2] = {1e6f, NAN};
+    uint16_t encoded[2];
+    Geometry::EncodeHalf2(encoded, sizeof(encoded), special, sizeof(special), 1);
+    EE_CHECK(std::isinf(Geometry::HalfToFloat(encoded[0])));
+    EE_CHECK(std::isnan(Geometry::HalfToFloat(encoded[1])));
+}
+
+}
+
+int main()
+{
+    TestEncodingError();
+    TestHalf();
+    return Tests::Finish();
+}
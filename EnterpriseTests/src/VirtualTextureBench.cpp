@@ -0,0 +1,76 @@
+#include <cstdio>
+#include <vector>
+
+#include "Test.h"
+#include "Enterprise/Textures/VirtualTexture.h"
+
+using namespace Enterprise;
+
+namespace {
+
+constexpr uint32_t TEXTURE_SIZE = 65536;
+constexpr uint32_t NUM_SLOTS = 4096;
+constexpr uint32_t MAX_LOADS = 64;
+constexpr int      NUM_FRAMES = 300;
+// Feedback is written at a 240x135 fraction of a 1080p frame.
+constexpr uint32_t FEEDBACK_WIDTH = 240;
+constexpr uint32_t FEEDBACK_HEIGHT = 135;
+
+class NullStreamer : public Textures::TileStreamer {
+public:
+    void LoadTiles( Textures::TileLoad* loads, size_t count ) override
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            loads[i].Loaded = true;
+        }
+    }
+};
+
+}
+
+int main()
+{
+    Textures::VirtualTextureLayout layout;
+    if (!EE_CHECK(Textures::MakeVirtualTextureLayout(TEXTURE_SIZE, TEXTURE_SIZE, 128, 4, &layout)))
+    {
+        return Tests::Finish();
+    }
+    Textures::VirtualTexturePageTable pageTable(layout, NUM_SLOTS);
+    NullStreamer                      streamer;
+    EE_CHECK(pageTable.Initialize(streamer));
+
+    // A camera panning across the texture, the bands of the screen sampling coarser mips further away.
+    std::vector<uint32_t> feedback(FEEDBACK_WIDTH * FEEDBACK_HEIGHT);
+    double                feedbackTime = 0.0;
+    double                updateTime = 0.0;
+    uint64_t              numLoaded = 0;
+    for (int frame = 0; frame < NUM_FRAMES; ++frame)
+    {
+        uint32_t centerX = (frame * 3) % 400;
+        uint32_t centerY = 100;
+        for (uint32_t i = 0; i < feedback.size(); ++i)
+        {
+            uint32_t x = i % FEEDBACK_WIDTH;
+            uint32_t y = i / FEEDBACK_WIDTH;
+            uint32_t mip = y / 30;
+            feedback[i] = Textures::PackTileId({(centerX + x / 8) >> mip, (centerY + y / 8) >> mip, mip});
+        }
+
+        Tests::Timer timer;
+        pageTable.AddFeedback(feedback.data(), feedback.size());
+        feedbackTime += timer.GetMilliseconds();
+        timer.Reset();
+        numLoaded += pageTable.Update(streamer, MAX_LOADS);
+        updateTime += timer.GetMilliseconds();
+    }
+
+    const auto &statistics = pageTable.GetStatistics();
+    EE_CHECK(statistics.NumResident <= NUM_SLOTS && numLoaded > 0);
+    std::printf("%ux%u texture, %u tiles, %u slots, %zu feedback texels\n", TEXTURE_SIZE, TEXTURE_SIZE,
+                layout.GetNumTiles(), NUM_SLOTS, feedback.size());
+    std::printf("feedback: %8.3f ms/frame\n", feedbackTime / NUM_FRAMES);
+    std::printf("update:   %8.3f ms/frame, %.1f loads/frame, %u resident\n", updateTime / NUM_FRAMES,
+                double(numLoaded) / NUM_FRAMES, statistics.NumResident);
+    return Tests::Finish();
+}
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "TestImages.h"
+#include "Enterprise/Assets/TextureCooker.h"
+#include "Enterprise/Assets/TiledTexture.h"
+#include "Enterprise/Textures/VirtualTexture.h"
+
+using namespace Enterprise;
+using Textures::TileId;
+
+namespace {
+
+// Remembers which tile went into which slot, and fails a share of the loads.
+class MockStreamer : public Textures::TileStreamer {
+public:
+    explicit MockStreamer( float failRate = 0.0f ) : m_FailRate(failRate) {}
+
+    void LoadTiles( Textures::TileLoad* loads, size_t count ) override
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            loads[i].Loaded = std::uniform_real_distribution<float>(0.0f, 1.0f)(m_Random) >= m_FailRate;
+            if (loads[i].Loaded)
+            {
+                m_SlotTiles.resize(std::max<size_t>(m_SlotTiles.size(), loads[i].Slot + 1),
+                                   Textures::INVALID_PACKED_TILE);
+                m_SlotTiles[loads[i].Slot] = Textures::PackTileId(loads[i].Tile);
+            }
+        }
+    }
+
+    [[nodiscard]] uint32_t GetSlotTile( uint32_t slot ) const
+    {
+        return slot < m_SlotTiles.size() ? m_SlotTiles[slot] : Textures::INVALID_PACKED_TILE;
+    }
+
+private:
+    std::mt19937          m_Random{1};
+    float                 m_FailRate;
+    std::vector<uint32_t> m_SlotTiles;
+};
+
+// Every page maps to the slot holding the finest resident tile covering it.
+bool IsPageTableValid( const Textures::VirtualTexturePageTable &pageTable, const MockStreamer &streamer )
+{
+    const auto &layout = pageTable.GetLayout();
+    for (uint32_t mip = 0; mip < layout.NumMips; ++mip)
+    {
+        for (uint32_t y = 0; y < layout.GetNumTilesY(mip); ++y)
+        {
+            for (uint32_t x = 0; x < layout.GetNumTilesX(mip); ++x)
+            {
+                TileId tile = {x, y, mip};
+                while (!pageTable.IsResident(tile))
+                {
+                    tile = {tile.X >> 1, tile.Y >> 1, tile.Mip + 1};
+                }
+                uint32_t entry = pageTable.GetPageTable(mip)[y * layout.GetNumTilesX(mip) + x];
+                if (Textures::GetPageTableEntryMip(entry) != tile.Mip ||
+                    streamer.GetSlotTile(Textures::GetPageTableEntrySlot(entry)) != Textures::PackTileId(tile))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+Textures::VirtualTextureLayout MakeLayout()
+{
+    Textures::VirtualTextureLayout layout;
+    EE_CHECK(Textures::MakeVirtualTextureLayout(5000, 3000, 128, 4, &layout));
+    return layout;
+}
+
+void TestLayout()
+{
+    auto layout = MakeLayout();
+    EE_CHECK(layout.NumMips == 7);
+    EE_CHECK(layout.GetNumTilesX(0) == 40 && layout.GetNumTilesY(0) == 24);
+    EE_CHECK(layout.GetNumTilesX(layout.NumMips - 1) == 1 && layout.GetNumTilesY(layout.NumMips - 1) == 1);
+
+    TileId tile = {1234, 567, 9};
+    auto   unpacked = Textures::UnpackTileId(Textures::PackTileId(tile));
+    EE_CHECK(unpacked.X == tile.X && unpacked.Y == tile.Y && unpacked.Mip == tile.Mip);
+
+    Textures::VirtualTextureLayout tooLarge;
+    EE_CHECK(!Textures::MakeVirtualTextureLayout(1u << 22, 128, 128, 4, &tooLarge));
+}
+
+void TestEviction()
+{
+    auto                              layout = MakeLayout();
+    Textures::VirtualTexturePageTable pageTable(layout, 4);
+    MockStreamer                      streamer;
+    EE_CHECK(pageTable.Initialize(streamer) && IsPageTableValid(pageTable, streamer));
+
+    // The tile and its five missing ancestors do not fit in the three free slots, the coarsest go first.
+    uint32_t first = Textures::PackTileId({0, 0, 0});
+    pageTable.AddFeedback(&first, 1);
+    pageTable.Update(streamer, 100);
+    EE_CHECK(pageTable.GetStatistics().NumLoaded == 3 && pageTable.GetStatistics().NumDeferred > 0);
+    EE_CHECK(pageTable.IsResident({0, 0, layout.NumMips - 2}) && !pageTable.IsResident({0, 0, 0}));
+    EE_CHECK(IsPageTableValid(pageTable, streamer));
+
+    // Another tile evicts those, but never the pinned last mip.
+    uint32_t second = Textures::PackTileId({10, 10, 0});
+    pageTable.AddFeedback(&second, 1);
+    pageTable.Update(streamer, 100);
+    EE_CHECK(pageTable.GetStatistics().NumEvicted > 0);
+    EE_CHECK(pageTable.IsResident({0, 0, layout.NumMips - 1}));
+    EE_CHECK(IsPageTableValid(pageTable, streamer));
+}
+
+void TestFeedback()
+{
+    auto                              layout = MakeLayout();
+    Textures::VirtualTexturePageTable pageTable(layout, 64);
+    MockStreamer                      streamer;
+    pageTable.Initialize(streamer);
+    pageTable.ClearDirty();
+
+    std::vector<uint32_t> feedback(10, Textures::PackTileId({3, 3, 0}));
+    feedback.push_back(Textures::PackTileId({30, 20, 0}));
+    feedback.push_back(Textures::INVALID_PACKED_TILE);
+    feedback.push_back(Textures::PackTileId({1000, 0, 0}));
+    pageTable.AddFeedback(feedback.data(), feedback.size());
+    pageTable.Update(streamer, 1000);
+    EE_CHECK(pageTable.GetStatistics().NumRequested == 2);
+    EE_CHECK(pageTable.IsResident({3, 3, 0}) && pageTable.IsResident({30, 20, 0}));
+    EE_CHECK(pageTable.IsDirty(0) && IsPageTableValid(pageTable, streamer));
+
+    // With room for one more load, the most requested tile goes first.
+    Textures::VirtualTexturePageTable limited(layout, 64);
+    limited.Initialize(streamer);
+    feedback = std::vector<uint32_t>(10, Textures::PackTileId({0, 0, layout.NumMips - 2}));
+    feedback.push_back(Textures::PackTileId({1, 0, layout.NumMips - 2}));
+    limited.AddFeedback(feedback.data(), feedback.size());
+    limited.Update(streamer, 1);
+    EE_CHECK(limited.IsResident({0, 0, layout.NumMips - 2}) && !limited.IsResident({1, 0, layout.NumMips - 2}));
+    EE_CHECK(limited.GetStatistics().NumDeferred == 1);
+}
+
+// A camera wandering over the texture, with one load in ten failing.
+void TestRandomFeedback()
+{
+    constexpr uint32_t NUM_SLOTS = 40;
+
+    auto                              layout = MakeLayout();
+    Textures::VirtualTexturePageTable pageTable(layout, NUM_SLOTS);
+    MockStreamer                      streamer(0.1f);
+    pageTable.Initialize(streamer);
+
+    std::mt19937 random(7);
+    bool         valid = true;
+    for (int frame = 0; frame < 500; ++frame)
+    {
+        std::vector<uint32_t> feedback;
+        uint32_t              centerX = random() % layout.GetNumTilesX(0);
+        uint32_t              centerY = random() % layout.GetNumTilesY(0);
+        for (int i = 0; i < 200; ++i)
+        {
+            uint32_t mip = random() % layout.NumMips;
+            uint32_t x = std::min<uint32_t>((centerX + random() % 5) >> mip, layout.GetNumTilesX(mip) - 1);
+            uint32_t y = std::min<uint32_t>((centerY + random() % 5) >> mip, layout.GetNumTilesY(mip) - 1);
+            feedback.push_back(Textures::PackTileId({x, y, mip}));
+        }
+        pageTable.AddFeedback(feedback.data(), feedback.size());
+        pageTable.Update(streamer, 8);
+        valid &= pageTable.GetStatistics().NumResident <= NUM_SLOTS;
+        valid &= frame % 50 != 0 || IsPageTableValid(pageTable, streamer);
+    }
+    EE_CHECK(valid && IsPageTableValid(pageTable, streamer));
+}
+
+void TestTiledTexture( const std::filesystem::path &directory )
+{
+    constexpr uint32_t WIDTH = 1000;
+    constexpr uint32_t HEIGHT = 600;
+    constexpr uint32_t BORDER = 4;
+
+    auto                  texels = Tests::MakeImage(WIDTH, HEIGHT);
+    Assets::DecodedImage  image;
+    if (!EE_CHECK(Assets::DecodeImage({texels.data(), texels.size(), WIDTH, HEIGHT}, &image)))
+    {
+        return;
+    }
+    auto source = [&]( uint32_t x, uint32_t y ) { return image.Pixels.GetData() + (size_t(y) * WIDTH + x) * 4; };
+    auto path = (directory / "texture.etil").string();
+
+    for (auto format: {Textures::TextureFormat::RGBA8, Textures::TextureFormat::BC1})
+    {
+        Assets::TextureCookSettings    settings;
+        Assets::CompressedTiledTexture tiled;
+        settings.Format = format;
+        settings.Quality = Textures::CompressionQuality::Fast;
+        EE_CHECK(Assets::TileTexture(image, settings, 128, BORDER, &tiled));
+        EE_CHECK(Assets::WriteTiledTexture(path, tiled));
+
+        Assets::TiledTexture texture;
+        if (!EE_CHECK(texture.Open(path)))
+        {
+            continue;
+        }
+        const auto &layout = texture.GetLayout();
+        EE_CHECK(texture.GetFormat() == format && layout.Width == WIDTH && layout.NumMips == tiled.Layout.NumMips);
+        bool same = true;
+        for (uint32_t mip = 0; mip < layout.NumMips; ++mip)
+        {
+            for (uint32_t y = 0; y < layout.GetNumTilesY(mip); ++y)
+            {
+                for (uint32_t x = 0; x < layout.GetNumTilesX(mip); ++x)
+                {
+                    const auto &tile = tiled.Tiles[texture.GetTileIndex({x, y, mip})];
+                    same &= tile.size() == texture.GetTileSize() &&
+                            std::memcmp(texture.GetTileData({x, y, mip}), tile.data(), tile.size()) == 0;
+                }
+            }
+        }
+        EE_CHECK(same);
+
+        if (format == Textures::TextureFormat::RGBA8)
+        {
+            // Inside a tile, in its border, and past the right edge, which repeats the last column.
+            uint32_t       pitch = layout.GetPaddedTileSize();
+            const uint8_t* tile = texture.GetTileData({1, 2, 0});
+            EE_CHECK(std::memcmp(tile + ((BORDER + 7) * pitch + BORDER + 5) * 4, source(133, 263), 4) == 0);
+            EE_CHECK(std::memcmp(tile, source(128 - BORDER, 256 - BORDER), 4) == 0);
+            const uint8_t* edge = texture.GetTileData({7, 4, 0});
+            EE_CHECK(std::memcmp(edge + (BORDER * pitch + pitch - 1) * 4, source(WIDTH - 1, 512), 4) == 0);
+        }
+    }
+
+    // A tile size that does not match the tile table.
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        uint32_t     tileSize = 64;
+        file.seekp(offsetof(Assets::TiledTextureHeader, TileSize));
+        file.write(reinterpret_cast<const char *>(&tileSize), sizeof(tileSize));
+    }
+    Assets::TiledTexture corrupt;
+    EE_CHECK(!corrupt.Open(path));
+}
+
+}
+
+int main()
+{
+    TestLayout();
+    TestEviction();
+    TestFeedback();
+    TestRandomFeedback();
+    TestTiledTexture(Tests::MakeTempDirectory("VirtualTextureTests"));
+    return Tests::Finish();
+}